@@ -46,7 +46,6 @@ extern std::string global_fileToOpen;
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileOutputStream.h>
-#include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/opengl/CGridPlaneXY.h>
 #include <mrpt/opengl/CEllipsoid.h>
@@ -1102,8 +1101,8 @@ void hmtMapViewerFrame::OnmenuExportLocalMapsSelected(wxCommandEvent& event)
 				NODE_ANNOTATION_POSES_GRAPH, hypID, false);
 		obj_poseGraph->convertIntoSimplemap(simpleMap);
 
-		CFileGZOutputStream f(map_file);
-		archiveFrom(f) << simpleMap;  // Save simplemap
+		if (!simpleMap.saveToFile(map_file))
+			THROW_EXCEPTION_FMT("Error saving '%s'", map_file.c_str());
 	}
 
 	WX_END_TRY
@@ -55,7 +55,9 @@ double obs3d_test_depth_to_3d(int a, int b)
 
 	T3DPointsProjectionParams pp;
 	pp.PROJ3D_USE_LUT = (a & 0x01) != 0;
-	pp.USE_SSE2 = (a & 0x02) != 0;
+	pp.numThreads = (a & 0x02) != 0 ? 4 : 1;
+	if (a & 0x04) pp.decimation = 2;
+	if (a & 0x08) pp.voxelSize = 0.05f;
 
 	TRangeImageFilterParams fp;
 	mrpt::math::CMatrix minF, maxF;
@@ -140,72 +142,81 @@ void register_tests_CObservation3DRangeScan()
 	{
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/o SSE2)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,1 thread)",
 				obs3d_test_depth_to_3d, 0x00, 0));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/SSE2)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,4 threads)",
 				obs3d_test_depth_to_3d, 0x02, 0));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/o SSE2)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread)",
 				obs3d_test_depth_to_3d, 0x01, 0));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,4 threads)",
 				obs3d_test_depth_to_3d, 0x03, 0));
 
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/o SSE2,minFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,1 thread,minFilter)",
 				obs3d_test_depth_to_3d, 0x00, 0x01));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/SSE2,minFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,4 threads,minFilter)",
 				obs3d_test_depth_to_3d, 0x02, 0x01));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/o SSE2,minFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread,minFilter)",
 				obs3d_test_depth_to_3d, 0x01, 0x01));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2,minFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,4 threads,minFilter)",
 				obs3d_test_depth_to_3d, 0x03, 0x01));
 
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/o SSE2,maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,1 thread,maxFilter)",
 				obs3d_test_depth_to_3d, 0x00, 0x02));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/SSE2,maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,4 threads,maxFilter)",
 				obs3d_test_depth_to_3d, 0x02, 0x02));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/o SSE2,maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread,maxFilter)",
 				obs3d_test_depth_to_3d, 0x01, 0x02));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2,maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,4 threads,maxFilter)",
 				obs3d_test_depth_to_3d, 0x03, 0x02));
 
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/o "
-				"SSE2,min/maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,1 thread,"
+				"min/maxFilter)",
 				obs3d_test_depth_to_3d, 0x00, 0x03));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (no LUT,w/SSE2,min/maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (no LUT,4 threads,"
+				"min/maxFilter)",
 				obs3d_test_depth_to_3d, 0x02, 0x03));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/o SSE2,min/maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread,min/maxFilter)",
 				obs3d_test_depth_to_3d, 0x01, 0x03));
 		lstTests.push_back(
 			TestData(
-				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2,min/maxFilter)",
+				"3DRangeScan: 320x240 Depth->3D (LUT,4 threads,min/maxFilter)",
 				obs3d_test_depth_to_3d, 0x03, 0x03));
+		lstTests.push_back(
+			TestData(
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread,decimation=2)",
+				obs3d_test_depth_to_3d, 0x05, 0));
+		lstTests.push_back(
+			TestData(
+				"3DRangeScan: 320x240 Depth->3D (LUT,1 thread,voxel=5cm)",
+				obs3d_test_depth_to_3d, 0x09, 0));
 
 		lstTests.push_back(
 			TestData(
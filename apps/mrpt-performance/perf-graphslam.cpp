@@ -57,6 +57,57 @@ double graphslam_levmarq_solve(int nVertices, int N)
 	return ret;
 }
 
+// A long path, as in large mapping sessions: each node has constraints with
+// the next few ones, plus some loop closures.
+template <class GRAPH_TYPE>
+void create_long_path(GRAPH_TYPE& graph, size_t nVertices)
+{
+	typename GRAPH_TYPE::global_poses_t real_node_poses;
+	for (TNodeID j = 0; j < nVertices; j++)
+	{
+		const CPose2D p(0.5 * j, 10 * sin(0.01 * j), 0.01 * j);
+		real_node_poses[j] = p;
+		graph.nodes[j] = p;
+	}
+	for (TNodeID i = 0; i < nVertices; i++)
+	{
+		for (TNodeID j = i + 1; j <= i + 3 && j < nVertices; j++)
+			GraphSlamLevMarqTest<GRAPH_TYPE>::addEdge(
+				i, j, real_node_poses, graph);
+		if (i > 0 && i % 100 == 0)
+			GraphSlamLevMarqTest<GRAPH_TYPE>::addEdge(
+				i / 2, i, real_node_poses, graph);
+	}
+	graph.root = TNodeID(0);
+
+	// Add noise to nodes:
+	for (auto& node : graph.nodes)
+		if (node.first != graph.root)
+			node.second += typename GRAPH_TYPE::edge_t::type_value(CPose3D(
+				getRandomGenerator().drawGaussian1D(0, 0.05),
+				getRandomGenerator().drawGaussian1D(0, 0.05), 0,
+				getRandomGenerator().drawGaussian1D(0, DEG2RAD(0.5)), 0, 0));
+}
+
+// Time of a fixed number of iterations on a large graph:
+template <class GRAPH_TYPE>
+double graphslam_levmarq_large(int nVertices, int nThreads)
+{
+	GRAPH_TYPE graph;
+	create_long_path(graph, nVertices);
+
+	mrpt::system::TParametersDouble params;
+	params["max_iterations"] = 10;
+	params["num_threads"] = nThreads;
+
+	graphslam::TResultInfoSpaLevMarq levmarq_info;
+
+	CTicTac tictac;
+	graphslam::optimize_graph_spa_levmarq(
+		graph, levmarq_info, nullptr, params);
+	return tictac.Tac();
+}
+
 // ------------------------------------------------------
 // register_tests_graphslam
 // ------------------------------------------------------
@@ -79,4 +130,37 @@ void register_tests_graphslam()
 		TestData(
 			"graphslam(3d): levmarq 100 KFs/451 edges",
 			graphslam_levmarq_solve<CNetworkOfPoses3D>, 100, 2));
+
+	lstTests.push_back(
+		TestData(
+			"graphslam(2d): levmarq 10k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses2D>, 10000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(2d): levmarq 50k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses2D>, 50000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(2d): levmarq 100k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses2D>, 100000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(2d): levmarq 50k KFs, 10 iters, 4 threads",
+			graphslam_levmarq_large<CNetworkOfPoses2D>, 50000, 4));
+	lstTests.push_back(
+		TestData(
+			"graphslam(3d): levmarq 10k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses3D>, 10000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(3d): levmarq 50k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses3D>, 50000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(3d): levmarq 100k KFs, 10 iters",
+			graphslam_levmarq_large<CNetworkOfPoses3D>, 100000, 1));
+	lstTests.push_back(
+		TestData(
+			"graphslam(3d): levmarq 50k KFs, 10 iters, 4 threads",
+			graphslam_levmarq_large<CNetworkOfPoses3D>, 50000, 4));
 }
@@ -171,6 +171,45 @@ double grid_test_8(int a1, int a2)
 	return tictac.Tac() / N;
 }
 
+// Cost of inserting one scan and bringing the likelihood-field cache up to
+// date, in a (2*a1)x(2*a1) meters map. It should not grow with the map size.
+double grid_test_10(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	COccupancyGridMap2D gridmap(-a1, a1, -a1, a1, 0.05f);
+	gridmap.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+	gridmap.likelihoodOptions.enableLikelihoodCache = true;
+	gridmap.insertionOptions.maxDistanceInsertion = 5;
+
+	// Build the whole cache once:
+	const CPose3D pose0(0, 0, 0);
+	gridmap.insertObservation(&scan1, &pose0);
+	double R = gridmap.computeObservationLikelihood(&scan1, pose0);
+
+	const long N = 100;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+	{
+		CPose3D pose(
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-1.0, 1.0), 0,
+			getRandomGenerator().drawUniform(-M_PI, M_PI), 0, 0);
+		gridmap.insertObservation(&scan1, &pose);
+		R += gridmap.computeObservationLikelihood(&scan1, pose);
+	}
+	return tictac.Tac() / N;
+}
+
 double grid_test_9(int a1, int a2)
 {
 	// test 9: computeMatchingWith2D
@@ -231,4 +270,12 @@ void register_tests_grids()
 	lstTests.push_back(TestData("gridmap2D: computeLikelihood", grid_test_8));
 	lstTests.push_back(
 		TestData("gridmap2D: determineMatching2D", grid_test_9, 5000));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: insert scan+update LF cache (40x40m)", grid_test_10,
+			20));
+	lstTests.push_back(
+		TestData(
+			"gridmap2D: insert scan+update LF cache (100x100m)", grid_test_10,
+			50));
 }
@@ -9,6 +9,7 @@
 
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/CVoxelHashPointsMap.h>
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/random.h>
 
@@ -280,6 +281,49 @@ double pointmap_test_5(int a1, int a2)
 	return tictac.Tac() / a2;
 }
 
+double pointmap_test_6(int a1, int a2)
+{
+	using namespace mrpt::tfest;
+
+	// test 6: (insert scan + 3D matching) with a CSimplePointsMap (a2=0) or a
+	// CVoxelHashPointsMap (a2=1), as done in ICP-based odometry
+	// ----------------------------------------
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	CSimplePointsMap simpleMap, scanPoints;
+	CVoxelHashPointsMap voxelMap;
+	CPointsMap& pt_map = a2 == 0 ? static_cast<CPointsMap&>(simpleMap)
+								 : static_cast<CPointsMap&>(voxelMap);
+	pt_map.insertionOptions.minDistBetweenLaserPoints = 0.03f;
+	scanPoints.insertObservation(&scan1);
+
+	TMatchingPairList correspondences;
+	TMatchingParams matchParams;
+	TMatchingExtraResults matchExtraResults;
+	matchParams.maxDistForCorrespondence = 0.20f;
+
+	CTicTac tictac;
+	CPose3D pose;
+	for (long i = 0; i < a1; i++)
+	{
+		// Small motions, so the same area is observed over and over:
+		pose.setFromValues(
+			0.5 * sin(i * 0.1), 0.3 * cos(i * 0.07), 0, 0.1 * sin(i * 0.05));
+		pt_map.determineMatching3D(
+			&scanPoints, pose, correspondences, matchParams,
+			matchExtraResults);
+		pt_map.insertObservation(&scan1, &pose);
+	}
+	return tictac.Tac() / a1;
+}
+
 // ------------------------------------------------------
 // register_tests_pointmaps
 // ------------------------------------------------------
@@ -347,6 +391,15 @@ void register_tests_pointmaps()
 	lstTests.push_back(
 		TestData("pointmap: computeMatchingWith2D", pointmap_test_4, 5000));
 
+	lstTests.push_back(
+		TestData(
+			"pointmap: (3D matching+insert scan) x 500, simple map",
+			pointmap_test_6, 500, 0));
+	lstTests.push_back(
+		TestData(
+			"pointmap: (3D matching+insert scan) x 500, voxel-hashed map",
+			pointmap_test_6, 500, 1));
+
 	lstTests.push_back(
 		TestData(
 			"pointmap: boundingBox (10 scans)", pointmap_test_5, 10, 50000));
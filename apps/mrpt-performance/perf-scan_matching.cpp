@@ -11,10 +11,18 @@
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/random.h>
 #include <mrpt/tfest.h>
+#include <mrpt/slam/CCorrelativeScanMatcher.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
 
 #include "common.h"
 
 using namespace mrpt::poses;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::slam;
 using namespace mrpt::system;
 using namespace mrpt::tfest;
 using namespace std;
@@ -196,6 +204,54 @@ double scan_matching_test_4(int nCorrs, int nRepets)
 	return T;
 }
 
+// ------------------------------------------------------
+//	Benchmark: CCorrelativeScanMatcher, global search of a
+//  360 deg scan within a +-(linWindow_cm) window, whole circle
+// ------------------------------------------------------
+double scan_matching_test_5(int linWindow_cm, int nThreads)
+{
+	// A 20x20m world with some rooms, at 5cm resolution:
+	COccupancyGridMap2D grid(-11, 11, -11, 11, 0.05f);
+	grid.fill(1.0f);
+	auto wall = [&grid](float x0, float y0, float x1, float y1) {
+		const float L = std::hypot(x1 - x0, y1 - y0);
+		for (float t = 0; t <= L; t += 0.025f)
+			grid.setPos(x0 + (x1 - x0) * t / L, y0 + (y1 - y0) * t / L, 0);
+	};
+	wall(-10, -10, 10, -10);
+	wall(10, -10, 10, 10);
+	wall(10, 10, -10, 10);
+	wall(-10, 10, -10, -10);
+	wall(-10, 0, -3, 0);
+	wall(-1, 0, 4, 0);
+	wall(0, 0, 0, 7);
+	wall(4, -10, 4, -4);
+	wall(6, 3, 10, 3);
+	wall(-6, -6, -4, -6);
+
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf * 2;
+	scan.maxRange = 30;
+	grid.laserScanSimulator(scan, CPose2D(2, -3, 0.7), 0.5f, 720);
+	CSimplePointsMap scanPoints;
+	scanPoints.insertObservation(&scan);
+
+	CCorrelativeScanMatcher matcher;
+	matcher.options.linear_window = linWindow_cm * 0.01;
+	matcher.options.numThreads = nThreads;
+	// Only measure the search, not the pyramid construction:
+	matcher.precomputePyramid(grid);
+
+	const CPosePDFGaussian initialGuess(CPose2D(2.3, -2.6, 0));
+	const size_t N = 10;
+	CTicTac tictac;
+	tictac.Tic();
+	for (size_t i = 0; i < N; i++)
+		matcher.AlignPDF(&grid, &scanPoints, initialGuess);
+
+	return tictac.Tac() / N;
+}
+
 // ------------------------------------------------------
 // register_tests_scan_matching
 // ------------------------------------------------------
@@ -212,4 +268,14 @@ void register_tests_scan_matching()
 		TestData("tfest: se2_l2 [x100 corrs]", scan_matching_test_4, 100, 1e6));
 	lstTests.push_back(TestData(
 		"tfest: se2_l2 [x1000 corrs]", scan_matching_test_4, 1000, 1e5));
+
+	lstTests.push_back(TestData(
+		"CCorrelativeScanMatcher: +-1m,+-180deg", scan_matching_test_5, 100,
+		1));
+	lstTests.push_back(TestData(
+		"CCorrelativeScanMatcher: +-5m,+-180deg", scan_matching_test_5, 500,
+		1));
+	lstTests.push_back(TestData(
+		"CCorrelativeScanMatcher: +-5m,+-180deg [4 threads]",
+		scan_matching_test_5, 500, 4));
 }
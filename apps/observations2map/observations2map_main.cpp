@@ -75,8 +75,10 @@ int main(int argc, char** argv)
 		// Load simplemap:
 		cout << "Loading simplemap...";
 		mrpt::maps::CSimpleMap simplemap;
-		mrpt::io::CFileGZInputStream f(inputFile.c_str());
-		mrpt::serialization::archiveFrom(f) >> simplemap;
+		// Observations are loaded from disk as the maps are built, keeping
+		// just a few frames in memory at once:
+		if (!simplemap.loadFromFileLazy(inputFile, 64))
+			THROW_EXCEPTION_FMT("Error loading '%s'", inputFile.c_str());
 		cout << "done: " << simplemap.size() << " observations." << endl;
 
 		// Create metric maps:
@@ -30,7 +30,7 @@
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/obs/CActionCollection.h>
 #include <mrpt/obs/CObservationOdometry.h>
-#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogPrefetchReader.h>
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CMultiMetricMap.h>
@@ -251,10 +251,8 @@ void do_pf_localization(
 			// It's a ".simplemap":
 			// -------------------------
 			printf("Loading '.simplemap' file...");
-			{
-				CFileGZInputStream f(MAP_FILE);
-				archiveFrom(f) >> simpleMap;
-			}
+			if (!simpleMap.loadFromFileLazy(MAP_FILE, 64))
+				THROW_EXCEPTION_FMT("Error loading '%s'", MAP_FILE.c_str());
 			printf("Ok\n");
 
 			ASSERT_(simpleMap.size() > 0);
@@ -383,7 +381,8 @@ void do_pf_localization(
 			// Load the rawlog:
 			// --------------------------
 			printf("Opening the rawlog file...");
-			CFileGZInputStream rawlog_in_stream(RAWLOG_FILE);
+			// Read and decode the rawlog in the background:
+			CRawlogPrefetchReader rawlogReader(RAWLOG_FILE);
 			printf("OK\n");
 
 			// The experiment directory is:
@@ -488,8 +487,6 @@ void do_pf_localization(
 			CPose2D last_used_abs_odo(0, 0, 0),
 				pending_most_recent_odo(0, 0, 0);
 
-			auto arch = archiveFrom(rawlog_in_stream);
-
 			while (!end)
 			{
 				// Finish if ESC is pushed:
@@ -502,8 +499,7 @@ void do_pf_localization(
 				CSensoryFrame::Ptr observations;
 				CObservation::Ptr obs;
 
-				if (!CRawlog::getActionObservationPairOrObservation(
-						arch,  // In stream
+				if (!rawlogReader.getActionObservationPairOrObservation(
 						action, observations,  // Out pair <action,SF>, or:
 						obs,  // Out single observation
 						rawlogEntry  // In/Out index counter.
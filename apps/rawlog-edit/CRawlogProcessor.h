@@ -15,6 +15,7 @@
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/os.h>
 #include <mrpt/serialization/CArchive.h>
+#include <memory>
 
 // Aparently, TCLAP headers can't be included in more than one source file
 //  or duplicated linking symbols appear! -> Use forward declarations instead:
@@ -171,26 +172,19 @@ class CRawlogProcessorOnEachObservation : public CRawlogProcessor
 	{
 		MRPT_UNUSED_PARAM(actions);
 		// Process each observation individually, either from "obs" or each
-		// within a "SF":
-		for (size_t idxObs = 0; true; idxObs++)
+		// within a "SF". They are passed by reference, so resetting them
+		// removes them from the rawlog:
+		if (obs)
 		{
-			mrpt::obs::CObservation::Ptr obs_indiv;
-			if (obs)
-			{
-				if (idxObs > 0) break;
-				obs_indiv = obs;
-			}
-			else if (SF)
+			if (!processOneObservation(obs)) return false;
+		}
+		else if (SF)
+		{
+			for (auto& obs_indiv : *SF)
 			{
-				if (idxObs >= SF->size()) break;
-				obs_indiv = SF->getObservationByIndex(idxObs);
+				ASSERT_(obs_indiv);
+				if (!processOneObservation(obs_indiv)) return false;
 			}
-			else
-				break;  // shouldn't...
-
-			// Process "obs_indiv":
-			ASSERT_(obs_indiv);
-			if (!processOneObservation(obs_indiv)) return false;
 		}
 
 		return true;  // No error.
@@ -274,6 +268,39 @@ class CRawlogProcessorFilterObservations
 
 };  // end CRawlogProcessorOnEachObservation
 
+/** An operation on individual observations which, unlike the
+ * CRawlogProcessor classes, does not parse the rawlog by itself, so several
+ * of them can be chained and run in one single pass over the input rawlog
+ * (see runObservationOperations()).
+ * Observations removed by an operation are not passed to the next ones.
+ */
+class CObservationOperation
+{
+   public:
+	using Ptr = std::shared_ptr<CObservationOperation>;
+
+	virtual ~CObservationOperation() = default;
+
+	/** To be implemented by the user: process one observation, which can be
+	 * modified in-place or replaced. Return false to remove it from the
+	 * output rawlog.
+	 * Unless isSequential() returns true, this may be invoked in parallel
+	 * from several threads for different observations. */
+	virtual bool processOneObservation(mrpt::obs::CObservation::Ptr& obs) = 0;
+
+	/** Must return true if observations must be processed one at a time and
+	 * in the order they appear in the rawlog, e.g. if the result for one
+	 * observation depends on the previous ones. */
+	virtual bool isSequential() const { return false; }
+
+	/** Dump statistics once the whole rawlog has been processed */
+	virtual void printStatistics(bool verbose) const
+	{
+		MRPT_UNUSED_PARAM(verbose);
+	}
+
+};  // end CObservationOperation
+
 }  // namespace rawlogtools
 }  // namespace mrpt
 
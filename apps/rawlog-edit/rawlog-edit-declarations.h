@@ -16,6 +16,7 @@
 #include <mrpt/system/filesystem.h>
 #include <mrpt/obs/CObservation.h>
 #include "CRawlogProcessor.h"
+#include <vector>
 
 // Declarations:
 #define VERBOSE_COUT \
@@ -26,6 +27,14 @@
 		mrpt::io::CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline, \
 		bool verbose)
 
+/** Declares a factory of a chainable operation, see CObservationOperation */
+#define DECLARE_OBS_OPERATION(_NAME)                   \
+	mrpt::rawlogtools::CObservationOperation::Ptr _NAME( \
+		TCLAP::CmdLine& cmdline, bool verbose)
+
+using TObsOperationFactory = mrpt::rawlogtools::CObservationOperation::Ptr (*)(
+	TCLAP::CmdLine& cmdline, bool verbose);
+
 /** Auxiliary struct that performs all the checks and create the
 	 output rawlog stream, publishing it as "out_rawlog"
 */
@@ -47,4 +56,20 @@ bool getArgValue(
 	TCLAP::CmdLine& cmdline, const std::string& arg_name, T& out_val);
 bool isFlagSet(TCLAP::CmdLine& cmdline, const std::string& arg_name);
 
+// ======================================================================
+//  Creates (only once) the directory for the external files of the
+//  output rawlog ("<OUTPUT>_Images") and returns its path, ending in "/".
+// ======================================================================
+std::string getOutputExternalsDirectory(
+	TCLAP::CmdLine& cmdline, bool verbose);
+
+// ======================================================================
+//  Creates the output rawlog and a chain with the given operations, then
+//  runs all of them in one pass over the input rawlog, using a pool of
+//  worker threads (see "--threads") for those which are not sequential.
+// ======================================================================
+void runObservationOperations(
+	const std::vector<TObsOperationFactory>& factories,
+	TCLAP::CmdLine& cmdline, bool verbose);
+
 #endif
@@ -13,6 +13,7 @@
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/obs/CObservationImage.h>
 #include <mrpt/obs/CObservationStereoImages.h>
+#include <atomic>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -24,29 +25,22 @@ using namespace std;
 // ======================================================================
 //		op_camera_params
 // ======================================================================
-DECLARE_OP_FUNCTION(op_camera_params)
+DECLARE_OBS_OPERATION(op_camera_params)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_CamParams : public CRawlogProcessorOnEachObservation
+	class CObsOperation_CamParams : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
-
 		string target_label;
 		mrpt::img::TCamera new_cam_params;
 		mrpt::img::TStereoCamera new_stereo_cam_params;
 		bool is_stereo;
 
 	   public:
-		size_t m_changedCams;
+		std::atomic<size_t> m_changedCams{0};
 
-		CRawlogProcessor_CamParams(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
+		CObsOperation_CamParams(TCLAP::CmdLine& cmdline, bool verbose)
 		{
-			m_changedCams = 0;
-
 			// Load .ini file with poses:
 			string str;
 			getArgValue<string>(cmdline, "camera-params", str);
@@ -105,7 +99,7 @@ DECLARE_OP_FUNCTION(op_camera_params)
 						 << (is_stereo ? "stereo" : "monocular") << "\n";
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			if (strCmpI(obs->sensorLabel, target_label))
 			{
@@ -128,30 +122,12 @@ DECLARE_OP_FUNCTION(op_camera_params)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Number of modified entries        : "
+						 << m_changedCams << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_CamParams proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Number of modified entries        : " << proc.m_changedCams
-				 << "\n";
+	return std::make_shared<CObsOperation_CamParams>(cmdline, verbose);
 }
@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include "rawlog-edit-declarations.h"
+#include <mrpt/obs/CRawlogIndex.h>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -105,6 +106,34 @@ DECLARE_OP_FUNCTION(op_cut)
 			// All filters passed.
 			return true;
 		}
+
+		/** Returns the first entry of the rawlog index that must be parsed,
+		 * i.e. all the entries before it would be removed by
+		 * tellIfThisObsPasses(), without deciding the end of the cut. */
+		size_t firstEntryToParse(const CRawlogIndex& idx) const
+		{
+			size_t i = 0;
+			while (i < idx.size())
+			{
+				const auto& e = idx.entries[i];
+				const auto* cls = mrpt::rtti::findRegisteredClass(e.className);
+				if (cls && cls->derivedFrom(CLASS_ID(CObservation)))
+				{
+					// The entry counter is "i+1" after reading it:
+					const bool beforeIndex =
+						has_from_index && i + 1 < m_from_index;
+					const bool beforeTime = has_from_time &&
+											e.timestamp != INVALID_TIMESTAMP &&
+											timestampToDouble(e.timestamp) <
+												m_from_time;
+					if (!beforeIndex && !beforeTime) break;
+					i += 1;
+				}
+				else
+					break;  // Action/SF pairs are always parsed and saved
+			}
+			return i;
+		}
 	};
 
 	// Process
@@ -112,6 +141,27 @@ DECLARE_OP_FUNCTION(op_cut)
 	TOutputRawlogCreator outrawlog;
 	CRawlogProcessor_Cut proc(
 		in_rawlog, cmdline, verbose, outrawlog.out_rawlog_io);
+
+	// Skip the entries before the cut, if the rawlog has an index:
+	string input_rawlog;
+	getArgValue<std::string>(cmdline, "input", input_rawlog);
+	CRawlogIndex idx;
+	size_t skipped = 0;
+	if (idx.loadFromFile(CRawlogIndex::indexFileNameFor(input_rawlog)) &&
+		idx.isUpToDate(input_rawlog))
+	{
+		skipped = proc.firstEntryToParse(idx);
+		if (skipped > 0 && skipped < idx.size())
+		{
+			in_rawlog.Seek(idx.entries[skipped].offset);
+			proc.m_rawlogEntry = skipped;
+		}
+		else
+			skipped = 0;
+		VERBOSE_COUT << "Using the rawlog index to skip the first " << skipped
+					 << " entries.\n";
+	}
+
 	proc.doProcessRawlog();
 
 	// Dump statistics:
@@ -122,4 +172,5 @@ DECLARE_OP_FUNCTION(op_cut)
 				 << proc.m_entries_parsed << "\n";
 	VERBOSE_COUT << "Removed entries                   : "
 				 << proc.m_entries_removed << "\n";
+	VERBOSE_COUT << "Skipped entries (with the index)  : " << skipped << "\n";
 }
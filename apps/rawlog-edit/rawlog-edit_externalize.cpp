@@ -11,6 +11,7 @@
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CObservationImage.h>
 #include <mrpt/obs/CObservationStereoImages.h>
+#include <atomic>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -22,64 +23,26 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_externalize
 // ======================================================================
-DECLARE_OP_FUNCTION(op_externalize)
+DECLARE_OBS_OPERATION(op_externalize)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_Externalize
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_Externalize : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
-
-		string imgFileExtension;
-		string outDir;
+		const string imgFileExtension;
+		const string outDir;
 
 	   public:
-		size_t entries_converted;
-		size_t entries_skipped;  // Already external
+		std::atomic<size_t> entries_converted{0};
+		std::atomic<size_t> entries_skipped{0};  // Already external
 
-		CRawlogProcessor_Externalize(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
+		CObsOperation_Externalize(
+			const string& imgFileExt, const string& externalsDir)
+			: imgFileExtension(imgFileExt), outDir(externalsDir)
 		{
-			entries_converted = 0;
-			entries_skipped = 0;
-			getArgValue<string>(cmdline, "image-format", imgFileExtension);
-
-			mrpt::obs::CObservation3DRangeScan::EXTERNALS_AS_TEXT(
-				isFlagSet(cmdline, "txt-externals"));
-
-			// Create the default "/Images" directory.
-			const string out_rawlog_basedir =
-				extractFileDirectory(outrawlog.out_rawlog_filename);
-
-			outDir = (out_rawlog_basedir.empty()
-						  ? string()
-						  : (out_rawlog_basedir + string("/"))) +
-					 extractFileName(outrawlog.out_rawlog_filename) +
-					 string("_Images");
-			if (directoryExists(outDir))
-				throw runtime_error(
-					string(
-						"*ABORTING*: Output directory for images already "
-						"exists: ") +
-					outDir + string(
-								 "\n. Select a different output path or "
-								 "remove the directory."));
-
-			VERBOSE_COUT << "Creating directory: " << outDir << endl;
-
-			mrpt::system::createDirectory(outDir);
-			if (!fileExists(outDir))
-				throw runtime_error(
-					string("*ABORTING*: Couldn't create directory: ") + outDir);
-
-			// Add the final /
-			outDir += "/";
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			const string label_time = format(
 				"%s_%f", obs->sensorLabel.c_str(),
@@ -188,32 +151,22 @@ DECLARE_OP_FUNCTION(op_externalize)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Entries converted                 : "
+						 << entries_converted << "\n";
+			VERBOSE_COUT << "Entries skipped (already external): "
+						 << entries_skipped << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_Externalize proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Entries converted                 : "
-				 << proc.entries_converted << "\n";
-	VERBOSE_COUT << "Entries skipped (already external): "
-				 << proc.entries_skipped << "\n";
+	string imgFileExtension;
+	getArgValue<string>(cmdline, "image-format", imgFileExtension);
+
+	mrpt::obs::CObservation3DRangeScan::EXTERNALS_AS_TEXT(
+		isFlagSet(cmdline, "txt-externals"));
+
+	// Create the default "/Images" directory.
+	return std::make_shared<CObsOperation_Externalize>(
+		imgFileExtension, getOutputExternalsDirectory(cmdline, verbose));
 }
@@ -8,6 +8,8 @@
    +------------------------------------------------------------------------+ */
 
 #include "rawlog-edit-declarations.h"
+#include <atomic>
+#include <map>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -19,22 +21,17 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_remove_label
 // ======================================================================
-DECLARE_OP_FUNCTION(op_remove_label)
+DECLARE_OBS_OPERATION(op_remove_label)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_RemoveLabel
-		: public CRawlogProcessorFilterObservations
+	class CObsOperation_RemoveLabel : public CObservationOperation
 	{
 	   protected:
 		vector<string> m_filter_labels;
+		std::atomic<size_t> m_entries_removed{0};
 
 	   public:
-		CRawlogProcessor_RemoveLabel(
-			mrpt::io::CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose, mrpt::io::CFileGZOutputStream& out_rawlog,
-			const std::string& filter_label)
-			: CRawlogProcessorFilterObservations(
-				  in_rawlog, cmdline, verbose, out_rawlog)
+		CObsOperation_RemoveLabel(const std::string& filter_label, bool verbose)
 		{
 			mrpt::system::tokenize(filter_label, " ,", m_filter_labels);
 			ASSERT_(!m_filter_labels.empty());
@@ -43,59 +40,47 @@ DECLARE_OP_FUNCTION(op_remove_label)
 					cout << "Removing label: '" << m_filter_labels[i] << "'\n";
 		}
 
-		/** To be implemented by users: return false means the observation is */
-		virtual bool tellIfThisObsPasses(mrpt::obs::CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			for (size_t i = 0; i < m_filter_labels.size(); i++)
 				if (obs->sensorLabel == m_filter_labels[i])
 				{
+					m_entries_removed++;
 					return false;
 				}
 			return true;
 		}
+
+		void printStatistics(bool verbose) const override
+		{
+			VERBOSE_COUT << "remove-label: Removed entries     : "
+						 << m_entries_removed << "\n";
+		}
 	};
 
-	// Process
-	// ---------------------------------
 	string filter_label;
 	if (!getArgValue<string>(cmdline, "remove-label", filter_label) ||
 		filter_label.empty())
 		throw std::runtime_error(
 			"remove-label: This operation needs a non-empty argument.");
 
-	TOutputRawlogCreator outrawlog;
-	CRawlogProcessor_RemoveLabel proc(
-		in_rawlog, cmdline, verbose, outrawlog.out_rawlog_io, filter_label);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Analyzed entries                  : "
-				 << proc.m_entries_parsed << "\n";
-	VERBOSE_COUT << "Removed entries                   : "
-				 << proc.m_entries_removed << "\n";
+	return std::make_shared<CObsOperation_RemoveLabel>(filter_label, verbose);
 }
 
 // ======================================================================
 //		op_keep_label
 // ======================================================================
-DECLARE_OP_FUNCTION(op_keep_label)
+DECLARE_OBS_OPERATION(op_keep_label)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_KeepLabel : public CRawlogProcessorFilterObservations
+	class CObsOperation_KeepLabel : public CObservationOperation
 	{
 	   protected:
 		vector<string> m_filter_labels;
+		std::atomic<size_t> m_entries_removed{0};
 
 	   public:
-		CRawlogProcessor_KeepLabel(
-			mrpt::io::CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose, mrpt::io::CFileGZOutputStream& out_rawlog,
-			const std::string& filter_label)
-			: CRawlogProcessorFilterObservations(
-				  in_rawlog, cmdline, verbose, out_rawlog)
+		CObsOperation_KeepLabel(const std::string& filter_label, bool verbose)
 		{
 			mrpt::system::tokenize(filter_label, " ,", m_filter_labels);
 			ASSERT_(!m_filter_labels.empty());
@@ -104,37 +89,78 @@ DECLARE_OP_FUNCTION(op_keep_label)
 					cout << "Keeping label: '" << m_filter_labels[i] << "'\n";
 		}
 
-		/** To be implemented by users: return false means the observation is */
-		virtual bool tellIfThisObsPasses(mrpt::obs::CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			for (size_t i = 0; i < m_filter_labels.size(); i++)
 				if (obs->sensorLabel == m_filter_labels[i])
 				{
 					return true;
 				}
+			m_entries_removed++;
 			return false;
 		}
+
+		void printStatistics(bool verbose) const override
+		{
+			VERBOSE_COUT << "keep-label: Removed entries       : "
+						 << m_entries_removed << "\n";
+		}
 	};
 
-	// Process
-	// ---------------------------------
 	string filter_label;
 	if (!getArgValue<string>(cmdline, "keep-label", filter_label) ||
 		filter_label.empty())
 		throw std::runtime_error(
 			"keep-label: This operation needs a non-empty argument.");
 
-	TOutputRawlogCreator outrawlog;
-	CRawlogProcessor_KeepLabel proc(
-		in_rawlog, cmdline, verbose, outrawlog.out_rawlog_io, filter_label);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Analyzed entries                  : "
-				 << proc.m_entries_parsed << "\n";
-	VERBOSE_COUT << "Removed entries                   : "
-				 << proc.m_entries_removed << "\n";
+	return std::make_shared<CObsOperation_KeepLabel>(filter_label, verbose);
+}
+
+// ======================================================================
+//		op_decimate
+// ======================================================================
+DECLARE_OBS_OPERATION(op_decimate)
+{
+	// A class to do this operation:
+	class CObsOperation_Decimate : public CObservationOperation
+	{
+	   protected:
+		const size_t m_decimation;
+		/** Number of observations seen so far for each sensor label */
+		std::map<std::string, size_t> m_obsCount;
+		size_t m_entries_removed = 0;
+
+	   public:
+		CObsOperation_Decimate(size_t decimation) : m_decimation(decimation)
+		{
+		}
+
+		// Depends on the previous observations of the same sensor:
+		bool isSequential() const override { return true; }
+
+		bool processOneObservation(CObservation::Ptr& obs) override
+		{
+			if (m_obsCount[obs->sensorLabel]++ % m_decimation == 0)
+				return true;
+			m_entries_removed++;
+			return false;
+		}
+
+		void printStatistics(bool verbose) const override
+		{
+			VERBOSE_COUT << "decimate: Removed entries         : "
+						 << m_entries_removed << "\n";
+		}
+	};
+
+	size_t decimation = 0;
+	if (!getArgValue<size_t>(cmdline, "decimate", decimation) ||
+		decimation < 1)
+		throw std::runtime_error(
+			"decimate: This operation needs a decimation ratio >=1.");
+
+	VERBOSE_COUT << "Keeping one out of " << decimation
+				 << " observations of each sensor label.\n";
+
+	return std::make_shared<CObsOperation_Decimate>(decimation);
 }
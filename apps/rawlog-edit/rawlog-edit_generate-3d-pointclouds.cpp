@@ -9,6 +9,7 @@
 
 #include "rawlog-edit-declarations.h"
 #include <mrpt/obs/CObservation3DRangeScan.h>
+#include <atomic>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -20,27 +21,15 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_generate_3d_pointclouds
 // ======================================================================
-DECLARE_OP_FUNCTION(op_generate_3d_pointclouds)
+DECLARE_OBS_OPERATION(op_generate_3d_pointclouds)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_Generate3DPointClouds
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_Generate3DPointClouds : public CObservationOperation
 	{
-	   protected:
-		TOutputRawlogCreator outrawlog;
-
 	   public:
-		size_t entries_modified;
+		std::atomic<size_t> entries_modified{0};
 
-		CRawlogProcessor_Generate3DPointClouds(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
-		{
-			entries_modified = 0;
-		}
-
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			if (IS_CLASS(obs, CObservation3DRangeScan))
 			{
@@ -58,30 +47,14 @@ DECLARE_OP_FUNCTION(op_generate_3d_pointclouds)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Entries modified                  : "
+						 << entries_modified << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_Generate3DPointClouds proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Entries modified                  : "
-				 << proc.entries_modified << "\n";
+	MRPT_UNUSED_PARAM(cmdline);
+	MRPT_UNUSED_PARAM(verbose);
+	return std::make_shared<CObsOperation_Generate3DPointClouds>();
 }
@@ -0,0 +1,47 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "rawlog-edit-declarations.h"
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/system/CTicTac.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace mrpt::rawlogtools;
+using namespace std;
+using namespace mrpt::io;
+
+// ======================================================================
+//		op_build_index
+// ======================================================================
+DECLARE_OP_FUNCTION(op_build_index)
+{
+	MRPT_UNUSED_PARAM(in_rawlog);
+	string input_rawlog;
+	getArgValue<std::string>(cmdline, "input", input_rawlog);
+
+	CTicTac tictac;
+	CRawlogIndex idx;
+	if (!idx.buildFromRawlogFile(input_rawlog))
+		throw std::runtime_error("build-index: Cannot read the input rawlog.");
+
+	const string idxFile = CRawlogIndex::indexFileNameFor(input_rawlog);
+	if (!idx.saveToFile(idxFile))
+		throw std::runtime_error(
+			string("build-index: Cannot write the index file: ") + idxFile);
+
+	// Dump statistics:
+	// ---------------------------------
+	VERBOSE_COUT << "Time to process file (sec)        : " << tictac.Tac()
+				 << "\n";
+	VERBOSE_COUT << "Indexed entries                   : " << idx.size()
+				 << "\n";
+	VERBOSE_COUT << "Index saved to                    : " << idxFile << "\n";
+}
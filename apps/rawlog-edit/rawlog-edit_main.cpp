@@ -16,6 +16,11 @@
 //  See the "--help" output for list of supported operations and further
 //   instructions.
 //
+//  Several operations on individual observations (e.g. --keep-label,
+//   --decimate and --externalize) can be given at once: they are then
+//   applied in the order given in the command line, in one single pass over
+//   the rawlog, and using several threads (see --threads).
+//
 //  About integration with bash/.BAT scripts: The program will return 0 upon
 //   successful execution. To avoid any information display to stdout invoke
 //   it with the -q (or --quiet) flag. Upon error, it will return -1.
@@ -26,6 +31,7 @@
 #include "rawlog-edit-declarations.h"
 
 #include <mrpt/otherlibs/tclap/CmdLine.h>
+#include <algorithm>
 
 using TOperationFunctor = void (*)(
 	mrpt::io::CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
@@ -40,14 +46,12 @@ using namespace std;
 using namespace mrpt::io;
 
 // Frwd. decl:
-DECLARE_OP_FUNCTION(op_externalize);
 DECLARE_OP_FUNCTION(op_info);
 DECLARE_OP_FUNCTION(op_list_images);
 DECLARE_OP_FUNCTION(op_list_poses);
 DECLARE_OP_FUNCTION(op_list_rangebearing);
-DECLARE_OP_FUNCTION(op_remove_label);
-DECLARE_OP_FUNCTION(op_keep_label);
 DECLARE_OP_FUNCTION(op_cut);
+DECLARE_OP_FUNCTION(op_build_index);
 DECLARE_OP_FUNCTION(op_export_gps_kml);
 DECLARE_OP_FUNCTION(op_export_gps_gas_kml);
 DECLARE_OP_FUNCTION(op_export_gps_txt);
@@ -59,14 +63,20 @@ DECLARE_OP_FUNCTION(op_export_anemometer_txt);
 DECLARE_OP_FUNCTION(op_recalc_odometry);
 DECLARE_OP_FUNCTION(op_export_rawdaq_txt);
 DECLARE_OP_FUNCTION(op_export_2d_scans_txt);
-DECLARE_OP_FUNCTION(op_sensors_pose);
-DECLARE_OP_FUNCTION(op_camera_params);
-DECLARE_OP_FUNCTION(op_generate_3d_pointclouds);
 DECLARE_OP_FUNCTION(op_generate_pcd);
-DECLARE_OP_FUNCTION(op_stereo_rectify);
-DECLARE_OP_FUNCTION(op_rename_externals);
 DECLARE_OP_FUNCTION(op_list_timestamps);
-DECLARE_OP_FUNCTION(op_remap_timestamps);
+
+// Operations which can be chained in one pass over the rawlog:
+DECLARE_OBS_OPERATION(op_externalize);
+DECLARE_OBS_OPERATION(op_remove_label);
+DECLARE_OBS_OPERATION(op_keep_label);
+DECLARE_OBS_OPERATION(op_sensors_pose);
+DECLARE_OBS_OPERATION(op_camera_params);
+DECLARE_OBS_OPERATION(op_generate_3d_pointclouds);
+DECLARE_OBS_OPERATION(op_stereo_rectify);
+DECLARE_OBS_OPERATION(op_rename_externals);
+DECLARE_OBS_OPERATION(op_remap_timestamps);
+DECLARE_OBS_OPERATION(op_decimate);
 
 // Declare the supported command line switches ===========
 TCLAP::CmdLine cmd(
@@ -143,6 +153,13 @@ TCLAP::SwitchArg arg_overwrite(
 
 TCLAP::SwitchArg arg_quiet("q", "quiet", "Terse output", cmd, false);
 
+TCLAP::ValueArg<size_t> arg_threads(
+	"", "threads",
+	"Number of threads to run the operations on individual observations "
+	"(externalize, generate-3d-pointclouds, etc.). Default: 1. Use 0 for as "
+	"many as CPU cores.",
+	false, 1, "N", cmd);
+
 // ======================================================================
 //     main() of rawlog-edit
 // ======================================================================
@@ -155,6 +172,8 @@ int main(int argc, char** argv)
 	{
 		// --------------- List of possible operations ---------------
 		map<string, TOperationFunctor> ops_functors;
+		// Those which can be combined with others in one pass:
+		map<string, TObsOperationFactory> obs_ops_factories;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "externalize",
@@ -162,7 +181,7 @@ int main(int argc, char** argv)
 			"Requires: -o (or --output)\n"
 			"Optional: --image-format, --txt-externals",
 			cmd, false));
-		ops_functors["externalize"] = &op_externalize;
+		obs_ops_factories["externalize"] = &op_externalize;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "info",
@@ -204,7 +223,7 @@ int main(int argc, char** argv)
 			"semicolon.\n"
 			"Requires: -o (or --output)",
 			false, "", "a;b", cmd));
-		ops_functors["remap-timestamps"] = &op_remap_timestamps;
+		obs_ops_factories["remap-timestamps"] = &op_remap_timestamps;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "list-range-bearing",
@@ -221,7 +240,7 @@ int main(int argc, char** argv)
 			"Several labels can be provided separated by commas.\n"
 			"Requires: -o (or --output)",
 			false, "", "label[,label...]", cmd));
-		ops_functors["remove-label"] = &op_remove_label;
+		obs_ops_factories["remove-label"] = &op_remove_label;
 
 		arg_ops.push_back(new TCLAP::ValueArg<std::string>(
 			"", "keep-label",
@@ -230,7 +249,15 @@ int main(int argc, char** argv)
 			"Several labels can be provided separated by commas.\n"
 			"Requires: -o (or --output)",
 			false, "", "label[,label...]", cmd));
-		ops_functors["keep-label"] = &op_keep_label;
+		obs_ops_factories["keep-label"] = &op_keep_label;
+
+		arg_ops.push_back(new TCLAP::ValueArg<size_t>(
+			"", "decimate",
+			"Op: Keep only one out of each N observations of each sensor "
+			"label, removing the rest.\n"
+			"Requires: -o (or --output)",
+			false, 1, "N", cmd));
+		obs_ops_factories["decimate"] = &op_decimate;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "export-gps-kml",
@@ -361,17 +388,31 @@ int main(int argc, char** argv)
 			"--to-* at once.\n"
 			"If only a --from-* is given, the rawlog will be saved up to "
 			"its end. If only a --to-* is given, the rawlog will be saved "
-			"from its beginning.\n",
+			"from its beginning.\n"
+			"If an up-to-date index of the input rawlog exists (see "
+			"--build-index), the entries before the cut are skipped "
+			"without parsing them.\n",
 			cmd, false));
 		ops_functors["cut"] = &op_cut;
 
+		arg_ops.push_back(new TCLAP::SwitchArg(
+			"", "build-index",
+			"Op: Builds an index of the input rawlog, with the offset, "
+			"timestamp, class and sensor label of each entry, and saves it "
+			"next to it as '<input>.idx'.\n"
+			"The index is used by --cut, and by mrpt::obs::CRawlog for "
+			"random access to the rawlog.\n",
+			cmd, false));
+		ops_functors["build-index"] = &op_build_index;
+
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "generate-3d-pointclouds",
 			"Op: (re)generate the 3D pointclouds within "
 			"CObservation3DRangeScan objects that have range data.\n"
 			"Requires: -o (or --output)\n",
 			cmd, false));
-		ops_functors["generate-3d-pointclouds"] = &op_generate_3d_pointclouds;
+		obs_ops_factories["generate-3d-pointclouds"] =
+			&op_generate_3d_pointclouds;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "generate-pcd",
@@ -391,7 +432,7 @@ int main(int argc, char** argv)
 			"pose of sensors by their sensorLabel names.\n"
 			"Requires: -o (or --output)\n",
 			false, "", "file.ini", cmd));
-		ops_functors["sensors-pose"] = &op_sensors_pose;
+		obs_ops_factories["sensors-pose"] = &op_sensors_pose;
 
 		arg_ops.push_back(new TCLAP::ValueArg<std::string>(
 			"", "camera-params",
@@ -402,7 +443,7 @@ int main(int argc, char** argv)
 			"'[CAMERA_PARAMS_RIGHT]' for stereo.\n"
 			"Requires: -o (or --output)\n",
 			false, "", "SENSOR_LABEL,file.ini", cmd));
-		ops_functors["camera-params"] = &op_camera_params;
+		obs_ops_factories["camera-params"] = &op_camera_params;
 
 		arg_ops.push_back(new TCLAP::ValueArg<std::string>(
 			"", "stereo-rectify",
@@ -417,7 +458,7 @@ int main(int argc, char** argv)
 			"          --image-size to resize output images (example: "
 			"--image-size 640x480) \n",
 			false, "", "SENSOR_LABEL,0.5", cmd));
-		ops_functors["stereo-rectify"] = &op_stereo_rectify;
+		obs_ops_factories["stereo-rectify"] = &op_stereo_rectify;
 
 		arg_ops.push_back(new TCLAP::SwitchArg(
 			"", "rename-externals",
@@ -425,7 +466,7 @@ int main(int argc, char** argv)
 			"rawlog (it doesn't change the external files, which may even "
 			"not exist).\n",
 			cmd, false));
-		ops_functors["rename-externals"] = &op_rename_externals;
+		obs_ops_factories["rename-externals"] = &op_rename_externals;
 
 		// --------------- End of list of possible operations --------
 
@@ -436,44 +477,57 @@ int main(int argc, char** argv)
 		string input_rawlog = arg_input_file.getValue();
 		const bool verbose = !arg_quiet.getValue();
 
-		// Check the selected operation:
-		//  Only one of the ops should be selected:
-		string selected_op;
+		// Check the selected operation(s):
+		//  Only one of the ops should be selected, unless all of them can be
+		//  chained:
+		vector<string> selected_ops;
 		for (size_t i = 0; i < arg_ops.size(); i++)
 			if (arg_ops[i]->isSet())
-			{
-				if (selected_op.empty())
-				{
-					selected_op = arg_ops[i]->getName();
-				}
-				else
-					throw std::runtime_error(
-						"Exactly one operation must be indicated on command "
-						"line.\n"
-						"Use --help to see the list of possible operations.");
-			}
+				selected_ops.push_back(arg_ops[i]->getName());
 
-		if (selected_op.empty())
+		if (selected_ops.empty())
 		{
 			throw std::runtime_error(
 				"Don't know what to do: No operation was indicated.\n"
 				"Use --help to see the list of possible operations.");
 		}
 
-		VERBOSE_COUT << "Operation to perform: " << selected_op << endl;
+		const bool is_chain = std::all_of(
+			selected_ops.begin(), selected_ops.end(), [&](const string& op) {
+				return obs_ops_factories.count(op) != 0;
+			});
+		if (selected_ops.size() > 1 && !is_chain)
+			throw std::runtime_error(
+				"Exactly one operation must be indicated on command line, or "
+				"a list of operations on individual observations "
+				"(remove-label, decimate, externalize, etc.) to be run one "
+				"after the other.\n"
+				"Use --help to see the list of possible operations.");
 
-		// This will be done for any operation: open the input rawlog
+		// Chained ops run in the order they are given in the command line:
+		auto argvPosition = [argc, argv](const string& op) {
+			for (int i = 1; i < argc; i++)
+			{
+				const string a = argv[i];
+				if (a == "--" + op || a.find("--" + op + "=") == 0) return i;
+			}
+			return argc;
+		};
+		std::stable_sort(
+			selected_ops.begin(), selected_ops.end(),
+			[&](const string& a, const string& b) {
+				return argvPosition(a) < argvPosition(b);
+			});
+
+		for (const auto& op : selected_ops)
+			VERBOSE_COUT << "Operation to perform: " << op << endl;
+
+		// This will be done for any operation: check the input rawlog
 		// ------------------------------------------------------------
 		if (!mrpt::system::fileExists(input_rawlog))
 			throw runtime_error(
 				format("Input file doesn't exist: '%s'", input_rawlog.c_str()));
 
-		// Open input rawlog:
-		CFileGZInputStream fil_input;
-		VERBOSE_COUT << "Opening '" << input_rawlog << "'...\n";
-		fil_input.open(input_rawlog);
-		VERBOSE_COUT << "Open OK.\n";
-
 		// External storage directory?
 		CImage::setImagesPathBase(CRawlog::detectImagesDirectory(input_rawlog));
 		if (mrpt::system::directoryExists(CImage::getImagesPathBase()))
@@ -491,12 +545,31 @@ int main(int argc, char** argv)
 		// ------------------------------------
 		//  EXECUTE THE REQUESTED OPERATION
 		// ------------------------------------
-		ASSERTMSG_(
-			ops_functors.find(selected_op) != ops_functors.end(),
-			"Internal error: Unknown operation functor!");
+		if (is_chain)
+		{
+			vector<TObsOperationFactory> factories;
+			for (const auto& op : selected_ops)
+				factories.push_back(obs_ops_factories[op]);
 
-		// Call the selected functor:
-		ops_functors[selected_op](fil_input, cmd, verbose);
+			// Run all of them in one pass, reading the input rawlog there:
+			runObservationOperations(factories, cmd, verbose);
+		}
+		else
+		{
+			const string& selected_op = selected_ops[0];
+			ASSERTMSG_(
+				ops_functors.find(selected_op) != ops_functors.end(),
+				"Internal error: Unknown operation functor!");
+
+			// Open input rawlog:
+			CFileGZInputStream fil_input;
+			VERBOSE_COUT << "Opening '" << input_rawlog << "'...\n";
+			fil_input.open(input_rawlog);
+			VERBOSE_COUT << "Open OK.\n";
+
+			// Call the selected functor:
+			ops_functors[selected_op](fil_input, cmd, verbose);
+		}
 
 		// successful end of program.
 		ret_val = 0;
@@ -532,7 +605,7 @@ TOutputRawlogCreator::TOutputRawlogCreator()
 			string("\n. Select a different output path, remove the file or "
 				   "force overwrite with '-w' or '--overwrite'."));
 
-	if (!out_rawlog_io.open(out_rawlog_filename))
+	if (!out_rawlog_io.openBlockCompressed(out_rawlog_filename))
 		throw runtime_error(
 			string("*ABORTING*: Cannot open output file: ") +
 			out_rawlog_filename);
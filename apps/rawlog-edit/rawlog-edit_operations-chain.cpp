@@ -0,0 +1,226 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "rawlog-edit-declarations.h"
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/obs/CRawlogPrefetchReader.h>
+#include <algorithm>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace mrpt::rawlogtools;
+using namespace std;
+using namespace mrpt::io;
+
+// ======================================================================
+//		getOutputExternalsDirectory
+// ======================================================================
+std::string getOutputExternalsDirectory(TCLAP::CmdLine& cmdline, bool verbose)
+{
+	// Shared by all the operations in a chain writing external files:
+	static std::string outDir;
+	if (!outDir.empty()) return outDir;
+
+	string out_rawlog_filename;
+	if (!getArgValue<string>(cmdline, "output", out_rawlog_filename))
+		throw runtime_error(
+			"This operation requires an output file. Use '-o file' or "
+			"'--output file'.");
+
+	const string out_rawlog_basedir = extractFileDirectory(out_rawlog_filename);
+
+	string dir =
+		(out_rawlog_basedir.empty() ? string()
+									: (out_rawlog_basedir + string("/"))) +
+		extractFileName(out_rawlog_filename) + string("_Images");
+	if (directoryExists(dir))
+		throw runtime_error(
+			string(
+				"*ABORTING*: Output directory for images already "
+				"exists: ") +
+			dir + string(
+					  "\n. Select a different output path or "
+					  "remove the directory."));
+
+	VERBOSE_COUT << "Creating directory: " << dir << endl;
+
+	mrpt::system::createDirectory(dir);
+	if (!fileExists(dir))
+		throw runtime_error(
+			string("*ABORTING*: Couldn't create directory: ") + dir);
+
+	// Add the final /
+	outDir = dir + "/";
+	return outDir;
+}
+
+// ======================================================================
+//		runObservationOperations
+// ======================================================================
+void runObservationOperations(
+	const std::vector<TObsOperationFactory>& factories,
+	TCLAP::CmdLine& cmdline, bool verbose)
+{
+	ASSERT_(!factories.empty());
+
+	// Check the output first, as the old single-operation implementations:
+	TOutputRawlogCreator outrawlog;
+
+	std::vector<CObservationOperation::Ptr> ops;
+	for (const auto& factory : factories)
+		ops.push_back(factory(cmdline, verbose));
+
+	size_t num_threads = 1;
+	getArgValue<size_t>(cmdline, "threads", num_threads);
+	// With 1 thread, everything runs in this one:
+	mrpt::WorkerThreadsPool pool;
+	if (num_threads != 1) pool.resize(num_threads);
+	VERBOSE_COUT << "Worker threads: " << std::max<size_t>(pool.size(), 1)
+				 << "\n";
+
+	// Entries are read in a background thread while the previous ones are
+	// processed. External data is only loaded on demand by the operations.
+	string input_rawlog;
+	getArgValue<string>(cmdline, "input", input_rawlog);
+
+	// Number of entries processed at once by all the operations:
+	const size_t BATCH_LENGTH = std::max<size_t>(32, 8 * pool.size());
+
+	CRawlogPrefetchReader::TOptions readerOpts;
+	readerOpts.queueLength = BATCH_LENGTH;
+	readerOpts.loadExternalData = false;
+	CRawlogPrefetchReader reader(input_rawlog, readerOpts);
+
+	struct TEntry
+	{
+		CActionCollection::Ptr actions;
+		CSensoryFrame::Ptr SF;
+		CObservation::Ptr obs;
+	};
+	std::vector<TEntry> batch;
+	std::vector<CObservation::Ptr*> batchObs;
+	batch.reserve(BATCH_LENGTH);
+
+	mrpt::system::CTicTac timParse;
+	timParse.Tic();
+	mrpt::system::TTimeStamp last_console_update = mrpt::system::now();
+	size_t rawlogEntry = 0, entries_parsed = 0, entries_removed = 0;
+	bool eof = false;
+
+	while (!eof)
+	{
+		// Read one batch:
+		batch.clear();
+		while (batch.size() < BATCH_LENGTH)
+		{
+			TEntry e;
+			if (!reader.getActionObservationPairOrObservation(
+					e.actions, e.SF, e.obs, rawlogEntry))
+			{
+				eof = true;
+				break;
+			}
+			ASSERT_((e.actions && e.SF) || e.obs);
+			batch.emplace_back(std::move(e));
+		}
+
+		// Abort if the user presses ESC:
+		if (mrpt::system::os::kbhit())
+			if (27 == mrpt::system::os::getch())
+			{
+				std::cerr << "Aborted since user pressed ESC.\n";
+				eof = true;
+			}
+
+		// Observations of this batch, in order. They are passed by
+		// reference, so resetting them removes them from the rawlog:
+		batchObs.clear();
+		for (auto& e : batch)
+		{
+			if (e.obs)
+				batchObs.push_back(&e.obs);
+			else
+				for (auto& obs : *e.SF) batchObs.push_back(&obs);
+		}
+		const size_t N = batchObs.size();
+		entries_parsed += N;
+
+		// Run all operations on the batch, one after the other:
+		for (const auto& op : ops)
+		{
+			auto processRange = [&op, &batchObs](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++)
+				{
+					CObservation::Ptr& obs = *batchObs[i];
+					if (obs && !op->processOneObservation(obs)) obs.reset();
+				}
+			};
+
+			if (op->isSequential() || pool.size() < 2)
+				processRange(0, N);
+			else
+				pool.parallelForBlocks(
+					N, (N + 4 * pool.size() - 1) / (4 * pool.size()),
+					processRange);
+		}
+
+		// Save those entries which are not nullptr, in the original order:
+		for (auto& e : batch)
+		{
+			if (e.actions)
+			{
+				// Remove from SF those observations freed:
+				auto it = e.SF->begin();
+				while (it != e.SF->end())
+				{
+					if (*it)
+						it++;
+					else
+					{
+						it = e.SF->erase(it);
+						entries_removed++;
+					}
+				}
+				(*outrawlog.out_rawlog) << e.actions << e.SF;
+			}
+			else
+			{
+				if (e.obs)
+					(*outrawlog.out_rawlog) << e.obs;
+				else
+					entries_removed++;
+			}
+		}
+
+		// Update status to the console?
+		const mrpt::system::TTimeStamp tNow = mrpt::system::now();
+		if (verbose &&
+			mrpt::system::timeDifference(last_console_update, tNow) > 0.25)
+		{
+			last_console_update = tNow;
+			std::cout << mrpt::format(
+				"Progress: %7u objects --- %7u observations \r",
+				static_cast<unsigned int>(rawlogEntry),
+				static_cast<unsigned int>(entries_parsed));
+			std::cout.flush();
+		}
+	}
+	if (verbose) std::cout << "\n";  // new line after the "\r".
+
+	// Dump statistics:
+	// ---------------------------------
+	VERBOSE_COUT << "Time to process file (sec)        : " << timParse.Tac()
+				 << "\n";
+	VERBOSE_COUT << "Analyzed entries                  : " << entries_parsed
+				 << "\n";
+	VERBOSE_COUT << "Removed entries                   : " << entries_removed
+				 << "\n";
+	for (const auto& op : ops) op->printStatistics(verbose);
+}
@@ -20,29 +20,23 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_remap_timestamps
 // ======================================================================
-DECLARE_OP_FUNCTION(op_remap_timestamps)
+DECLARE_OBS_OPERATION(op_remap_timestamps)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_RemapTimestamps
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_RemapTimestamps : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
 		const double m_a, m_b;
 
 	   public:
-		CRawlogProcessor_RemapTimestamps(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose, double a, double b)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose),
-			  m_a(a),
-			  m_b(b)
+		CObsOperation_RemapTimestamps(bool verbose, double a, double b)
+			: m_a(a), m_b(b)
 		{
 			VERBOSE_COUT << "Applying timestamps remap a*t+b with: a=" << m_a
 						 << " b=" << m_b << endl;
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			// T_NEW = a * T_OLD + b
 			const double t = mrpt::system::timestampToDouble(obs->timestamp);
@@ -50,20 +44,6 @@ DECLARE_OP_FUNCTION(op_remap_timestamps)
 			obs->timestamp = mrpt::system::time_tToTimestamp(t_new);
 			return true;
 		}
-
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
-		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
-		}
 	};
 
 	string sAB_params;
@@ -83,13 +63,5 @@ DECLARE_OP_FUNCTION(op_remap_timestamps)
 	const double a = atof(sAB_tokens[0].c_str());
 	const double b = atof(sAB_tokens[1].c_str());
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_RemapTimestamps proc(in_rawlog, cmdline, verbose, a, b);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
+	return std::make_shared<CObsOperation_RemapTimestamps>(verbose, a, b);
 }
@@ -11,6 +11,7 @@
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CObservationImage.h>
 #include <mrpt/obs/CObservationStereoImages.h>
+#include <atomic>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -22,34 +23,24 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_rename_externals
 // ======================================================================
-DECLARE_OP_FUNCTION(op_rename_externals)
+DECLARE_OBS_OPERATION(op_rename_externals)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_RenameExternals
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_RenameExternals : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
-
 		string imgFileExtension;
-		string outDir;
 
 	   public:
-		size_t entries_converted;
-		size_t entries_skipped;  // Already external
+		std::atomic<size_t> entries_converted{0};
+		std::atomic<size_t> entries_skipped{0};  // Not external
 
-		CRawlogProcessor_RenameExternals(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
+		CObsOperation_RenameExternals(TCLAP::CmdLine& cmdline)
 		{
-			entries_converted = 0;
-			entries_skipped = 0;
-
 			getArgValue<string>(cmdline, "image-format", imgFileExtension);
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			map<string, string> files2rename;
 
@@ -189,32 +180,15 @@ DECLARE_OP_FUNCTION(op_rename_externals)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Entries converted                 : "
+						 << entries_converted << "\n";
+			VERBOSE_COUT << "Entries skipped (not external)    : "
+						 << entries_skipped << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_RenameExternals proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Entries converted                 : "
-				 << proc.entries_converted << "\n";
-	VERBOSE_COUT << "Entries skipped (not external)    : "
-				 << proc.entries_skipped << "\n";
+	MRPT_UNUSED_PARAM(verbose);
+	return std::make_shared<CObsOperation_RenameExternals>(cmdline);
 }
@@ -10,6 +10,7 @@
 #include "rawlog-edit-declarations.h"
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/core/aligned_std_map.h>
+#include <atomic>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -23,29 +24,21 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_sensors_pose
 // ======================================================================
-DECLARE_OP_FUNCTION(op_sensors_pose)
+DECLARE_OBS_OPERATION(op_sensors_pose)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_SensorsPose
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_SensorsPose : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
-
 		using TSensor2PoseMap =
 			mrpt::aligned_std_map<std::string, mrpt::poses::CPose3D>;
 		TSensor2PoseMap desiredSensorPoses;
 
 	   public:
-		size_t m_changedPoses;
+		std::atomic<size_t> m_changedPoses{0};
 
-		CRawlogProcessor_SensorsPose(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
+		CObsOperation_SensorsPose(TCLAP::CmdLine& cmdline)
 		{
-			m_changedPoses = 0;
-
 			// Load .ini file with poses:
 			string ini_poses;
 			getArgValue<string>(cmdline, "sensors-pose", ini_poses);
@@ -94,7 +87,7 @@ DECLARE_OP_FUNCTION(op_sensors_pose)
 					ini_poses);
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
+		bool processOneObservation(CObservation::Ptr& obs) override
 		{
 			// Check the sensor label:
 			TSensor2PoseMap::iterator i =
@@ -107,30 +100,13 @@ DECLARE_OP_FUNCTION(op_sensors_pose)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Number of modified entries        : "
+						 << m_changedPoses << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_SensorsPose proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Number of modified entries        : "
-				 << proc.m_changedPoses << "\n";
+	MRPT_UNUSED_PARAM(verbose);
+	return std::make_shared<CObsOperation_SensorsPose>(cmdline);
 }
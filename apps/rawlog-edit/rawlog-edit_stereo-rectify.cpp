@@ -20,22 +20,17 @@ using namespace mrpt::io;
 // ======================================================================
 //		op_stereo_rectify
 // ======================================================================
-DECLARE_OP_FUNCTION(op_stereo_rectify)
+DECLARE_OBS_OPERATION(op_stereo_rectify)
 {
 	// A class to do this operation:
-	class CRawlogProcessor_StereoRectify
-		: public CRawlogProcessorOnEachObservation
+	class CObsOperation_StereoRectify : public CObservationOperation
 	{
 	   protected:
-		TOutputRawlogCreator outrawlog;
-
 		string target_label;
 		string outDir;
 		string imgFileExtension;
 		double rectify_alpha;  // [0,1] see cvStereoRectify()
 
-		bool m_this_obs_is_ok;
-
 		mrpt::vision::CStereoRectifyMap rectify_map;
 
 		size_t m_num_external_files_failures;
@@ -43,10 +38,7 @@ DECLARE_OP_FUNCTION(op_stereo_rectify)
 	   public:
 		size_t m_changedCams;
 
-		CRawlogProcessor_StereoRectify(
-			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
-			bool verbose)
-			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, verbose)
+		CObsOperation_StereoRectify(TCLAP::CmdLine& cmdline, bool verbose)
 		{
 			m_changedCams = 0;
 			m_num_external_files_failures = 0;
@@ -74,34 +66,6 @@ DECLARE_OP_FUNCTION(op_stereo_rectify)
 
 			getArgValue<string>(cmdline, "image-format", imgFileExtension);
 
-			// Create a "/Images_Rectified" directory.
-			const string out_rawlog_basedir =
-				extractFileDirectory(outrawlog.out_rawlog_filename);
-
-			outDir = (out_rawlog_basedir.empty()
-						  ? string()
-						  : (out_rawlog_basedir + string("/"))) +
-					 extractFileName(outrawlog.out_rawlog_filename) +
-					 string("_Images");
-			if (directoryExists(outDir))
-				throw runtime_error(
-					string(
-						"*ABORTING*: Output directory for rectified images "
-						"already exists: ") +
-					outDir + string(
-								 "\n. Select a different output path or "
-								 "remove the directory."));
-
-			VERBOSE_COUT << "Creating directory: " << outDir << endl;
-
-			mrpt::system::createDirectory(outDir);
-			if (!fileExists(outDir))
-				throw runtime_error(
-					string("*ABORTING*: Couldn't create directory: ") + outDir);
-
-			// Add the final /
-			outDir += "/";
-
 			// Optional argument:  "--image-size=640x480"
 			string strResize;
 			if (getArgValue<string>(cmdline, "image-size", str))
@@ -128,12 +92,16 @@ DECLARE_OP_FUNCTION(op_stereo_rectify)
 					<< "Will rectify such that both image centers coincide.\n";
 				rectify_map.enableBothCentersCoincide(true);
 			}
+
+			// Create the "/Images" directory for the rectified images:
+			outDir = getOutputExternalsDirectory(cmdline, verbose);
 		}
 
-		bool processOneObservation(CObservation::Ptr& obs)
-		{
-			m_this_obs_is_ok = true;
+		// The rectification map is built from the first observation:
+		bool isSequential() const override { return true; }
 
+		bool processOneObservation(CObservation::Ptr& obs) override
+		{
 			if (strCmpI(obs->sensorLabel, target_label))
 			{
 				if (IS_CLASS(obs, CObservationStereoImages))
@@ -188,11 +156,13 @@ DECLARE_OP_FUNCTION(op_stereo_rectify)
 
 						if (m_num_external_files_failures < MAX_FAILURES)
 						{
-							m_this_obs_is_ok = false;
 							cerr << "\n *WARNING*: Dropping one observation "
 									"due to missing external image file at "
-									"rawlog entry "
-								 << m_rawlogEntry << endl;
+									"timestamp "
+								 << format(
+										"%f", timestampTotime_t(o->timestamp))
+								 << endl;
+							return false;
 						}
 						else
 						{
@@ -206,32 +176,12 @@ DECLARE_OP_FUNCTION(op_stereo_rectify)
 			return true;
 		}
 
-		// This method can be reimplemented to save the modified object to an
-		// output stream.
-		virtual void OnPostProcess(
-			mrpt::obs::CActionCollection::Ptr& actions,
-			mrpt::obs::CSensoryFrame::Ptr& SF,
-			mrpt::obs::CObservation::Ptr& obs)
+		void printStatistics(bool verbose) const override
 		{
-			if (!m_this_obs_is_ok) return;
-
-			ASSERT_((actions && SF) || obs);
-			if (actions)
-				(*outrawlog.out_rawlog) << actions << SF;
-			else
-				(*outrawlog.out_rawlog) << obs;
+			VERBOSE_COUT << "Number of modified entries        : "
+						 << m_changedCams << "\n";
 		}
 	};
 
-	// Process
-	// ---------------------------------
-	CRawlogProcessor_StereoRectify proc(in_rawlog, cmdline, verbose);
-	proc.doProcessRawlog();
-
-	// Dump statistics:
-	// ---------------------------------
-	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
-				 << "\n";
-	VERBOSE_COUT << "Number of modified entries        : " << proc.m_changedCams
-				 << "\n";
+	return std::make_shared<CObsOperation_StereoRectify>(cmdline, verbose);
 }
@@ -20,7 +20,7 @@
 
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/obs/CActionRobotMovement3D.h>
-#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogPrefetchReader.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/io/CFileOutputStream.h>
@@ -231,8 +231,8 @@ void MapBuilding_RBPF()
 	char strFil[1000];
 
 	size_t rawlogEntry = 0;
-	CFileGZInputStream rawlogFile(RAWLOG_FILE);
-	auto rawlogArch = mrpt::serialization::archiveFrom(rawlogFile);
+	// Read and decode the rawlog in the background:
+	CRawlogPrefetchReader rawlogReader(RAWLOG_FILE);
 
 	// ---------------------------------
 	//		MapPDF opts
@@ -377,11 +377,17 @@ void MapBuilding_RBPF()
 			if (c == 27) break;
 		}
 
-		// Load action/observation pair from the rawlog:
+		// Load action/observation pair from the rawlog, skipping single
+		// observations as CRawlog::readActionObservationPair() does:
 		// --------------------------------------------------
-		if (!CRawlog::readActionObservationPair(
-				rawlogArch, action, observations, rawlogEntry))
-			break;  // file EOF
+		CObservation::Ptr observation;
+		bool eof;
+		do
+		{
+			eof = !rawlogReader.getActionObservationPairOrObservation(
+				action, observations, observation, rawlogEntry);
+		} while (!eof && !action);
+		if (eof) break;  // file EOF
 
 		if (rawlogEntry >= rawlog_offset)
 		{
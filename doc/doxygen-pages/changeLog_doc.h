@@ -32,8 +32,26 @@ serialization with variants(To be replaced by std::variant eventually).
 	- Changes in applications:
 		- RawLogViewer:
 			- The ICP module now supports Velodyne 3D scans.
+		- icp-slam, rbpf-slam:
+			- The rawlog is read and decoded in a background thread, see
+mrpt::obs::CRawlogPrefetchReader.
 		- pf-localization:
 			- Odometry is now used also for observation-only rawlogs.
+			- The rawlog is read and decoded in a background thread.
+		- observations2map, pf-localization:
+			- `.simplemap` observations are loaded on demand, see
+mrpt::maps::CSimpleMap::loadFromFileLazy().
+		- rawlog-edit:
+			- Output rawlogs are written block-compressed, in parallel.
+			- New operation `--build-index` to save an index of the rawlog.
+`--cut` uses it, if present, to skip the entries before the cut.
+			- Fix: filtering operations (e.g. `--cut`) did not remove
+observations from the output rawlog.
+			- Operations on individual observations (`--keep-label`,
+`--externalize`, `--generate-3d-pointclouds`, etc.) can be chained in one
+command, and run in one pass over the rawlog using several threads (see
+`--threads`), preserving the order of the output entries.
+			- New operation `--decimate`.
 	- Changes in libraries:
 		- \ref mrpt_base_grp => Refactored into several smaller libraries, one
 per namespace.
@@ -44,6 +62,7 @@ string_manage.
 			- Memory alignment of aligned_allocator_cpp11<> is set to 16,32 or
 64 depending on whether AVX optimizations are enabled, to be compatible with
 Eigen.
+			- New class mrpt::WorkerThreadsPool.
 		- \ref mrpt_math_grp  [NEW IN MRPT 2.0.0]
 			- Removed functions (replaced by C++11/14 standard library):
 				- mrpt::math::erf, mrpt::math::erfc, std::isfinite,
@@ -53,16 +72,126 @@ initializator
 			- Removed the include file: `<mrpt/math/jacobians.h>`. Replace by
 `<mrpt/math/num_jacobian.h>` or individual methods in \ref mrpt_poses_grp
 classes.
+			- mrpt::math::KDTreeCapable: queries no longer share an internal
+buffer, so they can be run from several threads once the index is built (see
+kdTreeEnsureIndexBuilt3D()).
+			- mrpt::math::KDTreeCapable: New option
+mrpt::math::KDTreeCapable::TKDTreeSearchParams::incremental to extend the index
+with appended points (see kdtree_mark_as_appended()) instead of rebuilding it.
+			- mrpt::math::CSparseMatrix: New methods getStoredValues(),
+getStoredValuesCount() and getStoredValueIndex() to change the values of a
+column-compressed matrix in place. New constructor
+mrpt::math::CSparseMatrix::CholeskyDecomp::CholeskyDecomp(const CSparseMatrix&,bool)
+to do only the symbolic analysis, reused by update().
+			- mrpt::math::CLevenbergMarquardtTempl: New method executeSparse() for
+problems with sparse Jacobians (given by a user functor or estimated by finite
+differences of groups of independent parameters), solved by sparse Cholesky.
+New fields `robust_kernel`, `robust_kernel_param` and `residual_size` for
+robust cost functions, and `num_threads` to estimate Jacobians in parallel.
 		- \ref mrpt_config_grp  [NEW IN MRPT 2.0.0]
 			- mrpt::config::CConfigFileBase::write() now supports enum types.
 		- \ref mrpt_serialization_grp  [NEW IN MRPT 2.0.0]
 			- New method mrpt::serialization::CArchive::ReadPOD() and macro
 `MRPT_READ_POD()` for reading unaligned POD variables.-
 			- Add support for `$env{}` syntax to evaluate environment variables.
+			- New method mrpt::serialization::CArchive::ReadBufferView() to use
+large arrays in place, without copying them, in streams holding their data in
+memory.
+			- New class mrpt::serialization::CSerializablePool and method
+mrpt::serialization::CArchive::ReadObject(CSerializablePool&): deserialize
+objects into recycled instances of selected classes, keeping the capacity of
+their buffers, to read high-rate observations without memory allocations.
+		- \ref mrpt_io_grp
+			- mrpt::io::CFileGZInputStream now implements Seek().
+			- mrpt::io::CFileGZOutputStream::openBlockCompressed(): writes a
+block-compressed gzip file (BGZF format), compressing 64KB blocks in parallel.
+mrpt::io::CFileGZInputStream detects these files, decompresses blocks ahead in
+parallel and seeks without decompressing the preceding data. Files are still
+standard gzip files.
+			- New class mrpt::io::CFileMMapInputStream: a memory-mapped input
+file. mrpt::io::CFileGZInputStream uses it for uncompressed files.
+			- New method mrpt::io::CStream::ReadView() to access the data of
+memory streams and memory-mapped files without copying it.
+		- \ref mrpt_poses_grp
+			- mrpt::poses::CPoseRandomSampler::drawSample() can now use a
+user-provided random generator.
+		- \ref mrpt_obs_grp
+			- New class mrpt::obs::CRawlogIndex: a sidecar index of the
+offset, timestamp, class and sensor label of each rawlog entry, for random
+access. New method mrpt::obs::CRawlog::loadFromRawLogFileIndexed() to load
+only a time range and/or sensor label of a rawlog file.
+			- mrpt::obs::CRawlog::saveToRawLogFile() writes block-compressed
+files, see mrpt::io::CFileGZOutputStream::openBlockCompressed().
+			- New class mrpt::obs::CRawlogPrefetchReader: reads a rawlog in a
+background thread into a bounded queue of entries, loading their
+externally-stored images in advance. It can read objects from a
+mrpt::serialization::CSerializablePool.
+			- mrpt::obs::CObservationVelodyneScan::generatePointCloud() is
+faster: it decodes packets with per-laser tables straight into the point cloud
+columns, optionally in parallel (see
+mrpt::obs::CObservationVelodyneScan::TGeneratePointCloudParameters::numThreads).
+A new overload decodes into a user-provided mrpt::obs::CObservationVelodyneScan::TPointCloud.
+generatePointCloudAlongSE3Trajectory() interpolates the vehicle pose once per
+packet.
+			- mrpt::obs::CObservation3DRangeScan::project3DPointsFromDepthImageInto()
+is faster and can run in parallel, decimate the range image and apply a voxel
+filter in the same pass (see new fields in
+mrpt::obs::T3DPointsProjectionParams). Projection LUTs are now cached for each
+camera, and are safe to use from several threads; the signature of
+mrpt::obs::CObservation3DRangeScan::get_3dproj_lut() changed accordingly.
+T3DPointsProjectionParams::USE_SSE2 is now ignored.
+			- mrpt::obs::CObservationImage and
+mrpt::obs::CObservationStereoImages now implement load() and unload(), and
+mrpt::obs::CObservation3DRangeScan::load() also loads the intensity and
+confidence images.
+			- New method mrpt::maps::CSimpleMap::loadFromFileLazy(): keyframe
+poses are loaded at once, and the observations of each
+mrpt::obs::CSensoryFrame are read from disk upon first access, keeping at most
+a given number of frames in memory, for files saved with the new
+`lazyLoadable` flag of mrpt::maps::CSimpleMap::saveToFile(). Simplemaps are now
+saved block-compressed.
+		- \ref mrpt_bayes_grp
+			- mrpt::bayes::CParticleFilter: New options `numThreads` and
+`parallelBlockSize` for multi-threaded prediction and weighting in
+`pfStandardProposal`, with per-block random streams for reproducible results.
 		- \ref mrpt_slam_grp
 			- rbpf-slam: Add support for simplemap continuation.
 			- CICP: parameter `onlyClosestCorrespondences` deleted (always true
 now).
+			- mrpt::slam::CICP: New 3D algorithms `icpPointToPlane` and
+`icpGeneralized` (GICP), and new option `numThreads` to search for
+correspondences in parallel.
+			- New class mrpt::slam::CCorrelativeScanMatcher: global 2D scan
+matching against an occupancy grid over large x/y/phi windows, by branch and
+bound on a pyramid of max-pooled likelihood fields.
+		- \ref mrpt_graphs_grp
+			- mrpt::graphs::CDijkstra runs on a compact adjacency snapshot of the
+graph (TAdjacencySnapshot) with a binary heap, in O(E log V) instead of
+O(V^2). New method CDijkstra::fromSources() to run several searches sharing one
+snapshot in the threads of a given pool.
+			- New mrpt::graphs::CNetworkOfPoses::dijkstra_nodes_estimate()
+overload which keeps the spanning tree between calls and only updates the nodes
+affected by the new edges, taken from the edge change log of the graph. Used
+by graphslam-engine.
+			- mrpt::graphs::CDirectedGraph can log the edges inserted and erased
+through its methods (enableEdgeChangeLog(), getEdgeChangesSince()), so
+incremental algorithms do not need to look at all the edges in each step.
+		- \ref mrpt_graphslam_grp
+			- mrpt::graphslam::optimize_graph_spa_levmarq() is much faster for
+large graphs: the sparse structure of the Hessian and the symbolic Cholesky
+analysis are built once, and constraints are linearized and the Hessian
+assembled in parallel with the new parameter `num_threads`.
+			- New optimizer mrpt::graphslam::optimizers::CIncrementalGSO for
+graphslam-engine (`--optimizer CIncrementalGSO`): iSAM-style incremental
+Gauss-Newton that updates the Cholesky factor of the problem, only relinearizes
+nodes that moved and does a partial back-substitution, with a constant cost per
+step for odometry-like constraints.
+			- mrpt::graphslam::deciders::CLoopCloserERD: the ICP alignments of the
+loop closure hypotheses and the pair-wise consistency matrix are computed in
+parallel (new parameter `LC_num_threads`), and Dijkstra runs once per pair of
+nodes in a group instead of once per matrix element. New parameter
+`LC_async_evaluation` to evaluate loop closures in the background and register
+them at the next step.
 		- \ref mrpt_nav_grp
 			- Removed deprecated mrpt::nav::THolonomicMethod.
 			- mrpt::nav::CAbstractNavigator: callbacks in
@@ -73,9 +202,42 @@ configuration files.
 		- \ref mrpt_comms_grp [NEW IN MRPT 2.0.0]
 			- This new module has been created to hold all serial devices &
 networking classes, with minimal dependencies.
+			- New class mrpt::comms::CSharedMemoryChannel: sends serializable
+objects or raw messages between processes in the same host through a ring
+buffer in shared memory, serializing and deserializing them in place.
 		- \ref mrpt_maps_grp
 			- Added optional "channel" attribute to CReflectivityGrdMap2D and
 CObservationReflectivity to support different colors of light.
+			- mrpt::maps::COccupancyGridMap2D: New batch methods
+computeLikelihoodField_Thrun() and computeObservationLikelihoodForPoses() to
+evaluate one scan against many candidate poses at once (SSE2-vectorized).
+			- mrpt::maps::COccupancyGridMap2D: The likelihood-field cache is now
+built with an exact distance transform and updated incrementally, only around
+modified cells. New method updateVoronoiDiagram() for incremental updates of
+the Voronoi diagram.
+			- mrpt::maps::COccupancyGridMap2D: New insertion option `numThreads`
+to insert 2D range scans in parallel, by bands of rows. The resulting grid is
+identical to the single-threaded one.
+			- mrpt::maps::COccupancyGridMap2D: New optional tiled storage, see
+mrpt::maps::COccupancyGridMap2D::setTiledStorage(): 64x64-cell tiles are
+allocated on demand and growing the grid does not copy the cells. Enabled from
+config files with `tiledStorage=true` in the `_creationOpts` section. The
+serialization format is unchanged.
+			- mrpt::maps::COccupancyGridMap2D: New method
+laserScanSimulatorBatch() to simulate scans from many poses at once, in
+parallel and skipping over free space with a cached clearance map (sphere
+tracing). Ranges are identical to laserScanSimulator(). Also used by
+computeObservationLikelihoodForPoses() for the `lmRayTracing` method.
+			- mrpt::maps::CPointsMap: determineMatching3D() can run the
+nearest-neighbor queries in parallel (see mrpt::maps::TMatchingParams::numThreads).
+New methods getPointsNormals() and getPointsLocalCovariances(), cached per map.
+			- mrpt::maps::CPointsMap: Insertions that append points (scans with
+`addToExistingPointsMap`, insertPoint(), insertAnotherMap()) keep the kd-tree
+when its incremental mode is enabled, as done by mrpt::slam::CMetricMapBuilderICP.
+			- New class mrpt::maps::CVoxelHashPointsMap: a point cloud indexed by
+a hash table of voxels, with a bounded number of points per voxel and voxel-based
+nearest-neighbor queries, used by determineMatching3D() and getPointsNormals().
+Config file map name: `voxelHashPointsMap`.
 		- \ref mrpt_hwdrivers_grp
 			- COpenNI2Generic: is safer in multithreading apps.
 			- CHokuyoURG:
@@ -95,6 +257,8 @@ rotation matrices.
 (via the new `MRPT_READ_POD()` macro).
 		- Fix segfault in CMetricMap::loadFromSimpleMap() if the provided
 CMetricMap has empty smart pointers.
+		- Fix COutputLogger crash when logging formatted messages longer than
+1024 characters.
 	- Fix crash in CGPSInterface when not setting an external mutex.
 
 <hr>
@@ -192,6 +356,10 @@ mrpt::nav::CRobot2NavInterface are now invoked *after* `navigationStep()` to
 avoid problems if user code invokes the navigator API to change its state.
 			- Added methods to load/save mrpt::nav::TWaypointSequence to
 configuration files.
+		- \ref mrpt_bayes_grp
+			- mrpt::bayes::CParticleFilter: New options `numThreads` and
+`parallelBlockSize` for multi-threaded prediction and weighting in
+`pfStandardProposal`, with per-block random streams for reproducible results.
 		- \ref mrpt_slam_grp
 			- rbpf-slam: Add support for simplemap continuation.
 	- BUG FIXES:
@@ -15,6 +15,8 @@
 <h2>Library <code>mrpt-comms</code></h2>
 <hr>
 
-This module includes classes related to serial ports/devices and networking (TCP, DNS,...) utilities.
+This module includes classes related to serial ports/devices and networking (TCP, DNS,...) utilities, and a
+shared-memory channel between processes in the same host
+(mrpt::comms::CSharedMemoryChannel).
 
 */
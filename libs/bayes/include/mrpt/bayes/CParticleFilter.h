@@ -163,6 +163,27 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE{false};
+
+		/** (Default=1) Number of threads for the prediction and weighting
+		 * stages of those algorithms supporting parallel execution (currently,
+		 * "CParticleFilter::pfStandardProposal" with a fixed sample size).
+		 *  - 1: Single-threaded, in the calling thread.
+		 *  - 0: As many threads as hardware cores.
+		 *  - N>1: Use N worker threads.
+		 *
+		 * With a fixed sample size, particles are predicted in blocks of
+		 * `parallelBlockSize`, each with its own random number stream seeded
+		 * from mrpt::random::getRandomGenerator(), so results for a given seed
+		 * do not depend on the number of threads, single-threaded mode
+		 * included. In multi-threaded mode, the observation likelihood model
+		 * of the particle filter must be safe to evaluate concurrently once
+		 * it has been evaluated for the first particle.
+		 */
+		unsigned int numThreads{1};
+		/** (Default=256) Number of particles processed as a unit of work,
+		 * and sharing a random number stream. See numThreads. A value of 0
+		 * is handled as 1. */
+		unsigned int parallelBlockSize{256};
 	};
 
 	/** Statistics for being returned from the "execute" method. */
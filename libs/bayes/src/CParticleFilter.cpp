@@ -133,6 +133,13 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Threads for prediction & weighting: 1=single-threaded, 0=as many as "
+		"cores");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		parallelBlockSize,
+		"Particles per unit of work in multi-threaded mode");
 }
 
 /*---------------------------------------------------------------
@@ -175,6 +182,9 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 		section.c_str());
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(parallelBlockSize, int, iniFile, section.c_str());
+	ASSERT_(parallelBlockSize > 0);
 
 	MRPT_END
 }
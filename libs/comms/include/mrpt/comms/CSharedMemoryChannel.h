@@ -0,0 +1,150 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/serialization/CSerializable.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace mrpt
+{
+namespace serialization
+{
+class CSerializablePool;
+}
+namespace comms
+{
+/** A channel between two processes (or threads) in the same host, through a
+ * ring buffer of message slots in shared memory.
+ *
+ * One side creates the channel with a unique name, and the other one opens
+ * it by that name. Messages are sent by one writer and received, in order,
+ * by one reader. A writer waits while all the slots are full, and a reader
+ * while they are all empty.
+ *
+ * Messages are written and read in place, without intermediary buffers:
+ * - sendObject() serializes an object straight into a slot of the shared
+ * memory, and receiveObject() deserializes it from there. Classes reading
+ * their data with mrpt::serialization::CArchive::ReadBufferView() may use it
+ * in place. Using a mrpt::serialization::CSerializablePool avoids
+ * allocating memory for the received objects.
+ * - For other payloads, beginWrite() and commitWrite(), and beginRead() and
+ * endRead(), give direct access to the memory of the slots.
+ *
+ * \code
+ * // Process 1:
+ * CSharedMemoryChannel ch;
+ * ch.create("/robot_scans");
+ * ch.sendObject(scan);
+ *
+ * // Process 2:
+ * CSharedMemoryChannel ch;
+ * ch.open("/robot_scans");
+ * auto obj = ch.receiveObject();
+ * \endcode
+ *
+ * \note Implemented with POSIX shared memory and process-shared mutexes;
+ * on other systems create() and open() always return false.
+ * \note There must be only one writer and one reader at a time.
+ * \ingroup mrpt_comms_grp
+ */
+class CSharedMemoryChannel
+{
+   public:
+	struct TOptions
+	{
+		TOptions();
+		/** Number of message slots (Default: 8) */
+		std::size_t slotCount;
+		/** Maximum size of each message, in bytes (Default: 4 MiB) */
+		std::size_t slotSize;
+	};
+
+	CSharedMemoryChannel();
+	/** Dtor: calls close() */
+	~CSharedMemoryChannel();
+
+	CSharedMemoryChannel(const CSharedMemoryChannel&) = delete;
+	CSharedMemoryChannel& operator=(const CSharedMemoryChannel&) = delete;
+
+	/** Creates a new channel. The name must be unique in the system, like a
+	 * file name, and a leading "/" is added if missing. The channel is
+	 * removed when the creator closes it, although the other side can still
+	 * use it until it closes it too.
+	 * \return false on any error, e.g. if the channel already exists. */
+	bool create(const std::string& name, const TOptions& options = TOptions());
+	/** Opens a channel created by another process or object.
+	 * \return false if it does not exist or on any error. */
+	bool open(const std::string& name);
+	/** Closes the channel, removing it if this object created it. Any message
+	 * being written or read is discarded. */
+	void close();
+	/** Returns true if a channel was created or open */
+	bool isOpen() const;
+
+	/** Maximum size of a message, in bytes */
+	std::size_t slotSize() const;
+	/** Number of messages ready to be read */
+	std::size_t pendingMessages() const;
+
+	/** @name Objects
+	 * @{ */
+	/** Serializes an object into the next slot, waiting for one to be free.
+	 * \param timeout_ms Maximum time to wait, or -1 to wait forever.
+	 * \return false on timeout.
+	 * \exception std::exception If the object does not fit in a slot. */
+	bool sendObject(
+		const mrpt::serialization::CSerializable& obj, int timeout_ms = -1);
+	/** Receives the next object, waiting for it.
+	 * \param timeout_ms Maximum time to wait, or -1 to wait forever.
+	 * \param pool If not null, objects of the classes enabled in the pool are
+	 * recycled instances taken from it.
+	 * \return nullptr on timeout.
+	 * \exception std::exception On deserialization errors. */
+	mrpt::serialization::CSerializable::Ptr receiveObject(
+		int timeout_ms = -1,
+		mrpt::serialization::CSerializablePool* pool = nullptr);
+	/** Receives the next object into an existing one, which must be of the
+	 * same class.
+	 * \return false on timeout.
+	 * \exception std::exception On deserialization errors or class mismatch.
+	 */
+	bool receiveObject(
+		mrpt::serialization::CSerializable& obj, int timeout_ms = -1);
+	/** @} */
+
+	/** @name Raw access to messages
+	 * @{ */
+	/** Waits for a free slot and returns its memory, with room for
+	 * slotSize() bytes, to write a message in place. The message is sent by
+	 * commitWrite().
+	 * \param timeout_ms Maximum time to wait, or -1 to wait forever.
+	 * \return nullptr on timeout. */
+	void* beginWrite(int timeout_ms = -1);
+	/** Sends the message written in the slot returned by beginWrite(), with
+	 * the given length in bytes. */
+	void commitWrite(std::size_t length);
+	/** Waits for the next message and returns a pointer to it in the shared
+	 * memory, valid until endRead().
+	 * \param timeout_ms Maximum time to wait, or -1 to wait forever.
+	 * \return nullptr on timeout. */
+	const void* beginRead(std::size_t& length, int timeout_ms = -1);
+	/** Frees the slot of the message returned by beginRead() */
+	void endRead();
+	/** @} */
+
+   private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace comms
+}  // namespace mrpt
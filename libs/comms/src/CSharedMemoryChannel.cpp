@@ -0,0 +1,466 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "comms-precomp.h"  // Precompiled headers
+
+#include <mrpt/comms/CSharedMemoryChannel.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/CSerializablePool.h>
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using namespace mrpt::comms;
+using mrpt::serialization::CSerializable;
+
+namespace
+{
+/** Writes into the memory of a slot, up to its size */
+class CSlotOutputStream : public mrpt::io::CStream
+{
+   public:
+	CSlotOutputStream(void* data, std::size_t capacity)
+		: m_data(static_cast<uint8_t*>(data)), m_capacity(capacity)
+	{
+	}
+	size_t Read(void* Buffer, size_t Count) override
+	{
+		MRPT_UNUSED_PARAM(Buffer);
+		MRPT_UNUSED_PARAM(Count);
+		THROW_EXCEPTION("Trying to read from a write-only stream.");
+	}
+	size_t Write(const void* Buffer, size_t Count) override
+	{
+		if (Count > m_capacity - m_position)
+			THROW_EXCEPTION_FMT(
+				"Message larger than the slot size (%u bytes). Increase "
+				"CSharedMemoryChannel::TOptions::slotSize.",
+				static_cast<unsigned int>(m_capacity));
+		::memcpy(m_data + m_position, Buffer, Count);
+		m_position += Count;
+		return Count;
+	}
+	uint64_t Seek(int64_t Offset, TSeekOrigin Origin) override
+	{
+		MRPT_UNUSED_PARAM(Offset);
+		MRPT_UNUSED_PARAM(Origin);
+		THROW_EXCEPTION("Seek is not supported in this stream.");
+	}
+	uint64_t getTotalBytesCount() const override { return m_position; }
+	uint64_t getPosition() const override { return m_position; }
+
+   private:
+	uint8_t* m_data;
+	std::size_t m_capacity, m_position{0};
+};
+
+#ifndef _WIN32
+const uint32_t SHM_MAGIC = 0x4d52504d;  // "MPRM"
+const uint32_t SHM_VERSION = 1;
+const std::size_t SHM_ALIGN = 64;
+
+std::size_t alignSize(std::size_t n)
+{
+	return (n + SHM_ALIGN - 1) / SHM_ALIGN * SHM_ALIGN;
+}
+
+/** Header at the beginning of the shared memory, followed by the slots */
+struct TShmHeader
+{
+	/** Set once the rest is initialized */
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint64_t slotCount, slotSize, slotStride;
+	pthread_mutex_t mtx;
+	/** Signals new messages */
+	pthread_cond_t cvMessages;
+	/** Signals free slots */
+	pthread_cond_t cvSlots;
+	/** Number of messages written and read so far (protected by mtx) */
+	uint64_t written, read;
+};
+
+/** Each slot: the message length, followed by the message */
+const std::size_t SLOT_DATA_OFFSET = 16;
+
+/** Locks a robust mutex, recovering it if its owner died */
+class CShmLock
+{
+   public:
+	explicit CShmLock(pthread_mutex_t* mtx) : m_mtx(mtx)
+	{
+		if (::pthread_mutex_lock(m_mtx) == EOWNERDEAD)
+			::pthread_mutex_consistent(m_mtx);
+	}
+	~CShmLock() { ::pthread_mutex_unlock(m_mtx); }
+	/** Waits on the condition until pred() is true, or for timeout_ms
+	 * (if >=0) milliseconds. \return The last result of pred() */
+	template <class PRED>
+	bool wait(pthread_cond_t* cv, int timeout_ms, PRED pred)
+	{
+		timespec deadline;
+		if (timeout_ms >= 0)
+		{
+			::clock_gettime(CLOCK_MONOTONIC, &deadline);
+			deadline.tv_sec += timeout_ms / 1000;
+			deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+			if (deadline.tv_nsec >= 1000000000L)
+			{
+				deadline.tv_sec++;
+				deadline.tv_nsec -= 1000000000L;
+			}
+		}
+		while (!pred())
+		{
+			const int ret =
+				timeout_ms < 0 ? ::pthread_cond_wait(cv, m_mtx)
+							   : ::pthread_cond_timedwait(cv, m_mtx, &deadline);
+			if (ret == EOWNERDEAD)
+				::pthread_mutex_consistent(m_mtx);
+			else if (ret == ETIMEDOUT)
+				return pred();
+		}
+		return true;
+	}
+
+   private:
+	pthread_mutex_t* m_mtx;
+};
+#endif
+}  // namespace
+
+struct CSharedMemoryChannel::Impl
+{
+	std::string name;
+	/** Whether this object created the channel */
+	bool owner{false};
+	uint8_t* mem{nullptr};
+	std::size_t memSize{0};
+	bool writing{false}, reading{false};
+
+#ifndef _WIN32
+	TShmHeader* header() { return reinterpret_cast<TShmHeader*>(mem); }
+	/** The slot of the i-th message */
+	uint8_t* slot(uint64_t i)
+	{
+		TShmHeader* h = header();
+		return mem + alignSize(sizeof(TShmHeader)) +
+			   (i % h->slotCount) * h->slotStride;
+	}
+#endif
+};
+
+CSharedMemoryChannel::TOptions::TOptions()
+	: slotCount(8), slotSize(4 * 1024 * 1024)
+{
+}
+
+CSharedMemoryChannel::CSharedMemoryChannel() {}
+CSharedMemoryChannel::~CSharedMemoryChannel() { close(); }
+bool CSharedMemoryChannel::create(
+	const std::string& name, const TOptions& options)
+{
+	MRPT_START
+	close();
+	ASSERT_(options.slotCount > 0 && options.slotSize > 0);
+#ifdef _WIN32
+	MRPT_UNUSED_PARAM(name);
+	return false;
+#else
+	const std::string shmName = (name.empty() || name[0] != '/')
+									? std::string("/") + name
+									: name;
+	const int fd =
+		::shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) return false;
+
+	const std::size_t slotStride =
+		alignSize(SLOT_DATA_OFFSET + options.slotSize);
+	const std::size_t memSize =
+		alignSize(sizeof(TShmHeader)) + options.slotCount * slotStride;
+	void* p = MAP_FAILED;
+	if (::ftruncate(fd, memSize) == 0)
+		p = ::mmap(
+			nullptr, memSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED)
+	{
+		::shm_unlink(shmName.c_str());
+		return false;
+	}
+
+	m_impl.reset(new Impl);
+	m_impl->name = shmName;
+	m_impl->owner = true;
+	m_impl->mem = static_cast<uint8_t*>(p);
+	m_impl->memSize = memSize;
+
+	TShmHeader* h = m_impl->header();
+	h->version = SHM_VERSION;
+	h->slotCount = options.slotCount;
+	h->slotSize = options.slotSize;
+	h->slotStride = slotStride;
+	h->written = h->read = 0;
+
+	pthread_mutexattr_t mtxAttr;
+	::pthread_mutexattr_init(&mtxAttr);
+	::pthread_mutexattr_setpshared(&mtxAttr, PTHREAD_PROCESS_SHARED);
+	::pthread_mutexattr_setrobust(&mtxAttr, PTHREAD_MUTEX_ROBUST);
+	::pthread_mutex_init(&h->mtx, &mtxAttr);
+	::pthread_mutexattr_destroy(&mtxAttr);
+
+	pthread_condattr_t cvAttr;
+	::pthread_condattr_init(&cvAttr);
+	::pthread_condattr_setpshared(&cvAttr, PTHREAD_PROCESS_SHARED);
+	::pthread_condattr_setclock(&cvAttr, CLOCK_MONOTONIC);
+	::pthread_cond_init(&h->cvMessages, &cvAttr);
+	::pthread_cond_init(&h->cvSlots, &cvAttr);
+	::pthread_condattr_destroy(&cvAttr);
+
+	h->magic.store(SHM_MAGIC, std::memory_order_release);
+	return true;
+#endif
+	MRPT_END
+}
+
+bool CSharedMemoryChannel::open(const std::string& name)
+{
+	close();
+#ifdef _WIN32
+	MRPT_UNUSED_PARAM(name);
+	return false;
+#else
+	const std::string shmName = (name.empty() || name[0] != '/')
+									? std::string("/") + name
+									: name;
+	const int fd = ::shm_open(shmName.c_str(), O_RDWR, 0600);
+	if (fd < 0) return false;
+	struct stat st;
+	void* p = MAP_FAILED;
+	if (::fstat(fd, &st) == 0 &&
+		static_cast<std::size_t>(st.st_size) >= sizeof(TShmHeader))
+		p = ::mmap(
+			nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) return false;
+
+	m_impl.reset(new Impl);
+	m_impl->name = shmName;
+	m_impl->mem = static_cast<uint8_t*>(p);
+	m_impl->memSize = st.st_size;
+	// Not initialized yet, or incompatible:
+	TShmHeader* h = m_impl->header();
+	if (h->magic.load(std::memory_order_acquire) != SHM_MAGIC ||
+		h->version != SHM_VERSION)
+	{
+		close();
+		return false;
+	}
+	return true;
+#endif
+}
+
+void CSharedMemoryChannel::close()
+{
+	if (!m_impl) return;
+#ifndef _WIN32
+	if (m_impl->mem) ::munmap(m_impl->mem, m_impl->memSize);
+	if (m_impl->owner) ::shm_unlink(m_impl->name.c_str());
+#endif
+	m_impl.reset();
+}
+
+bool CSharedMemoryChannel::isOpen() const { return m_impl != nullptr; }
+std::size_t CSharedMemoryChannel::slotSize() const
+{
+#ifndef _WIN32
+	if (m_impl) return m_impl->header()->slotSize;
+#endif
+	return 0;
+}
+
+std::size_t CSharedMemoryChannel::pendingMessages() const
+{
+#ifndef _WIN32
+	if (!m_impl) return 0;
+	TShmHeader* h = m_impl->header();
+	CShmLock lock(&h->mtx);
+	return static_cast<std::size_t>(h->written - h->read);
+#else
+	return 0;
+#endif
+}
+
+void* CSharedMemoryChannel::beginWrite(int timeout_ms)
+{
+	MRPT_START
+	ASSERTMSG_(m_impl, "Channel is not open");
+#ifdef _WIN32
+	MRPT_UNUSED_PARAM(timeout_ms);
+	return nullptr;
+#else
+	TShmHeader* h = m_impl->header();
+	{
+		CShmLock lock(&h->mtx);
+		if (!lock.wait(&h->cvSlots, timeout_ms, [h] {
+				return h->written - h->read < h->slotCount;
+			}))
+			return nullptr;
+	}
+	// Only this writer changes h->written:
+	m_impl->writing = true;
+	return m_impl->slot(h->written) + SLOT_DATA_OFFSET;
+#endif
+	MRPT_END
+}
+
+void CSharedMemoryChannel::commitWrite(std::size_t length)
+{
+	MRPT_START
+	ASSERTMSG_(m_impl && m_impl->writing, "commitWrite() without beginWrite()");
+#ifndef _WIN32
+	TShmHeader* h = m_impl->header();
+	ASSERT_BELOWEQ_(length, h->slotSize);
+	uint8_t* slot = m_impl->slot(h->written);
+	const uint64_t len = length;
+	::memcpy(slot, &len, sizeof(len));
+	m_impl->writing = false;
+	{
+		CShmLock lock(&h->mtx);
+		h->written++;
+	}
+	::pthread_cond_signal(&h->cvMessages);
+#endif
+	MRPT_END
+}
+
+const void* CSharedMemoryChannel::beginRead(std::size_t& length, int timeout_ms)
+{
+	MRPT_START
+	ASSERTMSG_(m_impl, "Channel is not open");
+	length = 0;
+#ifdef _WIN32
+	MRPT_UNUSED_PARAM(timeout_ms);
+	return nullptr;
+#else
+	TShmHeader* h = m_impl->header();
+	{
+		CShmLock lock(&h->mtx);
+		if (!lock.wait(&h->cvMessages, timeout_ms, [h] {
+				return h->written != h->read;
+			}))
+			return nullptr;
+	}
+	// Only this reader changes h->read:
+	const uint8_t* slot = m_impl->slot(h->read);
+	uint64_t len;
+	::memcpy(&len, slot, sizeof(len));
+	length = static_cast<std::size_t>(len);
+	m_impl->reading = true;
+	return slot + SLOT_DATA_OFFSET;
+#endif
+	MRPT_END
+}
+
+void CSharedMemoryChannel::endRead()
+{
+	MRPT_START
+	ASSERTMSG_(m_impl && m_impl->reading, "endRead() without beginRead()");
+#ifndef _WIN32
+	TShmHeader* h = m_impl->header();
+	m_impl->reading = false;
+	{
+		CShmLock lock(&h->mtx);
+		h->read++;
+	}
+	::pthread_cond_signal(&h->cvSlots);
+#endif
+	MRPT_END
+}
+
+bool CSharedMemoryChannel::sendObject(
+	const CSerializable& obj, int timeout_ms)
+{
+	MRPT_START
+	void* data = beginWrite(timeout_ms);
+	if (!data) return false;
+	CSlotOutputStream out(data, slotSize());
+	try
+	{
+		auto arch = mrpt::serialization::archiveFrom(out);
+		arch << obj;
+	}
+	catch (...)
+	{
+		m_impl->writing = false;
+		throw;
+	}
+	commitWrite(out.getPosition());
+	return true;
+	MRPT_END
+}
+
+CSerializable::Ptr CSharedMemoryChannel::receiveObject(
+	int timeout_ms, mrpt::serialization::CSerializablePool* pool)
+{
+	MRPT_START
+	std::size_t length;
+	const void* data = beginRead(length, timeout_ms);
+	if (!data) return nullptr;
+	mrpt::io::CMemoryStream in;
+	in.assignMemoryNotOwn(data, length);
+	CSerializable::Ptr obj;
+	try
+	{
+		auto arch = mrpt::serialization::archiveFrom(in);
+		obj = pool ? arch.ReadObject(*pool) : arch.ReadObject();
+	}
+	catch (...)
+	{
+		endRead();
+		throw;
+	}
+	endRead();
+	return obj;
+	MRPT_END
+}
+
+bool CSharedMemoryChannel::receiveObject(CSerializable& obj, int timeout_ms)
+{
+	MRPT_START
+	std::size_t length;
+	const void* data = beginRead(length, timeout_ms);
+	if (!data) return false;
+	mrpt::io::CMemoryStream in;
+	in.assignMemoryNotOwn(data, length);
+	try
+	{
+		auto arch = mrpt::serialization::archiveFrom(in);
+		arch >> obj;
+	}
+	catch (...)
+	{
+		endRead();
+		throw;
+	}
+	endRead();
+	return true;
+	MRPT_END
+}
@@ -0,0 +1,153 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/comms/CSharedMemoryChannel.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/math/CMatrix.h>
+#include <gtest/gtest.h>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace mrpt::comms;
+
+namespace
+{
+std::string testChannelName(const char* test)
+{
+	return std::string("/mrpt_test_") + test + "_" +
+		   std::to_string(::getpid());
+}
+}  // namespace
+
+TEST(CSharedMemoryChannel, RawMessages)
+{
+	const std::string name = testChannelName("raw");
+	CSharedMemoryChannel::TOptions opts;
+	opts.slotCount = 2;
+	opts.slotSize = 1 << 20;
+	CSharedMemoryChannel tx, rx;
+	ASSERT_TRUE(tx.create(name, opts));
+	// Only one creator:
+	CSharedMemoryChannel other;
+	EXPECT_FALSE(other.create(name));
+	ASSERT_TRUE(rx.open(name));
+	EXPECT_EQ(rx.slotSize(), opts.slotSize);
+
+	// Timeouts on empty or full channels:
+	size_t len;
+	EXPECT_TRUE(rx.beginRead(len, 10) == nullptr);
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		auto p = static_cast<uint8_t*>(tx.beginWrite(0));
+		ASSERT_TRUE(p != nullptr);
+		std::memset(p, i + 1, opts.slotSize);
+		tx.commitWrite(opts.slotSize - i);
+	}
+	EXPECT_EQ(rx.pendingMessages(), 2u);
+	EXPECT_TRUE(tx.beginWrite(10) == nullptr);
+
+	// Messages are read in order, in place:
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		auto p = static_cast<const uint8_t*>(rx.beginRead(len, 0));
+		ASSERT_TRUE(p != nullptr);
+		EXPECT_EQ(len, opts.slotSize - i);
+		EXPECT_EQ(p[0], i + 1);
+		EXPECT_EQ(p[len - 1], i + 1);
+		rx.endRead();
+	}
+	EXPECT_EQ(rx.pendingMessages(), 0u);
+
+	// The channel is removed with its creator:
+	tx.close();
+	EXPECT_FALSE(other.open(name));
+}
+
+TEST(CSharedMemoryChannel, ObjectsBetweenThreads)
+{
+	const std::string name = testChannelName("threads");
+	CSharedMemoryChannel::TOptions opts;
+	opts.slotCount = 3;
+	opts.slotSize = 1 << 16;
+	CSharedMemoryChannel tx, rx;
+	ASSERT_TRUE(tx.create(name, opts));
+	ASSERT_TRUE(rx.open(name));
+
+	const size_t N = 200;
+	std::thread writer([&] {
+		for (size_t i = 0; i < N; i++)
+			tx.sendObject(mrpt::poses::CPose3D(i, 0, 0, 0, 0, 0));
+	});
+	for (size_t i = 0; i < N; i++)
+	{
+		if (i % 2)
+		{
+			auto p = std::dynamic_pointer_cast<mrpt::poses::CPose3D>(
+				rx.receiveObject(2000));
+			ASSERT_TRUE(p);
+			EXPECT_EQ(p->x(), double(i));
+		}
+		else
+		{
+			mrpt::poses::CPose3D p;
+			ASSERT_TRUE(rx.receiveObject(p, 2000));
+			EXPECT_EQ(p.x(), double(i));
+		}
+	}
+	writer.join();
+	EXPECT_TRUE(rx.receiveObject(0) == nullptr);
+
+	// Objects larger than a slot are not sent:
+	mrpt::math::CMatrix M(200, 200);
+	EXPECT_ANY_THROW(tx.sendObject(M));
+	EXPECT_EQ(rx.pendingMessages(), 0u);
+	M.setSize(10, 10);
+	M(3, 4) = 5.0f;
+	EXPECT_TRUE(tx.sendObject(M));
+	auto M2 = std::dynamic_pointer_cast<mrpt::math::CMatrix>(
+		rx.receiveObject(0));
+	ASSERT_TRUE(M2);
+	EXPECT_EQ((*M2)(3, 4), 5.0f);
+}
+
+TEST(CSharedMemoryChannel, ObjectsBetweenProcesses)
+{
+	const std::string name = testChannelName("procs");
+	CSharedMemoryChannel rx;
+	ASSERT_TRUE(rx.create(name));
+
+	const size_t N = 50;
+	const pid_t pid = ::fork();
+	ASSERT_GE(pid, 0);
+	if (pid == 0)
+	{
+		// Child process: the writer.
+		CSharedMemoryChannel tx;
+		bool ok = tx.open(name);
+		for (size_t i = 0; ok && i < N; i++)
+			ok = tx.sendObject(mrpt::poses::CPose3D(0, i, 0, 0, 0, 0), 5000);
+		tx.close();
+		::_exit(ok ? 0 : 1);
+	}
+	for (size_t i = 0; i < N; i++)
+	{
+		auto p = std::dynamic_pointer_cast<mrpt::poses::CPose3D>(
+			rx.receiveObject(5000));
+		ASSERT_TRUE(p);
+		EXPECT_EQ(p->y(), double(i));
+	}
+	int status = -1;
+	::waitpid(pid, &status, 0);
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+#endif
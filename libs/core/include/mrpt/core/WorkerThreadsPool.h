@@ -0,0 +1,146 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mrpt
+{
+/** A simple thread pool: a fixed number of worker threads consume tasks from
+ * a FIFO queue.
+ *
+ * Tasks are enqueued with enqueue(), which returns a `std::future<>` to wait
+ * for the task and get its result (or rethrow its exception).
+ * For data-parallel loops, see parallelForBlocks().
+ *
+ * A pool with zero threads (the default-constructed state) is valid: in that
+ * case enqueue() runs the task and parallelForBlocks() runs all blocks in the
+ * calling thread.
+ *
+ * \note Tasks must not wait on the results of other tasks enqueued in the
+ * same pool, or the pool may deadlock if all workers are busy waiting.
+ * \ingroup mrpt_core_grp
+ */
+class WorkerThreadsPool
+{
+   public:
+	/** Creates an empty pool with no threads. See resize() */
+	WorkerThreadsPool() = default;
+	/** Creates a pool with the given number of threads. 0 means as many
+	 * threads as hardware cores. */
+	explicit WorkerThreadsPool(std::size_t num_threads) { resize(num_threads); }
+	~WorkerThreadsPool() { clear(); }
+
+	WorkerThreadsPool(const WorkerThreadsPool&) = delete;
+	WorkerThreadsPool& operator=(const WorkerThreadsPool&) = delete;
+
+	/** Stops all threads (waiting for running tasks to finish) and launches
+	 * `num_threads` new ones. 0 means as many threads as hardware cores.
+	 * Pending tasks in the queue are kept. */
+	void resize(std::size_t num_threads);
+
+	/** Stops all worker threads. Tasks still in the queue are discarded and
+	 * their futures will report a `std::future_error` (broken promise). */
+	void clear();
+
+	/** Number of worker threads */
+	std::size_t size() const { return m_threads.size(); }
+
+	/** Number of enqueued tasks not started yet */
+	std::size_t pendingTasks() const;
+
+	/** Enqueues a task for execution in the first available worker.
+	 * If the pool has no threads, the task runs in the calling thread before
+	 * returning.
+	 * \return A future to wait for the task result. */
+	template <class F, class... Args>
+	auto enqueue(F&& f, Args&&... args)
+		-> std::future<std::invoke_result_t<F, Args...>>
+	{
+		using return_type = std::invoke_result_t<F, Args...>;
+
+		auto task = std::make_shared<std::packaged_task<return_type()>>(
+			std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+
+		std::future<return_type> res = task->get_future();
+		if (m_threads.empty())
+		{
+			// Exceptions are captured by the packaged_task:
+			(*task)();
+			return res;
+		}
+		{
+			std::unique_lock<std::mutex> lock(m_queue_mutex);
+			m_tasks.emplace([task]() { (*task)(); });
+		}
+		m_condition.notify_one();
+		return res;
+	}
+
+	/** Runs `f(first, last)` for consecutive, non-overlapping index ranges
+	 * `[first,last)` of at most `blockSize` elements covering `[0,N)`, then
+	 * waits for all of them to finish.
+	 *
+	 * The partition only depends on `N` and `blockSize`, not on the number of
+	 * threads, so algorithms keeping per-block state (e.g. a random generator
+	 * seeded from the block index) give identical results for any pool size.
+	 * Blocks run in the calling thread if the pool has no threads or there is
+	 * only one block. The first exception thrown by any block (in block
+	 * order) is rethrown here once all blocks have finished.
+	 */
+	template <class F>
+	void parallelForBlocks(std::size_t N, std::size_t blockSize, F&& f)
+	{
+		if (!N) return;
+		if (!blockSize) blockSize = 1;
+		const std::size_t nBlocks = (N + blockSize - 1) / blockSize;
+
+		if (m_threads.empty() || nBlocks == 1)
+		{
+			for (std::size_t b = 0; b < nBlocks; b++)
+				f(b * blockSize, std::min(N, (b + 1) * blockSize));
+			return;
+		}
+
+		std::vector<std::future<void>> done;
+		done.reserve(nBlocks);
+		for (std::size_t b = 0; b < nBlocks; b++)
+		{
+			const std::size_t first = b * blockSize,
+							  last = std::min(N, (b + 1) * blockSize);
+			done.emplace_back(enqueue([&f, first, last]() { f(first, last); }));
+		}
+		// Wait for all before (re)throwing, since blocks reference `f`:
+		for (auto& d : done) d.wait();
+		for (auto& d : done) d.get();
+	}
+
+   private:
+	/** Stops and joins all worker threads, keeping the queue */
+	void stopThreads();
+
+	std::vector<std::thread> m_threads;
+	std::atomic_bool m_do_stop{false};
+	mutable std::mutex m_queue_mutex;
+	std::condition_variable m_condition;
+	std::queue<std::function<void()>> m_tasks;
+};
+
+}  // namespace mrpt
@@ -0,0 +1,72 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "core-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/WorkerThreadsPool.h>
+
+using namespace mrpt;
+
+void WorkerThreadsPool::resize(std::size_t num_threads)
+{
+	stopThreads();
+
+	if (!num_threads) num_threads = std::thread::hardware_concurrency();
+	if (!num_threads) num_threads = 1;
+
+	m_do_stop = false;
+	for (std::size_t i = 0; i < num_threads; ++i)
+		m_threads.emplace_back([this] {
+			for (;;)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(m_queue_mutex);
+					m_condition.wait(
+						lock, [this] { return m_do_stop || !m_tasks.empty(); });
+					if (m_do_stop) return;
+					task = std::move(m_tasks.front());
+					m_tasks.pop();
+				}
+				// Exceptions are captured by the packaged_task:
+				task();
+			}
+		});
+}
+
+void WorkerThreadsPool::clear()
+{
+	stopThreads();
+
+	// Destroy the discarded tasks out of the lock: their promises are broken.
+	std::queue<std::function<void()>> discarded;
+	{
+		std::unique_lock<std::mutex> lock(m_queue_mutex);
+		discarded.swap(m_tasks);
+	}
+}
+
+void WorkerThreadsPool::stopThreads()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_queue_mutex);
+		m_do_stop = true;
+	}
+	m_condition.notify_all();
+
+	for (auto& t : m_threads)
+		if (t.joinable()) t.join();
+	m_threads.clear();
+}
+
+std::size_t WorkerThreadsPool::pendingTasks() const
+{
+	std::unique_lock<std::mutex> lock(m_queue_mutex);
+	return m_tasks.size();
+}
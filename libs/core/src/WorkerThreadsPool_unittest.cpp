@@ -0,0 +1,111 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(WorkerThreadsPool, enqueue)
+{
+	mrpt::WorkerThreadsPool pool(3);
+	EXPECT_EQ(pool.size(), 3U);
+
+	std::vector<std::future<int>> res;
+	for (int i = 0; i < 20; i++)
+		res.emplace_back(pool.enqueue([](int x) { return x * x; }, i));
+	for (int i = 0; i < 20; i++) EXPECT_EQ(res[i].get(), i * i);
+}
+
+TEST(WorkerThreadsPool, parallelForBlocks)
+{
+	for (std::size_t nThreads : {0, 1, 4})
+	{
+		mrpt::WorkerThreadsPool pool;
+		if (nThreads) pool.resize(nThreads);
+
+		const std::size_t N = 1001;
+		std::vector<int> hits(N, 0);
+		std::atomic<std::size_t> nBlocks{0};
+		pool.parallelForBlocks(N, 100, [&](std::size_t first, std::size_t last) {
+			EXPECT_LE(last - first, 100U);
+			for (std::size_t i = first; i < last; i++) hits[i]++;
+			nBlocks++;
+		});
+		EXPECT_EQ(nBlocks, 11U);
+		for (std::size_t i = 0; i < N; i++) EXPECT_EQ(hits[i], 1);
+	}
+}
+
+TEST(WorkerThreadsPool, exceptionsArePropagated)
+{
+	mrpt::WorkerThreadsPool pool(2);
+	EXPECT_THROW(
+		pool.parallelForBlocks(
+			10, 1,
+			[](std::size_t first, std::size_t) {
+				if (first == 7) throw std::runtime_error("block 7");
+			}),
+		std::runtime_error);
+
+	auto f = pool.enqueue([]() -> int { throw std::runtime_error("x"); });
+	EXPECT_THROW(f.get(), std::runtime_error);
+}
+
+TEST(WorkerThreadsPool, enqueueWithoutThreads)
+{
+	mrpt::WorkerThreadsPool pool;
+	EXPECT_EQ(pool.size(), 0U);
+
+	auto f = pool.enqueue([](int x) { return x + 1; }, 41);
+	ASSERT_EQ(f.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	EXPECT_EQ(f.get(), 42);
+	EXPECT_EQ(pool.pendingTasks(), 0U);
+
+	auto g = pool.enqueue([]() -> int { throw std::runtime_error("x"); });
+	EXPECT_THROW(g.get(), std::runtime_error);
+}
+
+TEST(WorkerThreadsPool, clearDiscardsPendingTasks)
+{
+	mrpt::WorkerThreadsPool pool(1);
+
+	// Keep the only worker busy until clear() has been called:
+	std::promise<void> started, go;
+	std::shared_future<void> goFut = go.get_future().share();
+	auto busy = pool.enqueue([&started, goFut]() {
+		started.set_value();
+		goFut.wait();
+	});
+	started.get_future().wait();
+
+	std::vector<std::future<int>> queued;
+	for (int i = 0; i < 5; i++)
+		queued.emplace_back(pool.enqueue([i]() { return i; }));
+
+	std::thread releaser([&go]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		go.set_value();
+	});
+	pool.clear();
+	releaser.join();
+
+	EXPECT_EQ(pool.size(), 0U);
+	EXPECT_EQ(pool.pendingTasks(), 0U);
+	EXPECT_NO_THROW(busy.get());
+	for (auto& q : queued)
+	{
+		ASSERT_EQ(
+			q.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+		EXPECT_THROW(q.get(), std::future_error);
+	}
+}
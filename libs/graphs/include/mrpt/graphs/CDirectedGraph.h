@@ -14,9 +14,14 @@
 #include <mrpt/core/aligned_std_map.h>
 #include <mrpt/core/exceptions.h>
 #include <mrpt/graphs/TNodeID.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <set>
 #include <map>
 #include <fstream>
+#include <unordered_map>
+#include <vector>
 
 namespace mrpt
 {
@@ -49,6 +54,13 @@ struct edge_annotations_empty
 {
 	DECLARE_TTYPENAME_CLASSNAME(mrpt::graphs::detail::edge_annotations_empty)
 };
+
+/** Returns a new unique ID for a log of changes in the edges of a graph */
+inline uint64_t newEdgeChangeLogID()
+{
+	static std::atomic<uint64_t> last_id{0};
+	return ++last_id;
+}
 }  // namespace detail
 
 /** A directed graph with the argument of the template specifying the type of
@@ -117,7 +129,11 @@ class CDirectedGraph
 	/** The number of edges in the graph */
 	inline size_t edgeCount() const { return edges.size(); }
 	/** Erase all edges */
-	inline void clearEdges() { edges.clear(); }
+	inline void clearEdges()
+	{
+		edges.clear();
+		m_edge_log.reset();
+	}
 	/** Insert an edge (from -> to) with the given edge value. \sa
 	 * insertEdgeAtEnd */
 	inline void insertEdge(
@@ -125,7 +141,7 @@ class CDirectedGraph
 	{
 		alignas(MRPT_MAX_ALIGN_BYTES) typename edges_map_t::value_type entry(
 			std::make_pair(from_nodeID, to_nodeID), edge_value);
-		edges.insert(entry);
+		m_edge_log.logInserted(edges.insert(entry));
 	}
 
 	/** Insert an edge (from -> to) with the given edge value (more efficient
@@ -136,7 +152,7 @@ class CDirectedGraph
 	{
 		alignas(MRPT_MAX_ALIGN_BYTES) typename edges_map_t::value_type entry(
 			std::make_pair(from_nodeID, to_nodeID), edge_value);
-		edges.insert(edges.end(), entry);
+		m_edge_log.logInserted(edges.insert(edges.end(), entry));
 	}
 
 	/** Test if the given directed edge exists. */
@@ -204,7 +220,17 @@ class CDirectedGraph
 	 */
 	inline void eraseEdge(TNodeID from_nodeID, TNodeID to_nodeID)
 	{
-		edges.erase(std::make_pair(from_nodeID, to_nodeID));
+		const auto range =
+			edges.equal_range(std::make_pair(from_nodeID, to_nodeID));
+		for (iterator it = range.first; it != range.second;) eraseEdge(it++);
+	}
+
+	/** Erase the given edge */
+	inline void eraseEdge(iterator it)
+	{
+		const TErasedEdge erased{it->first, &it->second};
+		edges.erase(it);
+		m_edge_log.logErased(erased);
 	}
 
 	/** Return a list of all the node_ID's of the graph, generated from all the
@@ -314,6 +340,113 @@ class CDirectedGraph
 
 	/** @} */  // end of edge/nodes utilities
 
+	/** @name Log of changes in the edges
+	 *  Consumers which keep some state computed from the edges (e.g.
+	 * incremental optimizers) can get the edges inserted and erased since
+	 * they last looked, in time proportional to the number of changes
+	 * instead of to the number of edges.
+	 *  Only the changes made through insertEdge(), insertEdgeAtEnd() and
+	 * eraseEdge() are logged: clearEdges(), assigning the graph, or changing
+	 * the number of edges through \a edges directly make
+	 * getEdgeChangesSince() report that the changes are unknown. Edges
+	 * inserted and erased through \a edges directly in equal numbers go
+	 * unnoticed. While enabled, the log takes one entry per change.
+		@{ */
+
+	/** An edge erased from the graph, with the address it had in \a edges */
+	struct TErasedEdge
+	{
+		TPairNodeIDs nodes;
+		const edge_t* edge;
+	};
+	/** Position in the log of changes, see getEdgeChangesSince() */
+	struct TEdgeLogPosition
+	{
+		/** The log it refers to (0: none) */
+		uint64_t log_id{0};
+		/** Number of entries of the log already seen */
+		size_t index{0};
+		/** Number of edges in the graph at that point */
+		size_t num_edges{0};
+	};
+	/** Changes in the edges between two positions of the log */
+	struct TEdgeChanges
+	{
+		/** New edges still in the graph, in insertion order */
+		std::vector<const_iterator> inserted;
+		/** Edges which were in the graph before and have been erased. Edges
+		 * both inserted and erased in between are in neither list. */
+		std::vector<TErasedEdge> erased;
+	};
+
+	/** Starts (or stops) logging the changes in the edges. Changes while
+	 * disabled are unknown. */
+	void enableEdgeChangeLog(bool enable = true)
+	{
+		if (enable == m_edge_log.enabled) return;
+		m_edge_log.enabled = enable;
+		m_edge_log.reset();
+	}
+	bool isEdgeChangeLogEnabled() const { return m_edge_log.enabled; }
+	/** Gets the changes in the edges since position \a pos of the log, and
+	 * moves \a pos to the current position.
+	 * \return false if the changes are unknown (the log is disabled, \a pos
+	 * comes from another log, or the edges were changed in a way not
+	 * logged), so any edge may have changed.
+	 */
+	bool getEdgeChangesSince(
+		TEdgeLogPosition& pos, TEdgeChanges& changes) const
+	{
+		changes.inserted.clear();
+		changes.erased.clear();
+		const auto& entries = m_edge_log.entries;
+		const TEdgeLogPosition cur_pos{
+			m_edge_log.id, entries.size(), edges.size()};
+		if (!m_edge_log.enabled || pos.log_id != m_edge_log.id ||
+			pos.index > entries.size())
+		{
+			pos = cur_pos;
+			return false;
+		}
+
+		// Inserted edges not erased afterwards, by address, as their index
+		// in the log. Only one edge at a time lives at each address.
+		std::unordered_map<const edge_t*, size_t> inserted;
+		size_t num_edges = pos.num_edges;
+		for (size_t i = pos.index; i < entries.size(); i++)
+		{
+			const auto& e = entries[i];
+			if (e.inserted)
+			{
+				inserted[e.erased.edge] = i;
+				num_edges++;
+				continue;
+			}
+			num_edges--;
+			const auto it = inserted.find(e.erased.edge);
+			if (it != inserted.end())
+				inserted.erase(it);
+			else
+				changes.erased.push_back(e.erased);
+		}
+		const bool known = num_edges == edges.size();
+		pos = cur_pos;
+		if (!known)
+		{
+			changes.erased.clear();
+			return false;
+		}
+
+		std::vector<size_t> idxs;
+		idxs.reserve(inserted.size());
+		for (const auto& i : inserted) idxs.push_back(i.second);
+		std::sort(idxs.begin(), idxs.end());
+		changes.inserted.reserve(idxs.size());
+		for (const size_t i : idxs) changes.inserted.push_back(entries[i].it);
+		return true;
+	}
+	/** @} */
+
 	/** @name I/O utilities
 		@{ */
 
@@ -372,6 +505,45 @@ class CDirectedGraph
 	}
 	/** @} */
 
+   private:
+	/** Log of changes in the edges. It is not copied along with the
+	 * graph, and assigning the graph invalidates it. */
+	struct TEdgeChangeLog
+	{
+		struct TEntry
+		{
+			/** The new edge, only for insertions */
+			const_iterator it;
+			/** The edge, as its nodes and address */
+			TErasedEdge erased;
+			bool inserted;
+		};
+		bool enabled{false};
+		uint64_t id{0};
+		std::vector<TEntry> entries;
+
+		TEdgeChangeLog() = default;
+		TEdgeChangeLog(const TEdgeChangeLog&) {}
+		TEdgeChangeLog& operator=(const TEdgeChangeLog&)
+		{
+			reset();
+			return *this;
+		}
+		void reset()
+		{
+			entries.clear();
+			id = enabled ? detail::newEdgeChangeLogID() : 0;
+		}
+		void logInserted(const_iterator it)
+		{
+			if (enabled) entries.push_back({it, {it->first, &it->second}, true});
+		}
+		void logErased(const TErasedEdge& e)
+		{
+			if (enabled) entries.push_back({const_iterator(), e, false});
+		}
+	};
+	TEdgeChangeLog m_edge_log;
 };  // end class CDirectedGraph
 
 /** @} */
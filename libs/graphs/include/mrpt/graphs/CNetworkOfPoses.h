@@ -47,6 +47,8 @@ namespace detail
 {
 template <class GRAPH_T>
 struct graph_ops;
+template <class GRAPH_T>
+struct TDijkstraNodesEstimateState;
 
 // forward declaration of CVisualizer
 template <
@@ -351,6 +353,32 @@ class CNetworkOfPoses
 		detail::graph_ops<self_t>::graph_of_poses_dijkstra_init(this);
 	}
 
+	/** Spanning tree kept by dijkstra_nodes_estimate(state) between calls */
+	using dijkstra_nodes_estimate_state_t =
+		detail::TDijkstraNodesEstimateState<self_t>;
+
+	/** Like dijkstra_nodes_estimate(), but keeping the spanning tree in \a
+	 * state between calls, so that only the nodes whose path to the root is
+	 * shortened by the edges added since the previous call are updated. Meant
+	 * for graphs which grow with time, e.g. in graph-SLAM.
+	 *
+	 * The new edges are taken from the edge change log of the graph, which
+	 * this method enables, or else by looking up all edges in \a state. The
+	 * first call, or any call after changing the root or removing edges,
+	 * computes the whole tree. Otherwise, only the poses of the updated
+	 * nodes are written to \a nodes. Since the tree is updated
+	 * incrementally, nodes reachable from the root through several shortest
+	 * paths may end up with a different parent than in
+	 * dijkstra_nodes_estimate().
+	 *
+	 * \note Edges must not be modified between calls with the same \a
+	 * state, unless state.clear() is called.
+	 */
+	inline void dijkstra_nodes_estimate(dijkstra_nodes_estimate_state_t& state)
+	{
+		detail::graph_ops<self_t>::graph_of_poses_dijkstra_update(this, state);
+	}
+
 	/** Look for duplicated edges (even in opposite directions) between all
 	 * pairs of nodes and fuse them.  Upon return, only one edge remains
 	 * between each pair of nodes with the mean & covariance (or information
@@ -920,7 +948,7 @@ class CNetworkOfPoses
 	/** Empty all edges, nodes and set root to ID 0. */
 	inline void clear()
 	{
-		BASE::edges.clear();
+		BASE::clearEdges();
 		nodes.clear();
 		root = 0;
 		edges_store_inverse_poses = false;
@@ -25,6 +25,11 @@
 #include <mrpt/poses/CPose3DPDFGaussian.h>
 #include <mrpt/poses/CPose3DPDFGaussianInf.h>
 #include <mrpt/graphs/TNodeAnnotations.h>
+#include <mrpt/core/aligned_std_vector.h>
+
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace mrpt
 {
@@ -74,6 +79,62 @@ struct TPosePDFHelper<CPose3D>
 	}
 };
 
+/** Spanning tree kept between calls to
+ * CNetworkOfPoses::dijkstra_nodes_estimate(state), so that it is only updated
+ * with the edges added to the graph since the previous call, as reported by
+ * the edge change log of the graph (see CDirectedGraph::enableEdgeChangeLog).
+ *
+ * \note Removed edges are detected and trigger a full re-estimation, but
+ * changes to the value of existing edges are not: call clear() after them.
+ */
+template <class graph_t>
+struct TDijkstraNodesEstimateState
+{
+	using edge_t = typename graph_t::edge_t;
+	using pose_t = typename graph_t::constraint_no_pdf_t;
+
+	/** Edge between a node and one of its neighbors: the edge from the node
+	 * to the neighbor if it exists (reverse=false), otherwise the one in the
+	 * opposite direction, as in CDijkstra. */
+	struct TArc
+	{
+		size_t neighbor;
+		const edge_t* edge;
+		bool reverse;
+	};
+	struct TNode
+	{
+		TNodeID id;
+		/** Number of edges from the root */
+		size_t dist{std::numeric_limits<size_t>::max()};
+		/** Index of the parent in the tree */
+		size_t parent{std::numeric_limits<size_t>::max()};
+		std::vector<TArc> arcs;
+		/** Global pose estimate */
+		pose_t pose;
+	};
+
+	/** Root node of the tree */
+	TNodeID root{INVALID_NODEID};
+	/** Index in "nodes" of each node ID */
+	std::map<TNodeID, size_t> node_index;
+	mrpt::aligned_std_vector<TNode> nodes;
+	/** Edges of the graph already in the tree, with their nodes */
+	std::unordered_map<const edge_t*, TPairNodeIDs> known_edges;
+	/** Position in the edge change log of the graph of the last update */
+	typename graph_t::TEdgeLogPosition edge_log_pos;
+
+	bool empty() const { return nodes.empty(); }
+	void clear()
+	{
+		root = INVALID_NODEID;
+		node_index.clear();
+		nodes.clear();
+		known_edges.clear();
+		edge_log_pos = typename graph_t::TEdgeLogPosition();
+	}
+};
+
 /// a helper struct with static template functions \sa CNetworkOfPoses
 template <class graph_t>
 struct graph_ops
@@ -740,7 +801,7 @@ struct graph_ops
 		{
 			const size_t N = it->second.size();
 			for (size_t i = 1; i < N; i++)  // i=0 is NOT removed
-				g->edges.erase(it->second[i]);
+				g->eraseEdge(it->second[i]);
 
 			if (N >= 2) nRemoved += N - 1;
 		}
@@ -865,6 +926,243 @@ struct graph_ops
 		MRPT_END
 	}  // end of graph_of_poses_dijkstra_init
 
+	// --------------------------------------------------------------------------------
+	//               Implements: dijkstra_nodes_estimate(state)
+	//
+	//	Same as graph_of_poses_dijkstra_init(), but only updating the spanning
+	// tree in "state" with the edges not seen in previous calls. Since all
+	// edges weight the same, the distances to the root are the lengths of the
+	// paths, and only the nodes whose distance is reduced by the new edges
+	// move to a new parent.
+	// --------------------------------------------------------------------------------
+	using dijkstra_state_t = TDijkstraNodesEstimateState<graph_t>;
+
+	static void graph_of_poses_dijkstra_update(
+		graph_t* g, dijkstra_state_t& state)
+	{
+		MRPT_START;
+		using node_t = typename dijkstra_state_t::TNode;
+		using arc_t = typename dijkstra_state_t::TArc;
+		const size_t INF = std::numeric_limits<size_t>::max();
+
+		// Start over if the root changed or any known edge was removed.
+		// Removals are taken from the change log of the graph, or else found
+		// by looking up all its edges (by address and nodes, since the
+		// address of a removed edge may be reused by a new one):
+		using edge_iterator_t = typename graph_t::const_iterator;
+		if (state.root != g->root) state.clear();
+		state.root = g->root;
+		g->enableEdgeChangeLog();
+		typename graph_t::TEdgeLogPosition log_pos = state.edge_log_pos;
+		typename graph_t::TEdgeChanges changes;
+		std::vector<edge_iterator_t> new_edges;
+		if (g->getEdgeChangesSince(log_pos, changes))
+		{
+			for (const auto& e : changes.erased)
+				if (state.known_edges.count(e.edge)) state.clear();
+			new_edges.swap(changes.inserted);
+		}
+		else
+		{
+			size_t nKnownEdges = 0;
+			for (auto it = g->edges.begin(); it != g->edges.end(); ++it)
+			{
+				const auto itKnown = state.known_edges.find(&it->second);
+				if (itKnown != state.known_edges.end() &&
+					itKnown->second == it->first)
+					nKnownEdges++;
+				else
+					new_edges.push_back(it);
+			}
+			if (nKnownEdges != state.known_edges.size()) state.clear();
+		}
+		const bool was_empty = state.empty();
+		if (was_empty)
+		{
+			new_edges.clear();
+			for (auto it = g->edges.begin(); it != g->edges.end(); ++it)
+				new_edges.push_back(it);
+		}
+		state.edge_log_pos = log_pos;
+
+		auto getIndex = [&state](const TNodeID id) {
+			const auto it = state.node_index.find(id);
+			if (it != state.node_index.end()) return it->second;
+			const size_t idx = state.nodes.size();
+			state.node_index[id] = idx;
+			state.nodes.emplace_back();
+			state.nodes.back().id = id;
+			return idx;
+		};
+		// Sets the arc from node "u" to "v". Returns true if it replaced the
+		// one in the tree.
+		auto setArc = [&state](size_t u, const arc_t& arc) {
+			for (auto& a : state.nodes[u].arcs)
+			{
+				if (a.neighbor != arc.neighbor) continue;
+				// Edges from "u" to "v" take precedence over those in the
+				// opposite direction, then the oldest one:
+				if (arc.reverse || !a.reverse) return false;
+				a = arc;
+				return state.nodes[arc.neighbor].parent == u;
+			}
+			state.nodes[u].arcs.push_back(arc);
+			return false;
+		};
+
+		// Add the new edges, keeping the nodes whose edge to their parent
+		// was replaced:
+		const size_t nOldNodes = state.nodes.size();
+		std::vector<size_t> seeds, reattached;
+		for (const edge_iterator_t& e : new_edges)
+		{
+			state.known_edges[&e->second] = e->first;
+			const TNodeID from = e->first.first, to = e->first.second;
+			if (from == to) continue;  // ignore self-loops...
+			const size_t u = getIndex(from), v = getIndex(to);
+			if (setArc(u, arc_t{v, &e->second, false})) reattached.push_back(v);
+			setArc(v, arc_t{u, &e->second, true});
+			if (!was_empty)
+			{
+				seeds.push_back(u);
+				seeds.push_back(v);
+			}
+		}
+
+		const auto itRoot = state.node_index.find(g->root);
+		if (itRoot == state.node_index.end())
+		{
+			state.clear();
+			THROW_EXCEPTION_FMT(
+				"Cannot find the source node_ID=%lu in the graph",
+				static_cast<unsigned long>(g->root));
+		}
+		if (was_empty)
+		{
+			state.nodes[itRoot->second].dist = 0;
+			seeds.push_back(itRoot->second);
+		}
+
+		// Propagate the reduced distances from the ends of the new edges,
+		// in the order of distance and ID (the one in CDijkstra), marking
+		// the nodes whose parent changed:
+		using heap_entry_t = std::pair<size_t, TNodeID>;
+		std::priority_queue<
+			heap_entry_t, std::vector<heap_entry_t>,
+			std::greater<heap_entry_t>>
+			heap;
+		for (const size_t i : seeds)
+			if (state.nodes[i].dist != INF)
+				heap.emplace(state.nodes[i].dist, state.nodes[i].id);
+		std::vector<size_t> updated;
+		while (!heap.empty())
+		{
+			const size_t d = heap.top().first;
+			const size_t u = state.node_index[heap.top().second];
+			heap.pop();
+			if (d != state.nodes[u].dist) continue;  // Outdated entry
+
+			for (const arc_t& a : state.nodes[u].arcs)
+			{
+				node_t& nei = state.nodes[a.neighbor];
+				if (d + 1 >= nei.dist) continue;
+				if (!was_empty) updated.push_back(a.neighbor);
+				nei.dist = d + 1;
+				nei.parent = u;
+				heap.emplace(nei.dist, nei.id);
+			}
+		}
+
+		// Nodes already in the tree can only get closer to the root, so only
+		// the new ones may be unconnected:
+		const bool all_connected = std::all_of(
+			state.nodes.begin() + nOldNodes, state.nodes.end(),
+			[INF](const node_t& n) { return n.dist != INF; });
+		if (!all_connected)
+		{
+			std::set<TNodeID> nodeIDs_unconnected;
+			for (const auto& n : g->nodes)
+			{
+				const auto it = state.node_index.find(n.first);
+				if (it == state.node_index.end() ||
+					state.nodes[it->second].dist == INF)
+					nodeIDs_unconnected.insert(n.first);
+			}
+			state.clear();
+			throw mrpt::graphs::detail::NotConnectedGraph(
+				nodeIDs_unconnected, "Graph is not fully connected!");
+		}
+
+		// Descendants of the nodes whose distance decreased were also
+		// reached above, but not those of the nodes attached to their
+		// parent through a new edge:
+		for (size_t k = 0; k < reattached.size(); k++)
+		{
+			const size_t u = reattached[k];
+			updated.push_back(u);
+			for (const arc_t& a : state.nodes[u].arcs)
+				if (state.nodes[a.neighbor].parent == u)
+					reattached.push_back(a.neighbor);
+		}
+
+		// Compute the poses, parents first:
+		if (was_empty)
+		{
+			updated.resize(state.nodes.size());
+			for (size_t i = 0; i < updated.size(); i++) updated[i] = i;
+		}
+		std::sort(
+			updated.begin(), updated.end(), [&state](size_t a, size_t b) {
+				return std::make_pair(state.nodes[a].dist, a) <
+					   std::make_pair(state.nodes[b].dist, b);
+			});
+		updated.erase(
+			std::unique(updated.begin(), updated.end()), updated.end());
+		for (const size_t i : updated)
+		{
+			node_t& n = state.nodes[i];
+			if (n.dist == 0)
+			{
+				n.pose = typename dijkstra_state_t::pose_t();
+				continue;
+			}
+			const node_t& parent = state.nodes[n.parent];
+			for (const arc_t& a : parent.arcs)
+			{
+				if (a.neighbor != i) continue;
+				// Compute the pose of the child as parent_pose (+)
+				// edge_delta_pose, taking into account that that edge may be
+				// in reverse order and then have to invert the delta_pose:
+				if (a.reverse == g->edges_store_inverse_poses)
+					n.pose.composeFrom(parent.pose, a.edge->getPoseMean());
+				else
+					n.pose.composeFrom(parent.pose, -a.edge->getPoseMean());
+				break;
+			}
+		}
+
+		// Save the new estimates, keeping the annotations of the nodes.
+		// Those nodes not in the tree are removed:
+		using constraint_no_pdf_t = typename graph_t::constraint_no_pdf_t;
+		for (const size_t i : updated)
+			static_cast<constraint_no_pdf_t&>(g->nodes[state.nodes[i].id]) =
+				state.nodes[i].pose;
+		if (g->nodes.size() != state.nodes.size())
+		{
+			typename graph_t::global_poses_t old_nodes;
+			std::swap(old_nodes, g->nodes);
+			for (const node_t& n : state.nodes)
+			{
+				auto& node = g->nodes[n.id];
+				const auto itOld = old_nodes.find(n.id);
+				if (itOld != old_nodes.end()) node = itOld->second;
+				static_cast<constraint_no_pdf_t&>(node) = n.pose;
+			}
+		}
+
+		MRPT_END
+	}  // end of graph_of_poses_dijkstra_update
+
 	// Auxiliary funcs:
 	template <class VEC>
 	static inline double auxMaha2Dist(VEC& err, const CPosePDFGaussianInf& p)
@@ -9,13 +9,18 @@
 #ifndef MRPT_DIJKSTRA_H
 #define MRPT_DIJKSTRA_H
 
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/graphs/CDirectedGraph.h>
 #include <mrpt/graphs/CDirectedTree.h>
 #include <mrpt/containers/traits_map.h>
 #include <mrpt/math/utils.h>
 
+#include <algorithm>
 #include <limits>
 #include <iostream>  // TODO - remove me
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <vector>
 #include <utility>
 #include <exception>
@@ -82,13 +87,19 @@ class NotConnectedGraph : public std::exception
  *  although the type mrpt::graphs::TNodeID is also provided for clarity in
  *  the code.
  *
- *  The second template argument MAPS_IMPLEMENTATION allows choosing
- *  between a sparse std::map<> representation (using *
- *  mrpt::containers::map_traits_stdmap) for several intermediary and final
- *  results, and an alternative (using
- *  mrpt::containers::map_traits_map_as_vector as argument) dense
- *  implementation which is much faster, but can be only used if the
- *  TNodeID's start in 0 or a low value.
+ *  The search runs on a compact snapshot of the graph adjacency (see
+ *  TAdjacencySnapshot), with node IDs mapped to consecutive indices and the
+ *  neighbors of each node stored contiguously, using a binary heap to pick
+ *  the next node, so it takes O(E log V) time. Ties between nodes at the
+ *  same distance are resolved in favor of the lowest node ID. The same
+ *  snapshot may be shared by searches from several source nodes, see
+ *  fromSources().
+ *
+ *  The second template argument MAPS_IMPLEMENTATION only determines the
+ *  type of the adjacency returned by getCachedAdjacencyMatrix(): a sparse
+ *  std::map<> (mrpt::containers::map_traits_stdmap) or a dense vector
+ *  (mrpt::containers::map_traits_map_as_vector), which can be only used if
+ *  the TNodeID's start in 0 or a low value.
  *
  * See <a
  * href="http://www.mrpt.org/Example:Dijkstra_optimal_path_search_in_graphs"
@@ -101,53 +112,6 @@ template <
 	class MAPS_IMPLEMENTATION = mrpt::containers::map_traits_stdmap>
 class CDijkstra
 {
-   protected:
-	/** Auxiliary struct for topological distances from root node */
-	struct TDistance
-	{
-		double dist;
-		inline TDistance() : dist(std::numeric_limits<double>::max()) {}
-		inline TDistance(const double D) : dist(D) {}
-		inline const TDistance& operator=(const double D)
-		{
-			dist = D;
-			return *this;
-		}
-	};
-
-	/** Auxiliary struct for backward paths */
-	struct TPrevious
-	{
-		inline TPrevious() : id(INVALID_NODEID) {}
-		TNodeID id;
-	};
-
-	// Cached input data:
-	const TYPE_GRAPH& m_cached_graph;
-	const TNodeID m_source_node_ID;
-
-	// Private typedefs:
-	/** A std::map (or a similar container according to MAPS_IMPLEMENTATION)
-	 * with all the neighbors of every node. */
-	using list_all_neighbors_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, std::set<TNodeID>>;
-	using id2pairIDs_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TPairNodeIDs>;
-	using id2dist_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TDistance>;
-	using id2id_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TPrevious>;
-
-	// Intermediary and final results:
-	/** All the distances */
-	id2dist_map_t m_distances;
-	std::map<TNodeID, TDistance>
-		m_distances_non_visited;  // Use a std::map here in all cases.
-	id2id_map_t m_prev_node;
-	id2pairIDs_map_t m_prev_arc;
-	std::set<TNodeID> m_lstNode_IDs;
-	list_all_neighbors_t m_allNeighbors;
-
    public:
 	/** @name Useful typedefs
 		@{ */
@@ -167,8 +131,126 @@ class CDijkstra
 	using functor_on_progress_t =
 		std::function<void(const graph_t& graph, size_t visitedCount)>;
 
+	/** A std::map (or a similar container according to MAPS_IMPLEMENTATION)
+	 * with all the neighbors of every node. */
+	using list_all_neighbors_t =
+		typename MAPS_IMPLEMENTATION::template map<TNodeID, std::set<TNodeID>>;
+
 	/** @} */
 
+	/** Invalid node index in TAdjacencySnapshot */
+	static constexpr size_t INVALID_INDEX = static_cast<size_t>(-1);
+
+	/** Compact (CSR) snapshot of the adjacency of a graph, regardless of the
+	 * direction of its edges, with the weight of each edge.
+	 *
+	 * Nodes are identified by their index in \a node_IDs. The neighbors of
+	 * the i'th node are the entries [offsets[i], offsets[i+1]) of \a
+	 * neighbors, \a edges and \a weights. Self-loops are left out.
+	 *
+	 * \note It keeps iterators to the edges of the graph, so the latter must
+	 * not be modified while the snapshot is in use.
+	 */
+	struct TAdjacencySnapshot
+	{
+		/** Sorted IDs of all the nodes in the edges of the graph */
+		std::vector<TNodeID> node_IDs;
+		std::vector<size_t> offsets;
+		/** Index of each neighbor in node_IDs */
+		std::vector<uint32_t> neighbors;
+		/** Edge linking the node with each neighbor: the one from the node to
+		 * the neighbor if it exists, otherwise the one in the opposite
+		 * direction. The first one in the graph if there are several. */
+		std::vector<typename graph_t::const_iterator> edges;
+		/** Weight of the edge to each neighbor */
+		std::vector<double> weights;
+
+		/** Index of the given node, or INVALID_INDEX if not found */
+		size_t indexOf(const TNodeID id) const
+		{
+			const auto it =
+				std::lower_bound(node_IDs.begin(), node_IDs.end(), id);
+			if (it == node_IDs.end() || *it != id) return INVALID_INDEX;
+			return it - node_IDs.begin();
+		}
+	};
+	using adjacency_ptr_t = std::shared_ptr<const TAdjacencySnapshot>;
+
+	/** Builds the adjacency snapshot of a graph. If a function \a
+	 * functor_edge_weight is provided, it will be used to compute the weight
+	 * of edges. Otherwise, all edges weight the unity.
+	 */
+	static adjacency_ptr_t buildAdjacencySnapshot(
+		const graph_t& graph,
+		functor_edge_weight_t functor_edge_weight = functor_edge_weight_t())
+	{
+		auto adj = std::make_shared<TAdjacencySnapshot>();
+
+		for (const auto& e : graph.edges)
+		{
+			adj->node_IDs.push_back(e.first.first);
+			adj->node_IDs.push_back(e.first.second);
+		}
+		std::sort(adj->node_IDs.begin(), adj->node_IDs.end());
+		adj->node_IDs.erase(
+			std::unique(adj->node_IDs.begin(), adj->node_IDs.end()),
+			adj->node_IDs.end());
+		const size_t nNodes = adj->node_IDs.size();
+		ASSERT_(nNodes < std::numeric_limits<uint32_t>::max());
+
+		// Both directions of each edge, sorted by node and neighbor. For each
+		// pair, the edge in the node->neighbor direction goes first, then
+		// in the graph order, which is the one std::multimap::find() returns:
+		struct TEntry
+		{
+			uint32_t node, neighbor;
+			bool reverse;
+			typename graph_t::const_iterator edge;
+		};
+		std::vector<TEntry> entries;
+		entries.reserve(2 * graph.edges.size());
+		for (auto it = graph.edges.begin(); it != graph.edges.end(); ++it)
+		{
+			if (it->first.first == it->first.second) continue;
+			const auto from =
+				static_cast<uint32_t>(adj->indexOf(it->first.first));
+			const auto to =
+				static_cast<uint32_t>(adj->indexOf(it->first.second));
+			entries.push_back({from, to, false, it});
+			entries.push_back({to, from, true, it});
+		}
+		std::stable_sort(
+			entries.begin(), entries.end(),
+			[](const TEntry& a, const TEntry& b) {
+				if (a.node != b.node) return a.node < b.node;
+				if (a.neighbor != b.neighbor) return a.neighbor < b.neighbor;
+				return !a.reverse && b.reverse;
+			});
+
+		adj->offsets.assign(nNodes + 1, 0);
+		for (size_t k = 0; k < entries.size(); k++)
+		{
+			const TEntry& e = entries[k];
+			if (k > 0 && e.node == entries[k - 1].node &&
+				e.neighbor == entries[k - 1].neighbor)
+				continue;  // Not the first edge between these nodes
+
+			adj->neighbors.push_back(e.neighbor);
+			adj->edges.push_back(e.edge);
+			adj->weights.push_back(
+				functor_edge_weight
+					? functor_edge_weight(
+						  graph, e.edge->first.first, e.edge->first.second,
+						  e.edge->second)
+					: 1.);
+			adj->offsets[e.node + 1]++;
+		}
+		for (size_t i = 0; i < nNodes; i++)
+			adj->offsets[i + 1] += adj->offsets[i];
+
+		return adj;
+	}
+
 	/** Constructor which takes the input graph and executes the entire
 	 * Dijkstra algorithm from the given root node ID.
 	 *
@@ -190,194 +272,127 @@ class CDijkstra
 		const graph_t& graph, const TNodeID source_node_ID,
 		functor_edge_weight_t functor_edge_weight = functor_edge_weight_t(),
 		functor_on_progress_t functor_on_progress = functor_on_progress_t())
-		: m_cached_graph(graph), m_source_node_ID(source_node_ID)
+		: CDijkstra(
+			  graph, buildAdjacencySnapshot(graph, functor_edge_weight),
+			  source_node_ID, functor_on_progress)
 	{
-		/*
-		1  function Dijkstra(G, w, s)
-		2     for each vertex v in V[G]                        //
-		Initializations
-		3           m_distances[v] := infinity
-		4           m_prev_node[v] := undefined
-		5     m_distances[s] := 0
-		6     S := empty set
-		7     Q := V[G]
-		8     while Q is not an empty set                      // The algorithm
-		itself
-		9           u := Extract_Min(Q)
-		10           S := S union {u}
-		11           for each edge (u,v) outgoing from u
-		12                  if m_distances[u] + w(u,v) < m_distances[v]
-		// Relax (u,v)
-		13                        m_distances[v] := m_distances[u] + w(u,v)
-		14                        m_prev_node[v] := u
-		*/
-
-		// Make a list of all the nodes in the graph:
-		graph.getAllNodes(m_lstNode_IDs);
-		const size_t nNodes = m_lstNode_IDs.size();
-
-		if (m_lstNode_IDs.find(source_node_ID) == m_lstNode_IDs.end())
+	}
+
+	/** Constructor which executes the entire Dijkstra algorithm from the
+	 * given root node ID, on an adjacency snapshot previously built from
+	 * the graph with buildAdjacencySnapshot().
+	 *
+	 * \exception std::exception If the source nodeID is not found in the
+	 * graph
+	 */
+	CDijkstra(
+		const graph_t& graph, adjacency_ptr_t adjacency,
+		const TNodeID source_node_ID,
+		functor_on_progress_t functor_on_progress = functor_on_progress_t())
+		: m_cached_graph(graph),
+		  m_source_node_ID(source_node_ID),
+		  m_adjacency(std::move(adjacency))
+	{
+		const TAdjacencySnapshot& adj = *m_adjacency;
+		const size_t nNodes = adj.node_IDs.size();
+		m_lstNode_IDs.insert(adj.node_IDs.begin(), adj.node_IDs.end());
+
+		const size_t source = adj.indexOf(source_node_ID);
+		if (source == INVALID_INDEX)
 		{
 			THROW_EXCEPTION_FMT(
 				"Cannot find the source node_ID=%lu in the graph",
 				static_cast<unsigned long>(source_node_ID));
 		}
 
-		// Init:
-		// m_distances: already initialized to infinity by default.
-		// m_prev_node: idem
-		// m_prev_arc: idem
-		// m_visited: idem
+		m_distances.assign(nNodes, std::numeric_limits<double>::max());
+		m_prev_node.assign(nNodes, INVALID_INDEX);
+		m_prev_edge.assign(nNodes, INVALID_INDEX);
+
+		// Min-heap of (distance, node index), with lazy deletion of the
+		// entries of nodes whose distance is later reduced. Indices follow
+		// the order of node IDs, so ties go to the lowest ID:
+		using heap_entry_t = std::pair<double, size_t>;
+		std::priority_queue<
+			heap_entry_t, std::vector<heap_entry_t>,
+			std::greater<heap_entry_t>>
+			heap;
+		std::vector<bool> visited(nNodes, false);
 		size_t visitedCount = 0;
-		m_distances[source_node_ID] = 0;
-		m_distances_non_visited[source_node_ID] = 0;
-
-		// Precompute all neighbors of all the nodes in the given graph:
-		graph.getAdjacencyMatrix(m_allNeighbors);
-
-		using namespace std;
-
-		TNodeID u;
-		// as long as there are nodes not yet visited.
-		do
-		{  // The algorithm:
-			// Find the nodeID with the minimum known distance so far
-			// considered:
-			double min_d = std::numeric_limits<double>::max();
-			u = INVALID_NODEID;
-
-			// No need to check if the min. distance node is not visited yet,
-			// since we
-			// keep two lists: m_distances_non_visited & m_distances
-			for (typename std::map<TNodeID, TDistance>::const_iterator itDist =
-					 m_distances_non_visited.begin();
-				 itDist != m_distances_non_visited.end(); ++itDist)
-			{
-				// TODO - remove these
-				// cout << "Current min distance: " << min_d << endl;
-				// cout << "itDist->first: " << itDist->first << endl;
-				// cout << "itDist->second (distance to this node): " <<
-				// itDist->second.dist << endl;
-
-				if (itDist->second.dist < min_d)
-				{
-					u = itDist->first;
-					min_d = itDist->second.dist;
-					// cout << "updating u, min_d... " << endl;
-				}
-				// cout << "finished for." << endl;
-			}
-
-			// make sure we have found the next nodeID from the available
-			// non-visited distances
-			if (u == INVALID_NODEID)
-			{
-				std::set<TNodeID> nodeIDs_unconnected;
-
-				// for all the nodes in the graph
-				for (typename TYPE_GRAPH::global_poses_t::const_iterator n_it =
-						 graph.nodes.begin();
-					 n_it != graph.nodes.end(); ++n_it)
-				{
-					// have I already visited this node in Dijkstra?
-					bool have_traversed = false;
-					for (typename id2dist_map_t::const_iterator d_it =
-							 m_distances.begin();
-						 d_it != m_distances.end(); ++d_it)
-					{
-						if (n_it->first == d_it->first)
-						{
-							have_traversed = true;
-							break;
-						}
-					}
-
-					if (!have_traversed)
-					{
-						nodeIDs_unconnected.insert(n_it->first);
-					}
-				}
-
-				std::string err_str =
-					mrpt::format("Graph is not fully connected!");
-				throw mrpt::graphs::detail::NotConnectedGraph(
-					nodeIDs_unconnected, err_str);
-			}
-
-			// Update distance (for possible future reference...) and remove
-			// this node from "non-visited":
-			m_distances[u] = m_distances_non_visited[u];
-			m_distances_non_visited.erase(u);
 
+		m_distances[source] = 0;
+		heap.emplace(0., source);
+		while (!heap.empty())
+		{
+			const double min_d = heap.top().first;
+			const size_t u = heap.top().second;
+			heap.pop();
+			if (visited[u]) continue;
+			visited[u] = true;
 			visitedCount++;
 
 			// Let the user know about our progress...
 			if (functor_on_progress) functor_on_progress(graph, visitedCount);
 
-			// For each arc from "u":
-			const std::set<TNodeID>& neighborsOfU =
-				m_allNeighbors[u];  // graph.getNeighborsOf(u,neighborsOfU);
-			for (std::set<TNodeID>::const_iterator itNei = neighborsOfU.begin();
-				 itNei != neighborsOfU.end(); ++itNei)
+			// Relax each arc from "u":
+			for (size_t e = adj.offsets[u]; e < adj.offsets[u + 1]; e++)
 			{
-				const TNodeID i = *itNei;
-				if (i == u) continue;  // ignore self-loops...
-
-				// the "edge_ui" may be searched here or a bit later, so the
-				// "bool" var will tell us.
-				typename graph_t::const_iterator edge_ui;
-				bool edge_ui_reverse = false;
-				bool edge_ui_found = false;
-
-				// Get weight of edge u<->i
-				double edge_ui_weight;
-				if (!functor_edge_weight)
-					edge_ui_weight = 1.;
-				else
-				{  // edge may be i->u or u->i:
-					edge_ui = graph.edges.find(std::make_pair(u, i));
-					if (edge_ui == graph.edges.end())
-					{
-						edge_ui = graph.edges.find(std::make_pair(i, u));
-						edge_ui_reverse = true;
-					}
-					ASSERT_(edge_ui != graph.edges.end());
-					edge_ui_weight = functor_edge_weight(
-						graph, edge_ui->first.first, edge_ui->first.second,
-						edge_ui->second);
-					edge_ui_found = true;
+				const size_t i = adj.neighbors[e];
+				const double d = min_d + adj.weights[e];
+				if (d < m_distances[i])
+				{
+					m_distances[i] = d;
+					m_prev_node[i] = u;
+					m_prev_edge[i] = e;
+					heap.emplace(d, i);
 				}
+			}
+		}
 
-				if ((min_d + edge_ui_weight) < m_distances[i].dist)
-				{  // the [] creates the entry if needed
-					// update m_distances, m_distances_non_visited
-					m_distances_non_visited[i].dist = min_d + edge_ui_weight;
-					m_distances[i].dist = min_d + edge_ui_weight;
-
-					m_prev_node[i].id = u;
-					// If still not done above, detect the direction of the arc
-					// now:
-					if (!edge_ui_found)
-					{
-						edge_ui = graph.edges.find(std::make_pair(u, i));
-						if (edge_ui == graph.edges.end())
-						{
-							edge_ui = graph.edges.find(std::make_pair(i, u));
-							edge_ui_reverse = true;
-						}
-						ASSERT_(edge_ui != graph.edges.end());
-					}
-
-					if (!edge_ui_reverse)
-						m_prev_arc[i] = std::make_pair(u, i);  // *u -> *i
-					else
-						m_prev_arc[i] = std::make_pair(i, u);  // *i -> *u
-				}
+		if (visitedCount < nNodes)
+		{
+			std::set<TNodeID> nodeIDs_unconnected;
+			for (typename TYPE_GRAPH::global_poses_t::const_iterator n_it =
+					 graph.nodes.begin();
+				 n_it != graph.nodes.end(); ++n_it)
+			{
+				const size_t i = adj.indexOf(n_it->first);
+				if (i == INVALID_INDEX || !visited[i])
+					nodeIDs_unconnected.insert(n_it->first);
 			}
-		} while (visitedCount < nNodes);
 
+			std::string err_str = mrpt::format("Graph is not fully connected!");
+			throw mrpt::graphs::detail::NotConnectedGraph(
+				nodeIDs_unconnected, err_str);
+		}
 	}  // end Dijkstra
 
+	/** Runs Dijkstra from each of the given source nodes, sharing a single
+	 * adjacency snapshot of the graph, in the threads of \a pool (or in the
+	 * calling thread, if it has none).
+	 *
+	 * \note \a functor_edge_weight is only invoked while building the
+	 * snapshot, in the calling thread.
+	 * \return One CDijkstra object per source node, in the same order.
+	 */
+	static std::vector<std::unique_ptr<CDijkstra>> fromSources(
+		const graph_t& graph, const std::vector<TNodeID>& source_node_IDs,
+		mrpt::WorkerThreadsPool& pool,
+		functor_edge_weight_t functor_edge_weight = functor_edge_weight_t())
+	{
+		const adjacency_ptr_t adj =
+			buildAdjacencySnapshot(graph, functor_edge_weight);
+
+		std::vector<std::unique_ptr<CDijkstra>> out(source_node_IDs.size());
+		pool.parallelForBlocks(
+			out.size(), 1, [&](size_t first, size_t last) {
+				for (size_t k = first; k < last; k++)
+					out[k].reset(
+						new CDijkstra(graph, adj, source_node_IDs[k]));
+			});
+		return out;
+	}
+
 	/** @name Query Dijkstra results
 	  @{ */
 
@@ -388,11 +403,11 @@ class CDijkstra
 	 */
 	inline double getNodeDistanceToRoot(const TNodeID id) const
 	{
-		typename id2dist_map_t::const_iterator it = m_distances.find(id);
-		if (it == m_distances.end())
+		const size_t i = m_adjacency->indexOf(id);
+		if (i == INVALID_INDEX)
 			THROW_EXCEPTION(
 				"Node was not found in the graph when running Dijkstra");
-		return it->second.dist;
+		return m_distances[i];
 	}
 
 	/** Return the set of all known node IDs (actually, a const ref to the
@@ -404,17 +419,34 @@ class CDijkstra
 
 	/** Return the node ID of the tree root, as passed in the constructor */
 	inline TNodeID getRootNodeID() const { return m_source_node_ID; }
-	/** Return the adjacency matrix of the input graph, which is cached at
-	 * construction so if needed later just use this copy to avoid
-	 * recomputing it
+	/** Return the adjacency matrix of the input graph, as it was at
+	 * construction time, so if needed later just use this copy to avoid
+	 * recomputing it. It is built from the adjacency snapshot upon the first
+	 * call (which may come from several threads at once), and does not
+	 * include self-loops.
 	 *
 	 * \sa  mrpt::graphs::CDirectedGraph::getAdjacencyMatrix
 	 * */
 	inline const list_all_neighbors_t& getCachedAdjacencyMatrix() const
 	{
+		std::call_once(m_allNeighborsBuilt, [this]() {
+			const TAdjacencySnapshot& adj = *m_adjacency;
+			for (size_t i = 0; i < adj.node_IDs.size(); i++)
+			{
+				std::set<TNodeID>& neighbors = m_allNeighbors[adj.node_IDs[i]];
+				for (size_t e = adj.offsets[i]; e < adj.offsets[i + 1]; e++)
+					neighbors.insert(adj.node_IDs[adj.neighbors[e]]);
+			}
+		});
 		return m_allNeighbors;
 	}
 
+	/** Return the adjacency snapshot the search ran on */
+	inline const adjacency_ptr_t& getAdjacencySnapshot() const
+	{
+		return m_adjacency;
+	}
+
 	/** Returns the shortest path between the source node passed in the
 	 * constructor and the given target node. The reconstructed path
 	 * contains a list of arcs (all of them exist in the graph with the given
@@ -432,14 +464,14 @@ class CDijkstra
 		out_path.clear();
 		if (target_node_ID == m_source_node_ID) return;
 
-		TNodeID nod = target_node_ID;
+		size_t nod = m_adjacency->indexOf(target_node_ID);
+		ASSERT_(nod != INVALID_INDEX);
 		do
 		{
-			typename id2pairIDs_map_t::const_iterator it = m_prev_arc.find(nod);
-			ASSERT_(it != m_prev_arc.end());
-			out_path.push_front(it->second);
-			nod = m_prev_node.find(nod)->second.id;
-		} while (nod != m_source_node_ID);
+			ASSERT_(m_prev_edge[nod] != INVALID_INDEX);
+			out_path.push_front(m_adjacency->edges[m_prev_edge[nod]]->first);
+			nod = m_prev_node[nod];
+		} while (m_adjacency->node_IDs[nod] != m_source_node_ID);
 
 	}  // end of getShortestPathTo
 
@@ -463,37 +495,44 @@ class CDijkstra
 
 		out_tree.clear();
 		out_tree.root = m_source_node_ID;
-		// For each saved arc in "m_prev_arc", recover the original data in the
-		// input graph and save it to the output tree structure.
-		for (typename id2pairIDs_map_t::const_iterator itArcs =
-				 m_prev_arc.begin();
-			 itArcs != m_prev_arc.end(); ++itArcs)
+		// For each node, save the arc from its parent to the output tree
+		// structure, along with the original edge data:
+		const TAdjacencySnapshot& adj = *m_adjacency;
+		for (size_t i = 0; i < adj.node_IDs.size(); i++)
 		{
-			const TNodeID id = itArcs->first;
-			const TNodeID id_from = itArcs->second.first;
-			const TNodeID id_to = itArcs->second.second;
+			if (m_prev_edge[i] == INVALID_INDEX) continue;
+			const TNodeID id = adj.node_IDs[i];
+			const auto itEdge = adj.edges[m_prev_edge[i]];
+			const TNodeID id_from = itEdge->first.first;
 
-			std::list<TreeEdgeInfo>& edges =
-				out_tree.edges_to_children[id == id_from ? id_to : id_from];
 			TreeEdgeInfo newEdge(id);
 			newEdge.reverse = (id == id_from);  // true: root towards leafs.
-			typename graph_t::edges_map_t::const_iterator itEdgeData =
-				m_cached_graph.edges.find(std::make_pair(id_from, id_to));
-			ASSERTMSG_(
-				itEdgeData != m_cached_graph.edges.end(),
-				format(
-					"Edge %u->%u is in Dijkstra paths but not in original "
-					"graph!",
-					static_cast<unsigned int>(id_from),
-					static_cast<unsigned int>(id_to)));
-			newEdge.data = &itEdgeData->second;
-			edges.push_back(newEdge);
+			newEdge.data = &itEdge->second;
+			out_tree.edges_to_children[adj.node_IDs[m_prev_node[i]]].push_back(
+				newEdge);
 		}
 
 	}  // end getTreeGraph
 
 	/** @} */
 
+   protected:
+	// Cached input data:
+	const TYPE_GRAPH& m_cached_graph;
+	const TNodeID m_source_node_ID;
+	adjacency_ptr_t m_adjacency;
+
+	// Intermediary and final results, by node index in the snapshot:
+	/** All the distances */
+	std::vector<double> m_distances;
+	/** Previous node in the shortest path, INVALID_INDEX for the root */
+	std::vector<size_t> m_prev_node;
+	/** Snapshot entry of the edge from the previous node */
+	std::vector<size_t> m_prev_edge;
+	std::set<TNodeID> m_lstNode_IDs;
+	mutable list_all_neighbors_t m_allNeighbors;
+	mutable std::once_flag m_allNeighborsBuilt;
+
 };  // end class
 
 }  // namespace graphs
@@ -0,0 +1,78 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace std;
+
+using graph_t = CNetworkOfPoses2D;
+
+TEST(CDirectedGraph, edgeChangeLog)
+{
+	graph_t g;
+	graph_t::TEdgeLogPosition pos;
+	graph_t::TEdgeChanges changes;
+
+	// Disabled by default:
+	g.insertEdge(0, 1, CPose2D(1, 0, 0));
+	EXPECT_FALSE(g.getEdgeChangesSince(pos, changes));
+
+	g.enableEdgeChangeLog();
+	EXPECT_FALSE(g.getEdgeChangesSince(pos, changes));
+	EXPECT_TRUE(g.getEdgeChangesSince(pos, changes));
+	EXPECT_TRUE(changes.inserted.empty());
+	EXPECT_TRUE(changes.erased.empty());
+
+	// Insertions, and an edge both inserted and erased in between:
+	const auto* e01 = &g.edges.begin()->second;
+	g.insertEdge(1, 2, CPose2D(2, 0, 0));
+	g.insertEdgeAtEnd(2, 3, CPose2D(3, 0, 0));
+	g.insertEdge(1, 3, CPose2D(4, 0, 0));
+	g.eraseEdge(1, 3);
+	g.eraseEdge(0, 1);
+	ASSERT_TRUE(g.getEdgeChangesSince(pos, changes));
+	ASSERT_EQ(changes.inserted.size(), 2u);
+	EXPECT_EQ(changes.inserted[0]->first, TPairNodeIDs(1, 2));
+	EXPECT_EQ(changes.inserted[1]->first, TPairNodeIDs(2, 3));
+	ASSERT_EQ(changes.erased.size(), 1u);
+	EXPECT_EQ(changes.erased[0].nodes, TPairNodeIDs(0, 1));
+	EXPECT_EQ(changes.erased[0].edge, e01);
+
+	// Erasing all edges between two nodes:
+	g.insertEdge(1, 2, CPose2D(5, 0, 0));
+	g.eraseEdge(1, 2);
+	ASSERT_TRUE(g.getEdgeChangesSince(pos, changes));
+	EXPECT_TRUE(changes.inserted.empty());
+	EXPECT_EQ(changes.erased.size(), 1u);
+	EXPECT_EQ(g.edgeCount(), 1u);
+
+	// Changes not logged:
+	g.edges.erase(g.edges.begin());
+	EXPECT_FALSE(g.getEdgeChangesSince(pos, changes));
+	EXPECT_TRUE(g.getEdgeChangesSince(pos, changes));
+	g.insertEdge(0, 1, CPose2D(1, 0, 0));
+	g.clearEdges();
+	EXPECT_FALSE(g.getEdgeChangesSince(pos, changes));
+
+	// Copies do not share the log:
+	g.insertEdge(0, 1, CPose2D(1, 0, 0));
+	graph_t copy = g;
+	EXPECT_FALSE(copy.isEdgeChangeLogEnabled());
+	copy.enableEdgeChangeLog();
+	graph_t::TEdgeLogPosition copy_pos;
+	copy.getEdgeChangesSince(copy_pos, changes);
+	EXPECT_FALSE(g.getEdgeChangesSince(copy_pos, changes));
+	g = copy;
+	EXPECT_FALSE(g.getEdgeChangesSince(pos, changes));
+	EXPECT_TRUE(g.getEdgeChangesSince(pos, changes));
+}
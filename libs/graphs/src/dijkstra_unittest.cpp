@@ -0,0 +1,287 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/graphs/dijkstra.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <thread>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace std;
+
+using graph_t = CNetworkOfPoses2D;
+using dijkstra_t = CDijkstra<graph_t>;
+
+// Edge weights are the (positive) "x" of each edge:
+static double edgeWeight(
+	const graph_t&, const TNodeID, const TNodeID, const graph_t::edge_t& e)
+{
+	return e.x();
+}
+
+// Random graph, with all nodes connected through a random spanning tree, plus
+// some extra edges in any direction, self-loops and duplicated edges.
+static void createRandomGraph(graph_t& g, size_t nNodes, std::mt19937& rng)
+{
+	std::uniform_real_distribution<double> w(0.1, 10.0);
+	g.clear();
+	g.root = 0;
+	for (TNodeID i = 0; i < nNodes; i++) g.nodes[i] = CPose2D();
+	for (TNodeID i = 1; i < nNodes; i++)
+	{
+		const TNodeID j = rng() % i;
+		if (rng() % 2)
+			g.insertEdge(i, j, CPose2D(w(rng), 0, 0));
+		else
+			g.insertEdge(j, i, CPose2D(w(rng), 0, 0));
+	}
+	for (size_t k = 0; k < 2 * nNodes; k++)
+		g.insertEdge(rng() % nNodes, rng() % nNodes, CPose2D(w(rng), 0, 0));
+}
+
+// Bellman-Ford, going from each node to its neighbors through the first edge
+// from the node to the neighbor, or else the first one in the opposite
+// direction:
+static std::map<TNodeID, double> bruteForceDistances(
+	const graph_t& g, TNodeID root, bool weighted)
+{
+	std::map<TNodeID, double> dist;
+	for (const auto& n : g.nodes) dist[n.first] = 1e300;
+	dist[root] = 0;
+	for (size_t it = 0; it < g.nodes.size(); it++)
+		for (const auto& e : g.edges)
+			for (int rev = 0; rev < 2; rev++)
+			{
+				const TNodeID a = rev ? e.first.second : e.first.first;
+				const TNodeID b = rev ? e.first.first : e.first.second;
+				auto itEdge = g.edges.find(std::make_pair(a, b));
+				if (itEdge == g.edges.end())
+					itEdge = g.edges.find(std::make_pair(b, a));
+				const double we = weighted ? itEdge->second.x() : 1.0;
+				if (a != b) dist[b] = std::min(dist[b], dist[a] + we);
+			}
+	return dist;
+}
+
+static void checkDijkstraResults(
+	const graph_t& g, const dijkstra_t& dijkstra, bool weighted)
+{
+	const auto dist =
+		bruteForceDistances(g, dijkstra.getRootNodeID(), weighted);
+	for (const auto& d : dist)
+	{
+		EXPECT_NEAR(dijkstra.getNodeDistanceToRoot(d.first), d.second, 1e-9);
+
+		// The path must be a chain of existing edges with that length:
+		dijkstra_t::edge_list_t path;
+		dijkstra.getShortestPathTo(d.first, path);
+		TNodeID cur = dijkstra.getRootNodeID();
+		double len = 0;
+		for (const auto& arc : path)
+		{
+			const auto itEdge = g.edges.find(arc);
+			ASSERT_TRUE(itEdge != g.edges.end());
+			ASSERT_TRUE(arc.first == cur || arc.second == cur);
+			cur = (arc.first == cur) ? arc.second : arc.first;
+			len += weighted ? itEdge->second.x() : 1.0;
+		}
+		EXPECT_EQ(cur, d.first);
+		EXPECT_NEAR(len, d.second, 1e-9);
+	}
+}
+
+TEST(CDijkstra, RandomGraphs)
+{
+	std::mt19937 rng(123);
+	for (int test = 0; test < 10; test++)
+	{
+		graph_t g;
+		createRandomGraph(g, 5 + 20 * test, rng);
+		const TNodeID root = rng() % g.nodes.size();
+		checkDijkstraResults(g, dijkstra_t(g, root, &edgeWeight), true);
+		checkDijkstraResults(g, dijkstra_t(g, root), false);
+
+		// The tree contains all nodes but the root, once:
+		dijkstra_t::tree_graph_t tree;
+		dijkstra_t(g, root).getTreeGraph(tree);
+		std::set<TNodeID> children;
+		for (const auto& n : tree.edges_to_children)
+			for (const auto& e : n.second)
+				EXPECT_TRUE(children.insert(e.id).second);
+		EXPECT_EQ(children.size(), g.nodes.size() - 1);
+		EXPECT_EQ(children.count(root), 0u);
+	}
+}
+
+TEST(CDijkstra, NotConnectedGraph)
+{
+	graph_t g;
+	for (TNodeID i = 0; i < 4; i++) g.nodes[i] = CPose2D();
+	g.insertEdge(0, 1, CPose2D(1, 0, 0));
+	g.insertEdge(2, 3, CPose2D(1, 0, 0));
+	EXPECT_THROW(
+		dijkstra_t(g, 0), mrpt::graphs::detail::NotConnectedGraph);
+	EXPECT_ANY_THROW(dijkstra_t(g, 10));
+}
+
+TEST(CDijkstra, MultipleSources)
+{
+	std::mt19937 rng(456);
+	graph_t g;
+	createRandomGraph(g, 200, rng);
+	std::vector<TNodeID> sources;
+	for (int i = 0; i < 16; i++) sources.push_back(rng() % g.nodes.size());
+
+	for (const size_t num_threads : {0, 4})
+	{
+		mrpt::WorkerThreadsPool pool(num_threads);
+		const auto results =
+			dijkstra_t::fromSources(g, sources, pool, &edgeWeight);
+		ASSERT_EQ(results.size(), sources.size());
+		for (size_t k = 0; k < sources.size(); k++)
+		{
+			const dijkstra_t single(g, sources[k], &edgeWeight);
+			EXPECT_EQ(results[k]->getRootNodeID(), sources[k]);
+			for (const auto& n : g.nodes)
+				EXPECT_EQ(
+					results[k]->getNodeDistanceToRoot(n.first),
+					single.getNodeDistanceToRoot(n.first));
+		}
+
+		// The adjacency is built once, even if queried from several
+		// threads:
+		const auto& d = *results[0];
+		std::vector<const dijkstra_t::list_all_neighbors_t*> adjs(4);
+		std::vector<std::thread> threads;
+		for (auto& a : adjs)
+			threads.emplace_back(
+				[&a, &d]() { a = &d.getCachedAdjacencyMatrix(); });
+		for (auto& t : threads) t.join();
+		for (const auto* a : adjs)
+		{
+			EXPECT_EQ(a, adjs[0]);
+			EXPECT_EQ(a->size(), g.nodes.size());
+		}
+	}
+}
+
+// Incremental estimation of the poses of a growing graph, whose edges are
+// consistent with some ground truth poses, so that any spanning tree yields
+// the same estimate:
+TEST(CNetworkOfPoses, IncrementalDijkstraNodesEstimate)
+{
+	std::mt19937 rng(789);
+	std::uniform_real_distribution<double> noise(-1.0, 1.0);
+
+	std::map<TNodeID, CPose2D> gt;
+	gt[0] = CPose2D();
+	graph_t g;
+	g.root = 0;
+	g.nodes[0] = CPose2D();
+	graph_t::dijkstra_nodes_estimate_state_t state;
+
+	auto addEdge = [&](TNodeID from, TNodeID to) {
+		g.insertEdge(from, to, gt[to] - gt[from]);
+	};
+
+	for (TNodeID i = 1; i < 300; i++)
+	{
+		gt[i] = gt[i - 1] + CPose2D(1.0, 0.1 * noise(rng), 0.2 * noise(rng));
+		g.nodes[i] = CPose2D();
+		if (rng() % 2)
+			addEdge(i - 1, i);
+		else
+			addEdge(i, i - 1);
+		// Loop closures:
+		if (i > 10 && rng() % 5 == 0)
+		{
+			const TNodeID j = rng() % (i - 1);
+			if (rng() % 2)
+				addEdge(i, j);
+			else
+				addEdge(j, i);
+		}
+
+		g.dijkstra_nodes_estimate(state);
+
+		ASSERT_EQ(g.nodes.size(), i + 1);
+		if (i % 50 == 0 || i == 299)
+		{
+			const dijkstra_t dijkstra(g, g.root);
+			for (const auto& n : state.nodes)
+				EXPECT_EQ(
+					static_cast<double>(n.dist),
+					dijkstra.getNodeDistanceToRoot(n.id));
+		}
+		for (const auto& n : g.nodes)
+		{
+			EXPECT_NEAR(n.second.x(), gt[n.first].x(), 1e-6);
+			EXPECT_NEAR(n.second.y(), gt[n.first].y(), 1e-6);
+			EXPECT_NEAR(n.second.phi(), gt[n.first].phi(), 1e-6);
+		}
+	}
+
+	// Same results than a full estimation:
+	graph_t g_full = g;
+	g_full.dijkstra_nodes_estimate();
+	for (const auto& n : g_full.nodes)
+		EXPECT_NEAR((n.second - g.nodes[n.first]).norm(), 0, 1e-9);
+
+	// Removing an edge and inserting another one starts over, also if the
+	// new edges may reuse the address of the removed one:
+	for (const bool erase_through_graph : {true, false})
+	{
+		const auto itErase = std::next(g.edges.begin(), 20);
+		const TNodeID from = itErase->first.first, to = itErase->first.second;
+		if (erase_through_graph)
+			g.eraseEdge(itErase);
+		else
+			g.edges.erase(itErase);
+		// The removed edge is bypassed by a node not connected yet:
+		const TNodeID i = g.nodes.size();
+		gt[i] = gt[from] + CPose2D(0.5, 0.5, 0);
+		g.nodes[i] = CPose2D();
+		addEdge(from, i);
+		addEdge(i, to);
+		// Some other edge, with a wrong value:
+		g.insertEdge(from, to, CPose2D(10, 10, 0));
+		g.eraseEdge(from, to);
+
+		g.dijkstra_nodes_estimate(state);
+		g_full = g;
+		g_full.dijkstra_nodes_estimate();
+		ASSERT_EQ(g.nodes.size(), g_full.nodes.size());
+		for (const auto& n : g_full.nodes)
+		{
+			EXPECT_NEAR((n.second - g.nodes[n.first]).norm(), 0, 1e-9);
+			EXPECT_NEAR((n.second - gt[n.first]).norm(), 0, 1e-6);
+		}
+		EXPECT_EQ(state.known_edges.size(), g.edges.size());
+	}
+
+	// Only the nodes reached through shorter paths are written:
+	const CPose2D untouched(-1, -1, 0);
+	g.nodes[1] = untouched;
+	g.nodes[260] = untouched;
+	g.insertEdge(250, 260, gt[260] - gt[250]);
+	g.dijkstra_nodes_estimate(state);
+	EXPECT_NEAR((g.nodes[1] - untouched).norm(), 0, 1e-9);
+	EXPECT_NEAR((g.nodes[260] - gt[260]).norm(), 0, 1e-6);
+	g.nodes[1] = gt[1];
+
+	// Changing the root starts over:
+	g.root = 150;
+	g.dijkstra_nodes_estimate(state);
+	EXPECT_EQ(state.root, 150u);
+	EXPECT_NEAR((g.nodes[150] - CPose2D()).norm(), 0, 1e-9);
+	EXPECT_NEAR((g.nodes[0] - (gt[0] - gt[150])).norm(), 0, 1e-6);
+}
@@ -723,6 +723,9 @@ class CGraphSlamEngine : public mrpt::system::COutputLogger
 
 	/**\brief The graph object to be built and optimized. */
 	GRAPH_T m_graph;
+	/**\brief Spanning tree of m_graph, updated with the new edges on each
+	 * call to execDijkstraNodesEstimation() */
+	typename GRAPH_T::dijkstra_nodes_estimate_state_t m_dijkstra_state;
 
 	/**\name Decider/Optimizer instances. Delegating the GRAPH_T tasks to these
 	 * classes makes up for a modular and configurable design
@@ -877,7 +877,7 @@ void CGraphSlamEngine<GRAPH_T>::execDijkstraNodesEstimation()
 	{
 		std::lock_guard<std::mutex> graph_lock(m_graph_section);
 		m_time_logger.enter("dijkstra_nodes_estimation");
-		m_graph.dijkstra_nodes_estimate();
+		m_graph.dijkstra_nodes_estimate(m_dijkstra_state);
 		m_time_logger.leave("dijkstra_nodes_estimation");
 	}
 }
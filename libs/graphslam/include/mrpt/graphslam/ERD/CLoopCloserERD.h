@@ -10,6 +10,7 @@
 #ifndef CLOOPCLOSERERD_H
 #define CLOOPCLOSERERD_H
 
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/math/CMatrix.h>
 #include <mrpt/config/CLoadableOptions.h>
 #include <mrpt/config/CConfigFileBase.h>
@@ -27,7 +28,9 @@
 #include <mrpt/graphs/THypothesis.h>
 #include <mrpt/graphs/CHypothesisNotFoundException.h>
 
+#include <future>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <set>
@@ -200,6 +203,22 @@ exponential.
  *   + \a Description   : Boolean flag indicating whether to check for loop
  *   closures only in the current node's partition
  *
+ * - \b LC_num_threads
+ *   + \a Section       : EdgeRegistrationDeciderParameters
+ *   + \a Default value : 1
+ *   + \a Required      : FALSE
+ *   + \a Description   : Number of threads running the ICP alignments of the
+ *   loop closure hypotheses and computing the elements of the pair-wise
+ *   consistency matrix (0: as many as CPU cores).
+ *
+ * - \b LC_async_evaluation
+ *   + \a Section       : EdgeRegistrationDeciderParameters
+ *   + \a Default value : FALSE
+ *   + \a Required      : FALSE
+ *   + \a Description   : If TRUE, the loop closure hypotheses are evaluated
+ *   in a background thread while graphSLAM goes on, and the accepted edges
+ *   are registered in the graph at the next call to updateState().
+ *
  * - \b visualize_map_partitions
  *   + \a Section       : VisualizationParameters
  *   + \a Default value : TRUE
@@ -320,67 +339,8 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 			return o;
 		}
 	};
-	/**\brief Struct for passing additional parameters to the
-	 * generateHypotsPool call
-	 */
-	struct TGenerateHypotsPoolAdParams
-	{
-		using group_t = std::map<mrpt::graphs::TNodeID, node_props_t>;
-
-		/**\brief  Ad. params for groupA */
-		group_t groupA_params;
-		/**\brief  Ad. params for groupB */
-		group_t groupB_params;
-	};
 	/**\} */
 
-	/**\brief Generate the hypothesis pool for all the inter-group constraints
-	 * between two groups of nodes.
-	 *
-	 * \param[in] groupA First group to be tested
-	 * \param[in] groupB Second group to be tested
-	 * \param[out] generated_hypots Pool of generated hypothesis. Hypotheses
-	 * are generated in the heap, so the caller is responsible of afterwards
-	 * calling \a delete.
-	 */
-	void generateHypotsPool(
-		const std::vector<uint32_t>& groupA,
-		const std::vector<uint32_t>& groupB, hypotsp_t* generated_hypots,
-		const TGenerateHypotsPoolAdParams* ad_params = NULL);
-	/**\brief Compute the pair-wise consistencies Matrix.
-	 *
-	 * \param[in] groupA First group to be used
-	 * \param[in] groupB Second group to be used
-	 * \param[in] hypots_pool Pool of hypothesis that has been generated
-	 * between the two groups
-	 * \pram[out] consist_matrix Pointer to Pair-wise consistencies matrix that
-	 * is to be filled
-
-	 * \param[in] groupA_opt_paths Pointer to vector of optimal paths that can
-	 * be used instead of making queries to the m_node_optimal_paths class
-	 * vector. See corresponding argument in generatePWConsistencyElement
-	 * method
-	 * \param[in] groupB_opt_paths
-	 *
-	 * \sa generatePWConsistencyElement
-	 * \sa evalPWConsistenciesMatrix
-	 */
-	void generatePWConsistenciesMatrix(
-		const std::vector<uint32_t>& groupA,
-		const std::vector<uint32_t>& groupB, const hypotsp_t& hypots_pool,
-		mrpt::math::CMatrixDouble* consist_matrix,
-		const paths_t* groupA_opt_paths = NULL,
-		const paths_t* groupB_opt_paths = NULL);
-	/**\brief Evalute the consistencies matrix, fill the valid hypotheses
-	 *
-	 * Call to this method should be made right after generating the
-	 * consistencies matrix using the generatePWConsistenciesMatrix method
-	 *
-	 * \sa generatePWConsistenciesMatrix
-	 */
-	void evalPWConsistenciesMatrix(
-		const mrpt::math::CMatrixDouble& consist_matrix,
-		const hypotsp_t& hypots_pool, hypotsp_t* valid_hypots);
 	// Public variables
 	// ////////////////////////////
    protected:
@@ -498,6 +458,12 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 		 * registered
 		 */
 		int full_partition_per_nodes;
+		/**\brief Threads for evaluating the loop closure hypotheses (0: as
+		 * many as CPU cores) */
+		size_t LC_num_threads;
+		/**\brief Evaluate the loop closure hypotheses in the background and
+		 * register the accepted ones in the next step */
+		bool LC_async_evaluation;
 		bool visualize_map_partitions;
 		std::string keystroke_map_partitions;
 
@@ -610,10 +576,114 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 	 */
 	void evaluatePartitionsForLC(const partitions_t& partitions);
 
+	/**\name Loop closure evaluation in worker threads */
+	/**\{ */
+	/**\brief Evaluation of the loop closure hypotheses of one partition.
+	 *
+	 * Holds copies of everything the evaluation reads (poses and laser scans
+	 * of the nodes, minimum uncertainty paths within each group), so that
+	 * runLCEvaluation() does not access the graph and may run concurrently
+	 * with the next graphSLAM steps.
+	 */
+	struct TLCEvaluation
+	{
+		TLCEvaluation() = default;
+		TLCEvaluation(const TLCEvaluation&) = delete;
+		TLCEvaluation& operator=(const TLCEvaluation&) = delete;
+		/** Deletes the generated hypotheses */
+		~TLCEvaluation();
+
+		std::vector<uint32_t> groupA, groupB;
+		/** Pose and laser scan of the nodes of both groups */
+		std::map<mrpt::graphs::TNodeID, node_props_t> nodes_props;
+		/** Minimum uncertainty paths between the nodes of each group */
+		paths_t groupA_opt_paths, groupB_opt_paths;
+		/** Minimum ICP goodness for a hypothesis to be valid */
+		double goodness_thresh = 0;
+
+		/** Generated hypotheses (owned) and the consistent ones among them */
+		hypotsp_t hypots_pool, valid_hypots;
+		/** Two largest eigenvalues of the pair-wise consistency matrix */
+		double lambda1 = 0, lambda2 = 0;
+	};
+	using lc_evaluations_t = std::vector<std::unique_ptr<TLCEvaluation>>;
+
+	/**\brief Split the partition in groups and fetch everything needed for
+	 * its evaluation from the graph.
+	 *
+	 * \return False if the partition can't be evaluated (e.g. the paths
+	 * between the nodes of a group are not available).
+	 */
+	bool prepareLCEvaluation(
+		const std::vector<uint32_t>& partition, TLCEvaluation* eval);
+	/**\brief Generate the hypotheses pool and keep the consistent ones.
+	 *
+	 * ICP alignments and elements of the consistency matrix are computed in
+	 * parallel in the given pool. Neither this method nor those it calls
+	 * access the graph or log, so it can run in a background thread.
+	 */
+	void runLCEvaluation(TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool);
+	/**\brief Generate the hypothesis pool for all the inter-group constraints
+	 * between the two groups of nodes of the evaluation, directed bi => ai.
+	 *
+	 * The ICP alignments run in parallel, one per task. Hypotheses between
+	 * nodes without a laser scan, or with an alignment goodness not above
+	 * TLCEvaluation::goodness_thresh, are marked as invalid.
+	 */
+	void generateHypotsPool(
+		TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool);
+	/**\brief Compute the pair-wise consistencies matrix of the hypotheses
+	 * pool, in parallel.
+	 *
+	 * \param[out] consist_matrix Pair-wise consistencies matrix, of the size
+	 * of the hypotheses pool.
+	 *
+	 * \sa computePWConsistency
+	 * \sa evalPWConsistenciesMatrix
+	 */
+	void generatePWConsistenciesMatrix(
+		const TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool,
+		mrpt::math::CMatrixDouble* consist_matrix) const;
+	/**\brief Evalute the consistencies matrix and fill the valid hypotheses
+	 * of the evaluation, along with the two largest eigenvalues.
+	 *
+	 * \sa generatePWConsistenciesMatrix
+	 */
+	void evalPWConsistenciesMatrix(
+		const mrpt::math::CMatrixDouble& consist_matrix,
+		TLCEvaluation& eval) const;
+	/**\brief Compute the dominant eigenvector of the consistency matrix, with
+	 * the absolute value of its elements, and its two largest eigenvalues.
+	 *
+	 * \return True if the ratio of the eigenvalues is above
+	 * TLoopClosureParams::LC_eigenvalues_ratio_thresh.
+	 */
 	bool computeDominantEigenVector(
 		const mrpt::math::CMatrixDouble& consist_matrix,
-		mrpt::math::dynamic_vector<double>* eigvec,
-		bool use_power_method = false);
+		mrpt::math::dynamic_vector<double>* eigvec, double* lambda1,
+		double* lambda2) const;
+	/**\brief Register the accepted hypotheses of the given evaluations. */
+	void commitLCEvaluations(const lc_evaluations_t& evals);
+	/**\brief Wait for the background evaluation, if any, and register its
+	 * accepted hypotheses.
+	 */
+	void collectAsyncLCEvaluation();
+	/**\brief Pair-wise consistency of the hypotheses b1=>a2, b2=>a1 given
+	 * the minimum uncertainty paths a1=>a2, b1=>b2.
+	 *
+	 * \sa generatePWConsistencyElement
+	 */
+	static double computePWConsistency(
+		const path_t& path_a1_a2, const path_t& path_b1_b2,
+		const hypot_t& hypot_b1_a2, const hypot_t& hypot_b2_a1);
+	/**\brief Discretize the dominant eigenvector of the consistency matrix
+	 * into the 0/1 indicator vector of the accepted hypotheses, greedily
+	 * maximizing its normalized dot product with the former.
+	 */
+	static void discretizeIndicatorVector(
+		const mrpt::math::dynamic_vector<double>& u,
+		mrpt::math::dynamic_vector<double>* w);
+	/**\} */
 	/**\brief Return the pair-wise consistency between the observations of the
 	 * given nodes.
 	 *
@@ -851,6 +921,12 @@ class CLoopCloserERD : public virtual mrpt::graphslam::deciders::
 	 * proc.
 	 */
 	double m_lc_icp_constraint_factor;
+	/**\brief Threads for the ICP alignments and consistency matrices */
+	mrpt::WorkerThreadsPool m_lc_threads;
+	/**\brief Evaluations running in the background, if
+	 * TLoopClosureParams::LC_async_evaluation is set */
+	lc_evaluations_t m_async_lc_evals;
+	std::future<void> m_async_lc;
 };
 }  // namespace deciders
 }  // namespace graphslam
@@ -9,10 +9,13 @@
 
 #ifndef CLOOPCLOSERERD_IMPL_H
 #define CLOOPCLOSERERD_IMPL_H
+#include <mrpt/config/CConfigFile.h>
 #include <mrpt/math/utils.h>
+#include <mrpt/obs/obs_utils.h>
 #include <mrpt/containers/stl_containers_utils.h>
 #include <mrpt/opengl/CEllipsoid.h>
 #include <mrpt/opengl/CSphere.h>
+#include <mrpt/opengl/CPlanarLaserScan.h>
 #include <mrpt/math/data_utils.h>
 
 namespace mrpt
@@ -42,6 +45,9 @@ CLoopCloserERD<GRAPH_T>::~CLoopCloserERD()
 {
 	using namespace mrpt::graphslam;
 
+	// let a background loop closure evaluation finish before tearing down
+	if (m_async_lc.valid()) m_async_lc.wait();
+
 	// release memory of m_node_optimal_paths map.
 	MRPT_LOG_DEBUG_STREAM("Releasing memory of m_node_optimal_paths map...");
 	for (auto it = m_node_optimal_paths.begin();
@@ -71,6 +77,9 @@ bool CLoopCloserERD<GRAPH_T>::updateState(
 	using namespace mrpt::poses;
 	using namespace mrpt::math;
 
+	// register the loop closures found in the background since last step
+	this->collectAsyncLCEvaluation();
+
 	// Track the last recorded laser scan
 	{
 		CObservation2DRangeScan::Ptr scan =
@@ -542,141 +551,249 @@ void CLoopCloserERD<GRAPH_T>::evaluatePartitionsForLC(
 	const partitions_t& partitions)
 {
 	MRPT_START;
-	using namespace mrpt;
-	using namespace mrpt::graphslam::detail;
-	using namespace mrpt::math;
 	using namespace std;
-	this->m_time_logger.enter("LoopClosureEvaluation");
 
+	// a previous background evaluation must be over before starting another
+	this->collectAsyncLCEvaluation();
 	if (partitions.size() == 0) return;
+	this->m_time_logger.enter("LoopClosureEvaluation");
 
 	MRPT_LOG_DEBUG_FMT(
 		"Evaluating partitions for loop closures...\n%s\n",
 		this->header_sep.c_str());
 
-	// for each partition to be evaulated...
+	// fetch from the graph whatever the evaluation of each partition needs...
+	lc_evaluations_t evals;
 	for (partitions_t::const_iterator p_it = partitions.begin();
 		 p_it != partitions.end(); ++p_it)
 	{
-		std::vector<uint32_t> partition(*p_it);
+		std::unique_ptr<TLCEvaluation> eval(new TLCEvaluation);
+		if (this->prepareLCEvaluation(*p_it, eval.get()))
+		{
+			evals.push_back(std::move(eval));
+		}
+	}
 
-		// split the partition to groups
-		std::vector<uint32_t> groupA, groupB;
-		this->splitPartitionToGroups(
-			partition, &groupA, &groupB,
-			/*max_nodes_in_group=*/5);
+	// ... and evaluate the hypotheses, either now or in the background
+	if (m_lc_params.LC_async_evaluation)
+	{
+		m_async_lc_evals = std::move(evals);
+		m_async_lc = std::async(std::launch::async, [this]() {
+			for (auto& eval : m_async_lc_evals)
+				this->runLCEvaluation(*eval, m_lc_threads);
+		});
+	}
+	else
+	{
+		for (auto& eval : evals) this->runLCEvaluation(*eval, m_lc_threads);
+		this->commitLCEvaluations(evals);
+	}
+
+	MRPT_LOG_DEBUG_STREAM("\n" << this->header_sep);
+	this->m_time_logger.leave("LoopClosureEvaluation");
 
-		// generate hypotheses pool
-		hypotsp_t hypots_pool;
-		this->generateHypotsPool(groupA, groupB, &hypots_pool);
+	MRPT_END;
+}
 
-		// compute the pair-wise consistency matrix
-		CMatrixDouble consist_matrix(hypots_pool.size(), hypots_pool.size());
-		this->generatePWConsistenciesMatrix(
-			groupA, groupB, hypots_pool, &consist_matrix);
+template <class GRAPH_T>
+bool CLoopCloserERD<GRAPH_T>::prepareLCEvaluation(
+	const std::vector<uint32_t>& partition, TLCEvaluation* eval)
+{
+	MRPT_START;
+	using mrpt::graphs::TNodeID;
+	ASSERTDEB_(eval);
 
-		// evaluate resulting matrix - fill valid hypotheses
-		hypotsp_t valid_hypots;
-		this->evalPWConsistenciesMatrix(
-			consist_matrix, hypots_pool, &valid_hypots);
+	// split the partition to groups
+	std::vector<uint32_t> partition_nodes(partition);
+	this->splitPartitionToGroups(
+		partition_nodes, &eval->groupA, &eval->groupB,
+		/*max_nodes_in_group=*/5);
 
-		// registering the indicated/valid hypotheses
-		if (valid_hypots.size())
+	// pose and laser scan of each node. Those without a scan are left out;
+	// their hypotheses are marked as invalid
+	for (const std::vector<uint32_t>* group : {&eval->groupA, &eval->groupB})
+	{
+		for (const TNodeID nodeID : *group)
 		{
-			MRPT_LOG_WARN_STREAM("Registering Hypotheses...");
-			for (typename hypotsp_t::iterator it = valid_hypots.begin();
-				 it != valid_hypots.end(); ++it)
+			node_props_t props;
+			if (this->getPropsOfNodeID(nodeID, &props.pose, props.scan))
 			{
-				this->registerHypothesis(**it);
+				eval->nodes_props[nodeID] = props;
 			}
 		}
-		// delete all hypotheses - generated in the heap...
-		MRPT_LOG_DEBUG_STREAM("Deleting the generated hypotheses pool...");
-		for (typename hypotsp_t::iterator it = hypots_pool.begin();
-			 it != hypots_pool.end(); ++it)
+	}
+
+	// minimum uncertainty paths between the nodes of each group, as used in
+	// generatePWConsistencyElement (a1 => a2, b1 => b2). Dijkstra runs once
+	// per pair of nodes instead of once per element of the consistency matrix
+	auto fetch_paths = [this](
+						   const std::vector<uint32_t>& group,
+						   paths_t* paths) {
+		for (size_t i = 0; i < group.size(); i++)
 		{
-			delete *it;
+			for (size_t j = i + 1; j < group.size(); j++)
+			{
+				this->execDijkstraProjection(group[i], group[j]);
+				const path_t* path = this->queryOptimalPath(group[j]);
+				if (!path || path->getSource() != group[i])
+				{
+					MRPT_LOG_DEBUG_STREAM(
+						"No optimal path between nodes: "
+						<< group[i] << " => " << group[j]);
+					return false;
+				}
+				paths->push_back(*path);
+			}
 		}
-	}  // for each partition
+		return true;
+	};
+	if (!fetch_paths(eval->groupA, &eval->groupA_opt_paths) ||
+		!fetch_paths(eval->groupB, &eval->groupB_opt_paths))
+	{
+		return false;
+	}
 
-	MRPT_LOG_DEBUG_STREAM("\n" << this->header_sep);
-	this->m_time_logger.leave("LoopClosureEvaluation");
+	eval->goodness_thresh =
+		m_laser_params.goodness_threshold_win.getMedian() *
+		m_lc_icp_constraint_factor;
+	return true;
+	MRPT_END;
+}
 
+template <class GRAPH_T>
+void CLoopCloserERD<GRAPH_T>::runLCEvaluation(
+	TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool)
+{
+	MRPT_START;
+	this->generateHypotsPool(eval, pool);
+	// the ratio of the two dominant eigenvalues is needed below
+	if (eval.hypots_pool.size() < 2) return;
+
+	mrpt::math::CMatrixDouble consist_matrix(
+		eval.hypots_pool.size(), eval.hypots_pool.size());
+	this->generatePWConsistenciesMatrix(eval, pool, &consist_matrix);
+	this->evalPWConsistenciesMatrix(consist_matrix, eval);
 	MRPT_END;
 }
 
+template <class GRAPH_T>
+void CLoopCloserERD<GRAPH_T>::commitLCEvaluations(
+	const lc_evaluations_t& evals)
+{
+	MRPT_START;
+	for (const auto& eval : evals)
+	{
+		MRPT_LOG_DEBUG_STREAM(
+			"Evaluated hypotheses between groups:\n"
+			<< "- groupA:\t" << mrpt::containers::getSTLContainerAsString(
+								   eval->groupA)
+			<< "\n- groupB:\t"
+			<< mrpt::containers::getSTLContainerAsString(eval->groupB)
+			<< "\nlambda1 = " << eval->lambda1
+			<< " | lambda2 = " << eval->lambda2
+			<< " | accepted hypotheses: " << eval->valid_hypots.size()
+			<< "/" << eval->hypots_pool.size());
+
+		// registering the indicated/valid hypotheses
+		if (eval->valid_hypots.size())
+		{
+			MRPT_LOG_WARN_STREAM("Registering Hypotheses...");
+			for (const hypot_t* hypot : eval->valid_hypots)
+			{
+				this->registerHypothesis(*hypot);
+			}
+		}
+	}
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CLoopCloserERD<GRAPH_T>::collectAsyncLCEvaluation()
+{
+	MRPT_START;
+	if (!m_async_lc.valid()) return;
+
+	this->m_time_logger.enter("LoopClosureEvaluation (wait)");
+	// rethrows any exception of the evaluation
+	m_async_lc.get();
+	this->m_time_logger.leave("LoopClosureEvaluation (wait)");
+
+	lc_evaluations_t evals = std::move(m_async_lc_evals);
+	m_async_lc_evals.clear();
+	this->commitLCEvaluations(evals);
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+CLoopCloserERD<GRAPH_T>::TLCEvaluation::~TLCEvaluation()
+{
+	// hypotheses are generated in the heap
+	for (hypot_t* hypot : hypots_pool)
+	{
+		delete hypot;
+	}
+}
+
 template <class GRAPH_T>
 void CLoopCloserERD<GRAPH_T>::evalPWConsistenciesMatrix(
-	const mrpt::math::CMatrixDouble& consist_matrix,
-	const hypotsp_t& hypots_pool, hypotsp_t* valid_hypots)
+	const mrpt::math::CMatrixDouble& consist_matrix, TLCEvaluation& eval) const
 {
 	MRPT_START;
-	using namespace std;
 	using namespace mrpt::math;
 
-	ASSERTDEB_(valid_hypots);
-	valid_hypots->clear();
+	eval.valid_hypots.clear();
 
 	// evaluate the pair-wise consistency matrix
 	// compute dominant eigenvector
 	dynamic_vector<double> u;
 	bool valid_lambda_ratio = this->computeDominantEigenVector(
-		consist_matrix, &u,
-		/*use_power_method=*/false);
+		consist_matrix, &u, &eval.lambda1, &eval.lambda2);
 	if (!valid_lambda_ratio) return;
 
-	// cout << "Dominant eigenvector: " << u.transpose() << endl;
-
 	// discretize the indicator vector - maximize the dot product of
 	// w_unit .* u
 	ASSERTDEB_(u.size());
-	dynamic_vector<double> w(u.size(), 0);  // discretized  indicator vector
-	double dot_product = 0;
-	for (int i = 0; i != w.size(); ++i)
+	dynamic_vector<double> w;  // discretized  indicator vector
+	discretizeIndicatorVector(u, &w);
+
+	// Current hypothesis is to be registered.
+	for (int wi = 0; wi != w.size(); ++wi)
 	{
-		// stream for debugging reasons
-		stringstream ss;
+		if (w(wi) == 1)
+		{
+			// search through the potential hypotheses, find the one with the
+			// correct ID and register it.
+			eval.valid_hypots.push_back(
+				this->findHypotByID(eval.hypots_pool, wi));
+		}
+	}
 
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CLoopCloserERD<GRAPH_T>::discretizeIndicatorVector(
+	const mrpt::math::dynamic_vector<double>& u,
+	mrpt::math::dynamic_vector<double>* w)
+{
+	ASSERTDEB_(w);
+	w->setZero(u.size());
+	double dot_product = 0;
+	for (int i = 0; i != w->size(); ++i)
+	{
 		// make the necessary change and see if the dot product increases
-		w(i) = 1;
+		(*w)(i) = 1;
 		double potential_dot_product =
-			((w.transpose() * u) / w.squaredNorm()).value();
-		ss << mrpt::format(
-			"current: %f | potential_dot_product: %f", dot_product,
-			potential_dot_product);
+			((w->transpose() * u) / w->squaredNorm()).value();
 		if (potential_dot_product > dot_product)
 		{
-			ss << " ==>  ACCEPT";
 			dot_product = potential_dot_product;
 		}
 		else
 		{
-			ss << " ==>  REJECT";
-			w(i) = 0;  // revert the change
+			(*w)(i) = 0;  // revert the change
 		}
-		ss << endl;
-		// MRPT_LOG_DEBUG_STREAM(ss.str());
 	}
-	cout << "Outcome of discretization: " << w.transpose() << endl;
-	// mrpt::system::pause();
-
-	// Current hypothesis is to be registered.
-	if (!w.isZero())
-	{
-		for (int wi = 0; wi != w.size(); ++wi)
-		{
-			if (w(wi) == 1)
-			{
-				// search through the potential hypotheses, find the one with
-				// the
-				// correct ID and register it.
-				valid_hypots->push_back(this->findHypotByID(hypots_pool, wi));
-			}
-		}
-	}
-	// mrpt::system::pause();
-
-	MRPT_END;
 }
 
 template <class GRAPH_T>
@@ -747,153 +864,57 @@ void CLoopCloserERD<GRAPH_T>::splitPartitionToGroups(
 
 template <class GRAPH_T>
 void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
-	const std::vector<uint32_t>& groupA, const std::vector<uint32_t>& groupB,
-	hypotsp_t* generated_hypots,
-	const TGenerateHypotsPoolAdParams* ad_params /*=NULL*/)
+	TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool)
 {
 	MRPT_START;
-	using namespace mrpt;
-	using namespace mrpt::containers;
-
-	ASSERTDEBMSG_(
-		generated_hypots,
-		"generateHypotsPool: Given hypotsp_t pointer is invalid.");
-	generated_hypots->clear();
+	using mrpt::graphs::TNodeID;
 
-	MRPT_LOG_DEBUG_STREAM("Generating hypotheses for groups: " << endl);
-	MRPT_LOG_DEBUG_STREAM(
-		"- groupA:\t" << getSTLContainerAsString(groupA)
-					  << " - size: " << groupA.size() << endl);
-	MRPT_LOG_DEBUG_STREAM(
-		"- groupB:\t" << getSTLContainerAsString(groupB)
-					  << " - size: " << groupB.size() << endl);
-
-	// verify that the number of laserScans is the same as the number of poses
-	// if
-	// the TGenerateHyptsPoolAdParams is used
-	// formulate into function and pass std::vector<uint32_t> and
-	// ad_params->group
-	// TODO
-	if (ad_params)
+	// use a hypothesis ID with which the consistency matrix will then be
+	// formed. By default hypotheses will direct bi => ai; If the hypothesis
+	// is traversed the opposite way, take the opposite of the constraint
+	hypotsp_t& hypots_pool = eval.hypots_pool;
+	for (const TNodeID b : eval.groupB)
 	{
-		const typename TGenerateHypotsPoolAdParams::group_t& params =
-			ad_params->groupA_params;
-		if (params.size())
+		for (const TNodeID a : eval.groupA)
 		{
-			size_t nodes_count = groupA.size();
-
-			// map should have same size
-			ASSERTDEBMSG_(
-				nodes_count == params.size(),
-				format(
-					"Size mismatch between nodeIDs in group [%lu]"
-					" and corresponding properties map [%lu]",
-					nodes_count, params.size()));
+			hypot_t* hypot = new hypot_t;
+			hypot->from = b;
+			hypot->to = a;
+			hypot->id = hypots_pool.size();
+			hypots_pool.push_back(hypot);
 		}
 	}
 
-	// use a hypothesis ID with which the consistency matrix will then be
-	// formed
-	int hypot_counter = 0;
-	int invalid_hypots = 0;  // just for keeping track of them.
-	{
-		// iterate over all the nodes in both groups
-		for (std::vector<uint32_t>::const_iterator  // B - from
-			 b_it = groupB.begin();
-			 b_it != groupB.end(); ++b_it)
-		{
-			for (std::vector<uint32_t>::const_iterator  // A - to
-				 a_it = groupA.begin();
-				 a_it != groupA.end(); ++a_it)
+	// one ICP alignment per task, since they are expensive
+	pool.parallelForBlocks(
+		hypots_pool.size(), 1, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
 			{
-				// by default hypotheses will direct bi => ai; If the hypothesis
-				// is
-				// traversed the opposite way, take the opposite of the
-				// constraint
-				hypot_t* hypot = new hypot_t;
-				hypot->from = *b_it;
-				hypot->to = *a_it;
-				hypot->id = hypot_counter++;
-
-				// [from] *b_it ====[edge]===> [to]  *a_it
-
-				// Fetch and set the pose and LaserScan of from, to nodeIDs
-				//
-				// even if icp_ad_params NULL, it will be handled appropriately
-				// by the
-				// getICPEdge fun.
-				// bool from_success, to_success;
-				TGetICPEdgeAdParams* icp_ad_params = NULL;
-				if (ad_params)
+				hypot_t& hypot = *hypots_pool[i];
+				const auto from = eval.nodes_props.find(hypot.from);
+				const auto to = eval.nodes_props.find(hypot.to);
+				if (from == eval.nodes_props.end() ||
+					to == eval.nodes_props.end())
 				{
-					icp_ad_params = new TGetICPEdgeAdParams;
-					// from_success = fillNodePropsFromGroupParams(
-					fillNodePropsFromGroupParams(
-						*b_it, ad_params->groupB_params,
-						&icp_ad_params->from_params);
-					// to_success = fillNodePropsFromGroupParams(
-					fillNodePropsFromGroupParams(
-						*a_it, ad_params->groupA_params,
-						&icp_ad_params->to_params);
-
-					// MRPT_LOG_DEBUG_STREAM(">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>");
-					// MRPT_LOG_DEBUG_STREAM("From nodeID (other): " << *b_it);
-					// MRPT_LOG_DEBUG_STREAM("From params (other): "
-					//<< icp_ad_params->from_params.getAsString());
-					// MRPT_LOG_DEBUG_STREAM("from_success: " << (from_success?
-					// "TRUE" : "FALSE"));
-					// MRPT_LOG_DEBUG_STREAM("**********");
-					// MRPT_LOG_DEBUG_STREAM("To nodeID (own)   : " << *a_it);
-					// MRPT_LOG_DEBUG_STREAM("To params (own)   : "
-					//<< icp_ad_params->to_params.getAsString());
-					// MRPT_LOG_DEBUG_STREAM("to_success: " << (to_success?
-					// "TRUE" : "FALSE"));
-					// MRPT_LOG_DEBUG_STREAM("<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<");
+					hypot.is_valid = false;
+					continue;
 				}
 
-				// fetch the ICP constraint bi => ai
-				mrpt::slam::CICP::TReturnInfo icp_info;
+				// fetch the ICP constraint bi => ai, with the initial
+				// estimation from the node poses, as in getICPEdge
+				const pose_t initial_estim =
+					to->second.pose - from->second.pose;
 				constraint_t edge;
-				bool found_edge = this->getICPEdge(
-					*b_it, *a_it, &edge, &icp_info, icp_ad_params);
-
-				hypot->setEdge(edge);
-				hypot->goodness =
-					icp_info.goodness;  // goodness related to the edge
-
-				// Check if invalid
-				//
-				// Goodness Threshold
-				double goodness_thresh =
-					m_laser_params.goodness_threshold_win.getMedian() *
-					m_lc_icp_constraint_factor;
-				bool accept_goodness = icp_info.goodness > goodness_thresh;
-				MRPT_LOG_DEBUG_STREAM(
-					"generateHypotsPool:\nCurr. Goodness: "
-					<< icp_info.goodness << "|\t Threshold: " << goodness_thresh
-					<< " => " << (accept_goodness ? "ACCEPT" : "REJECT")
-					<< endl);
-
-				if (!found_edge || !accept_goodness)
-				{
-					hypot->is_valid = false;
-					invalid_hypots++;
-				}
-				generated_hypots->push_back(hypot);
-				MRPT_LOG_DEBUG_STREAM(hypot->getAsString());
+				mrpt::slam::CICP::TReturnInfo icp_info;
+				range_ops_t::getICPEdge(
+					*from->second.scan, *to->second.scan, &edge,
+					&initial_estim, &icp_info);
 
-				// delete pointer to getICPEdge additional parameters if they
-				// were
-				// initialized
-				delete icp_ad_params;
+				hypot.setEdge(edge);
+				hypot.goodness = icp_info.goodness;
+				hypot.is_valid = icp_info.goodness > eval.goodness_thresh;
 			}
-		}
-		MRPT_LOG_DEBUG_STREAM(
-			"Generated pool of hypotheses...\tsize = "
-			<< generated_hypots->size()
-			<< "\tinvalid hypotheses: " << invalid_hypots);
-	}
-	// mrpt::system::pause();
+		});
 
 	MRPT_END;
 }  // end of generateHypotsPool
@@ -901,225 +922,122 @@ void CLoopCloserERD<GRAPH_T>::generateHypotsPool(
 template <class GRAPH_T>
 bool CLoopCloserERD<GRAPH_T>::computeDominantEigenVector(
 	const mrpt::math::CMatrixDouble& consist_matrix,
-	mrpt::math::dynamic_vector<double>* eigvec, bool use_power_method /*=true*/)
+	mrpt::math::dynamic_vector<double>* eigvec, double* lambda1,
+	double* lambda2) const
 {
 	MRPT_START;
 	using namespace mrpt;
 	using namespace mrpt::math;
-	using namespace std;
 	ASSERTDEB_(eigvec);
+	ASSERTDEB_(lambda1);
+	ASSERTDEB_(lambda2);
 
-	this->m_time_logger.enter("DominantEigenvectorComputation");
+	CMatrixDouble eigvecs, eigvals;
+	consist_matrix.eigenVectors(eigvecs, eigvals);
 
-	double lambda1, lambda2;  // eigenvalues to use
-	bool is_valid_lambda_ratio = false;
+	// assert that the eivenvectors, eigenvalues, consistency matrix are of the
+	// same size
+	ASSERTDEBMSG_(
+		eigvecs.size() == eigvals.size() &&
+			consist_matrix.size() == eigvals.size(),
+		mrpt::format(
+			"Size of eigvecs \"%lu\","
+			"eigvalues \"%lu\","
+			"consist_matrix \"%lu\" don't match",
+			static_cast<unsigned long>(eigvecs.size()),
+			static_cast<unsigned long>(eigvals.size()),
+			static_cast<unsigned long>(consist_matrix.size())));
 
-	if (use_power_method)
-	{
-		THROW_EXCEPTION(
-			"\nPower method for computing the first two "
-			"eigenvectors/eigenvalues hasn't been implemented yet\n");
-	}
-	else
-	{  // call to eigenVectors method
-		CMatrixDouble eigvecs, eigvals;
-		consist_matrix.eigenVectors(eigvecs, eigvals);
-
-		// assert that the eivenvectors, eigenvalues, consistency matrix are of
-		// the
-		// same size
-		ASSERTDEBMSG_(
-			eigvecs.size() == eigvals.size() &&
-				consist_matrix.size() == eigvals.size(),
-			mrpt::format(
-				"Size of eigvecs \"%lu\","
-				"eigvalues \"%lu\","
-				"consist_matrix \"%lu\" don't match",
-				static_cast<unsigned long>(eigvecs.size()),
-				static_cast<unsigned long>(eigvals.size()),
-				static_cast<unsigned long>(consist_matrix.size())));
-
-		eigvecs.extractCol(eigvecs.cols() - 1, *eigvec);
-		lambda1 = eigvals(eigvals.rows() - 1, eigvals.cols() - 1);
-		lambda2 = eigvals(eigvals.rows() - 2, eigvals.cols() - 2);
-	}
+	eigvecs.extractCol(eigvecs.cols() - 1, *eigvec);
+	*lambda1 = eigvals(eigvals.rows() - 1, eigvals.cols() - 1);
+	*lambda2 = eigvals(eigvals.rows() - 2, eigvals.cols() - 2);
 
 	// I don't care about the sign of the eigenvector element
 	for (int i = 0; i != eigvec->size(); ++i)
 	{
-		(*eigvec)(i) = abs((*eigvec)(i));
+		(*eigvec)(i) = std::abs((*eigvec)(i));
 	}
 
 	// check the ratio of the two eigenvalues - reject hypotheses set if ratio
 	// smaller than threshold
-	if (approximatelyEqual(0.0, lambda2, /**limit = */ 0.00001))
+	if (approximatelyEqual(0.0, *lambda2, /**limit = */ 0.00001))
 	{
-		MRPT_LOG_ERROR_STREAM(
-			"Bad lambda2 value: "
-			<< lambda2 << " => Skipping current evaluation." << endl);
 		return false;
 	}
-	double curr_lambda_ratio = lambda1 / lambda2;
-	MRPT_LOG_DEBUG_STREAM(
-		"lambda1 = " << lambda1 << " | lambda2 = " << lambda2
-					 << "| ratio = " << curr_lambda_ratio << endl);
-
-	is_valid_lambda_ratio =
-		(curr_lambda_ratio > m_lc_params.LC_eigenvalues_ratio_thresh);
-
-	this->m_time_logger.leave("DominantEigenvectorComputation");
-	return is_valid_lambda_ratio;
+	return *lambda1 / *lambda2 > m_lc_params.LC_eigenvalues_ratio_thresh;
 
 	MRPT_END;
 }  // end of computeDominantEigenVector
 
 template <class GRAPH_T>
 void CLoopCloserERD<GRAPH_T>::generatePWConsistenciesMatrix(
-	const std::vector<uint32_t>& groupA, const std::vector<uint32_t>& groupB,
-	const hypotsp_t& hypots_pool, mrpt::math::CMatrixDouble* consist_matrix,
-	const paths_t* groupA_opt_paths /*=NULL*/,
-	const paths_t* groupB_opt_paths /*=NULL*/)
+	const TLCEvaluation& eval, mrpt::WorkerThreadsPool& pool,
+	mrpt::math::CMatrixDouble* consist_matrix) const
 {
 	MRPT_START;
-
-	using namespace mrpt;
-	using namespace mrpt::math;
-	using namespace mrpt::containers;
-	using namespace std;
-	using mrpt::graphs::TNodeID;
-
+	const hypotsp_t& hypots_pool = eval.hypots_pool;
 	ASSERTDEBMSG_(
 		consist_matrix, "Invalid pointer to the Consistency matrix is given");
 	ASSERTDEBMSG_(
-		static_cast<unsigned long>(consist_matrix->rows()) ==
-				hypots_pool.size() &&
-			static_cast<unsigned long>(consist_matrix->rows()) ==
-				hypots_pool.size(),
+		static_cast<size_t>(consist_matrix->rows()) == hypots_pool.size() &&
+			static_cast<size_t>(consist_matrix->cols()) == hypots_pool.size(),
 		"Consistency matrix dimensions aren't equal to the hypotheses pool "
 		"size");
 
-	MRPT_LOG_DEBUG_STREAM(
-		">>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>"
-		<< endl
-		<< "In generatePWConsistencyMatrix:\n"
-		<< "\tgroupA: " << getSTLContainerAsString(groupA) << endl
-		<< "\tgroupB: " << getSTLContainerAsString(groupB) << endl
-		<< "\tHypots pool Size: " << hypots_pool.size());
-
-	// b1
-	for (std::vector<uint32_t>::const_iterator b1_it = groupB.begin();
-		 b1_it != groupB.end(); ++b1_it)
+	// list the elements of the matrix, then compute them in parallel
+	struct TConsistencyElement
 	{
-		TNodeID b1 = *b1_it;
-
-		// b2
-		for (std::vector<uint32_t>::const_iterator b2_it = b1_it + 1;
-			 b2_it != groupB.end(); ++b2_it)
+		const path_t *path_a1_a2, *path_b1_b2;
+		const hypot_t *hypot_b1_a2, *hypot_b2_a1;
+	};
+	std::vector<TConsistencyElement> elements;
+	const std::vector<uint32_t>&groupA = eval.groupA, &groupB = eval.groupB;
+	for (size_t b1 = 0; b1 < groupB.size(); b1++)
+	{
+		for (size_t b2 = b1 + 1; b2 < groupB.size(); b2++)
 		{
-			TNodeID b2 = *b2_it;
-
-			// a1
-			for (std::vector<uint32_t>::const_iterator a1_it = groupA.begin();
-				 a1_it != groupA.end(); ++a1_it)
+			for (size_t a1 = 0; a1 < groupA.size(); a1++)
 			{
-				TNodeID a1 = *a1_it;
-				hypot_t* hypot_b2_a1 =
-					this->findHypotByEnds(hypots_pool, b2, a1);
-				// MRPT_LOG_DEBUG_STREAM("hypot_b2_a1: " <<
-				// hypot_b2_a1->getAsString());
-
-				// a2
-				for (std::vector<uint32_t>::const_iterator a2_it = a1_it + 1;
-					 a2_it != groupA.end(); ++a2_it)
+				for (size_t a2 = a1 + 1; a2 < groupA.size(); a2++)
 				{
-					TNodeID a2 = *a2_it;
-					hypot_t* hypot_b1_a2 =
-						this->findHypotByEnds(hypots_pool, b1, a2);
-					// MRPT_LOG_DEBUG_STREAM("hypot_b1_a2: " <<
-					// hypot_b1_a2->getAsString());
-
-					double consistency;
-
-					// compute consistency element
-					if (hypot_b2_a1->is_valid && hypot_b1_a2->is_valid)
-					{
-						// extract vector of hypotheses that connect the given
-						// nodes,
-						// instead of passing the whole hypothesis pool.
-						hypotsp_t extracted_hypots;
-						extracted_hypots.push_back(hypot_b2_a1);
-						extracted_hypots.push_back(hypot_b1_a2);
-
-						paths_t* curr_opt_paths = NULL;
-						if (groupA_opt_paths || groupB_opt_paths)
-						{  // fill curr_opt_paths
-							curr_opt_paths = new paths_t();
-						}
-
-						// decide on additional optimal paths
-						if (curr_opt_paths)
-						{
-							// groupA
-							if (groupA_opt_paths)
-							{  // a1 -> a2 optimal path
-								const path_t* p = this->findPathByEnds(
-									*groupA_opt_paths, a1, a2,
-									/*throw_exc=*/true);
-								curr_opt_paths->push_back(*p);
-							}
-							else
-							{  // empty
-								curr_opt_paths->push_back(path_t());
-							}
-
-							if (groupB_opt_paths)
-							{  // b1 -> b2 optimal path
-								const path_t* p = this->findPathByEnds(
-									*groupB_opt_paths, b1, b2,
-									/*throw_exc=*/true);
-								curr_opt_paths->push_back(*p);
-							}
-							else
-							{  // empty
-								curr_opt_paths->push_back(path_t());
-							}
-						}
-
-						consistency = this->generatePWConsistencyElement(
-							a1, a2, b1, b2, extracted_hypots, curr_opt_paths);
-
-						delete curr_opt_paths;
-					}
-					else
-					{  //  null those that don't look good
-						consistency = 0;
-					}
-
-					// MRPT_LOG_DEBUG_STREAM(
-					//"Adding hypothesis consistency for nodeIDs: "
-					//<< "[b1] " << b1 << ", [b2] -> " << b2
-					//<< ", [a1] -> " << a1 << ", [a2] -> " << a2
-					//<< " ==> " << consistency << endl);
-
-					// fill the PW consistency matrix corresponding element -
-					// symmetrical
-					int id1 = hypot_b2_a1->id;
-					int id2 = hypot_b1_a2->id;
-
-					(*consist_matrix)(id1, id2) = consistency;
-					(*consist_matrix)(id2, id1) = consistency;
-
-					// MRPT_LOG_DEBUG_STREAM("id1 = " << id1 << "\t|"
-					//<< "id2 = " << id2 << "\t|"
-					//<< "consistency = " << consistency);
+					TConsistencyElement elem;
+					elem.path_a1_a2 = this->findPathByEnds(
+						eval.groupA_opt_paths, groupA[a1], groupA[a2]);
+					elem.path_b1_b2 = this->findPathByEnds(
+						eval.groupB_opt_paths, groupB[b1], groupB[b2]);
+					elem.hypot_b1_a2 = this->findHypotByEnds(
+						hypots_pool, groupB[b1], groupA[a2]);
+					elem.hypot_b2_a1 = this->findHypotByEnds(
+						hypots_pool, groupB[b2], groupA[a1]);
+					elements.push_back(elem);
 				}
 			}
 		}
 	}
 
-	// MRPT_LOG_WARN_STREAM("Consistency matrix:" << endl
-	//<< this->header_sep << endl
-	//<< *consist_matrix << endl);
+	const size_t num_threads = std::max<size_t>(1, pool.size());
+	pool.parallelForBlocks(
+		elements.size(), (elements.size() + num_threads - 1) / num_threads,
+		[&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				const TConsistencyElement& elem = elements[i];
+				//  null those that don't look good
+				double consistency = 0;
+				if (elem.hypot_b1_a2->is_valid && elem.hypot_b2_a1->is_valid)
+				{
+					consistency = computePWConsistency(
+						*elem.path_a1_a2, *elem.path_b1_b2, *elem.hypot_b1_a2,
+						*elem.hypot_b2_a1);
+				}
+				// fill the PW consistency matrix corresponding element -
+				// symmetrical; each pair of hypotheses shows up only once
+				const int id1 = elem.hypot_b2_a1->id;
+				const int id2 = elem.hypot_b1_a2->id;
+				(*consist_matrix)(id1, id2) = consistency;
+				(*consist_matrix)(id2, id1) = consistency;
+			}
+		});
 
 	MRPT_END;
 }  // end of generatePWConsistenciesMatrix
@@ -1178,7 +1096,7 @@ double CLoopCloserERD<GRAPH_T>::generatePWConsistencyElement(
 
 	// b1 ==> b2
 	const path_t* path_b1_b2;
-	if (!opt_paths || opt_paths->rend()->isEmpty())
+	if (!opt_paths || opt_paths->rbegin()->isEmpty())
 	{
 		MRPT_LOG_DEBUG_STREAM(
 			"Running djkstra [b1] " << b1 << " => [b2] " << b2);
@@ -1222,6 +1140,25 @@ double CLoopCloserERD<GRAPH_T>::generatePWConsistencyElement(
 		<< "hypot_b2_a1:\n"
 		<< hypot_b2_a1->getEdge() << endl);
 
+	return computePWConsistency(
+		*path_a1_a2, *path_b1_b2, *hypot_b1_a2, *hypot_b2_a1);
+	MRPT_END;
+}  // end of generatePWConsistencyElement
+
+template <class GRAPH_T>
+double CLoopCloserERD<GRAPH_T>::computePWConsistency(
+	const path_t& path_a1_a2, const path_t& path_b1_b2,
+	const hypot_t& hypot_b1_a2, const hypot_t& hypot_b2_a1)
+{
+	using namespace mrpt::math;
+
+	// Composition of Poses
+	// Order : a1 ==> a2 ==> b1 ==> b2 ==> a1
+	constraint_t res_transform(path_a1_a2.curr_pose_pdf);
+	res_transform += hypot_b1_a2.getInverseEdge();
+	res_transform += path_b1_b2.curr_pose_pdf;
+	res_transform += hypot_b2_a1.getEdge();
+
 	// get the vector of the corresponding transformation - [x, y, phi] form
 	dynamic_vector<double> T;
 	res_transform.getMeanVal().getAsVector(T);
@@ -1235,16 +1172,8 @@ double CLoopCloserERD<GRAPH_T>::generatePWConsistencyElement(
 	// of
 	// the information matrix.
 	double exponent = (-T.transpose() * cov_mat * T).value();
-	double consistency_elem = exp(exponent);
-
-	// cout << "T = " << endl << T << endl;
-	// cout << "exponent = " << exponent << endl;
-	// cout << "consistency_elem = " << consistency_elem << endl;
-	// mrpt::system::pause();
-
-	return consistency_elem;
-	MRPT_END;
-}  // end of generatePWConsistencyElement
+	return std::exp(exponent);
+}
 
 template <class GRAPH_T>
 const mrpt::graphslam::TUncertaintyPath<GRAPH_T>*
@@ -2384,6 +2313,12 @@ void CLoopCloserERD<GRAPH_T>::loadParams(const std::string& source_fname)
 		"EdgeRegistrationDeciderParameters", "lc_icp_constraint_factor", 0.70,
 		false);
 
+	m_lc_threads.clear();
+	if (m_lc_params.LC_num_threads != 1)
+	{
+		m_lc_threads.resize(m_lc_params.LC_num_threads);
+	}
+
 	// set the logging level if given by the user
 	int min_verbosity_level = source.read_int(
 		"EdgeRegistrationDeciderParameters", "class_verbosity", 1, false);
@@ -2605,7 +2540,9 @@ void CLoopCloserERD<GRAPH_T>::TLaserParams::loadFromConfigFile(
 
 template <class GRAPH_T>
 CLoopCloserERD<GRAPH_T>::TLoopClosureParams::TLoopClosureParams()
-	: keystroke_map_partitions("b"),
+	: LC_num_threads(1),
+	  LC_async_evaluation(false),
+	  keystroke_map_partitions("b"),
 	  balloon_elevation(3),
 	  balloon_radius(0.5),
 	  balloon_std_color(153, 0, 153),
@@ -2638,6 +2575,10 @@ void CLoopCloserERD<GRAPH_T>::TLoopClosureParams::dumpToTextStream(
 	   << (LC_check_curr_partition_only ? "TRUE" : "FALSE") << endl;
 	ss << "New registered nodes required for full partitioning   = "
 	   << full_partition_per_nodes << endl;
+	ss << "Threads for evaluating loop closure hypotheses        = "
+	   << LC_num_threads << endl;
+	ss << "Evaluate loop closure hypotheses in the background    = "
+	   << (LC_async_evaluation ? "TRUE" : "FALSE") << endl;
 	ss << "Visualize map partitions                              = "
 	   << (visualize_map_partitions ? "TRUE" : "FALSE") << endl;
 
@@ -2660,6 +2601,9 @@ void CLoopCloserERD<GRAPH_T>::TLoopClosureParams::loadFromConfigFile(
 		source.read_bool(section, "LC_check_curr_partition_only", true, false);
 	full_partition_per_nodes =
 		source.read_int(section, "full_partition_per_nodes", 50, false);
+	LC_num_threads = source.read_uint64_t(section, "LC_num_threads", 1, false);
+	LC_async_evaluation =
+		source.read_bool(section, "LC_async_evaluation", false, false);
 	visualize_map_partitions = source.read_bool(
 		"VisualizationParameters", "visualize_map_partitions", true, false);
 
@@ -0,0 +1,300 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#ifndef CINCREMENTALGSO_H
+#define CINCREMENTALGSO_H
+
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/aligned_std_map.h>
+#include <mrpt/core/aligned_std_vector.h>
+#include <mrpt/opengl/CRenderizable.h>
+
+#include <mrpt/graphslam/levmarq.h>
+#include <mrpt/graphslam/interfaces/CGraphSlamOptimizer.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace mrpt
+{
+namespace graphslam
+{
+namespace optimizers
+{
+/**\brief Incremental (iSAM-style) non-linear graph slam optimization scheme.
+ *
+ * ## Description
+ *
+ * Instead of re-optimizing the whole graph (or the nodes within a certain
+ * distance) every time a node or a loop closure is added, as CLevMarqGSO
+ * does, this optimizer keeps the Cholesky factor \f$ R \f$ of the
+ * information matrix of the linearized problem, \f$ H = R^T R \f$, and
+ * updates it incrementally:
+ *
+ * - Nodes are ordered in the same order they are added to the graph. New
+ *   constraints change \f$ H \f$ only from the oldest node they involve
+ *   onwards, so only that trailing part of \f$ R \f$ is refactored. For
+ *   odometry-like constraints between the latest nodes this takes constant
+ *   time; for a loop closure it takes time proportional to the length of the
+ *   loop.
+ * - Constraints are only relinearized when the estimate of one of their
+ *   nodes moves away from its linearization point more than \b
+ *   relinearize_threshold ("fluid relinearization").
+ * - The back-substitution \f$ R \delta = y \f$ only propagates to older nodes
+ *   while the change in the solution is larger than \b
+ *   backsubstitution_threshold, and only the nodes whose estimate changed are
+ *   written back to the graph.
+ *
+ * Each call to updateState() performs one Gauss-Newton step over the
+ * affected nodes, so the online cost per step does not grow with the
+ * length of the trajectory. The root node of the graph is kept fixed.
+ *
+ * Removing edges from the graph between updates is supported, but makes the
+ * optimizer start over. Edges must not be modified in place.
+ *
+ * ### .ini Configuration Parameters
+ *
+ * \htmlinclude graphslam-engine_config_params_preamble.txt
+ *
+ * - \b class_verbosity
+ *   + \a Section       : OptimizerParameters
+ *   + \a Default value : 1 (mrpt::system::LVL_INFO)
+ *   + \a Required      : FALSE
+ *
+ * - \b relinearize_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 0.05
+ *  + \a Required      : FALSE
+ *  + \a Description   : Nodes whose estimate moved more than this (maximum
+ *  absolute value of the manifold increment) from their linearization point
+ *  are relinearized, together with all their constraints.
+ *
+ * - \b backsubstitution_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1e-3
+ *  + \a Required      : FALSE
+ *  + \a Description   : The back-substitution stops at nodes whose solution
+ *  changes less than this. Set to 0 to always solve for all the nodes
+ *  connected to the updated ones.
+ *
+ *  \note For a detailed description of the graph visualization parameters
+ *  refer to CLevMarqGSO.
+ *
+ * \ingroup mrpt_graphslam_grp
+ */
+template <class GRAPH_T = typename mrpt::graphs::CNetworkOfPoses2DInf>
+class CIncrementalGSO
+	: public mrpt::graphslam::optimizers::CGraphSlamOptimizer<GRAPH_T>
+{
+   public:
+	/**\brief Handy typedefs */
+	/**\{*/
+	using constraint_t = typename GRAPH_T::constraint_t;
+	/** type of underlying poses (2D/3D)*/
+	using pose_t = typename GRAPH_T::constraint_t::type_value;
+	using gst = mrpt::graphslam::graphslam_traits<GRAPH_T>;
+	using matrix_VxV_t = typename gst::matrix_VxV_t;
+	using Array_O = typename gst::Array_O;
+	using parent = mrpt::graphslam::optimizers::CGraphSlamOptimizer<GRAPH_T>;
+	/**\}*/
+
+	CIncrementalGSO();
+	~CIncrementalGSO();
+
+	bool updateState(
+		mrpt::obs::CActionCollection::Ptr action,
+		mrpt::obs::CSensoryFrame::Ptr observations,
+		mrpt::obs::CObservation::Ptr observation);
+
+	void initializeVisuals();
+	void updateVisuals();
+	void notifyOfWindowEvents(
+		const std::map<std::string, bool>& events_occurred);
+
+	/**\brief Parameters of the incremental optimization */
+	struct OptimizationParams : public mrpt::config::CLoadableOptions
+	{
+	   public:
+		OptimizationParams();
+		~OptimizationParams();
+
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section);
+		void dumpToTextStream(std::ostream& out) const;
+
+		/** Max. abs. increment of a node before relinearizing it */
+		double relinearize_threshold;
+		/** Min. change in the solution of a node for the back-substitution
+		 * to go on with the nodes it depends on */
+		double backsubstitution_threshold;
+	};
+
+	/**\brief Parameters of the visualization of the optimized graph */
+	struct GraphVisualizationParams : public mrpt::config::CLoadableOptions
+	{
+	   public:
+		GraphVisualizationParams();
+		~GraphVisualizationParams();
+
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section);
+		void dumpToTextStream(std::ostream& out) const;
+
+		mrpt::system::TParametersDouble cfg;
+		bool visualize_optimized_graph;
+		std::string keystroke_graph_toggle;
+		std::string keystroke_graph_autofit;
+		int text_index_graph;
+		double offset_y_graph;
+	};
+
+	/**\brief Amount of work done in the last call to updateState() */
+	struct TLastUpdateStats
+	{
+		/** Number of nodes relinearized */
+		size_t num_relinearized{0};
+		/** Number of nodes (columns of R) refactored */
+		size_t num_refactored{0};
+		/** Number of nodes solved for in the back-substitution */
+		size_t num_solved{0};
+		/** Number of edges of the graph looked at */
+		size_t num_edges_visited{0};
+	};
+
+	void loadParams(const std::string& source_fname);
+	void printParams() const;
+	void getDescriptiveReport(std::string* report_str) const;
+
+	/** Work done in the last call to updateState() */
+	const TLastUpdateStats& getLastUpdateStats() const
+	{
+		return m_last_stats;
+	}
+	/** Discards the factorization, so it is built again from scratch from
+	 * the current graph in the next update */
+	void reset();
+
+	/** Parameters relevant to the optimization of the graph. */
+	OptimizationParams opt_params;
+	/** Parameters relevant to the visualization of the graph. */
+	GraphVisualizationParams viz_params;
+
+   protected:
+	/**\brief Locks the graph and runs one incremental update */
+	void optimizeGraph();
+	/**\brief Runs one incremental update: adds the new constraints,
+	 * relinearizes those nodes which moved away from their linearization
+	 * point, refactors the affected part of R and back-substitutes.
+	 */
+	void _optimizeGraph();
+
+	/** Node to be optimized, with its blocks of H and R, as the
+	 * column/row of them with the same index. */
+	struct TVariable
+	{
+		mrpt::graphs::TNodeID nodeID;
+		/** Linearization point of the node */
+		pose_t lin;
+		/** Current solution: the estimate is exp(-delta) (+) lin */
+		Array_O delta;
+		/** Blocks of the gradient (J^t * Inf * err) and of R^-t * grad */
+		Array_O grad, y;
+		/** Diagonal blocks of H and R */
+		matrix_VxV_t H_diag, R_diag;
+		/** Blocks above the diagonal in this column of H and R, by row */
+		mrpt::aligned_std_map<size_t, matrix_VxV_t> H_col, R_col;
+		/** Columns (sorted) with blocks in this row of R */
+		std::vector<size_t> R_row;
+		/** Indices of the factors involving this node */
+		std::vector<size_t> factors;
+	};
+	/** Each edge, with the jacobians and error at the linearization point of
+	 * its nodes */
+	struct TFactor
+	{
+		typename gst::edge_const_iterator edge;
+		/** Indices of the nodes in m_vars, or INVALID_VAR for the root */
+		size_t var1, var2;
+		typename gst::TPairJacobs jacobs;
+		Array_O err;
+	};
+	static constexpr size_t INVALID_VAR = static_cast<size_t>(-1);
+
+	/** Adds factors for the given edges not seen before, and variables for
+	 * their nodes. Those edges with nodes not in the graph yet are kept in
+	 * m_pending_edges. \return The lowest index of a variable whose blocks
+	 * in H changed. */
+	size_t addNewFactors(
+		const std::vector<typename gst::edge_const_iterator>& edges);
+	/** Moves the linearization point to the current estimate of those
+	 * nodes which moved more than relinearize_threshold, relinearizing
+	 * their factors. \return The lowest index of a relinearized node. */
+	size_t relinearize();
+	/** Computes jacobians and error of a factor at the current linearization
+	 * point of its nodes */
+	void linearizeFactor(TFactor& f);
+	/** Adds (sign=1) or removes (sign=-1) a factor to/from H and grad */
+	void accumulateFactor(const TFactor& f, double sign);
+	/** Recomputes columns [first, N) of R and the blocks of y */
+	void refactorFrom(size_t first);
+	/** Solves R*delta=y for the nodes from the last one down to "first",
+	 * and then for those older nodes depending on nodes whose solution
+	 * changed. */
+	void backSubstitute(size_t first);
+	/** Recomputes the solution of one node from the newer ones.
+	 * \return The max abs change in its solution. */
+	double solveVariable(size_t i);
+	/** Current estimate of a node */
+	pose_t getEstimate(const TVariable& v) const;
+
+	/**\brief Initialize objects related to the Graph Visualization */
+	void initGraphVisualization();
+	/**\brief Update the visualization of the optimized graph */
+	void updateGraphVisualization();
+	/**\brief Toggle the graph visualization on and off */
+	void toggleGraphVisualization();
+	/**\brief Fit the whole graph in the view of the CDisplayWindow3D */
+	void fitGraphInView();
+
+	mrpt::aligned_std_vector<TVariable> m_vars;
+	mrpt::aligned_std_vector<TFactor> m_factors;
+	/** Edges of the graph already in m_factors */
+	std::unordered_set<const constraint_t*> m_known_edges;
+	/** New edges whose nodes are not in the graph yet, by address */
+	std::vector<
+		std::pair<const constraint_t*, typename gst::edge_const_iterator>>
+		m_pending_edges;
+	/** Position in the log of changes of the edges of the graph, which
+	 * tells the new and erased edges without looking at all of them */
+	typename GRAPH_T::TEdgeLogPosition m_edge_log_pos;
+	std::map<mrpt::graphs::TNodeID, size_t> m_node_to_var;
+	/** Fixed pose of the root of the graph */
+	pose_t m_root_pose;
+	/** Nodes solved for in the last back-substitution, the only ones which
+	 * may need to be relinearized */
+	std::vector<size_t> m_last_solved;
+
+	TLastUpdateStats m_last_stats;
+	bool m_has_read_config;
+	bool m_autozoom_active;
+};
+}  // namespace optimizers
+}  // namespace graphslam
+}  // namespace mrpt
+
+#include "CIncrementalGSO_impl.h"
+
+#endif /* end of include guard: CINCREMENTALGSO_H */
@@ -0,0 +1,785 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#ifndef CINCREMENTALGSO_IMPL_H
+#define CINCREMENTALGSO_IMPL_H
+
+#include <mrpt/config/CConfigFile.h>
+#include <algorithm>
+#include <iterator>
+
+namespace mrpt
+{
+namespace graphslam
+{
+namespace optimizers
+{
+// Ctors, Dtors
+//////////////////////////////////////////////////////////////
+
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::CIncrementalGSO()
+	: m_has_read_config(false), m_autozoom_active(true)
+{
+	MRPT_START;
+	this->initializeLoggers("CIncrementalGSO");
+	MRPT_END;
+}
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::~CIncrementalGSO()
+{
+}
+
+// Member function implementations
+//////////////////////////////////////////////////////////////
+template <class GRAPH_T>
+bool CIncrementalGSO<GRAPH_T>::updateState(
+	mrpt::obs::CActionCollection::Ptr action,
+	mrpt::obs::CSensoryFrame::Ptr observations,
+	mrpt::obs::CObservation::Ptr observation)
+{
+	MRPT_START;
+	MRPT_LOG_DEBUG("In updateOptimizerState... ");
+
+	// The caller already holds the lock of the graph:
+	this->_optimizeGraph();
+	return true;
+
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::reset()
+{
+	m_vars.clear();
+	m_factors.clear();
+	m_known_edges.clear();
+	m_pending_edges.clear();
+	m_edge_log_pos = typename GRAPH_T::TEdgeLogPosition();
+	m_node_to_var.clear();
+	m_last_solved.clear();
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::optimizeGraph()
+{
+	MRPT_START;
+	std::lock_guard<std::mutex> graph_lock(*this->m_graph_section);
+	this->_optimizeGraph();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::_optimizeGraph()
+{
+	MRPT_START;
+	ASSERTDEB_(this->m_graph);
+	this->m_time_logger.enter("CIncrementalGSO::_optimizeGraph");
+
+	m_last_stats = TLastUpdateStats();
+
+	// Edges inserted and erased since the last update, from the log of the
+	// graph, so the cost does not grow with the number of edges:
+	GRAPH_T& graph = *this->m_graph;
+	graph.enableEdgeChangeLog();
+	typename GRAPH_T::TEdgeChanges changes;
+	bool rebuild = !graph.getEdgeChangesSince(m_edge_log_pos, changes);
+	for (const auto& e : changes.erased)
+	{
+		m_last_stats.num_edges_visited++;
+		if (m_known_edges.count(e.edge)) rebuild = true;
+		m_pending_edges.erase(
+			std::remove_if(
+				m_pending_edges.begin(), m_pending_edges.end(),
+				[&](const auto& p) { return p.first == e.edge; }),
+			m_pending_edges.end());
+	}
+
+	std::vector<typename gst::edge_const_iterator> new_edges;
+	if (rebuild)
+	{
+		// Edges of a factor were removed, or the changes are unknown: start
+		// all over again.
+		if (!m_known_edges.empty() || !m_pending_edges.empty())
+		{
+			MRPT_LOG_WARN("Edges were removed from the graph. Resetting.");
+			reset();
+			graph.getEdgeChangesSince(m_edge_log_pos, changes);
+		}
+		for (auto it = graph.edges.cbegin(); it != graph.edges.cend(); ++it)
+			new_edges.push_back(it);
+	}
+	else
+	{
+		for (const auto& p : m_pending_edges) new_edges.push_back(p.second);
+		m_pending_edges.clear();
+		new_edges.insert(
+			new_edges.end(), changes.inserted.begin(), changes.inserted.end());
+	}
+	m_last_stats.num_edges_visited += new_edges.size();
+
+	// Lowest index of a node whose blocks of H or grad changed. The
+	// factorization (and the solution) of older nodes is still valid.
+	size_t first = this->relinearize();
+	first = std::min(first, this->addNewFactors(new_edges));
+
+	if (first < m_vars.size())
+	{
+		this->refactorFrom(first);
+		this->backSubstitute(first);
+
+		// Keep the annotations of the nodes, just update their poses:
+		for (const size_t i : m_last_solved)
+			static_cast<pose_t&>(this->m_graph->nodes[m_vars[i].nodeID]) =
+				getEstimate(m_vars[i]);
+	}
+	else
+		m_last_solved.clear();
+
+	MRPT_LOG_DEBUG_FMT(
+		"Relinearized: %u nodes, refactored: %u, solved: %u, edges "
+		"visited: %u",
+		static_cast<unsigned int>(m_last_stats.num_relinearized),
+		static_cast<unsigned int>(m_last_stats.num_refactored),
+		static_cast<unsigned int>(m_last_stats.num_solved),
+		static_cast<unsigned int>(m_last_stats.num_edges_visited));
+
+	this->m_time_logger.leave("CIncrementalGSO::_optimizeGraph");
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+size_t CIncrementalGSO<GRAPH_T>::addNewFactors(
+	const std::vector<typename gst::edge_const_iterator>& edges)
+{
+	MRPT_START;
+	using mrpt::graphs::TNodeID;
+
+	GRAPH_T& graph = *this->m_graph;
+	if (edges.empty()) return m_vars.size();
+
+	if (m_known_edges.empty())
+	{
+		const auto it_root = graph.nodes.find(graph.root);
+		m_root_pose = it_root != graph.nodes.end() ? pose_t(it_root->second)
+												   : pose_t();
+	}
+
+	// Edges not seen before, between nodes with an initial guess:
+	std::vector<typename gst::edge_const_iterator> new_edges;
+	for (const auto& it : edges)
+	{
+		if (m_known_edges.count(&it->second)) continue;
+		if (!graph.nodes.count(it->first.first) ||
+			!graph.nodes.count(it->first.second))
+		{
+			// Try again once both nodes are in the graph
+			m_pending_edges.emplace_back(&it->second, it);
+			continue;
+		}
+		new_edges.push_back(it);
+	}
+
+	// Initial guess of the new nodes: compose the current estimate of a
+	// connected node with the edge, falling back to the graph:
+	std::map<TNodeID, pose_t> new_nodes;
+	auto known_pose = [&](TNodeID id, pose_t& p) {
+		if (id == graph.root)
+		{
+			p = m_root_pose;
+			return true;
+		}
+		const auto it_var = m_node_to_var.find(id);
+		if (it_var != m_node_to_var.end())
+		{
+			p = getEstimate(m_vars[it_var->second]);
+			return true;
+		}
+		const auto it_new = new_nodes.find(id);
+		if (it_new != new_nodes.end())
+		{
+			p = it_new->second;
+			return true;
+		}
+		return false;
+	};
+	for (bool progress = true; progress;)
+	{
+		progress = false;
+		for (const auto& it : new_edges)
+		{
+			const TNodeID from = it->first.first, to = it->first.second;
+			const auto& mean = it->second.getPoseMean();
+			pose_t p_from, p_to;
+			const bool known_from = known_pose(from, p_from);
+			const bool known_to = known_pose(to, p_to);
+			if (known_from == known_to) continue;
+			if (known_from)
+				new_nodes[to] = p_from + mean;
+			else
+				new_nodes[from] = p_to + (-mean);
+			progress = true;
+		}
+	}
+	for (const auto& it : new_edges)
+		for (const TNodeID id : {it->first.first, it->first.second})
+		{
+			pose_t p;
+			if (!known_pose(id, p)) new_nodes[id] = graph.nodes[id];
+		}
+
+	// New nodes are appended in increasing ID order:
+	for (const auto& n : new_nodes)
+	{
+		m_node_to_var[n.first] = m_vars.size();
+		m_vars.resize(m_vars.size() + 1);
+		TVariable& v = m_vars.back();
+		v.nodeID = n.first;
+		v.lin = n.second;
+		v.delta.setZero();
+		v.grad.setZero();
+		v.y.setZero();
+	}
+
+	size_t first = m_vars.size();
+	auto var_of = [&](TNodeID id) {
+		return id == graph.root ? INVALID_VAR : m_node_to_var[id];
+	};
+	for (const auto& it : new_edges)
+	{
+		m_known_edges.insert(&it->second);
+
+		TFactor f;
+		f.edge = it;
+		f.var1 = var_of(it->first.first);
+		f.var2 = var_of(it->first.second);
+		if (f.var1 == f.var2) continue;  // Useless edge
+
+		linearizeFactor(f);
+		accumulateFactor(f, 1.0);
+
+		for (const size_t i : {f.var1, f.var2})
+			if (i != INVALID_VAR)
+			{
+				m_vars[i].factors.push_back(m_factors.size());
+				mrpt::keep_min(first, i);
+			}
+		m_factors.push_back(f);
+	}
+	return first;
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+size_t CIncrementalGSO<GRAPH_T>::relinearize()
+{
+	MRPT_START;
+	// Only the nodes solved for in the last update may have moved:
+	std::set<size_t> factors;
+	size_t first = m_vars.size();
+	for (const size_t i : m_last_solved)
+	{
+		TVariable& v = m_vars[i];
+		if (v.delta.template lpNorm<Eigen::Infinity>() <=
+			opt_params.relinearize_threshold)
+			continue;
+
+		v.lin = getEstimate(v);
+		v.delta.setZero();
+		factors.insert(v.factors.begin(), v.factors.end());
+		m_last_stats.num_relinearized++;
+	}
+
+	for (const size_t k : factors)
+	{
+		TFactor& f = m_factors[k];
+		accumulateFactor(f, -1.0);
+		linearizeFactor(f);
+		accumulateFactor(f, 1.0);
+		for (const size_t i : {f.var1, f.var2})
+			if (i != INVALID_VAR) mrpt::keep_min(first, i);
+	}
+	return first;
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::linearizeFactor(TFactor& f)
+{
+	typename gst::observation_info_t obs;
+	obs.edge = f.edge;
+	obs.edge_mean = &f.edge->second.getPoseMean();
+	obs.P1 = f.var1 == INVALID_VAR ? &m_root_pose : &m_vars[f.var1].lin;
+	obs.P2 = f.var2 == INVALID_VAR ? &m_root_pose : &m_vars[f.var2].lin;
+	detail::computeJacobianAndError<GRAPH_T>(obs, f.jacobs, f.err);
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::accumulateFactor(const TFactor& f, double sign)
+{
+	using aux_eval_t = detail::AuxErrorEval<typename gst::edge_t, gst>;
+
+	matrix_VxV_t JtJ(mrpt::math::UNINITIALIZED_MATRIX);
+	Array_O g;
+	const size_t vars[2] = {f.var1, f.var2};
+	const matrix_VxV_t* Js[2] = {&f.jacobs.first, &f.jacobs.second};
+	for (int k = 0; k < 2; k++)
+	{
+		if (vars[k] == INVALID_VAR) continue;
+		TVariable& v = m_vars[vars[k]];
+		aux_eval_t::multiplyJtLambdaJ(*Js[k], JtJ, f.edge);
+		v.H_diag += sign * JtJ;
+		g.setZero();
+		aux_eval_t::multiply_Jt_W_err(*Js[k], f.edge, f.err, g);
+		v.grad += sign * g;
+	}
+	if (f.var1 == INVALID_VAR || f.var2 == INVALID_VAR) return;
+
+	// Only the block above the diagonal, H_{min,max}, is stored:
+	const int lo = f.var1 < f.var2 ? 0 : 1, hi = 1 - lo;
+	aux_eval_t::multiplyJ1tLambdaJ2(*Js[lo], *Js[hi], JtJ, f.edge);
+	m_vars[vars[hi]].H_col[vars[lo]] += sign * JtJ;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::refactorFrom(size_t first)
+{
+	MRPT_START;
+	const size_t N = m_vars.size();
+	m_last_stats.num_refactored = N - first;
+
+	// Rows of R older than "first" do not depend on the changes in H, so
+	// they are kept, even in the columns being recomputed:
+	for (size_t i = first; i < N; i++)
+	{
+		TVariable& v = m_vars[i];
+		v.R_col.erase(v.R_col.lower_bound(first), v.R_col.end());
+		v.R_row.clear();
+	}
+
+	// Left-looking block Cholesky, H = R^t * R. Each column of R above the
+	// diagonal is found by solving R^t * x = H_{:,j} with the sparse rows of
+	// R already computed.
+	mrpt::aligned_std_map<size_t, matrix_VxV_t> x;
+	for (size_t j = first; j < N; j++)
+	{
+		TVariable& vj = m_vars[j];
+		x.clear();
+		x.insert(vj.R_col.begin(), vj.R_col.end());
+		for (const auto& h : vj.H_col)
+			if (h.first >= first) x[h.first] += h.second;
+
+		for (auto it = x.begin(); it != x.end(); ++it)
+		{
+			const size_t i = it->first;
+			const TVariable& vi = m_vars[i];
+			if (i >= first)
+				vi.R_diag.transpose()
+					.template triangularView<Eigen::Lower>()
+					.solveInPlace(it->second);
+			for (auto k = std::lower_bound(
+					 vi.R_row.begin(), vi.R_row.end(), first);
+				 k != vi.R_row.end() && *k < j; ++k)
+				x[*k] -= m_vars[*k].R_col.find(i)->second.transpose() *
+						 it->second;
+		}
+
+		matrix_VxV_t S = vj.H_diag;
+		for (const auto& r : x)
+		{
+			S -= r.second.transpose() * r.second;
+			if (r.first < first) continue;
+			vj.R_col[r.first] = r.second;
+			m_vars[r.first].R_row.push_back(j);
+		}
+		Eigen::LLT<typename matrix_VxV_t::Base> llt(S);
+		if (llt.info() != Eigen::Success)
+			THROW_EXCEPTION_FMT(
+				"Information matrix not positive definite at node #%u. Is it "
+				"connected to the root of the graph?",
+				static_cast<unsigned int>(vj.nodeID));
+		vj.R_diag = llt.matrixU().toDenseMatrix();
+
+		// y = R^-t * grad, by forward substitution:
+		Array_O y = vj.grad;
+		for (const auto& r : vj.R_col)
+			y -= r.second.transpose() * m_vars[r.first].y;
+		vj.R_diag.transpose()
+			.template triangularView<Eigen::Lower>()
+			.solveInPlace(y);
+		vj.y = y;
+	}
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+double CIncrementalGSO<GRAPH_T>::solveVariable(size_t i)
+{
+	TVariable& v = m_vars[i];
+	Array_O d = v.y;
+	for (const size_t j : v.R_row)
+		d -= m_vars[j].R_col.find(i)->second * m_vars[j].delta;
+	v.R_diag.template triangularView<Eigen::Upper>().solveInPlace(d);
+
+	const double change = (d - v.delta).template lpNorm<Eigen::Infinity>();
+	v.delta = d;
+	m_last_solved.push_back(i);
+	return change;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::backSubstitute(size_t first)
+{
+	MRPT_START;
+	m_last_solved.clear();
+
+	// Older nodes to be solved for since they depend on nodes whose solution
+	// changed significantly, processed from the newest one:
+	std::set<size_t> pending;
+	auto solve = [&](size_t i) {
+		if (solveVariable(i) <= opt_params.backsubstitution_threshold) return;
+		for (const auto& r : m_vars[i].R_col)
+			if (r.first < first) pending.insert(r.first);
+	};
+
+	for (size_t i = m_vars.size(); i-- > first;) solve(i);
+	while (!pending.empty())
+	{
+		const auto it = std::prev(pending.end());
+		const size_t i = *it;
+		pending.erase(it);
+		solve(i);
+	}
+	m_last_stats.num_solved = m_last_solved.size();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+typename CIncrementalGSO<GRAPH_T>::pose_t CIncrementalGSO<GRAPH_T>::getEstimate(
+	const TVariable& v) const
+{
+	// Same convention than optimize_graph_spa_levmarq():
+	//  x = exp(-delta) (+) x_lin
+	const Array_O minus_delta(-v.delta);
+	pose_t exp_delta(mrpt::poses::UNINITIALIZED_POSE);
+	gst::SE_TYPE::exp(minus_delta, exp_delta);
+	pose_t p(mrpt::poses::UNINITIALIZED_POSE);
+	p.composeFrom(exp_delta, v.lin);
+	return p;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::initializeVisuals()
+{
+	MRPT_START;
+	ASSERTDEB_(m_has_read_config);
+	parent::initializeVisuals();
+
+	this->initGraphVisualization();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::updateVisuals()
+{
+	MRPT_START;
+	parent::updateVisuals();
+
+	if (viz_params.visualize_optimized_graph) this->updateGraphVisualization();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::notifyOfWindowEvents(
+	const std::map<std::string, bool>& events_occurred)
+{
+	MRPT_START;
+	parent::notifyOfWindowEvents(events_occurred);
+	if (!viz_params.visualize_optimized_graph) return;
+
+	if (events_occurred.find(viz_params.keystroke_graph_toggle)->second)
+		this->toggleGraphVisualization();
+
+	// if mouse event, let the user decide about the camera
+	if (events_occurred.find("mouse_clicked")->second)
+	{
+		MRPT_LOG_DEBUG_STREAM("Mouse was clicked. Disabling autozoom.");
+		m_autozoom_active = false;
+	}
+
+	if (events_occurred.find(viz_params.keystroke_graph_autofit)->second)
+		this->fitGraphInView();
+
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::initGraphVisualization()
+{
+	MRPT_START;
+	ASSERTDEBMSG_(this->m_win_manager, "No CWindowManager* is given");
+
+	if (viz_params.visualize_optimized_graph)
+	{
+		this->m_win_observer->registerKeystroke(
+			viz_params.keystroke_graph_toggle, "Toggle Graph visualization");
+		this->m_win_observer->registerKeystroke(
+			viz_params.keystroke_graph_autofit, "Fit Graph in view");
+
+		this->m_win_manager->assignTextMessageParameters(
+			/* offset_y*	= */ &viz_params.offset_y_graph,
+			/* text_index* = */ &viz_params.text_index_graph);
+	}
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::updateGraphVisualization()
+{
+	MRPT_START;
+	ASSERTDEBMSG_(this->m_win_manager, "No CWindowManager* is given");
+	using namespace mrpt::opengl;
+
+	COpenGLScene::Ptr& scene = this->m_win->get3DSceneAndLock();
+
+	// remove previous graph and insert the new instance
+	CRenderizable::Ptr prev_object = scene->getByName("optimized_graph");
+	bool prev_visibility = true;
+	if (prev_object) prev_visibility = prev_object->isVisible();
+	scene->removeObject(prev_object);
+
+	CSetOfObjects::Ptr graph_obj = mrpt::make_aligned_shared<CSetOfObjects>();
+	this->m_graph->getAs3DObject(graph_obj, viz_params.cfg);
+	graph_obj->setName("optimized_graph");
+	graph_obj->setVisibility(prev_visibility);
+	scene->insert(graph_obj);
+	this->m_win->unlockAccess3DScene();
+
+	this->m_win_manager->addTextMessage(
+		5, -viz_params.offset_y_graph,
+		format(
+			"Optimized Graph: #nodes %d",
+			static_cast<int>(this->m_graph->nodeCount())),
+		mrpt::img::TColorf(0.0, 0.0, 0.0),
+		/* unique_index = */ viz_params.text_index_graph);
+
+	this->m_win->forceRepaint();
+
+	if (m_autozoom_active) this->fitGraphInView();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::toggleGraphVisualization()
+{
+	MRPT_START;
+	using namespace mrpt::opengl;
+
+	COpenGLScene::Ptr& scene = this->m_win->get3DSceneAndLock();
+	CRenderizable::Ptr graph_obj = scene->getByName("optimized_graph");
+	if (graph_obj) graph_obj->setVisibility(!graph_obj->isVisible());
+	this->m_win->unlockAccess3DScene();
+	this->m_win->forceRepaint();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::fitGraphInView()
+{
+	MRPT_START;
+	using namespace mrpt::opengl;
+
+	COpenGLScene::Ptr& scene = this->m_win->get3DSceneAndLock();
+	CSetOfObjects::Ptr graph_obj = std::dynamic_pointer_cast<CSetOfObjects>(
+		scene->getByName("optimized_graph"));
+	this->m_win->unlockAccess3DScene();
+	if (!graph_obj) return;
+
+	// autofit it based on its grid
+	CGridPlaneXY::Ptr obj_grid =
+		graph_obj->CSetOfObjects::getByClass<CGridPlaneXY>();
+	if (obj_grid)
+	{
+		float x_min, x_max, y_min, y_max;
+		obj_grid->getPlaneLimits(x_min, x_max, y_min, y_max);
+		const float z_min = obj_grid->getPlaneZcoord();
+		this->m_win->setCameraPointingToPoint(
+			0.5 * (x_min + x_max), 0.5 * (y_min + y_max), z_min);
+		this->m_win->setCameraZoom(
+			2.0f * std::max(10.0f, std::max(x_max - x_min, y_max - y_min)));
+	}
+	this->m_win->setCameraAzimuthDeg(60);
+	this->m_win->setCameraElevationDeg(75);
+	this->m_win->setCameraProjective(true);
+	this->m_win->forceRepaint();
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::printParams() const
+{
+	parent::printParams();
+
+	opt_params.dumpToConsole();
+	viz_params.dumpToConsole();
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::loadParams(const std::string& source_fname)
+{
+	MRPT_START;
+	parent::loadParams(source_fname);
+
+	opt_params.loadFromConfigFileName(source_fname, "OptimizerParameters");
+	viz_params.loadFromConfigFileName(source_fname, "VisualizationParameters");
+
+	mrpt::config::CConfigFile source(source_fname);
+	int min_verbosity_level =
+		source.read_int("OptimizerParameters", "class_verbosity", 1, false);
+	this->setMinLoggingLevel(mrpt::system::VerbosityLevel(min_verbosity_level));
+
+	MRPT_LOG_DEBUG("Successfully loaded Params. ");
+	m_has_read_config = true;
+	MRPT_END;
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::getDescriptiveReport(
+	std::string* report_str) const
+{
+	MRPT_START;
+	using namespace std;
+
+	const std::string report_sep(2, '\n');
+	const std::string header_sep(80, '#');
+
+	stringstream class_props_ss;
+	class_props_ss << "Incremental Optimization Summary: " << std::endl;
+	class_props_ss << header_sep << std::endl;
+	class_props_ss << "Nodes: " << m_vars.size()
+				   << ", constraints: " << m_factors.size() << std::endl;
+
+	const std::string time_res = this->m_time_logger.getStatsAsText();
+	const std::string output_res = this->getLogAsString();
+
+	report_str->clear();
+	parent::getDescriptiveReport(report_str);
+
+	*report_str += class_props_ss.str();
+	*report_str += report_sep;
+
+	*report_str += time_res;
+	*report_str += report_sep;
+
+	*report_str += output_res;
+	*report_str += report_sep;
+
+	MRPT_END;
+}
+
+// OptimizationParams
+//////////////////////////////////////////////////////////////
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::OptimizationParams::OptimizationParams()
+	: relinearize_threshold(0.05), backsubstitution_threshold(1e-3)
+{
+}
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::OptimizationParams::~OptimizationParams()
+{
+}
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::OptimizationParams::dumpToTextStream(
+	std::ostream& out) const
+{
+	MRPT_START;
+	out << "-----------[ Incremental Optimization ] -------\n";
+	out << "Relinearization threshold      = " << relinearize_threshold
+		<< "\n";
+	out << "Back-substitution threshold    = " << backsubstitution_threshold
+		<< "\n";
+	MRPT_END;
+}
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::OptimizationParams::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_START;
+	MRPT_LOAD_CONFIG_VAR(relinearize_threshold, double, source, section);
+	MRPT_LOAD_CONFIG_VAR(backsubstitution_threshold, double, source, section);
+	MRPT_END;
+}
+
+// GraphVisualizationParams
+//////////////////////////////////////////////////////////////
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::GraphVisualizationParams::GraphVisualizationParams()
+	: visualize_optimized_graph(true),
+	  keystroke_graph_toggle("s"),
+	  keystroke_graph_autofit("a")
+{
+}
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::GraphVisualizationParams::~GraphVisualizationParams()
+{
+}
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::GraphVisualizationParams::dumpToTextStream(
+	std::ostream& out) const
+{
+	MRPT_START;
+	out << mrpt::format(
+		"-----------[ Graph Visualization Parameters ]-----------\n");
+	out << mrpt::format(
+		"Visualize optimized graph = %s\n",
+		visualize_optimized_graph ? "TRUE" : "FALSE");
+	out << mrpt::format("%s", cfg.getAsString().c_str());
+	MRPT_END;
+}
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::GraphVisualizationParams::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& source, const std::string& section)
+{
+	MRPT_START;
+
+	visualize_optimized_graph =
+		source.read_bool(section, "visualize_optimized_graph", 1, false);
+
+	cfg["show_ID_labels"] =
+		source.read_bool(section, "optimized_show_ID_labels", 0, false);
+	cfg["show_ground_grid"] =
+		source.read_double(section, "optimized_show_ground_grid", 1, false);
+	cfg["show_edges"] =
+		source.read_bool(section, "optimized_show_edges", 1, false);
+	cfg["edge_color"] =
+		source.read_int(section, "optimized_edge_color", 4286611456, false);
+	cfg["edge_width"] =
+		source.read_double(section, "optimized_edge_width", 1.5, false);
+	cfg["show_node_corners"] =
+		source.read_bool(section, "optimized_show_node_corners", 1, false);
+	cfg["show_edge_rel_poses"] =
+		source.read_bool(section, "optimized_show_edge_rel_poses", 1, false);
+	cfg["edge_rel_poses_color"] = source.read_int(
+		section, "optimized_edge_rel_poses_color", 1090486272, false);
+	cfg["nodes_edges_corner_scale"] = source.read_double(
+		section, "optimized_nodes_edges_corner_scale", 0.4, false);
+	cfg["nodes_corner_scale"] =
+		source.read_double(section, "optimized_nodes_corner_scale", 0.7, false);
+	cfg["nodes_point_size"] =
+		source.read_int(section, "optimized_nodes_point_size", 5, false);
+	cfg["nodes_point_color"] = source.read_int(
+		section, "optimized_nodes_point_color", 10526880, false);
+
+	MRPT_END;
+}
+}  // namespace optimizers
+}  // namespace graphslam
+}  // namespace mrpt
+
+#endif /* end of include guard: CINCREMENTALGSO_IMPL_H */
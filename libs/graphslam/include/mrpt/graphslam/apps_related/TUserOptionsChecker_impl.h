@@ -64,6 +64,8 @@ void TUserOptionsChecker<GRAPH_t>::createDeciderOptimizerMappings()
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
 	optimizers_map["CEmptyGSO"] =
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
+	optimizers_map["CIncrementalGSO"] =
+		&createGraphSlamOptimizer<CIncrementalGSO<GRAPH_t>>;
 
 	// create the decider optimizer, specific to the GRAPH_T template type
 	this->_createDeciderOptimizerMappings();
@@ -428,6 +430,19 @@ void TUserOptionsChecker<GRAPH_t>::populateDeciderOptimizerProperties()
 		optimizers_descriptions.push_back(opt);
 	}
 
+	{  // CIncrementalGSO
+		TOptimizerProps* opt = new TOptimizerProps;
+		opt->name = "CIncrementalGSO";
+		opt->description =
+			"Incremental (iSAM-style) non-linear graphSLAM solver, with "
+			"constant cost per step";
+		opt->is_mr_slam_class = false;
+		opt->is_slam_2d = true;
+		opt->is_slam_3d = true;
+
+		optimizers_descriptions.push_back(opt);
+	}
+
 	MRPT_END
 }
 }
@@ -63,6 +63,14 @@ namespace graphslam
  *		- "e2": (default=1e-6) Lev-marq algorithm iteration stopping criterion
  *#2:
  *|delta_incr| < e2*(x_norm+e2)
+ *		- "num_threads": (default=1) Number of threads used to linearize the
+ *constraints and build the Hessian and gradient (0: as many as CPU cores).
+ *Results do not depend on the number of threads.
+ *
+ * The sparse structure of the Hessian is built once, and its values are
+ *updated in place in each iteration. The symbolic analysis of its sparse
+ *Cholesky factorization (see mrpt::math::CSparseMatrix::CholeskyDecomp) is
+ *also done only once.
  *
  * \note The following graph types are supported:
  *mrpt::graphs::CNetworkOfPoses2D, mrpt::graphs::CNetworkOfPoses3D,
@@ -118,6 +126,12 @@ void optimize_graph_spa_levmarq(
 
 	const double SCALE_HESSIAN =
 		extra_params.getWithDefaultVal("scale_hessian", 1);
+	const size_t num_threads = static_cast<size_t>(
+		extra_params.getWithDefaultVal("num_threads", 1));
+
+	// With 1 thread, everything runs in this one:
+	mrpt::WorkerThreadsPool pool;
+	if (num_threads != 1) pool.resize(num_threads);
 
 	mrpt::system::CTimeLogger profiler(enable_profiler);
 	profiler.enter("optimize_graph_spa_levmarq (entire)");
@@ -208,17 +222,12 @@ void optimize_graph_spa_levmarq(
 	// problem:
 	const size_t nObservations = lstObservationData.size();
 	ASSERTDEB_ABOVE_(nObservations, 0);
-	// Cholesky object, as a pointer to reuse it between iterations:
-
-	using SparseCholeskyDecompPtr =
-		std::unique_ptr<CSparseMatrix::CholeskyDecomp>;
-	SparseCholeskyDecompPtr ptrCh;
 
 	// The list of Jacobians: for each constraint i->j,
 	//  we need the pair of Jacobians: { dh(xi,xj)_dxi, dh(xi,xj)_dxj },
 	//  which are "first" and "second" in each pair.
-	// Index of the map are the node IDs {i,j} for each contraint.
-	typename gst::map_pairIDs_pairJacobs_t lstJacobians;
+	// In the same order than lstObservationData.
+	typename gst::vector_pairJacobs_t lstJacobians;
 	// The vector of errors: err_k = SE(2/3)::pseudo_Ln( P_i * EDGE_ij *
 	// inv(P_j) )
 	mrpt::aligned_std_vector<typename gst::Array_O>
@@ -230,7 +239,7 @@ void optimize_graph_spa_levmarq(
 	// ===================================
 	profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 	double total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-		graph, lstObservationData, lstJacobians, errs);
+		lstObservationData, lstJacobians, errs, pool);
 	profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 	// Only once (since this will be static along iterations), build a quick
@@ -246,24 +255,157 @@ void optimize_graph_spa_levmarq(
 	// ordered in
 	// "nodes_to_optimize"
 	observationIndex_to_relatedFreeNodeIndex.reserve(nObservations);
-	ASSERTDEB_(lstJacobians.size() == nObservations);
-	for (typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ =
-			 lstJacobians.begin();
-		 itJ != lstJacobians.end(); ++itJ)
 	{
-		const TNodeID id1 = itJ->first.first;
-		const TNodeID id2 = itJ->first.second;
-		observationIndex_to_relatedFreeNodeIndex.push_back(std::make_pair(
-			mrpt::containers::find_in_vector(id1, *nodes_to_optimize),
-			mrpt::containers::find_in_vector(id2, *nodes_to_optimize)));
+		const vector<TNodeID> freeNodeIDs(
+			nodes_to_optimize->begin(), nodes_to_optimize->end());
+		auto freeNodeIndex = [&freeNodeIDs](const TNodeID id) {
+			const auto it =
+				std::lower_bound(freeNodeIDs.begin(), freeNodeIDs.end(), id);
+			return (it != freeNodeIDs.end() && *it == id)
+					   ? static_cast<size_t>(it - freeNodeIDs.begin())
+					   : string::npos;
+		};
+		for (const auto& obs : lstObservationData)
+			observationIndex_to_relatedFreeNodeIndex.emplace_back(
+				freeNodeIndex(obs.edge->first.first),
+				freeNodeIndex(obs.edge->first.second));
+	}
+
+	profiler.enter("optimize_graph_spa_levmarq.sp_H:structure");
+	// ======================================================================
+	// Build, only once, the sparse structure of the upper triangular part of
+	// the Hessian matrix H = J^t * J, made of DIMS_POSE x DIMS_POSE blocks,
+	// and the list of terms of each constraint that must be added to each
+	// block and to each part of the gradient.
+	//  - Block "b" is at column H_blocks_col_row[b].first and row
+	//  H_blocks_col_row[b].second, both in the range [0,N-1] as ordered in
+	//  "*nodes_to_optimize". Blocks are sorted by column, then row.
+	//  - The terms of block "b" are H_terms[H_terms_start[b]] to
+	//  H_terms[H_terms_start[b+1]-1], in the order of the constraints.
+	//  - Likewise, the gradient terms of free node "k" are
+	//  grad_terms[grad_terms_start[k]] to grad_terms[grad_terms_start[k+1]-1]
+	// ======================================================================
+	// A term J_row^t * Inf * J_col of one constraint in a Hessian block.
+	// Jacobians are the "first" or "second" of the pair of the constraint.
+	struct THessianTerm
+	{
+		size_t obs;
+		bool row_J_is_first, col_J_is_first;
+		// true: J_row=J_col, the term is computed as J^t * Inf * J
+		bool same_J;
+	};
+	vector<pair<size_t, size_t>> H_blocks_col_row;
+	vector<size_t> H_terms_start;
+	vector<THessianTerm> H_terms;
+	// A term J^t * Inf * err of one constraint in the gradient:
+	vector<pair<size_t, bool /*J is first*/>> grad_terms;
+	vector<size_t> grad_terms_start(nFreeNodes + 1, 0);
+	{
+		// Terms for each [column][row] block:
+		vector<std::map<size_t, vector<THessianTerm>>> terms_by_block(
+			nFreeNodes);
+		vector<vector<pair<size_t, bool>>> terms_by_node(nFreeNodes);
+
+		for (size_t idxObs = 0; idxObs < nObservations; ++idxObs)
+		{
+			const auto& ids = lstObservationData[idxObs].edge->first;
+			const auto& freeIdxs =
+				observationIndex_to_relatedFreeNodeIndex[idxObs];
+
+			if (freeIdxs.first != string::npos)
+				terms_by_node[freeIdxs.first].emplace_back(idxObs, true);
+			if (freeIdxs.second != string::npos)
+				terms_by_node[freeIdxs.second].emplace_back(idxObs, false);
+
+			// We sort IDs such as "i" < "j" and we can build just the
+			// upper triangular part of the Hessian.
+			const bool edge_straight = ids.first < ids.second;
+
+			// Indices in the range [0,N-1]:
+			const size_t idx_i =
+				edge_straight ? freeIdxs.first : freeIdxs.second;
+			const size_t idx_j =
+				edge_straight ? freeIdxs.second : freeIdxs.first;
+
+			// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
+			if (idx_i != string::npos)
+				terms_by_block[idx_i][idx_i].push_back(
+					{idxObs, edge_straight, edge_straight, true});
+			// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
+			if (idx_j != string::npos)
+				terms_by_block[idx_j][idx_j].push_back(
+					{idxObs, !edge_straight, !edge_straight, true});
+			// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
+			if (idx_i != string::npos && idx_j != string::npos)
+				terms_by_block[idx_j][idx_i].push_back(
+					{idxObs, edge_straight, !edge_straight, false});
+		}
+
+		H_terms_start.push_back(0);
+		H_terms.reserve(3 * nObservations);
+		for (size_t col = 0; col < nFreeNodes; col++)
+			for (const auto& blockTerms : terms_by_block[col])
+			{
+				H_blocks_col_row.emplace_back(col, blockTerms.first);
+				H_terms.insert(
+					H_terms.end(), blockTerms.second.begin(),
+					blockTerms.second.end());
+				H_terms_start.push_back(H_terms.size());
+			}
+
+		grad_terms.reserve(2 * nObservations);
+		for (size_t k = 0; k < nFreeNodes; k++)
+		{
+			grad_terms.insert(
+				grad_terms.end(), terms_by_node[k].begin(),
+				terms_by_node[k].end());
+			grad_terms_start[k + 1] = grad_terms.size();
+		}
+	}
+	const size_t nBlocks = H_blocks_col_row.size();
+
+	// The value of each block, accumulated over iterations:
+	mrpt::aligned_std_vector<typename gst::matrix_VxV_t> H_blocks(nBlocks);
+	for (auto& H : H_blocks) H.setZero();
+
+	// The sparse matrix H: only the upper diagonal part is filled in, since
+	// Cholesky will later on ignore the other part. Each entry is first set
+	// to a unique index into "H_value_index", which is then replaced by the
+	// index of that entry in the values of the column-compressed matrix:
+	static const size_t BLOCK_LEN = DIMS_POSE * DIMS_POSE;
+	CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
+	vector<int> H_value_index(nBlocks * BLOCK_LEN, -1);
+	for (size_t b = 0; b < nBlocks; b++)
+	{
+		const size_t i_offset = H_blocks_col_row[b].first * DIMS_POSE;
+		const size_t j_offset = H_blocks_col_row[b].second * DIMS_POSE;
+		const bool is_diagonal = i_offset == j_offset;
+		for (size_t r = 0; r < DIMS_POSE; r++)
+			for (size_t c = (is_diagonal ? r : 0); c < DIMS_POSE; c++)
+				sp_H.insert_entry_fast(
+					j_offset + r, i_offset + c,
+					b * BLOCK_LEN + r * DIMS_POSE + c);
+	}
+	sp_H.compressFromTriplet();
+	{
+		double* sp_H_values = sp_H.getStoredValues();
+		for (size_t k = 0; k < sp_H.getStoredValuesCount(); k++)
+			H_value_index[static_cast<size_t>(sp_H_values[k])] = int(k);
 	}
 
+	// Symbolic analysis for the Cholesky decomposition, which only depends on
+	// the sparse structure, hence it is reused in all iterations:
+	CSparseMatrix::CholeskyDecomp sp_H_chol(sp_H, true /*symbolic only*/);
+	profiler.leave("optimize_graph_spa_levmarq.sp_H:structure");
+
 	// other important vars for the main loop:
 	CVectorDouble grad(nFreeNodes * DIMS_POSE);
 	grad.setZero();
-	using map_ID2matrix_VxV_t =
-		mrpt::aligned_std_map<TNodeID, typename gst::matrix_VxV_t>;
-	vector<map_ID2matrix_VxV_t> H_map(nFreeNodes);
+	mrpt::aligned_std_vector<typename gst::Array_O> grad_parts(nFreeNodes);
+
+	// Jacobians & errors for the tentative new solutions:
+	typename gst::vector_pairJacobs_t new_lstJacobians;
+	mrpt::aligned_std_vector<typename gst::Array_O> new_errs;
 
 	double lambda = initial_lambda;  // Will be actually set on first iteration.
 	double v = 1;  // was 2, changed since it's modified in the first pass.
@@ -296,54 +438,29 @@ void optimize_graph_spa_levmarq(
 			// that is: g_i is the "dot-product" of the i'th (transposed)
 			// block-column of J and the vector of errors "errs"
 			profiler.enter("optimize_graph_spa_levmarq.grad");
-			mrpt::aligned_std_vector<typename gst::Array_O> grad_parts(
-				nFreeNodes, array_O_zeros);
-
-			// "lstJacobians" is sorted in the same order than
-			// "lstObservationData":
-			ASSERTDEB_EQUAL_(lstJacobians.size(), lstObservationData.size());
-			{
-				size_t idx_obs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ;
-
-				for (idx_obs = 0, itJ = lstJacobians.begin();
-					 itJ != lstJacobians.end(); ++itJ, ++idx_obs)
-				{
-					// make sure they're in the expected order!
-					ASSERTDEB_(
-						itJ->first == lstObservationData[idx_obs].edge->first);
-
-					//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
-					//    k: [0,nFreeNodes-1]     <-- IDs.first & IDs.second
-					//    i: [0,nObservations-1]  <--- idx_obs
-
-					// Get the corresponding indices in the vector of "free
-					// variables" being optimized:
-					const size_t idx1 =
-						observationIndex_to_relatedFreeNodeIndex[idx_obs].first;
-					const size_t idx2 =
-						observationIndex_to_relatedFreeNodeIndex[idx_obs]
-							.second;
-
-					if (idx1 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.first /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx1] /* out */
-							);
-
-					if (idx2 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.second /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx2] /* out */
-							);
-				}
-			}
+			pool.parallelForBlocks(
+				nFreeNodes, detail::parallelBlockSize(nFreeNodes, pool),
+				[&](size_t first, size_t last) {
+					for (size_t k = first; k < last; k++)
+					{
+						grad_parts[k] = array_O_zeros;
+						for (size_t t = grad_terms_start[k];
+							 t < grad_terms_start[k + 1]; t++)
+						{
+							//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
+							const size_t idx_obs = grad_terms[t].first;
+							const auto& Js = lstJacobians[idx_obs];
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiply_Jt_W_err(
+									grad_terms[t].second ? Js.first
+														 : Js.second /* J */,
+									lstObservationData[idx_obs].edge /* W */,
+									errs[idx_obs] /* err */,
+									grad_parts[k] /* out */
+								);
+						}
+					}
+				});
 
 			// build the gradient as a single vector:
 			::memcpy(
@@ -369,89 +486,38 @@ void optimize_graph_spa_levmarq(
 
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:build map");
 			// ======================================================================
-			// Build sparse representation of the upper triangular part of
-			//  the Hessian matrix H = J^t * J
-			//
-			// Sparse memory structure is a vector of maps, such as:
-			//  - H_map[i]: corresponds to the i'th column of H.
-			//              Here "i" corresponds to [0,N-1] indices of
-			//              appearance in the map "*nodes_to_optimize".
-			//  - H_map[i][j] is the entry for the j'th row, with "j" also in
-			//  the range [0,N-1] as ordered in "*nodes_to_optimize".
+			// Add the terms of the Hessian matrix H = J^t * J for the new
+			// Jacobians to each block. Note that blocks are never reset, so
+			// they accumulate the terms of all the linearization points so
+			// far.
 			// ======================================================================
-			{
-				size_t idxObs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator
-					itJacobPair;
-
-				for (idxObs = 0, itJacobPair = lstJacobians.begin();
-					 idxObs < nObservations; ++itJacobPair, ++idxObs)
-				{
-					// We sort IDs such as "i" < "j" and we can build just the
-					// upper triangular part of the Hessian.
-					const bool edge_straight =
-						itJacobPair->first.first < itJacobPair->first.second;
-
-					// Indices in the "H_map" vector:
-					const size_t idx_i =
-						edge_straight
-							? observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .first
-							: observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .second;
-					const size_t idx_j =
-						edge_straight
-							? observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .second
-							: observationIndex_to_relatedFreeNodeIndex[idxObs]
-								  .first;
-
-					const bool is_i_free_node = idx_i != string::npos;
-					const bool is_j_free_node = idx_j != string::npos;
-
-					// Take references to both Jacobians (wrt pose "i" and pose
-					// "j"), taking into account the possible
-					// switch in their order:
-
-					const typename gst::matrix_VxV_t& J1 =
-						edge_straight ? itJacobPair->second.first
-									  : itJacobPair->second.second;
-					const typename gst::matrix_VxV_t& J2 =
-						edge_straight ? itJacobPair->second.second
-									  : itJacobPair->second.first;
-
-					// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
-					if (is_i_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J1, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_i][idx_i] += JtJ;
-					}
-					// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
-					if (is_j_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_j] += JtJ;
-					}
-					// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
-					if (is_i_free_node && is_j_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJ1tLambdaJ2(
-								J1, J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_i] += JtJ;
-					}
-				}
-			}
+			pool.parallelForBlocks(
+				nBlocks, detail::parallelBlockSize(nBlocks, pool),
+				[&](size_t first, size_t last) {
+					using aux_eval_t =
+						detail::AuxErrorEval<typename gst::edge_t, gst>;
+					typename gst::matrix_VxV_t JtJ(
+						mrpt::math::UNINITIALIZED_MATRIX);
+					for (size_t b = first; b < last; b++)
+						for (size_t t = H_terms_start[b];
+							 t < H_terms_start[b + 1]; t++)
+						{
+							const THessianTerm& term = H_terms[t];
+							const auto& Js = lstJacobians[term.obs];
+							const auto& J_row =
+								term.row_J_is_first ? Js.first : Js.second;
+							const auto& J_col =
+								term.col_J_is_first ? Js.first : Js.second;
+							const auto& edge =
+								lstObservationData[term.obs].edge;
+							if (term.same_J)
+								aux_eval_t::multiplyJtLambdaJ(J_row, JtJ, edge);
+							else
+								aux_eval_t::multiplyJ1tLambdaJ2(
+									J_row, J_col, JtJ, edge);
+							H_blocks[b] += JtJ;
+						}
+				});
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:build map");
 
 			// Just in the first iteration, we need to calculate an estimate for
@@ -461,20 +527,13 @@ void optimize_graph_spa_levmarq(
 				profiler.enter(
 					"optimize_graph_spa_levmarq.lambda_init");  // ---\  .
 				double H_diagonal_max = 0;
-				for (size_t i = 0; i < nFreeNodes; i++)
-					for (typename map_ID2matrix_VxV_t::const_iterator it =
-							 H_map[i].begin();
-						 it != H_map[i].end(); ++it)
+				for (size_t b = 0; b < nBlocks; b++)
+					if (H_blocks_col_row[b].first ==
+						H_blocks_col_row[b].second)
 					{
-						const size_t j =
-							it->first;  // entry submatrix is for (i,j).
-						if (i == j)
-						{
-							for (size_t k = 0; k < DIMS_POSE; k++)
-								mrpt::keep_max(
-									H_diagonal_max,
-									it->second.get_unsafe(k, k));
-						}
+						for (size_t k = 0; k < DIMS_POSE; k++)
+							mrpt::keep_max(
+								H_diagonal_max, H_blocks[b].get_unsafe(k, k));
 					}
 				lambda = tau * H_diagonal_max;
 
@@ -507,48 +566,35 @@ void optimize_graph_spa_levmarq(
 		}
 
 		profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
-		// Now, build the actual sparse matrix H:
-		// Note: we only need to fill out the upper diagonal part, since
-		// Cholesky will later on ignore the other part.
-		CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
-		for (size_t i = 0; i < nFreeNodes; i++)
+		// Now, update the values of the actual sparse matrix H in place:
 		{
-			const size_t i_offset = i * DIMS_POSE;
-
-			for (typename map_ID2matrix_VxV_t::const_iterator it =
-					 H_map[i].begin();
-				 it != H_map[i].end(); ++it)
-			{
-				const size_t j = it->first;  // entry submatrix is for (i,j).
-				const size_t j_offset = j * DIMS_POSE;
-
-				// For i==j (diagonal blocks), it's different, since we only
-				// need to insert their
-				// upper-diagonal half and also we have to add the lambda*I to
-				// the diagonal from the Lev-Marq. algorithm:
-				if (i == j)
-				{
-					for (size_t r = 0; r < DIMS_POSE; r++)
+			double* sp_H_values = sp_H.getStoredValues();
+			pool.parallelForBlocks(
+				nBlocks, detail::parallelBlockSize(nBlocks, pool),
+				[&](size_t first, size_t last) {
+					for (size_t b = first; b < last; b++)
 					{
-						// c=r: add lambda from LM
-						sp_H.insert_entry_fast(
-							j_offset + r, i_offset + r,
-							it->second.get_unsafe(r, r) + lambda);
-						// c>r:
-						for (size_t c = r + 1; c < DIMS_POSE; c++)
-							sp_H.insert_entry_fast(
-								j_offset + r, i_offset + c,
-								it->second.get_unsafe(r, c));
+						const auto& H = H_blocks[b];
+						const int* idxs = &H_value_index[b * BLOCK_LEN];
+						// For diagonal blocks, it's different, since we only
+						// need to insert their upper-diagonal half and also we
+						// have to add the lambda*I to the diagonal from the
+						// Lev-Marq. algorithm:
+						const bool is_diagonal = H_blocks_col_row[b].first ==
+												 H_blocks_col_row[b].second;
+						for (size_t r = 0; r < DIMS_POSE; r++)
+						{
+							if (is_diagonal)
+								sp_H_values[idxs[r * DIMS_POSE + r]] =
+									H.get_unsafe(r, r) + lambda;
+							for (size_t c = (is_diagonal ? r + 1 : 0);
+								 c < DIMS_POSE; c++)
+								sp_H_values[idxs[r * DIMS_POSE + c]] =
+									H.get_unsafe(r, c);
+						}
 					}
-				}
-				else
-				{
-					sp_H.insert_submatrix(j_offset, i_offset, it->second);
-				}
-			}
-		}  // end for each free node, build sp_H
-
-		sp_H.compressFromTriplet();
+				});
+		}
 		profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
 
 		// Use the cparse Cholesky decomposition to efficiently solve:
@@ -560,15 +606,11 @@ void optimize_graph_spa_levmarq(
 		try
 		{
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:chol");
-			if (!ptrCh.get())
-				ptrCh = SparseCholeskyDecompPtr(
-					new CSparseMatrix::CholeskyDecomp(sp_H));
-			else
-				ptrCh.get()->update(sp_H);
+			sp_H_chol.update(sp_H);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:chol");
 
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:backsub");
-			ptrCh->backsub(grad, delta);
+			sp_H_chol.backsub(grad, delta);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:backsub");
 		}
 		catch (CExceptionNotDefPos&)
@@ -663,12 +705,9 @@ void optimize_graph_spa_levmarq(
 			// =============================================================
 			// Compute Jacobians & errors with the new "graph.nodes" info:
 			// =============================================================
-			typename gst::map_pairIDs_pairJacobs_t new_lstJacobians;
-			mrpt::aligned_std_vector<typename gst::Array_O> new_errs;
-
 			profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 			double new_total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-				graph, lstObservationData, new_lstJacobians, new_errs);
+				lstObservationData, new_lstJacobians, new_errs, pool);
 			profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 			// Now, to decide whether to accept the change:
@@ -9,6 +9,9 @@
 #ifndef GRAPH_SLAM_LEVMARQ_IMPL_H
 #define GRAPH_SLAM_LEVMARQ_IMPL_H
 
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <algorithm>
+
 namespace mrpt
 {
 namespace graphslam
@@ -172,6 +175,44 @@ struct AuxErrorEval<CPose3DPDFGaussianInf, gst>
 	}
 };
 
+// Computes the jacobians and the error vector of one constraint, with the
+// current global poses of its nodes.
+template <class GRAPH_T>
+void computeJacobianAndError(
+	const typename graphslam_traits<GRAPH_T>::observation_info_t& obs,
+	typename graphslam_traits<GRAPH_T>::TPairJacobs& jacobs,
+	typename graphslam_traits<GRAPH_T>::Array_O& err)
+{
+	using gst = graphslam_traits<GRAPH_T>;
+	using pose_t = typename gst::graph_t::constraint_t::type_value;
+
+	// Compute the residual pose error of these pair of nodes + its
+	// constraint, that is: P1DP2inv = P1 * EDGE * inv(P2)
+	pose_t P1DP2inv(mrpt::poses::UNINITIALIZED_POSE);
+	{
+		pose_t P1D(mrpt::poses::UNINITIALIZED_POSE);
+		P1D.composeFrom(*obs.P1, *obs.edge_mean);
+		const pose_t P2inv = -(*obs.P2);  // Pose inverse (NOT just switching
+		// signs!)
+		P1DP2inv.composeFrom(P1D, P2inv);
+	}
+
+	AuxErrorEval<typename gst::edge_t, gst>::computePseudoLnError(
+		P1DP2inv, err, obs.edge->second);
+
+	gst::SE_TYPE::jacobian_dP1DP2inv_depsilon(
+		P1DP2inv, &jacobs.first, &jacobs.second);
+}
+
+// Number of elements of each parallel block of work, for N elements:
+inline size_t parallelBlockSize(size_t N, const mrpt::WorkerThreadsPool& pool)
+{
+	if (pool.size() < 2) return N;
+	// A few blocks per thread, to balance the load:
+	const size_t nBlocks = 4 * pool.size();
+	return std::max<size_t>(64, (N + nBlocks - 1) / nBlocks);
+}
+
 }  // end NS detail
 
 // Compute, at once, jacobians and the error vectors for each constraint in
@@ -191,45 +232,18 @@ double computeJacobiansAndErrors(
 	errs.clear();
 
 	const size_t nObservations = lstObservationData.size();
+	errs.resize(nObservations);
 
 	for (size_t i = 0; i < nObservations; i++)
 	{
 		const typename gst::observation_info_t& obs = lstObservationData[i];
-		typename gst::edge_const_iterator it = obs.edge;
-		const typename gst::graph_t::constraint_t::type_value* EDGE_POSE =
-			obs.edge_mean;
-		typename gst::graph_t::constraint_t::type_value* P1 = obs.P1;
-		typename gst::graph_t::constraint_t::type_value* P2 = obs.P2;
-
-		const auto& ids = it->first;
-		const auto& edge = it->second;
-
-		// Compute the residual pose error of these pair of nodes + its
-		// constraint,
-		//  that is: P1DP2inv = P1 * EDGE * inv(P2)
-		typename gst::graph_t::constraint_t::type_value P1DP2inv(
-			mrpt::poses::UNINITIALIZED_POSE);
-		{
-			typename gst::graph_t::constraint_t::type_value P1D(
-				mrpt::poses::UNINITIALIZED_POSE);
-			P1D.composeFrom(*P1, *EDGE_POSE);
-			const typename gst::graph_t::constraint_t::type_value P2inv =
-				-(*P2);  // Pose inverse (NOT just switching signs!)
-			P1DP2inv.composeFrom(P1D, P2inv);
-		}
-
-		// Add to vector of errors:
-		errs.resize(errs.size() + 1);
-		detail::AuxErrorEval<typename gst::edge_t, gst>::computePseudoLnError(
-			P1DP2inv, errs.back(), edge);
-
-		// Compute the jacobians:
+
 		alignas(MRPT_MAX_ALIGN_BYTES)
 			std::pair<mrpt::graphs::TPairNodeIDs, typename gst::TPairJacobs>
 				newMapEntry;
-		newMapEntry.first = ids;
-		gst::SE_TYPE::jacobian_dP1DP2inv_depsilon(
-			P1DP2inv, &newMapEntry.second.first, &newMapEntry.second.second);
+		newMapEntry.first = obs.edge->first;
+		detail::computeJacobianAndError<GRAPH_T>(
+			obs, newMapEntry.second, errs[i]);
 
 		// And insert into map of jacobians:
 		lstJacobians.insert(lstJacobians.end(), newMapEntry);
@@ -243,6 +257,36 @@ double computeJacobiansAndErrors(
 	return ret_err;
 }
 
+// Like above, but with the pairs of jacobians in a vector, in the same order
+// than "lstObservationData". Constraints are evaluated in parallel in the
+// threads of "pool", if any.
+template <class GRAPH_T>
+double computeJacobiansAndErrors(
+	const std::vector<typename graphslam_traits<GRAPH_T>::observation_info_t>&
+		lstObservationData,
+	typename graphslam_traits<GRAPH_T>::vector_pairJacobs_t& lstJacobians,
+	mrpt::aligned_std_vector<typename graphslam_traits<GRAPH_T>::Array_O>& errs,
+	mrpt::WorkerThreadsPool& pool)
+{
+	const size_t nObservations = lstObservationData.size();
+	lstJacobians.resize(nObservations);
+	errs.resize(nObservations);
+
+	pool.parallelForBlocks(
+		nObservations, detail::parallelBlockSize(nObservations, pool),
+		[&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+				detail::computeJacobianAndError<GRAPH_T>(
+					lstObservationData[i], lstJacobians[i], errs[i]);
+		});
+
+	// Sequential sum, so the result does not depend on the number of
+	// threads:
+	double ret_err = 0.0;
+	for (size_t i = 0; i < errs.size(); i++) ret_err += errs[i].squaredNorm();
+	return ret_err;
+}
+
 }  // end of NS
 }  // end of NS
 
@@ -11,6 +11,7 @@
 #include <mrpt/graphs/CNetworkOfPoses.h>
 #include <mrpt/poses/SE_traits.h>
 #include <mrpt/core/aligned_std_map.h>
+#include <mrpt/core/aligned_std_vector.h>
 #include <functional>
 
 namespace mrpt
@@ -45,6 +46,7 @@ struct graphslam_traits
 	using TPairJacobs = std::pair<matrix_VxV_t, matrix_VxV_t>;
 	using map_pairIDs_pairJacobs_t =
 		mrpt::aligned_std_multimap<mrpt::graphs::TPairNodeIDs, TPairJacobs>;
+	using vector_pairJacobs_t = mrpt::aligned_std_vector<TPairJacobs>;
 
 	/** Auxiliary struct used in graph-slam implementation: It holds the
 	 * relevant information for each of the constraints being taking into
@@ -0,0 +1,244 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "graph_slam_levmarq_test_common.h"
+
+#include <mrpt/graphslam/GSO/CIncrementalGSO.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::random;
+using namespace mrpt::poses;
+using namespace mrpt::graphs;
+using namespace mrpt::math;
+using namespace std;
+
+template <class my_graph_t>
+class CIncrementalGSOTester : public GraphSlamLevMarqTest<my_graph_t>,
+							  public ::testing::Test
+{
+   protected:
+	virtual void SetUp() {}
+	virtual void TearDown() {}
+	using gso_t = mrpt::graphslam::optimizers::CIncrementalGSO<my_graph_t>;
+
+	// Adds the nodes of "full" to "graph" one by one, as graphslam-engine
+	// does, together with the edges to the nodes already in the graph.
+	static void addNextNode(
+		const my_graph_t& full, TNodeID id, my_graph_t& graph,
+		gso_t& optimizer)
+	{
+		graph.nodes[id] = full.nodes.find(id)->second;
+		for (const auto& e : full.edges)
+			if (std::max(e.first.first, e.first.second) == id)
+				graph.insertEdge(e.first.first, e.first.second, e.second);
+		optimizer.updateState(nullptr, nullptr, nullptr);
+	}
+
+	// Strict thresholds, so all the nodes are relinearized and solved for:
+	static void setupOptimizer(gso_t& optimizer, my_graph_t& graph)
+	{
+		optimizer.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+		optimizer.setGraphPtr(&graph);
+		optimizer.opt_params.relinearize_threshold = 1e-6;
+		optimizer.opt_params.backsubstitution_threshold = 0;
+	}
+
+	void test_ring_path()
+	{
+		my_graph_t full;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(full);
+		// Noisy edges, so the optimal solution is not the ground truth:
+		for (auto& e : full.edges)
+			e.second += typename my_graph_t::edge_t(
+				CPose3D(
+					getRandomGenerator().drawGaussian1D(0, 0.01),
+					getRandomGenerator().drawGaussian1D(0, 0.01),
+					getRandomGenerator().drawGaussian1D(0, 0.01),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(0.5)),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(0.5)),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(0.5))));
+
+		// Solution with all the nodes and edges at once:
+		my_graph_t batch = full;
+		gso_t batch_optimizer;
+		setupOptimizer(batch_optimizer, batch);
+		for (int i = 0; i < 20; i++)
+			batch_optimizer.updateState(nullptr, nullptr, nullptr);
+
+		// Incremental solution:
+		my_graph_t graph;
+		graph.root = full.root;
+		graph.nodes[full.root] = full.nodes.find(full.root)->second;
+		gso_t optimizer;
+		setupOptimizer(optimizer, graph);
+		for (TNodeID id = 1; id < full.nodes.size(); id++)
+			addNextNode(full, id, graph, optimizer);
+		for (int i = 0; i < 20; i++)
+			optimizer.updateState(nullptr, nullptr, nullptr);
+
+		ASSERT_EQ(graph.edges.size(), full.edges.size());
+		for (const auto& n : batch.nodes)
+		{
+			const auto p = graph.nodes[n.first].getAsVectorVal();
+			const auto p_batch = n.second.getAsVectorVal();
+			for (int k = 0; k < p.size(); k++)
+				EXPECT_NEAR(p[k], p_batch[k], 1e-4) << "node: " << n.first;
+		}
+
+		// Both are better than Levenberg-Marquardt:
+		my_graph_t levmarq = full;
+		mrpt::system::TParametersDouble params;
+		params["max_iterations"] = 1000;
+		graphslam::TResultInfoSpaLevMarq levmarq_info;
+		graphslam::optimize_graph_spa_levmarq(
+			levmarq, levmarq_info, nullptr, params);
+		EXPECT_LE(
+			graph.getGlobalSquareError(), levmarq.getGlobalSquareError());
+	}
+
+	// Edges erased through the graph are in its log of changes, otherwise
+	// the optimizer finds out from the number of edges.
+	void test_replaced_edge(bool erase_through_graph)
+	{
+		my_graph_t graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph);
+		// Noisy edges, so removing one of them changes the solution:
+		for (auto& e : graph.edges)
+			e.second += typename my_graph_t::edge_t(
+				CPose3D(
+					getRandomGenerator().drawGaussian1D(0, 0.05),
+					getRandomGenerator().drawGaussian1D(0, 0.05),
+					getRandomGenerator().drawGaussian1D(0, 0.05),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(2)),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(2)),
+					getRandomGenerator().drawGaussian1D(0, DEG2RAD(2))));
+		gso_t optimizer;
+		setupOptimizer(optimizer, graph);
+		for (int i = 0; i < 5; i++)
+			optimizer.updateState(nullptr, nullptr, nullptr);
+
+		// Remove a loop closure and add another edge in the same step, so
+		// the number of edges does not change:
+		const size_t nEdges = graph.edges.size();
+		auto it = graph.edges.begin();
+		while (std::abs(
+				   static_cast<long>(it->first.first) -
+				   static_cast<long>(it->first.second)) <= 1)
+			++it;
+		const TNodeID a = it->first.first, b = it->first.second;
+		if (erase_through_graph)
+			graph.eraseEdge(it);
+		else
+			graph.edges.erase(it);
+		graph.insertEdge(
+			a + 1, b,
+			typename my_graph_t::edge_t(
+				graph.nodes[b] - graph.nodes[a + 1] +
+				typename my_graph_t::edge_t::type_value(
+					CPose3D(0.5, 0, 0, 0, 0, 0))));
+		ASSERT_EQ(graph.edges.size(), nEdges);
+
+		// Same solution than optimizing the new graph from scratch:
+		my_graph_t batch = graph;
+		gso_t batch_optimizer;
+		setupOptimizer(batch_optimizer, batch);
+		for (int i = 0; i < 20; i++)
+		{
+			optimizer.updateState(nullptr, nullptr, nullptr);
+			batch_optimizer.updateState(nullptr, nullptr, nullptr);
+		}
+		for (const auto& n : batch.nodes)
+		{
+			const auto p = graph.nodes[n.first].getAsVectorVal();
+			const auto p_batch = n.second.getAsVectorVal();
+			for (int k = 0; k < p.size(); k++)
+				EXPECT_NEAR(p[k], p_batch[k], 1e-6) << "node: " << n.first;
+		}
+	}
+
+	void test_long_path()
+	{
+		// A path without loop closures: each new node only changes the last
+		// columns of the factorization, whatever the length of the path.
+		my_graph_t graph;
+		graph.root = 0;
+		graph.nodes[0] = typename my_graph_t::global_pose_t();
+		gso_t optimizer;
+		optimizer.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+		optimizer.setGraphPtr(&graph);
+
+		const CPose3D step(
+			1.0, 0.1, 0.01, DEG2RAD(2.0), DEG2RAD(1.0), DEG2RAD(0.5));
+		for (TNodeID id = 1; id < 1000; id++)
+		{
+			graph.nodes[id] = typename my_graph_t::global_pose_t();
+			graph.insertEdge(id - 1, id, typename my_graph_t::edge_t(step));
+			optimizer.updateState(nullptr, nullptr, nullptr);
+
+			const auto& stats = optimizer.getLastUpdateStats();
+			EXPECT_EQ(stats.num_relinearized, 0u);
+			EXPECT_LE(stats.num_refactored, 2u);
+			EXPECT_LE(stats.num_solved, 2u);
+			// Only the new edge is looked at:
+			EXPECT_EQ(stats.num_edges_visited, 1u);
+		}
+		optimizer.updateState(nullptr, nullptr, nullptr);
+		EXPECT_EQ(optimizer.getLastUpdateStats().num_edges_visited, 0u);
+
+		// Loop closure to the middle of the path: only the nodes from there
+		// on are refactored.
+		graph.insertEdge(
+			500, 999,
+			typename my_graph_t::edge_t(
+				graph.nodes[999] - graph.nodes[500] +
+				typename my_graph_t::edge_t::type_value(
+					CPose3D(0.5, 0, 0, 0, 0, 0))));
+		optimizer.updateState(nullptr, nullptr, nullptr);
+		EXPECT_EQ(optimizer.getLastUpdateStats().num_refactored, 500u);
+		EXPECT_EQ(optimizer.getLastUpdateStats().num_edges_visited, 1u);
+	}
+};
+
+using CIncrementalGSOTester2D = CIncrementalGSOTester<CNetworkOfPoses2D>;
+using CIncrementalGSOTester3D = CIncrementalGSOTester<CNetworkOfPoses3D>;
+
+TEST_F(CIncrementalGSOTester2D, OptimizeSampleRingPath)
+{
+	for (int seed = 1; seed < 5; seed++)
+	{
+		getRandomGenerator().randomize(seed);
+		test_ring_path();
+	}
+}
+TEST_F(CIncrementalGSOTester2D, ConstantCostPerStep) { test_long_path(); }
+TEST_F(CIncrementalGSOTester2D, ReplacedEdge)
+{
+	getRandomGenerator().randomize(123);
+	test_replaced_edge(true);
+	getRandomGenerator().randomize(123);
+	test_replaced_edge(false);
+}
+
+TEST_F(CIncrementalGSOTester3D, OptimizeSampleRingPath)
+{
+	for (int seed = 1; seed < 5; seed++)
+	{
+		getRandomGenerator().randomize(seed);
+		test_ring_path();
+	}
+}
+TEST_F(CIncrementalGSOTester3D, ConstantCostPerStep) { test_long_path(); }
+TEST_F(CIncrementalGSOTester3D, ReplacedEdge)
+{
+	getRandomGenerator().randomize(123);
+	test_replaced_edge(true);
+	getRandomGenerator().randomize(123);
+	test_replaced_edge(false);
+}
@@ -0,0 +1,159 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/graphslam/ERD/CLoopCloserERD.h>
+#include <gtest/gtest.h>
+#include <future>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::graphslam::deciders;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace std;
+
+using graph_t = CNetworkOfPoses2DInf;
+
+// Exposes the evaluation of the loop closures of one partition
+class LoopCloserTester : public CLoopCloserERD<graph_t>
+{
+   public:
+	using CLoopCloserERD<graph_t>::TLCEvaluation;
+	using CLoopCloserERD<graph_t>::runLCEvaluation;
+
+	LoopCloserTester()
+	{
+		this->setMinLoggingLevel(mrpt::system::LVL_ERROR);
+		this->m_lc_params.LC_eigenvalues_ratio_thresh = 2;
+	}
+};
+
+// Walls of a room with some furniture, as (x0,y0,x1,y1):
+static const double walls[][4] = {
+	{-4, -3, 8, -3}, {8, -3, 8, 5},	{8, 5, -4, 5},   {-4, 5, -4, -3},
+	{1, 1, 3, 1},	{3, 1, 3, 2.5},  {3, 2.5, 1, 1},  {-2, -3, -2, -1.5},
+	{5, 5, 5, 3.5},  {5.5, -1, 6.5, -2}};
+
+// Laser scan of the room, ray traced from the given pose:
+static CObservation2DRangeScan::Ptr simulateScan(const CPose2D& p)
+{
+	auto scan = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+	const size_t N = 361;
+	scan->aperture = M_PI;
+	scan->maxRange = 20;
+	scan->rightToLeft = true;
+	scan->resizeScan(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const double a = p.phi() - 0.5 * M_PI + M_PI * i / (N - 1);
+		const double dx = cos(a), dy = sin(a);
+		double r = scan->maxRange;
+		for (const auto& w : walls)
+		{
+			// p + t*(dx,dy) = w0 + s*(w1-w0)
+			const double ex = w[2] - w[0], ey = w[3] - w[1];
+			const double det = dx * (-ey) + ex * dy;
+			if (std::abs(det) < 1e-9) continue;
+			const double bx = w[0] - p.x(), by = w[1] - p.y();
+			const double t = (bx * (-ey) + ex * by) / det;
+			const double s = (dx * by - dy * bx) / det;
+			if (t > 0 && s >= 0 && s <= 1) r = std::min(r, t);
+		}
+		scan->setScanRange(i, static_cast<float>(r));
+		scan->setScanRangeValidity(i, r < scan->maxRange);
+	}
+	return scan;
+}
+
+// Two groups of nodes seen when passing twice through the same place, the
+// second time with an odometry drift and a node with a wrong pose.
+static void createEvaluation(LoopCloserTester::TLCEvaluation& eval)
+{
+	using path_t = LoopCloserTester::path_t;
+	const CPose2D drift(0.3, -0.2, DEG2RAD(4));
+	std::map<TNodeID, CPose2D> real_poses;
+	for (TNodeID i = 0; i < 4; i++)
+	{
+		const TNodeID a = i, b = 10 + i;
+		eval.groupA.push_back(a);
+		eval.groupB.push_back(b);
+		real_poses[a] = CPose2D(-1 + 0.5 * i, 0.2 * i, DEG2RAD(5.0 * i));
+		real_poses[b] = CPose2D(-0.8 + 0.5 * i, -0.3 + 0.2 * i, DEG2RAD(-10));
+		eval.nodes_props[a].pose = real_poses[a];
+		eval.nodes_props[b].pose = drift + real_poses[b];
+	}
+	// The last node of group B is somewhere else:
+	real_poses[13] = CPose2D(6, 3, DEG2RAD(180));
+	for (const auto& p : real_poses)
+		eval.nodes_props[p.first].scan = simulateScan(p.second);
+
+	// Paths between the nodes of each group, from their real poses
+	for (const auto* group : {&eval.groupA, &eval.groupB})
+	{
+		auto& paths = group == &eval.groupA ? eval.groupA_opt_paths
+											 : eval.groupB_opt_paths;
+		for (size_t i = 0; i < group->size(); i++)
+			for (size_t j = i + 1; j < group->size(); j++)
+			{
+				const TNodeID from = (*group)[i], to = (*group)[j];
+				graph_t::constraint_t edge;
+				edge.mean = real_poses[to] - real_poses[from];
+				edge.cov_inv.unit(3, 1e3);
+				paths.push_back(path_t(from, to, edge));
+			}
+	}
+	eval.goodness_thresh = 0.5;
+}
+
+static std::vector<std::pair<TNodeID, TNodeID>> acceptedLoopClosures(
+	const LoopCloserTester::TLCEvaluation& eval)
+{
+	std::vector<std::pair<TNodeID, TNodeID>> ret;
+	for (const auto* h : eval.valid_hypots) ret.emplace_back(h->from, h->to);
+	return ret;
+}
+
+TEST(CLoopCloserERD, SameLoopClosuresSerialParallelAsync)
+{
+	LoopCloserTester lc;
+
+	LoopCloserTester::TLCEvaluation serial;
+	createEvaluation(serial);
+	mrpt::WorkerThreadsPool no_threads;
+	lc.runLCEvaluation(serial, no_threads);
+	const auto expected = acceptedLoopClosures(serial);
+	ASSERT_FALSE(expected.empty());
+	// The node with a wrong pose is left out:
+	for (const auto& h : expected) EXPECT_NE(h.first, 13u);
+
+	LoopCloserTester::TLCEvaluation parallel;
+	createEvaluation(parallel);
+	mrpt::WorkerThreadsPool threads(4);
+	lc.runLCEvaluation(parallel, threads);
+
+	// As CLoopCloserERD does with LC_async_evaluation:
+	LoopCloserTester::TLCEvaluation async;
+	createEvaluation(async);
+	std::async(std::launch::async, [&]() {
+		lc.runLCEvaluation(async, threads);
+	}).get();
+
+	for (const auto* eval : {&parallel, &async})
+	{
+		EXPECT_EQ(acceptedLoopClosures(*eval), expected);
+		EXPECT_DOUBLE_EQ(eval->lambda1, serial.lambda1);
+		EXPECT_DOUBLE_EQ(eval->lambda2, serial.lambda2);
+		ASSERT_EQ(eval->hypots_pool.size(), serial.hypots_pool.size());
+		for (size_t i = 0; i < serial.hypots_pool.size(); i++)
+			EXPECT_EQ(
+				eval->hypots_pool[i]->is_valid,
+				serial.hypots_pool[i]->is_valid);
+	}
+}
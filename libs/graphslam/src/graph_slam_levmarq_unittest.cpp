@@ -53,6 +53,33 @@ class GraphSlamLevMarqTester : public GraphSlamLevMarqTest<my_graph_t>,
 
 	}  // end test_ring_path
 
+	void test_num_threads()
+	{
+		my_graph_t graph1;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph1);
+		my_graph_t graphN = graph1;
+
+		mrpt::system::TParametersDouble params;
+		params["max_iterations"] = 1000;
+		graphslam::TResultInfoSpaLevMarq info1, infoN;
+		params["num_threads"] = 1;
+		graphslam::optimize_graph_spa_levmarq(graph1, info1, nullptr, params);
+		params["num_threads"] = 4;
+		graphslam::optimize_graph_spa_levmarq(graphN, infoN, nullptr, params);
+
+		// The same result, regardless of the number of threads:
+		EXPECT_EQ(info1.num_iters, infoN.num_iters);
+		EXPECT_EQ(info1.final_total_sq_error, infoN.final_total_sq_error);
+		ASSERT_EQ(graph1.nodes.size(), graphN.nodes.size());
+		for (auto it1 = graph1.nodes.begin(), itN = graphN.nodes.begin();
+			 it1 != graph1.nodes.end(); ++it1, ++itN)
+		{
+			EXPECT_EQ(it1->first, itN->first);
+			EXPECT_EQ(
+				it1->second.getAsVectorVal(), itN->second.getAsVectorVal());
+		}
+	}
+
 	void test_graph_bin_serialization()
 	{
 		my_graph_t graph;
@@ -100,6 +127,14 @@ TEST_F(GraphSlamLevMarqTester2D, OptimizeSampleRingPath)
 		test_ring_path();
 	}
 }
+TEST_F(GraphSlamLevMarqTester2D, SameResultsWithThreads)
+{
+	for (int seed = 1; seed < 3; seed++)
+	{
+		getRandomGenerator().randomize(seed);
+		test_num_threads();
+	}
+}
 TEST_F(GraphSlamLevMarqTester2D, BinarySerialization)
 {
 	getRandomGenerator().randomize(123);
@@ -114,6 +149,14 @@ TEST_F(GraphSlamLevMarqTester3D, OptimizeSampleRingPath)
 		test_ring_path();
 	}
 }
+TEST_F(GraphSlamLevMarqTester3D, SameResultsWithThreads)
+{
+	for (int seed = 1; seed < 3; seed++)
+	{
+		getRandomGenerator().randomize(seed);
+		test_num_threads();
+	}
+}
 TEST_F(GraphSlamLevMarqTester3D, BinarySerialization)
 {
 	getRandomGenerator().randomize(123);
@@ -624,6 +624,25 @@ void CImage::serializeTo(mrpt::serialization::CArchive& out) const
 #endif
 }
 
+#if MRPT_HAS_OPENCV
+// Decodes the next nBytes of JPEG data in the archive, in place if the
+// archive supports views (e.g. memory-mapped files).
+static void loadJPEGFromArchive(
+	CImage& img, mrpt::serialization::CArchive& in, uint32_t nBytes)
+{
+	mrpt::io::CMemoryStream aux;
+	if (const void* jpeg = in.ReadBufferView(nBytes))
+		aux.assignMemoryNotOwn(jpeg, nBytes);
+	else
+	{
+		aux.changeSize(nBytes + 10);
+		in.ReadBuffer(aux.getRawBufferData(), nBytes);
+		aux.Seek(0);
+	}
+	img.loadFromStreamAsJPEG(aux);
+}
+#endif
+
 void CImage::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 {
 #if !MRPT_HAS_OPENCV
@@ -664,17 +683,9 @@ void CImage::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 		case 1:
 		{
 			// Version 1: High quality JPEG image
-			mrpt::io::CMemoryStream aux;
 			uint32_t nBytes;
 			in >> nBytes;
-
-			aux.changeSize(nBytes + 10);
-
-			in.ReadBuffer(aux.getRawBufferData(), nBytes);
-
-			aux.Seek(0);
-
-			loadFromStreamAsJPEG(aux);
+			loadJPEGFromArchive(*this, in, nBytes);
 		}
 		break;
 		case 2:
@@ -809,13 +820,9 @@ void CImage::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 					// COLOR IMAGE: JPEG
 					if (loadJPEG)
 					{
-						mrpt::io::CMemoryStream aux;
 						uint32_t nBytes;
 						in >> nBytes;
-						aux.changeSize(nBytes + 10);
-						in.ReadBuffer(aux.getRawBufferData(), nBytes);
-						aux.Seek(0);
-						loadFromStreamAsJPEG(aux);
+						loadJPEGFromArchive(*this, in, nBytes);
 					}
 				}
 			}
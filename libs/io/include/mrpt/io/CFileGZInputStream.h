@@ -9,18 +9,28 @@
 #pragma once
 
 #include <mrpt/io/CStream.h>
+#include <cstddef>
+#include <memory>
 
 namespace mrpt
 {
 namespace io
 {
+class CFileMMapInputStream;
+
 /** Transparently opens a compressed "gz" file and reads uncompressed data from
  * it.
- *   If the file is not a .gz file, it silently reads data from the file.
+ *   If the file is not a .gz file, it silently reads data from the file,
+ * memory-mapping it (see CFileMMapInputStream) so that ReadView() works.
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileInputStream
  *
- * \sa CFileInputStream
+ * Block-compressed files (see CFileGZOutputStream::openBlockCompressed())
+ * are detected automatically: their blocks are read ahead and decompressed
+ * in parallel by a pool of worker threads, and Seek() goes straight to the
+ * block holding the requested position.
+ *
+ * \sa CFileInputStream, CFileGZOutputStream
  * \ingroup mrpt_io_grp
  */
 class CFileGZInputStream : public CStream
@@ -29,6 +39,11 @@ class CFileGZInputStream : public CStream
 	void* m_f;
 	/** Compressed file size */
 	uint64_t m_file_size;
+	struct BlockReader;
+	/** Only for block-compressed files */
+	std::unique_ptr<BlockReader> m_blocks;
+	/** Only for uncompressed files */
+	std::unique_ptr<CFileMMapInputStream> m_plain;
 
    public:
 	/** Constructor without open */
@@ -48,9 +63,13 @@ class CFileGZInputStream : public CStream
 
 	/** Opens the file for read.
 	 * \param fileName The file to be open in this stream
+	 * \param numThreads Number of decompression threads for block-compressed
+	 * files (0: as many as cores). The default, one thread, already overlaps
+	 * decompression with the reading of the stream; use more for files read
+	 * faster than a single core decompresses them.
 	 * \return false if there's an error opening the file, true otherwise
 	 */
-	bool open(const std::string& fileName);
+	bool open(const std::string& fileName, std::size_t numThreads = 1);
 	/** Closes the file */
 	void close();
 	/** Returns true if the file was open without errors. */
@@ -59,18 +78,41 @@ class CFileGZInputStream : public CStream
 	bool is_open() { return fileOpenCorrectly(); }
 	/** Will be true if EOF has been already reached. */
 	bool checkEOF();
+	/** Returns true if the open file is gzip-compressed, either as a single
+	 * stream or in independent blocks. */
+	bool isCompressed() const;
+	/** Returns true if the open file is block-compressed (see
+	 * CFileGZOutputStream::openBlockCompressed()), so Seek() is fast. */
+	bool isBlockCompressed() const { return m_blocks != nullptr; }
 
 	/** Method for getting the total number of <b>compressed</b> bytes of in the
 	 * file (the physical size of the compressed file). */
 	uint64_t getTotalBytesCount() const override;
-	/** Method for getting the current cursor position in the <b>compressed</b>,
-	 * where 0 is the first byte and TotalBytesCount-1 the last one. */
+	/** Method for getting the current cursor position in the
+	 * <b>uncompressed</b> stream, where 0 is the first byte. */
 	uint64_t getPosition() const override;
 
-	/** This method is not implemented in this class */
-	uint64_t Seek(int64_t, CStream::TSeekOrigin = sFromBeginning) override;
+	/** Moves the read cursor to a position of the <b>uncompressed</b> stream,
+	 * as returned by getPosition(). In compressed files, seeking forward
+	 * decompresses (but does not return) the skipped data, and seeking
+	 * backward restarts from the beginning of the file; in uncompressed files
+	 * it is a plain file seek. Seeking from the end is not supported.
+	 *
+	 * In block-compressed files, the cost does not depend on the size of the
+	 * skipped data: the first seek past the blocks found so far reads the
+	 * header (a few bytes) of every block in between, and all other seeks are
+	 * a binary search in the block index. The block holding the new position
+	 * (up to 64KB of data) is decompressed by the next Read(), and prefetched
+	 * blocks not ahead of it are dropped, so scattered small seeks and reads
+	 * cost one block decompression each.
+	 * \return The new position
+	 * \exception std::exception On error */
+	uint64_t Seek(
+		int64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning) override;
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
+	/** Only supported in uncompressed files: see CStream::ReadView() */
+	const void* ReadView(size_t Count) override;
 };  // End of class def.
 }  // End of namespace
 }  // end of namespace
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <mrpt/io/CStream.h>
+#include <cstddef>
+#include <memory>
 
 namespace mrpt
 {
@@ -20,13 +22,22 @@ namespace io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileOutputStream
  *
- * \sa CFileOutputStream
+ * Files opened with openBlockCompressed() are written as a sequence of
+ * independent gzip blocks of up to 64KB of data each (the BGZF format of
+ * bgzip/htslib), compressed in parallel by a pool of worker threads. They
+ * are still valid gzip files, and CFileGZInputStream decompresses them in
+ * parallel too, and seeks in them without decompressing the skipped data.
+ *
+ * \sa CFileOutputStream, CFileGZInputStream
  * \ingroup mrpt_io_grp
  */
 class CFileGZOutputStream : public CStream
 {
    private:
 	void* m_f;
+	struct BlockWriter;
+	/** Only for files open with openBlockCompressed() */
+	std::unique_ptr<BlockWriter> m_blocks;
 
    public:
 	/** Constructor: opens an output file with compression level = 1 (minimum,
@@ -53,6 +64,16 @@ class CFileGZOutputStream : public CStream
 	 * \return true on success, false on any error.
 	 */
 	bool open(const std::string& fileName, int compress_level = 1);
+	/** Open a file for write in block-compressed mode (see the class
+	 * description).
+	 * \param fileName The file to be open in this stream
+	 * \param compress_level 0:no compression, 1:fastest, 9:best
+	 * \param numThreads Number of compression threads (0: as many as cores)
+	 * \return true on success, false on any error.
+	 */
+	bool openBlockCompressed(
+		const std::string& fileName, int compress_level = 1,
+		std::size_t numThreads = 1);
 	/** Close the file */
 	void close();
 	/** Returns true if the file was open without errors. */
@@ -0,0 +1,86 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/io/CStream.h>
+
+namespace mrpt
+{
+namespace io
+{
+/** A read-only, binary stream over a memory-mapped file.
+ *
+ * The whole file is mapped in the address space of the process, so reading
+ * costs page faults instead of system calls and intermediary buffers, and
+ * ReadView() (and mrpt::serialization::CArchive::ReadBufferView()) hand out
+ * pointers to the file contents without copying them. Pointers returned by
+ * ReadView() and getRawBufferData() are valid until the file is closed.
+ *
+ * CFileGZInputStream uses this class for uncompressed files.
+ *
+ * \sa CFileInputStream, CFileGZInputStream
+ * \ingroup mrpt_io_grp
+ */
+class CFileMMapInputStream : public CStream
+{
+   private:
+	const uint8_t* m_data{nullptr};
+	uint64_t m_size{0}, m_position{0};
+	bool m_open{false};
+#ifdef _WIN32
+	void* m_hFile{nullptr};
+	void* m_hMapping{nullptr};
+#endif
+
+   public:
+	/** Constructor
+	 * \param fileName The file to be open in this stream
+	 * \exception std::exception On error trying to open the file.
+	 */
+	CFileMMapInputStream(const std::string& fileName);
+	/** Default constructor */
+	CFileMMapInputStream() {}
+
+	CFileMMapInputStream(const CFileMMapInputStream&) = delete;
+	CFileMMapInputStream& operator=(const CFileMMapInputStream&) = delete;
+
+	virtual ~CFileMMapInputStream();
+
+	/** Open and map a file for reading
+	 * \param fileName The file to be open in this stream
+	 * \return true on success.
+	 */
+	bool open(const std::string& fileName);
+	/** Close the stream, unmapping the file */
+	void close();
+	/** Returns true if the file was open without errors. */
+	bool fileOpenCorrectly() const { return m_open; }
+	/** Returns true if the file was open without errors. */
+	bool is_open() { return fileOpenCorrectly(); }
+	/** Will be true if EOF has been already reached. */
+	bool checkEOF() const { return m_position >= m_size; }
+
+	/** Returns a pointer to the whole file contents, whose length is given
+	 * by getTotalBytesCount() (nullptr for empty files). */
+	const void* getRawBufferData() const { return m_data; }
+
+	// See docs in base class
+	uint64_t Seek(
+		int64_t off, CStream::TSeekOrigin Origin = sFromBeginning) override;
+	// See docs in base class
+	uint64_t getTotalBytesCount() const override { return m_size; }
+	// See docs in base class
+	uint64_t getPosition() const override { return m_position; }
+
+	size_t Read(void* Buffer, size_t Count) override;
+	size_t Write(const void* Buffer, size_t Count) override;
+	const void* ReadView(size_t Count) override;
+};  // End of class def.
+}  // namespace io
+}  // namespace mrpt
@@ -28,6 +28,7 @@ class CMemoryStream : public CStream
    public:
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
+	const void* ReadView(size_t Count) override;
 
    protected:
 	/** Internal data */
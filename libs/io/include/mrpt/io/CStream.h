@@ -66,6 +66,20 @@ class CStream
 		return Read(Buffer, Count);
 	}
 
+	/** For streams whose data is already in memory (e.g. CMemoryStream,
+	 * CFileMMapInputStream), returns a pointer to the next Count bytes and
+	 * moves the read position past them, as Read() would, but without
+	 * copying them. The pointer remains valid while the stream is neither
+	 * modified nor closed, and it is not necessarily aligned.
+	 * \return nullptr if the stream does not support it or there are less
+	 * than Count bytes left. The position is then left unchanged.
+	 */
+	virtual const void* ReadView(size_t Count)
+	{
+		MRPT_UNUSED_PARAM(Count);
+		return nullptr;
+	}
+
 	/** Introduces a pure virtual method for moving to a specified position in
 	 *the streamed resource.
 	 *   he Origin parameter indicates how to interpret the Offset parameter.
@@ -10,10 +10,18 @@
 #include "io-precomp.h"  // Precompiled headers
 
 #include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileMMapInputStream.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/core/exceptions.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include "gz_blocks.h"
 
 #include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <map>
 
 using namespace mrpt::io;
 using namespace std;
@@ -25,6 +33,198 @@ static_assert(
 
 #define THE_GZFILE reinterpret_cast<gzFile>(m_f)
 
+// Block-compressed input: the location of blocks is found by reading their
+// headers only, and the next blocks are read and handed to the pool for
+// decompression while the current one is consumed.
+struct CFileGZInputStream::BlockReader
+{
+	struct TBlock
+	{
+		uint64_t compOffset, uncompOffset;
+		uint32_t compSize, uncompSize;
+	};
+
+	std::ifstream f;
+	uint64_t fileSize{0};
+	/** Blocks found so far, in file order */
+	std::vector<TBlock> blocks;
+	/** File offset of the first block not in `blocks` */
+	uint64_t nextBlockOffset{0};
+	bool allBlocksFound{false};
+
+	mrpt::WorkerThreadsPool pool;
+	std::size_t readAhead{2};
+	/** Blocks being decompressed, by block index */
+	std::map<std::size_t, std::future<std::vector<uint8_t>>> prefetched;
+
+	/** Current block, its data (once decompressed) and read position */
+	std::size_t cur{0};
+	bool curLoaded{false};
+	std::vector<uint8_t> curData;
+	std::size_t curPos{0};
+
+	BlockReader(std::ifstream&& file, uint64_t size, std::size_t numThreads)
+		: f(std::move(file)), fileSize(size), pool(numThreads)
+	{
+		readAhead = std::max<std::size_t>(2, 2 * pool.size());
+	}
+
+	void readAt(uint64_t offset, void* buf, std::size_t len)
+	{
+		f.clear();
+		f.seekg(static_cast<std::streamoff>(offset));
+		f.read(reinterpret_cast<char*>(buf), len);
+		if (!f) THROW_EXCEPTION("Error reading compressed file");
+	}
+
+	/** Locates the next block. Returns false at the end of the file. */
+	bool findNextBlock()
+	{
+		if (allBlocksFound) return false;
+		if (nextBlockOffset + internal::GZ_BLOCK_HEADER_PREFIX > fileSize)
+		{
+			allBlocksFound = true;
+			return false;
+		}
+		uint8_t prefix[internal::GZ_BLOCK_HEADER_PREFIX];
+		readAt(nextBlockOffset, prefix, sizeof(prefix));
+		const int extraLen = internal::gzBlockExtraLength(prefix);
+		std::vector<uint8_t> extra(std::max(extraLen, 0));
+		if (extraLen > 0)
+			readAt(
+				nextBlockOffset + sizeof(prefix), extra.data(), extra.size());
+		const std::size_t blockSize =
+			extraLen < 0 ? 0 : internal::gzBlockSize(extra.data(), extraLen);
+		if (!blockSize || nextBlockOffset + blockSize > fileSize)
+			THROW_EXCEPTION("Invalid block in block-compressed file");
+
+		uint8_t trailer[internal::GZ_BLOCK_TRAILER_SIZE];
+		readAt(
+			nextBlockOffset + blockSize - sizeof(trailer), trailer,
+			sizeof(trailer));
+		TBlock b;
+		b.compOffset = nextBlockOffset;
+		b.compSize = static_cast<uint32_t>(blockSize);
+		b.uncompOffset = blocks.empty() ? 0
+										: blocks.back().uncompOffset +
+											  blocks.back().uncompSize;
+		b.uncompSize = internal::gzBlockDataLength(trailer);
+		blocks.push_back(b);
+		nextBlockOffset += blockSize;
+		return true;
+	}
+
+	/** Reads and enqueues for decompression the blocks after the current
+	 * one, and drops those no longer needed. */
+	void prefetch()
+	{
+		while (!prefetched.empty() && prefetched.begin()->first < cur)
+			prefetched.erase(prefetched.begin());
+		for (std::size_t i = cur; i < cur + readAhead; i++)
+		{
+			if (i >= blocks.size() && !findNextBlock()) break;
+			if (prefetched.count(i) || (i == cur && curLoaded)) continue;
+			const TBlock& b = blocks[i];
+			std::vector<uint8_t> comp(b.compSize);
+			readAt(b.compOffset, comp.data(), comp.size());
+			prefetched[i] = pool.enqueue(
+				[](const std::vector<uint8_t>& block) {
+					std::vector<uint8_t> data;
+					internal::gzDecompressBlock(
+						block.data(), block.size(), data);
+					return data;
+				},
+				std::move(comp));
+		}
+	}
+
+	/** Makes the current block to have unread data, moving to the next
+	 * blocks as needed. Returns false at the end of the file. */
+	bool loadCurrent()
+	{
+		for (;;)
+		{
+			if (curLoaded && curPos < curData.size()) return true;
+			if (curLoaded)
+			{
+				cur++;
+				curPos = 0;
+				curLoaded = false;
+			}
+			prefetch();
+			auto it = prefetched.find(cur);
+			if (it == prefetched.end()) return false;  // EOF
+			curData = it->second.get();
+			prefetched.erase(it);
+			curLoaded = true;
+		}
+	}
+
+	std::size_t read(void* buffer, std::size_t count)
+	{
+		auto* out = static_cast<uint8_t*>(buffer);
+		std::size_t done = 0;
+		while (done < count && loadCurrent())
+		{
+			const std::size_t n =
+				std::min(count - done, curData.size() - curPos);
+			std::memcpy(out + done, &curData[curPos], n);
+			curPos += n;
+			done += n;
+		}
+		return done;
+	}
+
+	uint64_t position() const
+	{
+		if (cur < blocks.size()) return blocks[cur].uncompOffset + curPos;
+		return blocks.empty() ? 0
+							  : blocks.back().uncompOffset +
+									blocks.back().uncompSize;
+	}
+
+	uint64_t seek(uint64_t pos)
+	{
+		// Locate the block, finding more of them if needed:
+		while (allBlocksFound == false &&
+			   (blocks.empty() || blocks.back().uncompOffset +
+									  blocks.back().uncompSize <=
+								  pos))
+			findNextBlock();
+		auto it = std::upper_bound(
+			blocks.begin(), blocks.end(), pos,
+			[](uint64_t p, const TBlock& b) { return p < b.uncompOffset; });
+		ASSERTMSG_(
+			it != blocks.begin() && pos <= position_end(),
+			"Seek beyond the end of the file");
+		std::size_t idx = std::distance(blocks.begin(), it) - 1;
+		// Skip empty blocks (e.g. the EOF marker) and past-the-end positions:
+		while (idx + 1 < blocks.size() &&
+			   pos >= blocks[idx].uncompOffset + blocks[idx].uncompSize)
+			idx++;
+		if (idx != cur)
+		{
+			cur = idx;
+			curLoaded = false;
+			curData.clear();
+			// Keep only the prefetched blocks still ahead:
+			for (auto p = prefetched.begin(); p != prefetched.end();)
+				if (p->first < cur || p->first >= cur + readAhead)
+					p = prefetched.erase(p);
+				else
+					++p;
+		}
+		curPos = pos - blocks[cur].uncompOffset;
+		return pos;
+	}
+	uint64_t position_end() const
+	{
+		return blocks.empty() ? 0
+							  : blocks.back().uncompOffset +
+									blocks.back().uncompSize;
+	}
+};
+
 CFileGZInputStream::CFileGZInputStream(const string& fileName) : m_f(nullptr)
 {
 	MRPT_START
@@ -33,17 +233,56 @@ CFileGZInputStream::CFileGZInputStream(const string& fileName) : m_f(nullptr)
 }
 
 CFileGZInputStream::CFileGZInputStream() : m_f(nullptr) {}
-bool CFileGZInputStream::open(const std::string& fileName)
+bool CFileGZInputStream::open(
+	const std::string& fileName, std::size_t numThreads)
 {
 	MRPT_START
 
-	if (m_f) gzclose(THE_GZFILE);
+	close();
 
 	// Get compressed file size:
 	m_file_size = mrpt::system::getFileSize(fileName);
 	if (m_file_size == uint64_t(-1))
 		THROW_EXCEPTION_FMT("Couldn't access the file '%s'", fileName.c_str());
 
+	// Is it block-compressed?
+	std::ifstream f(fileName, std::ios::binary);
+	if (!f.is_open()) return false;
+	char prefix[internal::GZ_BLOCK_HEADER_PREFIX];
+	std::vector<char> extra;
+	bool isBlockCompressed = false;
+	f.read(prefix, sizeof(prefix));
+	const bool isGZ = f.gcount() >= 2 && uint8_t(prefix[0]) == 0x1f &&
+					  uint8_t(prefix[1]) == 0x8b;
+	if (f)
+	{
+		const int extraLen = internal::gzBlockExtraLength(
+			reinterpret_cast<const uint8_t*>(prefix));
+		if (extraLen > 0)
+		{
+			extra.resize(extraLen);
+			isBlockCompressed =
+				f.read(extra.data(), extra.size()) &&
+				internal::gzBlockSize(
+					reinterpret_cast<const uint8_t*>(extra.data()),
+					extra.size()) != 0;
+		}
+	}
+	if (isBlockCompressed)
+	{
+		m_blocks.reset(new BlockReader(std::move(f), m_file_size, numThreads));
+		return true;
+	}
+	f.close();
+
+	// Map uncompressed files, if possible:
+	if (!isGZ)
+	{
+		m_plain.reset(new CFileMMapInputStream);
+		if (m_plain->open(fileName)) return true;
+		m_plain.reset();
+	}
+
 	// Open gz stream:
 	m_f = gzopen(fileName.c_str(), "rb");
 	return m_f != nullptr;
@@ -53,6 +292,8 @@ bool CFileGZInputStream::open(const std::string& fileName)
 
 void CFileGZInputStream::close()
 {
+	m_blocks.reset();
+	m_plain.reset();
 	if (m_f)
 	{
 		gzclose(THE_GZFILE);
@@ -63,6 +304,8 @@ void CFileGZInputStream::close()
 CFileGZInputStream::~CFileGZInputStream() { close(); }
 size_t CFileGZInputStream::Read(void* Buffer, size_t Count)
 {
+	if (m_blocks) return m_blocks->read(Buffer, Count);
+	if (m_plain) return m_plain->Read(Buffer, Count);
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -71,6 +314,11 @@ size_t CFileGZInputStream::Read(void* Buffer, size_t Count)
 	return gzread(THE_GZFILE, Buffer, Count);
 }
 
+const void* CFileGZInputStream::ReadView(size_t Count)
+{
+	return m_plain ? m_plain->ReadView(Count) : nullptr;
+}
+
 size_t CFileGZInputStream::Write(const void* Buffer, size_t Count)
 {
 	MRPT_UNUSED_PARAM(Buffer);
@@ -80,7 +328,7 @@ size_t CFileGZInputStream::Write(const void* Buffer, size_t Count)
 
 uint64_t CFileGZInputStream::getTotalBytesCount() const
 {
-	if (!m_f)
+	if (!fileOpenCorrectly())
 	{
 		THROW_EXCEPTION("File is not open.");
 	}
@@ -89,6 +337,8 @@ uint64_t CFileGZInputStream::getTotalBytesCount() const
 
 uint64_t CFileGZInputStream::getPosition() const
 {
+	if (m_blocks) return m_blocks->position();
+	if (m_plain) return m_plain->getPosition();
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -96,16 +346,60 @@ uint64_t CFileGZInputStream::getPosition() const
 	return gztell(THE_GZFILE);
 }
 
-bool CFileGZInputStream::fileOpenCorrectly() const { return m_f != nullptr; }
+bool CFileGZInputStream::fileOpenCorrectly() const
+{
+	return m_f != nullptr || m_blocks != nullptr || m_plain != nullptr;
+}
+bool CFileGZInputStream::isCompressed() const
+{
+	if (m_blocks) return true;
+	return m_f != nullptr && gzdirect(THE_GZFILE) == 0;
+}
 bool CFileGZInputStream::checkEOF()
 {
+	if (m_blocks) return !m_blocks->loadCurrent();
+	if (m_plain) return m_plain->checkEOF();
 	if (!m_f)
 		return true;
 	else
 		return 0 != gzeof(THE_GZFILE);
 }
 
-uint64_t CFileGZInputStream::Seek(int64_t, CStream::TSeekOrigin)
+uint64_t CFileGZInputStream::Seek(int64_t Offset, CStream::TSeekOrigin Origin)
 {
-	THROW_EXCEPTION("Method not available in this class.");
+	if (m_blocks)
+	{
+		if (Origin == sFromCurrent)
+			Offset += m_blocks->position();
+		else if (Origin != sFromBeginning)
+			THROW_EXCEPTION("Seek from the end is not supported in gz files.");
+		ASSERT_(Offset >= 0);
+		return m_blocks->seek(static_cast<uint64_t>(Offset));
+	}
+	if (m_plain)
+	{
+		if (Origin == sFromEnd)
+			THROW_EXCEPTION("Seek from the end is not supported in gz files.");
+		return m_plain->Seek(Offset, Origin);
+	}
+	if (!m_f)
+	{
+		THROW_EXCEPTION("File is not open.");
+	}
+	int whence;
+	switch (Origin)
+	{
+		case sFromBeginning:
+			whence = SEEK_SET;
+			break;
+		case sFromCurrent:
+			whence = SEEK_CUR;
+			break;
+		default:
+			THROW_EXCEPTION("Seek from the end is not supported in gz files.");
+	};
+	const auto ret = gzseek(THE_GZFILE, Offset, whence);
+	if (ret < 0)
+		THROW_EXCEPTION_FMT("gzseek() failed to offset %li", (long)Offset);
+	return ret;
 }
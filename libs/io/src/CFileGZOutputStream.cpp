@@ -11,14 +11,109 @@
 
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/core/exceptions.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include "gz_blocks.h"
 
 #include <zlib.h>
+#include <deque>
+#include <fstream>
+#include <future>
 
 #define THE_GZFILE reinterpret_cast<gzFile>(m_f)
 
 using namespace mrpt::io;
 using namespace std;
 
+// Block-compressed output: blocks are compressed by the pool, and written
+// in order as they are finished.
+struct CFileGZOutputStream::BlockWriter
+{
+	std::ofstream f;
+	int level{1};
+	mrpt::WorkerThreadsPool pool;
+	/** Blocks being compressed, in file order */
+	std::deque<std::future<std::vector<uint8_t>>> pending;
+	std::size_t maxPending{2};
+	/** Data of the current block */
+	std::vector<uint8_t> buf;
+	uint64_t totalWritten{0};
+
+	BlockWriter(
+		std::ofstream&& file, int compress_level, std::size_t numThreads)
+		: f(std::move(file)), level(compress_level), pool(numThreads)
+	{
+		maxPending = 4 * pool.size();
+		buf.reserve(internal::GZ_BLOCK_MAX_INPUT);
+	}
+	~BlockWriter()
+	{
+		try
+		{
+			close();
+		}
+		catch (std::exception&)
+		{
+		}
+	}
+
+	void writeBytes(const std::vector<uint8_t>& b)
+	{
+		f.write(reinterpret_cast<const char*>(b.data()), b.size());
+		if (!f) THROW_EXCEPTION("Error writing to compressed file");
+	}
+	// Writes finished blocks while more than `maxLeft` are pending:
+	void flushPending(std::size_t maxLeft)
+	{
+		while (pending.size() > maxLeft)
+		{
+			writeBytes(pending.front().get());
+			pending.pop_front();
+		}
+	}
+	void submitBlock()
+	{
+		if (buf.empty()) return;
+		pending.emplace_back(pool.enqueue(
+			[l = level](const std::vector<uint8_t>& data) {
+				return internal::gzCompressBlock(data.data(), data.size(), l);
+			},
+			std::move(buf)));
+		buf.clear();
+		buf.reserve(internal::GZ_BLOCK_MAX_INPUT);
+		flushPending(maxPending);
+	}
+	void write(const uint8_t* data, std::size_t len)
+	{
+		totalWritten += len;
+		while (len)
+		{
+			const std::size_t n =
+				std::min(len, internal::GZ_BLOCK_MAX_INPUT - buf.size());
+			buf.insert(buf.end(), data, data + n);
+			data += n;
+			len -= n;
+			if (buf.size() == internal::GZ_BLOCK_MAX_INPUT) submitBlock();
+		}
+	}
+	void close()
+	{
+		if (!f.is_open()) return;
+		try
+		{
+			submitBlock();
+			flushPending(0);
+			writeBytes(internal::gzEOFBlock());
+		}
+		catch (std::exception&)
+		{
+			f.close();
+			throw;
+		}
+		f.close();
+		if (!f) THROW_EXCEPTION("Error closing compressed file");
+	}
+};
+
 CFileGZOutputStream::CFileGZOutputStream(const string& fileName) : m_f(nullptr)
 {
 	MRPT_START
@@ -33,7 +128,7 @@ bool CFileGZOutputStream::open(const string& fileName, int compress_level)
 {
 	MRPT_START
 
-	if (m_f) gzclose(THE_GZFILE);
+	close();
 
 	// Open gz stream:
 	m_f = gzopen(fileName.c_str(), format("wb%i", compress_level).c_str());
@@ -42,7 +137,27 @@ bool CFileGZOutputStream::open(const string& fileName, int compress_level)
 	MRPT_END
 }
 
-CFileGZOutputStream::~CFileGZOutputStream() { close(); }
+bool CFileGZOutputStream::openBlockCompressed(
+	const std::string& fileName, int compress_level, std::size_t numThreads)
+{
+	MRPT_START
+
+	close();
+
+	std::ofstream f(fileName, std::ios::binary | std::ios::trunc);
+	if (!f.is_open()) return false;
+	m_blocks.reset(new BlockWriter(std::move(f), compress_level, numThreads));
+	return true;
+
+	MRPT_END
+}
+
+CFileGZOutputStream::~CFileGZOutputStream()
+{
+	// Errors are not reported from the destructor; call close() to get them.
+	m_blocks.reset();
+	close();
+}
 void CFileGZOutputStream::close()
 {
 	if (m_f)
@@ -50,6 +165,13 @@ void CFileGZOutputStream::close()
 		gzclose(THE_GZFILE);
 		m_f = nullptr;
 	}
+	if (m_blocks)
+	{
+		// Close the file even if writing its last blocks fails:
+		std::unique_ptr<BlockWriter> blocks;
+		blocks.swap(m_blocks);
+		blocks->close();
+	}
 }
 
 size_t CFileGZOutputStream::Read(void*, size_t)
@@ -59,6 +181,11 @@ size_t CFileGZOutputStream::Read(void*, size_t)
 
 size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 {
+	if (m_blocks)
+	{
+		m_blocks->write(static_cast<const uint8_t*>(Buffer), Count);
+		return Count;
+	}
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -68,6 +195,7 @@ size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 
 uint64_t CFileGZOutputStream::getPosition() const
 {
+	if (m_blocks) return m_blocks->totalWritten;
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -75,7 +203,10 @@ uint64_t CFileGZOutputStream::getPosition() const
 	return gztell(THE_GZFILE);
 }
 
-bool CFileGZOutputStream::fileOpenCorrectly() const { return m_f != nullptr; }
+bool CFileGZOutputStream::fileOpenCorrectly() const
+{
+	return m_f != nullptr || m_blocks != nullptr;
+}
 uint64_t CFileGZOutputStream::Seek(int64_t, CStream::TSeekOrigin)
 {
 	THROW_EXCEPTION("Method not available in this class.");
@@ -0,0 +1,121 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/zip.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace std;
+
+namespace
+{
+// Compressible test data, with some incompressible stretches:
+std::vector<uint8_t> testData(size_t N)
+{
+	std::vector<uint8_t> d(N);
+	uint32_t r = 12345;
+	for (size_t i = 0; i < N; i++)
+	{
+		r = r * 1103515245 + 12345;
+		d[i] = ((i / 100000) % 3 == 0) ? uint8_t(r >> 24) : uint8_t(i / 7);
+	}
+	return d;
+}
+
+void writeInChunks(CFileGZOutputStream& f, const std::vector<uint8_t>& d)
+{
+	size_t i = 0, chunk = 1;
+	while (i < d.size())
+	{
+		const size_t n = std::min(chunk, d.size() - i);
+		f.Write(&d[i], n);
+		i += n;
+		chunk = (chunk * 7 + 3) % 150000;
+	}
+	EXPECT_EQ(f.getPosition(), d.size());
+}
+}  // namespace
+
+TEST(CFileGZStreams, blockCompressedRoundTrip)
+{
+	const auto data = testData(1000000);
+	const std::string file = mrpt::system::getTempFileName() + ".gz";
+
+	for (size_t numThreads : {1, 4})
+	{
+		{
+			CFileGZOutputStream fo;
+			ASSERT_TRUE(fo.openBlockCompressed(file, 1, numThreads));
+			writeInChunks(fo, data);
+		}
+
+		// Parallel decompression:
+		CFileGZInputStream fi;
+		ASSERT_TRUE(fi.open(file, numThreads));
+		std::vector<uint8_t> rd(data.size() + 10);
+		EXPECT_EQ(fi.Read(&rd[0], 1), 1u);
+		EXPECT_EQ(fi.Read(&rd[1], rd.size() - 1), data.size() - 1);
+		rd.resize(data.size());
+		EXPECT_TRUE(rd == data);
+		EXPECT_TRUE(fi.checkEOF());
+		EXPECT_EQ(fi.getPosition(), data.size());
+		fi.close();
+
+		// It is a valid gzip file for standard readers:
+		std::vector<uint8_t> rd2;
+		ASSERT_TRUE(mrpt::io::zip::decompress_gz_file(file, rd2));
+		EXPECT_TRUE(rd2 == data);
+	}
+	mrpt::system::deleteFile(file);
+}
+
+TEST(CFileGZStreams, seek)
+{
+	const auto data = testData(500000);
+	const std::string blockFile = mrpt::system::getTempFileName() + ".gz";
+	const std::string gzFile = mrpt::system::getTempFileName() + ".gz";
+	{
+		CFileGZOutputStream fo;
+		ASSERT_TRUE(fo.openBlockCompressed(blockFile));
+		writeInChunks(fo, data);
+		CFileGZOutputStream fo2(gzFile);
+		writeInChunks(fo2, data);
+	}
+
+	for (const auto& file : {blockFile, gzFile})
+	{
+		CFileGZInputStream fi(file);
+		EXPECT_TRUE(fi.isCompressed());
+		EXPECT_EQ(fi.isBlockCompressed(), file == blockFile);
+		for (uint64_t pos : {400000, 10, 0, 65280, 65279, 499999, 200000})
+		{
+			EXPECT_EQ(fi.Seek(pos), pos);
+			EXPECT_EQ(fi.getPosition(), pos);
+			uint8_t buf[1000];
+			const size_t n = fi.Read(buf, sizeof(buf));
+			ASSERT_EQ(n, std::min<size_t>(sizeof(buf), data.size() - pos));
+			EXPECT_TRUE(std::equal(buf, buf + n, &data[pos])) << pos;
+		}
+		// Relative seeks:
+		fi.Seek(1000);
+		EXPECT_EQ(fi.Seek(100000, CStream::sFromCurrent), 101000u);
+		uint8_t b;
+		ASSERT_EQ(fi.Read(&b, 1), 1u);
+		EXPECT_EQ(b, data[101000]);
+		// The end of the file:
+		EXPECT_EQ(fi.Seek(data.size()), data.size());
+		EXPECT_EQ(fi.Read(&b, 1), 0u);
+	}
+	mrpt::system::deleteFile(blockFile);
+	mrpt::system::deleteFile(gzFile);
+}
@@ -0,0 +1,167 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"  // Precompiled headers
+
+#include <mrpt/io/CFileMMapInputStream.h>
+#include <mrpt/core/exceptions.h>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mrpt::io;
+using namespace std;
+
+static_assert(
+	!std::is_copy_constructible<CFileMMapInputStream>::value &&
+		!std::is_copy_assignable<CFileMMapInputStream>::value,
+	"Copy Check");
+
+CFileMMapInputStream::CFileMMapInputStream(const string& fileName)
+{
+	MRPT_START
+	if (!open(fileName))
+		THROW_EXCEPTION_FMT(
+			"Error trying to open file: '%s'", fileName.c_str());
+	MRPT_END
+}
+
+CFileMMapInputStream::~CFileMMapInputStream() { close(); }
+bool CFileMMapInputStream::open(const string& fileName)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(
+		fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size))
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+	m_hFile = hFile;
+	m_size = static_cast<uint64_t>(size.QuadPart);
+	// Empty files cannot be mapped:
+	if (m_size > 0)
+	{
+		m_hMapping =
+			CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_hMapping)
+			m_data = static_cast<const uint8_t*>(
+				MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_data)
+		{
+			close();
+			return false;
+		}
+	}
+#else
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		::close(fd);
+		return false;
+	}
+	m_size = static_cast<uint64_t>(st.st_size);
+	// Empty files cannot be mapped:
+	if (m_size > 0)
+	{
+		void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			::close(fd);
+			m_size = 0;
+			return false;
+		}
+		// Most reads are sequential: ask for a larger read-ahead.
+		::madvise(p, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const uint8_t*>(p);
+	}
+	// The mapping remains valid after closing the file:
+	::close(fd);
+#endif
+	m_position = 0;
+	m_open = true;
+	return true;
+}
+
+void CFileMMapInputStream::close()
+{
+#ifdef _WIN32
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_hMapping) CloseHandle(m_hMapping);
+	if (m_hFile) CloseHandle(m_hFile);
+	m_hMapping = nullptr;
+	m_hFile = nullptr;
+#else
+	if (m_data) ::munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = m_position = 0;
+	m_open = false;
+}
+
+size_t CFileMMapInputStream::Read(void* Buffer, size_t Count)
+{
+	if (m_position >= m_size) return 0;
+	const size_t n =
+		static_cast<size_t>(std::min<uint64_t>(Count, m_size - m_position));
+	::memcpy(Buffer, m_data + m_position, n);
+	m_position += n;
+	return n;
+}
+
+const void* CFileMMapInputStream::ReadView(size_t Count)
+{
+	if (m_position > m_size || Count > m_size - m_position) return nullptr;
+	const void* ret = m_data + m_position;
+	m_position += Count;
+	return ret;
+}
+
+size_t CFileMMapInputStream::Write(const void* Buffer, size_t Count)
+{
+	MRPT_UNUSED_PARAM(Buffer);
+	MRPT_UNUSED_PARAM(Count);
+	THROW_EXCEPTION("Trying to write to a read file stream.");
+}
+
+uint64_t CFileMMapInputStream::Seek(int64_t Offset, CStream::TSeekOrigin Origin)
+{
+	if (!m_open) THROW_EXCEPTION("File is not open.");
+	int64_t pos = Offset;
+	switch (Origin)
+	{
+		case sFromBeginning:
+			break;
+		case sFromCurrent:
+			pos += static_cast<int64_t>(m_position);
+			break;
+		case sFromEnd:
+			pos += static_cast<int64_t>(m_size);
+			break;
+	};
+	ASSERTMSG_(
+		pos >= 0 && static_cast<uint64_t>(pos) <= m_size,
+		"Seek beyond the limits of the file");
+	m_position = static_cast<uint64_t>(pos);
+	return m_position;
+}
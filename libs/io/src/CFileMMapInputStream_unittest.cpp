@@ -0,0 +1,114 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/io/CFileMMapInputStream.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+#include <cstring>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace std;
+
+namespace
+{
+const std::string writeTestFile(const std::vector<float>& v)
+{
+	const std::string file = mrpt::system::getTempFileName();
+	CFileOutputStream fo(file);
+	const uint32_t N = v.size();
+	fo.Write(&N, sizeof(N));
+	fo.Write(v.data(), sizeof(float) * N);
+	return file;
+}
+}  // namespace
+
+TEST(CFileMMapInputStream, ReadSeekAndViews)
+{
+	std::vector<float> v(100000);
+	for (size_t i = 0; i < v.size(); i++) v[i] = i * 0.5f;
+	const auto file = writeTestFile(v);
+	const size_t fileLen = sizeof(uint32_t) + sizeof(float) * v.size();
+
+	CFileMMapInputStream f(file);
+	EXPECT_EQ(f.getTotalBytesCount(), fileLen);
+	uint32_t N;
+	ASSERT_EQ(f.Read(&N, sizeof(N)), sizeof(N));
+	ASSERT_EQ(N, v.size());
+	// The view points to the mapped file contents:
+	const void* view = f.ReadView(sizeof(float) * N);
+	ASSERT_TRUE(view != nullptr);
+	EXPECT_EQ(
+		static_cast<const uint8_t*>(view),
+		static_cast<const uint8_t*>(f.getRawBufferData()) + sizeof(uint32_t));
+	EXPECT_EQ(0, std::memcmp(view, v.data(), sizeof(float) * N));
+	EXPECT_TRUE(f.checkEOF());
+	// No view beyond the end, nor any change of position:
+	EXPECT_TRUE(f.ReadView(1) == nullptr);
+	EXPECT_EQ(f.getPosition(), fileLen);
+
+	// Reads and seeks:
+	EXPECT_EQ(f.Seek(sizeof(uint32_t) + 4 * sizeof(float)), 20u);
+	float x;
+	EXPECT_EQ(f.Read(&x, sizeof(x)), sizeof(x));
+	EXPECT_EQ(x, v[4]);
+	EXPECT_EQ(f.Seek(-8, CStream::sFromEnd), fileLen - 8);
+	float last[3];
+	EXPECT_EQ(f.Read(last, sizeof(last)), 8u);
+	EXPECT_EQ(last[1], v.back());
+	EXPECT_EQ(f.Read(last, sizeof(last)), 0u);
+	f.close();
+	EXPECT_FALSE(f.fileOpenCorrectly());
+
+	// Uncompressed files read through CFileGZInputStream support views too:
+	CFileGZInputStream fgz(file);
+	EXPECT_FALSE(fgz.isCompressed());
+	EXPECT_FALSE(fgz.isBlockCompressed());
+	fgz.Seek(sizeof(uint32_t));
+	view = fgz.ReadView(sizeof(float) * N);
+	ASSERT_TRUE(view != nullptr);
+	EXPECT_EQ(0, std::memcmp(view, v.data(), sizeof(float) * N));
+	fgz.close();
+
+	// ... but compressed files do not:
+	const std::string gzFile = file + ".gz";
+	{
+		CFileGZOutputStream fo(gzFile);
+		fo.Write(v.data(), sizeof(float) * N);
+	}
+	fgz.open(gzFile);
+	EXPECT_TRUE(fgz.ReadView(4) == nullptr);
+	EXPECT_EQ(fgz.getPosition(), 0u);
+	fgz.close();
+
+	mrpt::system::deleteFile(file);
+	mrpt::system::deleteFile(gzFile);
+}
+
+TEST(CFileMMapInputStream, EmptyAndMissingFiles)
+{
+	const std::string file = mrpt::system::getTempFileName();
+	{
+		CFileOutputStream fo(file);
+	}
+	CFileMMapInputStream f;
+	EXPECT_TRUE(f.open(file));
+	EXPECT_EQ(f.getTotalBytesCount(), 0u);
+	EXPECT_TRUE(f.checkEOF());
+	uint8_t b;
+	EXPECT_EQ(f.Read(&b, 1), 0u);
+	EXPECT_TRUE(f.ReadView(1) == nullptr);
+	mrpt::system::deleteFile(file);
+
+	EXPECT_FALSE(f.open(file));
+	EXPECT_FALSE(f.fileOpenCorrectly());
+}
@@ -95,6 +95,14 @@ size_t CMemoryStream::Read(void* Buffer, size_t Count)
 	return nToRead;
 }
 
+const void* CMemoryStream::ReadView(size_t Count)
+{
+	if (m_position > m_size || Count > m_size - m_position) return nullptr;
+	const void* ret = ((char*)m_memory.get()) + m_position;
+	m_position += Count;
+	return ret;
+}
+
 size_t CMemoryStream::Write(const void* Buffer, size_t Count)
 {
 	// Enought space in current bufer?
@@ -12,3 +12,14 @@
 
 MRPT_TODO("implement tests!");
 TEST(CMemoryStream, readwrite) {}
+
+TEST(CMemoryStream, ReadView)
+{
+	const uint8_t data[] = {1, 2, 3, 4, 5};
+	mrpt::io::CMemoryStream m;
+	m.assignMemoryNotOwn(data, sizeof(data));
+	EXPECT_EQ(m.ReadView(2), &data[0]);
+	EXPECT_EQ(m.ReadView(3), &data[2]);
+	EXPECT_TRUE(m.ReadView(1) == nullptr);
+	EXPECT_EQ(m.getPosition(), sizeof(data));
+}
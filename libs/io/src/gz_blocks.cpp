@@ -0,0 +1,158 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"  // Precompiled headers
+
+#include "gz_blocks.h"
+#include <mrpt/core/exceptions.h>
+
+#include <zlib.h>
+
+using namespace mrpt::io::internal;
+
+static void writeLE16(uint8_t* p, uint32_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+static void writeLE32(uint8_t* p, uint32_t v)
+{
+	writeLE16(p, v);
+	writeLE16(p + 2, v >> 16);
+}
+
+// Raw deflate of the whole input. Returns false if it does not fit in
+// outMax bytes.
+static bool rawDeflate(
+	const uint8_t* data, std::size_t len, int level, uint8_t* out,
+	std::size_t outMax, std::size_t& outLen)
+{
+	z_stream zs;
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	// Negative window bits: raw deflate, without zlib header.
+	if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+		Z_OK)
+		THROW_EXCEPTION("deflateInit2() failed");
+	zs.next_in = const_cast<Bytef*>(data);
+	zs.avail_in = static_cast<uInt>(len);
+	zs.next_out = out;
+	zs.avail_out = static_cast<uInt>(outMax);
+	const int ret = deflate(&zs, Z_FINISH);
+	outLen = zs.total_out;
+	deflateEnd(&zs);
+	return ret == Z_STREAM_END;
+}
+
+std::vector<uint8_t> mrpt::io::internal::gzCompressBlock(
+	const uint8_t* data, std::size_t len, int compress_level)
+{
+	ASSERT_(len <= GZ_BLOCK_MAX_INPUT);
+	// The block size must fit in the 16 bits of the BSIZE field:
+	const std::size_t maxBlock = 0x10000;
+	std::vector<uint8_t> blk(maxBlock);
+
+	std::size_t compLen = 0;
+	const std::size_t maxComp =
+		maxBlock - GZ_BLOCK_HEADER_SIZE - GZ_BLOCK_TRAILER_SIZE;
+	if (!rawDeflate(
+			data, len, compress_level, &blk[GZ_BLOCK_HEADER_SIZE], maxComp,
+			compLen))
+	{
+		// Incompressible data: stored blocks always fit.
+		if (!rawDeflate(
+				data, len, 0, &blk[GZ_BLOCK_HEADER_SIZE], maxComp, compLen))
+			THROW_EXCEPTION("deflate() failed");
+	}
+	const std::size_t blockLen =
+		GZ_BLOCK_HEADER_SIZE + compLen + GZ_BLOCK_TRAILER_SIZE;
+	blk.resize(blockLen);
+
+	// gzip header, with FEXTRA and the "BC" subfield holding BSIZE:
+	const uint8_t header[GZ_BLOCK_HEADER_SIZE] = {
+		0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0};
+	std::copy(header, header + GZ_BLOCK_HEADER_SIZE, blk.begin());
+	writeLE16(&blk[16], static_cast<uint32_t>(blockLen - 1));
+
+	// Trailer:
+	const uLong crc =
+		crc32(crc32(0L, Z_NULL, 0), data, static_cast<uInt>(len));
+	writeLE32(&blk[blockLen - 8], static_cast<uint32_t>(crc));
+	writeLE32(&blk[blockLen - 4], static_cast<uint32_t>(len));
+	return blk;
+}
+
+const std::vector<uint8_t>& mrpt::io::internal::gzEOFBlock()
+{
+	static const std::vector<uint8_t> eof = gzCompressBlock(nullptr, 0, 1);
+	return eof;
+}
+
+int mrpt::io::internal::gzBlockExtraLength(const uint8_t* prefix)
+{
+	if (prefix[0] != 0x1f || prefix[1] != 0x8b || prefix[2] != 8 ||
+		(prefix[3] & 4) == 0)
+		return -1;
+	return int(prefix[10]) | (int(prefix[11]) << 8);
+}
+
+std::size_t mrpt::io::internal::gzBlockSize(
+	const uint8_t* extra, std::size_t extraLen)
+{
+	// Look for the "BC" subfield:
+	std::size_t i = 0;
+	while (i + 4 <= extraLen)
+	{
+		const std::size_t sLen = extra[i + 2] | (extra[i + 3] << 8);
+		if (extra[i] == 'B' && extra[i + 1] == 'C' && sLen == 2 &&
+			i + 6 <= extraLen)
+			return (extra[i + 4] | (extra[i + 5] << 8)) + 1;
+		i += 4 + sLen;
+	}
+	return 0;
+}
+
+void mrpt::io::internal::gzDecompressBlock(
+	const uint8_t* block, std::size_t blockLen, std::vector<uint8_t>& out)
+{
+	const int extraLen = gzBlockExtraLength(block);
+	ASSERT_(extraLen >= 0);
+	const std::size_t dataStart = GZ_BLOCK_HEADER_PREFIX + extraLen;
+	ASSERT_(blockLen >= dataStart + GZ_BLOCK_TRAILER_SIZE);
+	const uint8_t* trailer = block + blockLen - GZ_BLOCK_TRAILER_SIZE;
+	out.resize(gzBlockDataLength(trailer));
+
+	z_stream zs;
+	zs.zalloc = Z_NULL;
+	zs.zfree = Z_NULL;
+	zs.opaque = Z_NULL;
+	zs.next_in = const_cast<Bytef*>(block + dataStart);
+	zs.avail_in =
+		static_cast<uInt>(blockLen - dataStart - GZ_BLOCK_TRAILER_SIZE);
+	if (inflateInit2(&zs, -15) != Z_OK)
+		THROW_EXCEPTION("inflateInit2() failed");
+	uint8_t dummy;  // zlib does not accept a null output buffer
+	zs.next_out = out.empty() ? &dummy : out.data();
+	zs.avail_out = static_cast<uInt>(out.size());
+	const int ret = inflate(&zs, Z_FINISH);
+	const auto nOut = zs.total_out;
+	inflateEnd(&zs);
+	if (ret != Z_STREAM_END || nOut != out.size())
+		THROW_EXCEPTION("Corrupted data in compressed block");
+
+	const uLong crc =
+		crc32(crc32(0L, Z_NULL, 0), out.data(), static_cast<uInt>(out.size()));
+	const uint32_t storedCrc = uint32_t(trailer[0]) |
+							   (uint32_t(trailer[1]) << 8) |
+							   (uint32_t(trailer[2]) << 16) |
+							   (uint32_t(trailer[3]) << 24);
+	if (static_cast<uint32_t>(crc) != storedCrc)
+		THROW_EXCEPTION("CRC error in compressed block");
+}
@@ -0,0 +1,69 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mrpt
+{
+namespace io
+{
+namespace internal
+{
+/** \defgroup gz_blocks Block-compressed gzip files (BGZF)
+ * A block-compressed file is a sequence of independent gzip members (the
+ * BGZF format, as in bgzip or htslib), each holding up to
+ * GZ_BLOCK_MAX_INPUT bytes of data and with its own size stored in an
+ * extra header field, plus an empty block as end-of-file marker. Any gzip
+ * reader can decompress it sequentially, while blocks can be compressed and
+ * decompressed in parallel and located without decompressing the file.
+ * @{ */
+
+/** Maximum number of uncompressed bytes per block */
+constexpr std::size_t GZ_BLOCK_MAX_INPUT = 0xff00;
+/** Length of the gzip header of a block, up to the extra fields length */
+constexpr std::size_t GZ_BLOCK_HEADER_PREFIX = 12;
+/** Length of the header of the blocks written by gzCompressBlock() */
+constexpr std::size_t GZ_BLOCK_HEADER_SIZE = 18;
+/** Length of the trailer of each block (CRC32 and data length) */
+constexpr std::size_t GZ_BLOCK_TRAILER_SIZE = 8;
+
+/** Compresses up to GZ_BLOCK_MAX_INPUT bytes into a whole block. */
+std::vector<uint8_t> gzCompressBlock(
+	const uint8_t* data, std::size_t len, int compress_level);
+
+/** The empty block that marks the end of a block-compressed file */
+const std::vector<uint8_t>& gzEOFBlock();
+
+/** Checks the first GZ_BLOCK_HEADER_PREFIX bytes of a block.
+ * \return The length of the extra fields that follow them, or -1 if this
+ * is not the header of a gzip member with extra fields. */
+int gzBlockExtraLength(const uint8_t* prefix);
+
+/** Finds the total block size in the extra fields of its header.
+ * \return The block size in bytes, or 0 if it is not a block header. */
+std::size_t gzBlockSize(const uint8_t* extra, std::size_t extraLen);
+
+/** Decompresses a whole block, checking its CRC32.
+ * \exception std::exception On corrupted data. */
+void gzDecompressBlock(
+	const uint8_t* block, std::size_t blockLen, std::vector<uint8_t>& out);
+
+/** Returns the uncompressed length stored in the trailer of a block */
+inline uint32_t gzBlockDataLength(const uint8_t* trailer)
+{
+	return uint32_t(trailer[4]) | (uint32_t(trailer[5]) << 8) |
+		   (uint32_t(trailer[6]) << 16) | (uint32_t(trailer[7]) << 24);
+}
+/** @} */
+}  // namespace internal
+}  // namespace io
+}  // namespace mrpt
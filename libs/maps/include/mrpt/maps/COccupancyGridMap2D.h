@@ -16,6 +16,7 @@
 #include <mrpt/tfest/TMatchingPair.h>
 #include <mrpt/maps/CLogOddsGridMap2D.h>
 #include <mrpt/core/safe_pointers.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/poses/poses_frwds.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
 #include <mrpt/obs/CObservation2DRangeScanWithUncertainty.h>
@@ -23,6 +24,9 @@
 #include <mrpt/typemeta/TEnumType.h>
 
 #include <mrpt/config.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
 #if (                                                \
 	!defined(OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS) &&   \
 	!defined(OCCUPANCY_GRIDMAP_CELL_SIZE_16BITS)) || \
@@ -57,6 +61,11 @@ namespace maps
  *		- Laser scans simulation for the map contents
  *		- Entropy and information methods (See computeEntropy)
  *
+ * Cells are stored in one dense array by default. For large, sparsely
+ *explored environments, setTiledStorage() switches to square tiles that are
+ *only allocated when some of their cells are modified, so growing the grid
+ *never copies the existing cells.
+ *
  * \ingroup mrpt_maps_grp
  **/
 class COccupancyGridMap2D : public CMetricMap,
@@ -100,7 +109,8 @@ class COccupancyGridMap2D : public CMetricMap,
 	/** Lookup tables for log-odds */
 	static CLogOddsGridMapLUT<cellType>& get_logodd_lut();
 
-	/** Store of cell occupancy values. Order: row by row, from left to right */
+	/** Store of cell occupancy values. Order: row by row, from left to right.
+	 * Empty if m_tiledStorage is set. */
 	std::vector<cellType> map;
 	/** The size of the grid in cells */
 	uint32_t size_x, size_y;
@@ -109,11 +119,76 @@ class COccupancyGridMap2D : public CMetricMap,
 	/** Cell size, i.e. resolution of the grid map. */
 	float resolution;
 
+	/** A rectangle of cells (inclusive indices) modified since the last
+	 * update of some data derived from the cell contents, so it can be
+	 * updated incrementally. */
+	struct TModifiedArea
+	{
+		/** If set, the whole grid must be considered as modified */
+		bool all{true};
+		int cx_min{0}, cx_max{-1}, cy_min{0}, cy_max{-1};
+
+		bool empty() const { return !all && cx_min > cx_max; }
+		void clear()
+		{
+			all = false;
+			cx_min = cy_min = 0;
+			cx_max = cy_max = -1;
+		}
+		void include(int x1, int x2, int y1, int y2)
+		{
+			if (cx_min > cx_max)
+			{
+				cx_min = x1;
+				cx_max = x2;
+				cy_min = y1;
+				cy_max = y2;
+			}
+			else
+			{
+				cx_min = std::min(cx_min, x1);
+				cx_max = std::max(cx_max, x2);
+				cy_min = std::min(cy_min, y1);
+				cy_max = std::max(cy_max, y2);
+			}
+		}
+	};
+
 	/** Auxiliary variables to speed up the computation of observation
 	 * likelihood values for LF method among others, at a high cost in memory
 	 * (see TLikelihoodOptions::enableLikelihoodCache). */
 	std::vector<double> precomputedLikelihood;
-	bool precomputedLikelihoodToBeRecomputed;
+	/** Cells modified since the last update of precomputedLikelihood */
+	TModifiedArea precomputedLikelihoodModifiedArea;
+	/** LF parameters used to build precomputedLikelihood (it must be
+	 * rebuilt if they change) */
+	std::vector<double> precomputedLikelihoodParams;
+	/** Brings precomputedLikelihood up to date, recomputing only the cells
+	 * whose likelihood may have changed due to modified cells. */
+	void updateLikelihoodFieldCache();
+	/** Clearance map used by laserScanSimulatorBatch() to skip over free
+	 * space: distance (in cells, rounded down and saturated to
+	 * CLEARANCE_MAP_SATURATION) from each cell to the closest cell blocking
+	 * the rays. Same order than "map". */
+	std::vector<uint8_t> m_clearanceMap;
+	static constexpr int CLEARANCE_MAP_SATURATION = 64;
+	/** Raw cell values up to this one block the rays in m_clearanceMap */
+	int m_clearanceMapThreshold{0};
+	/** Cells modified since the last update of m_clearanceMap */
+	TModifiedArea m_clearanceMapModifiedArea;
+	/** Brings m_clearanceMap up to date for rays stopping at cells with raw
+	 * values up to `threshold_free_int`. */
+	void updateClearanceMap(const int threshold_free_int);
+	/** Worker threads for laserScanSimulatorBatch() */
+	std::shared_ptr<mrpt::WorkerThreadsPool> m_simulationThreadPool;
+	/** The ray tracing of simulateScanRay(), without noise. If
+	 * `useClearanceMap` is set, m_clearanceMap must be up to date for
+	 * `threshold_free` and is used to skip over free space, giving exactly
+	 * the same results. */
+	void internal_simulateScanRay(
+		const double x, const double y, const double angle_direction,
+		float& out_range, bool& out_valid, const double max_range_meters,
+		const float threshold_free, const bool useClearanceMap) const;
 
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
 	 * not a basis point. */
@@ -124,6 +199,9 @@ class COccupancyGridMap2D : public CMetricMap,
 	 *    in 1/100th distance units (i.e. in centimeters), or 0 if not into the
 	 * Voronoi diagram  */
 	mrpt::containers::CDynamicGrid<uint16_t> m_voronoi_diagram;
+	/** The clearance of each cell before thinning the Voronoi diagram, so it
+	 * can be thinned again around modified cells by updateVoronoiDiagram() */
+	mrpt::containers::CDynamicGrid<uint16_t> m_voronoi_clearance;
 
 	/** True upon construction; used by isEmpty() */
 	bool m_is_empty;
@@ -134,27 +212,128 @@ class COccupancyGridMap2D : public CMetricMap,
 
 	/** The free-cells threshold used to compute the Voronoi diagram. */
 	float voroni_free_threshold;
+	/** The parameters used to compute the Voronoi diagram. */
+	float m_voronoi_threshold{0}, m_voronoi_robot_size{0};
+	/** Whether buildVoronoiDiagram() was ever called */
+	bool m_voronoi_built{false};
+	/** Cells modified since the last update of the Voronoi diagram */
+	TModifiedArea m_voronoiModifiedArea;
+
+	/** Marks all the data derived from the cell contents (likelihood field
+	 * cache, Voronoi diagram, clearance map) to be recomputed for the whole
+	 * grid. */
+	void invalidateDerivedData()
+	{
+		precomputedLikelihoodModifiedArea.all = true;
+		m_voronoiModifiedArea.all = true;
+		m_clearanceMapModifiedArea.all = true;
+	}
+	/** Marks a rectangle of cells (inclusive indices) as modified, so the
+	 * data derived from them is updated the next time it is needed. */
+	inline void markModifiedCells(int x1, int x2, int y1, int y2)
+	{
+		precomputedLikelihoodModifiedArea.include(x1, x2, y1, y2);
+		m_voronoiModifiedArea.include(x1, x2, y1, y2);
+		m_clearanceMapModifiedArea.include(x1, x2, y1, y2);
+	}
+
+	/** Worker threads for insertObservation(), see
+	 * TInsertionOptions::numThreads */
+	std::shared_ptr<mrpt::WorkerThreadsPool> m_insertionThreadPool;
+	/** Runs `insertRows(first_row, last_row)` (inclusive cell indices) for
+	 * bands of rows covering the whole grid, in parallel if
+	 * TInsertionOptions::numThreads!=1. */
+	void insertInRowBands(const std::function<void(int, int)>& insertRows);
 
 	/** Entropy computation internal function: */
 	static double H(double p);
 	/** Internally used to speed-up entropy calculation */
 	static std::vector<float> entropyTable;
 
+	/** Log2 of the side length, in cells, of the tiles used with tiled
+	 * storage (64x64 cells) */
+	static constexpr unsigned int TILE_BITS = 6;
+	static constexpr int TILE_SIZE = 1 << TILE_BITS;
+	static constexpr int TILE_MASK = TILE_SIZE - 1;
+
+	/** Whether cells live in m_tiles instead of `map`. See setTiledStorage()
+	 */
+	bool m_tiledStorage{false};
+	/** Tiled storage: m_tiles_x x m_tiles_y tiles (row by row), each one with
+	 * TILE_SIZE x TILE_SIZE cells (row by row). Tile (0,0) starts at cell
+	 * (-m_tileOffsetX,-m_tileOffsetY), so the grid can grow to the left and
+	 * bottom by any number of cells. Tiles not allocated yet are empty
+	 * vectors, and all their cells have the value in m_tileDefaultValues.
+	 * Cells of allocated tiles beyond the grid limits also keep that value. */
+	std::vector<std::vector<cellType>> m_tiles;
+	/** The value of the cells of each tile not allocated yet */
+	std::vector<cellType> m_tileDefaultValues;
+	uint32_t m_tiles_x{0}, m_tiles_y{0};
+	uint32_t m_tileOffsetX{0}, m_tileOffsetY{0};
+
+	/** Index of the tile containing a cell, and of the cell in the tile */
+	inline size_t tileIndex(int x, int y) const
+	{
+		return ((x + m_tileOffsetX) >> TILE_BITS) +
+			   ((y + m_tileOffsetY) >> TILE_BITS) * m_tiles_x;
+	}
+	inline size_t cellIndexInTile(int x, int y) const
+	{
+		return ((x + m_tileOffsetX) & TILE_MASK) +
+			   (((y + m_tileOffsetY) & TILE_MASK) << TILE_BITS);
+	}
+	/** Sets up the tiles of an empty grid of size_x x size_y cells */
+	void resetTiles(cellType defaultValue);
+	/** Moves the contents of `map` into tiles, allocating only those with
+	 * some cell different than p2l(0.5) */
+	void denseToTiles();
+	/** Moves the contents of all tiles into `map` */
+	void tilesToDense();
+
+	/** Read the raw (log-odds) contents of a cell, without checking the grid
+	 * limits */
+	inline cellType getRawCell_nocheck(int x, int y) const
+	{
+		if (!m_tiledStorage) return map[x + y * size_x];
+		const size_t t = tileIndex(x, y);
+		const std::vector<cellType>& tile = m_tiles[t];
+		return tile.empty() ? m_tileDefaultValues[t]
+							: tile[cellIndexInTile(x, y)];
+	}
+	/** Pointer to the raw (log-odds) contents of a cell, for writing it,
+	 * without checking the grid limits. With tiled storage, the tile is
+	 * allocated if needed. */
+	inline cellType* getRawCellPtr_nocheck(int x, int y)
+	{
+		if (!m_tiledStorage) return &map[x + y * size_x];
+		const size_t t = tileIndex(x, y);
+		std::vector<cellType>& tile = m_tiles[t];
+		if (tile.empty())
+			tile.assign(TILE_SIZE * TILE_SIZE, m_tileDefaultValues[t]);
+		return &tile[cellIndexInTile(x, y)];
+	}
+
 	/** Change the contents [0,1] of a cell, given its index */
 	inline void setCell_nocheck(int x, int y, float value)
 	{
-		map[x + y * size_x] = p2l(value);
+		*getRawCellPtr_nocheck(x, y) = p2l(value);
+		markModifiedCells(x, x, y, y);
 	}
 
 	/** Read the real valued [0,1] contents of a cell, given its index */
 	inline float getCell_nocheck(int x, int y) const
 	{
-		return l2p(map[x + y * size_x]);
+		return l2p(getRawCell_nocheck(x, y));
 	}
 	/** Changes a cell by its absolute index (Do not use it normally) */
 	inline void setRawCell(unsigned int cellIndex, cellType b)
 	{
-		if (cellIndex < size_x * size_y) map[cellIndex] = b;
+		if (cellIndex < size_x * size_y)
+		{
+			const int cx = cellIndex % size_x, cy = cellIndex / size_x;
+			*getRawCellPtr_nocheck(cx, cy) = b;
+			markModifiedCells(cx, cx, cy, cy);
+		}
 	}
 
 	/** One of the methods that can be selected for implementing
@@ -216,8 +395,29 @@ class COccupancyGridMap2D : public CMetricMap,
 
    public:
 	/** Read-only access to the raw cell contents (cells are in log-odd units)
+	 * \exception std::exception If tiled storage is enabled.
 	 */
-	const std::vector<cellType>& getRawMap() const { return this->map; }
+	const std::vector<cellType>& getRawMap() const
+	{
+		ASSERTMSG_(!m_tiledStorage, "Not available with tiled storage");
+		return this->map;
+	}
+
+	/** Selects how cells are stored in memory: one dense array for the whole
+	 * grid (default), or tiles of 64x64 cells allocated the first time one of
+	 * their cells is modified. With tiled storage, the memory usage grows with
+	 * the explored area instead of with the grid bounding box, and
+	 * resizeGrid() never copies the existing cells. Cell access is O(1) in
+	 * both modes, and so are the grid limits after resizeGrid(). The current
+	 * contents are kept. getRawMap() and getRow() are not available with
+	 * tiled storage.
+	 * \sa isTiledStorage, getStoredCellsCount */
+	void setTiledStorage(bool enable);
+	/** \sa setTiledStorage */
+	bool isTiledStorage() const { return m_tiledStorage; }
+	/** Number of cells actually stored in memory: all of them with dense
+	 * storage, or those in allocated tiles with tiled storage. */
+	size_t getStoredCellsCount() const;
 	/** Performs the Bayesian fusion of a new observation of a cell  \sa
 	 * updateInfoChangeOnly, updateCell_fast_occupied, updateCell_fast_free */
 	void updateCell(int x, int y, float v);
@@ -371,8 +571,8 @@ class COccupancyGridMap2D : public CMetricMap,
 		if (static_cast<unsigned int>(x) >= size_x ||
 			static_cast<unsigned int>(y) >= size_y)
 			return;
-		else
-			map[x + y * size_x] = p2l(value);
+		*getRawCellPtr_nocheck(x, y) = p2l(value);
+		markModifiedCells(x, x, y, y);
 	}
 
 	/** Read the real valued [0,1] contents of a cell, given its index */
@@ -383,13 +583,14 @@ class COccupancyGridMap2D : public CMetricMap,
 			static_cast<unsigned int>(y) >= size_y)
 			return 0.5f;
 		else
-			return l2p(map[x + y * size_x]);
+			return l2p(getRawCell_nocheck(x, y));
 	}
 
 	/** Access to a "row": mainly used for drawing grid as a bitmap efficiently,
-	 * do not use it normally */
+	 * do not use it normally. Not available with tiled storage. */
 	inline cellType* getRow(int cy)
 	{
+		ASSERTMSG_(!m_tiledStorage, "Not available with tiled storage");
 		if (cy < 0 || static_cast<unsigned int>(cy) >= size_y)
 			return nullptr;
 		else
@@ -397,9 +598,10 @@ class COccupancyGridMap2D : public CMetricMap,
 	}
 
 	/** Access to a "row": mainly used for drawing grid as a bitmap efficiently,
-	 * do not use it normally */
+	 * do not use it normally. Not available with tiled storage. */
 	inline const cellType* getRow(int cy) const
 	{
+		ASSERTMSG_(!m_tiledStorage, "Not available with tiled storage");
 		if (cy < 0 || static_cast<unsigned int>(cy) >= size_y)
 			return nullptr;
 		else
@@ -547,6 +749,11 @@ class COccupancyGridMap2D : public CMetricMap,
 		/** Enabled: Rays widen with distance to approximate the real behavior
 		 * of lasers, disabled: insert rays as simple lines (Default=false) */
 		bool wideningBeamsWithDistance;
+		/** Number of threads used to insert 2D range scans: 1 (default) runs
+		 * in the calling thread, 0 means one thread per hardware core. The
+		 * grid is split into bands of rows, so the result is identical for
+		 * any number of threads. */
+		unsigned int numThreads;
 	};
 
 	/** With this struct options are provided to the observation insertion
@@ -644,7 +851,11 @@ class COccupancyGridMap2D : public CMetricMap,
 		std::vector<float> OWA_weights;
 
 		/** Enables the usage of a cache of likelihood values (for LF methods),
-		 * if set to true (default=false). */
+		 * if set to true (default=false). The cache is built for the whole
+		 * grid with an exact distance transform on first use, then only
+		 * cells near modified areas (inserted observations, setCell(),
+		 * updateCell()) are recomputed. Once up to date, evaluating
+		 * likelihoods only reads from it. */
 		bool enableLikelihoodCache;
 	} likelihoodOptions;
 
@@ -692,6 +903,18 @@ class COccupancyGridMap2D : public CMetricMap,
 		float threshold, float robot_size, int x1 = 0, int x2 = 0, int y1 = 0,
 		int y2 = 0);
 
+	/** Updates the Voronoi diagram computed by a previous call to
+	 * buildVoronoiDiagram() for the whole grid, using the same parameters and
+	 * recomputing only the cells near those modified since then (by
+	 * insertObservation(), setCell(), updateCell(),...). The result is the
+	 * same than that of buildVoronoiDiagram() with those parameters. The
+	 * diagram is fully rebuilt if the grid changed its size, or if the last
+	 * call to buildVoronoiDiagram() was for a part of the grid only.
+	 * \exception std::exception If buildVoronoiDiagram() was never called.
+	 * \sa buildVoronoiDiagram
+	 */
+	void updateVoronoiDiagram();
+
 	/** Reads a the clearance of a cell (in centimeters), after building the
 	 * Voronoi diagram with \a buildVoronoiDiagram */
 	inline uint16_t getVoroniClearance(int cx, int cy) const
@@ -707,6 +930,19 @@ class COccupancyGridMap2D : public CMetricMap,
 	}
 
    protected:
+	/** Computes the Voronoi diagram in a window of cells (inclusive indices),
+	 * whose clearance values must be zero. */
+	void internal_buildVoronoiDiagram(int x1, int x2, int y1, int y2);
+	/** Computes m_voronoi_clearance in a window of cells (inclusive indices).
+	 * The search of each cell starts from the result of the previous cell in
+	 * its column, so the result for a column only depends on the window
+	 * rows. */
+	void internal_computeVoronoiClearance(int x1, int x2, int y1, int y2);
+	/** Thins the Voronoi diagram in the rows [y1,y2] of column x, from the
+	 * clearances in m_voronoi_clearance, once the previous columns and rows
+	 * are done. \return true if any cell of m_voronoi_diagram changed. */
+	bool internal_thinVoronoiColumn(int x, int y1, int y2);
+
 	/** Used to set the clearance of a cell, while building the Voronoi diagram.
 	 */
 	inline void setVoroniClearance(int cx, int cy, uint16_t dist)
@@ -766,12 +1002,35 @@ class COccupancyGridMap2D : public CMetricMap,
 		int cx, int cy, int* basis_x, int* basis_y, int* nBasis,
 		bool GetContourPoint = false) const;
 
+   protected:
+	/** Like computeClearance(), starting the search for obstacles at the
+	 * circle of radius \a free_circle (in cells), which is set to the last
+	 * searched circle on return, or to 0 for occupied or out of map cells.
+	 */
+	int internal_computeClearance(
+		int cx, int cy, int* basis_x, int* basis_y, int* nBasis,
+		bool GetContourPoint, int& free_circle) const;
+
+   public:
+
 	/** An alternative method for computing the clearance of a given location
 	 * (in meters).
 	 *  \return The clearance (distance to closest OCCUPIED cell), in meters.
 	 */
 	float computeClearance(float x, float y, float maxSearchDistance) const;
 
+	/** Exact squared Euclidean distance (in cells^2) from the center of each
+	 * cell in the rectangle [x1,x2]x[y1,y2] (inclusive indices) to the center
+	 * of the closest cell whose raw value is below `obstacleBelow`, saturated
+	 * to distSat^2. Results are stored row by row into out_d2.
+	 * Cells outside of the map are never considered obstacles.
+	 * \sa p2l, computeClearance
+	 */
+	void computeDistanceTransform(
+		const int x1, const int x2, const int y1, const int y2,
+		const int distSat, const int obstacleBelow,
+		std::vector<uint32_t>& out_d2) const;
+
 	/** Compute the 'cost' of traversing a segment of the map according to the
 	 * occupancy of traversed cells.
 	 *  \return This returns '1-mean(traversed cells occupancy)', i.e. 0.5 for
@@ -850,6 +1109,50 @@ class COccupancyGridMap2D : public CMetricMap,
 		const float threshold_free = 0.4f, const double noiseStd = .0,
 		const double angleNoiseStd = .0) const;
 
+	/** Input params for laserScanSimulatorBatch() */
+	struct TLaserSimulBatchParams
+	{
+		TLaserSimulBatchParams();
+
+		/** The minimum occupancy threshold to consider a cell to be occupied
+		 * (Default: 0.6f) */
+		float threshold;
+		/** The count of range scan "rays" (Default: 361) */
+		size_t nRays;
+		/** The rays that will be simulated are at indexes: 0, D, 2D, 3D, ...
+		 * (Default: D=1) */
+		unsigned int decimation;
+		/** Number of threads among which the poses are distributed: 1
+		 * (default) runs in the calling thread, 0 uses one thread per
+		 * hardware core. */
+		unsigned int numThreads;
+		/** If true (default), rays jump over free space using a cached map
+		 * of the distance from each cell to the closest occupied one (sphere
+		 * tracing). Results are exactly the same with and without it, but
+		 * long rays in open areas are much faster. */
+		bool useClearanceMap;
+	};
+
+	/** Simulates a laser range scan from many robot poses at once, e.g. for
+	 * all the particles of a particle filter.
+	 * Each pose gives the same ranges than laserScanSimulator() without
+	 * noise, but the clearance map (see TLaserSimulBatchParams) and the
+	 * worker threads are shared by all the poses.
+	 * \param scanParams [IN] The aperture, maxRange, rightToLeft and
+	 * sensorPose of the simulated scanner are taken from this object.
+	 * \param robotPoses [IN] The robot poses in this map coordinates.
+	 * \param out_ranges [OUT] The ranges, `params.nRays` per pose: the range
+	 * of ray `k` from pose `i` is `out_ranges[i*params.nRays+k]`. Rays not
+	 * simulated due to decimation are set to 0.
+	 * \param out_valid [OUT] The validity of each range, same layout than
+	 * out_ranges.
+	 * \sa laserScanSimulator() */
+	void laserScanSimulatorBatch(
+		const mrpt::obs::CObservation2DRangeScan& scanParams,
+		const std::vector<mrpt::math::TPose2D>& robotPoses,
+		std::vector<float>& out_ranges, std::vector<char>& out_valid,
+		const TLaserSimulBatchParams& params = TLaserSimulBatchParams());
+
 	/** Methods for TLaserSimulUncertaintyParams in
 	 * laserScanSimulatorWithUncertainty() */
 	enum TLaserSimulUncertaintyMethod
@@ -952,6 +1255,30 @@ class COccupancyGridMap2D : public CMetricMap,
 		const CPointsMap* pm,
 		const mrpt::poses::CPose2D* relativePose = nullptr);
 
+	/** Batch version of computeLikelihoodField_Thrun(): evaluates the same set
+	 * of points at many candidate relative poses at once, leaving in
+	 * `out_log_liks[i]` exactly the same value than
+	 * computeLikelihoodField_Thrun(pm, &relativePoses[i]) would return.
+	 * Points are read and decimated only once, and their transformation to
+	 * grid cell indices is vectorized (SSE2) if available.
+	 */
+	void computeLikelihoodField_Thrun(
+		const CPointsMap* pm,
+		const std::vector<mrpt::math::TPose2D>& relativePoses,
+		std::vector<double>& out_log_liks);
+
+	/** Evaluates the log-likelihood of one observation for many candidate
+	 * robot poses at once, as computeObservationLikelihood() would do for each
+	 * pose. 2D laser scans with the lmLikelihoodField_Thrun method use the
+	 * batch version of computeLikelihoodField_Thrun(); any other case
+	 * falls back to one computeObservationLikelihood() call per pose.
+	 * Useful to score all the particles of a localization filter.
+	 */
+	void computeObservationLikelihoodForPoses(
+		const mrpt::obs::CObservation* obs,
+		const std::vector<mrpt::math::TPose2D>& robotPoses,
+		std::vector<double>& out_log_liks);
+
 	/** Computes the likelihood [0,1] of a set of points, given the current grid
 	 * map as reference.
 	 * \param pm The points map
@@ -1172,6 +1499,8 @@ class COccupancyGridMap2D : public CMetricMap,
 	MAP_DEFINITION_START(COccupancyGridMap2D)
 	/** See COccupancyGridMap2D::COccupancyGridMap2D */
 	float min_x, max_x, min_y, max_y, resolution;
+	/** See COccupancyGridMap2D::setTiledStorage() (Default: false) */
+	bool tiledStorage;
 	/** Observations insertion options */
 	mrpt::maps::COccupancyGridMap2D::TInsertionOptions insertionOpts;
 	/** Probabilistic observation likelihood options */
@@ -21,6 +21,7 @@
 #include <mrpt/obs/obs_frwds.h>
 #include <mrpt/opengl/pointcloud_adapters.h>
 #include <mrpt/img/color_maps.h>
+#include <mutex>
 
 // Add for declaration of mexplus::from template specialization
 DECLARE_MEXPLUS_FROM(mrpt::maps::CPointsMap)
@@ -604,7 +605,7 @@ class CPointsMap : public CMetricMap,
 	inline void insertPoint(float x, float y, float z = 0)
 	{
 		insertPointFast(x, y, z);
-		mark_as_modified();
+		mark_as_appended();
 	}
 	/// \overload
 	inline void insertPoint(const mrpt::math::TPoint3D& p)
@@ -748,6 +749,31 @@ class CPointsMap : public CMetricMap,
 		mrpt::tfest::TMatchingPairList& correspondences,
 		float& correspondencesRatio);
 
+	/** @name Local surface geometry
+		@{ */
+	/** Returns, for each point, the covariance of its `nNeighbors` closest
+	 * points (itself included), which describes the shape of the surface
+	 * around it. They are computed on demand and cached until the map is
+	 * modified or a different `nNeighbors` is requested.
+	 * It is safe to call this and getPointsNormals() from several threads at
+	 * once on the same (unmodified) map, as long as all of them ask for the
+	 * same `nNeighbors`: the returned reference is only valid until the map
+	 * is modified or the cache is recomputed for another `nNeighbors`.
+	 * Used by point-to-plane and generalized ICP, see mrpt::slam::CICP.
+	 * \param numThreads Threads for the nearest-neighbor queries: 1 runs in
+	 * the calling thread, 0 uses one thread per hardware core.
+	 * \sa getPointsNormals */
+	const mrpt::aligned_std_vector<mrpt::math::CMatrixFloat33>&
+		getPointsLocalCovariances(
+			const size_t nNeighbors, const unsigned int numThreads = 1) const;
+
+	/** Returns, for each point, the unit normal of the surface around it: the
+	 * eigenvector of the smallest eigenvalue of its local covariance (with an
+	 * arbitrary sign). Cached along with getPointsLocalCovariances(). */
+	const std::vector<mrpt::math::TPoint3Df>& getPointsNormals(
+		const size_t nNeighbors, const unsigned int numThreads = 1) const;
+	/** @} */
+
 	/** Transform the range scan into a set of cartessian coordinated
 	 *	 points. The options in "insertionOptions" are considered in this
 	 *method.
@@ -1086,7 +1112,20 @@ class CPointsMap : public CMetricMap,
 	{
 		m_largestDistanceFromOriginIsUpdated = false;
 		m_boundingBoxIsUpdated = false;
+		m_localSurfacesIsUpdated = false;
 		kdtree_mark_as_outdated();
+		internal_markAsModified();
+	}
+	/** Like mark_as_modified(), for changes that only append new points at
+	 * the end of the map, leaving the existing ones untouched: the kd-tree
+	 * can then be updated incrementally, if enabled in
+	 * kdtree_search_params.incremental. */
+	inline void mark_as_appended() const
+	{
+		m_largestDistanceFromOriginIsUpdated = false;
+		m_boundingBoxIsUpdated = false;
+		m_localSurfacesIsUpdated = false;
+		kdtree_mark_as_appended();
 	}
 
    protected:
@@ -1110,6 +1149,47 @@ class CPointsMap : public CMetricMap,
 	mutable float m_bb_min_x, m_bb_max_x, m_bb_min_y, m_bb_max_y, m_bb_min_z,
 		m_bb_max_z;
 
+	/** Cache of getPointsLocalCovariances() and getPointsNormals() */
+	mutable bool m_localSurfacesIsUpdated{false};
+	mutable size_t m_localSurfacesNeighbors{0};
+	mutable mrpt::aligned_std_vector<mrpt::math::CMatrixFloat33>
+		m_localCovariances;
+	mutable std::vector<mrpt::math::TPoint3Df> m_localNormals;
+	/** Serializes the (re)computation of the cache above among concurrent
+	 * const callers. Copying a map gives the copy its own, unlocked mutex. */
+	struct TCacheMutex
+	{
+		std::mutex mtx;
+		TCacheMutex() = default;
+		TCacheMutex(const TCacheMutex&) {}
+		TCacheMutex& operator=(const TCacheMutex&) { return *this; }
+	};
+	mutable TCacheMutex m_localSurfacesMtx;
+	void updateLocalSurfaces(
+		const size_t nNeighbors, const unsigned int numThreads) const;
+
+	/** Called from mark_as_modified(), for derived classes to invalidate
+	 * their own caches of the point coordinates. */
+	virtual void internal_markAsModified() const {}
+
+	/** @name Nearest neighbor searches used by determineMatching3D() and
+	 * getPointsNormals(). By default, they use the 3D kd-tree; derived classes
+	 * with their own spatial index may redefine them.
+		@{ */
+	/** Makes the index ready, so the two search methods below can then be
+	 * called from several threads at once. */
+	virtual void nn_prepare3D() const { kdTreeEnsureIndexBuilt3D(); }
+	/** Looks for the closest point to (x,y,z). \return false if there is no
+	 * point at a squared distance below maxDistSqr. */
+	virtual bool nn_closestPoint3D(
+		const float x, const float y, const float z, const double maxDistSqr,
+		size_t& outIdx, float& outDistSqr) const;
+	/** Looks for the knn closest points to (x,y,z), sorted by distance */
+	virtual void nn_kClosestPoints3D(
+		const float x, const float y, const float z, const size_t knn,
+		std::vector<size_t>& outIdx, std::vector<float>& outDistSqr) const;
+	/** @} */
+
 	/** This is a common version of CMetricMap::insertObservation() for point
 	 * maps (actually, CMetricMap::internal_insertObservation),
 	 *   so derived classes don't need to worry implementing that method unless
@@ -0,0 +1,230 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef CVoxelHashPointsMap_H
+#define CVoxelHashPointsMap_H
+
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/serialization/CSerializable.h>
+#include <mrpt/obs/obs_frwds.h>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mrpt
+{
+namespace maps
+{
+/** A cloud of 3D points (x,y,z), spatially indexed by a hash table of cubic
+ * voxels.
+ *
+ * Each inserted point goes to its voxel in constant time: if the voxel
+ * already holds TVoxelOptions::max_points_per_voxel points, or one closer
+ * than TVoxelOptions::min_dist_between_points, the new point is discarded.
+ * Thus, the density of the map is bounded and it does not grow without
+ * limit while the same area is observed over and over, without the kd-tree
+ * queries of CPointsMap::TInsertionOptions::fuseWithExisting.
+ *
+ * The voxels also answer nearest neighbor queries (see voxelClosestPoint3D(),
+ * voxelNClosestPoints3D(), voxelRadiusSearch3D()) by visiting shells of
+ * voxels around the query point, with no global kd-tree. They are used by
+ * determineMatching3D() and getPointsNormals(), so this map can be used as
+ * the reference map of mrpt::slam::CICP 3D methods, e.g. for lidar odometry.
+ * Other methods inherited from CPointsMap (2D matching, likelihoods) still
+ * use the kd-tree.
+ *
+ * Observations are first converted into points as CSimplePointsMap does
+ * (the same insertionOptions apply, except `fuseWithExisting`), then
+ * inserted into the voxels. Points set by any other means (setPoint(),
+ * resize(), addFrom(),...) are kept, and only indexed.
+ *
+ * In a CMultiMetricMap config file, this map is named `CVoxelHashPointsMap`
+ * or `voxelHashPointsMap`. Its TVoxelOptions are loaded from the section
+ * `<sectionName>_voxelOpts`.
+ *
+ * \sa CSimplePointsMap, CPointsMap
+ * \ingroup mrpt_maps_grp
+ */
+class CVoxelHashPointsMap : public CPointsMap
+{
+	DEFINE_SERIALIZABLE(CVoxelHashPointsMap)
+
+   public:
+	/** Default constructor */
+	CVoxelHashPointsMap();
+
+	/** Voxel and insertion-time decimation parameters */
+	struct TVoxelOptions : public mrpt::config::CLoadableOptions
+	{
+		TVoxelOptions() = default;
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(std::ostream& out) const override;
+
+		/** Binary dump to stream */
+		void writeToStream(mrpt::serialization::CArchive& out) const;
+		/** Binary dump to stream */
+		void readFromStream(mrpt::serialization::CArchive& in);
+
+		/** Length of the edges of the voxels (meters) (Default=0.2) */
+		float voxel_size{0.2f};
+		/** Maximum number of points kept per voxel (Default=20) */
+		uint32_t max_points_per_voxel{20};
+		/** New points closer than this distance to a point of the same voxel
+		 * are discarded (meters) (Default=0, disabled) */
+		float min_dist_between_points{0};
+	};
+
+	/** Voxel options. Changing them invalidates the voxels, which are
+	 * rebuilt in the next insertion or query (call mark_as_modified()). */
+	TVoxelOptions voxelOptions;
+
+	/** @name Pure virtual interfaces to be implemented by any class derived
+	   from CPointsMap
+		@{ */
+	virtual void reserve(size_t newLength) override;  // See base class docs
+	virtual void resize(size_t newLength) override;  // See base class docs
+	virtual void setSize(size_t newLength) override;  // See base class docs
+	/** Changes the coordinates of the given point (0-based index), *without*
+	 * checking for out-of-bounds and *without* calling mark_as_modified()  \sa
+	 * setPoint */
+	virtual void setPointFast(size_t index, float x, float y, float z) override;
+	/** The virtual method for \a insertPoint() *without* calling
+	 * mark_as_modified(). The point is discarded if its voxel is full, or
+	 * too close to another point. */
+	virtual void insertPointFast(float x, float y, float z = 0) override;
+	/** Virtual assignment operator, to be implemented in derived classes  */
+	virtual void copyFrom(const CPointsMap& obj) override;
+	/** Get all the data fields for one point as a vector: [X Y Z] */
+	virtual void getPointAllFieldsFast(
+		const size_t index, std::vector<float>& point_data) const override
+	{
+		point_data.resize(3);
+		point_data[0] = m_x[index];
+		point_data[1] = m_y[index];
+		point_data[2] = m_z[index];
+	}
+	/** Set all the data fields for one point as a vector: [X Y Z] */
+	virtual void setPointAllFieldsFast(
+		const size_t index, const std::vector<float>& point_data) override
+	{
+		ASSERTDEB_(point_data.size() == 3);
+		m_x[index] = point_data[0];
+		m_y[index] = point_data[1];
+		m_z[index] = point_data[2];
+	}
+
+	// See CPointsMap::loadFromRangeScan()
+	virtual void loadFromRangeScan(
+		const mrpt::obs::CObservation2DRangeScan& rangeScan,
+		const mrpt::poses::CPose3D* robotPose = nullptr) override;
+	// See CPointsMap::loadFromRangeScan()
+	virtual void loadFromRangeScan(
+		const mrpt::obs::CObservation3DRangeScan& rangeScan,
+		const mrpt::poses::CPose3D* robotPose = nullptr) override;
+
+   protected:
+	virtual void addFrom_classSpecific(
+		const CPointsMap& anotherMap, const size_t nPreviousPoints) override
+	{
+		MRPT_UNUSED_PARAM(anotherMap);
+		MRPT_UNUSED_PARAM(nPreviousPoints);
+		// No extra data.
+	}
+
+   public:
+	/** @} */
+
+	/** @name Voxel queries
+	 * These methods can be called from several threads at once, once the
+	 * voxels are up to date (see updateVoxels()).
+		@{ */
+	/** Rebuilds the voxels from the points, if they were modified other than
+	 * by insertions. Called automatically by insertions and queries. */
+	void updateVoxels() const;
+	/** Closest point to (x,y,z), if closer than maxDist.
+	 * \return The point index, or -1 if there is none. */
+	int voxelClosestPoint3D(
+		const float x, const float y, const float z, const float maxDist,
+		float& outDistSqr) const;
+	/** The knn closest points to (x,y,z), sorted by increasing distance (less
+	 * than knn if the map has less points). */
+	void voxelNClosestPoints3D(
+		const float x, const float y, const float z, const size_t knn,
+		std::vector<size_t>& outIdx, std::vector<float>& outDistSqr) const;
+	/** All the points within a distance of (x,y,z), as pairs of index and
+	 * squared distance sorted by increasing distance. */
+	void voxelRadiusSearch3D(
+		const float x, const float y, const float z, const float radius,
+		std::vector<std::pair<size_t, float>>& outIdxDistSqr) const;
+	/** Number of non-empty voxels */
+	size_t voxelCount() const;
+	/** @} */
+
+   protected:
+	void nn_prepare3D() const override { updateVoxels(); }
+	bool nn_closestPoint3D(
+		const float x, const float y, const float z, const double maxDistSqr,
+		size_t& outIdx, float& outDistSqr) const override;
+	void nn_kClosestPoints3D(
+		const float x, const float y, const float z, const size_t knn,
+		std::vector<size_t>& outIdx,
+		std::vector<float>& outDistSqr) const override;
+	void internal_markAsModified() const override
+	{
+		m_voxelsIsUpdated = false;
+	}
+
+	/** Clear the map, erasing all the points.
+	 */
+	virtual void internal_clear() override;
+	/** Inserts the points of the observation into the voxels */
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation* obs,
+		const mrpt::poses::CPose3D* robotPose) override;
+
+	/** @name PLY Import virtual methods to implement in base classes
+		@{ */
+	virtual void PLY_import_set_vertex_count(const size_t N) override;
+	/** @} */
+
+	/** Indices of the points in each voxel, by voxel key */
+	mutable std::unordered_map<uint64_t, std::vector<uint32_t>> m_voxels;
+	/** false if m_voxels must be rebuilt from the points */
+	mutable bool m_voxelsIsUpdated{false};
+	/** Voxel coordinates of a point */
+	void voxelCoords(
+		const float x, const float y, const float z, int32_t& ix, int32_t& iy,
+		int32_t& iz) const;
+	/** Appends the points of m to the voxels, with decimation */
+	void insertDecimated(const CPointsMap& m);
+	/** Reused buffer of the points of the last observation */
+	CSimplePointsMap m_auxObsPoints;
+	template <class RESULTSET>
+	void searchVoxels(
+		const float x, const float y, const float z,
+		RESULTSET& resultSet) const;
+
+	MAP_DEFINITION_START(CVoxelHashPointsMap)
+	/** Observations insertion options */
+	mrpt::maps::CPointsMap::TInsertionOptions insertionOpts;
+	/** Probabilistic observation likelihood options */
+	mrpt::maps::CPointsMap::TLikelihoodOptions likelihoodOpts;
+	/** Rendering as 3D object options */
+	mrpt::maps::CPointsMap::TRenderOptions renderOpts;
+	/** Voxel options */
+	mrpt::maps::CVoxelHashPointsMap::TVoxelOptions voxelOpts;
+	MAP_DEFINITION_END(CVoxelHashPointsMap)
+};  // End of class def.
+}  // namespace maps
+}  // namespace mrpt
+
+#endif
@@ -34,7 +34,8 @@ COccupancyGridMap2D::TMapDefinition::TMapDefinition()
 	  max_x(10.0f),
 	  min_y(-10.0f),
 	  max_y(10.0f),
-	  resolution(0.10f)
+	  resolution(0.10f),
+	  tiledStorage(false)
 {
 }
 
@@ -50,6 +51,7 @@ void COccupancyGridMap2D::TMapDefinition::loadFromConfigFile_map_specific(
 	MRPT_LOAD_CONFIG_VAR(min_y, float, source, sSectCreation);
 	MRPT_LOAD_CONFIG_VAR(max_y, float, source, sSectCreation);
 	MRPT_LOAD_CONFIG_VAR(resolution, float, source, sSectCreation);
+	MRPT_LOAD_CONFIG_VAR(tiledStorage, bool, source, sSectCreation);
 
 	// [<sectionName>+"_occupancyGrid_##_insertOpts"]
 	insertionOpts.loadFromConfigFile(
@@ -68,6 +70,7 @@ void COccupancyGridMap2D::TMapDefinition::dumpToTextStream_map_specific(
 	LOADABLEOPTS_DUMP_VAR(min_y, float);
 	LOADABLEOPTS_DUMP_VAR(max_y, float);
 	LOADABLEOPTS_DUMP_VAR(resolution, float);
+	LOADABLEOPTS_DUMP_VAR(tiledStorage, bool);
 
 	this->insertionOpts.dumpToTextStream(out);
 	this->likelihoodOpts.dumpToTextStream(out);
@@ -80,6 +83,7 @@ mrpt::maps::CMetricMap* COccupancyGridMap2D::internal_CreateFromMapDefinition(
 		*dynamic_cast<const COccupancyGridMap2D::TMapDefinition*>(&_def);
 	COccupancyGridMap2D* obj = new COccupancyGridMap2D(
 		def.min_x, def.max_x, def.min_y, def.max_y, def.resolution);
+	obj->setTiledStorage(def.tiledStorage);
 	obj->insertionOptions = def.insertionOpts;
 	obj->likelihoodOptions = def.likelihoodOpts;
 	return obj;
@@ -114,7 +118,6 @@ COccupancyGridMap2D::COccupancyGridMap2D(
 	  y_max(),
 	  resolution(),
 	  precomputedLikelihood(),
-	  precomputedLikelihoodToBeRecomputed(true),
 	  m_basis_map(),
 	  m_voronoi_diagram(),
 	  m_is_empty(true),
@@ -145,11 +148,19 @@ void COccupancyGridMap2D::copyMapContentFrom(const COccupancyGridMap2D& o)
 	size_x = o.size_x;
 	size_y = o.size_y;
 	map = o.map;
+	m_tiledStorage = o.m_tiledStorage;
+	m_tiles = o.m_tiles;
+	m_tileDefaultValues = o.m_tileDefaultValues;
+	m_tiles_x = o.m_tiles_x;
+	m_tiles_y = o.m_tiles_y;
+	m_tileOffsetX = o.m_tileOffsetX;
+	m_tileOffsetY = o.m_tileOffsetY;
 
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
+	m_voronoi_clearance.clear();
 
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 	m_is_empty = o.m_is_empty;
 }
 
@@ -164,7 +175,7 @@ void COccupancyGridMap2D::setSize(
 	ASSERT_(default_value >= 0 && default_value <= 1);
 
 	freeMap();
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 
 	// Adjust sizes to adapt them to full sized cells acording to the
 	// resolution:
@@ -196,11 +207,15 @@ void COccupancyGridMap2D::setSize(
 #endif
 
 	// Cells memory:
-	map.resize(size_x * size_y, p2l(default_value));
+	if (m_tiledStorage)
+		resetTiles(p2l(default_value));
+	else
+		map.resize(size_x * size_y, p2l(default_value));
 
 	// Free these buffers also:
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
+	m_voronoi_clearance.clear();
 
 	m_is_empty = true;
 
@@ -238,7 +253,7 @@ void COccupancyGridMap2D::resizeGrid(
 		return;
 
 	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 
 	// Add an additional margin:
 	if (additionalMargin)
@@ -288,11 +303,91 @@ void COccupancyGridMap2D::resizeGrid(
 	assert(0 == (new_size_x % 16));
 #endif
 
-	// Reserve new mem block
-	new_map.resize(new_size_x * new_size_y, p2l(new_cells_default_value));
+	if (m_tiledStorage)
+	{
+		// Shift the origin of the tiles, so the existing ones are just moved
+		// to their new place in the tile grid:
+		const uint32_t add_tiles_x =
+			extra_x_izq > m_tileOffsetX
+				? (extra_x_izq - m_tileOffsetX + TILE_MASK) >> TILE_BITS
+				: 0;
+		const uint32_t add_tiles_y =
+			extra_y_arr > m_tileOffsetY
+				? (extra_y_arr - m_tileOffsetY + TILE_MASK) >> TILE_BITS
+				: 0;
+		const uint32_t new_offset_x =
+			m_tileOffsetX + (add_tiles_x << TILE_BITS) - extra_x_izq;
+		const uint32_t new_offset_y =
+			m_tileOffsetY + (add_tiles_y << TILE_BITS) - extra_y_arr;
+
+		// Cells of the old tiles which were out of the old grid limits and
+		// are within the new ones get the new default value. Only tiles at
+		// the old borders may have such cells:
+		const cellType newDefault = p2l(new_cells_default_value);
+		const int old_x0 = m_tileOffsetX, old_x1 = m_tileOffsetX + size_x;
+		const int old_y0 = m_tileOffsetY, old_y1 = m_tileOffsetY + size_y;
+		const int new_x0 = old_x0 - static_cast<int>(extra_x_izq),
+				  new_x1 = new_x0 + static_cast<int>(new_size_x);
+		const int new_y0 = old_y0 - static_cast<int>(extra_y_arr),
+				  new_y1 = new_y0 + static_cast<int>(new_size_y);
+		for (uint32_t ty = 0; ty < m_tiles_y; ty++)
+		{
+			for (uint32_t tx = 0; tx < m_tiles_x; tx++)
+			{
+				const int tile_x0 = tx << TILE_BITS, tile_y0 = ty << TILE_BITS;
+				const size_t t = tx + ty * m_tiles_x;
+				if ((tile_x0 >= old_x0 && tile_x0 + TILE_SIZE <= old_x1 &&
+					 tile_y0 >= old_y0 && tile_y0 + TILE_SIZE <= old_y1) ||
+					m_tileDefaultValues[t] == newDefault)
+					continue;
+
+				std::vector<cellType>& tile = m_tiles[t];
+				for (int y = max(tile_y0, new_y0);
+					 y < min(tile_y0 + TILE_SIZE, new_y1); y++)
+					for (int x = max(tile_x0, new_x0);
+						 x < min(tile_x0 + TILE_SIZE, new_x1); x++)
+					{
+						if (x >= old_x0 && x < old_x1 && y >= old_y0 &&
+							y < old_y1)
+							continue;
+						if (tile.empty())
+							tile.assign(
+								TILE_SIZE * TILE_SIZE, m_tileDefaultValues[t]);
+						tile[(x - tile_x0) + ((y - tile_y0) << TILE_BITS)] =
+							newDefault;
+					}
+			}
+		}
 
-	// Copy all the old map rows into the new map:
+		const uint32_t new_tiles_x =
+			(new_size_x + new_offset_x + TILE_MASK) >> TILE_BITS;
+		const uint32_t new_tiles_y =
+			(new_size_y + new_offset_y + TILE_MASK) >> TILE_BITS;
+		std::vector<std::vector<cellType>> new_tiles(new_tiles_x * new_tiles_y);
+		std::vector<cellType> new_defaults(
+			new_tiles_x * new_tiles_y, newDefault);
+		for (uint32_t ty = 0; ty < m_tiles_y; ty++)
+			for (uint32_t tx = 0; tx < m_tiles_x; tx++)
+			{
+				const size_t t = tx + ty * m_tiles_x;
+				const size_t new_t =
+					add_tiles_x + tx + (add_tiles_y + ty) * new_tiles_x;
+				new_tiles[new_t].swap(m_tiles[t]);
+				new_defaults[new_t] = m_tileDefaultValues[t];
+			}
+		m_tiles.swap(new_tiles);
+		m_tileDefaultValues.swap(new_defaults);
+		m_tiles_x = new_tiles_x;
+		m_tiles_y = new_tiles_y;
+		m_tileOffsetX = new_offset_x;
+		m_tileOffsetY = new_offset_y;
+	}
+	else
 	{
+		// Reserve new mem block
+		new_map.resize(new_size_x * new_size_y, p2l(new_cells_default_value));
+
+		// Copy all the old map rows into the new map:
 		cellType* dest_ptr = &new_map[extra_x_izq + extra_y_arr * new_size_x];
 		cellType* src_ptr = &map[0];
 		size_t row_size = size_x * sizeof(cellType);
@@ -324,6 +419,7 @@ void COccupancyGridMap2D::resizeGrid(
 	// Free the other buffers:
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
+	m_voronoi_clearance.clear();
 }
 
 /*---------------------------------------------------------------
@@ -335,20 +431,90 @@ void COccupancyGridMap2D::freeMap()
 
 	// Free map and sectors
 	map.clear();
+	m_tiles.clear();
+	m_tileDefaultValues.clear();
+	m_tiles_x = m_tiles_y = 0;
+	m_tileOffsetX = m_tileOffsetY = 0;
 
 	m_basis_map.clear();
 	m_voronoi_diagram.clear();
+	m_voronoi_clearance.clear();
 
 	size_x = size_y = 0;
 
 	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 
 	m_is_empty = true;
 
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+						setTiledStorage
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::setTiledStorage(bool enable)
+{
+	if (enable == m_tiledStorage) return;
+	if (enable)
+	{
+		m_tiledStorage = true;
+		denseToTiles();
+	}
+	else
+	{
+		tilesToDense();
+		m_tiledStorage = false;
+	}
+}
+
+size_t COccupancyGridMap2D::getStoredCellsCount() const
+{
+	if (!m_tiledStorage) return map.size();
+	size_t n = 0;
+	for (const auto& tile : m_tiles) n += tile.size();
+	return n;
+}
+
+void COccupancyGridMap2D::denseToTiles()
+{
+	ASSERT_EQUAL_(map.size(), size_t(size_x) * size_y);
+
+	const cellType defaultValue = p2l(0.5f);
+	resetTiles(defaultValue);
+
+	for (uint32_t cy = 0; cy < size_y; cy++)
+	{
+		const cellType* row = &map[cy * size_x];
+		for (uint32_t cx = 0; cx < size_x; cx++)
+			if (row[cx] != defaultValue)
+				*getRawCellPtr_nocheck(cx, cy) = row[cx];
+	}
+	std::vector<cellType>().swap(map);
+}
+
+void COccupancyGridMap2D::tilesToDense()
+{
+	std::vector<cellType> newMap(size_t(size_x) * size_y);
+	for (uint32_t cy = 0; cy < size_y; cy++)
+		for (uint32_t cx = 0; cx < size_x; cx++)
+			newMap[cx + cy * size_x] = getRawCell_nocheck(cx, cy);
+	map.swap(newMap);
+	m_tiles.clear();
+	m_tileDefaultValues.clear();
+	m_tiles_x = m_tiles_y = 0;
+	m_tileOffsetX = m_tileOffsetY = 0;
+}
+
+void COccupancyGridMap2D::resetTiles(cellType defaultValue)
+{
+	m_tileOffsetX = m_tileOffsetY = 0;
+	m_tiles_x = (size_x + TILE_MASK) >> TILE_BITS;
+	m_tiles_y = (size_y + TILE_MASK) >> TILE_BITS;
+	m_tiles.assign(m_tiles_x * m_tiles_y, std::vector<cellType>());
+	m_tileDefaultValues.assign(m_tiles.size(), defaultValue);
+}
+
 /*---------------------------------------------------------------
   Computes the entropy and related values of this grid map.
 	out_H The target variable for absolute entropy, computed
@@ -398,16 +564,19 @@ void COccupancyGridMap2D::computeEntropy(TEntropyInfo& info) const
 
 	info.H = info.I = 0;
 	info.effectiveMappedCells = 0;
-	for (std::vector<cellType>::const_iterator it = map.begin();
-		 it != map.end(); ++it)
+	for (unsigned int cy = 0; cy < size_y; cy++)
 	{
-		cellTypeUnsigned ctu = static_cast<cellTypeUnsigned>(*it);
-		h = entropyTable[ctu];
-		info.H += h;
-		if (h < (MAX_H - 0.001f))
+		for (unsigned int cx = 0; cx < size_x; cx++)
 		{
-			info.effectiveMappedCells++;
-			info.I -= h;
+			cellTypeUnsigned ctu =
+				static_cast<cellTypeUnsigned>(getRawCell_nocheck(cx, cy));
+			h = entropyTable[ctu];
+			info.H += h;
+			if (h < (MAX_H - 0.001f))
+			{
+				info.effectiveMappedCells++;
+				info.I -= h;
+			}
 		}
 	}
 
@@ -450,7 +619,7 @@ void COccupancyGridMap2D::internal_clear()
 	setSize(-10, 10, -10, 10, getResolution());
 	// resetFeaturesCache();
 	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 }
 
 /*---------------------------------------------------------------
@@ -459,10 +628,16 @@ void COccupancyGridMap2D::internal_clear()
 void COccupancyGridMap2D::fill(float default_value)
 {
 	cellType defValue = p2l(default_value);
+	if (m_tiledStorage)
+	{
+		// Release all the tiles:
+		m_tiles.assign(m_tiles.size(), std::vector<cellType>());
+		m_tileDefaultValues.assign(m_tiles.size(), defValue);
+	}
 	for (std::vector<cellType>::iterator it = map.begin(); it < map.end(); ++it)
 		*it = defValue;
 	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 	// resetFeaturesCache();
 }
 
@@ -476,8 +651,10 @@ void COccupancyGridMap2D::updateCell(int x, int y, float v)
 		static_cast<unsigned int>(y) >= size_y)
 		return;
 
+	markModifiedCells(x, x, y, y);
+
 	// Get the current contents of the cell:
-	cellType& theCell = map[x + y * size_x];
+	cellType& theCell = *getRawCellPtr_nocheck(x, y);
 
 	// Compute the new Bayesian-fused value of the cell:
 	if (updateInfoChangeOnly.enabled)
@@ -542,6 +719,7 @@ void COccupancyGridMap2D::subSample(int downRatio)
 
 	setSize(x_min, x_max, y_min, y_max, resolution);
 	map = newMap;
+	if (m_tiledStorage) denseToTiles();
 }
 
 /*---------------------------------------------------------------
@@ -667,7 +845,7 @@ void COccupancyGridMap2D::determineMatching2D(
 			for (int cy = cy_min; cy <= cy_max; cy++)
 			{
 				// Is an occupied cell?
-				if (map[cx + cy * size_x] <
+				if (getRawCell_nocheck(cx, cy) <
 					thresholdCellValue)  //  getCell(cx,cy)<0.49)
 				{
 					const float residual_x = idx2x(cx) - x_local;
@@ -34,7 +34,6 @@ void COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{  // 8bit gray-scale
 			img.resize(size_x, size_y, 1, true);  // verticalFlip);
-			const cellType* srcPtr = &map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < size_y; y++)
 			{
@@ -44,14 +43,13 @@ void COccupancyGridMap2D::getAsImage(
 					destPtr = img(0, y);
 				for (unsigned int x = 0; x < size_x; x++)
 				{
-					*destPtr++ = l2p_255(*srcPtr++);
+					*destPtr++ = l2p_255(getRawCell_nocheck(x, y));
 				}
 			}
 		}
 		else
 		{  // 24bit RGB:
 			img.resize(size_x, size_y, 3, true);  // verticalFlip);
-			const cellType* srcPtr = &map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < size_y; y++)
 			{
@@ -61,7 +59,7 @@ void COccupancyGridMap2D::getAsImage(
 					destPtr = img(0, y);
 				for (unsigned int x = 0; x < size_x; x++)
 				{
-					uint8_t c = l2p_255(*srcPtr++);
+					uint8_t c = l2p_255(getRawCell_nocheck(x, y));
 					*destPtr++ = c;
 					*destPtr++ = c;
 					*destPtr++ = c;
@@ -75,7 +73,6 @@ void COccupancyGridMap2D::getAsImage(
 		if (!forceRGB)
 		{  // 8bit gray-scale
 			img.resize(size_x, size_y, 1, true);  // verticalFlip);
-			const cellType* srcPtr = &map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < size_y; y++)
 			{
@@ -85,7 +82,7 @@ void COccupancyGridMap2D::getAsImage(
 					destPtr = img(0, y);
 				for (unsigned int x = 0; x < size_x; x++)
 				{
-					uint8_t c = l2p_255(*srcPtr++);
+					uint8_t c = l2p_255(getRawCell_nocheck(x, y));
 					if (c < 120)
 						c = 0;
 					else if (c > 136)
@@ -99,7 +96,6 @@ void COccupancyGridMap2D::getAsImage(
 		else
 		{  // 24bit RGB:
 			img.resize(size_x, size_y, 3, true);  // verticalFlip);
-			const cellType* srcPtr = &map[0];
 			unsigned char* destPtr;
 			for (unsigned int y = 0; y < size_y; y++)
 			{
@@ -109,7 +105,7 @@ void COccupancyGridMap2D::getAsImage(
 					destPtr = img(0, y);
 				for (unsigned int x = 0; x < size_x; x++)
 				{
-					uint8_t c = l2p_255(*srcPtr++);
+					uint8_t c = l2p_255(getRawCell_nocheck(x, y));
 					if (c < 120)
 						c = 0;
 					else if (c > 136)
@@ -171,15 +167,13 @@ void COccupancyGridMap2D::getAs3DObject(
 	CImage imgColor(size_x, size_y, 1);
 	CImage imgTrans(size_x, size_y, 1);
 
-	const cellType* srcPtr = &map[0];
-
 	for (unsigned int y = 0; y < size_y; y++)
 	{
 		unsigned char* destPtr_color = imgColor(0, y);
 		unsigned char* destPtr_trans = imgTrans(0, y);
 		for (unsigned int x = 0; x < size_x; x++)
 		{
-			uint8_t cell255 = l2p_255(*srcPtr++);
+			uint8_t cell255 = l2p_255(getRawCell_nocheck(x, y));
 			*destPtr_color++ = cell255;
 
 			int8_t auxC = (int8_t)((signed short)cell255) - 127;
@@ -15,6 +15,7 @@
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/system/memory.h>  // alloca()
+#include <thread>
 
 #if HAVE_ALLOCA_H
 #include <alloca.h>
@@ -50,11 +51,6 @@ bool COccupancyGridMap2D::internal_insertObservation(
 	CPose2D robotPose2D;
 	CPose3D robotPose3D;
 
-	// This is required to indicate the grid map has changed!
-	// resetFeaturesCache();
-	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
-
 	if (robotPose)
 	{
 		robotPose2D = CPose2D(*robotPose);
@@ -123,7 +119,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			// ---------------------------------------------
 			//		Insert the scan as simple rays:
 			// ---------------------------------------------
-			int cx, cy, N = o->scan.size();
+			int N = o->scan.size();
 			float px, py;
 			double A, dAK;
 
@@ -151,6 +147,17 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			MRPT_CHECK_NORMAL_NUMBER(py);
 #endif
 
+			// Only cells within the longest inserted ray may change (invalid
+			// ranges are inserted with half the last valid range):
+			{
+				float maxR = invalidAsFree ? 0.5f * maxDistanceInsertion : 0;
+				for (idx = 0; idx < nRanges; idx++)
+					if (o->validRange[idx]) keep_max(maxR, o->scan[idx]);
+				const float R = min(maxDistanceInsertion, maxR) + resolution;
+				markModifiedCells(
+					x2idx(px - R), x2idx(px + R), y2idx(py - R), y2idx(py + R));
+			}
+
 			// Here we go! Now really insert changes in the grid:
 			if (!insertionOptions.wideningBeamsWithDistance)
 			{
@@ -247,82 +254,112 @@ bool COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
 
-				// For updateCell_fast methods:
-				cellType* theMapArray = &map[0];
-				unsigned theMapSize_x = size_x;
 
 				int cx0 =
 					x2idx(px);  // Remember: This must be after the resizeGrid!!
 				int cy0 = y2idx(py);
 
-				// Insert rays:
-				for (idx = 0; idx < nRanges; idx += K)
-				{
-					if (!o->validRange[idx] && !invalidAsFree) continue;
+				// Insert rays. Each call only updates the cells in rows
+				// [band_cy1,band_cy2], following the same ray order, so bands
+				// can be processed in parallel with the same result:
+				auto insertRays = [&](const int band_cy1, const int band_cy2) {
+					for (size_t i = 0; i < nRanges; i += K)
+					{
+						if (!o->validRange[i] && !invalidAsFree) continue;
 
-					// Starting position: Laser position
-					cx = cx0;
-					cy = cy0;
+						// Starting position: Laser position
+						int cx = cx0;
+						int cy = cy0;
 
-					// Target, in cell indexes:
-					int trg_cx = x2idx(scanPoints_x[idx]);
-					int trg_cy = y2idx(scanPoints_y[idx]);
+						// Target, in cell indexes:
+						int trg_cx = x2idx(scanPoints_x[i]);
+						int trg_cy = y2idx(scanPoints_y[i]);
 
-					// The x> comparison implicitly holds if x<0
-					ASSERT_(
-						static_cast<unsigned int>(trg_cx) < size_x &&
-						static_cast<unsigned int>(trg_cy) < size_y);
+						// The x> comparison implicitly holds if x<0
+						ASSERT_(
+							static_cast<unsigned int>(trg_cx) < size_x &&
+							static_cast<unsigned int>(trg_cy) < size_y);
 
-					// Use "fractional integers" to approximate float operations
-					//  during the ray tracing:
-					int Acx = trg_cx - cx;
-					int Acy = trg_cy - cy;
+						// Use "fractional integers" to approximate float
+						// operations during the ray tracing:
+						int Acx = trg_cx - cx;
+						int Acy = trg_cy - cy;
 
-					int Acx_ = abs(Acx);
-					int Acy_ = abs(Acy);
+						int Acx_ = abs(Acx);
+						int Acy_ = abs(Acy);
 
-					int nStepsRay = max(Acx_, Acy_);
-					if (!nStepsRay) continue;  // May be...
+						int nStepsRay = max(Acx_, Acy_);
+						if (!nStepsRay) continue;  // May be...
 
-					// Integers store "float values * 128"
-					float N_1 = 1.0f / nStepsRay;  // Avoid division twice.
+						// Integers store "float values * 128"
+						float N_1 = 1.0f / nStepsRay;  // Avoid division twice.
 
-					// Increments at each raytracing step:
-					int frAcx =
-						(Acx < 0 ? -1 : +1) * round((Acx_ << FRBITS) * N_1);
-					int frAcy =
-						(Acy < 0 ? -1 : +1) * round((Acy_ << FRBITS) * N_1);
-
-					int frCX = cx << FRBITS;
-					int frCY = cy << FRBITS;
-					const auto logodd_free = o->validRange[idx]
-												 ? logodd_observation_free
-												 : logodd_noecho_free;
-
-					for (int nStep = 0; nStep < nStepsRay; nStep++)
-					{
-						updateCell_fast_free(
-							cx, cy, logodd_free, logodd_thres_free, theMapArray,
-							theMapSize_x);
+						// Increments at each raytracing step:
+						int frAcx =
+							(Acx < 0 ? -1 : +1) * round((Acx_ << FRBITS) * N_1);
+						int frAcy =
+							(Acy < 0 ? -1 : +1) * round((Acy_ << FRBITS) * N_1);
+
+						int frCX = cx << FRBITS;
+						int frCY = cy << FRBITS;
+						const auto logodd_free = o->validRange[i]
+													 ? logodd_observation_free
+													 : logodd_noecho_free;
+
+						// Jump to the first step within the band. The "y" is
+						// monotonic along the ray, and exactly computable
+						// with the integer arithmetic of the stepping:
+						int nStep = 0;
+						if (cy < band_cy1)
+							nStep = frAcy > 0 ? ((band_cy1 << FRBITS) - frCY +
+												 frAcy - 1) /
+													frAcy
+											  : nStepsRay;
+						else if (cy > band_cy2)
+							nStep = frAcy < 0
+										? (frCY - ((band_cy2 + 1) << FRBITS)) /
+												  (-frAcy) +
+											  1
+										: nStepsRay;
+						if (nStep > 0 && nStep < nStepsRay)
+						{
+							frCX += nStep * frAcx;
+							frCY += nStep * frAcy;
+							cx = frCX >> FRBITS;
+							cy = frCY >> FRBITS;
+						}
 
-						frCX += frAcx;
-						frCY += frAcy;
+						for (; nStep < nStepsRay; nStep++)
+						{
+							// Out of the band: we are done with this ray.
+							if (cy < band_cy1 || cy > band_cy2) break;
 
-						cx = frCX >> FRBITS;
-						cy = frCY >> FRBITS;
-					}
+							updateCell_fast_free(
+								getRawCellPtr_nocheck(cx, cy), logodd_free,
+								logodd_thres_free);
 
-					// And finally, the occupied cell at the end:
-					// Only if:
-					//  - It was a valid ray, and
-					//  - The ray was not truncated
-					if (o->validRange[idx] &&
-						o->scan[idx] < maxDistanceInsertion)
-						updateCell_fast_occupied(
-							trg_cx, trg_cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
+							frCX += frAcx;
+							frCY += frAcy;
+
+							cx = frCX >> FRBITS;
+							cy = frCY >> FRBITS;
+						}
+
+						// And finally, the occupied cell at the end:
+						// Only if:
+						//  - It was a valid ray, and
+						//  - The ray was not truncated
+						if (o->validRange[i] &&
+							o->scan[i] < maxDistanceInsertion &&
+							trg_cy >= band_cy1 && trg_cy <= band_cy2)
+							updateCell_fast_occupied(
+								getRawCellPtr_nocheck(trg_cx, trg_cy),
+								logodd_observation_occupied,
+								logodd_thres_occupied);
 
-				}  // End of each range
+					}  // End of each range
+				};
+				insertInRowBands(insertRays);
 
 				mrpt_alloca_free(scanPoints_x);
 				mrpt_alloca_free(scanPoints_y);
@@ -414,9 +451,6 @@ bool COccupancyGridMap2D::internal_insertObservation(
 				// -----------------------
 				resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
 
-				// For updateCell_fast methods:
-				cellType* theMapArray = &map[0];
-				unsigned theMapSize_x = size_x;
 
 				// int  cx0 = x2idx(px);		// Remember: This must be after
 				// the
@@ -436,360 +470,372 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					dAK = -K * o->aperture / N;
 				}
 
-				// Insert the rays:
+				// Insert the rays. Like in the simple rays case, each call
+				// only updates the cells in rows [band_cy1,band_cy2]:
 				// ------------------------------------------
-				// Vertices of the triangle: In meters
-				TLocalPoint P0, P1, P2, P1b;
-
-				last_valid_range = maxDistanceInsertion;
-
 				const double dA_2 = 0.5 * o->aperture / N;
-				for (idx = 0; idx < nRanges; idx += K, A += dAK)
-				{
-					float theR;  // The range of this beam
-					if (o->validRange[idx])
-					{
-						curRange = o->scan[idx];
-						last_valid_range = curRange;
-						theR = min(maxDistanceInsertion, curRange);
-					}
-					else
+				const double A_first = A;
+				auto insertBeams = [&](const int band_cy1, const int band_cy2) {
+					// Vertices of the triangle: In meters
+					TLocalPoint P0, P1, P2, P1b;
+
+					float beamLastValidRange = maxDistanceInsertion;
+					double beamAng = A_first;
+
+					// Free cells are always updated by rows:
+					auto insertFreeRow = [&](int cx1, int cx2, int cy) {
+						if (cy < band_cy1 || cy > band_cy2) return;
+						for (int ccx = cx1; ccx <= cx2; ccx++)
+							updateCell_fast_free(
+								getRawCellPtr_nocheck(ccx, cy),
+								logodd_observation_free, logodd_thres_free);
+					};
+
+					for (size_t i = 0; i < nRanges; i += K, beamAng += dAK)
 					{
-						// Invalid range:
-						if (invalidAsFree)
+						float theR;  // The range of this beam
+						if (o->validRange[i])
 						{
-							theR = min(
-								maxDistanceInsertion, 0.5f * last_valid_range);
+							beamLastValidRange = o->scan[i];
+							theR =
+								min(maxDistanceInsertion, beamLastValidRange);
 						}
 						else
-							continue;  // Nothing to do
-					}
-					if (theR < resolution)
-						continue;  // Range must be larger than a cell...
-					theR -= resolution;  // Remove one cell of length, which
-					// will be filled with "occupied"
-					// later.
-
-					/* ---------------------------------------------------------
-						  Fill one triangle with vertices: P0,P1,P2
-					   ---------------------------------------------------------
-					   */
-					P0.x = px;
-					P0.y = py;
-
-					P1.x = px + cos(A - dA_2) * theR;
-					P1.y = py + sin(A - dA_2) * theR;
-
-					P2.x = px + cos(A + dA_2) * theR;
-					P2.y = py + sin(A + dA_2) * theR;
-
-					// Order the vertices by the "y": P0->bottom, P2: top
-					if (P2.y < P1.y) std::swap(P2, P1);
-					if (P2.y < P0.y) std::swap(P2, P0);
-					if (P1.y < P0.y) std::swap(P1, P0);
-
-					// In cell indexes:
-					P0.cx = x2idx(P0.x);
-					P0.cy = y2idx(P0.y);
-					P1.cx = x2idx(P1.x);
-					P1.cy = y2idx(P1.y);
-					P2.cx = x2idx(P2.x);
-					P2.cy = y2idx(P2.y);
-
-#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
-					// The x> comparison implicitly holds if x<0
-					ASSERT_(
-						static_cast<unsigned int>(P0.cx) < size_x &&
-						static_cast<unsigned int>(P0.cy) < size_y);
-					ASSERT_(
-						static_cast<unsigned int>(P1.cx) < size_x &&
-						static_cast<unsigned int>(P1.cy) < size_y);
-					ASSERT_(
-						static_cast<unsigned int>(P2.cx) < size_x &&
-						static_cast<unsigned int>(P2.cy) < size_y);
-#endif
-
-					struct
-					{
-						int frX, frY;
-						int cx, cy;
-					} R1, R2;  // Fractional coords of the two rays:
-
-					// Special case: one single row
-					if (P0.cy == P2.cy && P0.cy == P1.cy)
-					{
-						// Optimized case:
-						int min_cx = min3(P0.cx, P1.cx, P2.cx);
-						int max_cx = max3(P0.cx, P1.cx, P2.cx);
-
-						for (int ccx = min_cx; ccx <= max_cx; ccx++)
-							updateCell_fast_free(
-								ccx, P0.cy, logodd_observation_free,
-								logodd_thres_free, theMapArray, theMapSize_x);
-					}
-					else
-					{
-						// The intersection point P1b in the segment P0-P2 at
-						// the "y" of P1:
-						P1b.y = P1.y;
-						P1b.x = P0.x +
-								(P1.y - P0.y) * (P2.x - P0.x) / (P2.y - P0.y);
-
-						P1b.cx = x2idx(P1b.x);
-						P1b.cy = y2idx(P1b.y);
-
-						// Use "fractional integers" to approximate float
-						// operations during the ray tracing:
-						// Integers store "float values * 128"
-						const int Acx01 = P1.cx - P0.cx;
-						const int Acy01 = P1.cy - P0.cy;
-						const int Acx01b = P1b.cx - P0.cx;
-						// const int Acy01b = P1b.cy - P0.cy;  // = Acy01
-
-						// Increments at each raytracing step:
-						const float inv_N_01 =
-							1.0f / (max3(abs(Acx01), abs(Acy01), abs(Acx01b)) +
-									1);  // Number of steps ^ -1
-						const int frAcx01 = round(
-							(Acx01 << FRBITS) * inv_N_01);  //  Acx*128 / N
-						const int frAcy01 = round(
-							(Acy01 << FRBITS) * inv_N_01);  //  Acy*128 / N
-						const int frAcx01b = round(
-							(Acx01b << FRBITS) * inv_N_01);  //  Acx*128 / N
-
-						// ------------------------------------
-						// First sub-triangle: P0-P1-P1b
-						// ------------------------------------
-						R1.cx = P0.cx;
-						R1.cy = P0.cy;
-						R1.frX = P0.cx << FRBITS;
-						R1.frY = P0.cy << FRBITS;
-
-						int frAx_R1 = 0, frAx_R2 = 0;  //, frAy_R2;
-						int frAy_R1 = frAcy01;
-
-						// Start R1=R2 = P0... unlesss P0.cy == P1.cy, i.e.
-						// there is only one row:
-						if (P0.cy != P1.cy)
 						{
-							R2 = R1;
-							//  R1 & R2 follow the edges: P0->P1  & P0->P1b
-							//  R1 is forced to be at the left hand:
-							if (P1.x < P1b.x)
+							// Invalid range:
+							if (invalidAsFree)
 							{
-								// R1: P0->P1
-								frAx_R1 = frAcx01;
-								frAx_R2 = frAcx01b;
+								theR = min(
+									maxDistanceInsertion,
+									0.5f * beamLastValidRange);
 							}
 							else
-							{
-								// R1: P0->P1b
-								frAx_R1 = frAcx01b;
-								frAx_R2 = frAcx01;
-							}
+								continue;  // Nothing to do
 						}
-						else
-						{
-							R2.cx = P1.cx;
-							R2.cy = P1.cy;
-							R2.frX = P1.cx << FRBITS;
-							// R2.frY = P1.cy << FRBITS;
-						}
-
-						int last_insert_cy = -1;
-						// int last_insert_cx = -1;
-						do
-						{
-							if (last_insert_cy !=
-								R1.cy)  // || last_insert_cx!=R1.cx)
-							{
-								last_insert_cy = R1.cy;
-								//	last_insert_cx = R1.cx;
-
-								for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
-									updateCell_fast_free(
-										ccx, R1.cy, logodd_observation_free,
-										logodd_thres_free, theMapArray,
-										theMapSize_x);
-							}
-
-							R1.frX += frAx_R1;
-							R1.frY += frAy_R1;
-							R2.frX += frAx_R2;  // R1.frY += frAcy01;
-
-							R1.cx = R1.frX >> FRBITS;
-							R1.cy = R1.frY >> FRBITS;
-							R2.cx = R2.frX >> FRBITS;
-						} while (R1.cy < P1.cy);
-
-						// ------------------------------------
-						// Second sub-triangle: P1-P1b-P2
-						// ------------------------------------
+						if (theR < resolution)
+							continue;  // Range must be larger than a cell...
+						theR -= resolution;  // Remove one cell of length, which
+						// will be filled with "occupied"
+						// later.
+
+						/* -----------------------------------------------------
+							  Fill one triangle with vertices: P0,P1,P2
+						   -----------------------------------------------------
+						   */
+						P0.x = px;
+						P0.y = py;
+
+						P1.x = px + cos(beamAng - dA_2) * theR;
+						P1.y = py + sin(beamAng - dA_2) * theR;
+
+						P2.x = px + cos(beamAng + dA_2) * theR;
+						P2.y = py + sin(beamAng + dA_2) * theR;
+
+						// Order the vertices by the "y": P0->bottom, P2: top
+						if (P2.y < P1.y) std::swap(P2, P1);
+						if (P2.y < P0.y) std::swap(P2, P0);
+						if (P1.y < P0.y) std::swap(P1, P0);
+
+						// In cell indexes:
+						P0.cx = x2idx(P0.x);
+						P0.cy = y2idx(P0.y);
+						P1.cx = x2idx(P1.x);
+						P1.cy = y2idx(P1.y);
+						P2.cx = x2idx(P2.x);
+						P2.cy = y2idx(P2.y);
 
-						// Use "fractional integers" to approximate float
-						// operations during the ray tracing:
-						// Integers store "float values * 128"
-						const int Acx12 = P2.cx - P1.cx;
-						const int Acy12 = P2.cy - P1.cy;
-						const int Acx1b2 = P2.cx - P1b.cx;
-						// const int Acy1b2 = Acy12
+	#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
+						// The x> comparison implicitly holds if x<0
+						ASSERT_(
+							static_cast<unsigned int>(P0.cx) < size_x &&
+							static_cast<unsigned int>(P0.cy) < size_y);
+						ASSERT_(
+							static_cast<unsigned int>(P1.cx) < size_x &&
+							static_cast<unsigned int>(P1.cy) < size_y);
+						ASSERT_(
+							static_cast<unsigned int>(P2.cx) < size_x &&
+							static_cast<unsigned int>(P2.cy) < size_y);
+	#endif
 
-						// Increments at each raytracing step:
-						const float inv_N_12 =
-							1.0f / (max3(abs(Acx12), abs(Acy12), abs(Acx1b2)) +
-									1);  // Number of steps ^ -1
-						const int frAcx12 = round(
-							(Acx12 << FRBITS) * inv_N_12);  //  Acx*128 / N
-						const int frAcy12 = round(
-							(Acy12 << FRBITS) * inv_N_12);  //  Acy*128 / N
-						const int frAcx1b2 = round(
-							(Acx1b2 << FRBITS) * inv_N_12);  //  Acx*128 / N
-
-						// struct { int frX,frY; int cx,cy; } R1,R2;	//
-						// Fractional coords of the two rays:
-						// R1, R2 follow edges P1->P2 & P1b->P2
-						// R1 forced to be at the left hand
-						frAy_R1 = frAcy12;
-						if (!frAy_R1)
-							frAy_R1 = 2 << FRBITS;  // If Ay=0, force it to be
-						// >0 so the "do...while"
-						// loop below ends in ONE
-						// iteration.
+						struct
+						{
+							int frX, frY;
+							int cx, cy;
+						} R1, R2;  // Fractional coords of the two rays:
 
-						if (P1.x < P1b.x)
+						// Special case: one single row
+						if (P0.cy == P2.cy && P0.cy == P1.cy)
 						{
-							// R1: P1->P2,  R2: P1b->P2
-							R1.cx = P1.cx;
-							R1.cy = P1.cy;
-							R2.cx = P1b.cx;
-							R2.cy = P1b.cy;
-							frAx_R1 = frAcx12;
-							frAx_R2 = frAcx1b2;
+							// Optimized case:
+							int min_cx = min3(P0.cx, P1.cx, P2.cx);
+							int max_cx = max3(P0.cx, P1.cx, P2.cx);
+
+							insertFreeRow(min_cx, max_cx, P0.cy);
 						}
 						else
 						{
-							// R1: P1b->P2,  R2: P1->P2
-							R1.cx = P1b.cx;
-							R1.cy = P1b.cy;
-							R2.cx = P1.cx;
-							R2.cy = P1.cy;
-							frAx_R1 = frAcx1b2;
-							frAx_R2 = frAcx12;
-						}
+							// The intersection point P1b in the segment P0-P2
+							// at the "y" of P1:
+							P1b.y = P1.y;
+							P1b.x = P0.x + (P1.y - P0.y) * (P2.x - P0.x) /
+											   (P2.y - P0.y);
 
-						R1.frX = R1.cx << FRBITS;
-						R1.frY = R1.cy << FRBITS;
-						R2.frX = R2.cx << FRBITS;
-						R2.frY = R2.cy << FRBITS;
+							P1b.cx = x2idx(P1b.x);
+							P1b.cy = y2idx(P1b.y);
 
-						last_insert_cy = -100;
-						// last_insert_cx=-100;
+							// Use "fractional integers" to approximate float
+							// operations during the ray tracing:
+							// Integers store "float values * 128"
+							const int Acx01 = P1.cx - P0.cx;
+							const int Acy01 = P1.cy - P0.cy;
+							const int Acx01b = P1b.cx - P0.cx;
+							// const int Acy01b = P1b.cy - P0.cy;  // = Acy01
 
-						do
-						{
-							if (last_insert_cy !=
-								R1.cy)  // || last_insert_cx!=R1.cx)
+							// Increments at each raytracing step:
+							const float inv_N_01 =
+								1.0f /
+								(max3(abs(Acx01), abs(Acy01), abs(Acx01b)) +
+								 1);  // Number of steps ^ -1
+							const int frAcx01 = round(
+								(Acx01 << FRBITS) * inv_N_01);  //  Acx*128 / N
+							const int frAcy01 = round(
+								(Acy01 << FRBITS) * inv_N_01);  //  Acy*128 / N
+							const int frAcx01b = round(
+								(Acx01b << FRBITS) * inv_N_01);  //  Acx*128 / N
+
+							// ------------------------------------
+							// First sub-triangle: P0-P1-P1b
+							// ------------------------------------
+							R1.cx = P0.cx;
+							R1.cy = P0.cy;
+							R1.frX = P0.cx << FRBITS;
+							R1.frY = P0.cy << FRBITS;
+
+							int frAx_R1 = 0, frAx_R2 = 0;  //, frAy_R2;
+							int frAy_R1 = frAcy01;
+
+							// Start R1=R2 = P0... unlesss P0.cy == P1.cy, i.e.
+							// there is only one row:
+							if (P0.cy != P1.cy)
 							{
-								//	last_insert_cx = R1.cx;
-								last_insert_cy = R1.cy;
-								for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
-									updateCell_fast_free(
-										ccx, R1.cy, logodd_observation_free,
-										logodd_thres_free, theMapArray,
-										theMapSize_x);
+								R2 = R1;
+								//  R1 & R2 follow the edges: P0->P1  & P0->P1b
+								//  R1 is forced to be at the left hand:
+								if (P1.x < P1b.x)
+								{
+									// R1: P0->P1
+									frAx_R1 = frAcx01;
+									frAx_R2 = frAcx01b;
+								}
+								else
+								{
+									// R1: P0->P1b
+									frAx_R1 = frAcx01b;
+									frAx_R2 = frAcx01;
+								}
+							}
+							else
+							{
+								R2.cx = P1.cx;
+								R2.cy = P1.cy;
+								R2.frX = P1.cx << FRBITS;
+								// R2.frY = P1.cy << FRBITS;
 							}
 
-							R1.frX += frAx_R1;
-							R1.frY += frAy_R1;
-							R2.frX += frAx_R2;  // R1.frY += frAcy01;
-
-							R1.cx = R1.frX >> FRBITS;
-							R1.cy = R1.frY >> FRBITS;
-							R2.cx = R2.frX >> FRBITS;
-						} while (R1.cy <= P2.cy);
-
-					}  // end of free-area normal case (not a single row)
-
-					// ----------------------------------------------------
-					// The final occupied cells along the edge P1<->P2
-					// Only if:
-					//  - It was a valid ray, and
-					//  - The ray was not truncated
-					// ----------------------------------------------------
-					if (o->validRange[idx] &&
-						o->scan[idx] < maxDistanceInsertion)
-					{
-						theR += resolution;
+							int last_insert_cy = -1;
+							// int last_insert_cx = -1;
+							do
+							{
+								if (last_insert_cy !=
+									R1.cy)  // || last_insert_cx!=R1.cx)
+								{
+									last_insert_cy = R1.cy;
+									//	last_insert_cx = R1.cx;
 
-						P1.x = px + cos(A - dA_2) * theR;
-						P1.y = py + sin(A - dA_2) * theR;
+									insertFreeRow(R1.cx, R2.cx, R1.cy);
+								}
 
-						P2.x = px + cos(A + dA_2) * theR;
-						P2.y = py + sin(A + dA_2) * theR;
+								R1.frX += frAx_R1;
+								R1.frY += frAy_R1;
+								R2.frX += frAx_R2;  // R1.frY += frAcy01;
 
-						P1.cx = x2idx(P1.x);
-						P1.cy = y2idx(P1.y);
-						P2.cx = x2idx(P2.x);
-						P2.cy = y2idx(P2.y);
+								R1.cx = R1.frX >> FRBITS;
+								R1.cy = R1.frY >> FRBITS;
+								R2.cx = R2.frX >> FRBITS;
+							} while (R1.cy < P1.cy);
 
-#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
-						// The x> comparison implicitly holds if x<0
-						ASSERT_(
-							static_cast<unsigned int>(P1.cx) < size_x &&
-							static_cast<unsigned int>(P1.cy) < size_y);
-						ASSERT_(
-							static_cast<unsigned int>(P2.cx) < size_x &&
-							static_cast<unsigned int>(P2.cy) < size_y);
-#endif
+							// ------------------------------------
+							// Second sub-triangle: P1-P1b-P2
+							// ------------------------------------
 
-						// Special case: Only one cell:
-						if (P2.cx == P1.cx && P2.cy == P1.cy)
-						{
-							updateCell_fast_occupied(
-								P1.cx, P1.cy, logodd_observation_occupied,
-								logodd_thres_occupied, theMapArray,
-								theMapSize_x);
-						}
-						else
-						{
 							// Use "fractional integers" to approximate float
 							// operations during the ray tracing:
 							// Integers store "float values * 128"
-							const int AcxE = P2.cx - P1.cx;
-							const int AcyE = P2.cy - P1.cy;
+							const int Acx12 = P2.cx - P1.cx;
+							const int Acy12 = P2.cy - P1.cy;
+							const int Acx1b2 = P2.cx - P1b.cx;
+							// const int Acy1b2 = Acy12
 
 							// Increments at each raytracing step:
-							const int nSteps = (max(abs(AcxE), abs(AcyE)) + 1);
 							const float inv_N_12 =
-								1.0f / nSteps;  // Number of steps ^ -1
-							const int frAcxE = round(
-								(AcxE << FRBITS) * inv_N_12);  //  Acx*128 / N
-							const int frAcyE = round(
-								(AcyE << FRBITS) * inv_N_12);  //  Acy*128 / N
-
-							R1.cx = P1.cx;
-							R1.cy = P1.cy;
+								1.0f /
+								(max3(abs(Acx12), abs(Acy12), abs(Acx1b2)) +
+								 1);  // Number of steps ^ -1
+							const int frAcx12 = round(
+								(Acx12 << FRBITS) * inv_N_12);  //  Acx*128 / N
+							const int frAcy12 = round(
+								(Acy12 << FRBITS) * inv_N_12);  //  Acy*128 / N
+							const int frAcx1b2 = round(
+								(Acx1b2 << FRBITS) * inv_N_12);  //  Acx*128 / N
+
+							// struct { int frX,frY; int cx,cy; } R1,R2;	//
+							// Fractional coords of the two rays:
+							// R1, R2 follow edges P1->P2 & P1b->P2
+							// R1 forced to be at the left hand
+							frAy_R1 = frAcy12;
+							if (!frAy_R1)
+								frAy_R1 = 2 << FRBITS;  // If Ay=0, force it to
+							// >0 so the "do...while"
+							// loop below ends in ONE
+							// iteration.
+
+							if (P1.x < P1b.x)
+							{
+								// R1: P1->P2,  R2: P1b->P2
+								R1.cx = P1.cx;
+								R1.cy = P1.cy;
+								R2.cx = P1b.cx;
+								R2.cy = P1b.cy;
+								frAx_R1 = frAcx12;
+								frAx_R2 = frAcx1b2;
+							}
+							else
+							{
+								// R1: P1b->P2,  R2: P1->P2
+								R1.cx = P1b.cx;
+								R1.cy = P1b.cy;
+								R2.cx = P1.cx;
+								R2.cy = P1.cy;
+								frAx_R1 = frAcx1b2;
+								frAx_R2 = frAcx12;
+							}
+
 							R1.frX = R1.cx << FRBITS;
 							R1.frY = R1.cy << FRBITS;
+							R2.frX = R2.cx << FRBITS;
+							R2.frY = R2.cy << FRBITS;
+
+							last_insert_cy = -100;
+							// last_insert_cx=-100;
 
-							for (int nStep = 0; nStep <= nSteps; nStep++)
+							do
 							{
-								updateCell_fast_occupied(
-									R1.cx, R1.cy, logodd_observation_occupied,
-									logodd_thres_occupied, theMapArray,
-									theMapSize_x);
+								if (last_insert_cy !=
+									R1.cy)  // || last_insert_cx!=R1.cx)
+								{
+									//	last_insert_cx = R1.cx;
+									last_insert_cy = R1.cy;
+									insertFreeRow(R1.cx, R2.cx, R1.cy);
+								}
+
+								R1.frX += frAx_R1;
+								R1.frY += frAy_R1;
+								R2.frX += frAx_R2;  // R1.frY += frAcy01;
 
-								R1.frX += frAcxE;
-								R1.frY += frAcyE;
 								R1.cx = R1.frX >> FRBITS;
 								R1.cy = R1.frY >> FRBITS;
+								R2.cx = R2.frX >> FRBITS;
+							} while (R1.cy <= P2.cy);
+
+						}  // end of free-area normal case (not a single row)
+
+						// ----------------------------------------------------
+						// The final occupied cells along the edge P1<->P2
+						// Only if:
+						//  - It was a valid ray, and
+						//  - The ray was not truncated
+						// ----------------------------------------------------
+						if (o->validRange[i] &&
+							o->scan[i] < maxDistanceInsertion)
+						{
+							theR += resolution;
+
+							P1.x = px + cos(beamAng - dA_2) * theR;
+							P1.y = py + sin(beamAng - dA_2) * theR;
+
+							P2.x = px + cos(beamAng + dA_2) * theR;
+							P2.y = py + sin(beamAng + dA_2) * theR;
+
+							P1.cx = x2idx(P1.x);
+							P1.cy = y2idx(P1.y);
+							P2.cx = x2idx(P2.x);
+							P2.cy = y2idx(P2.y);
+
+	#if defined(_DEBUG) || (MRPT_ALWAYS_CHECKS_DEBUG)
+							// The x> comparison implicitly holds if x<0
+							ASSERT_(
+								static_cast<unsigned int>(P1.cx) < size_x &&
+								static_cast<unsigned int>(P1.cy) < size_y);
+							ASSERT_(
+								static_cast<unsigned int>(P2.cx) < size_x &&
+								static_cast<unsigned int>(P2.cy) < size_y);
+	#endif
+
+							// Special case: Only one cell:
+							if (P2.cx == P1.cx && P2.cy == P1.cy)
+							{
+								if (P1.cy >= band_cy1 && P1.cy <= band_cy2)
+									updateCell_fast_occupied(
+										getRawCellPtr_nocheck(P1.cx, P1.cy),
+										logodd_observation_occupied,
+										logodd_thres_occupied);
 							}
-
-						}  // end do a line
-
-					}  // end if we must set occupied cells
-
-				}  // End of each range
+							else
+							{
+								// Use "fractional integers" to approximate
+								// float operations during the ray tracing:
+								// Integers store "float values * 128"
+								const int AcxE = P2.cx - P1.cx;
+								const int AcyE = P2.cy - P1.cy;
+
+								// Increments at each raytracing step:
+								const int nSteps =
+									(max(abs(AcxE), abs(AcyE)) + 1);
+								const float inv_N_12 =
+									1.0f / nSteps;  // Number of steps ^ -1
+								const int frAcxE = round(
+									(AcxE << FRBITS) *
+									inv_N_12);  //  Acx*128 / N
+								const int frAcyE = round(
+									(AcyE << FRBITS) *
+									inv_N_12);  //  Acy*128 / N
+
+								R1.cx = P1.cx;
+								R1.cy = P1.cy;
+								R1.frX = R1.cx << FRBITS;
+								R1.frY = R1.cy << FRBITS;
+
+								for (int nStep = 0; nStep <= nSteps; nStep++)
+								{
+									if (R1.cy >= band_cy1 && R1.cy <= band_cy2)
+										updateCell_fast_occupied(
+											getRawCellPtr_nocheck(R1.cx, R1.cy),
+											logodd_observation_occupied,
+											logodd_thres_occupied);
+
+									R1.frX += frAcxE;
+									R1.frY += frAcyE;
+									R1.cx = R1.frX >> FRBITS;
+									R1.cy = R1.frY >> FRBITS;
+								}
+
+							}  // end do a line
+
+						}  // end if we must set occupied cells
+
+					}  // End of each range
+				};
+				insertInRowBands(insertBeams);
 
 			}  // end insert with beam widening
 
@@ -854,6 +900,13 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			MRPT_CHECK_NORMAL_NUMBER(px);
 			MRPT_CHECK_NORMAL_NUMBER(py);
 #endif
+
+			// Only cells within the maximum insertion distance may change:
+			{
+				const float R = maxDistanceInsertion + resolution;
+				markModifiedCells(
+					x2idx(px - R), x2idx(px + R), y2idx(py - R), y2idx(py + R));
+			}
 			// ---------------------------------
 			//  		Widen rays
 			// Algorithm in: http://www.mrpt.org/Occupancy_Grids
@@ -932,9 +985,6 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			// -----------------------
 			resizeGrid(new_x_min, new_x_max, new_y_min, new_y_max, 0.5);
 
-			// For updateCell_fast methods:
-			cellType* theMapArray = &map[0];
-			unsigned theMapSize_x = size_x;
 
 			// int  cx0 = x2idx(px);		// Remember: This must be after the
 			// resizeGrid!!
@@ -1031,8 +1081,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 
 					for (int ccx = min_cx; ccx <= max_cx; ccx++)
 						updateCell_fast_free(
-							ccx, P0.cy, logodd_observation_free,
-							logodd_thres_free, theMapArray, theMapSize_x);
+							getRawCellPtr_nocheck(ccx, P0.cy),
+							logodd_observation_free, logodd_thres_free);
 				}
 				else
 				{
@@ -1114,9 +1164,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 
 							for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 								updateCell_fast_free(
-									ccx, R1.cy, logodd_observation_free,
-									logodd_thres_free, theMapArray,
-									theMapSize_x);
+									getRawCellPtr_nocheck(ccx, R1.cy),
+									logodd_observation_free, logodd_thres_free);
 						}
 
 						R1.frX += frAx_R1;
@@ -1199,9 +1248,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 							last_insert_cy = R1.cy;
 							for (int ccx = R1.cx; ccx <= R2.cx; ccx++)
 								updateCell_fast_free(
-									ccx, R1.cy, logodd_observation_free,
-									logodd_thres_free, theMapArray,
-									theMapSize_x);
+									getRawCellPtr_nocheck(ccx, R1.cy),
+									logodd_observation_free, logodd_thres_free);
 						}
 
 						R1.frX += frAx_R1;
@@ -1250,8 +1298,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					if (P2.cx == P1.cx && P2.cy == P1.cy)
 					{
 						updateCell_fast_occupied(
-							P1.cx, P1.cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
+							getRawCellPtr_nocheck(P1.cx, P1.cy),
+							logodd_observation_occupied, logodd_thres_occupied);
 					}
 					else
 					{
@@ -1278,9 +1326,9 @@ bool COccupancyGridMap2D::internal_insertObservation(
 						for (int nStep = 0; nStep <= nSteps; nStep++)
 						{
 							updateCell_fast_occupied(
-								R1.cx, R1.cy, logodd_observation_occupied,
-								logodd_thres_occupied, theMapArray,
-								theMapSize_x);
+								getRawCellPtr_nocheck(R1.cx, R1.cy),
+								logodd_observation_occupied,
+								logodd_thres_occupied);
 
 							R1.frX += frAcxE;
 							R1.frY += frAcyE;
@@ -1327,7 +1375,8 @@ COccupancyGridMap2D::TInsertionOptions::TInsertionOptions()
 	  CFD_features_gaussian_size(1),
 	  CFD_features_median_size(3),
 
-	  wideningBeamsWithDistance(false)
+	  wideningBeamsWithDistance(false),
+	  numThreads(1)
 {
 }
 
@@ -1351,6 +1400,7 @@ void COccupancyGridMap2D::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(CFD_features_gaussian_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(CFD_features_median_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(wideningBeamsWithDistance, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -1375,10 +1425,51 @@ void COccupancyGridMap2D::TInsertionOptions::dumpToTextStream(
 	LOADABLEOPTS_DUMP_VAR(CFD_features_gaussian_size, float)
 	LOADABLEOPTS_DUMP_VAR(CFD_features_median_size, float)
 	LOADABLEOPTS_DUMP_VAR(wideningBeamsWithDistance, bool)
+	LOADABLEOPTS_DUMP_VAR(numThreads, int)
 
 	out << mrpt::format("\n");
 }
 
+/*---------------------------------------------------------------
+					insertInRowBands
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::insertInRowBands(
+	const std::function<void(int, int)>& insertRows)
+{
+	unsigned int nThreads = insertionOptions.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+
+	if (nThreads <= 1 || size_y < 2)
+	{
+		insertRows(0, static_cast<int>(size_y) - 1);
+		return;
+	}
+
+	if (!m_insertionThreadPool || m_insertionThreadPool->size() != nThreads)
+		m_insertionThreadPool =
+			std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+
+	// Several bands per thread, since the load concentrates around the
+	// sensor:
+	size_t bandRows = std::max<size_t>(8, size_y / (4 * nThreads));
+	// Each tile must belong to one band only, since tiles are allocated
+	// while inserting, so bands are aligned to the rows of tiles:
+	size_t firstRowOffset = 0;
+	if (m_tiledStorage)
+	{
+		bandRows = ((bandRows + TILE_MASK) >> TILE_BITS) << TILE_BITS;
+		firstRowOffset = m_tileOffsetY;
+	}
+	m_insertionThreadPool->parallelForBlocks(
+		size_y + firstRowOffset, bandRows,
+		[&](const size_t first, const size_t last) {
+			insertRows(
+				static_cast<int>(std::max(first, firstRowOffset)) -
+					static_cast<int>(firstRowOffset),
+				static_cast<int>(last - firstRowOffset) - 1);
+		});
+}
+
 void COccupancyGridMap2D::OnPostSuccesfulInsertObs(
 	const mrpt::obs::CObservation*)
 {
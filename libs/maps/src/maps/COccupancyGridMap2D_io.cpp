@@ -57,13 +57,31 @@ void COccupancyGridMap2D::serializeTo(mrpt::serialization::CArchive& out) const
 #endif
 
 	out << size_x << size_y << x_min << x_max << y_min << y_max << resolution;
-	ASSERT_(size_x * size_y == map.size());
 
+	// The stream always holds all the cells, regardless of the storage:
+	if (!m_tiledStorage)
+	{
+		ASSERT_(size_x * size_y == map.size());
+#ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
+		out.WriteBuffer(&map[0], sizeof(map[0]) * size_x * size_y);
+#else
+		out.WriteBufferFixEndianness(&map[0], size_x * size_y);
+#endif
+	}
+	else
+	{
+		std::vector<cellType> row(size_x);
+		for (uint32_t cy = 0; cy < size_y; cy++)
+		{
+			for (uint32_t cx = 0; cx < size_x; cx++)
+				row[cx] = getRawCell_nocheck(cx, cy);
 #ifdef OCCUPANCY_GRIDMAP_CELL_SIZE_8BITS
-	out.WriteBuffer(&map[0], sizeof(map[0]) * size_x * size_y);
+			out.WriteBuffer(&row[0], sizeof(row[0]) * size_x);
 #else
-	out.WriteBufferFixEndianness(&map[0], size_x * size_y);
+			out.WriteBufferFixEndianness(&row[0], size_x);
 #endif
+		}
+	}
 
 	// insertionOptions:
 	out << insertionOptions.mapAltitude << insertionOptions.useMapAltitude
@@ -142,6 +160,8 @@ void COccupancyGridMap2D::serializeFrom(
 				new_x_min, new_x_max, new_y_min, new_y_max, new_resolution,
 				0.5);
 
+			// Cells are read as a dense grid, then moved into tiles if needed:
+			if (m_tiledStorage) map.assign(size_x * size_y, p2l(0.5f));
 			ASSERT_(size_x * size_y == map.size());
 
 			if (bitsPerCellStream == MyBitsPerCell)
@@ -193,9 +213,10 @@ void COccupancyGridMap2D::serializeFrom(
 					*ptr++ = p2l(p);
 				}
 			}
+			if (m_tiledStorage) denseToTiles();
 
 			// For the precomputed likelihood trick:
-			precomputedLikelihoodToBeRecomputed = true;
+			invalidateDerivedData();
 
 			if (version >= 1)
 			{
@@ -293,7 +314,7 @@ bool COccupancyGridMap2D::loadFromBitmap(
 	MRPT_START
 
 	// For the precomputed likelihood trick:
-	precomputedLikelihoodToBeRecomputed = true;
+	invalidateDerivedData();
 
 	size_t bmpWidth = imgFl.getWidth();
 	size_t bmpHeight = imgFl.getHeight();
@@ -15,6 +15,10 @@
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/serialization/CArchive.h>
 
+#if MRPT_HAS_SSE2
+#include <mrpt/core/SSE_types.h>
+#endif
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::maps;
@@ -80,6 +84,121 @@ double COccupancyGridMap2D::internal_computeObservationLikelihood(
 	};
 }
 
+namespace
+{
+/** The log-likelihood of the "lmRayTracing" method, given the ranges
+ * simulated at the rays 0, decimation, 2*decimation,... of the scan. */
+double rayTracingLogLikelihood(
+	const CObservation2DRangeScan& o, const float* simRanges,
+	const int decimation, const double stdLaser)
+{
+	const int nRays = o.scan.size();
+	const double stdSqrt2 = sqrt(2.0f) * stdLaser;
+
+	// Compute likelihoods:
+	double ret = 1;
+	for (int j = 0; j < nRays; j += decimation)
+	{
+		// Simulated and measured ranges:
+		const float r_sim = simRanges[j];
+		const float r_obs = o.scan[j];
+
+		// Is a valid range?
+		if (o.validRange[j])
+		{
+			const double likelihood =
+				0.1 / o.maxRange +
+				0.9 *
+					exp(-square(
+						min((float)fabs(r_sim - r_obs), 2.0f) / stdSqrt2));
+			ret += log(likelihood);
+		}
+	}
+	return ret;
+}
+}  // namespace
+
+/*---------------------------------------------------------------
+			computeObservationLikelihoodForPoses
+---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeObservationLikelihoodForPoses(
+	const CObservation* obs, const std::vector<TPose2D>& robotPoses,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	ASSERT_(obs != nullptr);
+
+	if (genericMapParams.enableObservationLikelihood &&
+		likelihoodOptions.likelihoodMethod == lmLikelihoodField_Thrun &&
+		IS_CLASS(obs, CObservation2DRangeScan))
+	{
+		const CObservation2DRangeScan* o =
+			static_cast<const CObservation2DRangeScan*>(obs);
+
+		// Same checks than in internal_computeObservationLikelihood():
+		if (!o->isPlanarScan(insertionOptions.horizontalTolerance) ||
+			(insertionOptions.useMapAltitude &&
+			 fabs(insertionOptions.mapAltitude - o->sensorPose.z()) > 0.01))
+		{
+			out_log_liks.assign(robotPoses.size(), -10);
+			return;
+		}
+
+		CPointsMap::TInsertionOptions opts;
+		opts.minDistBetweenLaserPoints = resolution * 0.5f;
+		opts.isPlanarMap = true;  // Already filtered above!
+		opts.horizontalTolerance = insertionOptions.horizontalTolerance;
+
+		computeLikelihoodField_Thrun(
+			o->buildAuxPointsMap<mrpt::maps::CPointsMap>(&opts), robotPoses,
+			out_log_liks);
+		return;
+	}
+
+	if (genericMapParams.enableObservationLikelihood &&
+		likelihoodOptions.likelihoodMethod == lmRayTracing &&
+		IS_CLASS(obs, CObservation2DRangeScan))
+	{
+		const CObservation2DRangeScan* o =
+			static_cast<const CObservation2DRangeScan*>(obs);
+
+		// Same checks than in internal_computeObservationLikelihood():
+		if (!o->isPlanarScan(insertionOptions.horizontalTolerance) ||
+			(insertionOptions.useMapAltitude &&
+			 fabs(insertionOptions.mapAltitude - o->sensorPose.z()) > 0.01))
+		{
+			out_log_liks.assign(robotPoses.size(), -10);
+			return;
+		}
+
+		// Same simulation than computeObservationLikelihood_rayTracing(),
+		// for all the poses at once:
+		TLaserSimulBatchParams simParams;
+		simParams.threshold = 0.45f;
+		simParams.nRays = o->scan.size();
+		simParams.decimation = likelihoodOptions.rayTracing_decimation;
+		std::vector<float> ranges;
+		std::vector<char> valids;
+		laserScanSimulatorBatch(*o, robotPoses, ranges, valids, simParams);
+
+		out_log_liks.resize(robotPoses.size());
+		for (size_t i = 0; i < robotPoses.size(); i++)
+			out_log_liks[i] = rayTracingLogLikelihood(
+				*o, &ranges[i * simParams.nRays], simParams.decimation,
+				likelihoodOptions.rayTracing_stdHit);
+		return;
+	}
+
+	// Generic case: one pose at a time.
+	out_log_liks.resize(robotPoses.size());
+	for (size_t i = 0; i < robotPoses.size(); i++)
+		out_log_liks[i] =
+			computeObservationLikelihood(obs, CPose2D(robotPoses[i]));
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 			computeObservationLikelihood_Consensus
 ---------------------------------------------------------------*/
@@ -393,33 +512,9 @@ double COccupancyGridMap2D::computeObservationLikelihood_rayTracing(
 			nRays,  // Scan length
 			0, decimation);
 
-		double stdLaser = likelihoodOptions.rayTracing_stdHit;
-		double stdSqrt2 = sqrt(2.0f) * stdLaser;
-
-		// Compute likelihoods:
-		ret = 1;
-		// bool		useDF = likelihoodOptions.rayTracing_useDistanceFilter;
-		float r_sim, r_obs;
-		double likelihood;
-
-		for (int j = 0; j < nRays; j += decimation)
-		{
-			// Simulated and measured ranges:
-			r_sim = simulatedObs.scan[j];
-			r_obs = o->scan[j];
-
-			// Is a valid range?
-			if (o->validRange[j])
-			{
-				likelihood =
-					0.1 / o->maxRange +
-					0.9 *
-						exp(-square(
-							min((float)fabs(r_sim - r_obs), 2.0f) / stdSqrt2));
-				ret += log(likelihood);
-				// printf("Sim=%f\tReal=%f\tlik=%f\n",r_sim,r_obs,likelihood);
-			}
-		}
+		ret = rayTracingLogLikelihood(
+			*o, &simulatedObs.scan[0], decimation,
+			likelihoodOptions.rayTracing_stdHit);
 	}
 
 	return ret;
@@ -519,199 +614,408 @@ double COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_II(
 	MRPT_END
 }
 
+namespace
+{
+/** Constants of the likelihood field model ("LF_Thrun"), shared by the
+ * on-the-fly evaluation and the likelihood cache so both give identical
+ * values. Distances to obstacles are handled in "discrete units": 100 times
+ * the squared distance in cells. */
+struct LF_Thrun_Model
+{
+	LF_Thrun_Model(
+		const COccupancyGridMap2D::TLikelihoodOptions& opts,
+		const float resolution)
+		: K((int)ceil(opts.LF_maxCorrsDistance /*m*/ / resolution)),
+		  zHit(opts.LF_zHit),
+		  zRandomTerm(opts.LF_zRandom / opts.LF_maxRange),
+		  Q(-0.5f / square(opts.LF_stdHit)),
+		  useSquareDist(opts.LF_useSquareDist)
+	{
+		const double maxCorrDist_sq = square(opts.LF_maxCorrsDistance);
+		const double _resolution = resolution;
+		const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
+		constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+		minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
+		maxDistInt = mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+	}
+
+	/** The size of the checking area for matchings, in cells */
+	int K;
+	float zHit, zRandomTerm, Q;
+	bool useSquareDist;
+	double constDist2DiscrUnits_INV;
+	/** Likelihood of points out of the map */
+	double minimumLik;
+	/** Max. correspondence distance, in discrete units */
+	unsigned int maxDistInt;
+
+	/** Likelihood of a point given the distance to its closest obstacle,
+	 * in discrete units */
+	double likelihood(const unsigned int occupiedMinDistInt) const
+	{
+		float occupiedMinDist = occupiedMinDistInt * constDist2DiscrUnits_INV;
+		if (useSquareDist) occupiedMinDist *= occupiedMinDist;
+		return zRandomTerm + zHit * exp(Q * occupiedMinDist);
+	}
+
+	std::vector<double> asVector(const float resolution) const
+	{
+		return {double(K),
+				zHit,
+				zRandomTerm,
+				Q,
+				useSquareDist ? 1.0 : 0.0,
+				double(maxDistInt),
+				resolution};
+	}
+};
+}  // namespace
+
 /*---------------------------------------------------------------
-					computeLikelihoodField_Thrun
+					updateLikelihoodFieldCache
  ---------------------------------------------------------------*/
-double COccupancyGridMap2D::computeLikelihoodField_Thrun(
-	const CPointsMap* pm, const CPose2D* relativePose)
+void COccupancyGridMap2D::updateLikelihoodFieldCache()
 {
 	MRPT_START
 
-	double ret;
-	size_t N = pm->size();
-	int K = (int)ceil(
-		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
-		resolution);  // The size of the checking area for matchings:
+	const LF_Thrun_Model lf(likelihoodOptions, resolution);
+	const int K = lf.K;
 
-	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
+	auto& area = precomputedLikelihoodModifiedArea;
 
-	if (!N)
+	// A change in the model parameters invalidates all the values:
+	const std::vector<double> params = lf.asVector(resolution);
+	const size_t nCells = size_t(size_x) * size_y;
+	if (params != precomputedLikelihoodParams ||
+		precomputedLikelihood.size() != nCells)
+	{
+		precomputedLikelihoodParams = params;
+		area.all = true;
+	}
+	if (area.empty()) return;
+	if (!nCells)
 	{
-		return -100;  // No way to estimate this likelihood!!
+		precomputedLikelihood.clear();
+		area.clear();
+		return;
 	}
 
-	// Compute the likelihoods for each point:
-	ret = 0;
+	// Cells whose likelihood may have changed: those within K cells of a
+	// modified cell.
+	const int sx = static_cast<int>(size_x), sy = static_cast<int>(size_y);
+	int x1 = 0, x2 = sx - 1, y1 = 0, y2 = sy - 1;
+	if (area.all)
+		precomputedLikelihood.resize(nCells);
+	else
+	{
+		x1 = max(x1, area.cx_min - K);
+		x2 = min(x2, area.cx_max + K);
+		y1 = max(y1, area.cy_min - K);
+		y2 = min(y2, area.cy_max + K);
+	}
+	area.clear();
+	if (x1 > x2 || y1 > y2) return;
 
-	float stdHit = likelihoodOptions.LF_stdHit;
-	float zHit = likelihoodOptions.LF_zHit;
-	float zRandom = likelihoodOptions.LF_zRandom;
-	float zRandomMaxRange = likelihoodOptions.LF_maxRange;
-	float zRandomTerm = zRandom / zRandomMaxRange;
-	float Q = -0.5f / square(stdHit);
-	int M = 0;
+	// Exact distances to the occupied cells. Distances beyond K cells all
+	// give the same likelihood, so they are saturated to K+1, which keeps the
+	// result exact.
+	std::vector<uint32_t> d2;
+	computeDistanceTransform(x1, x2, y1, y2, K + 1, p2l(0.5f), d2);
 
-	unsigned int size_x_1 = size_x - 1;
-	unsigned int size_y_1 = size_y - 1;
+	const int w = x2 - x1 + 1;
+	for (int y = y1; y <= y2; y++)
+	{
+		const uint32_t* rowD2 = &d2[(y - y1) * w];
+		double* lik = &precomputedLikelihood[y * size_x];
+		for (int x = x1; x <= x2; x++)
+			lik[x] = lf.likelihood(
+				static_cast<unsigned int>(std::min<int64_t>(
+					lf.maxDistInt, 100 * int64_t(rowD2[x - x1]))));
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					computeDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeDistanceTransform(
+	const int x1, const int x2, const int y1, const int y2, const int distSat,
+	const int obstacleBelow, std::vector<uint32_t>& out_d2) const
+{
+	MRPT_START
+
+	ASSERT_(x1 >= 0 && y1 >= 0 && x1 <= x2 && y1 <= y2);
+	ASSERT_BELOW_(x2, static_cast<int>(size_x));
+	ASSERT_BELOW_(y2, static_cast<int>(size_y));
+	ASSERT_(distSat > 0 && distSat < 0xFFFF);
 
-#define LIK_LF_CACHE_INVALID (66)
+	const int sx = static_cast<int>(size_x), sy = static_cast<int>(size_y);
 
-	// Aux. variables for the "for j" loop:
-	double thisLik = LIK_LF_CACHE_INVALID;
-	double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
-	double minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
-	double ccos, ssin;
-	float occupiedMinDist;
+	// Only obstacles within distSat cells may be closer than distSat:
+	const int ex1 = max(0, x1 - distSat), ex2 = min(sx - 1, x2 + distSat);
+	const int ey1 = max(0, y1 - distSat), ey2 = min(sy - 1, y2 + distSat);
+	const int w = ex2 - ex1 + 1, h = ey2 - ey1 + 1;
 
-	if (likelihoodOptions.enableLikelihoodCache)
+	// Exact Euclidean distance transform (Felzenszwalb & Huttenlocher).
+	// 1) Along columns: distance to the closest obstacle in the same column.
+	std::vector<uint16_t> colDist(w * h);
+	for (int y = 0; y < h; y++)  // downwards
 	{
-		// Reset the precomputed likelihood values map
-		if (precomputedLikelihoodToBeRecomputed)
+		uint16_t* row = &colDist[y * w];
+		const uint16_t* prevRow = y > 0 ? row - w : nullptr;
+		for (int x = 0; x < w; x++)
 		{
-			if (!map.empty())
-				precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
+			if (getRawCell_nocheck(ex1 + x, ey1 + y) < obstacleBelow)
+				row[x] = 0;
 			else
-				precomputedLikelihood.clear();
+				row[x] = prevRow ? std::min<int>(prevRow[x] + 1, distSat)
+								 : distSat;
+		}
+	}
+	for (int y = h - 2; y >= 0; y--)  // upwards
+	{
+		uint16_t* row = &colDist[y * w];
+		const uint16_t* nextRow = row + w;
+		for (int x = 0; x < w; x++)
+			if (nextRow[x] + 1 < row[x]) row[x] = nextRow[x] + 1;
+	}
 
-			precomputedLikelihoodToBeRecomputed = false;
+	// 2) Along rows: lower envelope of the parabolas (x-q)^2+colDist(q)^2.
+	const int64_t d2Sat = square(int64_t(distSat));
+	out_d2.resize(size_t(x2 - x1 + 1) * (y2 - y1 + 1));
+	std::vector<int64_t> f(w);
+	std::vector<int> v(w);
+	std::vector<double> z(w + 1);
+	for (int y = y1; y <= y2; y++)
+	{
+		const uint16_t* row = &colDist[(y - ey1) * w];
+		for (int q = 0; q < w; q++) f[q] = square(int64_t(row[q]));
+
+		// Intersection of the parabolas rooted at p and q:
+		auto intersection = [&f](const int p, const int q) {
+			return double((f[q] + int64_t(q) * q) - (f[p] + int64_t(p) * p)) /
+				   (2.0 * (q - p));
+		};
+		int k = 0;
+		v[0] = 0;
+		z[0] = -std::numeric_limits<double>::max();
+		z[1] = std::numeric_limits<double>::max();
+		for (int q = 1; q < w; q++)
+		{
+			double s = intersection(v[k], q);
+			while (s <= z[k]) s = intersection(v[--k], q);
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = std::numeric_limits<double>::max();
+		}
+
+		uint32_t* outRow = &out_d2[(y - y1) * (x2 - x1 + 1)];
+		for (int x = x1, j = 0; x <= x2; x++)
+		{
+			const int q = x - ex1;
+			while (z[j + 1] < q) j++;
+			outRow[x - x1] = static_cast<uint32_t>(std::min<int64_t>(
+				d2Sat, square(int64_t(q - v[j])) + f[v[j]]));
 		}
 	}
 
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					computeLikelihoodField_Thrun
+ ---------------------------------------------------------------*/
+double COccupancyGridMap2D::computeLikelihoodField_Thrun(
+	const CPointsMap* pm, const CPose2D* relativePose)
+{
+	MRPT_START
+
+	// (0,0,0) gives exactly the same global coordinates than not
+	// transforming the points at all:
+	const std::vector<TPose2D> poses(
+		1, relativePose ? relativePose->asTPose() : TPose2D(0, 0, 0));
+	std::vector<double> logLiks;
+	computeLikelihoodField_Thrun(pm, poses, logLiks);
+	return logLiks[0];
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+			computeLikelihoodField_Thrun (batch version)
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeLikelihoodField_Thrun(
+	const CPointsMap* pm, const std::vector<TPose2D>& relativePoses,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	ASSERT_(pm != nullptr);
+
+	const size_t nPoses = relativePoses.size();
+	size_t N = pm->size();
+
+	if (!N)
+	{
+		// No way to estimate this likelihood!!
+		out_log_liks.assign(nPoses, -100);
+		return;
+	}
+	out_log_liks.resize(nPoses);
+
+	const LF_Thrun_Model lf(likelihoodOptions, resolution);
+	const int K = lf.K;
+
+	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
+
+	unsigned int size_x_1 = size_x - 1;
+	unsigned int size_y_1 = size_y - 1;
+
+	const bool useCache = likelihoodOptions.enableLikelihoodCache;
+	if (useCache) updateLikelihoodFieldCache();
+
 	cellType thresholdCellValue = p2l(0.5f);
 	int decimation = likelihoodOptions.LF_decimation;
 
 	const double _resolution = this->resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
 
 	if (N < 10) decimation = 1;
 
-	TPoint2D pointLocal;
-	TPoint2D pointGlobal;
+	// Likelihood of a cell within the map limits, from the cache or computed
+	// now by searching for the closest occupied cell in a window of
+	// (2K+1)x(2K+1) cells:
+	auto cellLikelihood = [&](const int cx, const int cy) -> double {
+		if (useCache) return precomputedLikelihood[cx + cy * size_x];
 
-	for (size_t j = 0; j < N; j += decimation)
-	{
-		occupiedMinDist = maxCorrDist_sq;  // The max.distance
+		int xx1 = max(0, cx - K);
+		int xx2 = min(size_x_1, (unsigned)(cx + K));
+		int yy1 = max(0, cy - K);
+		int yy2 = min(size_y_1, (unsigned)(cy + K));
 
-		// Get the point and pass it to global coordinates:
-		if (relativePose)
-		{
-			pm->getPoint(j, pointLocal);
-// pointGlobal = *relativePose + pointLocal;
-#ifdef HAVE_SINCOS
-			::sincos(relativePose->phi(), &ssin, &ccos);
-#else
-			ccos = cos(relativePose->phi());
-			ssin = sin(relativePose->phi());
-#endif
-			pointGlobal.x =
-				relativePose->x() + pointLocal.x * ccos - pointLocal.y * ssin;
-			pointGlobal.y =
-				relativePose->y() + pointLocal.x * ssin + pointLocal.y * ccos;
-		}
-		else
-		{
-			pm->getPoint(j, pointGlobal);
-		}
+		// Optimized code: this part will be invoked a *lot* of times:
+		signed int Ax0 = 10 * (xx1 - cx);
+		signed int Ay = 10 * (yy1 - cy);
 
-		// Point to cell indixes
-		int cx = x2idx(pointGlobal.x);
-		int cy = y2idx(pointGlobal.y);
+		unsigned int occupiedMinDistInt = lf.maxDistInt;
 
-		// Precomputed table:
-		// Tip: Comparison cx<0 is implicit in (unsigned)(x)>size...
-		if (static_cast<unsigned>(cx) >= size_x_1 ||
-			static_cast<unsigned>(cy) >= size_y_1)
-		{
-			// We are outside of the map: Assign the likelihood for the max.
-			// correspondence distance:
-			thisLik = minimumLik;
-		}
-		else
+		for (int yy = yy1; yy <= yy2; yy++)
 		{
-			// We are into the map limits:
-			if (likelihoodOptions.enableLikelihoodCache)
-			{
-				thisLik = precomputedLikelihood[cx + cy * size_x];
-			}
+			unsigned int Ay2 = square((unsigned int)(Ay));  // Square is faster
+			// with unsigned.
+			signed short Ax = Ax0;
 
-			if (!likelihoodOptions.enableLikelihoodCache ||
-				thisLik == LIK_LF_CACHE_INVALID)
+			for (int xx = xx1; xx <= xx2; xx++)
 			{
-				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
+				if (getRawCell_nocheck(xx, yy) < thresholdCellValue)
 				{
-					cellType* mapPtr =
-						&map[xx1 + yy1 * size_x];  // Initial pointer position
-					unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));  // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
+					unsigned int d = square((unsigned int)(Ax)) + Ay2;
+					keep_min(occupiedMinDistInt, d);
 				}
+				Ax += 10;
+			}
+			Ay += 10;
+		}
 
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
-
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
+		return lf.likelihood(occupiedMinDistInt);
+	};
 
-				if (likelihoodOptions.enableLikelihoodCache)
-					// And save it into the table and into "thisLik":
-					precomputedLikelihood[cx + cy * size_x] = thisLik;
-			}
+	// Gather the (decimated) local points into contiguous buffers only once
+	// for all the poses:
+	const size_t nPts = (N + decimation - 1) / decimation;
+	std::vector<double> lxs(nPts), lys(nPts);
+	{
+		TPoint2D pointLocal;
+		for (size_t j = 0, k = 0; j < N; j += decimation, k++)
+		{
+			pm->getPoint(j, pointLocal);
+			lxs[k] = pointLocal.x;
+			lys[k] = pointLocal.y;
 		}
+	}
+	std::vector<int> cxs(nPts), cys(nPts);
 
-		// Update the likelihood:
-		if (Product_T_OrSum_F)
+	const double xMin = x_min, yMin = y_min;
+
+	for (size_t p = 0; p < nPoses; p++)
+	{
+		const TPose2D& relPose = relativePoses[p];
+		double ccos, ssin;
+#ifdef HAVE_SINCOS
+		::sincos(relPose.phi, &ssin, &ccos);
+#else
+		ccos = cos(relPose.phi);
+		ssin = sin(relPose.phi);
+#endif
+
+		// Pass all points to global coordinates and then to cell indices.
+		// The arithmetic is the same than in x2idx()/y2idx(), in double
+		// precision, so results are identical to the scalar code:
+		size_t k = 0;
+#if MRPT_HAS_SSE2
 		{
-			ret += log(thisLik);
+			const __m128d x0 = _mm_set1_pd(relPose.x);
+			const __m128d y0 = _mm_set1_pd(relPose.y);
+			const __m128d cos_2val = _mm_set1_pd(ccos);
+			const __m128d sin_2val = _mm_set1_pd(ssin);
+			const __m128d xmin_2val = _mm_set1_pd(xMin);
+			const __m128d ymin_2val = _mm_set1_pd(yMin);
+			const __m128d res_2val = _mm_set1_pd(_resolution);
+
+			for (; k + 2 <= nPts; k += 2)
+			{
+				const __m128d lx = _mm_loadu_pd(&lxs[k]);
+				const __m128d ly = _mm_loadu_pd(&lys[k]);
+				const __m128d gx = _mm_sub_pd(
+					_mm_add_pd(x0, _mm_mul_pd(lx, cos_2val)),
+					_mm_mul_pd(ly, sin_2val));
+				const __m128d gy = _mm_add_pd(
+					_mm_add_pd(y0, _mm_mul_pd(lx, sin_2val)),
+					_mm_mul_pd(ly, cos_2val));
+				// Truncation, like static_cast<int>():
+				_mm_storel_epi64(
+					reinterpret_cast<__m128i*>(&cxs[k]),
+					_mm_cvttpd_epi32(
+						_mm_div_pd(_mm_sub_pd(gx, xmin_2val), res_2val)));
+				_mm_storel_epi64(
+					reinterpret_cast<__m128i*>(&cys[k]),
+					_mm_cvttpd_epi32(
+						_mm_div_pd(_mm_sub_pd(gy, ymin_2val), res_2val)));
+			}
 		}
-		else
+#endif
+		for (; k < nPts; k++)
 		{
-			ret += thisLik;
-			M++;
+			const double gx = relPose.x + lxs[k] * ccos - lys[k] * ssin;
+			const double gy = relPose.y + lxs[k] * ssin + lys[k] * ccos;
+			cxs[k] = static_cast<int>((gx - xMin) / _resolution);
+			cys[k] = static_cast<int>((gy - yMin) / _resolution);
 		}
-	}  // end of for each point in the scan
 
-	if (!Product_T_OrSum_F) ret = log(ret / M);
+		// Likelihood of each point:
+		double ret = 0;
+		for (k = 0; k < nPts; k++)
+		{
+			const int cx = cxs[k], cy = cys[k];
+			// Tip: Comparison cx<0 is implicit in (unsigned)(x)>size...
+			const double thisLik = (static_cast<unsigned>(cx) >= size_x_1 ||
+									static_cast<unsigned>(cy) >= size_y_1)
+									   // Outside of the map: Assign the
+									   // likelihood for the max. corr. dist.
+									   ? lf.minimumLik
+									   : cellLikelihood(cx, cy);
+
+			// Update the likelihood:
+			if (Product_T_OrSum_F)
+				ret += log(thisLik);
+			else
+				ret += thisLik;
+		}
+		if (!Product_T_OrSum_F) ret = log(ret / nPts);
 
-	return ret;
+		out_log_liks[p] = ret;
+	}
 
 	MRPT_END
 }
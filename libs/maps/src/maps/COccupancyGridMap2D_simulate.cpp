@@ -16,12 +16,15 @@
 #include <mrpt/math/transform_gaussian.h>
 
 #include <mrpt/random.h>
+#include <cmath>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::maps;
 using namespace mrpt::obs;
 using namespace mrpt::random;
 using namespace mrpt::poses;
+using namespace mrpt::math;
 using namespace std;
 
 double COccupancyGridMap2D::RAYTRACE_STEP_SIZE_IN_CELL_UNITS = 0.8;
@@ -118,6 +121,21 @@ void COccupancyGridMap2D::simulateScanRay(
 			 ? getRandomGenerator().drawGaussian1D_normalized() * angleNoiseStd
 			 : .0);
 
+	internal_simulateScanRay(
+		start_x, start_y, A_, out_range, out_valid, max_range_meters,
+		threshold_free, false /*useClearanceMap*/);
+
+	// Add additive Gaussian noise:
+	if (noiseStd > 0 && out_valid)
+		out_range +=
+			noiseStd * getRandomGenerator().drawGaussian1D_normalized();
+}
+
+void COccupancyGridMap2D::internal_simulateScanRay(
+	const double start_x, const double start_y, const double A_,
+	float& out_range, bool& out_valid, const double max_range_meters,
+	const float threshold_free, const bool useClearanceMap) const
+{
 // Unit vector in the directorion of the ray:
 #ifdef HAVE_SINCOS
 	double Arx, Ary;
@@ -150,14 +168,38 @@ void COccupancyGridMap2D::simulateScanRay(
 	const cellType threshold_free_int = p2l(threshold_free);
 	int x, y = int_y2idx(ryi);
 
+	// Sphere tracing: the sample points j steps ahead are, at most,
+	// j*stepLen+sqrt(2) cells away from the center of the current cell
+	// (center-to-center). While that is below the clearance of the current
+	// cell and they stay within the grid, they all are free cells and can be
+	// skipped, giving exactly the same result than visiting them.
+	const double stepLen =
+		std::sqrt(double(Arxi * Arxi + Aryi * Aryi)) / (1L << INTPRECNUMBIT);
+	const bool skipFreeSpace = useClearanceMap && stepLen > 0;
+	const double invStepLen = skipFreeSpace ? 1.0 / stepLen : .0;
+
 	while ((x = int_x2idx(rxi)) >= 0 && (y = int_y2idx(ryi)) >= 0 &&
 		   x < static_cast<int>(size_x) && y < static_cast<int>(size_y) &&
-		   (hitCellOcc_int = map[x + y * size_x]) > threshold_free_int &&
+		   (hitCellOcc_int = getRawCell_nocheck(x, y)) > threshold_free_int &&
 		   ray_len < max_ray_len)
 	{
-		rxi += Arxi;
-		ryi += Aryi;
-		ray_len++;
+		unsigned int nSteps = 1;
+		if (skipFreeSpace)
+		{
+			// Free distance around the current cell, within the grid:
+			const int border = std::min(
+				std::min(x, static_cast<int>(size_x) - 1 - x),
+				std::min(y, static_cast<int>(size_y) - 1 - y));
+			const double freeDist = std::min(
+				m_clearanceMap[x + y * size_x] - 1.5, border - 1.0);
+			if (freeDist >= stepLen)
+				nSteps = std::min<unsigned int>(
+					static_cast<unsigned int>(freeDist * invStepLen) + 1,
+					max_ray_len - ray_len);
+		}
+		rxi += nSteps * Arxi;
+		ryi += nSteps * Aryi;
+		ray_len += nSteps;
 	}
 
 	// Store:
@@ -173,13 +215,144 @@ void COccupancyGridMap2D::simulateScanRay(
 	{  // No: The normal case:
 		out_range = RAYTRACE_STEP_SIZE_IN_CELL_UNITS * ray_len * resolution;
 		out_valid = (ray_len < max_ray_len);  // out_range<max_range_meters;
-		// Add additive Gaussian noise:
-		if (noiseStd > 0 && out_valid)
-			out_range +=
-				noiseStd * getRandomGenerator().drawGaussian1D_normalized();
 	}
 }
 
+void COccupancyGridMap2D::updateClearanceMap(const int threshold_free_int)
+{
+	MRPT_START
+
+	auto& area = m_clearanceMapModifiedArea;
+
+	const size_t nCells = size_t(size_x) * size_y;
+	if (threshold_free_int != m_clearanceMapThreshold ||
+		m_clearanceMap.size() != nCells)
+	{
+		m_clearanceMapThreshold = threshold_free_int;
+		area.all = true;
+	}
+	if (area.empty()) return;
+	if (!nCells)
+	{
+		m_clearanceMap.clear();
+		area.clear();
+		return;
+	}
+
+	// Cells whose clearance may have changed: those within the saturation
+	// distance of a modified cell.
+	const int D = CLEARANCE_MAP_SATURATION;
+	int x1 = 0, x2 = static_cast<int>(size_x) - 1;
+	int y1 = 0, y2 = static_cast<int>(size_y) - 1;
+	if (area.all)
+		m_clearanceMap.resize(nCells);
+	else
+	{
+		x1 = std::max(x1, area.cx_min - D);
+		x2 = std::min(x2, area.cx_max + D);
+		y1 = std::max(y1, area.cy_min - D);
+		y2 = std::min(y2, area.cy_max + D);
+	}
+	area.clear();
+	if (x1 > x2 || y1 > y2) return;
+
+	// Rays stop at cells with values up to threshold_free_int:
+	std::vector<uint32_t> d2;
+	computeDistanceTransform(x1, x2, y1, y2, D, threshold_free_int + 1, d2);
+
+	const int w = x2 - x1 + 1;
+	for (int y = y1; y <= y2; y++)
+	{
+		const uint32_t* rowD2 = &d2[(y - y1) * w];
+		uint8_t* row = &m_clearanceMap[y * size_x];
+		for (int x = x1; x <= x2; x++)
+		{
+			// Round down, so the clearance is never overestimated:
+			int d = static_cast<int>(std::sqrt(double(rowD2[x - x1])));
+			if (d * d > int(rowD2[x - x1])) d--;
+			row[x] = static_cast<uint8_t>(d);
+		}
+	}
+
+	MRPT_END
+}
+
+COccupancyGridMap2D::TLaserSimulBatchParams::TLaserSimulBatchParams()
+	: threshold(.6f),
+	  nRays(361),
+	  decimation(1),
+	  numThreads(1),
+	  useClearanceMap(true)
+{
+}
+
+// See docs in header
+void COccupancyGridMap2D::laserScanSimulatorBatch(
+	const CObservation2DRangeScan& scanParams,
+	const std::vector<TPose2D>& robotPoses, std::vector<float>& out_ranges,
+	std::vector<char>& out_valid, const TLaserSimulBatchParams& params)
+{
+	MRPT_START
+
+	ASSERT_(params.decimation >= 1);
+	ASSERT_(params.nRays >= 2);
+
+	const size_t N = params.nRays, nPoses = robotPoses.size();
+	out_ranges.assign(nPoses * N, .0f);
+	out_valid.assign(nPoses * N, 0);
+	if (!nPoses) return;
+
+	const float free_thres = 1.0f - params.threshold;
+	if (params.useClearanceMap) updateClearanceMap(p2l(free_thres));
+
+	const double AA =
+		(scanParams.rightToLeft ? 1.0 : -1.0) * (scanParams.aperture / (N - 1));
+
+	// Same computations than laserScanSimulator(), for poses [first,last):
+	auto simulatePoses = [&](const size_t first, const size_t last) {
+		for (size_t i = first; i < last; i++)
+		{
+			// Sensor pose in global coordinates
+			const CPose3D sensorPose3D =
+				CPose3D(CPose2D(robotPoses[i])) + scanParams.sensorPose;
+			// Aproximation: grid is 2D !!!
+			const CPose2D sensorPose(sensorPose3D);
+
+			double A = sensorPose.phi() +
+					   (scanParams.rightToLeft ? -0.5 : +0.5) *
+						   scanParams.aperture;
+			float* ranges = &out_ranges[i * N];
+			char* valids = &out_valid[i * N];
+			for (size_t k = 0; k < N;
+				 k += params.decimation, A += AA * params.decimation)
+			{
+				bool valid;
+				internal_simulateScanRay(
+					sensorPose.x(), sensorPose.y(), A, ranges[k], valid,
+					scanParams.maxRange, free_thres, params.useClearanceMap);
+				valids[k] = valid ? 1 : 0;
+			}
+		}
+	};
+
+	unsigned int nThreads = params.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1 || nPoses < 2)
+	{
+		simulatePoses(0, nPoses);
+		return;
+	}
+
+	if (!m_simulationThreadPool || m_simulationThreadPool->size() != nThreads)
+		m_simulationThreadPool =
+			std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+	// Several blocks per thread, since rays are much longer from some poses:
+	const size_t blockSize = std::max<size_t>(1, nPoses / (4 * nThreads));
+	m_simulationThreadPool->parallelForBlocks(nPoses, blockSize, simulatePoses);
+
+	MRPT_END
+}
+
 COccupancyGridMap2D::TLaserSimulUncertaintyParams::
 	TLaserSimulUncertaintyParams()
 	: method(sumUnscented),
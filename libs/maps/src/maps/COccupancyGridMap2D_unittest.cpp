@@ -7,9 +7,15 @@
    | Released under BSD License. See details in http://www.mrpt.org/License |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/io/CMemoryStream.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/serialization/CArchive.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
 
 using namespace mrpt;
 using namespace mrpt::maps;
@@ -104,3 +110,456 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 		// should have a high "freeness"
 	}
 }
+
+// Straightforward implementation of the likelihood field model, as a
+// reference for the optimized versions:
+static double referenceLikelihoodField(
+	const COccupancyGridMap2D& grid, const CPointsMap& pm, const TPose2D& pose)
+{
+	const auto& opts = grid.likelihoodOptions;
+	const double res = grid.getResolution();
+	const int K = static_cast<int>(ceil(opts.LF_maxCorrsDistance / res));
+	const int size_x = static_cast<int>(grid.getSizeX());
+	const int size_y = static_cast<int>(grid.getSizeY());
+	const double Q = -0.5 / square(opts.LF_stdHit);
+	const double zRandomTerm = opts.LF_zRandom / opts.LF_maxRange;
+	const double maxCorrDist_sq = square(opts.LF_maxCorrsDistance);
+	const size_t decimation = pm.size() < 10 ? 1 : opts.LF_decimation;
+
+	double sum = 0;
+	size_t M = 0;
+	for (size_t j = 0; j < pm.size(); j += decimation)
+	{
+		TPoint2D pl;
+		pm.getPoint(j, pl);
+		const double gx =
+			pose.x + pl.x * cos(pose.phi) - pl.y * sin(pose.phi);
+		const double gy =
+			pose.y + pl.x * sin(pose.phi) + pl.y * cos(pose.phi);
+		const int cx = grid.x2idx(gx), cy = grid.y2idx(gy);
+
+		double minDist_sq = maxCorrDist_sq;
+		if (cx >= 0 && cy >= 0 && cx < size_x - 1 && cy < size_y - 1)
+		{
+			for (int yy = std::max(0, cy - K);
+				 yy <= std::min(size_y - 1, cy + K); yy++)
+				for (int xx = std::max(0, cx - K);
+					 xx <= std::min(size_x - 1, cx + K); xx++)
+					if (grid.getRow(yy)[xx] < COccupancyGridMap2D::p2l(0.5f))
+						minDist_sq = std::min(
+							minDist_sq,
+							(square(xx - cx) + square(yy - cy)) * res * res);
+			if (opts.LF_useSquareDist) minDist_sq *= minDist_sq;
+		}
+		const double lik = zRandomTerm + opts.LF_zHit * exp(Q * minDist_sq);
+		sum += opts.LF_alternateAverageMethod ? lik : log(lik);
+		M++;
+	}
+	return opts.LF_alternateAverageMethod ? log(sum / M) : sum;
+}
+
+TEST(COccupancyGridMap2DTests, likelihoodFieldBatchMatchesScalar)
+{
+	// A square room, 8x8 m:
+	COccupancyGridMap2D grid(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+	for (float t = -4.0f; t <= 4.0f; t += 0.025f)
+	{
+		grid.setPos(t, -4.0f, 0.0f);
+		grid.setPos(t, 4.0f, 0.0f);
+		grid.setPos(-4.0f, t, 0.0f);
+		grid.setPos(4.0f, t, 0.0f);
+	}
+
+	// Wall points seen from (0,0,0), some of them out of the map:
+	CSimplePointsMap pts;
+	for (int i = 0; i < 101; i++)
+	{
+		const double a = -M_PI + 2 * M_PI * i / 101.0;
+		const double r = (i % 10 == 0)
+							 ? 7.0
+							 : 4.0 / std::max(fabs(cos(a)), fabs(sin(a)));
+		pts.insertPoint(r * cos(a), r * sin(a), 0);
+	}
+
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 37; i++)
+		poses.emplace_back(0.1 * (i % 5), -0.07 * (i % 3), 0.05 * i - 0.9);
+
+	for (int avrg = 0; avrg < 2; avrg++)
+	{
+		grid.likelihoodOptions.LF_alternateAverageMethod = (avrg != 0);
+
+		std::vector<double> logliks;
+		grid.computeLikelihoodField_Thrun(&pts, poses, logliks);
+		ASSERT_EQ(logliks.size(), poses.size());
+
+		for (size_t i = 0; i < poses.size(); i++)
+		{
+			const CPose2D p(poses[i]);
+			EXPECT_EQ(logliks[i], grid.computeLikelihoodField_Thrun(&pts, &p))
+				<< "pose: " << poses[i];
+			EXPECT_NEAR(
+				logliks[i], referenceLikelihoodField(grid, pts, poses[i]), 1e-6)
+				<< "pose: " << poses[i];
+		}
+		// The true pose must be the most likely one:
+		EXPECT_GT(
+			grid.computeLikelihoodField_Thrun(&pts),
+			*std::max_element(logliks.begin(), logliks.end()));
+	}
+}
+
+TEST(COccupancyGridMap2DTests, likelihoodFieldCacheIncrementalUpdates)
+{
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	for (float t = -4.0f; t <= 4.0f; t += 0.025f)
+	{
+		grid.setPos(t, -4.0f, 0.0f);
+		grid.setPos(t, 4.0f, 0.0f);
+		grid.setPos(-4.0f, t, 0.0f);
+		grid.setPos(4.0f, t, 0.0f);
+	}
+
+	CSimplePointsMap pts;
+	for (int i = 0; i < 90; i++)
+	{
+		const double a = 2 * M_PI * i / 90.0;
+		pts.insertPoint(3.9 * cos(a), 3.9 * sin(a), 0);
+	}
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 50; i++)
+		poses.emplace_back(-6.0 + 0.25 * i, 0.05 * (i % 7), 0.03 * i);
+
+	// Reference: no cache at all.
+	COccupancyGridMap2D gridNoCache = grid;
+	gridNoCache.likelihoodOptions.enableLikelihoodCache = false;
+	grid.likelihoodOptions.enableLikelihoodCache = true;
+
+	auto checkEqual = [&]() {
+		std::vector<double> l1, l2;
+		grid.computeLikelihoodField_Thrun(&pts, poses, l1);
+		gridNoCache.computeLikelihoodField_Thrun(&pts, poses, l2);
+		ASSERT_EQ(l1.size(), l2.size());
+		for (size_t i = 0; i < l1.size(); i++)
+			EXPECT_EQ(l1[i], l2[i]) << "pose: " << poses[i];
+	};
+
+	// Cache fully built:
+	checkEqual();
+
+	// Local changes, near and far from existing walls:
+	for (auto* g : {&grid, &gridNoCache})
+	{
+		g->setPos(2.0f, 2.0f, 0.0f);
+		g->setPos(-3.95f, 0.0f, 1.0f);
+		for (int i = 0; i < 20; i++) g->updateCell(240, 200, 0.1f);
+	}
+	checkEqual();
+
+	// A laser scan:
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.rightToLeft = true;
+	scan.resizeScanAndAssign(181, 3.0f, true);
+	const CPose3D robotPose(1.0, -0.5, 0, 0.2, 0, 0);
+	for (auto* g : {&grid, &gridNoCache})
+		g->insertObservation(&scan, &robotPose);
+	checkEqual();
+
+	// Model parameters changed:
+	grid.likelihoodOptions.LF_stdHit = 0.5f;
+	gridNoCache.likelihoodOptions.LF_stdHit = 0.5f;
+	checkEqual();
+}
+
+TEST(COccupancyGridMap2DTests, voronoiIncrementalUpdates)
+{
+	// Rooms of 3x3 m with doors:
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.10f);
+	for (float a = -18.0f; a <= 18.0f; a += 3.0f)
+		for (float t = -18.0f; t <= 18.0f; t += 0.05f)
+		{
+			if (std::abs(std::fmod(t + 18.0f, 3.0f) - 1.5f) < 0.4f) continue;
+			grid.setPos(a, t, 0.0f);
+			grid.setPos(t, a, 0.0f);
+		}
+
+	const float threshold = 0.5f, robot_size = 0.2f;
+	EXPECT_ANY_THROW(grid.updateVoronoiDiagram());
+	grid.buildVoronoiDiagram(threshold, robot_size);
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> cellIdx(
+		0, static_cast<int>(grid.getSizeX()) - 1);
+	std::uniform_real_distribution<float> occupancy(0.0f, 1.0f);
+	for (int step = 0; step < 8; step++)
+	{
+		// Random changes around a random cell, some of them close to the
+		// borders of the grid:
+		const int cx = cellIdx(rng), cy = cellIdx(rng);
+		for (int i = 0; i < 30; i++)
+		{
+			const int x = cx + static_cast<int>(rng() % 21) - 10;
+			const int y = cy + static_cast<int>(rng() % 21) - 10;
+			if (x >= 0 && y >= 0 && x < static_cast<int>(grid.getSizeX()) &&
+				y < static_cast<int>(grid.getSizeY()))
+				grid.setCell(x, y, occupancy(rng));
+		}
+		grid.updateVoronoiDiagram();
+
+		COccupancyGridMap2D full = grid;
+		full.buildVoronoiDiagram(threshold, robot_size);
+
+		const auto& inc_diag = grid.getVoronoiDiagram();
+		const auto& full_diag = full.getVoronoiDiagram();
+		ASSERT_EQ(inc_diag.getSizeX(), full_diag.getSizeX());
+		ASSERT_EQ(inc_diag.getSizeY(), full_diag.getSizeY());
+		size_t nDiagramCells = 0;
+		for (unsigned y = 0; y < full_diag.getSizeY(); y++)
+			for (unsigned x = 0; x < full_diag.getSizeX(); x++)
+			{
+				const uint16_t v = *full_diag.cellByIndex(x, y);
+				if (v) nDiagramCells++;
+				ASSERT_EQ(*inc_diag.cellByIndex(x, y), v)
+					<< "step: " << step << " cell: " << x << "," << y;
+			}
+		EXPECT_GT(nDiagramCells, 1000u);
+	}
+}
+
+TEST(COccupancyGridMap2DTests, insertScanParallelIsBitIdentical)
+{
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.rightToLeft = true;
+	scan.resizeScan(361);
+	for (size_t i = 0; i < scan.scan.size(); i++)
+	{
+		scan.setScanRange(i, 1.0f + 0.02f * (i % 250));
+		scan.setScanRangeValidity(i, (i % 37) != 0);
+	}
+
+	for (const bool widening : {false, true})
+	{
+		for (const bool invalidAsFree : {false, true})
+		{
+			COccupancyGridMap2D gridSerial(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+			gridSerial.insertionOptions.wideningBeamsWithDistance = widening;
+			gridSerial.insertionOptions.considerInvalidRangesAsFreeSpace =
+				invalidAsFree;
+			COccupancyGridMap2D gridParallel = gridSerial;
+			gridParallel.insertionOptions.numThreads = 4;
+
+			for (int k = 0; k < 8; k++)
+			{
+				const CPose3D robotPose(
+					0.4 * k - 1.5, 0.2 * k, 0, 0.7 * k, 0, 0);
+				gridSerial.insertObservation(&scan, &robotPose);
+				gridParallel.insertObservation(&scan, &robotPose);
+			}
+
+			ASSERT_EQ(gridSerial.getSizeX(), gridParallel.getSizeX());
+			ASSERT_EQ(gridSerial.getSizeY(), gridParallel.getSizeY());
+			EXPECT_TRUE(gridSerial.getRawMap() == gridParallel.getRawMap())
+				<< "widening: " << widening
+				<< " invalidAsFree: " << invalidAsFree;
+		}
+	}
+}
+
+TEST(COccupancyGridMap2DTests, laserScanSimulatorBatchMatchesScalar)
+{
+	// A large room with a few obstacles, so rays cross large free areas:
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	for (float t = -15.0f; t <= 15.0f; t += 0.025f)
+	{
+		grid.setPos(t, -15.0f, 0.0f);
+		grid.setPos(t, 15.0f, 0.0f);
+		grid.setPos(-15.0f, t, 0.0f);
+		grid.setPos(15.0f, t, 0.0f);
+		if (t > -5.0f && t < 3.0f) grid.setPos(t, 0.3f * t + 4.0f, 0.0f);
+	}
+
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.rightToLeft = true;
+	scan.maxRange = 30.0f;
+	scan.sensorPose = CPose3D(0.2, 0.1, 0.3, 0.1, 0, 0);
+
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 23; i++)
+		poses.emplace_back(1.3 * i - 17.0, 0.6 * i - 6.0, 0.37 * i);
+
+	auto checkEqual = [&](const unsigned int decimation) {
+		const COccupancyGridMap2D& cgrid = grid;
+		for (const bool useClearanceMap : {false, true})
+		{
+			COccupancyGridMap2D::TLaserSimulBatchParams params;
+			params.nRays = 181;
+			params.decimation = decimation;
+			params.useClearanceMap = useClearanceMap;
+			params.numThreads = useClearanceMap ? 4 : 1;
+			std::vector<float> ranges;
+			std::vector<char> valids;
+			grid.laserScanSimulatorBatch(scan, poses, ranges, valids, params);
+			ASSERT_EQ(ranges.size(), poses.size() * params.nRays);
+			ASSERT_EQ(valids.size(), ranges.size());
+
+			for (size_t i = 0; i < poses.size(); i++)
+			{
+				CObservation2DRangeScan sim = scan;
+				cgrid.laserScanSimulator(
+					sim, CPose2D(poses[i]), params.threshold, params.nRays, 0,
+					decimation);
+				for (size_t k = 0; k < params.nRays; k += decimation)
+				{
+					const size_t idx = i * params.nRays + k;
+					EXPECT_EQ(ranges[idx], sim.scan[k])
+						<< "pose: " << poses[i] << " ray: " << k;
+					EXPECT_EQ(valids[idx] != 0, sim.validRange[k] != 0)
+						<< "pose: " << poses[i] << " ray: " << k;
+				}
+			}
+		}
+	};
+
+	checkEqual(1);
+	checkEqual(3);
+
+	// Local changes must be seen by the cached clearance map:
+	grid.setPos(0.0f, -10.0f, 0.0f);
+	for (float t = -2.0f; t <= 2.0f; t += 0.025f) grid.setPos(8.0f, t, 0.0f);
+	CObservation2DRangeScan obs = scan;
+	obs.resizeScanAndAssign(181, 12.0f, true);
+	const CPose3D robotPose(-3.0, -8.0, 0, 0.4, 0, 0);
+	grid.insertObservation(&obs, &robotPose);
+	checkEqual(1);
+
+	// Ray tracing likelihood, all poses at once:
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmRayTracing;
+	std::vector<double> logliks;
+	grid.computeObservationLikelihoodForPoses(&obs, poses, logliks);
+	ASSERT_EQ(logliks.size(), poses.size());
+	for (size_t i = 0; i < poses.size(); i++)
+		EXPECT_EQ(
+			logliks[i], grid.computeObservationLikelihood(
+							&obs, CPose3D(CPose2D(poses[i]))))
+			<< "pose: " << poses[i];
+}
+
+TEST(COccupancyGridMap2DTests, tiledStorageMatchesDense)
+{
+	// Scans looking towards +X,+Y, so the grid grows to the right and top:
+	CObservation2DRangeScan scan;
+	scan.aperture = 0.5 * M_PIf;
+	scan.rightToLeft = true;
+	scan.resizeScan(181);
+	for (size_t i = 0; i < scan.scan.size(); i++)
+		scan.setScanRange(i, 2.0f + 0.03f * (i % 150));
+
+	COccupancyGridMap2D dense(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+	COccupancyGridMap2D tiled = dense;
+	tiled.setTiledStorage(true);
+	tiled.insertionOptions.numThreads = 3;
+
+	for (int k = 0; k < 10; k++)
+	{
+		const CPose3D robotPose(
+			-4.0 + 2.0 * k, -4.0 + 1.5 * k, 0, M_PI / 4, 0, 0);
+		dense.insertObservation(&scan, &robotPose);
+		tiled.insertObservation(&scan, &robotPose);
+	}
+	// And towards -X,-Y, growing to the left and bottom:
+	for (int k = 0; k < 5; k++)
+	{
+		const CPose3D robotPose(
+			-4.0 - 1.7 * k, -4.0 - 2.3 * k, 0, -3 * M_PI / 4, 0, 0);
+		dense.insertObservation(&scan, &robotPose);
+		tiled.insertObservation(&scan, &robotPose);
+	}
+
+	ASSERT_EQ(dense.getSizeX(), tiled.getSizeX());
+	ASSERT_EQ(dense.getSizeY(), tiled.getSizeY());
+	for (unsigned int cy = 0; cy < dense.getSizeY(); cy++)
+		for (unsigned int cx = 0; cx < dense.getSizeX(); cx++)
+			ASSERT_EQ(dense.getCell(cx, cy), tiled.getCell(cx, cy))
+				<< "cx=" << cx << " cy=" << cy;
+	EXPECT_LT(tiled.getStoredCellsCount(), dense.getStoredCellsCount());
+
+	// The serialization format does not depend on the storage:
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << tiled;
+	buf.Seek(0);
+	COccupancyGridMap2D fromTiled;
+	arch >> fromTiled;
+	EXPECT_FALSE(fromTiled.isTiledStorage());
+	EXPECT_TRUE(fromTiled.getRawMap() == dense.getRawMap());
+
+	buf.Seek(0);
+	fromTiled.setTiledStorage(true);
+	arch >> fromTiled;
+	EXPECT_LE(fromTiled.getStoredCellsCount(), tiled.getStoredCellsCount());
+	fromTiled.setTiledStorage(false);
+	EXPECT_TRUE(fromTiled.getRawMap() == dense.getRawMap());
+}
+
+TEST(COccupancyGridMap2DTests, tiledStorageGrowsWithoutLosingCells)
+{
+	COccupancyGridMap2D grid(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f);
+	grid.setTiledStorage(true);
+	const std::vector<TPoint2D> pts = {
+		{-4.95, -4.95}, {4.95, -4.95}, {4.95, 4.95}, {-4.95, 4.95}};
+	for (const auto& p : pts) grid.setPos(p.x, p.y, 0.1f);
+	EXPECT_EQ(grid.getStoredCellsCount(), 4u * 64 * 64);
+
+	// Grow in all directions, to exactly the requested limits:
+	grid.resizeGrid(-30.0f, 30.0f, -20.0f, 40.0f, 0.5f, false);
+	EXPECT_NEAR(grid.getXMin(), -30.0f, 1e-4);
+	EXPECT_NEAR(grid.getYMin(), -20.0f, 1e-4);
+	EXPECT_NEAR(grid.getXMax(), 30.0f, 1e-4);
+	EXPECT_NEAR(grid.getYMax(), 40.0f, 1e-4);
+	EXPECT_EQ(grid.getStoredCellsCount(), 4u * 64 * 64);
+	for (const auto& p : pts) EXPECT_NEAR(grid.getPos(p.x, p.y), 0.1f, 0.01f);
+	EXPECT_NEAR(grid.getPos(-29.0f, -19.0f), 0.5f, 0.01f);
+	EXPECT_NEAR(grid.getPos(29.0f, 39.0f), 0.5f, 0.01f);
+
+	// New cells with a different default value, which only allocates tiles
+	// with cells of both the old and new areas:
+	grid.resizeGrid(-40.0f, 30.0f, -20.0f, 40.0f, 0.2f, false);
+	EXPECT_NEAR(grid.getPos(-39.0f, 0.0f), 0.2f, 0.01f);
+	EXPECT_NEAR(grid.getPos(-30.05f, 0.0f), 0.2f, 0.01f);
+	EXPECT_NEAR(grid.getPos(-29.95f, 0.0f), 0.5f, 0.01f);
+	EXPECT_NEAR(grid.getPos(-29.0f, -19.0f), 0.5f, 0.01f);
+	for (const auto& p : pts) EXPECT_NEAR(grid.getPos(p.x, p.y), 0.1f, 0.01f);
+	// The 4 tiles from before, plus a column of tiles along the old left
+	// border:
+	EXPECT_LE(
+		grid.getStoredCellsCount(), (4u + grid.getSizeY() / 64 + 2) * 64 * 64);
+
+	// Same contents than a dense grid resized the same way:
+	COccupancyGridMap2D dense(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f);
+	for (const auto& p : pts) dense.setPos(p.x, p.y, 0.1f);
+	dense.resizeGrid(-30.0f, 30.0f, -20.0f, 40.0f, 0.5f, false);
+	dense.resizeGrid(-40.0f, 30.0f, -20.0f, 40.0f, 0.2f, false);
+	ASSERT_EQ(dense.getSizeX(), grid.getSizeX());
+	ASSERT_EQ(dense.getSizeY(), grid.getSizeY());
+	for (unsigned int cy = 0; cy < dense.getSizeY(); cy++)
+		for (unsigned int cx = 0; cx < dense.getSizeX(); cx++)
+			ASSERT_EQ(dense.getCell(cx, cy), grid.getCell(cx, cy))
+				<< "cx=" << cx << " cy=" << cy;
+
+	// Grids with different origins resized to the same limits have the same
+	// size, as done for the particles of a RBPF:
+	COccupancyGridMap2D other(-3.3f, 7.1f, -6.2f, 2.9f, 0.1f);
+	other.setTiledStorage(true);
+	other.setPos(0, 0, 0.1f);
+	other.resizeGrid(-40.0f, 30.0f, -20.0f, 40.0f, 0.5f, false);
+	EXPECT_EQ(other.getSizeX(), grid.getSizeX());
+	EXPECT_EQ(other.getSizeY(), grid.getSizeY());
+	EXPECT_NEAR(other.getPos(0, 0), 0.1f, 0.01f);
+
+	grid.fill(0.5f);
+	EXPECT_EQ(grid.getStoredCellsCount(), 0u);
+}
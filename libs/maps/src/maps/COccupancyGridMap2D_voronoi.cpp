@@ -39,8 +39,6 @@ void COccupancyGridMap2D::buildVoronoiDiagram(
 		y2 = min(y2, static_cast<int>(size_y) - 1);
 	}
 
-	int robot_size_units = round(100 * robot_size / resolution);
-
 	/* We store 0 in cells NOT belonging to Voronoi, or the closest distance
  * to obstacle otherwise, the "clearance" in "int" distance units.
  */
@@ -49,46 +47,105 @@ void COccupancyGridMap2D::buildVoronoiDiagram(
 	ASSERT_EQUAL_(m_voronoi_diagram.getSizeX(), size_x);
 	ASSERT_EQUAL_(m_voronoi_diagram.getSizeY(), size_y);
 	m_voronoi_diagram.fill(0);
+	m_voronoi_clearance.setSize(x_min, x_max, y_min, y_max, resolution);
+	m_voronoi_clearance.fill(0);
 
 	// freeness threshold
 	voroni_free_threshold = 1.0f - threshold;
+	m_voronoi_threshold = threshold;
+	m_voronoi_robot_size = robot_size;
+	m_voronoi_built = true;
+
+	internal_buildVoronoiDiagram(x1, x2, y1, y2);
+
+	// Only a diagram of the whole grid can be updated incrementally:
+	if (x1 == 0 && y1 == 0 && x2 == static_cast<int>(size_x) - 1 &&
+		y2 == static_cast<int>(size_y) - 1)
+		m_voronoiModifiedArea.clear();
+	else
+		m_voronoiModifiedArea.all = true;
+}
+
+/*---------------------------------------------------------------
+				internal_buildVoronoiDiagram
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::internal_buildVoronoiDiagram(
+	int x1, int x2, int y1, int y2)
+{
+	internal_computeVoronoiClearance(x1, x2, y1, y2);
+
+	// Limpiar: Hacer que los trazos sean de grosor 1:
+	//  Si un punto del diagrama esta rodeada de mas de 2
+	//   puntos tb del diagrama, eliminarlo:
+	for (int x = x1; x <= x2; x++) internal_thinVoronoiColumn(x, y1, y2);
+}
+
+void COccupancyGridMap2D::internal_computeVoronoiClearance(
+	int x1, int x2, int y1, int y2)
+{
+	int robot_size_units = round(100 * m_voronoi_robot_size / resolution);
 
 	int basis_x[2], basis_y[2];
 	int nBasis;
 
-	// Build Voronoi:
 	for (int x = x1; x <= x2; x++)
 	{
+		// Start the search of each cell from the free circle of the previous
+		// one, if it was free:
+		int last_free_y = y1 - 2, last_free_circle = 0;
 		for (int y = y1; y <= y2; y++)
 		{
-			const int Clearance =
-				computeClearance(x, y, basis_x, basis_y, &nBasis);
-
-			if (Clearance > robot_size_units)
-				setVoroniClearance(x, y, Clearance);
+			int free_circle = (last_free_y == y - 1)
+								  ? max(1, last_free_circle - 3)
+								  : 1;
+			int Clearance = internal_computeClearance(
+				x, y, basis_x, basis_y, &nBasis, false, free_circle);
+			if (free_circle)
+			{
+				last_free_y = y;
+				last_free_circle = free_circle;
+			}
+			if (Clearance <= robot_size_units) Clearance = 0;
+			*m_voronoi_clearance.cellByIndex(x, y) = Clearance;
 		}
 	}
+}
 
-	// Limpiar: Hacer que los trazos sean de grosor 1:
-	//  Si un punto del diagrama esta rodeada de mas de 2
-	//   puntos tb del diagrama, eliminarlo:
-	int nDiag;
-	for (int x = x1; x <= x2; x++)
+bool COccupancyGridMap2D::internal_thinVoronoiColumn(int x, int y1, int y2)
+{
+	// Cells before (x,y) in the order of the loops are already thinned, the
+	// rest are taken from the clearance before thinning:
+	auto value = [&](int xx, int yy, int y) -> uint16_t {
+		if (xx < 0 || yy < 0 || xx >= static_cast<int>(size_x) ||
+			yy >= static_cast<int>(size_y))
+			return 0;
+		if (xx < x || (xx == x && yy < y))
+			return *m_voronoi_diagram.cellByIndex(xx, yy);
+		return *m_voronoi_clearance.cellByIndex(xx, yy);
+	};
+
+	bool changed = false;
+	for (int y = y1; y <= y2; y++)
 	{
-		for (int y = y1; y <= y2; y++)
+		uint16_t clearance = value(x, y, y);
+		if (clearance)
 		{
-			if (getVoroniClearance(x, y))
-			{
-				nDiag = 0;
-				for (int xx = x - 1; xx <= (x + 1); xx++)
-					for (int yy = y - 1; yy <= (y + 1); yy++)
-						if (getVoroniClearance(xx, yy)) nDiag++;
+			int nDiag = 0;
+			for (int xx = x - 1; xx <= (x + 1); xx++)
+				for (int yy = y - 1; yy <= (y + 1); yy++)
+					if (value(xx, yy, y)) nDiag++;
 
-				// Eliminar?
-				if (nDiag > 3) setVoroniClearance(x, y, 0);
-			}
+			// Eliminar?
+			if (nDiag > 3) clearance = 0;
+		}
+		uint16_t* cell = m_voronoi_diagram.cellByIndex(x, y);
+		if (*cell != clearance)
+		{
+			*cell = clearance;
+			changed = true;
 		}
 	}
+	return changed;
 }
 
 /*---------------------------------------------------------------
@@ -263,24 +320,46 @@ int COccupancyGridMap2D::computeClearance(
 		static_cast<unsigned>(cy) >= size_y)
 		return 0;
 
-	if (map[cx + cy * size_y] < thresholdCellValue) return 0;
+	if (getRawCell_nocheck(cx, cy) < thresholdCellValue) return 0;
 
 	// Truco para acelerar MUCHO:
 	//  Si miramos un punto junto al mirado antes,
 	//   usar sus resultados, xk SEGURO que no hay obstaculos
 	//   mucho antes:
 	static int ultimo_cx = -10, ultimo_cy = -10;
-	int estimated_min_free_circle;
+	int free_circle;
 	static int ultimo_free_circle;
 
 	if (abs(ultimo_cx - cx) <= 1 && abs(ultimo_cy - cy) <= 1)
-		estimated_min_free_circle = max(1, ultimo_free_circle - 3);
+		free_circle = max(1, ultimo_free_circle - 3);
 	else
-		estimated_min_free_circle = 1;
+		free_circle = 1;
 
 	ultimo_cx = cx;
 	ultimo_cy = cy;
 
+	const int clearance = internal_computeClearance(
+		cx, cy, basis_x, basis_y, nBasis, GetContourPoint, free_circle);
+
+	// Estimacion para siguiente punto:
+	ultimo_free_circle = free_circle;
+	return clearance;
+}
+
+int COccupancyGridMap2D::internal_computeClearance(
+	int cx, int cy, int* basis_x, int* basis_y, int* nBasis,
+	bool GetContourPoint, int& free_circle) const
+{
+	static const cellType thresholdCellValue = p2l(0.5f);
+
+	if (static_cast<unsigned>(cx) >= size_x ||
+		static_cast<unsigned>(cy) >= size_y ||
+		getRawCell_nocheck(cx, cy) < thresholdCellValue)
+	{
+		free_circle = 0;
+		return 0;
+	}
+
 // Tabla de circulos:
 #define N_CIRCULOS 100
 	static bool tabla_construida = false;
@@ -333,7 +412,7 @@ int COccupancyGridMap2D::computeClearance(
 
 	int vueltas_extra = 2;
 
-	for (tam_circ = estimated_min_free_circle;
+	for (tam_circ = free_circle;
 		 tam_circ < N_CIRCULOS && (!(*nBasis) || vueltas_extra); tam_circ++)
 	{
 		int nEnts = nEntradasCirculo[tam_circ];
@@ -349,7 +428,7 @@ int COccupancyGridMap2D::computeClearance(
 				yy < static_cast<int>(size_y))
 			{
 				// if ( getCell(xx,yy)<=voroni_free_threshold )
-				if (map[xx + yy * size_y] < thresholdCellValue)
+				if (getRawCell_nocheck(xx, yy) < thresholdCellValue)
 				{
 					if (!dentro_obs)
 					{
@@ -391,8 +470,7 @@ int COccupancyGridMap2D::computeClearance(
 		}
 	}
 
-	// Estimacion para siguiente punto:
-	ultimo_free_circle = tam_circ;
+	free_circle = tam_circ;
 
 	if (*nBasis >= 2)
 	{
@@ -587,10 +665,51 @@ float COccupancyGridMap2D::computeClearance(
 
 	for (xx = xx1; xx <= xx2; xx++)
 		for (yy = yy1; yy <= yy2; yy++)
-			if (map[xx + yy * size_x] < thresholdCellValue)
+			if (getRawCell_nocheck(xx, yy) < thresholdCellValue)
 				clearance_sq =
 					min(clearance_sq, square(resolution) *
 										  (square(xx - cx) + square(yy - cy)));
 
 	return sqrt(clearance_sq);
 }
+
+/*---------------------------------------------------------------
+				updateVoronoiDiagram
+  ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateVoronoiDiagram()
+{
+	ASSERTMSG_(
+		m_voronoi_built,
+		"buildVoronoiDiagram() must be called before updateVoronoiDiagram()");
+
+	if (m_voronoi_diagram.getSizeX() != size_x ||
+		m_voronoi_diagram.getSizeY() != size_y ||
+		m_voronoi_clearance.getSizeX() != size_x ||
+		m_voronoi_clearance.getSizeY() != size_y)
+		m_voronoiModifiedArea.all = true;
+
+	if (m_voronoiModifiedArea.all)
+	{
+		buildVoronoiDiagram(m_voronoi_threshold, m_voronoi_robot_size);
+		return;
+	}
+	if (m_voronoiModifiedArea.empty()) return;
+
+	// The clearance of a cell depends on obstacles up to N_CIRCULOS cells
+	// away. Whole columns are recomputed, since the search in each cell
+	// starts from the result of the previous one:
+	const int margin = N_CIRCULOS + 1;
+	const int x1 = max(0, m_voronoiModifiedArea.cx_min - margin);
+	const int x2 = min(
+		static_cast<int>(size_x) - 1, m_voronoiModifiedArea.cx_max + margin);
+	m_voronoiModifiedArea.clear();
+
+	internal_computeVoronoiClearance(x1, x2, 0, size_y - 1);
+
+	// Thinning a cell depends on its 8 neighbors, already thinned or not
+	// depending on the order of the loops. Redo it from the column before
+	// the modified ones, until a column beyond them stays the same, since
+	// the next ones would do it too:
+	for (int x = max(0, x1 - 1); x < static_cast<int>(size_x); x++)
+		if (!internal_thinVoronoiColumn(x, 0, size_y - 1) && x >= x2) break;
+}
@@ -34,6 +34,11 @@
 //#   include <pcl/registration/icp.h>
 #endif
 
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <Eigen/Eigenvalues>
+#include <mutex>
+#include <thread>
+
 #if MRPT_HAS_SSE2
 #include <mrpt/core/SSE_types.h>
 #include <mrpt/core/SSE_macros.h>
@@ -54,6 +59,24 @@ using namespace std;
 
 IMPLEMENTS_VIRTUAL_SERIALIZABLE(CPointsMap, CMetricMap, mrpt::maps)
 
+namespace
+{
+/** Worker threads for the parallel nearest-neighbor queries of all the point
+ * maps. They only run short tasks which never wait for other tasks, so they
+ * can be shared. */
+std::shared_ptr<mrpt::WorkerThreadsPool> getNearestNeighborsThreadPool(
+	const unsigned int nThreads)
+{
+	static std::mutex poolMtx;
+	static std::shared_ptr<mrpt::WorkerThreadsPool> pool;
+
+	std::lock_guard<std::mutex> lock(poolMtx);
+	if (!pool || pool->size() != nThreads)
+		pool = std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+	return pool;
+}
+}  // namespace
+
 /*---------------------------------------------------------------
 						Constructor
   ---------------------------------------------------------------*/
@@ -1099,8 +1122,6 @@ void CPointsMap::determineMatching3D(
 	float local_z_min = std::numeric_limits<float>::max(),
 		  local_z_max = -std::numeric_limits<float>::max();
 
-	double maxDistForCorrespondenceSquared;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -1151,43 +1172,41 @@ void CPointsMap::determineMatching3D(
 		local_y_min > global_y_max || local_y_max < global_y_min)
 		return;  // No need to compute: matching is ZERO.
 
-	// Loop for each point in local map:
-	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
-
+	// Look for the nearest neighbor of the checked points of the other map
+	// number [first,last) (after decimation):
+	auto matchPoints = [&](
+		const size_t first, const size_t last, TMatchingPairList& outPairs,
+		float& outSumSqrDist) {
+		for (size_t k = first; k < last; k++)
 		{
-			// KD-TREE implementation
-			// Use a KD-tree to look for the nearnest neighbor of:
-			//   (x_local, y_local, z_local)
-			// In "this" (global/reference) points map.
+			const size_t localIdx = params.offset_other_map_points +
+									k * params.decimation_other_map_points;
 
-			float tentativ_err_sq;
-			const unsigned int tentativ_this_idx = kdTreeClosestPoint3D(
-				x_local, y_local, z_local,  // Look closest to this guy
-				tentativ_err_sq  // save here the min. distance squared
-			);
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
+			const float z_local = z_locals[localIdx];
 
 			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
+			const double maxDistForCorrespondenceSquared = square(
 				params.maxAngularDistForCorrespondence *
 					params.angularDistPivotPoint.distanceTo(
 						TPoint3D(x_local, y_local, z_local)) +
 				params.maxDistForCorrespondence);
 
-			// Distance below the threshold??
-			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+			// Look for the nearnest neighbor of (x_local, y_local, z_local)
+			// in "this" (global/reference) points map, with a distance below
+			// the threshold:
+			size_t tentativ_this_idx;
+			float tentativ_err_sq;
+			if (nn_closestPoint3D(
+					x_local, y_local, z_local, maxDistForCorrespondenceSquared,
+					tentativ_this_idx, tentativ_err_sq))
 			{
 				// Save all the correspondences:
-				_correspondences.resize(_correspondences.size() + 1);
+				outPairs.resize(outPairs.size() + 1);
 
-				TMatchingPair& p = _correspondences.back();
+				TMatchingPair& p = outPairs.back();
 
 				p.this_idx = tentativ_this_idx;
 				p.this_x = m_x[tentativ_this_idx];
@@ -1201,16 +1220,50 @@ void CPointsMap::determineMatching3D(
 
 				p.errorSquareAfterTransformation = tentativ_err_sq;
 
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
-
 				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
+				outSumSqrDist += p.errorSquareAfterTransformation;
 			}
-
-		}  // End of test_match
-	}  // For each local point
+		}  // For each local point
+	};
+
+	const size_t nChecked =
+		nLocalPoints > params.offset_other_map_points
+			? (nLocalPoints - params.offset_other_map_points +
+			   params.decimation_other_map_points - 1) /
+				  params.decimation_other_map_points
+			: 0;
+
+	unsigned int nThreads = params.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1)
+		matchPoints(0, nChecked, _correspondences, _sumSqrDist);
+	else
+	{
+		// The index must be built before querying it from several threads:
+		nn_prepare3D();
+
+		// Each block of points keeps its own list of pairs, so the final
+		// list has the same order than in the single-threaded case:
+		const size_t blockSize = 256;
+		const size_t nBlocks = (nChecked + blockSize - 1) / blockSize;
+		std::vector<TMatchingPairList> blockPairs(nBlocks);
+		std::vector<float> blockSumSqrDist(nBlocks, .0f);
+		getNearestNeighborsThreadPool(nThreads)->parallelForBlocks(
+			nChecked, blockSize, [&](const size_t first, const size_t last) {
+				const size_t b = first / blockSize;
+				matchPoints(first, last, blockPairs[b], blockSumSqrDist[b]);
+			});
+		for (size_t b = 0; b < nBlocks; b++)
+		{
+			_correspondences.insert(
+				_correspondences.end(), blockPairs[b].begin(),
+				blockPairs[b].end());
+			_sumSqrDist += blockSumSqrDist[b];
+		}
+	}
+	// Each checked point has at most one correspondence:
+	nOtherMapPointsWithCorrespondence = _correspondences.size();
+	_sumSqrCount = _correspondences.size();
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -1241,6 +1294,118 @@ void CPointsMap::determineMatching3D(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+				updateLocalSurfaces
+---------------------------------------------------------------*/
+bool CPointsMap::nn_closestPoint3D(
+	const float x, const float y, const float z, const double maxDistSqr,
+	size_t& outIdx, float& outDistSqr) const
+{
+	outIdx = kdTreeClosestPoint3D(x, y, z, outDistSqr);
+	return outDistSqr < maxDistSqr;
+}
+
+void CPointsMap::nn_kClosestPoints3D(
+	const float x, const float y, const float z, const size_t knn,
+	std::vector<size_t>& outIdx, std::vector<float>& outDistSqr) const
+{
+	kdTreeNClosestPoint3DIdx(x, y, z, knn, outIdx, outDistSqr);
+}
+
+void CPointsMap::updateLocalSurfaces(
+	const size_t nNeighbors, const unsigned int numThreads) const
+{
+	MRPT_START
+
+	ASSERT_ABOVEEQ_(nNeighbors, 3);
+
+	std::lock_guard<std::mutex> lck(m_localSurfacesMtx.mtx);
+	if (m_localSurfacesIsUpdated && m_localSurfacesNeighbors == nNeighbors)
+		return;
+
+	const size_t N = m_x.size();
+	m_localCovariances.resize(N);
+	m_localNormals.resize(N);
+	const size_t knn = std::min(nNeighbors, N);
+
+	auto estimateSurfaces = [&](const size_t first, const size_t last) {
+		std::vector<size_t> idxs;
+		std::vector<float> dists_sqr;
+		for (size_t i = first; i < last; i++)
+		{
+			nn_kClosestPoints3D(m_x[i], m_y[i], m_z[i], knn, idxs, dists_sqr);
+
+			// Mean and covariance of the neighbors:
+			float mx = 0, my = 0, mz = 0;
+			for (const size_t j : idxs)
+			{
+				mx += m_x[j];
+				my += m_y[j];
+				mz += m_z[j];
+			}
+			const float invN = 1.0f / knn;
+			mx *= invN;
+			my *= invN;
+			mz *= invN;
+
+			CMatrixFloat33& C = m_localCovariances[i];
+			C.zeros();
+			for (const size_t j : idxs)
+			{
+				const float dx = m_x[j] - mx, dy = m_y[j] - my,
+							dz = m_z[j] - mz;
+				C(0, 0) += dx * dx;
+				C(0, 1) += dx * dy;
+				C(0, 2) += dx * dz;
+				C(1, 1) += dy * dy;
+				C(1, 2) += dy * dz;
+				C(2, 2) += dz * dz;
+			}
+			C(1, 0) = C(0, 1);
+			C(2, 0) = C(0, 2);
+			C(2, 1) = C(1, 2);
+			C *= invN;
+
+			// Eigenvalues in increasing order:
+			const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> es(C);
+			const Eigen::Vector3f n = es.eigenvectors().col(0);
+			m_localNormals[i] = TPoint3Df(n[0], n[1], n[2]);
+		}
+	};
+
+	unsigned int nThreads = numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1 || N < 2)
+		estimateSurfaces(0, N);
+	else
+	{
+		// The index must be built before querying it from several threads:
+		nn_prepare3D();
+		getNearestNeighborsThreadPool(nThreads)->parallelForBlocks(
+			N, 256, estimateSurfaces);
+	}
+
+	m_localSurfacesNeighbors = nNeighbors;
+	m_localSurfacesIsUpdated = true;
+
+	MRPT_END
+}
+
+const mrpt::aligned_std_vector<CMatrixFloat33>&
+	CPointsMap::getPointsLocalCovariances(
+		const size_t nNeighbors, const unsigned int numThreads) const
+{
+	updateLocalSurfaces(nNeighbors, numThreads);
+	return m_localCovariances;
+}
+
+const std::vector<TPoint3Df>& CPointsMap::getPointsNormals(
+	const size_t nNeighbors, const unsigned int numThreads) const
+{
+	updateLocalSurfaces(nNeighbors, numThreads);
+	return m_localNormals;
+}
+
 /*---------------------------------------------------------------
 				extractCylinder
 ---------------------------------------------------------------*/
@@ -1705,7 +1870,7 @@ void CPointsMap::addFrom(const CPointsMap& anotherMap)
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(anotherMap, nThis);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Save the point cloud as a PCL PCD file, in either ASCII or binary format
@@ -1799,7 +1964,7 @@ void CPointsMap::insertAnotherMap(
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(*otherMap, N_this);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Helper method for ::copyFrom() */
@@ -1853,7 +2018,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation2DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const CObservation2DRangeScan* o =
 			static_cast<const CObservation2DRangeScan*>(obs);
@@ -1945,7 +2110,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation3DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const CObservation3DRangeScan* o =
 			static_cast<const CObservation3DRangeScan*>(obs);
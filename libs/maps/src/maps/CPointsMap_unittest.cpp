@@ -10,8 +10,11 @@
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/maps/CWeightedPointsMap.h>
 #include <mrpt/maps/CColouredPointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/poses/CPoint2D.h>
+#include <mrpt/poses/CPose3D.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::maps;
@@ -184,3 +187,148 @@ TEST(CColouredPointsMapTests, clipOutOfRange)
 {
 	do_test_clipOutOfRange<CColouredPointsMap>();
 }
+
+TEST(CSimplePointsMapTests, determineMatching3DParallel)
+{
+	// Two noisy, displaced samples of the same wavy surface:
+	CSimplePointsMap m1, m2;
+	for (int i = 0; i < 3000; i++)
+	{
+		const float x = 0.01f * (i % 100), y = 0.013f * (i / 100);
+		m1.insertPoint(x, y, 0.1f * sin(5 * x) * cos(3 * y));
+		m2.insertPoint(
+			x + 0.003f, y - 0.002f,
+			0.1f * sin(5 * x + 0.02f) * cos(3 * y) + 0.001f * (i % 7));
+	}
+	const CPose3D pose(0.01, -0.02, 0.005, 0.02, 0.01, -0.01);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.05f;
+	params.decimation_other_map_points = 3;
+	params.offset_other_map_points = 1;
+
+	mrpt::tfest::TMatchingPairList corrsSerial, corrsParallel;
+	TMatchingExtraResults extraSerial, extraParallel;
+	m1.determineMatching3D(&m2, pose, corrsSerial, params, extraSerial);
+	params.numThreads = 4;
+	m1.determineMatching3D(&m2, pose, corrsParallel, params, extraParallel);
+
+	ASSERT_GT(corrsSerial.size(), 500u);
+	EXPECT_TRUE(corrsSerial == corrsParallel);
+	EXPECT_EQ(
+		extraSerial.correspondencesRatio, extraParallel.correspondencesRatio);
+}
+
+TEST(CSimplePointsMapTests, getPointsNormals)
+{
+	// Points on the plane z=0.5x, slightly scattered along it:
+	CSimplePointsMap m;
+	for (int i = 0; i < 400; i++)
+	{
+		const float x = 0.05f * (i % 20) + 0.001f * (i % 3),
+					y = 0.05f * (i / 20);
+		m.insertPoint(x, y, 0.5f * x);
+	}
+
+	const auto& normalsSerial = m.getPointsNormals(8);
+	const std::vector<TPoint3Df> normals1 = normalsSerial;
+	m.mark_as_modified();
+	const auto& normals4 = m.getPointsNormals(8, 4);
+	ASSERT_EQ(normals1.size(), m.size());
+	ASSERT_EQ(normals4.size(), m.size());
+
+	const double k = 1.0 / std::sqrt(1.25);
+	for (size_t i = 0; i < m.size(); i++)
+	{
+		// Sign is arbitrary:
+		EXPECT_NEAR(std::abs(normals1[i].x), 0.5 * k, 1e-4);
+		EXPECT_NEAR(std::abs(normals1[i].y), 0, 1e-4);
+		EXPECT_NEAR(std::abs(normals1[i].z), k, 1e-4);
+		EXPECT_EQ(normals1[i].x, normals4[i].x);
+		EXPECT_EQ(normals1[i].y, normals4[i].y);
+		EXPECT_EQ(normals1[i].z, normals4[i].z);
+	}
+}
+
+TEST(CSimplePointsMapTests, getPointsNormalsConcurrently)
+{
+	CSimplePointsMap m;
+	for (int i = 0; i < 2000; i++)
+	{
+		const float x = 0.05f * (i % 50) + 0.001f * (i % 7),
+					y = 0.05f * (i / 50);
+		m.insertPoint(x, y, 0.5f * x + 0.1f * std::sin(y));
+	}
+	// A copy computes its own cache:
+	const CSimplePointsMap mRef = m;
+	const std::vector<TPoint3Df> normalsRef = mRef.getPointsNormals(8);
+
+	// Several threads asking the (unmodified) map for its normals at once:
+	std::vector<std::vector<TPoint3Df>> normals(4);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < normals.size(); t++)
+		threads.emplace_back([&m, &normals, t]() {
+			normals[t] = m.getPointsNormals(8, t % 2 ? 2 : 1);
+		});
+	for (auto& th : threads) th.join();
+
+	for (const auto& n : normals)
+	{
+		ASSERT_EQ(n.size(), normalsRef.size());
+		for (size_t i = 0; i < n.size(); i++)
+		{
+			EXPECT_EQ(n[i].x, normalsRef[i].x);
+			EXPECT_EQ(n[i].y, normalsRef[i].y);
+			EXPECT_EQ(n[i].z, normalsRef[i].z);
+		}
+	}
+}
+
+TEST(CSimplePointsMapTests, incrementalKdTree)
+{
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.resizeScan(181);
+	for (size_t i = 0; i < scan.getScanSize(); i++)
+	{
+		scan.setScanRange(i, 2.0f + 0.5f * sin(0.1f * i));
+		scan.setScanRangeValidity(i, true);
+	}
+
+	// Insert the same scans from several poses into both maps, querying the
+	// kd-tree between insertions:
+	CSimplePointsMap incr, full;
+	incr.kdtree_search_params.incremental = true;
+	for (int k = 0; k < 10; k++)
+	{
+		const CPose3D robotPose(0.3 * k, 0.1 * k, 0, 0.2 * k, 0, 0);
+		if (k == 5)
+		{
+			// Replace the contents in the middle of the sequence:
+			incr.insertionOptions.addToExistingPointsMap = false;
+			full.insertionOptions.addToExistingPointsMap = false;
+			incr.loadFromRangeScan(scan, &robotPose);
+			full.loadFromRangeScan(scan, &robotPose);
+		}
+		else
+		{
+			incr.insertObservation(&scan, &robotPose);
+			full.insertObservation(&scan, &robotPose);
+		}
+		ASSERT_EQ(incr.size(), full.size());
+
+		for (int q = 0; q < 20; q++)
+		{
+			const float x = -2 + 0.4f * q, y = 1 - 0.1f * q;
+			std::vector<size_t> idxI, idxF;
+			std::vector<float> distI, distF;
+			incr.kdTreeNClosestPoint2DIdx(x, y, 3, idxI, distI);
+			full.kdTreeNClosestPoint2DIdx(x, y, 3, idxF, distF);
+			EXPECT_EQ(distI, distF);
+			float di, df;
+			EXPECT_EQ(
+				incr.kdTreeClosestPoint3D(x, y, 0, di),
+				full.kdTreeClosestPoint3D(x, y, 0, df));
+		}
+	}
+}
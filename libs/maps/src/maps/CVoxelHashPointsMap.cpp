@@ -0,0 +1,516 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+
+#include <mrpt/maps/CVoxelHashPointsMap.h>
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/core/bits_mem.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"CVoxelHashPointsMap,voxelHashPointsMap", mrpt::maps::CVoxelHashPointsMap)
+
+CVoxelHashPointsMap::TMapDefinition::TMapDefinition() {}
+void CVoxelHashPointsMap::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& c, const std::string& s)
+{
+	insertionOpts.loadFromConfigFile(c, s + string("_insertOpts"));
+	likelihoodOpts.loadFromConfigFile(c, s + string("_likelihoodOpts"));
+	renderOpts.loadFromConfigFile(c, s + string("_renderOpts"));
+	voxelOpts.loadFromConfigFile(c, s + string("_voxelOpts"));
+}
+
+void CVoxelHashPointsMap::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+	this->renderOpts.dumpToTextStream(out);
+	this->voxelOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap* CVoxelHashPointsMap::internal_CreateFromMapDefinition(
+	const mrpt::maps::TMetricMapInitializer& _def)
+{
+	const CVoxelHashPointsMap::TMapDefinition& def =
+		*dynamic_cast<const CVoxelHashPointsMap::TMapDefinition*>(&_def);
+	CVoxelHashPointsMap* obj = new CVoxelHashPointsMap();
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	obj->renderOptions = def.renderOpts;
+	obj->voxelOptions = def.voxelOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CVoxelHashPointsMap, CPointsMap, mrpt::maps)
+
+void CVoxelHashPointsMap::TVoxelOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& iniFile, const string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(voxel_size, float, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(max_points_per_voxel, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(min_dist_between_points, float, iniFile, section);
+}
+
+void CVoxelHashPointsMap::TVoxelOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CVoxelHashPointsMap::TVoxelOptions] ------------ "
+		   "\n\n";
+
+	LOADABLEOPTS_DUMP_VAR(voxel_size, double);
+	LOADABLEOPTS_DUMP_VAR(max_points_per_voxel, int);
+	LOADABLEOPTS_DUMP_VAR(min_dist_between_points, double);
+
+	out << endl;
+}
+
+void CVoxelHashPointsMap::TVoxelOptions::writeToStream(
+	mrpt::serialization::CArchive& out) const
+{
+	const int8_t version = 0;
+	out << version;
+	out << voxel_size << max_points_per_voxel << min_dist_between_points;
+}
+
+void CVoxelHashPointsMap::TVoxelOptions::readFromStream(
+	mrpt::serialization::CArchive& in)
+{
+	int8_t version;
+	in >> version;
+	switch (version)
+	{
+		case 0:
+		{
+			in >> voxel_size >> max_points_per_voxel >>
+				min_dist_between_points;
+		}
+		break;
+		default:
+			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	}
+}
+
+CVoxelHashPointsMap::CVoxelHashPointsMap() {}
+void CVoxelHashPointsMap::reserve(size_t newLength)
+{
+	m_x.reserve(newLength);
+	m_y.reserve(newLength);
+	m_z.reserve(newLength);
+}
+
+void CVoxelHashPointsMap::resize(size_t newLength)
+{
+	this->reserve(newLength);  // to ensure 4N capacity
+	m_x.resize(newLength, 0);
+	m_y.resize(newLength, 0);
+	m_z.resize(newLength, 0);
+	mark_as_modified();
+}
+
+void CVoxelHashPointsMap::setSize(size_t newLength)
+{
+	this->reserve(newLength);  // to ensure 4N capacity
+	m_x.assign(newLength, 0);
+	m_y.assign(newLength, 0);
+	m_z.assign(newLength, 0);
+	mark_as_modified();
+}
+
+void CVoxelHashPointsMap::copyFrom(const CPointsMap& obj)
+{
+	CPointsMap::base_copyFrom(
+		obj);  // This also does a ::resize(N) of all data fields.
+}
+
+uint8_t CVoxelHashPointsMap::serializeGetVersion() const { return 0; }
+void CVoxelHashPointsMap::serializeTo(mrpt::serialization::CArchive& out) const
+{
+	const uint32_t n = m_x.size();
+	out << n;
+	if (n > 0)
+	{
+		out.WriteBufferFixEndianness(&m_x[0], n);
+		out.WriteBufferFixEndianness(&m_y[0], n);
+		out.WriteBufferFixEndianness(&m_z[0], n);
+	}
+	out << genericMapParams;
+	insertionOptions.writeToStream(out);
+	likelihoodOptions.writeToStream(out);
+	renderOptions.writeToStream(out);
+	voxelOptions.writeToStream(out);
+}
+
+void CVoxelHashPointsMap::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			uint32_t n;
+			in >> n;
+			this->resize(n);
+			if (n > 0)
+			{
+				in.ReadBufferFixEndianness(&m_x[0], n);
+				in.ReadBufferFixEndianness(&m_y[0], n);
+				in.ReadBufferFixEndianness(&m_z[0], n);
+			}
+			in >> genericMapParams;
+			insertionOptions.readFromStream(in);
+			likelihoodOptions.readFromStream(in);
+			renderOptions.readFromStream(in);
+			voxelOptions.readFromStream(in);
+			mark_as_modified();
+		}
+		break;
+		default:
+			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version)
+	};
+}
+
+void CVoxelHashPointsMap::internal_clear()
+{
+	// This swap() thing is the only way to really deallocate the memory.
+	vector_strong_clear(m_x);
+	vector_strong_clear(m_y);
+	vector_strong_clear(m_z);
+	m_voxels.clear();
+
+	mark_as_modified();
+}
+
+void CVoxelHashPointsMap::PLY_import_set_vertex_count(const size_t N)
+{
+	this->setSize(N);
+}
+
+void CVoxelHashPointsMap::setPointFast(size_t index, float x, float y, float z)
+{
+	m_x[index] = x;
+	m_y[index] = y;
+	m_z[index] = z;
+	// The point may now belong to another voxel:
+	m_voxelsIsUpdated = false;
+}
+
+// Voxel coordinates are packed into 21 bits each:
+static inline uint64_t voxelKey(int32_t ix, int32_t iy, int32_t iz)
+{
+	const uint64_t m = (uint64_t(1) << 21) - 1;
+	return (uint64_t(ix) & m) | ((uint64_t(iy) & m) << 21) |
+		   ((uint64_t(iz) & m) << 42);
+}
+static inline void voxelKeyCoords(
+	const uint64_t key, int32_t& ix, int32_t& iy, int32_t& iz)
+{
+	// Shifts to the left, then arithmetic shifts to extend the sign:
+	ix = static_cast<int32_t>(static_cast<int64_t>(key << 43) >> 43);
+	iy = static_cast<int32_t>(static_cast<int64_t>(key << 22) >> 43);
+	iz = static_cast<int32_t>(static_cast<int64_t>(key << 1) >> 43);
+}
+
+void CVoxelHashPointsMap::voxelCoords(
+	const float x, const float y, const float z, int32_t& ix, int32_t& iy,
+	int32_t& iz) const
+{
+	const float k = 1.0f / voxelOptions.voxel_size;
+	ix = static_cast<int32_t>(std::floor(x * k));
+	iy = static_cast<int32_t>(std::floor(y * k));
+	iz = static_cast<int32_t>(std::floor(z * k));
+}
+
+void CVoxelHashPointsMap::updateVoxels() const
+{
+	if (m_voxelsIsUpdated) return;
+	ASSERT_ABOVE_(voxelOptions.voxel_size, 0);
+
+	// All the points are indexed, even those beyond the per-voxel limit,
+	// since they were set explicitly by the user:
+	m_voxels.clear();
+	for (size_t i = 0; i < m_x.size(); i++)
+	{
+		int32_t ix, iy, iz;
+		voxelCoords(m_x[i], m_y[i], m_z[i], ix, iy, iz);
+		m_voxels[voxelKey(ix, iy, iz)].push_back(i);
+	}
+	m_voxelsIsUpdated = true;
+}
+
+size_t CVoxelHashPointsMap::voxelCount() const
+{
+	updateVoxels();
+	return m_voxels.size();
+}
+
+void CVoxelHashPointsMap::insertPointFast(float x, float y, float z)
+{
+	updateVoxels();
+
+	int32_t ix, iy, iz;
+	voxelCoords(x, y, z, ix, iy, iz);
+	std::vector<uint32_t>& voxel = m_voxels[voxelKey(ix, iy, iz)];
+	if (voxel.size() >= voxelOptions.max_points_per_voxel) return;
+	if (voxelOptions.min_dist_between_points > 0)
+	{
+		const float minDistSqr = square(voxelOptions.min_dist_between_points);
+		for (const uint32_t i : voxel)
+			if (square(m_x[i] - x) + square(m_y[i] - y) +
+					square(m_z[i] - z) <
+				minDistSqr)
+				return;
+	}
+
+	voxel.push_back(m_x.size());
+	m_x.push_back(x);
+	m_y.push_back(y);
+	m_z.push_back(z);
+}
+
+void CVoxelHashPointsMap::insertDecimated(const CPointsMap& m)
+{
+	const size_t N = m.size();
+	float x, y, z;
+	for (size_t i = 0; i < N; i++)
+	{
+		m.getPointFast(i, x, y, z);
+		insertPointFast(x, y, z);
+	}
+	mark_as_appended();
+}
+
+bool CVoxelHashPointsMap::internal_insertObservation(
+	const CObservation* obs, const CPose3D* robotPose)
+{
+	// Get the points of the observation, as CSimplePointsMap would, then
+	// insert them here:
+	m_auxObsPoints.clear();
+	m_auxObsPoints.insertionOptions = insertionOptions;
+	m_auxObsPoints.insertionOptions.fuseWithExisting = false;
+	if (!m_auxObsPoints.insertObservation(obs, robotPose)) return false;
+
+	insertDecimated(m_auxObsPoints);
+	return true;
+}
+
+void CVoxelHashPointsMap::loadFromRangeScan(
+	const CObservation2DRangeScan& rangeScan, const CPose3D* robotPose)
+{
+	if (!insertionOptions.addToExistingPointsMap) clear();
+	m_auxObsPoints.insertionOptions = insertionOptions;
+	m_auxObsPoints.insertionOptions.addToExistingPointsMap = false;
+	m_auxObsPoints.loadFromRangeScan(rangeScan, robotPose);
+	insertDecimated(m_auxObsPoints);
+}
+
+void CVoxelHashPointsMap::loadFromRangeScan(
+	const CObservation3DRangeScan& rangeScan, const CPose3D* robotPose)
+{
+	if (!insertionOptions.addToExistingPointsMap) clear();
+	m_auxObsPoints.insertionOptions = insertionOptions;
+	m_auxObsPoints.insertionOptions.addToExistingPointsMap = false;
+	m_auxObsPoints.loadFromRangeScan(rangeScan, robotPose);
+	insertDecimated(m_auxObsPoints);
+}
+
+namespace
+{
+// Result sets for CVoxelHashPointsMap::searchVoxels(), with the same
+// interface than nanoflann's ones. Points are only added if closer than
+// worstDist(), and the search ends once full() and no unvisited voxel may
+// hold a closer point than worstDist().
+struct TClosestResult
+{
+	float bestDistSqr;
+	size_t bestIdx{0};
+	bool found{false};
+
+	explicit TClosestResult(float maxDistSqr) : bestDistSqr(maxDistSqr) {}
+	bool full() const { return true; }
+	float worstDist() const { return bestDistSqr; }
+	void addPoint(float distSqr, size_t idx)
+	{
+		bestDistSqr = distSqr;
+		bestIdx = idx;
+		found = true;
+	}
+};
+
+struct TKNNResult
+{
+	size_t capacity;
+	std::vector<std::pair<size_t, float>> points;
+
+	explicit TKNNResult(size_t knn) : capacity(knn) { points.reserve(knn); }
+	bool full() const { return points.size() == capacity; }
+	float worstDist() const
+	{
+		return full() ? points.back().second
+					  : std::numeric_limits<float>::max();
+	}
+	void addPoint(float distSqr, size_t idx)
+	{
+		// Insertion in the sorted list:
+		if (full()) points.pop_back();
+		auto it = points.end();
+		while (it != points.begin() && (it - 1)->second > distSqr) --it;
+		points.emplace(it, idx, distSqr);
+	}
+};
+
+struct TRadiusResult
+{
+	float radiusSqr;
+	std::vector<std::pair<size_t, float>>& points;
+
+	TRadiusResult(float r2, std::vector<std::pair<size_t, float>>& out)
+		: radiusSqr(r2), points(out)
+	{
+		points.clear();
+	}
+	bool full() const { return true; }
+	float worstDist() const { return radiusSqr; }
+	void addPoint(float distSqr, size_t idx)
+	{
+		points.emplace_back(idx, distSqr);
+	}
+};
+}  // namespace
+
+template <class RESULTSET>
+void CVoxelHashPointsMap::searchVoxels(
+	const float x, const float y, const float z, RESULTSET& resultSet) const
+{
+	updateVoxels();
+	if (m_voxels.empty()) return;
+
+	const float vs = voxelOptions.voxel_size;
+	int32_t cx, cy, cz;
+	voxelCoords(x, y, z, cx, cy, cz);
+
+	// Distance from the query point to the faces of its own voxel:
+	const float minFaceDist = std::min(
+		{x - cx * vs, (cx + 1) * vs - x, y - cy * vs, (cy + 1) * vs - y,
+		 z - cz * vs, (cz + 1) * vs - z});
+
+	auto visitVoxel = [&](const std::vector<uint32_t>& voxel) {
+		for (const uint32_t i : voxel)
+		{
+			const float d2 =
+				square(m_x[i] - x) + square(m_y[i] - y) + square(m_z[i] - z);
+			if (d2 < resultSet.worstDist()) resultSet.addPoint(d2, i);
+		}
+	};
+
+	// Visit cubic shells of voxels of increasing radius "r" around the
+	// query: after shell "r", unvisited points are farther than
+	// (r+minFaceDist/vs)*vs.
+	for (int32_t r = 0;; r++)
+	{
+		const size_t shellCubeVoxels = (2 * r + 1) * (2 * r + 1) * (2 * r + 1);
+		if (shellCubeVoxels > m_voxels.size())
+		{
+			// Cheaper to visit all the remaining voxels at once:
+			for (const auto& v : m_voxels)
+			{
+				int32_t ix, iy, iz;
+				voxelKeyCoords(v.first, ix, iy, iz);
+				if (std::max({std::abs(ix - cx), std::abs(iy - cy),
+							  std::abs(iz - cz)}) >= r)
+					visitVoxel(v.second);
+			}
+			return;
+		}
+
+		for (int32_t dx = -r; dx <= r; dx++)
+			for (int32_t dy = -r; dy <= r; dy++)
+			{
+				const bool onShellXY = (std::abs(dx) == r || std::abs(dy) == r);
+				for (int32_t dz = -r; dz <= r;
+					 dz += (onShellXY || r == 0) ? 1 : 2 * r)
+				{
+					const auto it =
+						m_voxels.find(voxelKey(cx + dx, cy + dy, cz + dz));
+					if (it != m_voxels.end()) visitVoxel(it->second);
+				}
+			}
+
+		const float bound = r * vs + minFaceDist;
+		if (resultSet.full() && square(bound) >= resultSet.worstDist()) return;
+	}
+}
+
+int CVoxelHashPointsMap::voxelClosestPoint3D(
+	const float x, const float y, const float z, const float maxDist,
+	float& outDistSqr) const
+{
+	TClosestResult res(square(maxDist));
+	searchVoxels(x, y, z, res);
+	outDistSqr = res.bestDistSqr;
+	return res.found ? static_cast<int>(res.bestIdx) : -1;
+}
+
+void CVoxelHashPointsMap::voxelNClosestPoints3D(
+	const float x, const float y, const float z, const size_t knn,
+	std::vector<size_t>& outIdx, std::vector<float>& outDistSqr) const
+{
+	TKNNResult res(knn);
+	if (knn) searchVoxels(x, y, z, res);
+	outIdx.resize(res.points.size());
+	outDistSqr.resize(res.points.size());
+	for (size_t i = 0; i < res.points.size(); i++)
+	{
+		outIdx[i] = res.points[i].first;
+		outDistSqr[i] = res.points[i].second;
+	}
+}
+
+void CVoxelHashPointsMap::voxelRadiusSearch3D(
+	const float x, const float y, const float z, const float radius,
+	std::vector<std::pair<size_t, float>>& outIdxDistSqr) const
+{
+	TRadiusResult res(square(radius), outIdxDistSqr);
+	searchVoxels(x, y, z, res);
+	std::sort(
+		outIdxDistSqr.begin(), outIdxDistSqr.end(),
+		[](const std::pair<size_t, float>& a,
+		   const std::pair<size_t, float>& b) { return a.second < b.second; });
+}
+
+bool CVoxelHashPointsMap::nn_closestPoint3D(
+	const float x, const float y, const float z, const double maxDistSqr,
+	size_t& outIdx, float& outDistSqr) const
+{
+	TClosestResult res(static_cast<float>(maxDistSqr));
+	searchVoxels(x, y, z, res);
+	outIdx = res.bestIdx;
+	outDistSqr = res.bestDistSqr;
+	return res.found;
+}
+
+void CVoxelHashPointsMap::nn_kClosestPoints3D(
+	const float x, const float y, const float z, const size_t knn,
+	std::vector<size_t>& outIdx, std::vector<float>& outDistSqr) const
+{
+	voxelNClosestPoints3D(x, y, z, knn, outIdx, outDistSqr);
+}
@@ -0,0 +1,182 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/maps/CVoxelHashPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/TMetricMapTypesRegistry.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace std;
+
+static void randomPoints(CPointsMap& m, size_t N, unsigned int seed)
+{
+	mrpt::random::CRandomGenerator rng(seed);
+	for (size_t i = 0; i < N; i++)
+		m.insertPoint(
+			rng.drawUniform(-5, 5), rng.drawUniform(-5, 5),
+			rng.drawUniform(-1, 1));
+}
+
+TEST(CVoxelHashPointsMapTests, insertionIsDecimatedPerVoxel)
+{
+	CVoxelHashPointsMap m;
+	m.voxelOptions.voxel_size = 1.0f;
+	m.voxelOptions.max_points_per_voxel = 5;
+
+	// Many points in the same voxel [0,1)^3, then one in another voxel:
+	for (int i = 0; i < 100; i++) m.insertPoint(0.01f * i, 0.5f, 0.5f);
+	EXPECT_EQ(m.size(), 5u);
+	m.insertPoint(1.5f, 0.5f, 0.5f);
+	EXPECT_EQ(m.size(), 6u);
+	EXPECT_EQ(m.voxelCount(), 2u);
+
+	// Minimum distance within a voxel:
+	CVoxelHashPointsMap m2;
+	m2.voxelOptions.voxel_size = 1.0f;
+	m2.voxelOptions.min_dist_between_points = 0.1f;
+	for (int i = 0; i < 100; i++) m2.insertPoint(0.01f * i, 0.5f, 0.5f);
+	EXPECT_EQ(m2.size(), 10u);
+
+	// Observing the same scan again does not grow the map, if a minimum
+	// distance is set:
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.resizeScan(361);
+	for (size_t i = 0; i < scan.getScanSize(); i++)
+	{
+		scan.setScanRange(i, 3.0f);
+		scan.setScanRangeValidity(i, true);
+	}
+	CVoxelHashPointsMap m3;
+	m3.voxelOptions.min_dist_between_points = 0.01f;
+	m3.insertObservation(&scan);
+	const size_t n1 = m3.size();
+	EXPECT_GT(n1, 100u);
+	m3.insertObservation(&scan);
+	EXPECT_EQ(m3.size(), n1);
+}
+
+TEST(CVoxelHashPointsMapTests, queriesMatchBruteForce)
+{
+	CVoxelHashPointsMap m;
+	m.voxelOptions.voxel_size = 0.3f;
+	m.voxelOptions.max_points_per_voxel = 1000;
+	randomPoints(m, 3000, 1);
+	ASSERT_EQ(m.size(), 3000u);
+
+	mrpt::random::CRandomGenerator rng(2);
+	for (int q = 0; q < 100; q++)
+	{
+		// Some queries far from the cloud, too:
+		const float x = rng.drawUniform(-7, 7), y = rng.drawUniform(-7, 7),
+					z = rng.drawUniform(-2, 2);
+		std::vector<float> d2(m.size());
+		for (size_t i = 0; i < m.size(); i++)
+		{
+			float px, py, pz;
+			m.getPoint(i, px, py, pz);
+			d2[i] = square(px - x) + square(py - y) + square(pz - z);
+		}
+		std::vector<float> sorted = d2;
+		std::sort(sorted.begin(), sorted.end());
+
+		std::vector<size_t> idx;
+		std::vector<float> dist;
+		m.voxelNClosestPoints3D(x, y, z, 10, idx, dist);
+		ASSERT_EQ(idx.size(), 10u);
+		for (size_t k = 0; k < 10; k++)
+		{
+			EXPECT_EQ(dist[k], sorted[k]);
+			EXPECT_EQ(d2[idx[k]], dist[k]);
+		}
+
+		float closestDist;
+		const int closest = m.voxelClosestPoint3D(x, y, z, 0.5f, closestDist);
+		if (sorted[0] < 0.25f)
+		{
+			ASSERT_GE(closest, 0);
+			EXPECT_EQ(closestDist, sorted[0]);
+		}
+		else
+			EXPECT_EQ(closest, -1);
+
+		std::vector<std::pair<size_t, float>> inRadius;
+		m.voxelRadiusSearch3D(x, y, z, 0.8f, inRadius);
+		const size_t nInRadius =
+			std::lower_bound(sorted.begin(), sorted.end(), 0.64f) -
+			sorted.begin();
+		ASSERT_EQ(inRadius.size(), nInRadius);
+		for (size_t k = 0; k < nInRadius; k++)
+			EXPECT_EQ(inRadius[k].second, sorted[k]);
+	}
+
+	// More neighbors than points:
+	CVoxelHashPointsMap small;
+	randomPoints(small, 3, 3);
+	std::vector<size_t> idx;
+	std::vector<float> dist;
+	small.voxelNClosestPoints3D(100, 100, 100, 5, idx, dist);
+	EXPECT_EQ(idx.size(), 3u);
+}
+
+TEST(CVoxelHashPointsMapTests, matchingEqualsSimplePointsMap)
+{
+	CVoxelHashPointsMap ref;
+	ref.voxelOptions.max_points_per_voxel = 1000;
+	CSimplePointsMap refSimple, other;
+	randomPoints(ref, 2000, 4);
+	randomPoints(refSimple, 2000, 4);
+	randomPoints(other, 500, 5);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.3f;
+	TMatchingExtraResults extra1, extra2;
+	mrpt::tfest::TMatchingPairList corrs1, corrs2;
+	const CPose3D pose(0.05, -0.02, 0.01, 0.03, 0, 0);
+	ref.determineMatching3D(&other, pose, corrs1, params, extra1);
+	refSimple.determineMatching3D(&other, pose, corrs2, params, extra2);
+	ASSERT_GT(corrs1.size(), 100u);
+	EXPECT_TRUE(corrs1 == corrs2);
+
+	// Changing the points keeps the voxels consistent:
+	ref.changeCoordinatesReference(pose);
+	refSimple.changeCoordinatesReference(pose);
+	ref.determineMatching3D(&other, pose, corrs1, params, extra1);
+	refSimple.determineMatching3D(&other, pose, corrs2, params, extra2);
+	EXPECT_TRUE(corrs1 == corrs2);
+}
+
+TEST(CVoxelHashPointsMapTests, createFromConfigFile)
+{
+	mrpt::config::CConfigFileMemory cfg;
+	const std::string sect = "map_voxelHashPointsMap_00_voxelOpts";
+	cfg.write("map", "voxelHashPointsMap_count", 1);
+	cfg.write(sect, "voxel_size", 0.5);
+	cfg.write(sect, "max_points_per_voxel", 3);
+
+	TSetOfMetricMapInitializers inits;
+	inits.loadFromConfigFile(cfg, "map");
+	ASSERT_EQ(inits.size(), 1u);
+	std::unique_ptr<CMetricMap> map(
+		mrpt::maps::internal::TMetricMapTypesRegistry::Instance()
+			.factoryMapObjectFromDefinition(**inits.begin()));
+	auto voxelMap = dynamic_cast<CVoxelHashPointsMap*>(map.get());
+	ASSERT_TRUE(voxelMap != nullptr);
+	EXPECT_EQ(voxelMap->voxelOptions.voxel_size, 0.5f);
+	EXPECT_EQ(voxelMap->voxelOptions.max_points_per_voxel, 3u);
+}
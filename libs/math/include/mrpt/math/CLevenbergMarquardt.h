@@ -10,11 +10,18 @@
 #define CLevenbergMarquardt_H
 
 #include <mrpt/system/COutputLogger.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/math/types_math.h>
 #include <mrpt/math/num_jacobian.h>
+#include <mrpt/math/robust_kernels.h>
+#include <mrpt/math/CSparseMatrix.h>
 #include <mrpt/containers/printf_vector.h>
 #include <mrpt/math/ops_containers.h>
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <tuple>
+#include <vector>
 
 namespace mrpt
 {
@@ -27,6 +34,22 @@ namespace math
  * href="http://www.mrpt.org/Levenberg%E2%80%93Marquardt_algorithm" >page</a>
  * for more details on the algorithm and its usage.
  *
+ *  Two variants are provided:
+ *  - execute(): dense Jacobian, estimated by finite differences, and dense
+ * normal equations. Meant for problems with a few parameters.
+ *  - executeSparse(): for problems with many parameters where each error
+ * only depends on a few of them (camera calibration, bundle adjustment,...).
+ * The user gives the sparsity pattern of the Jacobian and, optionally, a
+ * functor to evaluate it. Otherwise, it is estimated by finite differences
+ * perturbing at once all the parameters which do not share any error term.
+ * The normal equations are solved by sparse Cholesky (see
+ * mrpt::math::CSparseMatrix::CholeskyDecomp), with the symbolic analysis
+ * done only once.
+ *
+ *  In both cases, the errors can be weighted by a robust kernel (see \a
+ * robust_kernel), and the finite differences can be evaluated in parallel
+ * (see \a num_threads).
+ *
  * \tparam NUMTYPE The numeric type for all the operations (float, double, or
  * long double)
  * \tparam USERPARAM The type of the "y" input to the user supplied evaluation
@@ -46,6 +69,24 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 	{
 	}
 
+	/** Number of threads to evaluate the finite differences of the Jacobian
+	 * (0: as many as CPU cores). If other than 1, the evaluation functor
+	 * must be safe to call concurrently. */
+	size_t num_threads{1};
+	/** Robust kernel applied to each residual (default: plain least squares).
+	 * With a robust kernel, each residual is weighted in the normal equations
+	 * by the derivative of the kernel at its current error (iteratively
+	 * reweighted least squares), and the reported square errors are the
+	 * robustified ones. */
+	TRobustKernelType robust_kernel{rkLeastSquares};
+	/** Parameter (threshold) of the robust kernel, in the units of the
+	 * errors */
+	NUMTYPE robust_kernel_param{1};
+	/** Number of consecutive entries in the error vector forming each
+	 * residual, whose squared norm is passed to the robust kernel (e.g. 2 for
+	 * pixel reprojection errors) */
+	size_t residual_size{1};
+
 	/** The type of the function passed to execute. The user must supply a
 	 * function which evaluates the error of a given point in the solution
 	 * space.
@@ -66,6 +107,17 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 		VECTORTYPE& x_new, const VECTORTYPE& x_old, const VECTORTYPE& x_incr,
 		const USERPARAM& user_param)>;
 
+	/** The (row, column) of each entry of the Jacobian (errors by
+	 * parameters) which may be non-zero. Passed to \a executeSparse */
+	using sparsity_pattern_t = std::vector<std::pair<size_t, size_t>>;
+
+	/** The type of an optional functor passed to \a executeSparse to
+	 * evaluate the Jacobian at a given point: it must fill \a out_values with
+	 * the value of each entry of the sparsity pattern, in the same order. */
+	using TFunctorJacobian = std::function<void(
+		const VECTORTYPE& x, const USERPARAM& y,
+		std::vector<NUMTYPE>& out_values)>;
+
 	struct TResultInfo
 	{
 		NUMTYPE final_sqr_err;
@@ -80,6 +132,8 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 		 *  \f[ COV = H M H^\top \f]
 		 *  With COV the covariance matrix of the optimal parameters, H this
 		 * matrix, and M the covariance of the input (observations).
+		 *
+		 * \note Left empty by executeSparse().
 		 */
 		matrix_t H;
 	};
@@ -108,34 +162,465 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 		const NUMTYPE e1 = 1e-8, const NUMTYPE e2 = 1e-8,
 		bool returnPath = true, TFunctorIncrement x_increment_adder = nullptr)
 	{
-		using namespace mrpt;
-		using namespace mrpt::math;
-		using namespace std;
-
 		MRPT_START
 
 		this->setMinLoggingLevel(verbosity);
 
-		VECTORTYPE& x = out_optimal_x;  // Var rename
-
 		// Asserts:
 		ASSERT_(increments.size() == x0.size());
 
-		x = x0;  // Start with the starting point
-		VECTORTYPE f_x;  // The vector error from the user function
+		mrpt::WorkerThreadsPool pool;
+		if (num_threads != 1) pool.resize(num_threads);
+
 		matrix_t AUX;
 		matrix_t J;  // The Jacobian of "f"
-		VECTORTYPE g;  // The gradient
 
-		// Compute the jacobian and the Hessian:
-		mrpt::math::estimateJacobian(x, functor, increments, userParam, J);
-		out_info.H.multiply_AtA(J);
+		// Compute the jacobian, the Hessian and the gradient:
+		auto linearize = [&](const VECTORTYPE& x, const VECTORTYPE& f_x,
+							 const std::vector<NUMTYPE>& weights,
+							 VECTORTYPE& g) {
+			if (pool.size() == 0)
+				mrpt::math::estimateJacobian(
+					x, functor, increments, userParam, J);
+			else
+				estimateJacobianParallel(
+					x, functor, increments, userParam, f_x.size(), J, pool);
+
+			if (weights.empty())
+			{
+				out_info.H.multiply_AtA(J);
+				J.multiply_Atb(f_x, g);
+			}
+			else
+			{
+				matrix_t WJ = J;
+				for (size_t i = 0; i < weights.size(); i++)
+					WJ.row(i) *= weights[i];
+				out_info.H = J.transpose() * WJ;
+				g = WJ.transpose() * f_x;
+			}
+			return out_info.H.maximumDiagonal();
+		};
+
+		// H_lm = -( H + \lambda I ) ^-1 * g
+		auto solve = [&](const NUMTYPE lambda, const VECTORTYPE& g,
+						 VECTORTYPE& h_lm) {
+			matrix_t H = out_info.H;
+			for (Eigen::Index k = 0; k < H.cols(); k++) H(k, k) += lambda;
+
+			H.inv_fast(AUX);
+			AUX.multiply_Ab(g, h_lm);
+			h_lm *= NUMTYPE(-1.0);
+			return true;
+		};
+
+		runIterations(
+			out_optimal_x, x0, functor, userParam, out_info, maxIter, tau, e1,
+			e2, returnPath, x_increment_adder, linearize, solve);
+
+		MRPT_END
+	}
+
+	/** Executes the LM-method for a problem with a sparse Jacobian.
+	 *
+	 * \a functor is the user-provided function computing the error vector,
+	 * as in execute(). The errors only depend on the parameters given in \a
+	 * jacobian_pattern: a list of (error index, parameter index) pairs.
+	 *
+	 * If \a functor_jacobian is provided, it is used to evaluate the
+	 * Jacobian. Otherwise, the Jacobian is estimated by central finite
+	 * differences with the given \a increments, perturbing at once all the
+	 * parameters which do not share any error, so it takes as many pairs of
+	 * calls to \a functor as the maximum number of parameters some error
+	 * depends on, rather than the number of parameters.
+	 *
+	 * The rest of arguments are as in execute(). TResultInfo::H is not
+	 * filled in.
+	 */
+	void executeSparse(
+		VECTORTYPE& out_optimal_x, const VECTORTYPE& x0, TFunctorEval functor,
+		const sparsity_pattern_t& jacobian_pattern,
+		TFunctorJacobian functor_jacobian, const VECTORTYPE& increments,
+		const USERPARAM& userParam, TResultInfo& out_info,
+		mrpt::system::VerbosityLevel verbosity = mrpt::system::LVL_INFO,
+		const size_t maxIter = 200, const NUMTYPE tau = 1e-3,
+		const NUMTYPE e1 = 1e-8, const NUMTYPE e2 = 1e-8,
+		bool returnPath = true, TFunctorIncrement x_increment_adder = nullptr)
+	{
+		MRPT_START
+
+		this->setMinLoggingLevel(verbosity);
+
+		const size_t N = x0.size();
+		ASSERT_(N > 0);
+		ASSERT_(functor_jacobian || increments.size() == x0.size());
+
+		mrpt::WorkerThreadsPool pool;
+		if (num_threads != 1) pool.resize(num_threads);
+
+		// Sparse structure of the Jacobian, by columns, without duplicates:
+		sparsity_pattern_t entries(jacobian_pattern.size());
+		for (size_t k = 0; k < entries.size(); k++)
+		{
+			ASSERT_BELOW_(jacobian_pattern[k].second, N);
+			entries[k] = std::make_pair(
+				jacobian_pattern[k].second, jacobian_pattern[k].first);
+		}
+		std::sort(entries.begin(), entries.end());
+		entries.erase(
+			std::unique(entries.begin(), entries.end()), entries.end());
+		const size_t nEntries = entries.size();
+
+		// Index into "entries" of each one in the user pattern:
+		std::vector<size_t> user_to_entry(jacobian_pattern.size());
+		for (size_t k = 0; k < jacobian_pattern.size(); k++)
+			user_to_entry[k] = std::lower_bound(
+								   entries.begin(), entries.end(),
+								   std::make_pair(
+									   jacobian_pattern[k].second,
+									   jacobian_pattern[k].first)) -
+							   entries.begin();
+
+		// Number of errors:
+		VECTORTYPE f_x0;
+		functor(x0, userParam, f_x0);
+		const size_t M = f_x0.size();
+		for (const auto& e : entries) ASSERT_BELOW_(e.second, M);
+
+		std::vector<size_t> col_start(N + 1, 0);
+		for (const auto& e : entries) col_start[e.first + 1]++;
+		for (size_t j = 0; j < N; j++) col_start[j + 1] += col_start[j];
+
+		// The entries in each row:
+		std::vector<size_t> row_start(M + 1, 0), row_entries(nEntries);
+		for (const auto& e : entries) row_start[e.second + 1]++;
+		for (size_t i = 0; i < M; i++) row_start[i + 1] += row_start[i];
+		{
+			std::vector<size_t> next(row_start.begin(), row_start.end() - 1);
+			for (size_t k = 0; k < nEntries; k++)
+				row_entries[next[entries[k].second]++] = k;
+		}
+
+		// Groups of parameters which do not share any error, to be perturbed
+		// at once in the finite differences (greedy coloring):
+		std::vector<std::vector<size_t>> groups;
+		if (!functor_jacobian)
+		{
+			const size_t NONE = std::numeric_limits<size_t>::max();
+			std::vector<size_t> group_of(N, NONE);
+			// The last parameter for which each group was found not valid:
+			std::vector<size_t> used_by;
+			for (size_t j = 0; j < N; j++)
+			{
+				for (size_t k = col_start[j]; k < col_start[j + 1]; k++)
+				{
+					const size_t i = entries[k].second;
+					for (size_t r = row_start[i]; r < row_start[i + 1]; r++)
+					{
+						const size_t col = entries[row_entries[r]].first;
+						if (group_of[col] != NONE) used_by[group_of[col]] = j;
+					}
+				}
+				size_t g = 0;
+				while (g < groups.size() && used_by[g] == j) g++;
+				if (g == groups.size())
+				{
+					groups.emplace_back();
+					used_by.push_back(NONE);
+				}
+				group_of[j] = g;
+				groups[g].push_back(j);
+			}
+			MRPT_LOG_DEBUG_FMT(
+				"Jacobian: %u parameters in %u groups",
+				static_cast<unsigned>(N), static_cast<unsigned>(groups.size()));
+		}
+
+		// Structure of the upper triangle of H = J^t * W * J: each entry is
+		// the sum of the products of pairs of entries of J in the same row.
+		// The diagonal is always present, for the damping term:
+		struct TProduct
+		{
+			size_t col, row;  // Of the entry in H
+			size_t a, b;  // Entries of J
+			bool operator<(const TProduct& o) const
+			{
+				return std::tie(col, row, a, b) <
+					   std::tie(o.col, o.row, o.a, o.b);
+			}
+		};
+		const size_t NO_ENTRY = std::numeric_limits<size_t>::max();
+		std::vector<TProduct> products;
+		for (size_t j = 0; j < N; j++)
+			products.push_back({j, j, NO_ENTRY, NO_ENTRY});
+		for (size_t i = 0; i < M; i++)
+			for (size_t r1 = row_start[i]; r1 < row_start[i + 1]; r1++)
+				for (size_t r2 = r1; r2 < row_start[i + 1]; r2++)
+				{
+					// Entries are sorted by column, so a <= b:
+					const size_t a = row_entries[r1], b = row_entries[r2];
+					products.push_back(
+						{entries[b].first, entries[a].first, a, b});
+				}
+		std::sort(products.begin(), products.end());
+
+		std::vector<size_t> H_start;  // Products of each entry of H
+		for (size_t k = 0; k < products.size(); k++)
+			if (k == 0 || products[k].col != products[k - 1].col ||
+				products[k].row != products[k - 1].row)
+				H_start.push_back(k);
+		const size_t nH = H_start.size();
+		H_start.push_back(products.size());
+
+		// The sparse matrix H, with its values set to the index of each
+		// entry, which is then replaced by the index of that entry in the
+		// values of the column-compressed matrix:
+		CSparseMatrix sp_H(N, N);
+		std::vector<size_t> H_value_index(nH);
+		std::vector<size_t> H_diag(N);  // Entry of H in each diagonal
+		for (size_t h = 0; h < nH; h++)
+		{
+			const TProduct& p = products[H_start[h]];
+			sp_H.insert_entry_fast(p.row, p.col, h);
+		}
+		sp_H.compressFromTriplet();
+		{
+			const double* sp_H_values = sp_H.getStoredValues();
+			for (size_t k = 0; k < sp_H.getStoredValuesCount(); k++)
+				H_value_index[static_cast<size_t>(sp_H_values[k])] = k;
+		}
+		for (size_t h = 0; h < nH; h++)
+		{
+			const TProduct& p = products[H_start[h]];
+			if (p.row == p.col) H_diag[p.col] = h;
+		}
+
+		// Symbolic analysis for the Cholesky decomposition, which only depends
+		// on the sparse structure, hence it is reused in all iterations:
+		CSparseMatrix::CholeskyDecomp sp_H_chol(sp_H, true /*symbolic only*/);
+
+		std::vector<NUMTYPE> J_values(nEntries), user_values;
+		std::vector<double> H_values(nH), sp_g(N), sp_h(N);
+
+		auto linearize = [&](const VECTORTYPE& x, const VECTORTYPE& f_x,
+							 const std::vector<NUMTYPE>& weights,
+							 VECTORTYPE& g) {
+			// Jacobian:
+			if (functor_jacobian)
+			{
+				functor_jacobian(x, userParam, user_values);
+				ASSERT_EQUAL_(user_values.size(), jacobian_pattern.size());
+				std::fill(J_values.begin(), J_values.end(), NUMTYPE(0));
+				for (size_t k = 0; k < user_values.size(); k++)
+					J_values[user_to_entry[k]] += user_values[k];
+			}
+			else
+			{
+				pool.parallelForBlocks(
+					groups.size(), 1, [&](size_t first, size_t last) {
+						VECTORTYPE x_mod(x), f_plus, f_minus;
+						for (size_t grp = first; grp < last; grp++)
+						{
+							for (const size_t j : groups[grp])
+								x_mod[j] = x[j] + increments[j];
+							functor(x_mod, userParam, f_plus);
+							for (const size_t j : groups[grp])
+								x_mod[j] = x[j] - increments[j];
+							functor(x_mod, userParam, f_minus);
+							for (const size_t j : groups[grp])
+							{
+								x_mod[j] = x[j];  // Leave as original
+								const NUMTYPE Ax_2_inv = 0.5 / increments[j];
+								for (size_t k = col_start[j];
+									 k < col_start[j + 1]; k++)
+								{
+									const size_t i = entries[k].second;
+									J_values[k] =
+										Ax_2_inv * (f_plus[i] - f_minus[i]);
+								}
+							}
+						}
+					});
+			}
+
+			// H and g = J^t * W * f(x), in parallel by entries/columns:
+			auto blockSize = [&pool](size_t n) {
+				// A few blocks per thread, to balance the load:
+				return std::max<size_t>(64, n / (4 * (1 + pool.size())));
+			};
+			pool.parallelForBlocks(
+				nH, blockSize(nH), [&](size_t first, size_t last) {
+					for (size_t h = first; h < last; h++)
+					{
+						double v = 0;
+						for (size_t k = H_start[h]; k < H_start[h + 1]; k++)
+						{
+							const TProduct& p = products[k];
+							if (p.a == NO_ENTRY) continue;
+							const double w = weights.empty()
+												 ? 1.0
+												 : weights[entries[p.a].second];
+							v += w * J_values[p.a] * J_values[p.b];
+						}
+						H_values[h] = v;
+					}
+				});
+			pool.parallelForBlocks(
+				N, blockSize(N), [&](size_t first, size_t last) {
+					for (size_t j = first; j < last; j++)
+					{
+						double v = 0;
+						for (size_t k = col_start[j]; k < col_start[j + 1]; k++)
+						{
+							const size_t i = entries[k].second;
+							const double w =
+								weights.empty() ? 1.0 : weights[i];
+							v += w * J_values[k] * f_x[i];
+						}
+						sp_g[j] = v;
+					}
+				});
+			g.resize(N);
+			for (size_t j = 0; j < N; j++) g[j] = sp_g[j];
+
+			double maxDiag = 0;
+			for (size_t j = 0; j < N; j++)
+				maxDiag = std::max(maxDiag, H_values[H_diag[j]]);
+			return NUMTYPE(maxDiag);
+		};
+
+		// Solve (H + \lambda I) * h_lm = -g by sparse Cholesky:
+		auto solve = [&](const NUMTYPE lambda, const VECTORTYPE& g,
+						 VECTORTYPE& h_lm) {
+			MRPT_UNUSED_PARAM(g);
+			double* sp_H_values = sp_H.getStoredValues();
+			for (size_t h = 0; h < nH; h++)
+				sp_H_values[H_value_index[h]] = H_values[h];
+			for (size_t j = 0; j < N; j++)
+				sp_H_values[H_value_index[H_diag[j]]] += lambda;
+			try
+			{
+				sp_H_chol.update(sp_H);
+			}
+			catch (CExceptionNotDefPos&)
+			{
+				return false;
+			}
+			sp_H_chol.backsub(&sp_g[0], &sp_h[0], N);
+			h_lm.resize(N);
+			for (size_t j = 0; j < N; j++) h_lm[j] = -sp_h[j];
+			return true;
+		};
+
+		runIterations(
+			out_optimal_x, x0, functor, userParam, out_info, maxIter, tau, e1,
+			e2, returnPath, x_increment_adder, linearize, solve);
+		out_info.H = matrix_t();
 
-		const size_t H_len = out_info.H.cols();
+		MRPT_END
+	}
+
+   protected:
+	/** Square error of the error vector "f", robustified with the kernel in
+	 * \a robust_kernel, and weight of each error in the normal equations
+	 * (left empty for plain least squares). */
+	NUMTYPE computeSquareError(
+		const VECTORTYPE& f, std::vector<NUMTYPE>& weights) const
+	{
+		weights.clear();
+		switch (robust_kernel)
+		{
+			case rkLeastSquares:
+				return std::pow(mrpt::math::norm(f), 2);
+			case rkPseudoHuber:
+				return computeRobustSquareError<rkPseudoHuber>(f, weights);
+			default:
+				THROW_EXCEPTION_FMT(
+					"Unknown robust kernel: %i", static_cast<int>(robust_kernel));
+		}
+	}
+
+	/** Robustified square error and weights, for blocks of  residual_size
+	 * errors each */
+	template <TRobustKernelType KERNEL>
+	NUMTYPE computeRobustSquareError(
+		const VECTORTYPE& f, std::vector<NUMTYPE>& weights) const
+	{
+		ASSERT_(residual_size > 0 && f.size() % residual_size == 0);
+		RobustKernel<KERNEL, NUMTYPE> kernel;
+		kernel.param_sq = robust_kernel_param * robust_kernel_param;
+		weights.resize(f.size());
+		NUMTYPE sqr_err = 0;
+		for (Eigen::Index i = 0; i < f.size(); i += residual_size)
+		{
+			NUMTYPE r2 = 0;
+			for (size_t k = 0; k < residual_size; k++)
+				r2 += f[i + k] * f[i + k];
+			NUMTYPE w, d2;
+			sqr_err += kernel.eval(r2, w, d2);
+			for (size_t k = 0; k < residual_size; k++) weights[i + k] = w;
+		}
+		return sqr_err;
+	}
+
+	/** Like mrpt::math::estimateJacobian(), evaluating the columns of the
+	 * Jacobian in the threads of "pool" */
+	static void estimateJacobianParallel(
+		const VECTORTYPE& x, const TFunctorEval& functor,
+		const VECTORTYPE& increments, const USERPARAM& userParam,
+		const size_t m, matrix_t& J, mrpt::WorkerThreadsPool& pool)
+	{
+		const size_t n = x.size();
+		for (size_t j = 0; j < n; j++) ASSERT_(increments[j] > 0);
+		J.setSize(m, n);
+		pool.parallelForBlocks(n, 1, [&](size_t first, size_t last) {
+			VECTORTYPE x_mod(x), f_plus, f_minus;
+			for (size_t j = first; j < last; j++)
+			{
+				x_mod[j] = x[j] + increments[j];
+				functor(x_mod, userParam, f_plus);
+				x_mod[j] = x[j] - increments[j];
+				functor(x_mod, userParam, f_minus);
+				x_mod[j] = x[j];  // Leave as original
+
+				const NUMTYPE Ax_2_inv = 0.5 / increments[j];
+				for (size_t i = 0; i < m; i++)
+					J(i, j) = Ax_2_inv * (f_plus[i] - f_minus[i]);
+			}
+		});
+	}
+
+	/** The LM iterations, common to the dense and sparse variants:
+	 *  - linearize(x, f_x, weights, g): computes the Jacobian at x, the
+	 * Hessian approximation H, and the gradient g; returns the maximum
+	 * element in the diagonal of H.
+	 *  - solve(lambda, g, h_lm): solves (H + lambda*I)*h_lm = -g; returns
+	 * false if the matrix is not positive definite.
+	 */
+	template <class LINEARIZE, class SOLVE>
+	void runIterations(
+		VECTORTYPE& out_optimal_x, const VECTORTYPE& x0, TFunctorEval& functor,
+		const USERPARAM& userParam, TResultInfo& out_info,
+		const size_t maxIter, const NUMTYPE tau, const NUMTYPE e1,
+		const NUMTYPE e2, bool returnPath, TFunctorIncrement& x_increment_adder,
+		LINEARIZE linearize, SOLVE solve)
+	{
+		using namespace mrpt;
+		using namespace mrpt::math;
+		using namespace std;
+
+		VECTORTYPE& x = out_optimal_x;  // Var rename
+
+		x = x0;  // Start with the starting point
+		VECTORTYPE f_x;  // The vector error from the user function
+		VECTORTYPE g;  // The gradient
+		std::vector<NUMTYPE> weights, weights_new;
 
-		// Compute the gradient:
 		functor(x, userParam, f_x);
-		J.multiply_Atb(f_x, g);
+		NUMTYPE F_x = computeSquareError(f_x, weights);
+
+		// Compute the jacobian, the Hessian and the gradient:
+		const NUMTYPE maxDiagonal = linearize(x, f_x, weights, g);
 
 		// Start iterations:
 		bool found = math::norm_inf(g) <= e1;
@@ -145,13 +630,12 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 				"End condition: math::norm_inf(g)<=e1 :%f\n",
 				math::norm_inf(g));
 
-		NUMTYPE lambda = tau * out_info.H.maximumDiagonal();
+		NUMTYPE lambda = tau * maxDiagonal;
 		size_t iter = 0;
 		NUMTYPE v = 2;
 
 		VECTORTYPE h_lm;
 		VECTORTYPE xnew, f_xnew;
-		NUMTYPE F_x = pow(math::norm(f_x), 2);
 
 		const size_t N = x.size();
 
@@ -166,20 +650,31 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 
 		while (!found && ++iter < maxIter)
 		{
-			// H_lm = -( H + \lambda I ) ^-1 * g
-			matrix_t H = out_info.H;
-			for (size_t k = 0; k < H_len; k++) H(k, k) += lambda;
-
-			H.inv_fast(AUX);
-			AUX.multiply_Ab(g, h_lm);
-			h_lm *= NUMTYPE(-1.0);
+			if (!solve(lambda, g, h_lm))
+			{
+				// Not positive definite: increase lambda and try again
+				logFmt(
+					mrpt::system::LVL_DEBUG,
+					"Iter:%u Non positive definite matrix, retrying with a "
+					"larger lambda\n",
+					(unsigned)iter);
+				lambda *= v;
+				v *= 2;
+				if (returnPath)
+				{
+					out_info.path.block(iter, 0, 1, N) = x.transpose();
+					out_info.path(iter, N) = F_x;
+				}
+				continue;
+			}
 
 			double h_lm_n2 = math::norm(h_lm);
 			double x_n2 = math::norm(x);
 
-			logFmt(
-				mrpt::system::LVL_DEBUG, "Iter:%u x=%s\n", (unsigned)iter,
-				mrpt::containers::sprintf_vector(" %f", x).c_str());
+			if (this->isLoggingLevelVisible(mrpt::system::LVL_DEBUG))
+				logFmt(
+					mrpt::system::LVL_DEBUG, "Iter:%u x=%s\n", (unsigned)iter,
+					mrpt::containers::sprintf_vector(" %f", x).c_str());
 
 			if (h_lm_n2 < e2 * (x_n2 + e2))
 			{
@@ -198,7 +693,7 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 					x_increment_adder(xnew, x, h_lm, userParam);
 
 				functor(xnew, userParam, f_xnew);
-				const double F_xnew = pow(math::norm(f_xnew), 2);
+				const double F_xnew = computeSquareError(f_xnew, weights_new);
 
 				// denom = h_lm^t * ( \lambda * h_lm - g )
 				VECTORTYPE tmp(h_lm);
@@ -214,11 +709,9 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 					x = xnew;
 					f_x = f_xnew;
 					F_x = F_xnew;
+					weights.swap(weights_new);
 
-					math::estimateJacobian(
-						x, functor, increments, userParam, J);
-					out_info.H.multiply_AtA(J);
-					J.multiply_Atb(f_x, g);
+					linearize(x, f_x, weights, g);
 
 					found = math::norm_inf(g) <= e1;
 					if (found)
@@ -250,8 +743,6 @@ class CLevenbergMarquardtTempl : public mrpt::system::COutputLogger
 		out_info.iterations_executed = iter;
 		out_info.last_err_vector = f_x;
 		if (returnPath) out_info.path.setSize(iter, N + 1);
-
-		MRPT_END
 	}
 
 };  // End of class def.
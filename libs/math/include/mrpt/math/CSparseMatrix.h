@@ -411,6 +411,29 @@ class CSparseMatrix
 
 	/** @} */
 
+	/** @name In-place access to the values of column-compressed matrices
+	 *  These methods allow changing the values of a matrix while keeping its
+	 * sparse structure, e.g. to refactorize it with CholeskyDecomp::update()
+	 * without rebuilding it from a triplet.
+		@{ */
+
+	/** ONLY for column-compressed matrices: number of stored values, which
+	 * includes any explicit zeros inserted in the triplet form. */
+	size_t getStoredValuesCount() const;
+
+	/** ONLY for column-compressed matrices: the index of entry (row,col) in
+	 * the array returned by getStoredValues(), or -1 if that entry is not
+	 * part of the sparse structure. Cost is linear in the number of stored
+	 * entries in column `col`. */
+	int getStoredValueIndex(const size_t row, const size_t col) const;
+
+	/** ONLY for column-compressed matrices: the array of
+	 * getStoredValuesCount() stored values, in CSparse order. */
+	double* getStoredValues();
+	const double* getStoredValues() const;
+
+	/** @} */
+
 	/** @name Cholesky factorization
 		@{  */
 
@@ -442,9 +465,9 @@ class CSparseMatrix
 	   private:
 		css* m_symbolic_structure;
 		csn* m_numeric_structure;
-		/** A const reference to the original matrix used to build this
-		 * decomposition. */
-		const CSparseMatrix* m_originalSM;
+		/** Size and number of stored values of the matrix used in the
+		 * symbolic analysis, to check the structure of updates. */
+		size_t m_size, m_storedValues;
 
 	   public:
 		/** Constructor from a square definite-positive sparse matrix A, which
@@ -457,6 +480,15 @@ class CSparseMatrix
 		 * matrix as input.
 		 */
 		CholeskyDecomp(const CSparseMatrix& A);
+
+		/** Constructor which only does the symbolic analysis of A (the
+		 * fill-reducing ordering and elimination tree), which only depends
+		 * on its sparse structure. update() must be called before any other
+		 * method, and then can be called again for each new matrix with the
+		 * same structure, reusing this analysis.
+		 *  \exception std::runtime_error On non-square input matrix.
+		 */
+		CholeskyDecomp(const CSparseMatrix& A, bool symbolicOnly);
 		CholeskyDecomp(const CholeskyDecomp& A) = delete;
 
 		CholeskyDecomp& operator=(const CholeskyDecomp&) = delete;
@@ -496,6 +528,9 @@ class CSparseMatrix
 		 * original input, square definite-positive sparse matrix.
 		 *  NOTE: This new matrix MUST HAVE exactly the same sparse structure
 		 * than the original one.
+		 *  \exception mrpt::math::CExceptionNotDefPos On
+		 * non-definite-positive matrix as input. The symbolic analysis is
+		 * kept, so update() can be called again with another matrix.
 		 */
 		void update(const CSparseMatrix& new_SM);
 	};
@@ -11,7 +11,9 @@
 // nanoflann library:
 #include <nanoflann.hpp>
 #include <mrpt/math/lightweight_geom_data.h>
+#include <algorithm>
 #include <memory>  // unique_ptr
+#include <vector>
 
 namespace mrpt
 {
@@ -60,6 +62,15 @@ namespace math
  *
  * The KD-tree index will be built on demand only upon call of any of the query
  * methods provided by this class.
+ * If the derived class only appends new points, it may call
+ * kdtree_mark_as_appended() instead, so the index can be extended instead of
+ * rebuilt in incremental mode (see TKDTreeSearchParams::incremental).
+ *
+ * Since building, rebuilding or extending the index happens lazily within
+ * the first query after a change, concurrent queries are only safe once the
+ * index is up to date: call kdTreeEnsureIndexBuilt2D() or
+ * kdTreeEnsureIndexBuilt3D() after changing or appending points and before
+ * querying from several threads.
  *
  *  Notice that there is only ONE internal cached KD-tree, so if a method to
  * query a 2D point is called,
@@ -94,9 +105,17 @@ class KDTreeCapable
 	inline Derived& derived() { return *static_cast<Derived*>(this); }
 	struct TKDTreeSearchParams
 	{
-		TKDTreeSearchParams() : leaf_max_size(10) {}
+		TKDTreeSearchParams() : leaf_max_size(10), incremental(false) {}
 		/** Max points per leaf */
 		size_t leaf_max_size;
+		/** If true, points appended to the data set (see
+		 * kdtree_mark_as_appended()) are indexed in a new tree, which is
+		 * merged with the most recent ones while they are smaller than twice
+		 * its size, instead of rebuilding the whole index. Each point is then
+		 * reindexed O(log N) times, and a query visits O(log N) trees.
+		 * Recommended for maps that grow little by little between queries.
+		 * (Default=false) */
+		bool incremental;
 	};
 
 	/** Parameters to tune the ANN searches */
@@ -136,11 +155,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -164,11 +180,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		return ret_index;
 		MRPT_END
@@ -238,11 +251,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x1 = derived().kdtree_get_pt(ret_indexes[0], 0);
@@ -307,11 +317,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -369,11 +376,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[2] = {x0, y0};
+		kdtree_find_neighbors(m_kdtree2d_data, resultSet, query_point);
 		MRPT_END
 	}
 
@@ -419,12 +423,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -449,12 +449,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		return ret_index;
 		MRPT_END
@@ -515,12 +511,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -573,12 +565,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -634,9 +622,12 @@ class KDTreeCapable
 		if (m_kdtree3d_data.m_num_points != 0)
 		{
 			const num_t xyz[3] = {x0, y0, z0};
-			m_kdtree3d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+				maxRadiusSqr, out_indices_dist);
+			kdtree_find_neighbors(m_kdtree3d_data, resultSet, xyz);
+			std::sort(
+				out_indices_dist.begin(), out_indices_dist.end(),
+				nanoflann::IndexDist_Sorter());
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -668,9 +659,12 @@ class KDTreeCapable
 		if (m_kdtree2d_data.m_num_points != 0)
 		{
 			const num_t xyz[2] = {x0, y0};
-			m_kdtree2d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+				maxRadiusSqr, out_indices_dist);
+			kdtree_find_neighbors(m_kdtree2d_data, resultSet, xyz);
+			std::sort(
+				out_indices_dist.begin(), out_indices_dist.end(),
+				nanoflann::IndexDist_Sorter());
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -707,12 +701,8 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
-			nanoflann::SearchParams());
+		const num_t query_point[3] = {x0, y0, z0};
+		kdtree_find_neighbors(m_kdtree3d_data, resultSet, query_point);
 		MRPT_END
 	}
 
@@ -725,6 +715,17 @@ class KDTreeCapable
 			static_cast<float>(p0.z), N, outIdx, outDistSqr);
 	}
 
+	/** Builds the 2D KD-tree index now, if it is not up to date.
+	 * Once built, and while the data points do not change, the 2D query
+	 * methods can be safely called from several threads at once.
+	 * \sa kdTreeEnsureIndexBuilt3D */
+	inline void kdTreeEnsureIndexBuilt2D() const { rebuild_kdTree_2D(); }
+	/** Builds the 3D KD-tree index now, if it is not up to date.
+	 * Once built, and while the data points do not change, the 3D query
+	 * methods can be safely called from several threads at once.
+	 * \sa kdTreeEnsureIndexBuilt2D */
+	inline void kdTreeEnsureIndexBuilt3D() const { rebuild_kdTree_3D(); }
+
 	/* @} */
 
    protected:
@@ -734,7 +735,71 @@ class KDTreeCapable
 		m_kdtree_is_uptodate = false;
 	}
 
+	/** To be called by child classes instead of kdtree_mark_as_outdated()
+	 * when new points have been appended at the end of the data set, and the
+	 * existing ones are unchanged. In incremental mode (see
+	 * TKDTreeSearchParams::incremental) the index is then extended instead of
+	 * rebuilt. As with any change, this happens within the next query, which
+	 * must not run concurrently with others (see kdTreeEnsureIndexBuilt3D()).
+	 */
+	inline void kdtree_mark_as_appended() const
+	{
+		if (!kdtree_search_params.incremental) m_kdtree_is_uptodate = false;
+	}
+
    private:
+	/** Exposes the data points [first,first+count) of the derived class to
+	 * nanoflann, for the sub-trees of the incremental index. */
+	struct TRangeAdaptor
+	{
+		const Derived* data;
+		size_t first, count;
+
+		inline size_t kdtree_get_point_count() const { return count; }
+		inline num_t kdtree_get_pt(const size_t idx, int dim) const
+		{
+			return data->kdtree_get_pt(first + idx, dim);
+		}
+		inline num_t kdtree_distance(
+			const num_t* p1, const size_t idx_p2, size_t size) const
+		{
+			return data->kdtree_distance(p1, first + idx_p2, size);
+		}
+		template <typename BBOX>
+		bool kdtree_get_bbox(BBOX&) const
+		{
+			return false;
+		}
+	};
+
+	/** metric_t, for a different data source type */
+	template <class METRIC, class DATASOURCE>
+	struct TRebindMetric;
+	template <
+		template <class, class, class> class METRIC, class T, class D,
+		class DIST, class DATASOURCE>
+	struct TRebindMetric<METRIC<T, D, DIST>, DATASOURCE>
+	{
+		using type = METRIC<T, DATASOURCE, DIST>;
+	};
+
+	/** Forwards the points found in a sub-tree of the incremental index to
+	 * a nanoflann result set, translating their indices. */
+	template <class RESULTSET>
+	struct TOffsetResultSet
+	{
+		RESULTSET& result;
+		size_t offset;
+
+		inline size_t size() const { return result.size(); }
+		inline bool full() const { return result.full(); }
+		inline num_t worstDist() const { return result.worstDist(); }
+		inline void addPoint(num_t dist, size_t index)
+		{
+			result.addPoint(dist, index + offset);
+		}
+	};
+
 	/** Internal structure with the KD-tree representation (mainly used to avoid
 	 * copying pointers with the = operator) */
 	template <int _DIM = -1>
@@ -755,16 +820,47 @@ class KDTreeCapable
 		}
 
 		/** Free memory (if allocated)  */
-		inline void clear() noexcept { index.reset(); }
+		inline void clear() noexcept
+		{
+			index.reset();
+			forest.clear();
+			m_num_points = 0;
+		}
 		using kdtree_index_t =
 			nanoflann::KDTreeSingleIndexAdaptor<metric_t, Derived, _DIM>;
 
 		/** nullptr or the up-to-date index */
 		std::unique_ptr<kdtree_index_t> index;
 
-		std::vector<num_t> query_point;
+		/** A tree of the incremental index, over a range of points */
+		struct TSubTree
+		{
+			using index_t = nanoflann::KDTreeSingleIndexAdaptor<
+				typename TRebindMetric<metric_t, TRangeAdaptor>::type,
+				TRangeAdaptor, _DIM>;
+
+			TSubTree(
+				const Derived& data, size_t first, size_t count,
+				size_t leaf_max_size)
+				: points{&data, first, count},
+				  index(
+					  _DIM, points,
+					  nanoflann::KDTreeSingleIndexAdaptorParams(
+						  leaf_max_size))
+			{
+				index.buildIndex();
+			}
+			TRangeAdaptor points;
+			index_t index;
+		};
+		/** In incremental mode, the index is made of trees of consecutive
+		 * ranges of points, each one at least twice as large as the next
+		 * one. */
+		std::vector<std::unique_ptr<TSubTree>> forest;
+
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
+		/** Number of indexed points */
 		size_t m_num_points = 0;
 	};
 
@@ -776,72 +872,83 @@ class KDTreeCapable
 
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
-	void rebuild_kdTree_2D() const
+	template <int _DIM>
+	void rebuild_kdTree(TKDTreeDataHolder<_DIM>& kd) const
 	{
-		using tree2d_t = typename TKDTreeDataHolder<2>::kdtree_index_t;
+		using tree_t = typename TKDTreeDataHolder<_DIM>::kdtree_index_t;
+		using subtree_t = typename TKDTreeDataHolder<_DIM>::TSubTree;
 
 		if (!m_kdtree_is_uptodate)
 		{
 			m_kdtree2d_data.clear();
 			m_kdtree3d_data.clear();
 			m_kdtreeNd_data.clear();
+			m_kdtree_is_uptodate = true;
 		}
 
-		if (!m_kdtree2d_data.index)
+		if (kdtree_search_params.incremental)
 		{
-			// Erase previous tree:
-			m_kdtree2d_data.clear();
-			// And build new index:
 			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree2d_data.m_num_points = N;
-			m_kdtree2d_data.m_dim = 2;
-			m_kdtree2d_data.query_point.resize(2);
-			if (N)
+			// Built in non-incremental mode, or points were removed:
+			if (kd.index || N < kd.m_num_points) kd.clear();
+			if (N == kd.m_num_points) return;
+
+			// Index the new points in a new tree, merged with the newest
+			// existing ones while they are not twice as large:
+			size_t first = kd.m_num_points;
+			while (!kd.forest.empty() &&
+				   kd.forest.back()->points.count < 2 * (N - first))
 			{
-				m_kdtree2d_data.index.reset(new tree2d_t(
-					2, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size)));
-				m_kdtree2d_data.index->buildIndex();
+				first = kd.forest.back()->points.first;
+				kd.forest.pop_back();
 			}
-			m_kdtree_is_uptodate = true;
+			kd.forest.emplace_back(new subtree_t(
+				derived(), first, N - first,
+				kdtree_search_params.leaf_max_size));
+			kd.m_num_points = N;
+			kd.m_dim = _DIM;
+			return;
 		}
-	}
-
-	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
-	/// asking the child class for the data points.
-	void rebuild_kdTree_3D() const
-	{
-		using tree3d_t = typename TKDTreeDataHolder<3>::kdtree_index_t;
 
-		if (!m_kdtree_is_uptodate)
-		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
-			m_kdtreeNd_data.clear();
-		}
-
-		if (!m_kdtree3d_data.index)
+		if (!kd.index)
 		{
 			// Erase previous tree:
-			m_kdtree3d_data.clear();
+			kd.clear();
 			// And build new index:
 			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree3d_data.m_num_points = N;
-			m_kdtree3d_data.m_dim = 3;
-			m_kdtree3d_data.query_point.resize(3);
+			kd.m_num_points = N;
+			kd.m_dim = _DIM;
 			if (N)
 			{
-				m_kdtree3d_data.index.reset(new tree3d_t(
-					3, derived(),
+				kd.index.reset(new tree_t(
+					_DIM, derived(),
 					nanoflann::KDTreeSingleIndexAdaptorParams(
 						kdtree_search_params.leaf_max_size)));
-				m_kdtree3d_data.index->buildIndex();
+				kd.index->buildIndex();
 			}
-			m_kdtree_is_uptodate = true;
 		}
 	}
-
+	void rebuild_kdTree_2D() const { rebuild_kdTree(m_kdtree2d_data); }
+	void rebuild_kdTree_3D() const { rebuild_kdTree(m_kdtree3d_data); }
+
+	/** Runs a nanoflann search over the whole index (single or incremental)
+	 * of the given dimensionality. */
+	template <int _DIM, class RESULTSET>
+	void kdtree_find_neighbors(
+		const TKDTreeDataHolder<_DIM>& kd, RESULTSET& result,
+		const num_t* query_point) const
+	{
+		if (kd.index)
+			kd.index->findNeighbors(
+				result, query_point, nanoflann::SearchParams());
+		for (const auto& tree : kd.forest)
+		{
+			TOffsetResultSet<RESULTSET> treeResult{result,
+												   tree->points.first};
+			tree->index.findNeighbors(
+				treeResult, query_point, nanoflann::SearchParams());
+		}
+	}
 };  // end of KDTreeCapable
 
 /**  @} */  // end of grouping
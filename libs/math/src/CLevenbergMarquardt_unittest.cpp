@@ -0,0 +1,206 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/math/CLevenbergMarquardt.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::math;
+using namespace std;
+
+using lm_t = CLevenbergMarquardt;
+
+// Chain of N parameters, with errors in the difference of consecutive ones
+// and a non-linear error in each one, with the solution x_i = sin(i):
+static void chainErrors(
+	const CVectorDouble& x, const CVectorDouble& y, CVectorDouble& out_f)
+{
+	MRPT_UNUSED_PARAM(y);
+	const size_t N = x.size();
+	out_f.resize(2 * N - 1);
+	for (size_t i = 0; i < N; i++)
+	{
+		const double gt = std::sin(double(i));
+		out_f[i] = 0.1 * x[i] * x[i] + x[i] - (0.1 * gt * gt + gt);
+		if (i + 1 < N)
+			out_f[N + i] = x[i + 1] - x[i] - (std::sin(i + 1.0) - gt);
+	}
+}
+
+static lm_t::sparsity_pattern_t chainPattern(size_t N)
+{
+	lm_t::sparsity_pattern_t pattern;
+	for (size_t i = 0; i < N; i++)
+	{
+		pattern.emplace_back(i, i);
+		if (i + 1 < N)
+		{
+			pattern.emplace_back(N + i, i);
+			pattern.emplace_back(N + i, i + 1);
+		}
+	}
+	return pattern;
+}
+
+static void chainJacobian(
+	const CVectorDouble& x, const CVectorDouble& y, std::vector<double>& out)
+{
+	MRPT_UNUSED_PARAM(y);
+	const size_t N = x.size();
+	out.clear();
+	for (size_t i = 0; i < N; i++)
+	{
+		out.push_back(0.2 * x[i] + 1);
+		if (i + 1 < N)
+		{
+			out.push_back(-1);
+			out.push_back(1);
+		}
+	}
+}
+
+static CVectorDouble chainInitialGuess(size_t N)
+{
+	CVectorDouble x0(N);
+	for (size_t i = 0; i < N; i++)
+		x0[i] = std::sin(double(i)) + 0.3 * std::cos(3.0 * i);
+	return x0;
+}
+
+static CVectorDouble chainIncrements(size_t N)
+{
+	CVectorDouble incrs(N);
+	incrs.setConstant(1e-5);
+	return incrs;
+}
+
+static void checkChainSolution(const CVectorDouble& x)
+{
+	for (Eigen::Index i = 0; i < x.size(); i++)
+		EXPECT_NEAR(x[i], std::sin(double(i)), 1e-6) << "i=" << i;
+}
+
+TEST(CLevenbergMarquardt, DenseChain)
+{
+	const size_t N = 20;
+	for (size_t num_threads : {1, 4})
+	{
+		lm_t lm;
+		lm.num_threads = num_threads;
+		lm_t::TResultInfo info;
+		CVectorDouble x, y;
+		lm.execute(
+			x, chainInitialGuess(N), &chainErrors, chainIncrements(N), y, info,
+			mrpt::system::LVL_ERROR);
+		checkChainSolution(x);
+		EXPECT_LT(info.final_sqr_err, 1e-12);
+		EXPECT_EQ(info.H.rows(), int(N));
+	}
+}
+
+TEST(CLevenbergMarquardt, SparseChain)
+{
+	const size_t N = 500;
+
+	// Numerical Jacobian, with 1 and 4 threads:
+	for (size_t num_threads : {1, 4})
+	{
+		std::atomic<size_t> nCalls(0);
+		auto counted = [&nCalls](
+						   const CVectorDouble& x, const CVectorDouble& y,
+						   CVectorDouble& out_f) {
+			nCalls++;
+			chainErrors(x, y, out_f);
+		};
+
+		lm_t lm;
+		lm.num_threads = num_threads;
+		lm_t::TResultInfo info;
+		CVectorDouble x, y;
+		lm.executeSparse(
+			x, chainInitialGuess(N), counted, chainPattern(N), nullptr,
+			chainIncrements(N), y, info, mrpt::system::LVL_ERROR);
+		checkChainSolution(x);
+		EXPECT_LT(info.final_sqr_err, 1e-12);
+
+		// Parameters not sharing errors are perturbed at once, so each
+		// Jacobian takes just a few evaluations:
+		EXPECT_LT(nCalls.load(), 20 * (info.iterations_executed + 1));
+	}
+
+	// Analytical Jacobian:
+	{
+		lm_t lm;
+		lm_t::TResultInfo info;
+		CVectorDouble x, y;
+		lm.executeSparse(
+			x, chainInitialGuess(N), &chainErrors, chainPattern(N),
+			&chainJacobian, CVectorDouble(), y, info, mrpt::system::LVL_ERROR);
+		checkChainSolution(x);
+		EXPECT_LT(info.final_sqr_err, 1e-12);
+	}
+}
+
+// Line fit y = a*t + b with some outliers:
+static void lineErrors(
+	const CVectorDouble& x, const CVectorDouble& ts, CVectorDouble& out_f)
+{
+	out_f.resize(ts.size());
+	for (Eigen::Index i = 0; i < ts.size(); i++)
+	{
+		double y = 2.0 * ts[i] + 1.0 + 0.01 * std::sin(10.0 * i);
+		if (i % 10 == 3) y += 5.0;  // Outlier
+		out_f[i] = x[0] * ts[i] + x[1] - y;
+	}
+}
+
+TEST(CLevenbergMarquardt, RobustKernel)
+{
+	CVectorDouble ts(50);
+	for (Eigen::Index i = 0; i < ts.size(); i++) ts[i] = 0.1 * i;
+	CVectorDouble x0(2), incrs(2);
+	x0.setZero();
+	incrs.setConstant(1e-5);
+	const lm_t::sparsity_pattern_t pattern = [&]() {
+		lm_t::sparsity_pattern_t p;
+		for (Eigen::Index i = 0; i < ts.size(); i++)
+		{
+			p.emplace_back(i, 0);
+			p.emplace_back(i, 1);
+		}
+		return p;
+	}();
+
+	lm_t lm;
+	lm_t::TResultInfo info;
+	CVectorDouble x_ls, x_robust, x_robust_sparse;
+	lm.execute(x_ls, x0, &lineErrors, incrs, ts, info, mrpt::system::LVL_ERROR);
+
+	lm.robust_kernel = rkPseudoHuber;
+	lm.robust_kernel_param = 0.05;
+	lm.execute(
+		x_robust, x0, &lineErrors, incrs, ts, info, mrpt::system::LVL_ERROR);
+	lm.executeSparse(
+		x_robust_sparse, x0, &lineErrors, pattern, nullptr, incrs, ts, info,
+		mrpt::system::LVL_ERROR);
+
+	// Outliers pull the least-squares solution away, not the robust one:
+	EXPECT_GT(std::abs(x_ls[1] - 1.0), 0.3);
+	EXPECT_NEAR(x_robust[0], 2.0, 0.05);
+	EXPECT_NEAR(x_robust[1], 1.0, 0.05);
+	EXPECT_NEAR(x_robust_sparse[0], x_robust[0], 1e-4);
+	EXPECT_NEAR(x_robust_sparse[1], x_robust[1], 1e-4);
+
+	// Unknown kernels are not silently replaced by another one:
+	lm.robust_kernel = static_cast<TRobustKernelType>(100);
+	EXPECT_ANY_THROW(lm.execute(
+		x_robust, x0, &lineErrors, incrs, ts, info, mrpt::system::LVL_ERROR));
+}
@@ -42,9 +42,9 @@ void CMatrixD::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 
 			setSize(nRows, nCols);
 
+			// Row-major storage: all rows are contiguous.
 			if (nRows > 0 && nCols > 0)
-				for (Index i = 0; i < rows(); i++)
-					in.ReadBufferFixEndianness<Scalar>(&coeffRef(i, 0), nCols);
+				in.ReadBufferFixEndianness<Scalar>(data(), size());
 		}
 		break;
 		default:
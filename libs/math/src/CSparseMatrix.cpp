@@ -344,6 +344,34 @@ bool CSparseMatrix::saveToTextFile_sparse(const std::string& filName)
 	return true;
 }
 
+size_t CSparseMatrix::getStoredValuesCount() const
+{
+	ASSERT_(isColumnCompressed());
+	return sparse_matrix.p[sparse_matrix.n];
+}
+
+int CSparseMatrix::getStoredValueIndex(
+	const size_t row, const size_t col) const
+{
+	ASSERT_(isColumnCompressed());
+	ASSERT_(col < cols());
+	for (int p = sparse_matrix.p[col]; p < sparse_matrix.p[col + 1]; p++)
+		if (sparse_matrix.i[p] == int(row)) return p;
+	return -1;
+}
+
+double* CSparseMatrix::getStoredValues()
+{
+	ASSERT_(isColumnCompressed());
+	return sparse_matrix.x;
+}
+
+const double* CSparseMatrix::getStoredValues() const
+{
+	ASSERT_(isColumnCompressed());
+	return sparse_matrix.x;
+}
+
 // ===============  START OF:   CSparseMatrix::CholeskyDecomp  inner class
 // ==============================
 
@@ -354,24 +382,35 @@ bool CSparseMatrix::saveToTextFile_sparse(const std::string& filName)
 * matrix as input.
 */
 CSparseMatrix::CholeskyDecomp::CholeskyDecomp(const CSparseMatrix& SM)
-	: m_symbolic_structure(nullptr),
-	  m_numeric_structure(nullptr),
-	  m_originalSM(&SM)
+	: CholeskyDecomp(SM, false)
+{
+}
+
+CSparseMatrix::CholeskyDecomp::CholeskyDecomp(
+	const CSparseMatrix& SM, bool symbolicOnly)
+	: m_symbolic_structure(nullptr), m_numeric_structure(nullptr)
 {
 	ASSERT_(SM.cols() == SM.rows());
 	ASSERT_(SM.isColumnCompressed());
 
+	m_size = SM.cols();
+	m_storedValues = SM.getStoredValuesCount();
+
 	// symbolic decomposition:
-	m_symbolic_structure =
-		cs_schol(1 /* order */, &m_originalSM->sparse_matrix);
+	m_symbolic_structure = cs_schol(1 /* order */, &SM.sparse_matrix);
+	ASSERT_(m_symbolic_structure);
 
-	// numeric decomposition:
-	m_numeric_structure =
-		cs_chol(&m_originalSM->sparse_matrix, m_symbolic_structure);
+	if (symbolicOnly) return;
 
+	// numeric decomposition:
+	m_numeric_structure = cs_chol(&SM.sparse_matrix, m_symbolic_structure);
 	if (!m_numeric_structure)
+	{
+		// The destructor is not called if the constructor throws:
+		cs_sfree(m_symbolic_structure);
 		throw mrpt::math::CExceptionNotDefPos(
 			"CSparseMatrix::CholeskyDecomp: Not positive definite matrix.");
+	}
 }
 
 // Destructor:
@@ -384,6 +423,7 @@ CSparseMatrix::CholeskyDecomp::~CholeskyDecomp()
 /** Return the L matrix (L*L' = M), as a dense matrix. */
 void CSparseMatrix::CholeskyDecomp::get_L(CMatrixDouble& L) const
 {
+	ASSERT_(m_numeric_structure);
 	CSparseMatrix::cs2dense(*m_numeric_structure->L, L);
 }
 
@@ -401,6 +441,7 @@ void CSparseMatrix::CholeskyDecomp::backsub(
 	const double* b, double* sol, const size_t N) const
 {
 	ASSERT_(N > 0);
+	ASSERT_(m_numeric_structure);
 	std::vector<double> tmp(N);
 
 	cs_ipvec(
@@ -424,21 +465,16 @@ void CSparseMatrix::CholeskyDecomp::backsub(
 void CSparseMatrix::CholeskyDecomp::update(const CSparseMatrix& new_SM)
 {
 	ASSERTMSG_(
-		m_originalSM->sparse_matrix.nzmax == new_SM.sparse_matrix.nzmax,
+		new_SM.isColumnCompressed() && new_SM.cols() == m_size &&
+			new_SM.getStoredValuesCount() == m_storedValues,
 		"New matrix doesn't have the same sparse structure!");
-	ASSERTMSG_(
-		m_originalSM->sparse_matrix.n == new_SM.sparse_matrix.n,
-		"New matrix doesn't have the same sparse structure!");
-
-	m_originalSM = &new_SM;  // Just copy the reference.
 
 	// Release old data:
 	cs_nfree(m_numeric_structure);
 	m_numeric_structure = nullptr;
 
 	// numeric decomposition:
-	m_numeric_structure =
-		cs_chol(&m_originalSM->sparse_matrix, m_symbolic_structure);
+	m_numeric_structure = cs_chol(&new_SM.sparse_matrix, m_symbolic_structure);
 	if (!m_numeric_structure)
 		throw mrpt::math::CExceptionNotDefPos(
 			"CholeskyDecomp::update: Not positive definite matrix.");
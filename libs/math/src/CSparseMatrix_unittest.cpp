@@ -233,3 +233,55 @@ TEST(SparseMatrix, CholeskyDecomp)
 	const double err = ((Ud.transpose()) - L).array().abs().mean();
 	EXPECT_TRUE(err < 1e-8);
 }
+
+TEST(SparseMatrix, CholeskyDecompUpdateInPlace)
+{
+	CSparseMatrix SM(10, 10);
+	const CMatrixDouble COV1 =
+		mrpt::random::getRandomGenerator()
+			.drawDefinitePositiveMatrix<CMatrixDouble>(6, 0.2, 1.0);
+	const CMatrixDouble COV2 =
+		mrpt::random::getRandomGenerator()
+			.drawDefinitePositiveMatrix<CMatrixDouble>(4, 0.2, 1.0);
+
+	SM.insert_submatrix(0, 0, COV1);
+	SM.insert_submatrix(6, 6, COV2);
+	SM.insert_entry(0, 9, 0.0);  // Explicit zero, kept in the structure
+	SM.compressFromTriplet();
+
+	EXPECT_EQ(SM.getStoredValuesCount(), 6u * 6u + 4u * 4u + 1u);
+	EXPECT_EQ(SM.getStoredValueIndex(9, 0), -1);
+	ASSERT_NE(SM.getStoredValueIndex(0, 9), -1);
+	EXPECT_EQ(SM.getStoredValues()[SM.getStoredValueIndex(0, 9)], 0.0);
+	EXPECT_EQ(SM.getStoredValues()[SM.getStoredValueIndex(2, 3)], COV1(2, 3));
+
+	CSparseMatrix::CholeskyDecomp Chol(SM, true /* symbolic only */);
+
+	for (int k = 0; k < 3; k++)
+	{
+		// Modify values in place, keeping the sparse structure:
+		double* vals = SM.getStoredValues();
+		for (size_t i = 0; i < SM.getStoredValuesCount(); i++) vals[i] *= 2;
+		vals[SM.getStoredValueIndex(0, 9)] = 0.1 * (k + 1);
+
+		Chol.update(SM);
+
+		// Solve a system and check it with the dense matrix (the lower
+		// triangle is not accessed by the sparse decomposition):
+		CMatrixDouble D;
+		SM.get_dense(D);
+		D(9, 0) = D(0, 9);
+
+		Eigen::VectorXd b(10);
+		for (int i = 0; i < 10; i++) b[i] = i + 1;
+		const Eigen::VectorXd x = Chol.backsub(b);
+		const double err = (D * x - b).array().abs().maxCoeff();
+		EXPECT_LT(err, 1e-8);
+	}
+
+	// A non-definite positive matrix keeps the symbolic analysis:
+	SM.getStoredValues()[SM.getStoredValueIndex(0, 0)] = -1;
+	EXPECT_THROW(Chol.update(SM), CExceptionNotDefPos);
+	SM.getStoredValues()[SM.getStoredValueIndex(0, 0)] = 100;
+	EXPECT_NO_THROW(Chol.update(SM));
+}
@@ -10,10 +10,177 @@
 #include <mrpt/math/KDTreeCapable.h>
 #include <mrpt/random.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::random;
 using namespace std;
 
-TEST(KDTreeCapable, test1) { MRPT_TODO("Write me!"); }
+namespace
+{
+// A minimal point cloud that can only grow:
+class TestPoints : public KDTreeCapable<TestPoints>
+{
+   public:
+	std::vector<TPoint3Df> pts;
+
+	void append(size_t n, CRandomGenerator& rng)
+	{
+		for (size_t i = 0; i < n; i++)
+			pts.emplace_back(
+				rng.drawUniform(-10, 10), rng.drawUniform(-10, 10),
+				rng.drawUniform(-1, 1));
+		kdtree_mark_as_appended();
+	}
+	void modify(size_t i, float x)
+	{
+		pts[i].x = x;
+		kdtree_mark_as_outdated();
+	}
+
+	inline size_t kdtree_get_point_count() const { return pts.size(); }
+	inline float kdtree_get_pt(const size_t idx, int dim) const
+	{
+		return dim == 0 ? pts[idx].x : dim == 1 ? pts[idx].y : pts[idx].z;
+	}
+	inline float kdtree_distance(
+		const float* p1, const size_t idx_p2, size_t size) const
+	{
+		float d = 0;
+		for (size_t i = 0; i < size; i++)
+			d += square(p1[i] - kdtree_get_pt(idx_p2, i));
+		return d;
+	}
+	template <typename BBOX>
+	bool kdtree_get_bbox(BBOX&) const
+	{
+		return false;
+	}
+
+	// Brute-force reference: squared distance of the k-th closest point
+	float bruteKthDistSqr(const TPoint3Df& q, size_t k, bool is3D) const
+	{
+		std::vector<float> d;
+		for (const auto& p : pts)
+			d.push_back(
+				square(p.x - q.x) + square(p.y - q.y) +
+				(is3D ? square(p.z - q.z) : 0.f));
+		std::nth_element(d.begin(), d.begin() + k, d.end());
+		return d[k];
+	}
+	size_t bruteCountInRadius(const TPoint3Df& q, float r2, bool is3D) const
+	{
+		size_t n = 0;
+		for (const auto& p : pts)
+			n += (square(p.x - q.x) + square(p.y - q.y) +
+				  (is3D ? square(p.z - q.z) : 0.f)) <= r2;
+		return n;
+	}
+};
+
+void checkAgainstBruteForce(const TestPoints& cloud, CRandomGenerator& rng)
+{
+	const size_t knn = std::min<size_t>(5, cloud.pts.size());
+	for (int i = 0; i < 50; i++)
+	{
+		const TPoint3Df q(
+			rng.drawUniform(-10, 10), rng.drawUniform(-10, 10),
+			rng.drawUniform(-1, 1));
+
+		std::vector<size_t> idx;
+		std::vector<float> d2;
+		cloud.kdTreeNClosestPoint2DIdx(q.x, q.y, knn, idx, d2);
+		for (size_t k = 0; k < knn; k++)
+			EXPECT_FLOAT_EQ(d2[k], cloud.bruteKthDistSqr(q, k, false));
+		cloud.kdTreeNClosestPoint3DIdx(q.x, q.y, q.z, knn, idx, d2);
+		for (size_t k = 0; k < knn; k++)
+		{
+			EXPECT_FLOAT_EQ(d2[k], cloud.bruteKthDistSqr(q, k, true));
+			// Returned indices must be global ones:
+			const auto& p = cloud.pts[idx[k]];
+			EXPECT_FLOAT_EQ(
+				d2[k],
+				square(p.x - q.x) + square(p.y - q.y) + square(p.z - q.z));
+		}
+
+		std::vector<std::pair<size_t, float>> found;
+		cloud.kdTreeRadiusSearch3D(q.x, q.y, q.z, 4.0f, found);
+		EXPECT_EQ(found.size(), cloud.bruteCountInRadius(q, 4.0f, true));
+		for (size_t k = 1; k < found.size(); k++)
+			EXPECT_LE(found[k - 1].second, found[k].second);
+		cloud.kdTreeRadiusSearch2D(q.x, q.y, 4.0f, found);
+		EXPECT_EQ(found.size(), cloud.bruteCountInRadius(q, 4.0f, false));
+	}
+}
+}  // namespace
+
+TEST(KDTreeCapable, incrementalIndexMatchesBruteForce)
+{
+	CRandomGenerator rng(123);
+	TestPoints cloud;
+	cloud.kdtree_search_params.incremental = true;
+
+	// Grow the cloud by chunks of different sizes, querying in between:
+	for (size_t n : {1, 200, 3, 50, 1000, 7, 7, 300})
+	{
+		cloud.append(n, rng);
+		checkAgainstBruteForce(cloud, rng);
+	}
+
+	// Modifications of existing points force a full rebuild:
+	cloud.modify(0, 100.0f);
+	float x, y, d2;
+	cloud.kdTreeClosestPoint2D(100.0f, cloud.pts[0].y, x, y, d2);
+	EXPECT_FLOAT_EQ(x, 100.0f);
+	checkAgainstBruteForce(cloud, rng);
+}
+
+TEST(KDTreeCapable, switchIncrementalMode)
+{
+	CRandomGenerator rng(321);
+	TestPoints cloud;
+	cloud.append(500, rng);
+	checkAgainstBruteForce(cloud, rng);
+
+	cloud.kdtree_search_params.incremental = true;
+	cloud.append(100, rng);
+	checkAgainstBruteForce(cloud, rng);
+
+	cloud.kdtree_search_params.incremental = false;
+	cloud.append(100, rng);
+	checkAgainstBruteForce(cloud, rng);
+}
+
+TEST(KDTreeCapable, concurrentQueries)
+{
+	CRandomGenerator rng(456);
+	TestPoints cloud;
+	cloud.kdtree_search_params.incremental = true;
+	cloud.append(2000, rng);
+	cloud.append(300, rng);
+	cloud.kdTreeEnsureIndexBuilt3D();
+
+	// Queries from several threads must give the serial results:
+	std::vector<TPoint3Df> queries;
+	for (int i = 0; i < 400; i++)
+		queries.emplace_back(
+			rng.drawUniform(-10, 10), rng.drawUniform(-10, 10), 0);
+	std::vector<size_t> serial(queries.size()), parallel(queries.size());
+	float d2;
+	for (size_t i = 0; i < queries.size(); i++)
+		serial[i] = cloud.kdTreeClosestPoint3D(
+			queries[i].x, queries[i].y, queries[i].z, d2);
+
+	std::vector<std::thread> threads;
+	const size_t nThreads = 4;
+	for (size_t t = 0; t < nThreads; t++)
+		threads.emplace_back([&, t]() {
+			float dist2;
+			for (size_t i = t; i < queries.size(); i += nThreads)
+				parallel[i] = cloud.kdTreeClosestPoint3D(
+					queries[i].x, queries[i].y, queries[i].z, dist2);
+		});
+	for (auto& th : threads) th.join();
+	EXPECT_EQ(serial, parallel);
+}
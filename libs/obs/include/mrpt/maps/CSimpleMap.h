@@ -46,10 +46,15 @@ class CSimpleMap : public mrpt::serialization::CSerializable
 	/** \name Map access and modification
 	 * @{ */
 
-	/** Save this object to a .simplemap binary file (compressed with gzip)
-	 * \sa loadFromFile
+	/** Save this object to a .simplemap binary file (compressed with gzip, in
+	 * independent blocks, see CFileGZOutputStream::openBlockCompressed())
+	 * \param lazyLoadable If true, the file is written uncompressed, and with
+	 * the length of each sensory frame, so loadFromFileLazy() can skip them.
+	 * Such files can not be read by MRPT versions older than 2.0.
+	 * \sa loadFromFile, loadFromFileLazy
 	 * \return false on any error. */
-	bool saveToFile(const std::string& filName) const;
+	bool saveToFile(
+		const std::string& filName, bool lazyLoadable = false) const;
 
 	/** Load the contents of this object from a .simplemap binary file (possibly
 	 * compressed with gzip)
@@ -57,6 +62,25 @@ class CSimpleMap : public mrpt::serialization::CSerializable
 	 * \return false on any error. */
 	bool loadFromFile(const std::string& filName);
 
+	/** Like loadFromFile(), but without deserializing the observations of the
+	 * sensory frames, which are loaded from the file upon first access (see
+	 * CSensoryFrame::CreateLazy()), so large maps are quickly loaded.
+	 * Poses are loaded as usual.
+	 * \param maxLoadedFrames Maximum number of frames with their observations
+	 * in memory at once (the least recently accessed ones are freed), or 0
+	 * for no limit. If not 0, it must be at least the number of frames to be
+	 * accessed at once.
+	 * \note Only files saved with saveToFile() with `lazyLoadable=true`
+	 * support lazy loading: others are entirely loaded as with loadFromFile().
+	 * \note Accessing a frame may free the observations of another one,
+	 * invalidating its iterators. The methods of CSensoryFrame are safe, but
+	 * a frame iterated while other threads access the map must be pinned
+	 * with a CSensoryFrame::TObservationsPin.
+	 * \sa loadFromFile
+	 * \return false on any error. */
+	bool loadFromFileLazy(
+		const std::string& filName, size_t maxLoadedFrames = 0);
+
 	/** Returns the count of pairs (pose,sensory data) */
 	size_t size() const;
 	/** Returns size()!=0 */
@@ -205,6 +229,11 @@ class CSimpleMap : public mrpt::serialization::CSerializable
 	/** The stored data */
 	TPosePDFSensFramePairList m_posesObsPairs;
 
+	/** Internal: write and read the lazy-loadable format, see saveToFile()
+	 * and loadFromFileLazy() */
+	class TLazyWriter;
+	class TLazyReader;
+
 };  // End of class def.
 
 }  // namespace maps
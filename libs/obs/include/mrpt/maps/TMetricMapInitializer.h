@@ -136,6 +136,8 @@ class TSetOfMetricMapInitializers : public mrpt::config::CLoadableOptions
 	 *mrpt::maps::CColouredPointsMap map>
 	 *  weightedPointsMap_count=<0 or 1, for creating a
 	 *mrpt::maps::CWeightedPointsMap map>
+	 *  voxelHashPointsMap_count=<Number of mrpt::maps::CVoxelHashPointsMap
+	 *maps>
 	 *
 	 * // ====================================================
 	 * //  Creation Options for OccupancyGridMap ##:
@@ -194,6 +196,12 @@ class TSetOfMetricMapInitializers : public mrpt::config::CLoadableOptions
 	 * [<sectionName>+"_pointsMap_##_likelihoodOpts"]
 	 *  <See CPointsMap::TLikelihoodOptions>
 	 *
+	 * // Voxel Options for mrpt::maps::CVoxelHashPointsMap ##:
+	 * [<sectionName>+"_voxelHashPointsMap_##_voxelOpts"]
+	 *  <See CVoxelHashPointsMap::TVoxelOptions>
+	 *  (its "_insertOpts" and "_likelihoodOpts" sections are those of
+	 *  CSimplePointsMap)
+	 *
 	 *
 	 * // ====================================================
 	 * // Creation Options for CGasConcentrationGridMap2D ##:
@@ -42,6 +42,12 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint;
+	/** Number of threads among which the nearest-neighbor queries are
+	 * distributed, if supported by the map (e.g.
+	 * mrpt::maps::CPointsMap::determineMatching3D()). 1 (default) runs in the
+	 * calling thread, 0 uses one thread per hardware core. The resulting
+	 * correspondences do not depend on this value. */
+	unsigned int numThreads;
 
 	/** Ctor: default values */
 	TMatchingParams()
@@ -51,7 +57,8 @@ struct TMatchingParams
 		  onlyUniqueRobust(false),
 		  decimation_other_map_points(1),
 		  offset_other_map_points(0),
-		  angularDistPivotPoint(0, 0, 0)
+		  angularDistPivotPoint(0, 0, 0),
+		  numThreads(1)
 	{
 	}
 };
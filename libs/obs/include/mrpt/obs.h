@@ -57,6 +57,8 @@ MRPT_WARNING(
 
 // Others:
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/obs/CRawlogPrefetchReader.h>
 #include <mrpt/obs/carmen_log_tools.h>
 #include <mrpt/obs/obs_utils.h>
 
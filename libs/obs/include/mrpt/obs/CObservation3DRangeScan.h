@@ -36,23 +36,39 @@ struct T3DPointsProjectionParams
 	bool takeIntoAccountSensorPoseOnRobot;
 	/** (Default: nullptr) Read takeIntoAccountSensorPoseOnRobot */
 	const mrpt::poses::CPose3D* robotPoseInTheWorld;
-	/** (Default:true) [Only used when `range_is_depth`=true] Whether to use a
-	 * Look-up-table (LUT) to speed up the conversion. It's thread safe in all
-	 * situations <b>except</b> when you call this method from different threads
-	 * <b>and</b> with different camera parameter matrices. In all other cases,
-	 * it is a good idea to left it enabled. */
+	/** (Default:true) Whether to use a look-up-table (LUT) to speed up the
+	 * conversion. LUTs are cached for each set of camera parameters (see
+	 * CObservation3DRangeScan::get_3dproj_lut()), so it is safe and efficient
+	 * to project observations from several cameras, even from different
+	 * threads. */
 	bool PROJ3D_USE_LUT;
-	/** (Default:true) If possible, use SSE2 optimized code. */
+	/** (Default:true) Unused: the projection code is vectorized by the
+	 * compiler where possible. Kept for backwards compatibility. */
 	bool USE_SSE2;
 	/** (Default:true) set to false if you want to preserve the organization of
 	 * the point cloud */
 	bool MAKE_DENSE;
+	/** (Default:1) Only project one every `decimation` rows and columns of the
+	 * range image. With MAKE_DENSE=false, the organized point cloud has the
+	 * size of the decimated image. */
+	unsigned int decimation;
+	/** (Default:0=disabled) If >0, only the first point (in row-major order)
+	 * within each cubic voxel of this size (in meters, in sensor-centric
+	 * coordinates) is kept. With MAKE_DENSE=false, the rest are set as invalid
+	 * points. */
+	float voxelSize;
+	/** (Default:1) Number of threads projecting blocks of rows in parallel. 0
+	 * means as many threads as CPU cores. The result does not depend on it. */
+	unsigned int numThreads;
 	T3DPointsProjectionParams()
 		: takeIntoAccountSensorPoseOnRobot(false),
 		  robotPoseInTheWorld(nullptr),
 		  PROJ3D_USE_LUT(true),
 		  USE_SSE2(true),
-		  MAKE_DENSE(true)
+		  MAKE_DENSE(true),
+		  decimation(1),
+		  voxelSize(0),
+		  numThreads(1)
 	{
 	}
 };
@@ -85,6 +101,37 @@ struct T3DPointsTo2DScanParams
 
 namespace detail
 {
+/** Points projected by projectRangeImage(), for internal use within
+ * project3DPointsFromDepthImageInto(). Points are stored by rows of the
+ * (decimated) range image: those of row `r` are at indices
+ * `[r*rowStride, r*rowStride+rowCount[r])`. */
+struct TProjectedRangeImage
+{
+	/** Coordinates of points */
+	std::vector<float> x, y, z;
+	/** (x,y) pixel coordinates of each point in the range image */
+	std::vector<uint16_t> idxs_x, idxs_y;
+	/** Whether each point is valid. Only filled if MAKE_DENSE=false. */
+	std::vector<uint8_t> valid;
+	/** Colors of points. Only filled if colors were requested and the
+	 * observation has an intensity image. */
+	std::vector<uint8_t> R, G, B;
+	/** Number of points of each row, and distance between rows */
+	std::vector<size_t> rowCount;
+	size_t rowStride{0};
+	/** Total number of points */
+	size_t size{0};
+};
+/** Projects the range image of an observation into 3D points, with all the
+ * stages of project3DPointsFromDepthImageInto() (filters, decimation, voxel
+ * filter, colors, and 6D transformation). The returned buffer is owned by the
+ * calling thread, and is valid until its next call to this function. */
+const TProjectedRangeImage& projectRangeImage(
+	const mrpt::obs::CObservation3DRangeScan& src_obs,
+	const mrpt::obs::T3DPointsProjectionParams& projectParams,
+	const mrpt::obs::TRangeImageFilterParams& filterParams,
+	bool computeColors);
+
 // Implemented in CObservation3DRangeScan_project3D_impl.h
 template <class POINTMAP>
 void project3DPointsFromDepthImageInto(
@@ -783,12 +830,20 @@ class CObservation3DRangeScan : public CObservation
 	/** Look-up-table struct for project3DPointsFromDepthImageInto() */
 	struct TCached3DProjTables
 	{
-		mrpt::math::CVectorFloat Kzs, Kys;
-		mrpt::img::TCamera prev_camParams;
+		/** Camera parameters and range image size of this LUT */
+		mrpt::img::TCamera camParams;
+		int width{0}, height{0};
+		/** For each pixel, `Ky=(cx-c)/fx`, `Kz=(cy-r)/fy`, and
+		 * `sqrt(1+Ky^2+Kz^2)` (the latter for `range_is_depth`=false) */
+		mrpt::math::CVectorFloat Kzs, Kys, Knorms;
 	};
-	/** 3D point cloud projection look-up-table \sa
-	 * project3DPointsFromDepthImage */
-	static TCached3DProjTables& get_3dproj_lut();
+	/** Returns the 3D point cloud projection look-up-table for the given
+	 * camera parameters and range image size, building it the first time.
+	 * The most recently used tables are cached, so several cameras can share
+	 * the cache without rebuilding them. Thread safe.
+	 * \sa project3DPointsFromDepthImageInto */
+	static std::shared_ptr<const TCached3DProjTables> get_3dproj_lut(
+		const mrpt::img::TCamera& camParams, int width, int height);
 
 };  // End of class def.
 
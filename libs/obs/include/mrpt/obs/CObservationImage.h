@@ -75,6 +75,10 @@ class CObservationImage : public CObservation
 		cameraPose = newSensorPose;
 	}
 	void getDescriptionAsText(std::ostream& o) const override;
+	// See base class docs
+	void load() const override;
+	// See base class docs
+	void unload() override;
 
 };  // End of class def.
 
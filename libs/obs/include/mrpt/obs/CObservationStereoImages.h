@@ -131,6 +131,10 @@ class CObservationStereoImages : public mrpt::obs::CObservation
 		cameraPose = mrpt::poses::CPose3DQuat(newSensorPose);
 	}
 	void getDescriptionAsText(std::ostream& o) const override;
+	// See base class docs
+	void load() const override;
+	// See base class docs
+	void unload() override;
 
 	/** Do an efficient swap of all data members of this object with "o". */
 	void swap(CObservationStereoImages& o);
@@ -254,6 +254,10 @@ class CObservationVelodyneScan : public CObservation
 		bool generatePerPointTimestamp{false};
 		/** (Default:false) If `true`, populate the vector azimuth */
 		bool generatePerPointAzimuth{false};
+		/** Number of threads decoding packets in parallel (Default: 1).
+		 * 0 means as many threads as CPU cores. The result does not depend
+		 * on it. */
+		unsigned int numThreads{1};
 	};
 
 	/** Generates the point cloud into the point cloud data fields in \a
@@ -272,6 +276,13 @@ class CObservationVelodyneScan : public CObservation
 	void generatePointCloud(
 		const TGeneratePointCloudParameters& params =
 			TGeneratePointCloudParameters());
+	/** Like generatePointCloud(), but into another point cloud buffer instead
+	 * of \a point_cloud, e.g. to reuse its memory across scans.
+	 * Data are decoded straight into the columns of `dest`, whose previous
+	 * contents are replaced. */
+	void generatePointCloud(
+		TPointCloud& dest, const TGeneratePointCloudParameters& params =
+							   TGeneratePointCloudParameters()) const;
 
 	/** Results for generatePointCloudAlongSE3Trajectory() */
 	struct TGeneratePointCloudSE3Results
@@ -167,6 +167,24 @@ class CRawlog : public mrpt::serialization::CSerializable
 	bool loadFromRawLogFile(
 		const std::string& fileName, bool non_obs_objects_are_legal = false);
 
+	/** Loads only the entries of a rawlog file with timestamps t fulfilling
+	 * time_start <= t < time_end and, if `sensorLabel` is not empty, only the
+	 * observations with that sensor label. The rest of the file is skipped
+	 * without deserializing it, by means of its index (see CRawlogIndex). If
+	 * the sidecar index file does not exist or is outdated, it is built (one
+	 * sequential pass over the file) and saved for the next time.
+	 *
+	 * Entries are timestamped as explained in CRawlogIndex::TEntry, and
+	 * objects other than observations, CSensoryFrame and CActionCollection
+	 * are not loaded. The comments of the rawlog are always loaded.
+	 * \returns false upon error reading or accessing the file.
+	 * \sa loadFromRawLogFile
+	 */
+	bool loadFromRawLogFileIndexed(
+		const std::string& fileName, mrpt::system::TTimeStamp time_start,
+		mrpt::system::TTimeStamp time_end,
+		const std::string& sensorLabel = std::string());
+
 	/** Saves the contents to a rawlog-file, compatible with RawlogViewer (As
 	 * the sequence of internal objects).
 	 *  The file is saved with gz-commpressed if MRPT has gz-streams.
@@ -0,0 +1,113 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef CRawlogIndex_H
+#define CRawlogIndex_H
+
+#include <mrpt/serialization/CSerializable.h>
+#include <mrpt/system/datetime.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mrpt
+{
+namespace obs
+{
+/** An index of the entries of a rawlog file, for random access to them
+ * without deserializing the rest of the file.
+ *
+ * For each serialized object in the file, the index records its byte offset
+ * in the (uncompressed) stream, its class name, its timestamp and its sensor
+ * label. Building the index requires one sequential pass over the rawlog
+ * (see buildFromRawlogFile()). Then, it is saved to a sidecar file (by
+ * default, the rawlog file name plus `.idx`, see indexFileNameFor()), along
+ * with the size and modification time of the rawlog, so it can be detected
+ * whether it is outdated (see isUpToDate()).
+ *
+ * Entries are read back with readEntry(), which seeks in the rawlog stream.
+ * Seeking is immediate in uncompressed rawlogs; in gz-compressed ones the
+ * skipped data must still be decompressed, but not deserialized.
+ *
+ * \sa CRawlog::loadFromRawLogFileIndexed()
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogIndex
+{
+   public:
+	/** One entry of the index, for each object in the rawlog file */
+	struct TEntry
+	{
+		/** Position of the object in the uncompressed rawlog stream */
+		uint64_t offset{0};
+		/** Timestamp of the observation, the earliest one of the observations
+		 * in a CSensoryFrame, or of the first action in a CActionCollection.
+		 * INVALID_TIMESTAMP for other classes. */
+		mrpt::system::TTimeStamp timestamp{INVALID_TIMESTAMP};
+		/** Class name of the object (e.g. "CObservation2DRangeScan") */
+		std::string className;
+		/** Sensor label for observations, empty for other classes */
+		std::string sensorLabel;
+	};
+
+	/** All the entries, in the order of the rawlog file */
+	std::vector<TEntry> entries;
+
+	/** Size of the rawlog file the index was built for (bytes) */
+	uint64_t rawlogFileSize{0};
+	/** Modification time of the rawlog file the index was built for */
+	uint64_t rawlogFileModificationTime{0};
+
+	/** The default sidecar index file name for a rawlog: `<rawlog>.idx` */
+	static std::string indexFileNameFor(const std::string& rawlogFile);
+
+	/** Builds the index by reading the whole rawlog file. Reading stops
+	 * silently on EOF or on any deserialization error, as
+	 * CRawlog::loadFromRawLogFile() does.
+	 * \return false if the file cannot be open. */
+	bool buildFromRawlogFile(const std::string& rawlogFile);
+
+	/** Saves the index to a binary file.
+	 * \return false on any error */
+	bool saveToFile(const std::string& indexFile) const;
+	/** Loads the index from a binary file saved with saveToFile().
+	 * \return false on any error, or if it is not a valid index file. */
+	bool loadFromFile(const std::string& indexFile);
+
+	/** Returns true if the size and modification time of the rawlog file are
+	 * those recorded in this index. */
+	bool isUpToDate(const std::string& rawlogFile) const;
+
+	/** Loads the sidecar index of the rawlog file, or builds it (and saves it,
+	 * if `saveIfBuilt` is true) if it does not exist or is outdated.
+	 * \return false if the rawlog file cannot be read. */
+	bool loadOrBuild(const std::string& rawlogFile, bool saveIfBuilt = true);
+
+	/** Returns the indices of the entries with timestamps t fulfilling
+	 * time_start <= t < time_end and, if `sensorLabel` is not empty, with
+	 * that sensor label. Timestamps are not required to be sorted. */
+	std::vector<size_t> findEntries(
+		mrpt::system::TTimeStamp time_start, mrpt::system::TTimeStamp time_end,
+		const std::string& sensorLabel = std::string()) const;
+
+	/** Seeks the rawlog stream to the given entry and deserializes it.
+	 * \exception std::exception If the index is out of bounds, or on any
+	 * reading error. */
+	mrpt::serialization::CSerializable::Ptr readEntry(
+		mrpt::io::CFileGZInputStream& rawlog, size_t index) const;
+
+	/** Number of entries */
+	size_t size() const { return entries.size(); }
+	void clear();
+};
+
+}  // namespace obs
+}  // namespace mrpt
+
+#endif
@@ -0,0 +1,109 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef CRawlogPrefetchReader_H
+#define CRawlogPrefetchReader_H
+
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/obs/CObservation.h>
+#include <mrpt/serialization/CSerializablePool.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace mrpt
+{
+namespace obs
+{
+/** Reads a rawlog file sequentially in a background thread, so the
+ * decompression and deserialization of the next entries overlap with the
+ * processing of the current one.
+ *
+ * A thread reads entries (action/sensory frame pairs or observations, as
+ * CRawlog::getActionObservationPairOrObservation() does) into a queue of at
+ * most TOptions::queueLength entries, and blocks while it is full.
+ * The externally-stored data (e.g. delayed-load images, see
+ * CObservation::load()) of the entries is also loaded in advance, by the
+ * reading thread or by a pool of threads, for heavy data. Entries are
+ * returned in file order and only once fully loaded.
+ *
+ * \code
+ * CRawlogPrefetchReader reader("dataset.rawlog");
+ * CActionCollection::Ptr action;
+ * CSensoryFrame::Ptr sf;
+ * CObservation::Ptr obs;
+ * size_t rawlogEntry = 0;
+ * while (reader.getActionObservationPairOrObservation(
+ *     action, sf, obs, rawlogEntry))
+ * {
+ *   ...
+ * }
+ * \endcode
+ *
+ * \sa CRawlog
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogPrefetchReader
+{
+   public:
+	struct TOptions
+	{
+		TOptions();
+		/** Maximum number of entries read ahead (Default: 16) */
+		std::size_t queueLength;
+		/** Whether to load the externally-stored data of the entries read
+		 * ahead, by calling CObservation::load() (Default: true) */
+		bool loadExternalData;
+		/** Number of threads loading the externally-stored data, if enabled.
+		 * With 0, it is loaded by the reading thread (Default: 0) */
+		std::size_t loadThreads;
+		/** If set, objects are read from this pool of recycled objects, to
+		 * avoid allocations for high-rate observations (Default: none).
+		 * \sa mrpt::serialization::CSerializablePool */
+		std::shared_ptr<mrpt::serialization::CSerializablePool> objectPool;
+	};
+
+	/** Default constructor, without open */
+	CRawlogPrefetchReader();
+	/** Constructor and open
+	 * \exception std::exception If the file cannot be open. */
+	CRawlogPrefetchReader(
+		const std::string& rawlogFile, const TOptions& options = TOptions());
+	/** Dtor: stops reading and closes the file */
+	~CRawlogPrefetchReader();
+
+	CRawlogPrefetchReader(const CRawlogPrefetchReader&) = delete;
+	CRawlogPrefetchReader& operator=(const CRawlogPrefetchReader&) = delete;
+
+	/** Opens a rawlog file and starts reading it in the background.
+	 * \return false if the file cannot be open. */
+	bool open(
+		const std::string& rawlogFile, const TOptions& options = TOptions());
+	/** Stops reading and closes the file */
+	void close();
+	/** Returns true if a file is open */
+	bool isOpen() const;
+
+	/** Returns the next action/sensory frame pair or observation, with the
+	 * same semantics as CRawlog::getActionObservationPairOrObservation(),
+	 * waiting for it to be read if needed. rawlogEntry is set to the number
+	 * of objects read from the file up to this entry.
+	 * \return false at the end of the file or on any read error. */
+	bool getActionObservationPairOrObservation(
+		CActionCollection::Ptr& action, CSensoryFrame::Ptr& observations,
+		CObservation::Ptr& observation, std::size_t& rawlogEntry);
+
+   private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace obs
+}  // namespace mrpt
+#endif
@@ -12,6 +12,8 @@
 #include <mrpt/serialization/CSerializable.h>
 #include <mrpt/maps/CMetricMap.h>
 #include <mrpt/obs/CObservation.h>
+#include <deque>
+#include <memory>
 
 namespace mrpt
 {
@@ -58,7 +60,7 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
    public:
 	/** Default constructor
 	 */
-	CSensoryFrame() = default;
+	CSensoryFrame();
 
 	/** Copy constructor
 	 */
@@ -213,6 +215,7 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	typename T::Ptr getObservationByClass(const size_t& ith = 0) const
 	{
 		MRPT_START
+		const TObservationsPin pin(*this);
 		size_t foundCount = 0;
 		const mrpt::rtti::TRuntimeClassId* class_ID =
 			&T::GetRuntimeClassIdStatic();
@@ -244,7 +247,11 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	  *
 	  * \endcode
 	  */
-	const_iterator begin() const { return m_observations.begin(); }
+	const_iterator begin() const
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.begin();
+	}
 	/** Returns a constant iterator to the end of the list of observations: this
 	  *is an example of usage:
 	  * \code
@@ -257,7 +264,11 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	  *
 	  * \endcode
 	  */
-	const_iterator end() const { return m_observations.end(); }
+	const_iterator end() const
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.end();
+	}
 	/** Returns a iterator to the first observation: this is an example of
 	  *usage:
 	  * \code
@@ -270,7 +281,11 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	  *
 	  * \endcode
 	  */
-	iterator begin() { return m_observations.begin(); }
+	iterator begin()
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.begin();
+	}
 	/** Returns a iterator to the end of the list of observations: this is an
 	  *example of usage:
 	  * \code
@@ -283,11 +298,23 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	  *
 	  * \endcode
 	  */
-	inline iterator end() { return m_observations.end(); }
+	inline iterator end()
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.end();
+	}
 	/** Returns the number of observations in the list. */
-	inline size_t size() const { return m_observations.size(); }
+	inline size_t size() const
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.size();
+	}
 	/** Returns true if there are no observations in the list. */
-	inline bool empty() const { return m_observations.empty(); }
+	inline bool empty() const
+	{
+		if (m_lazy) loadObservations();
+		return m_observations.empty();
+	}
 	/** Removes the i'th observation in the list (0=first). */
 	void eraseByIndex(const size_t& idx);
 
@@ -346,12 +373,106 @@ class CSensoryFrame : public mrpt::serialization::CSerializable
 	  */
 	void swap(CSensoryFrame& sf);
 
+	/** @name Lazy loading of observations
+	 * A frame created with CreateLazy() refers to a CSensoryFrame serialized
+	 * in a file (e.g. one in a CSimpleMap loaded with
+	 * CSimpleMap::loadFromFileLazy()), and its observations are only
+	 * deserialized upon first access through any method of this class.
+	 * All the lazy frames of a file share a budget of frames kept in memory:
+	 * when it is exceeded, the observations of the least recently accessed
+	 * frame are freed (see unloadObservations()), invalidating its iterators.
+	 * Loading and freeing are thread-safe, and frames pinned with a
+	 * TObservationsPin are never freed. The methods of this class pin the
+	 * frame while they use its observations; users iterating a frame while
+	 * other threads access frames of the same file must pin it themselves:
+	 * \code
+	 *   const CSensoryFrame::TObservationsPin pin(*sf);
+	 *   for (const auto& obs : *sf) { ... }
+	 * \endcode
+	 * Any change to the list of observations (insert(), erase(), clear(),...)
+	 * turns a lazy frame into a regular one (see detachFromFile()).
+		@{  */
+
+	/** A file with serialized sensory frames, shared by all the lazy frames
+	 * loaded from it. */
+	struct TLazyFile;
+
+	/** Opens a file to create lazy frames from it with CreateLazy().
+	 * \param maxLoadedFrames Maximum number of frames from this file with
+	 * their observations in memory at once, or 0 for no limit. Otherwise, it
+	 * must be at least the number of frames accessed at once (e.g. 2 to
+	 * compare frames in pairs).
+	 * \exception std::exception If the file cannot be open. */
+	static std::shared_ptr<TLazyFile> OpenLazyFile(
+		const std::string& fileName, size_t maxLoadedFrames = 0);
+
+	/** Creates a frame whose observations are those of the CSensoryFrame
+	 * serialized at the given position of the (uncompressed) file stream,
+	 * which are loaded upon first access. */
+	static Ptr CreateLazy(
+		const std::shared_ptr<TLazyFile>& file, uint64_t offset);
+
+	/** Returns true if this frame was created with CreateLazy() and has not
+	 * been detached from its file yet. */
+	inline bool isLazy() const { return m_lazy != nullptr; }
+
+	/** Returns false only for lazy frames with their observations not in
+	 * memory right now. */
+	bool observationsLoaded() const;
+
+	/** Makes sure the observations of a lazy frame are in memory, marking it
+	 * as the most recently used. Does nothing for regular frames. This is
+	 * automatically called when accessing the observations. */
+	void loadObservations() const;
+
+	/** Frees the observations of a lazy frame, which will be loaded again
+	 * from the file on the next access. Does nothing for regular frames, or
+	 * pinned ones (see TObservationsPin). */
+	void unloadObservations() const;
+
+	/** Keeps the observations of a lazy frame in memory (loading them, if
+	 * needed) while it exists, even if that exceeds the budget of its file:
+	 * the frame is not freed until it is unpinned and the least recently
+	 * used. Does nothing for regular frames. The frame must outlive the pin.
+	 */
+	class TObservationsPin
+	{
+	   public:
+		explicit TObservationsPin(const CSensoryFrame& sf);
+		~TObservationsPin();
+		TObservationsPin(const TObservationsPin&) = delete;
+		TObservationsPin& operator=(const TObservationsPin&) = delete;
+
+	   private:
+		const CSensoryFrame& m_sf;
+	};
+
+	/** Turns a lazy frame into a regular one, loading its observations and
+	 * keeping them in memory from now on. Does nothing for regular frames. */
+	void detachFromFile();
+
+	/** @} */
+
+	/** Destructor */
+	~CSensoryFrame() override;
+
    protected:
 	/** The set of observations taken at the same time instant. See the top of
 	 * this page for instructions on accessing this.
+	 * Mutable since lazy frames (see CreateLazy()) load and free them on
+	 * demand.
 	 */
 	// std::deque<CObservation*>	m_observations;
-	std::deque<CObservation::Ptr> m_observations;
+	mutable std::deque<CObservation::Ptr> m_observations;
+
+	/** Only for lazy frames, see CreateLazy() */
+	struct TLazyState;
+	std::unique_ptr<TLazyState> m_lazy;
+
+	/** Internal: leaves the LRU of the lazy file, without loading */
+	void internal_dropLazy();
+	/** Internal: loadObservations(), optionally pinning the frame */
+	void internal_loadLazy(bool pin) const;
 
 };  // End of class def.
 
@@ -25,7 +25,14 @@
 #include <mrpt/system/string_utils.h>
 #include <mrpt/serialization/stl_serialization.h>
 #include <mrpt/core/bits_mem.h>  // vector_strong_clear
+#include <mrpt/core/round.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <algorithm>
 #include <limits>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 
 using namespace std;
 using namespace mrpt::obs;
@@ -37,12 +44,405 @@ using mrpt::config::CConfigFileMemory;
 // This must be added to any CSerializable class implementation file.
 IMPLEMENTS_SERIALIZABLE(CObservation3DRangeScan, CObservation, mrpt::obs)
 
-// Static LUT:
-static CObservation3DRangeScan::TCached3DProjTables lut_3dproj;
-CObservation3DRangeScan::TCached3DProjTables&
-	CObservation3DRangeScan::get_3dproj_lut()
+// Cache of projection LUTs, the most recently used first:
+static std::mutex lut_3dproj_mtx;
+static std::list<
+	std::shared_ptr<const CObservation3DRangeScan::TCached3DProjTables>>
+	lut_3dproj_cache;
+static const size_t LUT_3DPROJ_CACHE_SIZE = 16;
+
+std::shared_ptr<const CObservation3DRangeScan::TCached3DProjTables>
+	CObservation3DRangeScan::get_3dproj_lut(
+		const mrpt::img::TCamera& camParams, int W, int H)
+{
+	std::lock_guard<std::mutex> lock(lut_3dproj_mtx);
+	for (auto it = lut_3dproj_cache.begin(); it != lut_3dproj_cache.end();
+		 ++it)
+	{
+		const auto& lut = *it;
+		if (lut->width == W && lut->height == H && lut->camParams == camParams)
+		{
+			lut_3dproj_cache.splice(
+				lut_3dproj_cache.begin(), lut_3dproj_cache, it);
+			return lut_3dproj_cache.front();
+		}
+	}
+
+	auto lut = std::make_shared<TCached3DProjTables>();
+	lut->camParams = camParams;
+	lut->width = W;
+	lut->height = H;
+	lut->Kys.resize(W * H);
+	lut->Kzs.resize(W * H);
+	lut->Knorms.resize(W * H);
+
+	const float r_cx = camParams.cx();
+	const float r_cy = camParams.cy();
+	const float r_fx_inv = 1.0f / camParams.fx();
+	const float r_fy_inv = 1.0f / camParams.fy();
+	size_t idx = 0;
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++, idx++)
+		{
+			const float Ky = (r_cx - c) * r_fx_inv;
+			const float Kz = (r_cy - r) * r_fy_inv;
+			lut->Kys[idx] = Ky;
+			lut->Kzs[idx] = Kz;
+			lut->Knorms[idx] = std::sqrt(1 + Ky * Ky + Kz * Kz);
+		}
+
+	lut_3dproj_cache.push_front(lut);
+	if (lut_3dproj_cache.size() > LUT_3DPROJ_CACHE_SIZE)
+		lut_3dproj_cache.pop_back();
+	return lut;
+}
+
+namespace
+{
+/** Worker threads for projecting range images in parallel, shared by all
+ * observations. A request for a different number of threads replaces the
+ * pool instead of resizing it, so callers still using the former one are not
+ * affected. */
+std::shared_ptr<mrpt::WorkerThreadsPool> getProjectionThreadPool(
+	const unsigned int nThreads)
+{
+	static std::mutex poolMtx;
+	static std::shared_ptr<mrpt::WorkerThreadsPool> pool;
+
+	std::lock_guard<std::mutex> lock(poolMtx);
+	if (!pool || pool->size() != nThreads)
+		pool = std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+	return pool;
+}
+
+/** Memory reused by projectRangeImage() between calls, one per thread */
+struct TProjectionBuffers
 {
-	return lut_3dproj;
+	mrpt::obs::detail::TProjectedRangeImage pts;
+	/** Voxel of each point, and set of occupied voxels */
+	std::vector<uint64_t> voxels;
+	std::unordered_set<uint64_t> occupiedVoxels;
+};
+
+/** Same than TRangeImageFilter::do_range_filter(), without branches so
+ * loops calling it can be vectorized. Dmin, Dmax = 0 mean no filter. */
+inline bool passRangeFilter(
+	const float D, const float Dmin, const float Dmax, const bool between)
+{
+	const bool has_min = Dmin != .0f, has_max = Dmax != .0f;
+	const bool pass_gt = !has_min | (D >= Dmin);
+	const bool pass_lt = !has_max | (D <= Dmax);
+	const bool pass_both = pass_gt & pass_lt;
+	const bool pass =
+		(has_min & has_max & !between) ? !pass_both : pass_both;
+	return (D > .0f) & pass;
+}
+
+/** Packs the integer coordinates of the voxel of a point into 3x21 bits */
+inline uint64_t voxelKey(
+	const float x, const float y, const float z, const float invVoxelSize)
+{
+	const auto idx = [invVoxelSize](const float v) {
+		const int64_t i = static_cast<int64_t>(std::floor(v * invVoxelSize));
+		return static_cast<uint64_t>(i + (1 << 20)) & 0x1FFFFF;
+	};
+	return idx(x) | (idx(y) << 21) | (idx(z) << 42);
+}
+}  // namespace
+
+const mrpt::obs::detail::TProjectedRangeImage&
+	mrpt::obs::detail::projectRangeImage(
+		const CObservation3DRangeScan& src_obs,
+		const T3DPointsProjectionParams& projectParams,
+		const TRangeImageFilterParams& filterParams, bool computeColors)
+{
+	// (Lambdas below run in other threads: only use references to buffers)
+	static thread_local TProjectionBuffers thread_buf;
+	TProjectionBuffers& buf = thread_buf;
+	TProjectedRangeImage& out = buf.pts;
+
+	const int W = src_obs.rangeImage.cols();
+	const int H = src_obs.rangeImage.rows();
+	ASSERT_(W != 0 && H != 0);
+	for (const auto mask : {filterParams.rangeMask_min,
+							filterParams.rangeMask_max})
+	{
+		if (!mask) continue;
+		// sanity check:
+		ASSERT_EQUAL_(mask->cols(), src_obs.rangeImage.cols());
+		ASSERT_EQUAL_(mask->rows(), src_obs.rangeImage.rows());
+	}
+
+	const size_t decim = std::max(1U, projectParams.decimation);
+	const size_t nCols = (W + decim - 1) / decim;
+	const size_t nRows = (H + decim - 1) / decim;
+	const size_t maxPts = nCols * nRows;
+	const bool dense = projectParams.MAKE_DENSE;
+	const bool isDepth = src_obs.range_is_depth;
+
+	// ------------------------------------------------------------
+	// Stage 1/3: Create 3D point cloud local coordinates
+	// ------------------------------------------------------------
+	std::shared_ptr<const CObservation3DRangeScan::TCached3DProjTables> lut;
+	if (projectParams.PROJ3D_USE_LUT)
+		lut = CObservation3DRangeScan::get_3dproj_lut(
+			src_obs.cameraParams, W, H);
+	const float r_cx = src_obs.cameraParams.cx();
+	const float r_cy = src_obs.cameraParams.cy();
+	const float r_fx_inv = 1.0f / src_obs.cameraParams.fx();
+	const float r_fy_inv = 1.0f / src_obs.cameraParams.fy();
+
+	const bool withVoxels = projectParams.voxelSize > 0;
+	const float invVoxelSize = withVoxels ? 1.0f / projectParams.voxelSize : 0;
+
+	// -------------------------------------------------------------
+	// Stage 2/3: Project local points into RGB image to get colors
+	// -------------------------------------------------------------
+	const bool withColors = computeColors && src_obs.hasIntensityImage;
+	const mrpt::img::CImage& img = src_obs.intensityImage;
+	const int imgW = withColors ? img.getWidth() : 0;
+	const int imgH = withColors ? img.getHeight() : 0;
+	const bool hasColorIntensityImg = withColors && img.isColor();
+
+	const float cx = src_obs.cameraParamsIntensity.cx();
+	const float cy = src_obs.cameraParamsIntensity.cy();
+	const float fx = src_obs.cameraParamsIntensity.fx();
+	const float fy = src_obs.cameraParamsIntensity.fy();
+
+	// Unless we are in a special case (both depth & RGB images coincide)...
+	const bool isDirectCorresp =
+		withColors && src_obs.doDepthAndIntensityCamerasCoincide();
+
+	// ...precompute the inverse of the pose transformation out of the loop,
+	//  store as a 4x4 homogeneous matrix to exploit SSE optimizations
+	//  below:
+	mrpt::math::CMatrixFixedNumeric<float, 4, 4> T_inv;
+	if (withColors && !isDirectCorresp)
+	{
+		mrpt::math::CMatrixFixedNumeric<double, 3, 3> R_inv;
+		mrpt::math::CMatrixFixedNumeric<double, 3, 1> t_inv;
+		mrpt::math::homogeneousMatrixInverse(
+			src_obs.relativePoseIntensityWRTDepth.getRotationMatrix(),
+			src_obs.relativePoseIntensityWRTDepth.m_coords, R_inv, t_inv);
+
+		T_inv(3, 3) = 1;
+		T_inv.block<3, 3>(0, 0) = R_inv.cast<float>();
+		T_inv.block<3, 1>(0, 3) = t_inv.cast<float>();
+	}
+
+	// ------------------------------------------------------------
+	// Stage 3/3: Apply 6D transformations
+	// ------------------------------------------------------------
+	const bool withTransf = projectParams.takeIntoAccountSensorPoseOnRobot ||
+							projectParams.robotPoseInTheWorld;
+	Eigen::Matrix<float, 4, 4> HM;
+	if (withTransf)
+	{
+		CPose3D transf_to_apply;  // Either ROBOTPOSE or
+		// ROBOTPOSE(+)SENSORPOSE or
+		// SENSORPOSE
+		if (projectParams.takeIntoAccountSensorPoseOnRobot)
+			transf_to_apply = src_obs.sensorPose;
+		if (projectParams.robotPoseInTheWorld)
+			transf_to_apply.composeFrom(
+				*projectParams.robotPoseInTheWorld, CPose3D(transf_to_apply));
+		HM = transf_to_apply.getHomogeneousMatrixVal<CMatrixDouble44>()
+				 .cast<float>();
+	}
+
+	out.x.resize(maxPts);
+	out.y.resize(maxPts);
+	out.z.resize(maxPts);
+	out.idxs_x.resize(maxPts);
+	out.idxs_y.resize(maxPts);
+	out.valid.resize(dense ? 0 : maxPts);
+	out.R.resize(withColors ? maxPts : 0);
+	out.G.resize(withColors ? maxPts : 0);
+	out.B.resize(withColors ? maxPts : 0);
+	buf.voxels.resize(withVoxels ? maxPts : 0);
+	out.rowCount.resize(nRows);
+	out.rowStride = nCols;
+
+	// All stages, for a block of (decimated) rows. The points of each row
+	// are stored from the beginning of its slots in the output vectors.
+	auto projectRows = [&](const size_t firstRow, const size_t lastRow) {
+		Eigen::Matrix<float, 4, 1> pt_wrt_color, pt_wrt_depth, pt_transf;
+		pt_wrt_depth[3] = 1;
+		for (size_t row = firstRow; row < lastRow; row++)
+		{
+			const int r = row * decim;
+			const float* D_ptr = &src_obs.rangeImage.coeffRef(r, 0);
+			const float* Dmin_ptr =
+				filterParams.rangeMask_min
+					? &filterParams.rangeMask_min->coeffRef(r, 0)
+					: nullptr;
+			const float* Dmax_ptr =
+				filterParams.rangeMask_max
+					? &filterParams.rangeMask_max->coeffRef(r, 0)
+					: nullptr;
+			const float* kys = lut ? &lut->Kys[r * W] : nullptr;
+			const float* kzs = lut ? &lut->Kzs[r * W] : nullptr;
+			const float* kns = lut ? &lut->Knorms[r * W] : nullptr;
+
+			const float Kz_row = (r_cy - r) * r_fy_inv;
+			const size_t first = row * nCols;
+			size_t idx = first;
+			// Branch-free, vectorizable filter and projection. Points which
+			// do not pass the filters are overwritten by the next one.
+			for (size_t j = 0; j < nCols; j++)
+			{
+				const int c = j * decim;
+				const float D = D_ptr[c];
+				const bool pass =
+					(Dmin_ptr || Dmax_ptr)
+						? passRangeFilter(
+							  D, Dmin_ptr ? Dmin_ptr[c] : .0f,
+							  Dmax_ptr ? Dmax_ptr[c] : .0f,
+							  filterParams.rangeCheckBetween)
+						: D > .0f;
+				/* range_is_depth = false :
+				 *   x(i) = rangeImage(r,c) / sqrt( 1 + Ky^2 + Kz^2 )
+				 *   y(i) = Ky * x(i)
+				 *   z(i) = Kz * x(i)
+				 */
+				const float Ky = kys ? kys[c] : (r_cx - c) * r_fx_inv;
+				const float Kz = kzs ? kzs[c] : Kz_row;
+				float x = D;
+				if (!isDepth)
+					x /= kns ? kns[c] : std::sqrt(1 + Ky * Ky + Kz * Kz);
+				out.x[idx] = x;
+				out.y[idx] = Ky * D;
+				out.z[idx] = Kz * D;
+				out.idxs_x[idx] = c;
+				out.idxs_y[idx] = r;
+				if (dense)
+					idx += pass;
+				else
+					out.valid[idx++] = pass;
+			}
+
+			// Voxels, colors and transformation of the valid points:
+			if (withVoxels || withColors || withTransf)
+				for (size_t i = first; i < idx; i++)
+				{
+					if (!dense && !out.valid[i]) continue;
+					float &x = out.x[i], &y = out.y[i], &z = out.z[i];
+					if (withVoxels)
+						buf.voxels[i] = voxelKey(x, y, z, invVoxelSize);
+
+					if (withColors)
+					{
+						// projected pixel coordinates, in the RGB image plane
+						int img_idx_x = 0, img_idx_y = 0;
+						bool pointWithinImage = false;
+						if (isDirectCorresp)
+						{
+							pointWithinImage = true;
+							img_idx_x = out.idxs_x[i];
+							img_idx_y = out.idxs_y[i];
+						}
+						else
+						{
+							// Project point, in local coordinates wrt the
+							// depth camera, into the intensity camera:
+							pt_wrt_depth[0] = x;
+							pt_wrt_depth[1] = y;
+							pt_wrt_depth[2] = z;
+							pt_wrt_color = T_inv * pt_wrt_depth;
+
+							// Project to image plane:
+							if (pt_wrt_color[2])
+							{
+								img_idx_x = mrpt::round(
+									cx +
+									fx * pt_wrt_color[0] / pt_wrt_color[2]);
+								img_idx_y = mrpt::round(
+									cy +
+									fy * pt_wrt_color[1] / pt_wrt_color[2]);
+								pointWithinImage =
+									img_idx_x >= 0 && img_idx_x < imgW &&
+									img_idx_y >= 0 && img_idx_y < imgH;
+							}
+						}
+
+						if (!pointWithinImage)
+							out.R[i] = out.G[i] = out.B[i] = 255;
+						else if (hasColorIntensityImg)
+						{
+							const uint8_t* col =
+								img.get_unsafe(img_idx_x, img_idx_y, 0);
+							out.R[i] = col[2];
+							out.G[i] = col[1];
+							out.B[i] = col[0];
+						}
+						else
+							out.R[i] = out.G[i] = out.B[i] =
+								*img.get_unsafe(img_idx_x, img_idx_y, 0);
+					}
+
+					if (withTransf)
+					{
+						pt_wrt_depth[0] = x;
+						pt_wrt_depth[1] = y;
+						pt_wrt_depth[2] = z;
+						pt_transf = HM * pt_wrt_depth;
+						x = pt_transf[0];
+						y = pt_transf[1];
+						z = pt_transf[2];
+					}
+				}
+			out.rowCount[row] = idx - first;
+		}
+	};
+
+	unsigned int nThreads = projectParams.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1 || nRows < 2)
+		projectRows(0, nRows);
+	else
+		getProjectionThreadPool(nThreads)->parallelForBlocks(
+			nRows, (nRows + nThreads - 1) / nThreads, projectRows);
+
+	// Apply the voxel filter, keeping the first point of each voxel:
+	if (withVoxels)
+	{
+		buf.occupiedVoxels.clear();
+		for (size_t row = 0; row < nRows; row++)
+		{
+			const size_t first = row * nCols;
+			size_t n = first;
+			for (size_t i = first; i < first + out.rowCount[row]; i++)
+			{
+				if ((dense || out.valid[i]) &&
+					!buf.occupiedVoxels.insert(buf.voxels[i]).second)
+				{
+					// Not the first point in its voxel:
+					if (dense) continue;
+					out.valid[i] = 0;
+				}
+				if (i != n)
+				{
+					out.x[n] = out.x[i];
+					out.y[n] = out.y[i];
+					out.z[n] = out.z[i];
+					out.idxs_x[n] = out.idxs_x[i];
+					out.idxs_y[n] = out.idxs_y[i];
+					if (!dense) out.valid[n] = out.valid[i];
+					if (withColors)
+					{
+						out.R[n] = out.R[i];
+						out.G[n] = out.G[i];
+						out.B[n] = out.B[i];
+					}
+				}
+				n++;
+			}
+			out.rowCount[row] = n - first;
+		}
+	}
+	out.size = 0;
+	for (const size_t n : out.rowCount) out.size += n;
+	return out;
 }
 
 static bool EXTERNALS_AS_TEXT_value = false;
@@ -475,6 +875,11 @@ void CObservation3DRangeScan::load() const
 			f >> const_cast<CMatrix&>(rangeImage);
 		}
 	}
+
+	if (hasIntensityImage && intensityImage.isExternallyStored())
+		intensityImage.forceLoad();
+	if (hasConfidenceImage && confidenceImage.isExternallyStored())
+		confidenceImage.forceLoad();
 }
 
 void CObservation3DRangeScan::unload()
@@ -10,6 +10,7 @@
 #include <mrpt/obs/CObservation3DRangeScan.h>
 
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace mrpt;
 using namespace std;
@@ -183,3 +184,147 @@ TEST(CObservation3DRangeScan, Project3D_filterMax)
 										   << std::endl;
 	}
 }
+
+TEST(CObservation3DRangeScan, Project3D_sameResultsAllMethods)
+{
+	for (int range_is_depth = 0; range_is_depth < 2; range_is_depth++)
+	{
+		mrpt::obs::T3DPointsProjectionParams pp;
+		mrpt::obs::CObservation3DRangeScan o;
+		fillSampleObs(o, pp, 0);
+		for (int r = 0; r < TEST_RANGEIMG_HEIGHT; r += 3)
+			for (int c = 0; c < TEST_RANGEIMG_WIDTH; c += 2)
+				o.rangeImage(r, c) = 1.0f + 0.1f * (r + c);
+		o.range_is_depth = range_is_depth != 0;
+		o.cameraParams.fx(30);
+		o.cameraParams.fy(31);
+		o.cameraParams.cx(15.5);
+		o.cameraParams.cy(11.5);
+		pp.takeIntoAccountSensorPoseOnRobot = true;
+		o.sensorPose = mrpt::poses::CPose3D(0.1, 0.2, 0.5, 0.3, 0.1, 0.05);
+
+		pp.PROJ3D_USE_LUT = false;
+		o.project3DPointsFromDepthImageInto(o, pp);
+		const auto xs = o.points3D_x, ys = o.points3D_y, zs = o.points3D_z;
+		const auto idxs_x = o.points3D_idxs_x, idxs_y = o.points3D_idxs_y;
+		EXPECT_GT(xs.size(), 21U);
+
+		for (unsigned int nThreads : {1, 2, 5})
+		{
+			pp.PROJ3D_USE_LUT = true;
+			pp.numThreads = nThreads;
+			o.project3DPointsFromDepthImageInto(o, pp);
+			EXPECT_EQ(o.points3D_x, xs);
+			EXPECT_EQ(o.points3D_y, ys);
+			EXPECT_EQ(o.points3D_z, zs);
+			EXPECT_EQ(o.points3D_idxs_x, idxs_x);
+			EXPECT_EQ(o.points3D_idxs_y, idxs_y);
+		}
+	}
+}
+
+TEST(CObservation3DRangeScan, Project3D_concurrentCallers)
+{
+	mrpt::obs::T3DPointsProjectionParams pp;
+	mrpt::obs::CObservation3DRangeScan o;
+	fillSampleObs(o, pp, 1);
+	for (int r = 0; r < TEST_RANGEIMG_HEIGHT; r += 3)
+		for (int c = 0; c < TEST_RANGEIMG_WIDTH; c += 2)
+			o.rangeImage(r, c) = 1.0f + 0.1f * (r + c);
+	o.cameraParams.fx(30);
+	o.cameraParams.fy(31);
+	o.cameraParams.cx(15.5);
+	o.cameraParams.cy(11.5);
+	o.project3DPointsFromDepthImageInto(o, pp);
+	const auto xs = o.points3D_x, ys = o.points3D_y, zs = o.points3D_z;
+
+	// Two threads projecting at once with a different number of threads
+	// each, so they keep asking for differently-sized worker pools:
+	std::vector<bool> allOk(2, true);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < 2; t++)
+		threads.emplace_back([&, t]() {
+			mrpt::obs::CObservation3DRangeScan obs = o;
+			auto params = pp;
+			params.numThreads = t == 0 ? 2 : 5;
+			for (int i = 0; i < 50; i++)
+			{
+				obs.project3DPointsFromDepthImageInto(obs, params);
+				if (obs.points3D_x != xs || obs.points3D_y != ys ||
+					obs.points3D_z != zs)
+					allOk[t] = false;
+			}
+		});
+	for (auto& th : threads) th.join();
+	EXPECT_TRUE(allOk[0]);
+	EXPECT_TRUE(allOk[1]);
+}
+
+TEST(CObservation3DRangeScan, Project3D_decimation)
+{
+	mrpt::obs::T3DPointsProjectionParams pp;
+	mrpt::obs::CObservation3DRangeScan o;
+	fillSampleObs(o, pp, 1);
+	pp.decimation = 2;
+	pp.numThreads = 2;
+	o.project3DPointsFromDepthImageInto(o, pp);
+	// Points at even rows and columns:
+	EXPECT_EQ(o.points3D_x.size(), 6U);
+	for (size_t i = 0; i < o.points3D_x.size(); i++)
+	{
+		EXPECT_EQ(o.points3D_idxs_x[i] % 2, 0);
+		EXPECT_EQ(o.points3D_idxs_y[i] % 2, 0);
+		EXPECT_EQ(o.points3D_x[i], float(o.points3D_idxs_y[i]));
+	}
+}
+
+TEST(CObservation3DRangeScan, Project3D_voxelFilter)
+{
+	mrpt::obs::T3DPointsProjectionParams pp;
+	mrpt::obs::TRangeImageFilterParams fp;
+	mrpt::obs::CObservation3DRangeScan o;
+	fillSampleObs(o, pp, 1);
+
+	// Each row of points has a different depth, and they are all within
+	// less than 1m in (y,z):
+	pp.voxelSize = 1.0f;
+	o.project3DPointsFromDepthImageInto(o, pp);
+	const size_t nVoxels = o.points3D_x.size();
+	EXPECT_GE(nVoxels, 6U);
+	EXPECT_LT(nVoxels, 21U);
+	pp.voxelSize = 100.0f;
+	o.project3DPointsFromDepthImageInto(o, pp);
+	ASSERT_EQ(o.points3D_x.size(), 1U);
+	// The first point in row-major order:
+	EXPECT_EQ(o.points3D_idxs_x[0], 10);
+	EXPECT_EQ(o.points3D_idxs_y[0], 10);
+
+	// Organized clouds keep all the pixels:
+	pp.voxelSize = 1.0f;
+	pp.MAKE_DENSE = false;
+	const auto& pts =
+		mrpt::obs::detail::projectRangeImage(o, pp, fp, false);
+	EXPECT_EQ(pts.size, size_t(TEST_RANGEIMG_WIDTH * TEST_RANGEIMG_HEIGHT));
+	size_t nValid = 0;
+	for (size_t i = 0; i < pts.size; i++) nValid += pts.valid[i];
+	EXPECT_EQ(nValid, nVoxels);
+}
+
+TEST(CObservation3DRangeScan, Project3D_LUTCache)
+{
+	mrpt::img::TCamera cam1, cam2;
+	cam1.fx(100);
+	cam2.fx(200);
+	const auto lut1 =
+		mrpt::obs::CObservation3DRangeScan::get_3dproj_lut(cam1, 32, 24);
+	const auto lut2 =
+		mrpt::obs::CObservation3DRangeScan::get_3dproj_lut(cam2, 32, 24);
+	EXPECT_NE(lut1, lut2);
+	EXPECT_EQ(
+		lut1,
+		mrpt::obs::CObservation3DRangeScan::get_3dproj_lut(cam1, 32, 24));
+	EXPECT_NE(
+		lut1,
+		mrpt::obs::CObservation3DRangeScan::get_3dproj_lut(cam1, 16, 12));
+	EXPECT_EQ(lut2->Kys.size(), 32 * 24);
+}
@@ -162,3 +162,10 @@ void CObservationImage::getDescriptionAsText(std::ostream& o) const
 		" Rows are stored in top-bottom order: %s\n",
 		image.isOriginTopLeft() ? "YES" : "NO");
 }
+
+void CObservationImage::load() const
+{
+	if (image.isExternallyStored()) image.forceLoad();
+}
+
+void CObservationImage::unload() { image.unload(); }
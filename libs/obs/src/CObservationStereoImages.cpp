@@ -293,3 +293,19 @@ void CObservationStereoImages::getDescriptionAsText(std::ostream& o) const
 		" Rows are stored in top-bottom order: %s\n",
 		imageLeft.isOriginTopLeft() ? "YES" : "NO");
 }
+
+void CObservationStereoImages::load() const
+{
+	if (imageLeft.isExternallyStored()) imageLeft.forceLoad();
+	if (hasImageRight && imageRight.isExternallyStored())
+		imageRight.forceLoad();
+	if (hasImageDisparity && imageDisparity.isExternallyStored())
+		imageDisparity.forceLoad();
+}
+
+void CObservationStereoImages::unload()
+{
+	imageLeft.unload();
+	imageRight.unload();
+	imageDisparity.unload();
+}
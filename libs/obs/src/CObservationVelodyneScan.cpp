@@ -12,8 +12,12 @@
 #include <mrpt/obs/CObservationVelodyneScan.h>
 #include <mrpt/poses/CPose3DInterpolator.h>
 #include <mrpt/core/round.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/serialization/CArchive.h>
+#include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 using namespace mrpt::obs;
@@ -136,359 +140,450 @@ double VLP16AdjustTimeStamp(int firingblock, int dsr, int firingwithinblock)
 		   (firingwithinblock * VLP16_FIRING_TOFFSET);
 }
 
-/** Auxiliary class used to refactor
- * CObservationVelodyneScan::generatePointCloud() */
-struct PointCloudStorageWrapper
+namespace
 {
-	/** Process the insertion of a new (x,y,z) point to the cloud, in
-	 * sensor-centric coordinates, with the exact timestamp of that LIDAR ray */
-	virtual void add_point(
-		double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-		const mrpt::system::TTimeStamp& tim, const float azimuth) = 0;
-};
-
-static void velodyne_scan_to_pointcloud(
-	const CObservationVelodyneScan& scan,
-	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
-	PointCloudStorageWrapper& out_pc)
+/** Timestamp of a packet of the scan */
+mrpt::system::TTimeStamp packetTimestamp(
+	const CObservationVelodyneScan& scan, size_t iPkt)
 {
-	// Initially based on code from ROS velodyne & from
-	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
-	using mrpt::round;
-
-	// Access to sin/cos table:
-	mrpt::obs::T2DScanProperties scan_props;
-	scan_props.aperture = 2 * M_PI;
-	scan_props.nRays = CObservationVelodyneScan::ROTATION_MAX_UNITS;
-	scan_props.rightToLeft = true;
-	// The LUT contains sin/cos values for angles in this order: [180deg ... 0
-	// deg ... -180 deg]
-	const CSinCosLookUpTableFor2DScans::TSinCosValues& lut_sincos =
-		velodyne_sincos_tables.getSinCosForScan(scan_props);
-
-	const int minAzimuth_int = round(params.minAzimuth_deg * 100);
-	const int maxAzimuth_int = round(params.maxAzimuth_deg * 100);
-	const float realMinDist =
-		std::max(static_cast<float>(scan.minRange), params.minDistance);
-	const float realMaxDist =
-		std::min(params.maxDistance, static_cast<float>(scan.maxRange));
-	const int16_t isolatedPointsFilterDistance_units =
-		params.isolatedPointsFilterDistance /
-		CObservationVelodyneScan::DISTANCE_RESOLUTION;
-
-	// This is: 16,32,64 depending on the LIDAR model
-	const size_t num_lasers = scan.calibration.laser_corrections.size();
-
-	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
-	{
-		const CObservationVelodyneScan::TVelodyneRawPacket* raw =
-			&scan.scan_packets[iPkt];
+	const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
+	const uint32_t us_pkt_this = scan.scan_packets[iPkt].gps_timestamp;
+	// Handle the case of time counter reset by new hour 00:00:00
+	const uint32_t us_ellapsed =
+		(us_pkt_this >= us_pkt0)
+			? (us_pkt_this - us_pkt0)
+			: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+	return mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+}
 
-		mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
-		{
-			const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
-			const uint32_t us_pkt_this = raw->gps_timestamp;
-			// Handle the case of time counter reset by new hour 00:00:00
-			const uint32_t us_ellapsed =
-				(us_pkt_this >= us_pkt0)
-					? (us_pkt_this - us_pkt0)
-					: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
-			pkt_tim =
-				mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
-		}
+/** Worker threads for decoding packets in parallel, shared by all scans.
+ * A request for a different number of threads replaces the pool instead of
+ * resizing it, so callers still using the former one are not affected. */
+std::shared_ptr<mrpt::WorkerThreadsPool> getDecoderThreadPool(
+	const unsigned int nThreads)
+{
+	static std::mutex poolMtx;
+	static std::shared_ptr<mrpt::WorkerThreadsPool> pool;
 
-		// Take the median rotational speed as a good value for interpolating
-		// the missing azimuths:
-		int median_azimuth_diff;
-		{
-			// In dual return, the azimuth rate is actually twice this
-			// estimation:
-			const int nBlocksPerAzimuth =
-				(raw->laser_return_mode ==
-				 CObservationVelodyneScan::RETMODE_DUAL)
-					? 2
-					: 1;
-			std::vector<int> diffs(
-				CObservationVelodyneScan::BLOCKS_PER_PACKET -
-				nBlocksPerAzimuth);
-			for (int i = 0; i < CObservationVelodyneScan::BLOCKS_PER_PACKET -
-									nBlocksPerAzimuth;
-				 ++i)
-			{
-				int localDiff = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
-								 raw->blocks[i + nBlocksPerAzimuth].rotation -
-								 raw->blocks[i].rotation) %
-								CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				diffs[i] = localDiff;
-			}
-			std::nth_element(
-				diffs.begin(),
-				diffs.begin() + CObservationVelodyneScan::BLOCKS_PER_PACKET / 2,
-				diffs.end());  // Calc median
-			median_azimuth_diff =
-				diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET / 2];
-		}
+	std::lock_guard<std::mutex> lock(poolMtx);
+	if (!pool || pool->size() != nThreads)
+		pool = std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+	return pool;
+}
 
-		for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
-			 block++)  // Firings per packet
+/** Everything needed to decode the packets of one scan which does not depend
+ * on the packet contents: the calibration and firing time of each laser
+ * return within a block, and the filter limits. Computed once per scan. */
+struct TVelodyneDecoder
+{
+	/** Calibration of the return `k` of blocks of the upper (0) or lower (1)
+	 * bank */
+	struct TReturnCalib
+	{
+		/** False if the laser is not in the calibration data */
+		bool valid{false};
+		float cosVert{0}, sinVert{0}, horzOffset{0}, vertOffset{0};
+		double distanceCorrection{0};
+	};
+	TReturnCalib calib[2][SCANS_PER_FIRING];
+	/** Fraction of the rotation between consecutive blocks at which each
+	 * return is fired: [dual return mode][bank][block][k] */
+	double azimuthFraction[2][2][CObservationVelodyneScan::BLOCKS_PER_PACKET]
+						  [SCANS_PER_FIRING];
+
+	const CObservationVelodyneScan& scan;
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params;
+	const CSinCosLookUpTableFor2DScans::TSinCosValues* lut_sincos{nullptr};
+	size_t num_lasers{0};
+	int minAzimuth_int{0}, maxAzimuth_int{0};
+	float realMinDist{0}, realMaxDist{0};
+	int16_t isolatedPointsFilterDistance_units{0};
+
+	TVelodyneDecoder(
+		const CObservationVelodyneScan& s,
+		const CObservationVelodyneScan::TGeneratePointCloudParameters& p)
+		: scan(s), params(p)
+	{
+		// Initially based on code from ROS velodyne & from
+		// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
+		using mrpt::round;
+
+		// Access to sin/cos table:
+		mrpt::obs::T2DScanProperties scan_props;
+		scan_props.aperture = 2 * M_PI;
+		scan_props.nRays = CObservationVelodyneScan::ROTATION_MAX_UNITS;
+		scan_props.rightToLeft = true;
+		// The LUT contains sin/cos values for angles in this order: [180deg
+		// ... 0 deg ... -180 deg]
+		lut_sincos = &velodyne_sincos_tables.getSinCosForScan(scan_props);
+
+		minAzimuth_int = round(params.minAzimuth_deg * 100);
+		maxAzimuth_int = round(params.maxAzimuth_deg * 100);
+		realMinDist =
+			std::max(static_cast<float>(scan.minRange), params.minDistance);
+		realMaxDist =
+			std::min(params.maxDistance, static_cast<float>(scan.maxRange));
+		isolatedPointsFilterDistance_units =
+			params.isolatedPointsFilterDistance /
+			CObservationVelodyneScan::DISTANCE_RESOLUTION;
+
+		// This is: 16,32,64 depending on the LIDAR model
+		num_lasers = scan.calibration.laser_corrections.size();
+		if (!scan.scan_packets.empty() && num_lasers != 16 &&
+			num_lasers != 32 && num_lasers != 64)
+			THROW_EXCEPTION("Error: unhandled LIDAR model!");
+
+		for (int bank = 0; bank < 2; bank++)
 		{
-			// ignore packets with mangled or otherwise different contents
-			if ((num_lasers != 64 &&
-				 CObservationVelodyneScan::UPPER_BANK !=
-					 raw->blocks[block].header) ||
-				(raw->blocks[block].header !=
-					 CObservationVelodyneScan::UPPER_BANK &&
-				 raw->blocks[block].header !=
-					 CObservationVelodyneScan::LOWER_BANK))
+			for (int k = 0; k < SCANS_PER_FIRING; k++)
 			{
-				cerr << "[CObservationVelodyneScan] skipping invalid packet: "
-						"block "
-					 << block << " header value is "
-					 << raw->blocks[block].header;
-				continue;
-			}
-
-			const int dsr_offset = (raw->blocks[block].header ==
-									CObservationVelodyneScan::LOWER_BANK)
-									   ? 32
-									   : 0;
-			const float azimuth_raw_f = (float)(raw->blocks[block].rotation);
-			const bool block_is_dual_2nd_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) != 0));
-			const bool block_is_dual_last_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) == 0));
-
-			for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
-			{
-				if (!raw->blocks[block]
-						 .laser_returns[k]
-						 .distance)  // Invalid return?
-					continue;
-
-				const uint8_t rawLaserId =
-					static_cast<uint8_t>(dsr + dsr_offset);
-				uint8_t laserId = rawLaserId;
-
+				int laserId = k + (bank ? 32 : 0);
 				// Detect VLP-16 data and adjust laser id if necessary
-				bool firingWithinBlock = false;
-				if (num_lasers == 16)
-				{
-					if (laserId >= 16)
-					{
-						laserId -= 16;
-						firingWithinBlock = true;
-					}
-				}
-
-				ASSERT_BELOW_(laserId, num_lasers);
-				const mrpt::obs::VelodyneCalibration::PerLaserCalib& calib =
-					scan.calibration.laser_corrections[laserId];
-
-				// In dual return, if the distance is equal in both ranges,
-				// ignore one of them:
-				if (block_is_dual_2nd_ranges)
+				int firingWithinBlock = 0;
+				if (num_lasers == 16 && laserId >= 16)
 				{
-					if (raw->blocks[block].laser_returns[k].distance ==
-						raw->blocks[block - 1].laser_returns[k].distance)
-						continue;  // duplicated point
-					if (!params.dualKeepStrongest) continue;
+					laserId -= 16;
+					firingWithinBlock = 1;
 				}
-				if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
-
-				// Return distance:
-				const float distance =
-					raw->blocks[block].laser_returns[k].distance *
-						CObservationVelodyneScan::DISTANCE_RESOLUTION +
-					calib.distanceCorrection;
-				if (distance < realMinDist || distance > realMaxDist) continue;
-
-				// Isolated points filtering:
-				if (params.filterOutIsolatedPoints)
+				TReturnCalib& c = calib[bank][k];
+				c.valid = laserId < static_cast<int>(num_lasers);
+				if (c.valid)
 				{
-					bool pass_filter = true;
-					const int16_t dist_this =
-						raw->blocks[block].laser_returns[k].distance;
-					if (k > 0)
-					{
-						const int16_t dist_prev =
-							raw->blocks[block].laser_returns[k - 1].distance;
-						if (!dist_prev ||
-							std::abs(dist_this - dist_prev) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (k < (SCANS_PER_FIRING - 1))
-					{
-						const int16_t dist_next =
-							raw->blocks[block].laser_returns[k + 1].distance;
-						if (!dist_next ||
-							std::abs(dist_this - dist_next) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (!pass_filter) continue;  // Filter out this point
+					const auto& lc =
+						scan.calibration.laser_corrections[laserId];
+					c.cosVert = lc.cosVertCorrection;
+					c.sinVert = lc.sinVertCorrection;
+					c.horzOffset = lc.horizontalOffsetCorrection;
+					c.vertOffset = lc.verticalOffsetCorrection;
+					c.distanceCorrection = lc.distanceCorrection;
 				}
 
 				// Azimuth correction: correct for the laser rotation as a
 				// function of timing during the firings
-				double timestampadjustment =
-					0.0;  // [us] since beginning of scan
-				double blockdsr0 = 0.0;
-				double nextblockdsr0 = 1.0;
-				switch (num_lasers)
+				for (int dual = 0; dual < 2; dual++)
 				{
-					// VLP-16
-					case 16:
+					for (int block = 0;
+						 block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
+						 block++)
 					{
-						if (raw->laser_return_mode ==
-							CObservationVelodyneScan::RETMODE_DUAL)
+						// [us] since beginning of scan
+						double timestampadjustment = 0.0;
+						double blockdsr0 = 0.0;
+						double nextblockdsr0 = 1.0;
+						if (num_lasers == 16)
 						{
+							// VLP-16
+							const int firingBlock = dual ? block / 2 : block;
 							timestampadjustment = VLP16AdjustTimeStamp(
-								block / 2, laserId, firingWithinBlock);
+								firingBlock, laserId, firingWithinBlock);
 							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block / 2 + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block / 2, 0, 0);
+								VLP16AdjustTimeStamp(firingBlock + 1, 0, 0);
+							blockdsr0 = VLP16AdjustTimeStamp(firingBlock, 0, 0);
 						}
-						else
+						else if (num_lasers == 32)
 						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block, 0, 0);
+							// HDL-32:
+							timestampadjustment =
+								HDL32AdjustTimeStamp(block, k);
+							nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+							blockdsr0 = HDL32AdjustTimeStamp(block, 0);
 						}
+						azimuthFraction[dual][bank][block][k] =
+							(timestampadjustment - blockdsr0) /
+							(nextblockdsr0 - blockdsr0);
 					}
-					break;
-					// HDL-32:
-					case 32:
-						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
-						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
-						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
-						break;
-					case 64:
-						break;
-					default:
-					{
-						THROW_EXCEPTION("Error: unhandled LIDAR model!");
-					}
-				};
-
-				const int azimuthadjustment = mrpt::round(
-					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
-										   (nextblockdsr0 - blockdsr0)));
-
-				const float azimuth_corrected_f =
-					azimuth_raw_f + azimuthadjustment;
-				const int azimuth_corrected =
-					((int)round(azimuth_corrected_f)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-
-				// Filter by azimuth:
-				if (!((minAzimuth_int < maxAzimuth_int &&
-					   azimuth_corrected >= minAzimuth_int &&
-					   azimuth_corrected <= maxAzimuth_int) ||
-					  (minAzimuth_int > maxAzimuth_int &&
-					   (azimuth_corrected <= maxAzimuth_int ||
-						azimuth_corrected >= minAzimuth_int))))
-					continue;
-
-				// Vertical axis mis-alignment calibration:
-				const float cos_vert_angle = calib.cosVertCorrection;
-				const float sin_vert_angle = calib.sinVertCorrection;
-				const float horz_offset = calib.horizontalOffsetCorrection;
-				const float vert_offset = calib.verticalOffsetCorrection;
-
-				float xy_distance = distance * cos_vert_angle;
-				if (vert_offset) xy_distance += vert_offset * sin_vert_angle;
-
-				const int azimuth_corrected_for_lut =
-					(azimuth_corrected +
-					 (CObservationVelodyneScan::ROTATION_MAX_UNITS / 2)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				const float cos_azimuth =
-					lut_sincos.ccos[azimuth_corrected_for_lut];
-				const float sin_azimuth =
-					lut_sincos.csin[azimuth_corrected_for_lut];
-
-				// Compute raw position
-				const mrpt::math::TPoint3Df pt(
-					xy_distance * cos_azimuth +
-						horz_offset * sin_azimuth,  // MRPT +X = Velodyne +Y
-					-(xy_distance * sin_azimuth -
-					  horz_offset * cos_azimuth),  // MRPT +Y = Velodyne -X
-					distance * sin_vert_angle + vert_offset);
-
-				bool add_point = true;
-				if (params.filterByROI &&
-					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
-					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
-					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
-					add_point = false;
-
-				if (params.filterBynROI &&
-					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
-					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
-					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
-					add_point = false;
-
-				if (!add_point) continue;
-
-				// Insert point:
-				out_pc.add_point(
-					pt.x, pt.y, pt.z,
-					raw->blocks[block].laser_returns[k].intensity, pkt_tim,
-					azimuth_corrected_f);
-
-			}  // end for k,dsr=[0,31]
-		}  // end for each block [0,11]
-	}  // end for each data packet
-}
+				}
+			}
+		}
+	}
 
-void CObservationVelodyneScan::generatePointCloud(
-	const TGeneratePointCloudParameters& params)
+	/** Decodes a packet into the point cloud, from index `first` on, which
+	 * must have room for MAX_POINTS_PER_PACKET points.
+	 * \return The number of points */
+	size_t decodePacket(
+		size_t iPkt, CObservationVelodyneScan::TPointCloud& pc,
+		size_t first) const;
+
+	static const size_t MAX_POINTS_PER_PACKET =
+		CObservationVelodyneScan::BLOCKS_PER_PACKET * SCANS_PER_FIRING;
+};
+
+size_t TVelodyneDecoder::decodePacket(
+	size_t iPkt, CObservationVelodyneScan::TPointCloud& pc,
+	size_t first) const
 {
-	struct PointCloudStorageWrapper_Inner : public PointCloudStorageWrapper
+	const CObservationVelodyneScan::TVelodyneRawPacket* raw =
+		&scan.scan_packets[iPkt];
+	const bool isDual =
+		raw->laser_return_mode == CObservationVelodyneScan::RETMODE_DUAL;
+
+	// Take the median rotational speed as a good value for interpolating
+	// the missing azimuths:
+	int median_azimuth_diff;
+	{
+		// In dual return, the azimuth rate is actually twice this
+		// estimation:
+		const int nBlocksPerAzimuth = isDual ? 2 : 1;
+		int diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET];
+		const int nDiffs =
+			CObservationVelodyneScan::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
+		for (int i = 0; i < nDiffs; ++i)
+			diffs[i] = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
+						raw->blocks[i + nBlocksPerAzimuth].rotation -
+						raw->blocks[i].rotation) %
+					   CObservationVelodyneScan::ROTATION_MAX_UNITS;
+		std::nth_element(
+			diffs, diffs + CObservationVelodyneScan::BLOCKS_PER_PACKET / 2,
+			diffs + nDiffs);  // Calc median
+		median_azimuth_diff =
+			diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET / 2];
+	}
+
+	const mrpt::system::TTimeStamp pkt_tim = packetTimestamp(scan, iPkt);
+	float* xs = pc.x.data() + first;
+	float* ys = pc.y.data() + first;
+	float* zs = pc.z.data() + first;
+	uint8_t* intensities = pc.intensity.data() + first;
+	float* azimuths =
+		params.generatePerPointAzimuth ? pc.azimuth.data() + first : nullptr;
+	size_t n = 0;
+
+	for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
+		 block++)  // Firings per packet
 	{
-		CObservationVelodyneScan& me_;
-		const TGeneratePointCloudParameters& params_;
-		PointCloudStorageWrapper_Inner(
-			CObservationVelodyneScan& me,
-			const TGeneratePointCloudParameters& p)
-			: me_(me), params_(p)
+		const CObservationVelodyneScan::raw_block_t& blk = raw->blocks[block];
+		// ignore packets with mangled or otherwise different contents
+		if ((num_lasers != 64 &&
+			 CObservationVelodyneScan::UPPER_BANK != blk.header) ||
+			(blk.header != CObservationVelodyneScan::UPPER_BANK &&
+			 blk.header != CObservationVelodyneScan::LOWER_BANK))
 		{
-			// Reset point cloud:
-			me_.point_cloud.clear();
+			cerr << "[CObservationVelodyneScan] skipping invalid packet: "
+					"block "
+				 << block << " header value is " << blk.header;
+			continue;
 		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
+
+		const int bank =
+			(blk.header == CObservationVelodyneScan::LOWER_BANK) ? 1 : 0;
+		const TReturnCalib* blockCalib = calib[bank];
+		const double* blockAzimuthFraction =
+			azimuthFraction[isDual ? 1 : 0][bank][block];
+		const float azimuth_raw_f = (float)(blk.rotation);
+		const bool block_is_dual_2nd_ranges = isDual && ((block & 0x01) != 0);
+		const bool block_is_dual_last_ranges =
+			isDual && ((block & 0x01) == 0);
+		if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+		if (block_is_dual_2nd_ranges && !params.dualKeepStrongest) continue;
+
+		// Values of all the returns of the block, in independent loops
+		// without branches, which compilers vectorize:
+		float distances[SCANS_PER_FIRING], xy_distances[SCANS_PER_FIRING];
+		int azimuths_corrected[SCANS_PER_FIRING];
+		float azimuths_corrected_f[SCANS_PER_FIRING];
+		for (int k = 0; k < SCANS_PER_FIRING; k++)
 		{
-			me_.point_cloud.x.push_back(pt_x);
-			me_.point_cloud.y.push_back(pt_y);
-			me_.point_cloud.z.push_back(pt_z);
-			me_.point_cloud.intensity.push_back(pt_intensity);
-			if (params_.generatePerPointTimestamp)
-			{
-				me_.point_cloud.timestamp.push_back(tim);
-			}
-			if (params_.generatePerPointAzimuth)
+			const TReturnCalib& c = blockCalib[k];
+			// Return distance:
+			distances[k] = blk.laser_returns[k].distance *
+							   CObservationVelodyneScan::DISTANCE_RESOLUTION +
+						   c.distanceCorrection;
+			// Vertical axis mis-alignment calibration:
+			xy_distances[k] =
+				distances[k] * c.cosVert + c.vertOffset * c.sinVert;
+		}
+		for (int k = 0; k < SCANS_PER_FIRING; k++)
+		{
+			const int azimuthadjustment = mrpt::round(
+				median_azimuth_diff * blockAzimuthFraction[k]);
+			azimuths_corrected_f[k] = azimuth_raw_f + azimuthadjustment;
+			azimuths_corrected[k] =
+				((int)azimuths_corrected_f[k]) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS;
+		}
+
+		for (int k = 0; k < SCANS_PER_FIRING; k++)
+		{
+			const uint16_t dist_this = blk.laser_returns[k].distance;
+			if (!dist_this) continue;  // Invalid return?
+
+			const TReturnCalib& c = blockCalib[k];
+			ASSERT_(c.valid);
+
+			// In dual return, if the distance is equal in both ranges,
+			// ignore one of them:
+			if (block_is_dual_2nd_ranges &&
+				dist_this == raw->blocks[block - 1].laser_returns[k].distance)
+				continue;  // duplicated point
+
+			const float distance = distances[k];
+			if (distance < realMinDist || distance > realMaxDist) continue;
+
+			// Isolated points filtering:
+			if (params.filterOutIsolatedPoints)
 			{
-				const int azimuth_corrected =
-					((int)round(azimuth)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				me_.point_cloud.azimuth.push_back(
-					azimuth_corrected * ROTATION_RESOLUTION);
+				bool pass_filter = true;
+				if (k > 0)
+				{
+					const int16_t dist_prev =
+						blk.laser_returns[k - 1].distance;
+					if (!dist_prev ||
+						std::abs(int16_t(dist_this) - dist_prev) >
+							isolatedPointsFilterDistance_units)
+						pass_filter = false;
+				}
+				if (k < (SCANS_PER_FIRING - 1))
+				{
+					const int16_t dist_next =
+						blk.laser_returns[k + 1].distance;
+					if (!dist_next ||
+						std::abs(int16_t(dist_this) - dist_next) >
+							isolatedPointsFilterDistance_units)
+						pass_filter = false;
+				}
+				if (!pass_filter) continue;  // Filter out this point
 			}
-		}
+
+			// Filter by azimuth:
+			const int azimuth_corrected = azimuths_corrected[k];
+			if (!((minAzimuth_int < maxAzimuth_int &&
+				   azimuth_corrected >= minAzimuth_int &&
+				   azimuth_corrected <= maxAzimuth_int) ||
+				  (minAzimuth_int > maxAzimuth_int &&
+				   (azimuth_corrected <= maxAzimuth_int ||
+					azimuth_corrected >= minAzimuth_int))))
+				continue;
+
+			const int azimuth_corrected_for_lut =
+				(azimuth_corrected +
+				 (CObservationVelodyneScan::ROTATION_MAX_UNITS / 2)) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS;
+			const float cos_azimuth =
+				lut_sincos->ccos[azimuth_corrected_for_lut];
+			const float sin_azimuth =
+				lut_sincos->csin[azimuth_corrected_for_lut];
+
+			// Compute raw position
+			const float xy_distance = xy_distances[k];
+			const mrpt::math::TPoint3Df pt(
+				xy_distance * cos_azimuth +
+					c.horzOffset * sin_azimuth,  // MRPT +X = Velodyne +Y
+				-(xy_distance * sin_azimuth -
+				  c.horzOffset * cos_azimuth),  // MRPT +Y = Velodyne -X
+				distance * c.sinVert + c.vertOffset);
+
+			if (params.filterByROI &&
+				(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
+				 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
+				 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
+				continue;
+
+			if (params.filterBynROI &&
+				(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
+				 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
+				 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
+				continue;
+
+			// Insert point:
+			xs[n] = pt.x;
+			ys[n] = pt.y;
+			zs[n] = pt.z;
+			intensities[n] = blk.laser_returns[k].intensity;
+			if (azimuths)
+				azimuths[n] = azimuth_corrected *
+							  CObservationVelodyneScan::ROTATION_RESOLUTION;
+			n++;
+		}  // end for k,dsr=[0,15]
+	}  // end for each block [0,11]
+
+	if (params.generatePerPointTimestamp)
+		std::fill(
+			pc.timestamp.begin() + first, pc.timestamp.begin() + first + n,
+			pkt_tim);
+	return n;
+}
+
+/** Decodes all the packets of a scan into `pc`, in parallel if enabled.
+ * Optionally, returns the index of the first point of each packet in
+ * `pktFirstPoint`, with one extra element at the end with the total count.
+ */
+void velodyne_scan_to_pointcloud(
+	const CObservationVelodyneScan& scan,
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
+	CObservationVelodyneScan::TPointCloud& pc,
+	std::vector<size_t>* pktFirstPoint = nullptr)
+{
+	const TVelodyneDecoder decoder(scan, params);
+	const size_t nPkts = scan.scan_packets.size();
+
+	// Each packet is decoded into its own range of the output vectors, then
+	// they are compacted:
+	const size_t maxPts = nPkts * TVelodyneDecoder::MAX_POINTS_PER_PACKET;
+	pc.x.resize(maxPts);
+	pc.y.resize(maxPts);
+	pc.z.resize(maxPts);
+	pc.intensity.resize(maxPts);
+	pc.timestamp.resize(params.generatePerPointTimestamp ? maxPts : 0);
+	pc.azimuth.resize(params.generatePerPointAzimuth ? maxPts : 0);
+
+	std::vector<size_t> pktCount(nPkts);
+	auto decodePackets = [&](size_t firstPkt, size_t lastPkt) {
+		for (size_t i = firstPkt; i < lastPkt; i++)
+			pktCount[i] = decoder.decodePacket(
+				i, pc, i * TVelodyneDecoder::MAX_POINTS_PER_PACKET);
 	};
+	unsigned int nThreads = params.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1 || nPkts < 2)
+		decodePackets(0, nPkts);
+	else
+		getDecoderThreadPool(nThreads)->parallelForBlocks(
+			nPkts, std::max<size_t>(1, nPkts / (4 * nThreads)),
+			decodePackets);
+
+	if (pktFirstPoint) pktFirstPoint->resize(nPkts + 1);
+	size_t n = 0;
+	for (size_t i = 0; i < nPkts; i++)
+	{
+		if (pktFirstPoint) (*pktFirstPoint)[i] = n;
+		const size_t src = i * TVelodyneDecoder::MAX_POINTS_PER_PACKET;
+		const size_t cnt = pktCount[i];
+		if (src != n)
+		{
+			std::copy_n(pc.x.begin() + src, cnt, pc.x.begin() + n);
+			std::copy_n(pc.y.begin() + src, cnt, pc.y.begin() + n);
+			std::copy_n(pc.z.begin() + src, cnt, pc.z.begin() + n);
+			std::copy_n(
+				pc.intensity.begin() + src, cnt, pc.intensity.begin() + n);
+			if (!pc.timestamp.empty())
+				std::copy_n(
+					pc.timestamp.begin() + src, cnt, pc.timestamp.begin() + n);
+			if (!pc.azimuth.empty())
+				std::copy_n(
+					pc.azimuth.begin() + src, cnt, pc.azimuth.begin() + n);
+		}
+		n += cnt;
+	}
+	if (pktFirstPoint) (*pktFirstPoint)[nPkts] = n;
+	pc.x.resize(n);
+	pc.y.resize(n);
+	pc.z.resize(n);
+	pc.intensity.resize(n);
+	if (!pc.timestamp.empty()) pc.timestamp.resize(n);
+	if (!pc.azimuth.empty()) pc.azimuth.resize(n);
+}
+}  // namespace
 
-	PointCloudStorageWrapper_Inner my_pc_wrap(*this, params);
+void CObservationVelodyneScan::generatePointCloud(
+	const TGeneratePointCloudParameters& params)
+{
+	generatePointCloud(point_cloud, params);
+}
 
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+void CObservationVelodyneScan::generatePointCloud(
+	TPointCloud& dest, const TGeneratePointCloudParameters& params) const
+{
+	velodyne_scan_to_pointcloud(*this, params, dest);
 }
 
 void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
@@ -497,64 +592,45 @@ void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
 	TGeneratePointCloudSE3Results& results_stats,
 	const TGeneratePointCloudParameters& params)
 {
+	// Points in sensor coordinates, and the first point of each packet:
+	TPointCloud pc;
+	std::vector<size_t> pktFirstPoint;
+	TGeneratePointCloudParameters localParams = params;
+	localParams.generatePerPointTimestamp = false;
+	localParams.generatePerPointAzimuth = false;
+	velodyne_scan_to_pointcloud(*this, localParams, pc, &pktFirstPoint);
+
 	// Pre-alloc mem:
-	out_points.reserve(
-		out_points.size() +
-		scan_packets.size() * BLOCKS_PER_PACKET * SCANS_PER_BLOCK + 16);
+	out_points.reserve(out_points.size() + pc.size());
 
-	struct PointCloudStorageWrapper_SE3_Interp : public PointCloudStorageWrapper
+	// All the points of a packet share the same timestamp, so the vehicle
+	// pose is interpolated once per packet:
+	for (size_t iPkt = 0; iPkt < scan_packets.size(); iPkt++)
 	{
-		CObservationVelodyneScan& me_;
-		const mrpt::poses::CPose3DInterpolator& vehicle_path_;
-		std::vector<mrpt::math::TPointXYZIu8>& out_points_;
-		TGeneratePointCloudSE3Results& results_stats_;
-		mrpt::system::TTimeStamp last_query_tim_;
-		mrpt::poses::CPose3D last_query_;
-		bool last_query_valid_;
-
-		PointCloudStorageWrapper_SE3_Interp(
-			CObservationVelodyneScan& me,
-			const mrpt::poses::CPose3DInterpolator& vehicle_path,
-			std::vector<mrpt::math::TPointXYZIu8>& out_points,
-			TGeneratePointCloudSE3Results& results_stats)
-			: me_(me),
-			  vehicle_path_(vehicle_path),
-			  out_points_(out_points),
-			  results_stats_(results_stats),
-			  last_query_tim_(INVALID_TIMESTAMP),
-			  last_query_valid_(false)
+		const size_t first = pktFirstPoint[iPkt],
+					 last = pktFirstPoint[iPkt + 1];
+		if (first == last) continue;
+		results_stats.num_points += last - first;
+
+		mrpt::poses::CPose3D vehicle_pose;
+		bool valid = false;
+		vehicle_path.interpolate(
+			packetTimestamp(*this, iPkt), vehicle_pose, valid);
+		if (!valid) continue;
+
+		mrpt::poses::CPose3D global_sensor_pose(
+			mrpt::poses::UNINITIALIZED_POSE);
+		global_sensor_pose.composeFrom(vehicle_pose, sensorPose);
+		for (size_t i = first; i < last; i++)
 		{
+			double gx, gy, gz;
+			global_sensor_pose.composePoint(
+				pc.x[i], pc.y[i], pc.z[i], gx, gy, gz);
+			out_points.push_back(
+				mrpt::math::TPointXYZIu8(gx, gy, gz, pc.intensity[i]));
 		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
-		{
-			// Use a cache since it's expected that the same timestamp is
-			// queried several times in a row:
-			if (last_query_tim_ != tim)
-			{
-				last_query_tim_ = tim;
-				vehicle_path_.interpolate(tim, last_query_, last_query_valid_);
-			}
-
-			if (last_query_valid_)
-			{
-				mrpt::poses::CPose3D global_sensor_pose(
-					mrpt::poses::UNINITIALIZED_POSE);
-				global_sensor_pose.composeFrom(last_query_, me_.sensorPose);
-				double gx, gy, gz;
-				global_sensor_pose.composePoint(pt_x, pt_y, pt_z, gx, gy, gz);
-				out_points_.push_back(
-					mrpt::math::TPointXYZIu8(gx, gy, gz, pt_intensity));
-				++results_stats_.num_correctly_inserted_points;
-			}
-			++results_stats_.num_points;
-		}
-	};
-
-	PointCloudStorageWrapper_SE3_Interp my_pc_wrap(
-		*this, vehicle_path, out_points, results_stats);
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+		results_stats.num_correctly_inserted_points += last - first;
+	}
 }
 
 void CObservationVelodyneScan::TPointCloud::clear()
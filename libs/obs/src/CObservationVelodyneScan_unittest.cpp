@@ -0,0 +1,439 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/obs/CSinCosLookUpTableFor2DScans.h>
+#include <mrpt/obs/T2DScanProperties.h>
+#include <mrpt/core/round.h>
+#include <mrpt/poses/CPose3DInterpolator.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace std;
+
+namespace
+{
+// A full rotation of synthetic packets, with some missing returns:
+void fillSampleScan(
+	CObservationVelodyneScan& obs, const std::string& model, bool dual)
+{
+	mrpt::random::CRandomGenerator rng(123);
+	obs.calibration = VelodyneCalibration::LoadDefaultCalibration(model);
+	obs.timestamp = mrpt::system::now();
+	obs.sensorPose = mrpt::poses::CPose3D(0.5, 0, 1.2, 0.1, 0, 0);
+	const size_t nPkts = 75;
+	obs.scan_packets.resize(nPkts);
+	for (size_t i = 0; i < nPkts; i++)
+	{
+		auto& pkt = obs.scan_packets[i];
+		pkt.gps_timestamp = 1000 * i;
+		pkt.laser_return_mode = dual ? CObservationVelodyneScan::RETMODE_DUAL
+									 : CObservationVelodyneScan::RETMODE_LAST;
+		for (int b = 0; b < CObservationVelodyneScan::BLOCKS_PER_PACKET; b++)
+		{
+			auto& blk = pkt.blocks[b];
+			blk.header = CObservationVelodyneScan::UPPER_BANK;
+			const int step = dual ? b / 2 : b;
+			blk.rotation = (40 * (i * 12 + step)) %
+						   CObservationVelodyneScan::ROTATION_MAX_UNITS;
+			for (auto& ret : blk.laser_returns)
+			{
+				ret.distance = (rng.drawUniform32bit() % 4 == 0)
+								   ? 0
+								   : rng.drawUniform(1000, 20000);
+				ret.intensity = rng.drawUniform32bit() % 256;
+			}
+		}
+	}
+}
+// The per-point decoder of previous versions, kept as a reference for the
+// output of generatePointCloud():
+void referencePointCloud(
+	const CObservationVelodyneScan& scan,
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
+	CObservationVelodyneScan::TPointCloud& pc)
+{
+	using V = CObservationVelodyneScan;
+	const int SCANS_PER_FIRING = 16;
+	const float VLP16_BLOCK_TDURATION = 110.592f, VLP16_DSR_TOFFSET = 2.304f,
+				VLP16_FIRING_TOFFSET = 55.296f, HDR32_DSR_TOFFSET = 1.152f,
+				HDR32_FIRING_TOFFSET = 46.08f;
+	auto HDL32AdjustTimeStamp = [&](int firingblock, int dsr) -> double {
+		return (firingblock * HDR32_FIRING_TOFFSET) +
+			   (dsr * HDR32_DSR_TOFFSET);
+	};
+	auto VLP16AdjustTimeStamp = [&](int firingblock, int dsr,
+									int firingwithinblock) -> double {
+		return (firingblock * VLP16_BLOCK_TDURATION) +
+			   (dsr * VLP16_DSR_TOFFSET) +
+			   (firingwithinblock * VLP16_FIRING_TOFFSET);
+	};
+
+	CSinCosLookUpTableFor2DScans sincos_tables;
+	T2DScanProperties scan_props;
+	scan_props.aperture = 2 * M_PI;
+	scan_props.nRays = V::ROTATION_MAX_UNITS;
+	scan_props.rightToLeft = true;
+	const auto& lut_sincos = sincos_tables.getSinCosForScan(scan_props);
+
+	const int minAzimuth_int = mrpt::round(params.minAzimuth_deg * 100);
+	const int maxAzimuth_int = mrpt::round(params.maxAzimuth_deg * 100);
+	const float realMinDist =
+		std::max(static_cast<float>(scan.minRange), params.minDistance);
+	const float realMaxDist =
+		std::min(params.maxDistance, static_cast<float>(scan.maxRange));
+	const int16_t isolatedPointsFilterDistance_units =
+		params.isolatedPointsFilterDistance / V::DISTANCE_RESOLUTION;
+	const size_t num_lasers = scan.calibration.laser_corrections.size();
+
+	pc.clear();
+	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
+	{
+		const V::TVelodyneRawPacket* raw = &scan.scan_packets[iPkt];
+
+		const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
+		const uint32_t us_pkt_this = raw->gps_timestamp;
+		const uint32_t us_ellapsed =
+			(us_pkt_this >= us_pkt0)
+				? (us_pkt_this - us_pkt0)
+				: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+		const mrpt::system::TTimeStamp pkt_tim =
+			mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+
+		int median_azimuth_diff;
+		{
+			const int nBlocksPerAzimuth =
+				(raw->laser_return_mode == V::RETMODE_DUAL) ? 2 : 1;
+			std::vector<int> diffs(V::BLOCKS_PER_PACKET - nBlocksPerAzimuth);
+			for (int i = 0; i < V::BLOCKS_PER_PACKET - nBlocksPerAzimuth; ++i)
+				diffs[i] = (V::ROTATION_MAX_UNITS +
+							raw->blocks[i + nBlocksPerAzimuth].rotation -
+							raw->blocks[i].rotation) %
+						   V::ROTATION_MAX_UNITS;
+			std::nth_element(
+				diffs.begin(), diffs.begin() + V::BLOCKS_PER_PACKET / 2,
+				diffs.end());
+			median_azimuth_diff = diffs[V::BLOCKS_PER_PACKET / 2];
+		}
+
+		for (int block = 0; block < V::BLOCKS_PER_PACKET; block++)
+		{
+			const auto& blk = raw->blocks[block];
+			if ((num_lasers != 64 && V::UPPER_BANK != blk.header) ||
+				(blk.header != V::UPPER_BANK && blk.header != V::LOWER_BANK))
+				continue;
+
+			const int dsr_offset = (blk.header == V::LOWER_BANK) ? 32 : 0;
+			const float azimuth_raw_f = (float)(blk.rotation);
+			const bool block_is_dual_2nd_ranges =
+				(raw->laser_return_mode == V::RETMODE_DUAL &&
+				 ((block & 0x01) != 0));
+			const bool block_is_dual_last_ranges =
+				(raw->laser_return_mode == V::RETMODE_DUAL &&
+				 ((block & 0x01) == 0));
+
+			for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
+			{
+				if (!blk.laser_returns[k].distance) continue;
+
+				uint8_t laserId = static_cast<uint8_t>(dsr + dsr_offset);
+				bool firingWithinBlock = false;
+				if (num_lasers == 16 && laserId >= 16)
+				{
+					laserId -= 16;
+					firingWithinBlock = true;
+				}
+				const auto& calib = scan.calibration.laser_corrections[laserId];
+
+				if (block_is_dual_2nd_ranges)
+				{
+					if (blk.laser_returns[k].distance ==
+						raw->blocks[block - 1].laser_returns[k].distance)
+						continue;
+					if (!params.dualKeepStrongest) continue;
+				}
+				if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+
+				const float distance =
+					blk.laser_returns[k].distance * V::DISTANCE_RESOLUTION +
+					calib.distanceCorrection;
+				if (distance < realMinDist || distance > realMaxDist) continue;
+
+				if (params.filterOutIsolatedPoints)
+				{
+					bool pass_filter = true;
+					const int16_t dist_this = blk.laser_returns[k].distance;
+					if (k > 0)
+					{
+						const int16_t dist_prev =
+							blk.laser_returns[k - 1].distance;
+						if (!dist_prev ||
+							std::abs(dist_this - dist_prev) >
+								isolatedPointsFilterDistance_units)
+							pass_filter = false;
+					}
+					if (k < (SCANS_PER_FIRING - 1))
+					{
+						const int16_t dist_next =
+							blk.laser_returns[k + 1].distance;
+						if (!dist_next ||
+							std::abs(dist_this - dist_next) >
+								isolatedPointsFilterDistance_units)
+							pass_filter = false;
+					}
+					if (!pass_filter) continue;
+				}
+
+				double timestampadjustment = 0.0;
+				double blockdsr0 = 0.0;
+				double nextblockdsr0 = 1.0;
+				if (num_lasers == 16)
+				{
+					const int b = (raw->laser_return_mode == V::RETMODE_DUAL)
+									  ? block / 2
+									  : block;
+					timestampadjustment =
+						VLP16AdjustTimeStamp(b, laserId, firingWithinBlock);
+					nextblockdsr0 = VLP16AdjustTimeStamp(b + 1, 0, 0);
+					blockdsr0 = VLP16AdjustTimeStamp(b, 0, 0);
+				}
+				else if (num_lasers == 32)
+				{
+					timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
+					nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+					blockdsr0 = HDL32AdjustTimeStamp(block, 0);
+				}
+
+				const int azimuthadjustment = mrpt::round(
+					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
+										   (nextblockdsr0 - blockdsr0)));
+				const float azimuth_corrected_f =
+					azimuth_raw_f + azimuthadjustment;
+				const int azimuth_corrected =
+					((int)round(azimuth_corrected_f)) % V::ROTATION_MAX_UNITS;
+
+				if (!((minAzimuth_int < maxAzimuth_int &&
+					   azimuth_corrected >= minAzimuth_int &&
+					   azimuth_corrected <= maxAzimuth_int) ||
+					  (minAzimuth_int > maxAzimuth_int &&
+					   (azimuth_corrected <= maxAzimuth_int ||
+						azimuth_corrected >= minAzimuth_int))))
+					continue;
+
+				const float cos_vert_angle = calib.cosVertCorrection;
+				const float sin_vert_angle = calib.sinVertCorrection;
+				const float horz_offset = calib.horizontalOffsetCorrection;
+				const float vert_offset = calib.verticalOffsetCorrection;
+
+				float xy_distance = distance * cos_vert_angle;
+				if (vert_offset) xy_distance += vert_offset * sin_vert_angle;
+
+				const int azimuth_corrected_for_lut =
+					(azimuth_corrected + (V::ROTATION_MAX_UNITS / 2)) %
+					V::ROTATION_MAX_UNITS;
+				const float cos_azimuth =
+					lut_sincos.ccos[azimuth_corrected_for_lut];
+				const float sin_azimuth =
+					lut_sincos.csin[azimuth_corrected_for_lut];
+
+				const mrpt::math::TPoint3Df pt(
+					xy_distance * cos_azimuth + horz_offset * sin_azimuth,
+					-(xy_distance * sin_azimuth - horz_offset * cos_azimuth),
+					distance * sin_vert_angle + vert_offset);
+
+				if (params.filterByROI &&
+					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
+					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
+					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
+					continue;
+				if (params.filterBynROI &&
+					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
+					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
+					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
+					continue;
+
+				pc.x.push_back(pt.x);
+				pc.y.push_back(pt.y);
+				pc.z.push_back(pt.z);
+				pc.intensity.push_back(blk.laser_returns[k].intensity);
+				if (params.generatePerPointTimestamp)
+					pc.timestamp.push_back(pkt_tim);
+				if (params.generatePerPointAzimuth)
+					pc.azimuth.push_back(
+						(((int)round(azimuth_corrected_f)) %
+						 V::ROTATION_MAX_UNITS) *
+						V::ROTATION_RESOLUTION);
+			}
+		}
+	}
+}
+}  // namespace
+
+TEST(CObservationVelodyneScan, generatePointCloudMatchesReference)
+{
+	for (const char* model : {"VLP16", "HDL32"})
+	{
+		for (bool dual : {false, true})
+		{
+			CObservationVelodyneScan obs;
+			fillSampleScan(obs, model, dual);
+
+			std::vector<CObservationVelodyneScan::TGeneratePointCloudParameters>
+				params(5);
+			for (auto& p : params)
+			{
+				p.generatePerPointAzimuth = true;
+				p.generatePerPointTimestamp = true;
+			}
+			params[1].minAzimuth_deg = 270;  // Wrapping azimuth range
+			params[1].maxAzimuth_deg = 45;
+			params[1].minDistance = 5;
+			params[1].maxDistance = 30;
+			params[2].filterOutIsolatedPoints = true;
+			params[2].isolatedPointsFilterDistance = 10;
+			params[2].dualKeepStrongest = false;
+			params[3].filterByROI = true;
+			params[3].ROI_x_min = -10;
+			params[3].ROI_x_max = 15;
+			params[3].ROI_z_max = 2;
+			params[3].dualKeepLast = false;
+			params[4].filterBynROI = true;
+			params[4].nROI_x_min = -5;
+			params[4].nROI_x_max = 5;
+			params[4].nROI_y_min = -20;
+			params[4].nROI_y_max = 20;
+			params[4].nROI_z_min = -10;
+			params[4].nROI_z_max = 10;
+
+			for (size_t i = 0; i < params.size(); i++)
+			{
+				CObservationVelodyneScan::TPointCloud ref;
+				referencePointCloud(obs, params[i], ref);
+				EXPECT_GT(ref.size(), 0u);
+				for (unsigned int nThreads : {1, 4})
+				{
+					params[i].numThreads = nThreads;
+					CObservationVelodyneScan::TPointCloud pc;
+					obs.generatePointCloud(pc, params[i]);
+					EXPECT_EQ(pc.x, ref.x) << model << " params #" << i;
+					EXPECT_EQ(pc.y, ref.y) << model << " params #" << i;
+					EXPECT_EQ(pc.z, ref.z) << model << " params #" << i;
+					EXPECT_EQ(pc.intensity, ref.intensity);
+					EXPECT_EQ(pc.azimuth, ref.azimuth);
+					EXPECT_EQ(pc.timestamp, ref.timestamp);
+				}
+			}
+		}
+	}
+}
+
+TEST(CObservationVelodyneScan, generatePointCloud)
+{
+	for (const char* model : {"VLP16", "HDL32"})
+	{
+		for (bool dual : {false, true})
+		{
+			CObservationVelodyneScan obs;
+			fillSampleScan(obs, model, dual);
+
+			CObservationVelodyneScan::TGeneratePointCloudParameters p;
+			p.generatePerPointAzimuth = true;
+			p.generatePerPointTimestamp = true;
+			obs.generatePointCloud(p);
+			const auto& pc = obs.point_cloud;
+			EXPECT_GT(pc.size(), 1000u);
+			ASSERT_EQ(pc.y.size(), pc.size());
+			ASSERT_EQ(pc.z.size(), pc.size());
+			ASSERT_EQ(pc.intensity.size(), pc.size());
+			ASSERT_EQ(pc.azimuth.size(), pc.size());
+			ASSERT_EQ(pc.timestamp.size(), pc.size());
+
+			// Ranges must be those of the returns (plus small calibration
+			// offsets):
+			for (size_t i = 0; i < pc.size(); i++)
+			{
+				const double r = std::sqrt(
+					mrpt::square(pc.x[i]) + mrpt::square(pc.y[i]) +
+					mrpt::square(pc.z[i]));
+				EXPECT_GT(r, 1.9);
+				EXPECT_LT(r, 40.2);
+				EXPECT_GE(pc.azimuth[i], 0.f);
+				EXPECT_LT(pc.azimuth[i], 360.f);
+			}
+
+			// Same results with several threads, or into another buffer:
+			CObservationVelodyneScan::TPointCloud pc2;
+			p.numThreads = 3;
+			obs.generatePointCloud(pc2, p);
+			EXPECT_EQ(pc.x, pc2.x);
+			EXPECT_EQ(pc.y, pc2.y);
+			EXPECT_EQ(pc.z, pc2.z);
+			EXPECT_EQ(pc.intensity, pc2.intensity);
+			EXPECT_EQ(pc.azimuth, pc2.azimuth);
+			EXPECT_EQ(pc.timestamp, pc2.timestamp);
+
+			// Filter by azimuth:
+			p.minAzimuth_deg = 90;
+			p.maxAzimuth_deg = 180;
+			obs.generatePointCloud(pc2, p);
+			EXPECT_GT(pc2.size(), 0u);
+			EXPECT_LT(pc2.size(), pc.size() / 2);
+			for (float az : pc2.azimuth)
+			{
+				EXPECT_GE(az, 90.f);
+				EXPECT_LE(az, 180.f);
+			}
+		}
+	}
+}
+
+TEST(CObservationVelodyneScan, generatePointCloudAlongSE3Trajectory)
+{
+	CObservationVelodyneScan obs;
+	fillSampleScan(obs, "VLP16", false);
+	obs.generatePointCloud();
+	const auto& pc = obs.point_cloud;
+
+	// A static vehicle: points are the local ones in vehicle coordinates.
+	const mrpt::poses::CPose3D vehPose(1, 2, 0, 0.5, 0, 0);
+	mrpt::poses::CPose3DInterpolator path;
+	path.insert(
+		mrpt::system::timestampAdd(obs.timestamp, -1.0), vehPose.asTPose());
+	path.insert(
+		mrpt::system::timestampAdd(obs.timestamp, 1.0), vehPose.asTPose());
+
+	std::vector<mrpt::math::TPointXYZIu8> pts;
+	CObservationVelodyneScan::TGeneratePointCloudSE3Results res;
+	obs.generatePointCloudAlongSE3Trajectory(path, pts, res);
+	EXPECT_EQ(res.num_points, pc.size());
+	EXPECT_EQ(res.num_correctly_inserted_points, pc.size());
+	ASSERT_EQ(pts.size(), pc.size());
+	const mrpt::poses::CPose3D sensorGlobalPose = vehPose + obs.sensorPose;
+	for (size_t i = 0; i < pc.size(); i++)
+	{
+		double gx, gy, gz;
+		sensorGlobalPose.composePoint(pc.x[i], pc.y[i], pc.z[i], gx, gy, gz);
+		EXPECT_NEAR(pts[i].pt.x, gx, 1e-4);
+		EXPECT_NEAR(pts[i].pt.y, gy, 1e-4);
+		EXPECT_NEAR(pts[i].pt.z, gz, 1e-4);
+		EXPECT_EQ(pts[i].intensity, pc.intensity[i]);
+	}
+
+	// No pose for the scan time:
+	mrpt::poses::CPose3DInterpolator emptyPath;
+	pts.clear();
+	res = CObservationVelodyneScan::TGeneratePointCloudSE3Results();
+	obs.generatePointCloudAlongSE3Trajectory(emptyPath, pts, res);
+	EXPECT_EQ(res.num_points, pc.size());
+	EXPECT_EQ(res.num_correctly_inserted_points, 0u);
+	EXPECT_TRUE(pts.empty());
+}
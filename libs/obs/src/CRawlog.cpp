@@ -11,6 +11,7 @@
 
 #include <mrpt/system/filesystem.h>
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogIndex.h>
 #include <mrpt/io/CFileInputStream.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
@@ -267,6 +268,56 @@ bool CRawlog::loadFromRawLogFile(
 	return true;
 }
 
+bool CRawlog::loadFromRawLogFileIndexed(
+	const std::string& fileName, mrpt::system::TTimeStamp time_start,
+	mrpt::system::TTimeStamp time_end, const std::string& sensorLabel)
+{
+	CRawlogIndex idx;
+	if (!idx.loadOrBuild(fileName)) return false;
+
+	CFileGZInputStream fi(fileName);
+	if (!fi.fileOpenCorrectly()) return false;
+
+	clear();  // Clear first
+
+	// Comments are kept apart, regardless of their timestamp:
+	std::vector<size_t> toRead;
+	for (size_t i = 0; i < idx.size(); i++)
+		if (idx.entries[i].className == "CObservationComment")
+			toRead.push_back(i);
+	for (size_t i : idx.findEntries(time_start, time_end, sensorLabel))
+	{
+		const auto& e = idx.entries[i];
+		if (e.className == "CObservationComment") continue;
+		const auto* cls = mrpt::rtti::findRegisteredClass(e.className);
+		if (!cls) continue;
+		if (cls->derivedFrom(CLASS_ID(CObservation)) ||
+			cls == CLASS_ID(CSensoryFrame) ||
+			cls == CLASS_ID(CActionCollection))
+			toRead.push_back(i);
+	}
+	std::sort(toRead.begin(), toRead.end());
+
+	try
+	{
+		for (size_t i : toRead)
+		{
+			CSerializable::Ptr obj = idx.readEntry(fi, i);
+			if (IS_CLASS(obj, CObservationComment))
+				m_commentTexts =
+					*std::dynamic_pointer_cast<CObservationComment>(obj);
+			else
+				m_seqOfActObs.push_back(obj);
+		}
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
 void CRawlog::remove(size_t index)
 {
 	MRPT_START
@@ -291,7 +342,8 @@ bool CRawlog::saveToRawLogFile(const std::string& fileName) const
 {
 	try
 	{
-		CFileGZOutputStream fo(fileName);
+		CFileGZOutputStream fo;
+		if (!fo.openBlockCompressed(fileName)) return false;
 		auto f = archiveFrom(fo);
 		if (!m_commentTexts.text.empty()) f << m_commentTexts;
 		for (size_t i = 0; i < m_seqOfActObs.size(); i++)
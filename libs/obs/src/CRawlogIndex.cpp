@@ -0,0 +1,190 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace mrpt::serialization;
+
+// Header of index files:
+static const std::string INDEX_FILE_MAGIC("MRPT_RAWLOG_INDEX");
+static const uint8_t INDEX_FILE_VERSION = 0;
+
+std::string CRawlogIndex::indexFileNameFor(const std::string& rawlogFile)
+{
+	return rawlogFile + std::string(".idx");
+}
+
+void CRawlogIndex::clear()
+{
+	entries.clear();
+	rawlogFileSize = 0;
+	rawlogFileModificationTime = 0;
+}
+
+bool CRawlogIndex::buildFromRawlogFile(const std::string& rawlogFile)
+{
+	clear();
+	if (!fileExists(rawlogFile)) return false;
+	CFileGZInputStream fi(rawlogFile);
+	if (!fi.fileOpenCorrectly()) return false;
+	auto arch = archiveFrom(fi);
+
+	rawlogFileSize = getFileSize(rawlogFile);
+	rawlogFileModificationTime = getFileModificationTime(rawlogFile);
+
+	for (;;)
+	{
+		TEntry e;
+		e.offset = fi.getPosition();
+		CSerializable::Ptr obj;
+		try
+		{
+			obj = arch.ReadObject();
+		}
+		catch (std::exception&)
+		{
+			// EOF or an invalid object: stop here, like
+			// CRawlog::loadFromRawLogFile()
+			break;
+		}
+		if (!obj) break;
+		e.className = obj->GetRuntimeClass()->className;
+
+		if (IS_DERIVED(obj, CObservation))
+		{
+			const auto o = std::dynamic_pointer_cast<CObservation>(obj);
+			e.timestamp = o->timestamp;
+			e.sensorLabel = o->sensorLabel;
+		}
+		else if (IS_CLASS(obj, CSensoryFrame))
+		{
+			const auto sf = std::dynamic_pointer_cast<CSensoryFrame>(obj);
+			for (const auto& o : *sf)
+				if (o->timestamp != INVALID_TIMESTAMP &&
+					(e.timestamp == INVALID_TIMESTAMP ||
+					 o->timestamp < e.timestamp))
+					e.timestamp = o->timestamp;
+		}
+		else if (IS_CLASS(obj, CActionCollection))
+		{
+			const CActionCollection& acts =
+				*std::dynamic_pointer_cast<CActionCollection>(obj);
+			if (acts.begin() != acts.end())
+				e.timestamp = acts.get(0).timestamp;
+		}
+		entries.emplace_back(std::move(e));
+	}
+	return true;
+}
+
+bool CRawlogIndex::saveToFile(const std::string& indexFile) const
+{
+	try
+	{
+		CFileOutputStream fo(indexFile);
+		auto f = archiveFrom(fo);
+		f << INDEX_FILE_MAGIC << INDEX_FILE_VERSION << rawlogFileSize
+		  << rawlogFileModificationTime;
+		f.WriteAs<uint64_t>(entries.size());
+		for (const auto& e : entries)
+			f << e.offset << e.timestamp << e.className << e.sensorLabel;
+		return true;
+	}
+	catch (std::exception&)
+	{
+		return false;
+	}
+}
+
+bool CRawlogIndex::loadFromFile(const std::string& indexFile)
+{
+	clear();
+	try
+	{
+		if (!fileExists(indexFile)) return false;
+		CFileInputStream fi(indexFile);
+		auto f = archiveFrom(fi);
+		std::string magic;
+		f >> magic;
+		if (magic != INDEX_FILE_MAGIC) return false;
+		uint8_t version;
+		f >> version;
+		if (version != INDEX_FILE_VERSION) return false;
+		f >> rawlogFileSize >> rawlogFileModificationTime;
+		entries.resize(f.ReadAs<uint64_t>());
+		for (auto& e : entries)
+			f >> e.offset >> e.timestamp >> e.className >> e.sensorLabel;
+		return true;
+	}
+	catch (std::exception&)
+	{
+		clear();
+		return false;
+	}
+}
+
+bool CRawlogIndex::isUpToDate(const std::string& rawlogFile) const
+{
+	return fileExists(rawlogFile) &&
+		   getFileSize(rawlogFile) == rawlogFileSize &&
+		   uint64_t(getFileModificationTime(rawlogFile)) ==
+			   rawlogFileModificationTime;
+}
+
+bool CRawlogIndex::loadOrBuild(const std::string& rawlogFile, bool saveIfBuilt)
+{
+	const std::string indexFile = indexFileNameFor(rawlogFile);
+	if (loadFromFile(indexFile) && isUpToDate(rawlogFile)) return true;
+	if (!buildFromRawlogFile(rawlogFile)) return false;
+	// Not being able to save the index (e.g. read-only dirs) is not an error:
+	if (saveIfBuilt) saveToFile(indexFile);
+	return true;
+}
+
+std::vector<size_t> CRawlogIndex::findEntries(
+	mrpt::system::TTimeStamp time_start, mrpt::system::TTimeStamp time_end,
+	const std::string& sensorLabel) const
+{
+	std::vector<size_t> found;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const auto& e = entries[i];
+		if (e.timestamp == INVALID_TIMESTAMP || e.timestamp < time_start ||
+			e.timestamp >= time_end)
+			continue;
+		if (!sensorLabel.empty() && e.sensorLabel != sensorLabel) continue;
+		found.push_back(i);
+	}
+	return found;
+}
+
+CSerializable::Ptr CRawlogIndex::readEntry(
+	mrpt::io::CFileGZInputStream& rawlog, size_t index) const
+{
+	MRPT_START
+	ASSERT_BELOW_(index, entries.size());
+	// Do not seek when reading consecutive entries:
+	if (rawlog.getPosition() != entries[index].offset)
+		rawlog.Seek(entries[index].offset);
+	auto arch = archiveFrom(rawlog);
+	return arch.ReadObject();
+	MRPT_END
+}
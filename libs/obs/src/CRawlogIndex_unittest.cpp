@@ -0,0 +1,225 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogIndex.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+const TTimeStamp t0 = time_tToTimestamp(1500000000.0);
+
+// A rawlog of observations from two sensors, "ODOM" and "LASER":
+CRawlog createTestRawlog(size_t N)
+{
+	CRawlog rawlog;
+	rawlog.setCommentText("A comment");
+	for (size_t i = 0; i < N; i++)
+	{
+		CObservation::Ptr obs;
+		if (i % 3 == 0)
+		{
+			auto o = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+			o->resizeScan(10);
+			o->sensorLabel = "LASER";
+			obs = o;
+		}
+		else
+		{
+			auto o = mrpt::make_aligned_shared<CObservationOdometry>();
+			o->odometry.x(i);
+			o->sensorLabel = "ODOM";
+			obs = o;
+		}
+		obs->timestamp = t0 + i * 1000000;  // 0.1 s
+		rawlog.addObservationMemoryReference(obs);
+	}
+	return rawlog;
+}
+
+void checkIndexedLoad(const std::string& file, size_t N)
+{
+	CRawlog all;
+	ASSERT_TRUE(all.loadFromRawLogFile(file));
+	ASSERT_EQ(all.size(), N);
+
+	for (const std::string label : {"", "ODOM", "LASER", "NONE"})
+	{
+		const TTimeStamp t1 = t0 + 25 * 1000000, t2 = t0 + 60 * 1000000;
+		CRawlog part;
+		ASSERT_TRUE(part.loadFromRawLogFileIndexed(file, t1, t2, label));
+		EXPECT_EQ(part.getCommentText(), "A comment");
+
+		size_t k = 0;
+		for (size_t i = 0; i < all.size(); i++)
+		{
+			const auto o = all.getAsObservation(i);
+			if (o->timestamp < t1 || o->timestamp >= t2) continue;
+			if (!label.empty() && o->sensorLabel != label) continue;
+			ASSERT_LT(k, part.size());
+			const auto p = part.getAsObservation(k++);
+			EXPECT_EQ(p->timestamp, o->timestamp);
+			EXPECT_EQ(p->sensorLabel, o->sensorLabel);
+			EXPECT_EQ(p->GetRuntimeClass(), o->GetRuntimeClass());
+		}
+		EXPECT_EQ(k, part.size());
+	}
+}
+}  // namespace
+
+TEST(CRawlogIndex, buildSaveLoadAndQuery)
+{
+	const size_t N = 100;
+	const std::string file = getTempFileName() + ".rawlog";
+	ASSERT_TRUE(createTestRawlog(N).saveToRawLogFile(file));
+
+	CRawlogIndex idx;
+	ASSERT_TRUE(idx.buildFromRawlogFile(file));
+	ASSERT_EQ(idx.size(), N + 1);  // plus the comment
+	EXPECT_EQ(idx.entries[0].className, "CObservationComment");
+	EXPECT_EQ(idx.entries[0].offset, 0u);
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& e = idx.entries[i + 1];
+		EXPECT_EQ(e.timestamp, t0 + i * 1000000);
+		EXPECT_EQ(e.sensorLabel, (i % 3 == 0) ? "LASER" : "ODOM");
+		EXPECT_GT(e.offset, idx.entries[i].offset);
+	}
+	EXPECT_TRUE(idx.isUpToDate(file));
+
+	// Time and label queries:
+	const auto found = idx.findEntries(t0 + 10 * 1000000, t0 + 20 * 1000000);
+	EXPECT_EQ(found.size(), 10u);
+	EXPECT_EQ(
+		idx.findEntries(INVALID_TIMESTAMP, t0 + 1000000000, "LASER").size(),
+		34u);
+
+	// Random access, in any order:
+	mrpt::io::CFileGZInputStream f(file);
+	for (size_t i : {50, 7, 8, 99, 1, 3})
+	{
+		auto o = std::dynamic_pointer_cast<CObservation>(idx.readEntry(f, i));
+		ASSERT_TRUE(o);
+		EXPECT_EQ(o->timestamp, idx.entries[i].timestamp);
+		if (auto odo = std::dynamic_pointer_cast<CObservationOdometry>(o))
+			EXPECT_EQ(odo->odometry.x(), i - 1);
+	}
+	f.close();
+
+	// Save & load the index:
+	const std::string idxFile = CRawlogIndex::indexFileNameFor(file);
+	ASSERT_TRUE(idx.saveToFile(idxFile));
+	CRawlogIndex idx2;
+	ASSERT_TRUE(idx2.loadFromFile(idxFile));
+	ASSERT_EQ(idx2.size(), idx.size());
+	for (size_t i = 0; i < idx.size(); i++)
+	{
+		EXPECT_EQ(idx2.entries[i].offset, idx.entries[i].offset);
+		EXPECT_EQ(idx2.entries[i].timestamp, idx.entries[i].timestamp);
+		EXPECT_EQ(idx2.entries[i].className, idx.entries[i].className);
+		EXPECT_EQ(idx2.entries[i].sensorLabel, idx.entries[i].sensorLabel);
+	}
+	EXPECT_TRUE(idx2.isUpToDate(file));
+
+	// A different rawlog in the same file makes the index outdated:
+	ASSERT_TRUE(createTestRawlog(N / 2).saveToRawLogFile(file));
+	EXPECT_FALSE(idx2.isUpToDate(file));
+	ASSERT_TRUE(idx2.loadOrBuild(file));
+	EXPECT_EQ(idx2.size(), N / 2 + 1);
+
+	deleteFile(file);
+	deleteFile(idxFile);
+}
+
+TEST(CRawlogIndex, loadIndexedCompressedAndPlain)
+{
+	const size_t N = 100;
+	const auto rawlog = createTestRawlog(N);
+
+	// gz-compressed rawlog:
+	const std::string gzFile = getTempFileName() + ".rawlog";
+	ASSERT_TRUE(rawlog.saveToRawLogFile(gzFile));
+	checkIndexedLoad(gzFile, N);
+	// The index was saved, and it is reused:
+	EXPECT_TRUE(fileExists(CRawlogIndex::indexFileNameFor(gzFile)));
+	checkIndexedLoad(gzFile, N);
+
+	// Uncompressed rawlog:
+	const std::string plainFile = getTempFileName() + ".rawlog";
+	{
+		mrpt::io::CFileOutputStream fo(plainFile);
+		auto f = mrpt::serialization::archiveFrom(fo);
+		CObservationComment comment;
+		comment.text = rawlog.getCommentText();
+		f << comment;
+		for (size_t i = 0; i < rawlog.size(); i++)
+			f << *rawlog.getAsGeneric(i);
+	}
+	checkIndexedLoad(plainFile, N);
+
+	for (const auto& file : {gzFile, plainFile})
+	{
+		deleteFile(file);
+		deleteFile(CRawlogIndex::indexFileNameFor(file));
+	}
+}
+
+TEST(CRawlogIndex, actionsAndSensoryFrames)
+{
+	CRawlog rawlog;
+	for (size_t i = 0; i < 20; i++)
+	{
+		CActionRobotMovement2D act;
+		act.timestamp = t0 + (2 * i) * 1000000;
+		rawlog.addAction(act);
+		CSensoryFrame sf;
+		auto o = mrpt::make_aligned_shared<CObservationOdometry>();
+		o->timestamp = t0 + (2 * i + 1) * 1000000;
+		sf.insert(o);
+		rawlog.addObservations(sf);
+	}
+	const std::string file = getTempFileName() + ".rawlog";
+	ASSERT_TRUE(rawlog.saveToRawLogFile(file));
+
+	CRawlogIndex idx;
+	ASSERT_TRUE(idx.buildFromRawlogFile(file));
+	ASSERT_EQ(idx.size(), 40u);
+	for (size_t i = 0; i < 40; i++)
+	{
+		EXPECT_EQ(idx.entries[i].timestamp, t0 + i * 1000000);
+		EXPECT_EQ(
+			idx.entries[i].className,
+			(i % 2) ? "CSensoryFrame" : "CActionCollection");
+	}
+
+	// Load the action/SF pairs #5 to #9:
+	CRawlog part;
+	ASSERT_TRUE(part.loadFromRawLogFileIndexed(
+		file, t0 + 10 * 1000000, t0 + 20 * 1000000));
+	ASSERT_EQ(part.size(), 10u);
+	size_t entry = 0;
+	CActionCollection::Ptr acts;
+	CSensoryFrame::Ptr sf;
+	ASSERT_TRUE(part.getActionObservationPair(acts, sf, entry));
+	EXPECT_EQ(acts->get(0)->timestamp, t0 + 10 * 1000000);
+
+	deleteFile(file);
+	deleteFile(CRawlogIndex::indexFileNameFor(file));
+}
@@ -0,0 +1,201 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/obs/CRawlogPrefetchReader.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/system/filesystem.h>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
+using namespace mrpt::obs;
+
+namespace
+{
+struct TEntry
+{
+	CActionCollection::Ptr action;
+	CSensoryFrame::Ptr observations;
+	CObservation::Ptr observation;
+	std::size_t rawlogEntry{0};
+	/** Loading of externally-stored data, if enabled */
+	std::future<void> loaded;
+};
+
+void loadExternalData(
+	const CSensoryFrame::Ptr& sf, const CObservation::Ptr& obs)
+{
+	// Errors (e.g. missing image files) are left to be reported when the
+	// user accesses the data:
+	try
+	{
+		if (obs) obs->load();
+		if (sf)
+			for (const auto& o : *sf) o->load();
+	}
+	catch (std::exception&)
+	{
+	}
+}
+}  // namespace
+
+struct CRawlogPrefetchReader::Impl
+{
+	mrpt::io::CFileGZInputStream in;
+	CRawlogPrefetchReader::TOptions options;
+	mrpt::WorkerThreadsPool loadPool;
+
+	std::mutex mtx;
+	/** Signals new entries, or the end of the file */
+	std::condition_variable cvEntries;
+	/** Signals free space in the queue, or a request to stop */
+	std::condition_variable cvSpace;
+	std::deque<TEntry> queue;
+	bool endOfFile{false};
+	bool stop{false};
+
+	std::thread reader;
+
+	void readerThread()
+	{
+		auto arch = mrpt::serialization::archiveFrom(in);
+		arch.setObjectPool(options.objectPool.get());
+		std::size_t rawlogEntry = 0;
+		for (;;)
+		{
+			{
+				// Once the queue is full, wait for it to be half empty, so the
+				// threads do not alternate at every entry:
+				std::unique_lock<std::mutex> lock(mtx);
+				if (queue.size() >= options.queueLength)
+					cvSpace.wait(lock, [this] {
+						return stop || queue.size() <= options.queueLength / 2;
+					});
+				if (stop) return;
+			}
+			TEntry e;
+			const bool ok = CRawlog::getActionObservationPairOrObservation(
+				arch, e.action, e.observations, e.observation, rawlogEntry);
+			if (ok)
+			{
+				e.rawlogEntry = rawlogEntry;
+				if (loadPool.size())
+					e.loaded = loadPool.enqueue(
+						&loadExternalData, e.observations, e.observation);
+				else if (options.loadExternalData)
+					loadExternalData(e.observations, e.observation);
+			}
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				if (ok)
+					queue.push_back(std::move(e));
+				else
+					endOfFile = true;
+			}
+			cvEntries.notify_one();
+			if (!ok) return;
+		}
+	}
+};
+
+CRawlogPrefetchReader::TOptions::TOptions()
+	: queueLength(16), loadExternalData(true), loadThreads(0)
+{
+}
+
+CRawlogPrefetchReader::CRawlogPrefetchReader() {}
+CRawlogPrefetchReader::CRawlogPrefetchReader(
+	const std::string& rawlogFile, const TOptions& options)
+{
+	MRPT_START
+	if (!open(rawlogFile, options))
+		THROW_EXCEPTION_FMT(
+			"Error trying to open rawlog file: '%s'", rawlogFile.c_str());
+	MRPT_END
+}
+
+CRawlogPrefetchReader::~CRawlogPrefetchReader() { close(); }
+bool CRawlogPrefetchReader::open(
+	const std::string& rawlogFile, const TOptions& options)
+{
+	MRPT_START
+	close();
+	ASSERT_(options.queueLength > 0);
+
+	if (!mrpt::system::fileExists(rawlogFile)) return false;
+	m_impl.reset(new Impl);
+	if (!m_impl->in.open(rawlogFile))
+	{
+		m_impl.reset();
+		return false;
+	}
+	m_impl->options = options;
+	if (options.loadExternalData && options.loadThreads)
+		m_impl->loadPool.resize(options.loadThreads);
+	Impl* impl = m_impl.get();
+	impl->reader = std::thread([impl] { impl->readerThread(); });
+	return true;
+	MRPT_END
+}
+
+void CRawlogPrefetchReader::close()
+{
+	if (!m_impl) return;
+	{
+		std::unique_lock<std::mutex> lock(m_impl->mtx);
+		m_impl->stop = true;
+	}
+	m_impl->cvSpace.notify_one();
+	if (m_impl->reader.joinable()) m_impl->reader.join();
+	// Wait for any pending load before destroying the entries:
+	for (auto& e : m_impl->queue)
+		if (e.loaded.valid()) e.loaded.wait();
+	m_impl.reset();
+}
+
+bool CRawlogPrefetchReader::isOpen() const { return m_impl != nullptr; }
+bool CRawlogPrefetchReader::getActionObservationPairOrObservation(
+	CActionCollection::Ptr& action, CSensoryFrame::Ptr& observations,
+	CObservation::Ptr& observation, std::size_t& rawlogEntry)
+{
+	action.reset();
+	observations.reset();
+	observation.reset();
+	if (!m_impl) return false;
+
+	TEntry e;
+	bool lowQueue;
+	{
+		std::unique_lock<std::mutex> lock(m_impl->mtx);
+		m_impl->cvEntries.wait(lock, [this] {
+			return !m_impl->queue.empty() || m_impl->endOfFile;
+		});
+		if (m_impl->queue.empty()) return false;
+		e = std::move(m_impl->queue.front());
+		m_impl->queue.pop_front();
+		lowQueue = m_impl->queue.size() <= m_impl->options.queueLength / 2;
+	}
+	if (lowQueue) m_impl->cvSpace.notify_one();
+
+	if (e.loaded.valid()) e.loaded.get();
+	action = std::move(e.action);
+	observations = std::move(e.observations);
+	observation = std::move(e.observation);
+	rawlogEntry = e.rawlogEntry;
+	return true;
+}
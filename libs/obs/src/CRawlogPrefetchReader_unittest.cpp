@@ -0,0 +1,127 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CRawlogPrefetchReader.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace std;
+
+namespace
+{
+// A rawlog mixing action/sensory frame pairs and single observations:
+std::string createTestRawlogFile(size_t N)
+{
+	CRawlog rawlog;
+	for (size_t i = 0; i < N; i++)
+	{
+		auto o = mrpt::make_aligned_shared<CObservationOdometry>();
+		o->odometry.x(i);
+		o->sensorLabel = "ODOM";
+		if (i % 4 == 0)
+		{
+			CActionCollection acts;
+			CActionRobotMovement2D act;
+			act.computeFromOdometry(
+				mrpt::poses::CPose2D(0.1, 0, 0),
+				CActionRobotMovement2D::TMotionModelOptions());
+			acts.insert(act);
+			CSensoryFrame sf;
+			sf.insert(o);
+			rawlog.addActions(acts);
+			rawlog.addObservations(sf);
+		}
+		else
+			rawlog.addObservationMemoryReference(o);
+	}
+	const std::string file = mrpt::system::getTempFileName() + ".rawlog";
+	EXPECT_TRUE(rawlog.saveToRawLogFile(file));
+	return file;
+}
+
+double odometryX(const CSensoryFrame::Ptr& sf, const CObservation::Ptr& obs)
+{
+	CObservation::Ptr o = obs ? obs : *sf->begin();
+	return std::dynamic_pointer_cast<CObservationOdometry>(o)->odometry.x();
+}
+}  // namespace
+
+TEST(CRawlogPrefetchReader, SameEntriesAsSequentialReading)
+{
+	const size_t N = 200;
+	const std::string file = createTestRawlogFile(N);
+
+	for (size_t loadThreads : {0, 2})
+	{
+		CRawlogPrefetchReader::TOptions opts;
+		opts.queueLength = 4;
+		opts.loadThreads = loadThreads;
+		if (loadThreads)
+		{
+			opts.objectPool =
+				std::make_shared<mrpt::serialization::CSerializablePool>();
+			opts.objectPool->enableClass<CObservationOdometry>();
+		}
+		CRawlogPrefetchReader reader(file, opts);
+
+		mrpt::io::CFileGZInputStream f(file);
+		auto arch = mrpt::serialization::archiveFrom(f);
+
+		CActionCollection::Ptr act1, act2;
+		CSensoryFrame::Ptr sf1, sf2;
+		CObservation::Ptr obs1, obs2;
+		size_t entry1 = 0, entry2 = 0, count = 0;
+		while (CRawlog::getActionObservationPairOrObservation(
+			arch, act1, sf1, obs1, entry1))
+		{
+			ASSERT_TRUE(reader.getActionObservationPairOrObservation(
+				act2, sf2, obs2, entry2));
+			EXPECT_EQ(entry1, entry2);
+			EXPECT_EQ(!!act1, !!act2);
+			EXPECT_EQ(!!sf1, !!sf2);
+			EXPECT_EQ(!!obs1, !!obs2);
+			EXPECT_EQ(odometryX(sf2, obs2), double(count));
+			count++;
+		}
+		EXPECT_EQ(count, N);
+		// End of file:
+		EXPECT_FALSE(reader.getActionObservationPairOrObservation(
+			act2, sf2, obs2, entry2));
+		EXPECT_FALSE(act2 || sf2 || obs2);
+	}
+	mrpt::system::deleteFile(file);
+}
+
+TEST(CRawlogPrefetchReader, CloseBeforeTheEnd)
+{
+	const std::string file = createTestRawlogFile(100);
+	CRawlogPrefetchReader::TOptions opts;
+	opts.queueLength = 2;
+	CRawlogPrefetchReader reader(file, opts);
+	CActionCollection::Ptr act;
+	CSensoryFrame::Ptr sf;
+	CObservation::Ptr obs;
+	size_t entry = 0;
+	EXPECT_TRUE(reader.getActionObservationPairOrObservation(
+		act, sf, obs, entry));
+	reader.close();
+	EXPECT_FALSE(reader.isOpen());
+	EXPECT_FALSE(reader.getActionObservationPairOrObservation(
+		act, sf, obs, entry));
+
+	EXPECT_FALSE(reader.open(file + ".missing"));
+	mrpt::system::deleteFile(file);
+}
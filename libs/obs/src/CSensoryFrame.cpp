@@ -11,10 +11,13 @@
 
 #include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/metaprogramming_serialization.h>
 #include <mrpt/system/os.h>
 #include <iterator>
+#include <list>
+#include <mutex>
 
 using namespace mrpt::obs;
 using namespace mrpt::poses;
@@ -23,16 +26,39 @@ using namespace std;
 
 IMPLEMENTS_SERIALIZABLE(CSensoryFrame, CSerializable, mrpt::obs)
 
+struct CSensoryFrame::TLazyFile
+{
+	std::mutex mtx;
+	mrpt::io::CFileGZInputStream in;
+	size_t maxLoadedFrames = 0;
+	/** Frames with their observations in memory, most recently used first */
+	std::list<const CSensoryFrame*> lru;
+};
+
+struct CSensoryFrame::TLazyState
+{
+	std::shared_ptr<TLazyFile> file;
+	uint64_t offset = 0;
+	bool loaded = false;
+	/** Number of TObservationsPin on this frame */
+	size_t pins = 0;
+	/** Only if loaded */
+	std::list<const CSensoryFrame*>::iterator lruIt;
+};
+
+CSensoryFrame::CSensoryFrame() = default;
 CSensoryFrame::CSensoryFrame(const CSensoryFrame& o) : m_observations()
 {
 	*this = o;
 }
 
+CSensoryFrame::~CSensoryFrame() { internal_dropLazy(); }
 CSensoryFrame& CSensoryFrame::operator=(const CSensoryFrame& o)
 {
 	MRPT_START
-	clear();
 	if (this == &o) return *this;  // It may be used sometimes
+	clear();
+	const TObservationsPin pin(o);
 	m_observations = o.m_observations;
 	m_cachedMap.reset();
 	return *this;
@@ -41,13 +67,136 @@ CSensoryFrame& CSensoryFrame::operator=(const CSensoryFrame& o)
 
 void CSensoryFrame::clear()
 {
+	internal_dropLazy();
 	m_observations.clear();
 	m_cachedMap.reset();
 }
 
+std::shared_ptr<CSensoryFrame::TLazyFile> CSensoryFrame::OpenLazyFile(
+	const std::string& fileName, size_t maxLoadedFrames)
+{
+	auto file = std::make_shared<TLazyFile>();
+	if (!file->in.open(fileName))
+		THROW_EXCEPTION_FMT("Cannot open file: '%s'", fileName.c_str());
+	file->maxLoadedFrames = maxLoadedFrames;
+	return file;
+}
+
+CSensoryFrame::Ptr CSensoryFrame::CreateLazy(
+	const std::shared_ptr<TLazyFile>& file, uint64_t offset)
+{
+	ASSERT_(file);
+	auto sf = CSensoryFrame::Create();
+	sf->m_lazy.reset(new TLazyState);
+	sf->m_lazy->file = file;
+	sf->m_lazy->offset = offset;
+	return sf;
+}
+
+bool CSensoryFrame::observationsLoaded() const
+{
+	if (!m_lazy) return true;
+	std::lock_guard<std::mutex> lck(m_lazy->file->mtx);
+	return m_lazy->loaded;
+}
+
+void CSensoryFrame::loadObservations() const
+{
+	if (m_lazy) internal_loadLazy(false);
+}
+
+void CSensoryFrame::internal_loadLazy(bool pin) const
+{
+	TLazyFile& f = *m_lazy->file;
+	std::lock_guard<std::mutex> lck(f.mtx);
+
+	if (m_lazy->loaded)
+	{
+		// Mark as most recently used:
+		if (m_lazy->lruIt != f.lru.begin())
+			f.lru.splice(f.lru.begin(), f.lru, m_lazy->lruIt);
+		if (pin) m_lazy->pins++;
+		return;
+	}
+
+	MRPT_START
+	f.in.Seek(m_lazy->offset);
+	auto sf =
+		mrpt::serialization::archiveFrom(f.in).ReadObject<CSensoryFrame>();
+	ASSERT_(sf);
+	m_observations.swap(sf->m_observations);
+	m_cachedMap.reset();
+	MRPT_END
+
+	m_lazy->loaded = true;
+	if (pin) m_lazy->pins++;
+	f.lru.push_front(this);
+	m_lazy->lruIt = f.lru.begin();
+
+	// Evict the least recently used frames, if over budget, but never this
+	// one or pinned ones:
+	for (auto it = f.lru.end();
+		 f.maxLoadedFrames && f.lru.size() > f.maxLoadedFrames &&
+		 it != f.lru.begin();)
+	{
+		const CSensoryFrame* victim = *(--it);
+		if (victim == this || victim->m_lazy->pins) continue;
+		it = f.lru.erase(it);
+		victim->m_lazy->loaded = false;
+		victim->m_observations.clear();
+		victim->m_cachedMap.reset();
+	}
+}
+
+CSensoryFrame::TObservationsPin::TObservationsPin(const CSensoryFrame& sf)
+	: m_sf(sf)
+{
+	if (m_sf.m_lazy) m_sf.internal_loadLazy(true);
+}
+
+CSensoryFrame::TObservationsPin::~TObservationsPin()
+{
+	// The frame may have been detached from its file meanwhile:
+	if (!m_sf.m_lazy) return;
+	std::lock_guard<std::mutex> lck(m_sf.m_lazy->file->mtx);
+	m_sf.m_lazy->pins--;
+}
+
+void CSensoryFrame::unloadObservations() const
+{
+	if (!m_lazy) return;
+	TLazyFile& f = *m_lazy->file;
+	std::lock_guard<std::mutex> lck(f.mtx);
+	if (!m_lazy->loaded || m_lazy->pins) return;
+	f.lru.erase(m_lazy->lruIt);
+	m_lazy->loaded = false;
+	m_observations.clear();
+	m_cachedMap.reset();
+}
+
+void CSensoryFrame::detachFromFile()
+{
+	if (!m_lazy) return;
+	// Pinned, so it is not freed before leaving the LRU:
+	internal_loadLazy(true);
+	internal_dropLazy();
+}
+
+void CSensoryFrame::internal_dropLazy()
+{
+	if (!m_lazy) return;
+	{
+		TLazyFile& f = *m_lazy->file;
+		std::lock_guard<std::mutex> lck(f.mtx);
+		if (m_lazy->loaded) f.lru.erase(m_lazy->lruIt);
+	}
+	m_lazy.reset();
+}
+
 uint8_t CSensoryFrame::serializeGetVersion() const { return 2; }
 void CSensoryFrame::serializeTo(mrpt::serialization::CArchive& out) const
 {
+	const TObservationsPin pin(*this);
 	out.WriteAs<uint32_t>(m_observations.size());
 	for (const auto& o : m_observations)
 	{
@@ -105,6 +254,7 @@ void CSensoryFrame::serializeFrom(
 void CSensoryFrame::operator+=(const CSensoryFrame& sf)
 {
 	MRPT_UNUSED_PARAM(sf);
+	detachFromFile();
 	m_cachedMap.reset();
 	for (const_iterator it = begin(); it != end(); ++it)
 	{
@@ -120,6 +270,7 @@ void CSensoryFrame::operator+=(const CSensoryFrame& sf)
   ---------------------------------------------------------------*/
 void CSensoryFrame::operator+=(const CObservation::Ptr& obs)
 {
+	detachFromFile();
 	m_cachedMap.reset();
 	m_observations.push_back(obs);
 }
@@ -129,6 +280,7 @@ void CSensoryFrame::operator+=(const CObservation::Ptr& obs)
   ---------------------------------------------------------------*/
 void CSensoryFrame::push_back(const CObservation::Ptr& obs)
 {
+	detachFromFile();
 	m_cachedMap.reset();
 	m_observations.push_back(obs);
 }
@@ -138,6 +290,7 @@ void CSensoryFrame::push_back(const CObservation::Ptr& obs)
   ---------------------------------------------------------------*/
 void CSensoryFrame::insert(const CObservation::Ptr& obs)
 {
+	detachFromFile();
 	m_cachedMap.reset();
 	m_observations.push_back(obs);
 }
@@ -148,6 +301,7 @@ void CSensoryFrame::insert(const CObservation::Ptr& obs)
 void CSensoryFrame::eraseByIndex(const size_t& idx)
 {
 	MRPT_START
+	detachFromFile();
 	if (idx >= size())
 		THROW_EXCEPTION_FMT(
 			"Index %u out of range.", static_cast<unsigned>(idx));
@@ -166,6 +320,7 @@ void CSensoryFrame::eraseByIndex(const size_t& idx)
 CObservation::Ptr CSensoryFrame::getObservationByIndex(const size_t& idx) const
 {
 	MRPT_START
+	const TObservationsPin pin(*this);
 	if (idx >= size())
 		THROW_EXCEPTION_FMT(
 			"Index %u out of range.", static_cast<unsigned>(idx));
@@ -182,6 +337,7 @@ CObservation::Ptr CSensoryFrame::getObservationByIndex(const size_t& idx) const
 CSensoryFrame::iterator CSensoryFrame::erase(const iterator& it)
 {
 	MRPT_START
+	detachFromFile();
 	ASSERT_(it != end());
 	m_cachedMap.reset();
 
@@ -197,6 +353,7 @@ CObservation::Ptr CSensoryFrame::getObservationBySensorLabel(
 {
 	MRPT_START
 
+	const TObservationsPin pin(*this);
 	size_t foundCount = 0;
 	for (const_iterator it = begin(); it != end(); ++it)
 		if (!os::_strcmpi((*it)->sensorLabel.c_str(), label.c_str()))
@@ -212,6 +369,8 @@ CObservation::Ptr CSensoryFrame::getObservationBySensorLabel(
   ---------------------------------------------------------------*/
 void CSensoryFrame::moveFrom(CSensoryFrame& sf)
 {
+	detachFromFile();
+	sf.detachFromFile();
 	copy(
 		sf.m_observations.begin(), sf.m_observations.end(),
 		back_inserter(m_observations));
@@ -224,6 +383,8 @@ void CSensoryFrame::moveFrom(CSensoryFrame& sf)
   ---------------------------------------------------------------*/
 void CSensoryFrame::swap(CSensoryFrame& sf)
 {
+	detachFromFile();
+	sf.detachFromFile();
 	m_observations.swap(sf.m_observations);
 	std::swap(m_cachedMap, sf.m_cachedMap);
 }
@@ -233,6 +394,7 @@ void CSensoryFrame::swap(CSensoryFrame& sf)
   ---------------------------------------------------------------*/
 void CSensoryFrame::eraseByLabel(const std::string& label)
 {
+	detachFromFile();
 	for (iterator it = begin(); it != end();)
 	{
 		if (!os::_strcmpi((*it)->sensorLabel.c_str(), label.c_str()))
@@ -270,6 +432,7 @@ void CSensoryFrame::internal_buildAuxPointsMap(const void* options) const
 			"[CSensoryFrame::buildAuxPointsMap] ERROR: This function needs "
 			"linking against mrpt-maps.\n");
 
+	const TObservationsPin pin(*this);
 	for (const_iterator it = begin(); it != end(); ++it)
 		if (IS_CLASS(*it, CObservation2DRangeScan))
 			(*ptr_internal_build_points_map_from_scan2D)(
@@ -280,6 +443,7 @@ void CSensoryFrame::internal_buildAuxPointsMap(const void* options) const
 bool CSensoryFrame::insertObservationsInto(
 	mrpt::maps::CMetricMap* theMap, const CPose3D* robotPose) const
 {
+	const TObservationsPin pin(*this);
 	bool anyone = false;
 	for (const_iterator it = begin(); it != end(); ++it)
 		anyone |= (*it)->insertObservationInto(theMap, robotPose);
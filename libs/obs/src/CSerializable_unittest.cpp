@@ -11,6 +11,7 @@
 #include <mrpt/obs.h>
 
 #include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CSerializablePool.h>
 #include <gtest/gtest.h>
 #include <CTraitsTest.h>
 #include <sstream>
@@ -156,3 +157,35 @@ TEST(Observations, CopyCtorAssignOp)
 	run_copy_tests<CObservationIMU>();
 	run_copy_tests<CObservationOdometry>();
 }
+
+// Recycled observations, also when nested in sensory frames, keep their
+// buffers:
+TEST(Observations, ReadFromObjectPool)
+{
+	CMemoryStream buf;
+	auto arch = archiveFrom(buf);
+	for (size_t i = 0; i < 3; i++)
+	{
+		auto scan = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+		scan->resizeScanAndAssign(361, 1.0f + i, true);
+		CSensoryFrame sf;
+		sf.insert(scan);
+		arch << sf;
+	}
+
+	CSerializablePool pool;
+	pool.enableClass<CObservation2DRangeScan>();
+	buf.Seek(0);
+	const float* scanData = nullptr;
+	for (size_t i = 0; i < 3; i++)
+	{
+		auto sf = arch.ReadObject<CSensoryFrame>(pool);
+		auto scan = sf->getObservationByClass<CObservation2DRangeScan>();
+		ASSERT_TRUE(scan);
+		ASSERT_EQ(scan->scan.size(), 361u);
+		EXPECT_EQ(scan->scan[0], 1.0f + i);
+		if (i > 0) EXPECT_EQ(scanData, &scan->scan[0]);
+		scanData = &scan->scan[0];
+	}
+	EXPECT_EQ(pool.available(CLASS_ID(CObservation2DRangeScan)), 1u);
+}
@@ -12,6 +12,7 @@
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/metaprogramming_serialization.h>
 
@@ -211,6 +212,83 @@ void CSimpleMap::insertToPos(
 	MRPT_END
 }
 
+// Writes a map in serialization version 2, where each frame is preceded by
+// its length, so it can be skipped (see loadFromFileLazy()). The length is
+// patched once the frame is written, so the stream must be seekable.
+class CSimpleMap::TLazyWriter : public CSimpleMap
+{
+   public:
+	TLazyWriter(const CSimpleMap& map, mrpt::io::CStream& out)
+		: m_map(map), m_out(out)
+	{
+	}
+
+   protected:
+	uint8_t serializeGetVersion() const override { return 2; }
+	void serializeTo(mrpt::serialization::CArchive& out) const override
+	{
+		out.WriteAs<uint32_t>(m_map.m_posesObsPairs.size());
+		for (const auto& p : m_map.m_posesObsPairs)
+		{
+			out << *p.first;
+			const uint64_t lenPos = m_out.getPosition();
+			out.WriteAs<uint64_t>(0);
+			out << *p.second;
+			const uint64_t endPos = m_out.getPosition();
+			m_out.Seek(lenPos);
+			out.WriteAs<uint64_t>(endPos - lenPos - sizeof(uint64_t));
+			m_out.Seek(endPos);
+		}
+	}
+
+   private:
+	const CSimpleMap& m_map;
+	mrpt::io::CStream& m_out;
+};
+
+// Reads a map into another one, creating lazy frames (see
+// CSensoryFrame::CreateLazy()) if it is in serialization version 2. Other
+// versions are read as usual.
+class CSimpleMap::TLazyReader : public CSimpleMap
+{
+   public:
+	TLazyReader(
+		CSimpleMap& map, mrpt::io::CStream& in,
+		const std::shared_ptr<CSensoryFrame::TLazyFile>& file)
+		: m_map(map), m_in(in), m_file(file)
+	{
+	}
+
+   protected:
+	void serializeFrom(
+		mrpt::serialization::CArchive& in, uint8_t version) override
+	{
+		if (version != 2)
+		{
+			m_map.serializeFrom(in, version);
+			return;
+		}
+		uint32_t n;
+		m_map.clear();
+		in >> n;
+		m_map.m_posesObsPairs.resize(n);
+		for (auto& p : m_map.m_posesObsPairs)
+		{
+			uint64_t len;
+			in >> p.first >> len;
+			// Skip the frame, to be loaded upon first access:
+			const uint64_t offset = m_in.getPosition();
+			m_in.Seek(offset + len);
+			p.second = CSensoryFrame::CreateLazy(m_file, offset);
+		}
+	}
+
+   private:
+	CSimpleMap& m_map;
+	mrpt::io::CStream& m_in;
+	std::shared_ptr<CSensoryFrame::TLazyFile> m_file;
+};
+
 uint8_t CSimpleMap::serializeGetVersion() const { return 1; }
 void CSimpleMap::serializeTo(mrpt::serialization::CArchive& out) const
 {
@@ -223,6 +301,20 @@ void CSimpleMap::serializeFrom(
 {
 	switch (version)
 	{
+		case 2:
+		{
+			uint32_t n;
+			clear();
+			in >> n;
+			m_posesObsPairs.resize(n);
+			for (auto& p : m_posesObsPairs)
+			{
+				// The frame length is only needed by TLazyReader:
+				uint64_t len;
+				in >> p.first >> len >> p.second;
+			}
+		}
+		break;
 		case 1:
 		{
 			uint32_t i, n;
@@ -268,12 +360,22 @@ void CSimpleMap::changeCoordinatesOrigin(const CPose3D& newOrigin)
  * \sa loadFromFile
  * \return false on any error.
  */
-bool CSimpleMap::saveToFile(const std::string& filName) const
+bool CSimpleMap::saveToFile(const std::string& filName, bool lazyLoadable) const
 {
 	try
 	{
-		mrpt::io::CFileGZOutputStream fo(filName);
-		archiveFrom(fo) << *this;
+		if (lazyLoadable)
+		{
+			mrpt::io::CFileOutputStream fo;
+			if (!fo.open(filName)) return false;
+			archiveFrom(fo) << TLazyWriter(*this, fo);
+		}
+		else
+		{
+			mrpt::io::CFileGZOutputStream fo;
+			if (!fo.openBlockCompressed(filName)) return false;
+			archiveFrom(fo) << *this;
+		}
 		return true;
 	}
 	catch (...)
@@ -300,3 +402,27 @@ bool CSimpleMap::loadFromFile(const std::string& filName)
 		return false;
 	}
 }
+
+bool CSimpleMap::loadFromFileLazy(
+	const std::string& filName, size_t maxLoadedFrames)
+{
+	try
+	{
+		mrpt::io::CFileGZInputStream fi(filName);
+		// Seeking in a file compressed as a single gzip stream means
+		// decompressing it from the beginning: load it all at once instead.
+		if (fi.isCompressed() && !fi.isBlockCompressed())
+		{
+			archiveFrom(fi) >> *this;
+			return true;
+		}
+		TLazyReader reader(
+			*this, fi, CSensoryFrame::OpenLazyFile(filName, maxLoadedFrames));
+		archiveFrom(fi) >> reader;
+		return true;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
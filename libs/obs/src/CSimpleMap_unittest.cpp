@@ -0,0 +1,316 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/maps/CSimpleMap.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPose3DPDFGaussian.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::system;
+using namespace std;
+
+namespace
+{
+// A simplemap with one odometry and one laser scan per frame, with values
+// depending on the frame index:
+CSimpleMap createTestMap(size_t N)
+{
+	CSimpleMap sm;
+	for (size_t i = 0; i < N; i++)
+	{
+		auto sf = mrpt::make_aligned_shared<CSensoryFrame>();
+		auto odo = mrpt::make_aligned_shared<CObservationOdometry>();
+		odo->sensorLabel = "ODOM";
+		odo->odometry.x(i);
+		sf->insert(odo);
+		auto scan = mrpt::make_aligned_shared<CObservation2DRangeScan>();
+		scan->sensorLabel = "LASER";
+		scan->resizeScan(i + 1);
+		sf->insert(scan);
+
+		CPose3DPDFGaussian pdf;
+		pdf.mean = CPose3D(i, 0, 0, 0, 0, 0);
+		sm.insert(&pdf, sf);
+	}
+	return sm;
+}
+
+void checkFrame(const CSensoryFrame& sf, size_t i)
+{
+	ASSERT_EQ(sf.size(), 2u);
+	auto odo = sf.getObservationByClass<CObservationOdometry>();
+	ASSERT_TRUE(odo);
+	EXPECT_EQ(odo->odometry.x(), double(i));
+	auto scan = sf.getObservationByClass<CObservation2DRangeScan>();
+	ASSERT_TRUE(scan);
+	EXPECT_EQ(scan->scan.size(), i + 1);
+}
+}  // namespace
+
+TEST(CSimpleMap, saveLoad)
+{
+	const size_t N = 20;
+	const std::string file = getTempFileName() + ".simplemap";
+	ASSERT_TRUE(createTestMap(N).saveToFile(file));
+
+	CSimpleMap sm;
+	ASSERT_TRUE(sm.loadFromFile(file));
+	ASSERT_EQ(sm.size(), N);
+	for (size_t i = 0; i < N; i++)
+	{
+		CPose3DPDF::Ptr pdf;
+		CSensoryFrame::Ptr sf;
+		sm.get(i, pdf, sf);
+		EXPECT_EQ(pdf->getMeanVal().x(), double(i));
+		EXPECT_FALSE(sf->isLazy());
+		checkFrame(*sf, i);
+	}
+	deleteFile(file);
+}
+
+TEST(CSimpleMap, loadFromFileLazy)
+{
+	const size_t N = 20, MAX_LOADED = 3;
+	const std::string file = getTempFileName() + ".simplemap";
+	ASSERT_TRUE(createTestMap(N).saveToFile(file, true /*lazyLoadable*/));
+
+	CSimpleMap sm;
+	ASSERT_TRUE(sm.loadFromFileLazy(file, MAX_LOADED));
+	ASSERT_EQ(sm.size(), N);
+
+	// Nothing loaded yet, but poses:
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& p = *(sm.begin() + i);
+		EXPECT_EQ(p.first->getMeanVal().x(), double(i));
+		EXPECT_TRUE(p.second->isLazy());
+		EXPECT_FALSE(p.second->observationsLoaded());
+	}
+
+	// Random accesses, backwards and forward:
+	for (size_t k = 0; k < 2 * N; k++)
+	{
+		const size_t i = (k * 7) % N;
+		const auto& sf = *(sm.begin() + i)->second;
+		checkFrame(sf, i);
+		EXPECT_TRUE(sf.observationsLoaded());
+
+		size_t nLoaded = 0;
+		for (const auto& p : sm)
+			if (p.second->observationsLoaded()) nLoaded++;
+		EXPECT_LE(nLoaded, MAX_LOADED);
+	}
+
+	// Least recently used frames are evicted first:
+	const auto& sf0 = *sm.begin()->second;
+	const auto& sf1 = *(sm.begin() + 1)->second;
+	const auto& sf2 = *(sm.begin() + 2)->second;
+	sf0.loadObservations();
+	sf1.loadObservations();
+	sf2.loadObservations();
+	sf0.loadObservations();
+	(sm.begin() + 3)->second->loadObservations();
+	EXPECT_TRUE(sf0.observationsLoaded());
+	EXPECT_FALSE(sf1.observationsLoaded());
+	EXPECT_TRUE(sf2.observationsLoaded());
+	sf2.unloadObservations();
+	EXPECT_FALSE(sf2.observationsLoaded());
+	checkFrame(sf2, 2);
+
+	// Modified frames are detached from the file, and never evicted:
+	auto sf5 = (sm.begin() + 5)->second;
+	sf5->eraseByLabel("LASER");
+	EXPECT_FALSE(sf5->isLazy());
+	for (size_t i = 0; i < N; i++) (sm.begin() + i)->second->loadObservations();
+	ASSERT_EQ(sf5->size(), 1u);
+
+	// Saving a lazy map loads all frames again:
+	const std::string file2 = getTempFileName() + ".simplemap";
+	ASSERT_TRUE(sm.saveToFile(file2));
+	CSimpleMap sm2;
+	ASSERT_TRUE(sm2.loadFromFile(file2));
+	ASSERT_EQ(sm2.size(), N);
+	for (size_t i = 0; i < N; i++)
+		if (i != 5) checkFrame(*(sm2.begin() + i)->second, i);
+
+	// Copies are regular maps:
+	CSimpleMap sm3 = sm;
+	EXPECT_FALSE(sm3.begin()->second->isLazy());
+	checkFrame(*sm3.begin()->second, 0);
+
+	deleteFile(file);
+	deleteFile(file2);
+}
+
+TEST(CSimpleMap, defaultFormatIsNotLazy)
+{
+	const size_t N = 5;
+
+	// Regular serialization keeps the version 1 format:
+	{
+		mrpt::io::CMemoryStream buf;
+		mrpt::serialization::archiveFrom(buf) << createTestMap(N);
+		const std::string className = "CSimpleMap";
+		ASSERT_GT(buf.getTotalBytesCount(), 1 + className.size());
+		const auto* data =
+			static_cast<const uint8_t*>(buf.getRawBufferData());
+		EXPECT_EQ(data[1 + className.size()], 1u);
+	}
+
+	// Without lazyLoadable, files are loaded at once:
+	const std::string file = getTempFileName() + ".simplemap";
+	for (int compressed = 0; compressed < 2; compressed++)
+	{
+		if (compressed)
+			ASSERT_TRUE(createTestMap(N).saveToFile(file));
+		else
+		{
+			mrpt::io::CFileOutputStream f(file);
+			mrpt::serialization::archiveFrom(f) << createTestMap(N);
+		}
+		CSimpleMap sm;
+		ASSERT_TRUE(sm.loadFromFileLazy(file, 2));
+		ASSERT_EQ(sm.size(), N);
+		for (size_t i = 0; i < N; i++)
+		{
+			const auto& sf = *(sm.begin() + i)->second;
+			EXPECT_FALSE(sf.isLazy());
+			checkFrame(sf, i);
+		}
+	}
+	deleteFile(file);
+}
+
+TEST(CSimpleMap, loadFromFileLazySingleGzipStream)
+{
+	// The lazy-loadable format (version 2), written by hand but compressed as
+	// a single gzip stream (not seekable): loaded at once.
+	const size_t N = 5;
+	const std::string file = getTempFileName() + ".simplemap";
+	{
+		const CSimpleMap sm = createTestMap(N);
+		mrpt::io::CFileGZOutputStream f(file);
+		auto arch = mrpt::serialization::archiveFrom(f);
+		const std::string className = "CSimpleMap";
+		arch << static_cast<int8_t>(className.size() | 0x80);
+		arch.WriteBuffer(className.c_str(), className.size());
+		arch << static_cast<uint8_t>(2) << static_cast<uint32_t>(N);
+		for (const auto& p : sm)
+		{
+			mrpt::io::CMemoryStream buf;
+			mrpt::serialization::archiveFrom(buf) << *p.second;
+			arch << *p.first
+				 << static_cast<uint64_t>(buf.getTotalBytesCount());
+			arch.WriteBuffer(
+				buf.getRawBufferData(), buf.getTotalBytesCount());
+		}
+		arch << static_cast<uint8_t>(0x88);  // End flag
+	}
+	CSimpleMap sm;
+	ASSERT_TRUE(sm.loadFromFileLazy(file, 2));
+	ASSERT_EQ(sm.size(), N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& sf = *(sm.begin() + i)->second;
+		EXPECT_FALSE(sf.isLazy());
+		checkFrame(sf, i);
+	}
+	deleteFile(file);
+}
+
+TEST(CSimpleMap, pinnedFramesAreNotEvicted)
+{
+	const size_t N = 10;
+	const std::string file = getTempFileName() + ".simplemap";
+	ASSERT_TRUE(createTestMap(N).saveToFile(file, true /*lazyLoadable*/));
+	CSimpleMap sm;
+	ASSERT_TRUE(sm.loadFromFileLazy(file, 2));
+
+	const auto& sf0 = *sm.begin()->second;
+	{
+		const CSensoryFrame::TObservationsPin pin(sf0);
+		EXPECT_TRUE(sf0.observationsLoaded());
+		auto it = sf0.begin();
+		for (size_t i = 1; i < N; i++)
+			(sm.begin() + i)->second->loadObservations();
+		sf0.unloadObservations();
+		// Still loaded, and the iterator still valid:
+		EXPECT_TRUE(sf0.observationsLoaded());
+		EXPECT_EQ((*it)->sensorLabel, "ODOM");
+		checkFrame(sf0, 0);
+	}
+	// Once unpinned, it is evicted as usual:
+	for (size_t i = 1; i < N; i++) (sm.begin() + i)->second->loadObservations();
+	EXPECT_FALSE(sf0.observationsLoaded());
+
+	// Several threads iterating frames, more than the budget, at once:
+	std::vector<std::thread> threads;
+	std::atomic<size_t> nErrors{0};
+	for (size_t t = 0; t < 4; t++)
+		threads.emplace_back([&, t]() {
+			for (size_t k = 0; k < 200; k++)
+			{
+				const size_t i = (k * 3 + t) % N;
+				const auto& sf = *(sm.begin() + i)->second;
+				const CSensoryFrame::TObservationsPin pin(sf);
+				size_t n = 0;
+				for (const auto& o : sf)
+					if (o->sensorLabel == "ODOM" || o->sensorLabel == "LASER")
+						n++;
+				if (n != 2) nErrors++;
+			}
+		});
+	for (auto& th : threads) th.join();
+	EXPECT_EQ(nErrors, 0u);
+
+	deleteFile(file);
+}
+
+TEST(CSimpleMap, loadFromFileLazyOldFormat)
+{
+	// Write serialization version 1, without the length of each frame, by
+	// hand, as older versions of MRPT did:
+	const size_t N = 5;
+	const std::string file = getTempFileName() + ".simplemap";
+	{
+		const CSimpleMap sm = createTestMap(N);
+		mrpt::io::CFileGZOutputStream f(file);
+		auto arch = mrpt::serialization::archiveFrom(f);
+		const std::string className = "CSimpleMap";
+		arch << static_cast<int8_t>(className.size() | 0x80);
+		arch.WriteBuffer(className.c_str(), className.size());
+		arch << static_cast<uint8_t>(1) << static_cast<uint32_t>(N);
+		for (const auto& p : sm) arch << *p.first << *p.second;
+		arch << static_cast<uint8_t>(0x88);  // End flag
+	}
+
+	// It can't be lazy, but is still loaded:
+	CSimpleMap sm;
+	ASSERT_TRUE(sm.loadFromFileLazy(file, 2));
+	ASSERT_EQ(sm.size(), N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto& sf = *(sm.begin() + i)->second;
+		EXPECT_FALSE(sf.isLazy());
+		checkFrame(sf, i);
+	}
+	deleteFile(file);
+}
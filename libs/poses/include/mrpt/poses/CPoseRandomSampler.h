@@ -19,6 +19,10 @@
 
 namespace mrpt
 {
+namespace random
+{
+class CRandomGenerator;
+}
 namespace poses
 {
 /** An efficient generator of random samples drawn from a given 2D (CPosePDF) or
@@ -60,9 +64,11 @@ class CPoseRandomSampler
 	void clear();
 
 	/** Used internally: sample from m_pdf2D */
-	void do_sample_2D(CPose2D& p) const;
+	void do_sample_2D(
+		CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
 	/** Used internally: sample from m_pdf3D */
-	void do_sample_3D(CPose3D& p) const;
+	void do_sample_3D(
+		CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
 
    public:
 	/** Default constructor */
@@ -113,6 +119,20 @@ class CPoseRandomSampler
 	  */
 	CPose3D& drawSample(CPose3D& p) const;
 
+	/** Generate a new sample from the selected PDF, using the given random
+	 * generator instead of mrpt::random::getRandomGenerator(). This allows
+	 * drawing samples concurrently from several threads, each one with its
+	 * own generator.
+	 * \return A reference to the same object passed as argument.
+	 * \sa setPosePDF
+	 */
+	CPose2D& drawSample(
+		CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
+
+	/** \overload */
+	CPose3D& drawSample(
+		CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
+
 	/** Return true if samples can be generated, which only requires a previous
 	 * call to setPosePDF */
 	bool isPrepared() const;
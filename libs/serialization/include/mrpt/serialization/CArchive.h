@@ -25,6 +25,7 @@ namespace mrpt
 namespace serialization
 {
 class CMessage;
+class CSerializablePool;
 
 /** Used in mrpt::serialization::CArchive */
 class CExceptionEOF : public std::runtime_error
@@ -95,6 +96,20 @@ class CArchive
 #endif
 	}
 
+	/** Returns a pointer to the next Count bytes of the stream, without
+	 * copying them, if the underlying stream holds its data in memory (e.g. a
+	 * memory-mapped file, see mrpt::io::CFileMMapInputStream). Large arrays
+	 * can then be used in place, or copied straight to their destination.
+	 * The pointer is not necessarily aligned, and remains valid while the
+	 * stream is neither modified nor closed.
+	 * \return nullptr if not supported by the stream or there are less than
+	 * Count bytes left. The stream is then left unchanged, so the data can be
+	 * read with ReadBuffer() instead.
+	 * \note This method is endianness-dependent.
+	 * \note [New in MRPT 2.0.0]
+	 */
+	const void* ReadBufferView(size_t Count);
+
 	/** Writes a block of bytes to the stream from Buffer.
 	 *	\exception std::exception On any error
 	 *  \sa Important, see: WriteBufferFixEndianness
@@ -189,7 +204,7 @@ class CArchive
 				THROW_EXCEPTION_FMT(
 					"Stored object has class '%s' which is not registered!",
 					strClassName.c_str());
-			obj.reset(dynamic_cast<CSerializable*>(classId->createObject()));
+			obj = internal_CreateObject(classId);
 		}
 		internal_ReadObject(
 			obj.get() /* may be nullptr */, strClassName, isOldFormat,
@@ -204,7 +219,44 @@ class CArchive
 		}
 	}
 
+	/** Like ReadObject(), but objects of the classes enabled in the pool,
+	 * including those nested in the one read, are recycled instances taken
+	 * from it. \sa CSerializablePool, setObjectPool()
+	 */
+	CSerializable::Ptr ReadObject(CSerializablePool& pool)
+	{
+		return ReadObject<CSerializable>(pool);
+	}
+	/** \overload */
+	template <typename T>
+	typename T::Ptr ReadObject(CSerializablePool& pool)
+	{
+		CSerializablePool* const prevPool = m_objectPool;
+		m_objectPool = &pool;
+		try
+		{
+			auto obj = ReadObject<T>();
+			m_objectPool = prevPool;
+			return obj;
+		}
+		catch (...)
+		{
+			m_objectPool = prevPool;
+			throw;
+		}
+	}
+	/** Sets a pool of objects to be used by all calls to ReadObject(), for
+	 * code which reads objects through functions not taking a pool (e.g.
+	 * rawlog readers). Use nullptr to stop using it. The pool must outlive
+	 * the archive or this setting. \sa CSerializablePool */
+	void setObjectPool(CSerializablePool* pool) { m_objectPool = pool; }
+	/** \sa setObjectPool */
+	CSerializablePool* getObjectPool() const { return m_objectPool; }
+
    private:
+	/** Pool of recycled objects to use in ReadObject(), if any */
+	CSerializablePool* m_objectPool{nullptr};
+
 	template <typename RET>
 	RET ReadVariant_helper(CSerializable::Ptr& ptr)
 	{
@@ -259,7 +311,7 @@ class CArchive
 				strClassName.c_str());
 		if (strClassName != "nullptr")
 		{
-			obj.reset(dynamic_cast<CSerializable*>(classId->createObject()));
+			obj = internal_CreateObject(classId);
 		}
 		internal_ReadObject(obj.get(), strClassName, isOldFormat, version);
 		if (!obj)
@@ -368,6 +420,14 @@ class CArchive
 	 * \return Number of bytes actually read if >0.
 	 */
 	virtual size_t read(void* buf, size_t len) = 0;
+	/** Returns a pointer to the next len bytes and moves past them, or
+	 * nullptr (without moving) if not supported or there are less than len
+	 * bytes left. See ReadBufferView(). */
+	virtual const void* readView(size_t len)
+	{
+		MRPT_UNUSED_PARAM(len);
+		return nullptr;
+	}
 	/** @} */
 
 	/** Read the object */
@@ -375,6 +435,11 @@ class CArchive
 		CSerializable* newObj, const std::string& className, bool isOldFormat,
 		int8_t version);
 
+	/** Creates an object of the given class, or takes a recycled one from
+	 * the object pool, if any, to read it */
+	CSerializable::Ptr internal_CreateObject(
+		const mrpt::rtti::TRuntimeClassId* classId);
+
 	/** Read the object Header*/
 	void internal_ReadObjectHeader(
 		std::string& className, bool& isOldFormat, int8_t& version);
@@ -539,6 +604,7 @@ class CArchiveStreamBase : public CArchive
    protected:
 	size_t write(const void* d, size_t n) override { return m_s.Write(d, n); }
 	size_t read(void* d, size_t n) override { return m_s.Read(d, n); }
+	const void* readView(size_t n) override { return m_s.ReadView(n); }
 };
 
 /** Helper function to create a templatized wrapper CArchive object for a:
@@ -0,0 +1,103 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/serialization/CSerializable.h>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace mrpt
+{
+namespace serialization
+{
+/** Pools of recycled objects, one per class, to deserialize high-rate data
+ * (e.g. IMU readings or laser scans) without allocating a new object, and
+ * its buffers, for each one.
+ *
+ * Pooling is enabled per class with enableClass(). Objects of those classes
+ * read with CArchive::ReadObject(CSerializablePool&), or from an archive
+ * with CArchive::setObjectPool(), are taken from the pool instead of being
+ * created, including objects nested in others (e.g. the observations of a
+ * mrpt::obs::CSensoryFrame). When the last smart pointer to one of them is
+ * released, the object returns to its pool, unless the pool is full or no
+ * longer exists. Since a recycled object is overwritten when read again, its
+ * std::vector and similar members keep their capacity, and reading objects
+ * of the same size does not allocate memory.
+ *
+ * \code
+ * CSerializablePool pool;
+ * pool.enableClass<mrpt::obs::CObservation2DRangeScan>();
+ * for (;;)
+ * {
+ *   CSerializable::Ptr obj = archive.ReadObject(pool);
+ *   ...
+ * }  // obj goes back to the pool here
+ * \endcode
+ *
+ * \note Only enable classes whose serializeFrom() sets all their fields, or
+ * recycled objects would keep stale data from their previous use.
+ * \note All methods are thread-safe, and objects may be released from any
+ * thread.
+ * \sa CArchive, mrpt::system::CGenericMemoryPool
+ * \ingroup mrpt_serialization_grp
+ */
+class CSerializablePool
+{
+   public:
+	CSerializablePool();
+	/** Dtor: deletes the pooled objects. Objects still in use are deleted
+	 * normally when released. */
+	~CSerializablePool();
+
+	CSerializablePool(const CSerializablePool&) = delete;
+	CSerializablePool& operator=(const CSerializablePool&) = delete;
+
+	/** Enables pooling objects of class T, keeping up to maxPooled of them
+	 * for reuse. */
+	template <class T>
+	void enableClass(std::size_t maxPooled = 16)
+	{
+		enableClass(CLASS_ID(T), maxPooled);
+	}
+	/** \overload */
+	void enableClass(
+		const mrpt::rtti::TRuntimeClassId* classId,
+		std::size_t maxPooled = 16);
+	/** Returns true if enableClass() was called for this class */
+	bool isEnabled(const mrpt::rtti::TRuntimeClassId* classId) const;
+
+	/** Returns a recycled object of the given class, or a new one if there
+	 * is none in the pool. The object returns to the pool when the last
+	 * copy of the smart pointer is released.
+	 * \return nullptr if pooling is not enabled for this class. */
+	CSerializable::Ptr acquire(const mrpt::rtti::TRuntimeClassId* classId);
+
+	/** Returns the number of objects of the given class ready for reuse */
+	std::size_t available(const mrpt::rtti::TRuntimeClassId* classId) const;
+
+	/** Deletes all the objects ready for reuse */
+	void clear();
+
+   private:
+	struct TClassPool;
+	struct TRecycler;
+	/** Pools are shared with the deleters of the acquired objects */
+	std::map<
+		const mrpt::rtti::TRuntimeClassId*, std::shared_ptr<TClassPool>>
+		m_pools;
+	mutable std::mutex m_pools_mtx;
+
+	std::shared_ptr<TClassPool> getPool(
+		const mrpt::rtti::TRuntimeClassId* classId) const;
+};
+
+}  // namespace serialization
+}  // namespace mrpt
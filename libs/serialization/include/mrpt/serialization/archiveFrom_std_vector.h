@@ -48,6 +48,14 @@ class CArchiveStreamBase<std::vector<uint8_t>> : public CArchive
 		m_pos_read += n;
 		return n;
 	};
+	const void* readView(size_t n) override
+	{
+		if (static_cast<int>(m_v.size()) - m_pos_read < static_cast<int>(n))
+			return nullptr;
+		const void* ret = &m_v[m_pos_read];
+		m_pos_read += n;
+		return ret;
+	}
 };
 /** Read-only version of the wrapper. See archiveFrom() */
 template <>
@@ -74,6 +82,14 @@ class CArchiveStreamBase<const std::vector<uint8_t>> : public CArchive
 		m_pos_read += n;
 		return n;
 	};
+	const void* readView(size_t n) override
+	{
+		if (static_cast<int>(m_v.size()) - m_pos_read < static_cast<int>(n))
+			return nullptr;
+		const void* ret = &m_v[m_pos_read];
+		m_pos_read += n;
+		return ret;
+	}
 };
 }  // namespace serialization
 }  // namespace mrpt
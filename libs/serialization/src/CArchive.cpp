@@ -15,6 +15,7 @@
 #include <mrpt/serialization/CSerializable.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/CMessage.h>
+#include <mrpt/serialization/CSerializablePool.h>
 #include <cstring>  // strlen()
 
 using namespace mrpt::serialization;
@@ -41,6 +42,11 @@ size_t CArchive::ReadBuffer(void* Buffer, size_t Count)
 		return 0;
 }
 
+const void* CArchive::ReadBufferView(size_t Count)
+{
+	return Count ? this->readView(Count) : nullptr;
+}
+
 /*---------------------------------------------------------------
 WriteBuffer
 Writes a block of bytes to the stream.
@@ -190,6 +196,18 @@ CArchive& CArchive::operator<<(const CSerializable& obj)
 	return *this;
 }
 
+CSerializable::Ptr CArchive::internal_CreateObject(
+	const mrpt::rtti::TRuntimeClassId* classId)
+{
+	if (m_objectPool)
+	{
+		auto obj = m_objectPool->acquire(classId);
+		if (obj) return obj;
+	}
+	return CSerializable::Ptr(
+		dynamic_cast<CSerializable*>(classId->createObject()));
+}
+
 CArchive& CArchive::operator>>(CSerializable::Ptr& pObj)
 {
 	pObj = ReadObject();
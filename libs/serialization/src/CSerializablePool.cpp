@@ -0,0 +1,132 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "serialization-precomp.h"  // Precompiled headers
+
+#include <mrpt/serialization/CSerializablePool.h>
+#include <mrpt/core/exceptions.h>
+#include <vector>
+
+using namespace mrpt::serialization;
+
+struct CSerializablePool::TClassPool
+{
+	const mrpt::rtti::TRuntimeClassId* classId{nullptr};
+	std::size_t maxPooled{0};
+	std::mutex mtx;
+	std::vector<CSerializable*> objects;
+
+	~TClassPool() { clear(); }
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto o : objects) delete o;
+		objects.clear();
+	}
+};
+
+/** Deleter of pooled objects: returns them to their pool, if it still
+ * exists and has room for them */
+struct CSerializablePool::TRecycler
+{
+	std::weak_ptr<TClassPool> pool;
+
+	void operator()(CSerializable* obj) const
+	{
+		if (auto p = pool.lock())
+		{
+			std::lock_guard<std::mutex> lock(p->mtx);
+			if (p->objects.size() < p->maxPooled)
+			{
+				p->objects.push_back(obj);
+				return;
+			}
+		}
+		delete obj;
+	}
+};
+
+CSerializablePool::CSerializablePool() {}
+CSerializablePool::~CSerializablePool() {}
+void CSerializablePool::enableClass(
+	const mrpt::rtti::TRuntimeClassId* classId, std::size_t maxPooled)
+{
+	MRPT_START
+	ASSERT_(classId != nullptr);
+	ASSERTMSG_(
+		classId->ptrCreateObject != nullptr,
+		"Cannot pool objects of a virtual class");
+	std::lock_guard<std::mutex> lock(m_pools_mtx);
+	auto& pool = m_pools[classId];
+	if (!pool)
+	{
+		pool = std::make_shared<TClassPool>();
+		pool->classId = classId;
+	}
+	std::lock_guard<std::mutex> lockPool(pool->mtx);
+	pool->maxPooled = maxPooled;
+	while (pool->objects.size() > maxPooled)
+	{
+		delete pool->objects.back();
+		pool->objects.pop_back();
+	}
+	MRPT_END
+}
+
+std::shared_ptr<CSerializablePool::TClassPool> CSerializablePool::getPool(
+	const mrpt::rtti::TRuntimeClassId* classId) const
+{
+	std::lock_guard<std::mutex> lock(m_pools_mtx);
+	const auto it = m_pools.find(classId);
+	return it == m_pools.end() ? nullptr : it->second;
+}
+
+bool CSerializablePool::isEnabled(
+	const mrpt::rtti::TRuntimeClassId* classId) const
+{
+	return getPool(classId) != nullptr;
+}
+
+CSerializable::Ptr CSerializablePool::acquire(
+	const mrpt::rtti::TRuntimeClassId* classId)
+{
+	auto pool = getPool(classId);
+	if (!pool) return nullptr;
+
+	CSerializable* obj = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(pool->mtx);
+		if (!pool->objects.empty())
+		{
+			obj = pool->objects.back();
+			pool->objects.pop_back();
+		}
+	}
+	if (!obj)
+	{
+		obj = dynamic_cast<CSerializable*>(classId->createObject());
+		ASSERT_(obj != nullptr);
+	}
+	return CSerializable::Ptr(obj, TRecycler{pool});
+}
+
+std::size_t CSerializablePool::available(
+	const mrpt::rtti::TRuntimeClassId* classId) const
+{
+	auto pool = getPool(classId);
+	if (!pool) return 0;
+	std::lock_guard<std::mutex> lock(pool->mtx);
+	return pool->objects.size();
+}
+
+void CSerializablePool::clear()
+{
+	std::lock_guard<std::mutex> lock(m_pools_mtx);
+	for (auto& p : m_pools) p.second->clear();
+}
@@ -9,8 +9,12 @@
 
 #include <mrpt/serialization/CSerializable.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/CSerializablePool.h>
+#include <mrpt/serialization/archiveFrom_std_streams.h>
 #include <mrpt/io/CMemoryStream.h>
 #include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
 
 using namespace mrpt::serialization;
 
@@ -50,3 +54,74 @@ TEST(Serialization, CustomClassSerialize)
 
 	EXPECT_EQ(a.value, b.value);
 }
+
+TEST(Serialization, ReadBufferView)
+{
+	const std::vector<float> v = {1.0f, 2.0f, 3.0f};
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << uint32_t(v.size());
+	arch.WriteBufferFixEndianness(v.data(), v.size());
+
+	buf.Seek(0);
+	uint32_t N;
+	arch >> N;
+	const void* view = arch.ReadBufferView(sizeof(float) * N);
+	ASSERT_TRUE(view != nullptr);
+	EXPECT_EQ(0, std::memcmp(view, v.data(), sizeof(float) * N));
+	// Not enough data left: no view, and the stream is not changed.
+	EXPECT_TRUE(arch.ReadBufferView(1 << 20) == nullptr);
+	EXPECT_EQ(buf.getPosition(), sizeof(uint32_t) + sizeof(float) * N);
+
+	// Streams without views:
+	std::istringstream ss("abc");
+	auto arch2 = mrpt::serialization::archiveFrom<std::istream>(ss);
+	EXPECT_TRUE(arch2.ReadBufferView(1) == nullptr);
+}
+
+TEST(Serialization, ReadObjectFromPool)
+{
+	mrpt::rtti::registerClass(CLASS_ID(MyNS::Foo));
+
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	for (int16_t i = 0; i < 3; i++)
+	{
+		MyNS::Foo a;
+		a.value = i;
+		arch << a;
+	}
+	arch.WriteObject(nullptr);
+
+	auto pool = std::make_unique<CSerializablePool>();
+	EXPECT_FALSE(pool->isEnabled(CLASS_ID(MyNS::Foo)));
+	pool->enableClass<MyNS::Foo>(1);
+	EXPECT_TRUE(pool->isEnabled(CLASS_ID(MyNS::Foo)));
+
+	buf.Seek(0);
+	auto o1 = arch.ReadObject<MyNS::Foo>(*pool);
+	ASSERT_TRUE(o1);
+	EXPECT_EQ(o1->value, 0);
+	const MyNS::Foo* addr = o1.get();
+	o1.reset();
+	EXPECT_EQ(pool->available(CLASS_ID(MyNS::Foo)), 1u);
+
+	// The released object is reused:
+	auto o2 = arch.ReadObject<MyNS::Foo>(*pool);
+	EXPECT_EQ(o2.get(), addr);
+	EXPECT_EQ(o2->value, 1);
+	EXPECT_EQ(pool->available(CLASS_ID(MyNS::Foo)), 0u);
+	// ... but objects read without the pool are not:
+	auto o3 = arch.ReadObject<MyNS::Foo>();
+	EXPECT_EQ(o3->value, 2);
+	EXPECT_TRUE(arch.ReadObject(*pool) == nullptr);
+
+	// Objects beyond the pool size, or released after the pool, are deleted:
+	auto o4 = pool->acquire(CLASS_ID(MyNS::Foo));
+	ASSERT_TRUE(o4 != nullptr);
+	o3.reset();
+	o4.reset();
+	EXPECT_EQ(pool->available(CLASS_ID(MyNS::Foo)), 1u);
+	pool.reset();
+	o2.reset();
+}
@@ -37,6 +37,7 @@ MRPT_WARNING(
 #include <mrpt/slam/CMonteCarloLocalization3D.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/slam/CGridMapAligner.h>
+#include <mrpt/slam/CCorrelativeScanMatcher.h>
 #include <mrpt/slam/CIncrementalMapPartitioner.h>
 #include <mrpt/slam/CRejectionSamplingRangeOnlyLocalization.h>
 #include <mrpt/slam/data_association.h>
@@ -0,0 +1,165 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#ifndef CCorrelativeScanMatcher_H
+#define CCorrelativeScanMatcher_H
+
+#include <mrpt/slam/CMetricMapsAlignmentAlgorithm.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mrpt
+{
+namespace slam
+{
+/** Global 2D scan matcher: finds the pose of a points map (m2) within an
+ * occupancy grid map (m1) by exhaustively correlating the points against a
+ * smoothed likelihood field of the grid, over a whole x/y/phi search window
+ * centered at the initial estimation.
+ *
+ * The search is made fast by branch and bound (Hess et al., "Real-Time Loop
+ * Closure in 2D LIDAR SLAM", ICRA 2016): the likelihood field is precomputed
+ * as a pyramid of max-pooled grids, where the cell (x,y) of level `h` holds
+ * the maximum of the cells [x,x+2^h)x[y,y+2^h) of the field. Scoring the
+ * points against level `h` gives an upper bound of the score of all the
+ * 2^h x 2^h translations it covers, so whole blocks of the search window can
+ * be discarded at once. The result is exactly the best pose of the
+ * discretized window, as an exhaustive search would find it.
+ *
+ * Unlike CICP, no good initial guess is needed; unlike CGridMapAligner, no
+ * features are extracted, so this class is well suited for global
+ * relocalization and loop closure checks. Its output lies on the search
+ * lattice (one grid cell, one angular step), so it is typically refined with
+ * CICP afterwards.
+ *
+ * The pyramid only depends on the grid map and is cached between calls to
+ * AlignPDF() with the same map object. If that map is modified, call
+ * precomputePyramid() (or clearPyramid()) to refresh it.
+ *
+ * \sa CMetricMapsAlignmentAlgorithm, CICP, CGridMapAligner
+ * \ingroup mrpt_slam_grp
+ */
+class CCorrelativeScanMatcher
+	: public mrpt::slam::CMetricMapsAlignmentAlgorithm
+{
+   public:
+	CCorrelativeScanMatcher() : options() {}
+
+	/** The algorithm configuration data */
+	class TConfigParams : public mrpt::config::CLoadableOptions
+	{
+	   public:
+		/** Initializer for default values: */
+		TConfigParams();
+
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void saveToConfigFile(
+			mrpt::config::CConfigFileBase& target,
+			const std::string& section) const override;  // See base docs
+
+		/** Half the size of the searched window in x and y, around the
+		 * initial estimation (meters) (Default=5) */
+		double linear_window{5.0};
+		/** Half the size of the searched window in phi, around the initial
+		 * estimation (radians) (Default=180deg, the whole circle) */
+		double angular_window;
+		/** Angular step of the search (radians). If 0 (default), the largest
+		 * step such that the furthest point moves at most one grid cell is
+		 * used. */
+		double angular_step{0};
+		/** Number of levels of the max-pooled pyramid (Default=7): the
+		 * coarsest one bounds blocks of 2^(levels-1) cells. */
+		unsigned int pyramid_levels{7};
+		/** Standard deviation of the likelihood field around obstacles, in
+		 * meters (Default=0.05) */
+		double sigma{0.05};
+		/** Cells whose value (see COccupancyGridMap2D::getCell(), 0=occupied,
+		 * 1=free) is below this threshold are obstacles (Default=0.45) */
+		double occupied_threshold{0.45};
+		/** Only one out of `decimation` points of m2 is used (Default=1) */
+		unsigned int decimation{1};
+		/** Minimum score, in the range [0,1], for a pose to be accepted
+		 * (Default=0.5). A higher value makes the search faster. */
+		double min_score{0.5};
+		/** Number of threads to use for the search (0: one per hardware core,
+		 * 1: the calling thread only) (Default=1) */
+		unsigned int numThreads{1};
+	};
+
+	/** The algorithm configuration data */
+	TConfigParams options;
+
+	/** The information returned through the "info" argument of AlignPDF(). */
+	struct TReturnInfo
+	{
+		/** Whether a pose with a score above options.min_score was found. If
+		 * not, the returned PDF is the initial estimation. */
+		bool found{false};
+		/** Score of the best pose, in the range [0,1]: the mean likelihood
+		 * field value at the points of m2. */
+		double goodness{0};
+		/** Number of searched angles */
+		size_t nAngles{0};
+		/** Number of candidates (translations of any pyramid level) whose
+		 * score was evaluated */
+		size_t nEvaluatedCandidates{0};
+	};
+
+	/** Searches the pose of m2 (a CPointsMap) within m1 (a
+	 * COccupancyGridMap2D), in the window defined in options centered at the
+	 * mean of initialEstimationPDF.
+	 * \param info An optional pointer to a TReturnInfo struct.
+	 * \return A CPosePDFGaussian with the best pose, and a covariance
+	 * reflecting the discretization of the search.
+	 */
+	mrpt::poses::CPosePDF::Ptr AlignPDF(
+		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+		const mrpt::poses::CPosePDFGaussian& initialEstimationPDF,
+		float* runningTime = nullptr, void* info = nullptr) override;
+
+	/** Runs AlignPDF() over the 2D projection of the initial estimation; the
+	 * resulting z, pitch and roll are those of the initial estimation. */
+	mrpt::poses::CPose3DPDF::Ptr Align3DPDF(
+		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
+		float* runningTime = nullptr, void* info = nullptr) override;
+
+	/** Builds the max-pooled likelihood field pyramid of a grid map with the
+	 * current options. Called automatically by AlignPDF() when needed, but
+	 * it may be invoked in advance, or to refresh it after the grid changes.
+	 */
+	void precomputePyramid(const mrpt::maps::COccupancyGridMap2D& grid);
+	/** Frees the cached pyramid, so it is rebuilt in the next search. */
+	void clearPyramid();
+
+   private:
+	/** Pyramid of max-pooled likelihood fields (values in [0,255]). Each
+	 * level has m_pyrSizeX x m_pyrSizeY cells, the first m_pyrPad rows and
+	 * columns lying before the first cell of the grid map. */
+	std::vector<std::vector<uint8_t>> m_pyramid;
+	int m_pyrSizeX{0}, m_pyrSizeY{0}, m_pyrPad{0};
+	/** Grid map and options the pyramid was built from */
+	const mrpt::maps::COccupancyGridMap2D* m_pyrGrid{nullptr};
+	std::vector<double> m_pyrParams;
+	std::vector<double> pyramidParams(
+		const mrpt::maps::COccupancyGridMap2D& grid) const;
+
+	std::shared_ptr<mrpt::WorkerThreadsPool> m_threadPool;
+	mrpt::WorkerThreadsPool* getThreadPool();
+};
+
+}  // namespace slam
+}  // namespace mrpt
+
+#endif
@@ -22,7 +22,15 @@ namespace slam
 enum TICPAlgorithm
 {
 	icpClassic = 0,
-	icpLevenbergMarquardt
+	icpLevenbergMarquardt,
+	/** [3D only] Minimizes the distances from each point to the plane
+	 * tangent to the surface of the reference map at its corresponding point
+	 * (Chen & Medioni, 1991) */
+	icpPointToPlane,
+	/** [3D only] Generalized-ICP: plane-to-plane distances weighted with the
+	 * local surface covariances of both maps (Segal, Haehnel & Thrun, 2009)
+	 */
+	icpGeneralized
 };
 
 /** ICP covariance estimation methods, used in mrpt::slam::CICP::options
@@ -176,6 +184,24 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation{5};
+
+		/** Number of threads among which the nearest-neighbor queries of the
+		 * correspondence search are distributed: 1 (default) runs in the
+		 * calling thread, 0 uses one thread per hardware core. See
+		 * mrpt::maps::TMatchingParams::numThreads */
+		unsigned int numThreads{1};
+
+		/** @name icpPointToPlane and icpGeneralized options
+			@{ */
+		/** Number of closest points used to estimate the normal and
+		 * covariance of the surface around each point (default=10). See
+		 * mrpt::maps::CPointsMap::getPointsLocalCovariances() */
+		unsigned int surface_neighbors{10};
+		/** [icpGeneralized] The variance of the points along the surface
+		 * normal, relative to the variance along the surface (default=1e-3)
+		 */
+		double gicp_epsilon{1e-3};
+		/** @} */
 	};
 
 	/** The options employed by the ICP align. */
@@ -263,6 +289,11 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** icpPointToPlane and icpGeneralized */
+	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_Surfaces(
+		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
+		TReturnInfo& outInfo);
 };
 }  // namespace slam
 }  // namespace mrpt
@@ -271,6 +302,8 @@ MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPAlgorithm)
 using namespace mrpt::slam;
 MRPT_FILL_ENUM(icpClassic);
 MRPT_FILL_ENUM(icpLevenbergMarquardt);
+MRPT_FILL_ENUM(icpPointToPlane);
+MRPT_FILL_ENUM(icpGeneralized);
 MRPT_ENUM_TYPE_END()
 
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPCovarianceMethod)
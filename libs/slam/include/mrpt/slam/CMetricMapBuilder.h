@@ -107,7 +107,11 @@ class CMetricMapBuilder : public mrpt::system::COutputLogger
 	/** Load map (mrpt::maps::CSimpleMap) from a ".simplemap" file */
 	void loadCurrentMapFromFile(const std::string& fileName);
 
-	/** Save map (mrpt::maps::CSimpleMap) to a ".simplemap" file. */
+	/** Save map (mrpt::maps::CSimpleMap) to a ".simplemap" file.
+	 * \param compressGZ If true, the file is block-compressed; otherwise, it
+	 * is not compressed, and it can be loaded with
+	 * mrpt::maps::CSimpleMap::loadFromFileLazy().
+	 * \sa mrpt::maps::CSimpleMap::saveToFile() */
 	void saveCurrentMapToFile(
 		const std::string& fileName, bool compressGZ = true) const;
 
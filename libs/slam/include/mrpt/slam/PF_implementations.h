@@ -240,29 +240,56 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			// -------------------------------------------------------------
 			// FIXED SAMPLE SIZE
 			// -------------------------------------------------------------
-			mrpt::poses::CPose3D incrPose;
-			for (size_t i = 0; i < M; i++)
-			{
-				// Generate gaussian-distributed 2D-pose increments according to
-				// mean-cov:
-				m_movementDrawer.drawSample(incrPose);
-				bool pose_is_valid;
-				const mrpt::poses::CPose3D finalPose =
-					mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
-					incrPose;
-
-				// Update the particle with the new pose: this part is
-				// caller-dependant and must be implemented there:
-				if constexpr(STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
-				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						me->m_particles[i].d.get(), finalPose.asTPose());
-				}
-				else
+			auto predictParticles = [&](
+				size_t first, size_t last,
+				mrpt::random::CRandomGenerator& rng) {
+				mrpt::poses::CPose3D incrPose;
+				for (size_t i = first; i < last; i++)
 				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						&me->m_particles[i].d, finalPose.asTPose());
+					// Generate gaussian-distributed 2D-pose increments
+					// according to mean-cov:
+					m_movementDrawer.drawSample(incrPose, rng);
+					bool pose_is_valid;
+					const mrpt::poses::CPose3D finalPose =
+						mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
+						incrPose;
+
+					// Update the particle with the new pose: this part is
+					// caller-dependant and must be implemented there:
+					if constexpr(
+						STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							me->m_particles[i].d.get(), finalPose.asTPose());
+					}
+					else
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							&me->m_particles[i].d, finalPose.asTPose());
+					}
 				}
+			};
+
+			// One random stream per block of particles, so the result
+			// does not depend on the number of threads:
+			const uint32_t seed =
+				mrpt::random::getRandomGenerator().drawUniform32bit();
+			auto predictBlock = [&](size_t first, size_t last) {
+				mrpt::random::CRandomGenerator rng(
+					seed + static_cast<uint32_t>(first));
+				predictParticles(first, last, rng);
+			};
+			if (PF_options.numThreads == 1)
+			{
+				// A pool without threads runs the same blocks in this thread:
+				mrpt::WorkerThreadsPool().parallelForBlocks(
+					M, PF_options.parallelBlockSize, predictBlock);
+			}
+			else
+			{
+				PF_SLAM_getThreadPool(PF_options)
+					.parallelForBlocks(
+						M, PF_options.parallelBlockSize, predictBlock);
 			}
 		}
 		else
@@ -361,18 +388,38 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
 		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
+		auto updateWeights = [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				bool pose_is_valid;
+				const mrpt::math::TPose3D partPose =
+					getLastPose(i, pose_is_valid);  // Take the particle data:
+				mrpt::poses::CPose3D partPose2 =
+					mrpt::poses::CPose3D(partPose);
+				const double obs_log_likelihood =
+					PF_SLAM_computeObservationLikelihoodForParticle(
+						PF_options, i, *sf, partPose2);
+				me->m_particles[i].log_w +=
+					obs_log_likelihood * PF_options.powFactor;
+			}  // for each particle "i"
+		};
+
+		if (PF_options.numThreads == 1 || M < 2)
 		{
-			bool pose_is_valid;
-			const mrpt::math::TPose3D partPose =
-				getLastPose(i, pose_is_valid);  // Take the particle data:
-			mrpt::poses::CPose3D partPose2 = mrpt::poses::CPose3D(partPose);
-			const double obs_log_likelihood =
-				PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, i, *sf, partPose2);
-			me->m_particles[i].log_w +=
-				obs_log_likelihood * PF_options.powFactor;
-		}  // for each particle "i"
+			updateWeights(0, M);
+		}
+		else
+		{
+			// Evaluate the first particle alone, so any lazily-built cache in
+			// the observations or the map is ready before going parallel:
+			updateWeights(0, 1);
+			PF_SLAM_getThreadPool(PF_options)
+				.parallelForBlocks(
+					M - 1, PF_options.parallelBlockSize,
+					[&](size_t first, size_t last) {
+						updateWeights(first + 1, last + 1);
+					});
+		}
 
 		// Normalization of weights is done outside of this method
 		// automatically.
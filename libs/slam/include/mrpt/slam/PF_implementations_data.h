@@ -18,6 +18,9 @@
 #include <mrpt/poses/CPoseRandomSampler.h>
 #include <mrpt/slam/TKLDParams.h>
 #include <mrpt/system/COutputLogger.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <memory>
+#include <thread>
 
 namespace mrpt
 {
@@ -59,6 +62,23 @@ class PF_implementation : public mrpt::system::COutputLogger
 	/** Used in al PF implementations. \sa
 	 * PF_SLAM_implementation_gatherActionsCheckBothActObs */
 	mrpt::poses::CPoseRandomSampler m_movementDrawer;
+
+	/** Worker threads used by PF implementations in multi-threaded mode. See
+	 * CParticleFilter::TParticleFilterOptions::numThreads */
+	std::shared_ptr<mrpt::WorkerThreadsPool> m_threadPool;
+
+	/** Returns m_threadPool, (re)creating it if needed to match the number of
+	 * threads requested in the PF options. */
+	mrpt::WorkerThreadsPool& PF_SLAM_getThreadPool(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options)
+	{
+		std::size_t nThreads = PF_options.numThreads;
+		if (!nThreads) nThreads = std::thread::hardware_concurrency();
+		if (!nThreads) nThreads = 1;
+		if (!m_threadPool || m_threadPool->size() != nThreads)
+			m_threadPool = std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+		return *m_threadPool;
+	}
 	/** Auxiliary variable used in the "pfAuxiliaryPFOptimal" algorithm. */
 	mutable mrpt::math::CVectorDouble m_pfAuxiliaryPFOptimal_estimatedProb;
 	/** Auxiliary variable used in the "pfAuxiliaryPFStandard" algorithm. */
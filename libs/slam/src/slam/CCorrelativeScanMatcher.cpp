@@ -0,0 +1,497 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "slam-precomp.h"  // Precompiled headers
+
+#include <mrpt/slam/CCorrelativeScanMatcher.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/system/CTicTac.h>
+#include <mrpt/config/CConfigFileBase.h>  // MRPT_LOAD_*()
+#include <mrpt/math/wrap2pi.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/poses/CPose3DPDFGaussian.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::system;
+using namespace mrpt::poses;
+using namespace std;
+
+CCorrelativeScanMatcher::TConfigParams::TConfigParams()
+	: angular_window(M_PI)
+{
+}
+
+void CCorrelativeScanMatcher::TConfigParams::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& iniFile, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(linear_window, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR_DEGREES(angular_window, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR_DEGREES(angular_step, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(pyramid_levels, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(sigma, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(occupied_threshold, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(min_score, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
+}
+
+void CCorrelativeScanMatcher::TConfigParams::saveToConfigFile(
+	mrpt::config::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		linear_window, "Half size of the x/y search window (meters)");
+	MRPT_SAVE_CONFIG_VAR_DEGREES_COMMENT(
+		"angular_window", angular_window,
+		"Half size of the phi search window (degrees)");
+	MRPT_SAVE_CONFIG_VAR_DEGREES_COMMENT(
+		"angular_step", angular_step,
+		"Angular search step (degrees). 0: automatic from the scan range");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		pyramid_levels, "Number of levels of the max-pooled pyramid");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		sigma, "Std. dev. of the likelihood field (meters)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		occupied_threshold, "Cells below this value are obstacles");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(decimation, "Use one out of N points");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		min_score, "Minimum score [0,1] of an acceptable pose");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads, "Threads for the search (0: one per hardware core)");
+}
+
+namespace
+{
+/** A translation (in cells) of the scan rotated by one of the searched
+ * angles. At pyramid level `h`, it stands for all the translations in
+ * [ix,ix+2^h)x[iy,iy+2^h), and `score` is an upper bound of theirs. */
+struct TCandidate
+{
+	int angle{0}, ix{0}, iy{0};
+	int64_t score{-1};
+};
+
+/** Best candidates first. Ties are broken by the position in the search
+ * window, so results do not depend on the order of evaluation. */
+bool betterCandidate(const TCandidate& a, const TCandidate& b)
+{
+	if (a.score != b.score) return a.score > b.score;
+	if (a.angle != b.angle) return a.angle < b.angle;
+	if (a.iy != b.iy) return a.iy < b.iy;
+	return a.ix < b.ix;
+}
+
+struct TBranchAndBound
+{
+	const std::vector<std::vector<uint8_t>>& pyramid;
+	int sizeX, sizeY;
+	/** Window of translations: [-w,w]x[-w,w] cells */
+	int w;
+	size_t nPoints;
+	/** For each angle, the pyramid cell of each point for the translation
+	 * (0,0), as (x,y) pairs */
+	std::vector<int> scanCells;
+
+	int64_t score(const TCandidate& c, const int h) const
+	{
+		const uint8_t* L = pyramid[h].data();
+		const int* cells = &scanCells[2 * nPoints * c.angle];
+		int64_t s = 0;
+		for (size_t i = 0; i < nPoints; i++)
+		{
+			const int x = cells[2 * i] + c.ix, y = cells[2 * i + 1] + c.iy;
+			if (static_cast<unsigned>(x) < static_cast<unsigned>(sizeX) &&
+				static_cast<unsigned>(y) < static_cast<unsigned>(sizeY))
+				s += L[y * sizeX + x];
+		}
+		return s;
+	}
+
+	/** Returns the best level-0 candidate below `c` (of level `h`) with a
+	 * score above `bound`, or a candidate with score=-1 if there is none. */
+	TCandidate branch(
+		const TCandidate& c, const int h, int64_t bound,
+		size_t& nEvaluated) const
+	{
+		if (h == 0) return c;
+
+		const int step = 1 << (h - 1);
+		TCandidate children[4];
+		int nChildren = 0;
+		for (int b = 0; b < 2; b++)
+			for (int a = 0; a < 2; a++)
+			{
+				TCandidate& ch = children[nChildren];
+				ch.angle = c.angle;
+				ch.ix = c.ix + a * step;
+				ch.iy = c.iy + b * step;
+				if (ch.ix > w || ch.iy > w) continue;
+				ch.score = score(ch, h - 1);
+				nChildren++;
+			}
+		nEvaluated += nChildren;
+		// Insertion sort, the fastest for up to 4 elements:
+		for (int i = 1; i < nChildren; i++)
+			for (int j = i;
+				 j > 0 && betterCandidate(children[j], children[j - 1]); j--)
+				std::swap(children[j], children[j - 1]);
+
+		TCandidate best;
+		for (int i = 0; i < nChildren; i++)
+		{
+			// Sorted: no other child may beat the bound either.
+			if (children[i].score <= bound) break;
+			const TCandidate r = branch(children[i], h - 1, bound, nEvaluated);
+			if (r.score > bound)
+			{
+				bound = r.score;
+				best = r;
+			}
+		}
+		return best;
+	}
+};
+}  // namespace
+
+mrpt::WorkerThreadsPool* CCorrelativeScanMatcher::getThreadPool()
+{
+	size_t nThreads = options.numThreads;
+	if (!nThreads) nThreads = std::thread::hardware_concurrency();
+	if (nThreads <= 1) return nullptr;
+	if (!m_threadPool || m_threadPool->size() != nThreads)
+		m_threadPool = std::make_shared<mrpt::WorkerThreadsPool>(nThreads);
+	return m_threadPool.get();
+}
+
+std::vector<double> CCorrelativeScanMatcher::pyramidParams(
+	const COccupancyGridMap2D& grid) const
+{
+	return {double(grid.getSizeX()),
+			double(grid.getSizeY()),
+			grid.getXMin(),
+			grid.getYMin(),
+			grid.getResolution(),
+			options.sigma,
+			options.occupied_threshold,
+			double(options.pyramid_levels)};
+}
+
+void CCorrelativeScanMatcher::clearPyramid()
+{
+	m_pyramid.clear();
+	m_pyrGrid = nullptr;
+	m_pyrParams.clear();
+}
+
+void CCorrelativeScanMatcher::precomputePyramid(const COccupancyGridMap2D& grid)
+{
+	MRPT_START
+
+	ASSERT_(options.pyramid_levels >= 1 && options.pyramid_levels <= 16);
+	ASSERT_ABOVE_(options.sigma, 0);
+	ASSERT_(grid.getSizeX() > 0 && grid.getSizeY() > 0);
+
+	const int nLevels = static_cast<int>(options.pyramid_levels);
+	const int sx = grid.getSizeX(), sy = grid.getSizeY();
+	const double res = grid.getResolution();
+
+	m_pyrPad = (1 << (nLevels - 1)) - 1;
+	m_pyrSizeX = sx + m_pyrPad;
+	m_pyrSizeY = sy + m_pyrPad;
+	m_pyramid.assign(nLevels, std::vector<uint8_t>());
+	for (auto& level : m_pyramid) level.assign(m_pyrSizeX * m_pyrSizeY, 0);
+
+	// Level 0: likelihood field, from the distance to the closest obstacle.
+	// Farther than 3 sigmas it is taken as zero.
+	const int distSat = std::max(1, int(std::ceil(3 * options.sigma / res)));
+	std::vector<uint32_t> d2;
+	grid.computeDistanceTransform(
+		0, sx - 1, 0, sy - 1, distSat,
+		COccupancyGridMap2D::p2l(float(options.occupied_threshold)), d2);
+
+	const double k = -square(res) / (2 * square(options.sigma));
+	std::vector<uint8_t> lut(distSat * distSat + 1, 0);
+	for (int i = 0; i < distSat * distSat; i++)
+		lut[i] = static_cast<uint8_t>(std::round(255 * std::exp(k * i)));
+
+	mrpt::WorkerThreadsPool* pool = getThreadPool();
+	auto forEachRow = [pool](const int nRows, auto&& f) {
+		if (pool)
+			pool->parallelForBlocks(nRows, 64, f);
+		else
+			f(0, nRows);
+	};
+
+	forEachRow(sy, [&](size_t first, size_t last) {
+		for (size_t y = first; y < last; y++)
+		{
+			const uint32_t* src = &d2[y * sx];
+			uint8_t* dst =
+				&m_pyramid[0][(y + m_pyrPad) * m_pyrSizeX + m_pyrPad];
+			for (int x = 0; x < sx; x++) dst[x] = lut[src[x]];
+		}
+	});
+
+	// Level h: max of the 2x2 blocks of level h-1 that are 2^(h-1) apart.
+	for (int h = 1; h < nLevels; h++)
+	{
+		const int s = 1 << (h - 1);
+		const uint8_t* prev = m_pyramid[h - 1].data();
+		uint8_t* cur = m_pyramid[h].data();
+		const int W = m_pyrSizeX, H = m_pyrSizeY;
+		forEachRow(H, [&](size_t first, size_t last) {
+			for (int y = int(first); y < int(last); y++)
+			{
+				const uint8_t* r0 = prev + y * W;
+				const uint8_t* r1 = y + s < H ? r0 + s * W : nullptr;
+				uint8_t* out = cur + y * W;
+				for (int x = 0; x < W; x++)
+				{
+					uint8_t v = r0[x];
+					if (r1) v = std::max(v, r1[x]);
+					if (x + s < W)
+					{
+						v = std::max(v, r0[x + s]);
+						if (r1) v = std::max(v, r1[x + s]);
+					}
+					out[x] = v;
+				}
+			}
+		});
+	}
+
+	m_pyrGrid = &grid;
+	m_pyrParams = pyramidParams(grid);
+
+	MRPT_END
+}
+
+CPosePDF::Ptr CCorrelativeScanMatcher::AlignPDF(
+	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+	const CPosePDFGaussian& initialEstimationPDF, float* runningTime,
+	void* info)
+{
+	MRPT_START
+
+	CTicTac tictac;
+	tictac.Tic();
+
+	const auto* grid = dynamic_cast<const COccupancyGridMap2D*>(m1);
+	const auto* pts = dynamic_cast<const CPointsMap*>(m2);
+	ASSERTMSG_(grid, "m1 must be of class COccupancyGridMap2D");
+	ASSERTMSG_(pts, "m2 must be a points map");
+	ASSERT_ABOVEEQ_(options.linear_window, 0);
+	ASSERT_ABOVEEQ_(options.angular_window, 0);
+	ASSERT_ABOVEEQ_(options.angular_step, 0);
+
+	if (m_pyrGrid != grid || m_pyrParams != pyramidParams(*grid))
+		precomputePyramid(*grid);
+
+	TReturnInfo outInfo;
+	const CPose2D init = initialEstimationPDF.mean;
+	const double res = grid->getResolution();
+
+	// Points to match:
+	const auto& xs = pts->getPointsBufferRef_x();
+	const auto& ys = pts->getPointsBufferRef_y();
+	const size_t decim = std::max(1U, options.decimation);
+	std::vector<float> lx, ly;
+	lx.reserve(xs.size() / decim + 1);
+	ly.reserve(xs.size() / decim + 1);
+	double maxRange2 = 0;
+	for (size_t i = 0; i < xs.size(); i += decim)
+	{
+		lx.push_back(xs[i]);
+		ly.push_back(ys[i]);
+		maxRange2 = std::max(maxRange2, square(double(xs[i])) + square(ys[i]));
+	}
+	const size_t nPoints = lx.size();
+
+	// Searched angles, as init.phi() + (k - nHalfAngles) * dPhi:
+	double dPhi = options.angular_step;
+	if (dPhi == 0)
+	{
+		// Rotating by dPhi moves the furthest point at most one cell.
+		const double c = 1 - square(res) / (2 * std::max(maxRange2, 1e-9));
+		dPhi = c > -1 ? std::acos(c) : M_PI;
+	}
+	int nAngles, nHalfAngles;
+	if (options.angular_window >= M_PI)
+	{
+		// Whole circle: use an integer number of steps with no repetitions.
+		nAngles = std::max(1, int(std::ceil(2 * M_PI / dPhi)));
+		dPhi = 2 * M_PI / nAngles;
+		nHalfAngles = nAngles / 2;
+	}
+	else
+	{
+		nHalfAngles = int(std::ceil(options.angular_window / dPhi));
+		nAngles = 2 * nHalfAngles + 1;
+	}
+	outInfo.nAngles = nAngles;
+
+	const int nLevels = static_cast<int>(m_pyramid.size());
+	TBranchAndBound bb{m_pyramid,
+					   m_pyrSizeX,
+					   m_pyrSizeY,
+					   int(std::ceil(options.linear_window / res)),
+					   nPoints,
+					   std::vector<int>(2 * nPoints * nAngles)};
+
+	// Initial (coarsest level) candidates, with the window aligned to the
+	// lowest translation:
+	const int topLevel = nLevels - 1;
+	const int topStep = 1 << topLevel;
+	const int nTopPerAxis = (2 * bb.w) / topStep + 1;
+	const int nTopPerAngle = nTopPerAxis * nTopPerAxis;
+	std::vector<TCandidate> candidates(size_t(nAngles) * nTopPerAngle);
+
+	mrpt::WorkerThreadsPool* pool = getThreadPool();
+	auto forEach = [pool](const size_t N, auto&& f) {
+		if (pool)
+			pool->parallelForBlocks(N, 1, f);
+		else
+			f(0, N);
+	};
+
+	forEach(nAngles, [&](size_t first, size_t last) {
+		for (size_t k = first; k < last; k++)
+		{
+			const double phi =
+				init.phi() + (int(k) - nHalfAngles) * dPhi;
+			const double ccos = cos(phi), csin = sin(phi);
+			int* cells = &bb.scanCells[2 * nPoints * k];
+			for (size_t i = 0; i < nPoints; i++)
+			{
+				const double gx = init.x() + ccos * lx[i] - csin * ly[i];
+				const double gy = init.y() + csin * lx[i] + ccos * ly[i];
+				cells[2 * i] = grid->x2idx(gx) + m_pyrPad;
+				cells[2 * i + 1] = grid->y2idx(gy) + m_pyrPad;
+			}
+			for (int j = 0; j < nTopPerAngle; j++)
+			{
+				TCandidate& c = candidates[k * nTopPerAngle + j];
+				c.angle = int(k);
+				c.ix = -bb.w + (j % nTopPerAxis) * topStep;
+				c.iy = -bb.w + (j / nTopPerAxis) * topStep;
+				c.score = bb.score(c, topLevel);
+			}
+		}
+	});
+	outInfo.nEvaluatedCandidates = candidates.size();
+	std::sort(candidates.begin(), candidates.end(), betterCandidate);
+
+	// Depth-first branch and bound, best candidates first. With several
+	// threads, the subtrees of consecutive candidates are explored
+	// concurrently, all with the bound at the beginning of the batch; taking
+	// the first best result of each batch gives the same pose as the serial
+	// search.
+	const double maxScore = 255.0 * nPoints;
+	int64_t bound = int64_t(std::ceil(options.min_score * maxScore)) - 1;
+	TCandidate best;
+	const size_t batchSize = pool ? pool->size() : 1;
+	std::vector<TCandidate> results(batchSize);
+	std::vector<size_t> nEvaluated(batchSize);
+	for (size_t i = 0; i < candidates.size() && nPoints > 0;
+		 i += batchSize)
+	{
+		if (candidates[i].score <= bound) break;
+		size_t n = 0;
+		while (n < batchSize && i + n < candidates.size() &&
+			   candidates[i + n].score > bound)
+			n++;
+		std::fill(nEvaluated.begin(), nEvaluated.end(), 0);
+		forEach(n, [&](size_t first, size_t last) {
+			for (size_t j = first; j < last; j++)
+				results[j] = bb.branch(
+					candidates[i + j], topLevel, bound, nEvaluated[j]);
+		});
+		for (size_t j = 0; j < n; j++)
+		{
+			outInfo.nEvaluatedCandidates += nEvaluated[j];
+			if (results[j].score > bound)
+			{
+				bound = results[j].score;
+				best = results[j];
+			}
+		}
+	}
+
+	CPosePDFGaussian::Ptr resultPDF;
+	if (best.score >= 0)
+	{
+		outInfo.found = true;
+		outInfo.goodness = best.score / maxScore;
+		CMatrixDouble33 cov;
+		cov(0, 0) = cov(1, 1) = square(res);
+		cov(2, 2) = square(dPhi);
+		resultPDF = mrpt::make_aligned_shared<CPosePDFGaussian>(
+			CPose2D(
+				init.x() + best.ix * res, init.y() + best.iy * res,
+				mrpt::math::wrapToPi(
+					init.phi() + (best.angle - nHalfAngles) * dPhi)),
+			cov);
+	}
+	else
+	{
+		resultPDF =
+			mrpt::make_aligned_shared<CPosePDFGaussian>(initialEstimationPDF);
+	}
+
+	if (runningTime) *runningTime = tictac.Tac();
+	if (info) *static_cast<TReturnInfo*>(info) = outInfo;
+
+	return resultPDF;
+
+	MRPT_END
+}
+
+CPose3DPDF::Ptr CCorrelativeScanMatcher::Align3DPDF(
+	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+	const CPose3DPDFGaussian& initialEstimationPDF, float* runningTime,
+	void* info)
+{
+	MRPT_START
+
+	// The (x,y,yaw) components of the 6D pose and covariance:
+	const int idx[3] = {0, 1, 3};
+
+	const CPose3D& init3D = initialEstimationPDF.mean;
+	CPosePDFGaussian init2D;
+	init2D.mean = CPose2D(init3D);
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			init2D.cov(i, j) = initialEstimationPDF.cov(idx[i], idx[j]);
+
+	const auto pdf2D = std::dynamic_pointer_cast<CPosePDFGaussian>(
+		AlignPDF(m1, m2, init2D, runningTime, info));
+	ASSERT_(pdf2D);
+
+	auto result = mrpt::make_aligned_shared<CPose3DPDFGaussian>();
+	result->mean = CPose3D(
+		pdf2D->mean.x(), pdf2D->mean.y(), init3D.z(), pdf2D->mean.phi(),
+		init3D.pitch(), init3D.roll());
+	// (x,y,yaw) come from the search, uncorrelated with (z,pitch,roll):
+	result->cov = initialEstimationPDF.cov;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 6; j++)
+			result->cov(idx[i], j) = result->cov(j, idx[i]) = 0;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			result->cov(idx[i], idx[j]) = pdf2D->cov(i, j);
+	return result;
+
+	MRPT_END
+}
@@ -0,0 +1,140 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CCorrelativeScanMatcher.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/math/wrap2pi.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace std;
+
+class CorrelativeScanMatcherTests : public ::testing::Test
+{
+   protected:
+	COccupancyGridMap2D grid{-6, 6, -6, 6, 0.05f};
+	CSimplePointsMap scanPoints;
+	const CPose2D truePose{-2, -1, 0.3};
+
+	void SetUp() override
+	{
+		// A 10x10m room with two obstacles that break its symmetry:
+		grid.fill(1.0f);
+		for (float t = -5; t <= 5; t += 0.025f)
+		{
+			grid.setPos(t, -5, 0);
+			grid.setPos(t, 5, 0);
+			grid.setPos(-5, t, 0);
+			grid.setPos(5, t, 0);
+		}
+		for (float x = 0; x < 1; x += 0.025f)
+			for (float y = 0; y < 1; y += 0.025f) grid.setPos(x, y, 0);
+		for (float x = -3; x < -2.5f; x += 0.025f)
+			for (float y = 2; y < 4; y += 0.025f) grid.setPos(x, y, 0);
+
+		CObservation2DRangeScan scan;
+		scan.aperture = M_PIf * 2;
+		scan.maxRange = 20;
+		grid.laserScanSimulator(scan, truePose, 0.5f, 360);
+		scanPoints.insertObservation(&scan);
+	}
+
+	CPose2D align(
+		CCorrelativeScanMatcher& matcher, const CPose2D& initialGuess,
+		CCorrelativeScanMatcher::TReturnInfo& info)
+	{
+		const auto pdf = matcher.AlignPDF(
+			&grid, &scanPoints, CPosePDFGaussian(initialGuess), nullptr,
+			&info);
+		return pdf->getMeanVal();
+	}
+};
+
+TEST_F(CorrelativeScanMatcherTests, findsPoseWithoutInitialGuess)
+{
+	CCorrelativeScanMatcher matcher;
+	matcher.options.linear_window = 4;
+
+	CCorrelativeScanMatcher::TReturnInfo info;
+	const CPose2D p = align(matcher, CPose2D(0, 0, 0), info);
+
+	EXPECT_TRUE(info.found);
+	EXPECT_GT(info.goodness, 0.8);
+	EXPECT_NEAR(p.x(), truePose.x(), 0.1);
+	EXPECT_NEAR(p.y(), truePose.y(), 0.1);
+	EXPECT_NEAR(mrpt::math::wrapToPi(p.phi() - truePose.phi()), 0, 0.05);
+}
+
+// Branch and bound must give the same pose than the exhaustive search (a
+// pyramid with one level), while evaluating much fewer candidates:
+TEST_F(CorrelativeScanMatcherTests, branchAndBoundMatchesExhaustiveSearch)
+{
+	const CPose2D initialGuess(-1.5, -0.6, 0.5);
+
+	CCorrelativeScanMatcher bb, brute;
+	bb.options.linear_window = brute.options.linear_window = 1;
+	bb.options.angular_window = brute.options.angular_window = 0.5;
+	bb.options.min_score = brute.options.min_score = 0.1;
+	brute.options.pyramid_levels = 1;
+
+	CCorrelativeScanMatcher::TReturnInfo infoBB, infoBrute;
+	const CPose2D pBB = align(bb, initialGuess, infoBB);
+	const CPose2D pBrute = align(brute, initialGuess, infoBrute);
+
+	ASSERT_TRUE(infoBB.found);
+	ASSERT_TRUE(infoBrute.found);
+	EXPECT_EQ(infoBB.nAngles, infoBrute.nAngles);
+	EXPECT_DOUBLE_EQ(infoBB.goodness, infoBrute.goodness);
+	EXPECT_DOUBLE_EQ(pBB.x(), pBrute.x());
+	EXPECT_DOUBLE_EQ(pBB.y(), pBrute.y());
+	EXPECT_DOUBLE_EQ(pBB.phi(), pBrute.phi());
+	EXPECT_LT(infoBB.nEvaluatedCandidates * 10, infoBrute.nEvaluatedCandidates);
+}
+
+TEST_F(CorrelativeScanMatcherTests, parallelSearchGivesSameResult)
+{
+	CCorrelativeScanMatcher serial, parallel;
+	serial.options.linear_window = parallel.options.linear_window = 4;
+	parallel.options.numThreads = 4;
+
+	CCorrelativeScanMatcher::TReturnInfo infoS, infoP;
+	const CPose2D pS = align(serial, CPose2D(0, 0, 0), infoS);
+	const CPose2D pP = align(parallel, CPose2D(0, 0, 0), infoP);
+
+	ASSERT_TRUE(infoS.found);
+	ASSERT_TRUE(infoP.found);
+	EXPECT_DOUBLE_EQ(infoS.goodness, infoP.goodness);
+	EXPECT_DOUBLE_EQ(pS.x(), pP.x());
+	EXPECT_DOUBLE_EQ(pS.y(), pP.y());
+	EXPECT_DOUBLE_EQ(pS.phi(), pP.phi());
+}
+
+TEST_F(CorrelativeScanMatcherTests, noMatchReturnsInitialGuess)
+{
+	CCorrelativeScanMatcher matcher;
+	matcher.options.linear_window = 0.5;
+	matcher.options.angular_window = 0.1;
+	matcher.options.min_score = 0.99;
+
+	const CPose2D initialGuess(2, 2, -1);
+	CCorrelativeScanMatcher::TReturnInfo info;
+	const CPose2D p = align(matcher, initialGuess, info);
+
+	EXPECT_FALSE(info.found);
+	EXPECT_EQ(p.x(), initialGuess.x());
+	EXPECT_EQ(p.y(), initialGuess.y());
+	EXPECT_EQ(p.phi(), initialGuess.phi());
+}
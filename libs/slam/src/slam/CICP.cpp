@@ -22,6 +22,7 @@
 #include <mrpt/poses/CPose3DPDF.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
 #include <mrpt/poses/CPose3DPDFGaussian.h>
+#include <Eigen/Eigenvalues>
 
 using namespace mrpt::slam;
 using namespace mrpt::maps;
@@ -53,6 +54,12 @@ CPosePDF::Ptr CICP::AlignPDF(
 		case icpLevenbergMarquardt:
 			resultPDF = ICP_Method_LM(m1, mm2, initialEstimationPDF, outInfo);
 			break;
+		case icpPointToPlane:
+		case icpGeneralized:
+			THROW_EXCEPTION(
+				"icpPointToPlane and icpGeneralized are only implemented for "
+				"ICP-3D");
+			break;
 		default:
 			THROW_EXCEPTION_FMT(
 				"Invalid value for ICP_algorithm: %i",
@@ -118,6 +125,9 @@ void CICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(surface_neighbors, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(gicp_epsilon, double, iniFile, section);
 }
 
 void CICP::TConfigParams::saveToConfigFile(
@@ -166,6 +176,13 @@ void CICP::TConfigParams::saveToConfigFile(
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_cov_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_quality_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(corresponding_points_decimation, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Threads for the correspondence search (0: one per hardware core)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		surface_neighbors,
+		"[icpPointToPlane,icpGeneralized] Points used to estimate normals");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(gicp_epsilon, "[icpGeneralized]");
 }
 
 float CICP::kernel(const float& x2, const float& rho2)
@@ -933,8 +950,14 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 			resultPDF =
 				ICP3D_Method_Classic(m1, mm2, initialEstimationPDF, outInfo);
 			break;
+		case icpPointToPlane:
+		case icpGeneralized:
+			resultPDF =
+				ICP3D_Method_Surfaces(m1, mm2, initialEstimationPDF, outInfo);
+			break;
 		case icpLevenbergMarquardt:
-			THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D");
+			THROW_EXCEPTION(
+				"icpLevenbergMarquardt is not implemented for ICP-3D");
 			break;
 		default:
 			THROW_EXCEPTION_FMT(
@@ -1007,6 +1030,7 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
 
 	// Asure maps are not empty!
 	// ------------------------------------------------------
@@ -1121,3 +1145,285 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 
 	MRPT_END
 }
+
+CPose3DPDF::Ptr CICP::ICP3D_Method_Surfaces(
+	const mrpt::maps::CMetricMap* mm1, const mrpt::maps::CMetricMap* mm2,
+	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
+{
+	MRPT_START
+
+	using Vector6d = Eigen::Matrix<double, 6, 1>;
+	using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+	const bool generalized = (options.ICP_algorithm == icpGeneralized);
+
+	size_t nCorrespondences = 0;
+	bool keepApproaching;
+	// Hessian of the normal equations in the last iteration, for the
+	// covariance of the estimate:
+	Matrix6d lastH;
+	bool hasLastH = false;
+	mrpt::tfest::TMatchingPairList correspondences;
+	CPose3D lastMeanPose;
+
+	// Assure the class of the maps: the local surfaces of both are needed.
+	ASSERT_(mm1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+	ASSERT_(mm2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+	const CPointsMap* m1 = static_cast<const CPointsMap*>(mm1);
+	const CPointsMap* m2 = static_cast<const CPointsMap*>(mm2);
+
+	// Asserts:
+	// -----------------
+	ASSERT_(options.ALFA > 0 && options.ALFA < 1);
+	ASSERT_ABOVEEQ_(options.surface_neighbors, 3);
+
+	// The algorithm output auxiliar info:
+	// -------------------------------------------------
+	outInfo.nIterations = 0;
+	outInfo.goodness = 1;
+	outInfo.quality = 0;
+
+	// The gaussian PDF to estimate, from the first gross approximation:
+	CPose3DPDFGaussian::Ptr gaussPdf =
+		mrpt::make_aligned_shared<CPose3DPDFGaussian>();
+	gaussPdf->mean = initialEstimationPDF.mean;
+
+	// Initial thresholds:
+	TMatchingParams matchParams;
+	TMatchingExtraResults matchExtraResults;
+
+	matchParams.maxDistForCorrespondence = options.thresholdDist;
+	matchParams.maxAngularDistForCorrespondence = options.thresholdAng;
+	matchParams.onlyKeepTheClosest = true;
+	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
+	matchParams.decimation_other_map_points =
+		options.corresponding_points_decimation;
+	matchParams.numThreads = options.numThreads;
+
+	// Asure maps are not empty!
+	// ------------------------------------------------------
+	if (!m1->isEmpty() && !m2->isEmpty())
+	{
+		matchParams.offset_other_map_points = 0;
+
+		// Local surfaces, cached within each map:
+		const auto& normals1 =
+			m1->getPointsNormals(options.surface_neighbors, options.numThreads);
+		const auto* covs1 =
+			generalized ? &m1->getPointsLocalCovariances(
+							  options.surface_neighbors, options.numThreads)
+						: nullptr;
+		const auto* covs2 =
+			generalized ? &m2->getPointsLocalCovariances(
+							  options.surface_neighbors, options.numThreads)
+						: nullptr;
+
+		// [GICP] Covariances of the points, as if sampled from a plane:
+		// eigenvalues replaced by (epsilon,1,1). Only computed for the points
+		// with correspondences.
+		std::vector<Eigen::Matrix3d> planeCovs1, planeCovs2;
+		std::vector<char> hasPlaneCov1, hasPlaneCov2;
+		if (generalized)
+		{
+			hasPlaneCov1.assign(m1->size(), 0);
+			hasPlaneCov2.assign(m2->size(), 0);
+			planeCovs1.resize(m1->size());
+			planeCovs2.resize(m2->size());
+		}
+		auto planeCov = [this](
+							const CMatrixFloat33& C, Eigen::Matrix3d& out) {
+			const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es(
+				C.cast<double>());
+			const Eigen::Vector3d d(options.gicp_epsilon, 1.0, 1.0);
+			out = es.eigenvectors() * d.asDiagonal() *
+				  es.eigenvectors().transpose();
+		};
+
+		// ------------------------------------------------------
+		//					The ICP loop
+		// ------------------------------------------------------
+		do
+		{
+			matchParams.angularDistPivotPoint = TPoint3D(
+				gaussPdf->mean.x(), gaussPdf->mean.y(), gaussPdf->mean.z());
+
+			// ------------------------------------------------------
+			//		Find the matching (for a points map)
+			// ------------------------------------------------------
+			m1->determineMatching3D(
+				m2,  // The other map
+				gaussPdf->mean,  // The other map pose
+				correspondences, matchParams, matchExtraResults);
+
+			nCorrespondences = correspondences.size();
+
+			// At least 6 constraints are needed for a 6D pose:
+			if (nCorrespondences < 6)
+			{
+				// Nothing we can do !!
+				keepApproaching = false;
+			}
+			else
+			{
+				// One Gauss-Newton step of the linearized distances, for a
+				// small increment (v,w) applied to the current pose:
+				// p' = p + w x p + v
+				const CPose3D& P = gaussPdf->mean;
+				const Eigen::Matrix3d R = P.getRotationMatrix();
+				Matrix6d H = Matrix6d::Zero();
+				Vector6d g = Vector6d::Zero();
+
+				for (const auto& c : correspondences)
+				{
+					double gx, gy, gz;
+					P.composePoint(c.other_x, c.other_y, c.other_z, gx, gy, gz);
+					const Eigen::Vector3d p(gx, gy, gz);
+					const Eigen::Vector3d q(c.this_x, c.this_y, c.this_z);
+
+					if (!generalized)
+					{
+						// Point-to-plane: r = n^t (p'-q)
+						const TPoint3Df& nf = normals1[c.this_idx];
+						const Eigen::Vector3d n(nf.x, nf.y, nf.z);
+						Vector6d J;
+						J.head<3>() = n;
+						J.tail<3>() = p.cross(n);
+						const double r = n.dot(p - q);
+						H.noalias() += J * J.transpose();
+						g.noalias() += J * r;
+					}
+					else
+					{
+						// GICP: r = p'-q, weighted with the inverse of the
+						// combined covariance of both points.
+						if (!hasPlaneCov1[c.this_idx])
+						{
+							planeCov(
+								(*covs1)[c.this_idx], planeCovs1[c.this_idx]);
+							hasPlaneCov1[c.this_idx] = 1;
+						}
+						if (!hasPlaneCov2[c.other_idx])
+						{
+							planeCov(
+								(*covs2)[c.other_idx], planeCovs2[c.other_idx]);
+							hasPlaneCov2[c.other_idx] = 1;
+						}
+						const Eigen::Matrix3d M =
+							(planeCovs1[c.this_idx] +
+							 R * planeCovs2[c.other_idx] * R.transpose())
+								.inverse();
+						Eigen::Matrix<double, 3, 6> J;
+						J.leftCols<3>().setIdentity();
+						J.rightCols<3>() << 0, p.z(), -p.y(), -p.z(), 0, p.x(),
+							p.y(), -p.x(), 0;
+						const Eigen::Vector3d r = p - q;
+						H.noalias() += J.transpose() * M * J;
+						g.noalias() += J.transpose() * (M * r);
+					}
+				}
+
+				// A tiny damping keeps the system solvable in degenerate
+				// scenes (e.g. a single plane):
+				H.diagonal().array() += 1e-9 * (1.0 + H.trace());
+				const Vector6d delta = -H.ldlt().solve(g);
+				lastH = H;
+				hasLastH = true;
+
+				mrpt::math::CArrayDouble<6> mu;
+				for (int i = 0; i < 6; i++) mu[i] = delta[i];
+				gaussPdf->mean =
+					CPose3D::exp(mu, true /*pseudo-exponential*/) + P;
+
+				// If matching has not changed, decrease the thresholds:
+				// --------------------------------------------------------
+				keepApproaching = true;
+				if (!(fabs(lastMeanPose.x() - gaussPdf->mean.x()) >
+						  options.minAbsStep_trans ||
+					  fabs(lastMeanPose.y() - gaussPdf->mean.y()) >
+						  options.minAbsStep_trans ||
+					  fabs(lastMeanPose.z() - gaussPdf->mean.z()) >
+						  options.minAbsStep_trans ||
+					  fabs(
+						  math::wrapToPi(
+							  lastMeanPose.yaw() - gaussPdf->mean.yaw())) >
+						  options.minAbsStep_rot ||
+					  fabs(
+						  math::wrapToPi(
+							  lastMeanPose.pitch() - gaussPdf->mean.pitch())) >
+						  options.minAbsStep_rot ||
+					  fabs(
+						  math::wrapToPi(
+							  lastMeanPose.roll() - gaussPdf->mean.roll())) >
+						  options.minAbsStep_rot))
+				{
+					matchParams.maxDistForCorrespondence *= options.ALFA;
+					matchParams.maxAngularDistForCorrespondence *= options.ALFA;
+					if (matchParams.maxDistForCorrespondence <
+						options.smallestThresholdDist)
+						keepApproaching = false;
+
+					if (++matchParams.offset_other_map_points >=
+						options.corresponding_points_decimation)
+						matchParams.offset_other_map_points = 0;
+				}
+
+				lastMeanPose = gaussPdf->mean;
+
+			}  // end of "else, there are correspondences"
+
+			// Next iteration:
+			outInfo.nIterations++;
+
+			if (outInfo.nIterations >= options.maxIterations &&
+				matchParams.maxDistForCorrespondence >
+					options.smallestThresholdDist)
+			{
+				matchParams.maxDistForCorrespondence *= options.ALFA;
+			}
+
+		} while (
+			(keepApproaching && outInfo.nIterations < options.maxIterations) ||
+			(outInfo.nIterations >= options.maxIterations &&
+			 matchParams.maxDistForCorrespondence >
+				 options.smallestThresholdDist));
+
+		outInfo.goodness = matchExtraResults.correspondencesRatio;
+
+		// -------------------------------------------------
+		//   Obtain the covariance matrix of the estimation
+		// -------------------------------------------------
+		if (!options.skip_cov_calculation && hasLastH)
+		{
+			// Covariance of the increment (v,w), from the inverse of the
+			// Hessian of the normal equations:
+			const Matrix6d covInc =
+				lastH.inverse() * options.covariance_varPoints;
+
+			// Transform it into the (x,y,z,yaw,pitch,roll) parameterization
+			// of the pose, with a numerical Jacobian of
+			// pose = exp(v,w) + mean around (v,w)=0:
+			const CPose3D& P = gaussPdf->mean;
+			const double eps = 1e-7;
+			Matrix6d J;
+			for (int i = 0; i < 6; i++)
+			{
+				mrpt::math::CArrayDouble<6> mu;
+				mu.fill(0);
+				mu[i] = eps;
+				const CPose3D Pi = CPose3D::exp(mu, true) + P;
+				J(0, i) = (Pi.x() - P.x()) / eps;
+				J(1, i) = (Pi.y() - P.y()) / eps;
+				J(2, i) = (Pi.z() - P.z()) / eps;
+				J(3, i) = math::wrapToPi(Pi.yaw() - P.yaw()) / eps;
+				J(4, i) = math::wrapToPi(Pi.pitch() - P.pitch()) / eps;
+				J(5, i) = math::wrapToPi(Pi.roll() - P.roll()) / eps;
+			}
+			gaussPdf->cov = J * covInc * J.transpose();
+		}
+
+	}  // end of "if maps are not empty"
+
+	return gaussPdf;
+
+	MRPT_END
+}
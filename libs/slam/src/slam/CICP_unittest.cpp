@@ -233,6 +233,142 @@ class ICPTests : public ::testing::Test
 		EXPECT_NEAR(good_pose.distanceTo(pdf->getMeanVal()), 0, 0.02);
 	}
 
+	void alignRayTracedScans3D(
+		const TICPAlgorithm icp_method, const unsigned int numThreads,
+		CICP::TReturnInfo* out_info = nullptr)
+	{
+		// Increase this values to get more precision. It will also increase
+		// run time.
+		const size_t HOW_MANY_YAWS = 150;
+		const size_t HOW_MANY_PITCHS = 150;
+
+		// The two origins for the 3D scans
+		CPose3D viewpoint1(
+			-0.3, 0.7, 3, DEG2RAD(5), DEG2RAD(80), DEG2RAD(3));
+		CPose3D viewpoint2(
+			0.5, -0.2, 2.6, DEG2RAD(-5), DEG2RAD(100), DEG2RAD(-7));
+
+		CPose3D SCAN2_POSE_ERROR(0.15, -0.07, 0.10, -0.03, 0.1, 0.1);
+
+		// Create the reference objects:
+		COpenGLScene::Ptr scene1 = mrpt::make_aligned_shared<COpenGLScene>();
+		COpenGLScene::Ptr scene2 = mrpt::make_aligned_shared<COpenGLScene>();
+		COpenGLScene::Ptr scene3 = mrpt::make_aligned_shared<COpenGLScene>();
+
+		opengl::CGridPlaneXY::Ptr plane1 =
+			mrpt::make_aligned_shared<CGridPlaneXY>(-20, 20, -20, 20, 0, 1);
+		plane1->setColor(0.3, 0.3, 0.3);
+		scene1->insert(plane1);
+		scene2->insert(plane1);
+		scene3->insert(plane1);
+
+		CSetOfObjects::Ptr world = mrpt::make_aligned_shared<CSetOfObjects>();
+		generateObjects(world);
+		scene1->insert(world);
+
+		// Perform the 3D scans:
+		CAngularObservationMesh::Ptr aom1 =
+			mrpt::make_aligned_shared<CAngularObservationMesh>();
+		CAngularObservationMesh::Ptr aom2 =
+			mrpt::make_aligned_shared<CAngularObservationMesh>();
+
+		CAngularObservationMesh::trace2DSetOfRays(
+			scene1, viewpoint1, aom1,
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_PITCHS),
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_YAWS));
+		CAngularObservationMesh::trace2DSetOfRays(
+			scene1, viewpoint2, aom2,
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_PITCHS),
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_YAWS));
+
+		// Put the viewpoints origins:
+		{
+			CSetOfObjects::Ptr origin1 = opengl::stock_objects::CornerXYZ();
+			origin1->setPose(viewpoint1);
+			origin1->setScale(0.6f);
+			scene1->insert(origin1);
+			scene2->insert(origin1);
+		}
+		{
+			CSetOfObjects::Ptr origin2 = opengl::stock_objects::CornerXYZ();
+			origin2->setPose(viewpoint2);
+			origin2->setScale(0.6f);
+			scene1->insert(origin2);
+			scene2->insert(origin2);
+		}
+
+		// Show the scanned points:
+		CSimplePointsMap M1, M2;
+
+		aom1->generatePointCloud(&M1);
+		aom2->generatePointCloud(&M2);
+
+		// Create the wrongly-localized M2:
+		CSimplePointsMap M2_noisy;
+		M2_noisy = M2;
+		M2_noisy.changeCoordinatesReference(SCAN2_POSE_ERROR);
+
+		CSetOfObjects::Ptr PTNS1 = mrpt::make_aligned_shared<CSetOfObjects>();
+		CSetOfObjects::Ptr PTNS2 = mrpt::make_aligned_shared<CSetOfObjects>();
+
+		M1.renderOptions.color = mrpt::img::TColorf(1, 0, 0);
+		M1.getAs3DObject(PTNS1);
+
+		M2_noisy.renderOptions.color = mrpt::img::TColorf(0, 0, 1);
+		M2_noisy.getAs3DObject(PTNS2);
+
+		scene2->insert(PTNS1);
+		scene2->insert(PTNS2);
+
+		// --------------------------------------
+		// Do the ICP-3D
+		// --------------------------------------
+		float run_time;
+		CICP icp;
+		CICP::TReturnInfo icp_info;
+
+		icp.options.ICP_algorithm = icp_method;
+		icp.options.numThreads = numThreads;
+		icp.options.thresholdDist = 0.40f;
+		icp.options.thresholdAng = 0;
+
+		CPose3DPDF::Ptr pdf = icp.Align3D(
+			&M2_noisy,  // Map to align
+			&M1,  // Reference map
+			CPose3D(),  // Initial gross estimate
+			&run_time, &icp_info);
+
+		CPose3D mean = pdf->getMeanVal();
+
+		// Checks:
+		EXPECT_NEAR(
+			0,
+			(mean.getAsVectorVal() - SCAN2_POSE_ERROR.getAsVectorVal())
+				.array()
+				.abs()
+				.mean(),
+			0.02)
+			<< "ICP output: mean= " << mean << endl
+			<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
+
+		// The surface methods estimate a proper, small covariance:
+		if (icp_method == icpPointToPlane || icp_method == icpGeneralized)
+		{
+			CMatrixDouble66 cov;
+			pdf->getCovariance(cov);
+			for (int i = 0; i < 6; i++)
+			{
+				EXPECT_GT(cov(i, i), 0.0) << "cov=\n" << cov;
+				EXPECT_LT(cov(i, i), 1e-3) << "cov=\n" << cov;
+			}
+		}
+		if (out_info) *out_info = icp_info;
+	}
+
 	static void generateObjects(CSetOfObjects::Ptr& world)
 	{
 		CSphere::Ptr sph = mrpt::make_aligned_shared<CSphere>(0.5);
@@ -264,119 +400,19 @@ TEST_F(ICPTests, AlignScans_icpLevenbergMarquardt)
 	align2scans(icpLevenbergMarquardt);
 }
 
-TEST_F(ICPTests, RayTracingICP3D)
+TEST_F(ICPTests, RayTracingICP3D) { alignRayTracedScans3D(icpClassic, 1); }
+TEST_F(ICPTests, RayTracingICP3D_parallel)
 {
-	// Increase this values to get more precision. It will also increase run
-	// time.
-	const size_t HOW_MANY_YAWS = 150;
-	const size_t HOW_MANY_PITCHS = 150;
-
-	// The two origins for the 3D scans
-	CPose3D viewpoint1(-0.3, 0.7, 3, DEG2RAD(5), DEG2RAD(80), DEG2RAD(3));
-	CPose3D viewpoint2(0.5, -0.2, 2.6, DEG2RAD(-5), DEG2RAD(100), DEG2RAD(-7));
-
-	CPose3D SCAN2_POSE_ERROR(0.15, -0.07, 0.10, -0.03, 0.1, 0.1);
-
-	// Create the reference objects:
-	COpenGLScene::Ptr scene1 = mrpt::make_aligned_shared<COpenGLScene>();
-	COpenGLScene::Ptr scene2 = mrpt::make_aligned_shared<COpenGLScene>();
-	COpenGLScene::Ptr scene3 = mrpt::make_aligned_shared<COpenGLScene>();
-
-	opengl::CGridPlaneXY::Ptr plane1 =
-		mrpt::make_aligned_shared<CGridPlaneXY>(-20, 20, -20, 20, 0, 1);
-	plane1->setColor(0.3, 0.3, 0.3);
-	scene1->insert(plane1);
-	scene2->insert(plane1);
-	scene3->insert(plane1);
-
-	CSetOfObjects::Ptr world = mrpt::make_aligned_shared<CSetOfObjects>();
-	generateObjects(world);
-	scene1->insert(world);
-
-	// Perform the 3D scans:
-	CAngularObservationMesh::Ptr aom1 =
-		mrpt::make_aligned_shared<CAngularObservationMesh>();
-	CAngularObservationMesh::Ptr aom2 =
-		mrpt::make_aligned_shared<CAngularObservationMesh>();
-
-	CAngularObservationMesh::trace2DSetOfRays(
-		scene1, viewpoint1, aom1,
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_PITCHS),
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_YAWS));
-	CAngularObservationMesh::trace2DSetOfRays(
-		scene1, viewpoint2, aom2,
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_PITCHS),
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_YAWS));
-
-	// Put the viewpoints origins:
-	{
-		CSetOfObjects::Ptr origin1 = opengl::stock_objects::CornerXYZ();
-		origin1->setPose(viewpoint1);
-		origin1->setScale(0.6f);
-		scene1->insert(origin1);
-		scene2->insert(origin1);
-	}
-	{
-		CSetOfObjects::Ptr origin2 = opengl::stock_objects::CornerXYZ();
-		origin2->setPose(viewpoint2);
-		origin2->setScale(0.6f);
-		scene1->insert(origin2);
-		scene2->insert(origin2);
-	}
-
-	// Show the scanned points:
-	CSimplePointsMap M1, M2;
-
-	aom1->generatePointCloud(&M1);
-	aom2->generatePointCloud(&M2);
-
-	// Create the wrongly-localized M2:
-	CSimplePointsMap M2_noisy;
-	M2_noisy = M2;
-	M2_noisy.changeCoordinatesReference(SCAN2_POSE_ERROR);
-
-	CSetOfObjects::Ptr PTNS1 = mrpt::make_aligned_shared<CSetOfObjects>();
-	CSetOfObjects::Ptr PTNS2 = mrpt::make_aligned_shared<CSetOfObjects>();
-
-	M1.renderOptions.color = mrpt::img::TColorf(1, 0, 0);
-	M1.getAs3DObject(PTNS1);
-
-	M2_noisy.renderOptions.color = mrpt::img::TColorf(0, 0, 1);
-	M2_noisy.getAs3DObject(PTNS2);
-
-	scene2->insert(PTNS1);
-	scene2->insert(PTNS2);
-
-	// --------------------------------------
-	// Do the ICP-3D
-	// --------------------------------------
-	float run_time;
-	CICP icp;
-	CICP::TReturnInfo icp_info;
-
-	icp.options.thresholdDist = 0.40f;
-	icp.options.thresholdAng = 0;
-
-	CPose3DPDF::Ptr pdf = icp.Align3D(
-		&M2_noisy,  // Map to align
-		&M1,  // Reference map
-		CPose3D(),  // Initial gross estimate
-		&run_time, &icp_info);
-
-	CPose3D mean = pdf->getMeanVal();
-
-	// Checks:
-	EXPECT_NEAR(
-		0,
-		(mean.getAsVectorVal() - SCAN2_POSE_ERROR.getAsVectorVal())
-			.array()
-			.abs()
-			.mean(),
-		0.02)
-		<< "ICP output: mean= " << mean << endl
-		<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
+	alignRayTracedScans3D(icpClassic, 4);
+}
+TEST_F(ICPTests, RayTracingICP3D_icpPointToPlane)
+{
+	alignRayTracedScans3D(icpPointToPlane, 4);
+}
+TEST_F(ICPTests, RayTracingICP3D_icpGeneralized)
+{
+	CICP::TReturnInfo infoClassic, infoGICP;
+	alignRayTracedScans3D(icpClassic, 1, &infoClassic);
+	alignRayTracedScans3D(icpGeneralized, 0, &infoGICP);
+	EXPECT_LT(infoGICP.nIterations, infoClassic.nIterations);
 }
@@ -15,7 +15,6 @@
 #include <mrpt/io/CFileInputStream.h>
 #include <mrpt/io/CFileOutputStream.h>
 #include <mrpt/io/CFileGZInputStream.h>
-#include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/serialization/CArchive.h>
 
 using namespace mrpt::slam;
@@ -96,15 +95,7 @@ void CMetricMapBuilder::saveCurrentMapToFile(
 		"[CMetricMapBuilder::saveCurrentMapToFile] Saving current map to '"
 		<< fileName << "' ..." << std::endl);
 
-	// Save to file:
-	if (compressGZ)
-	{
-		CFileGZOutputStream f(fileName);
-		archiveFrom(f) << curmap;
-	}
-	else
-	{
-		CFileOutputStream f(fileName);
-		archiveFrom(f) << curmap;
-	}
+	// Save to file (lazy-loadable, if not compressed):
+	if (!curmap.saveToFile(fileName, !compressGZ))
+		THROW_EXCEPTION_FMT("Error saving the map to '%s'", fileName.c_str());
 }
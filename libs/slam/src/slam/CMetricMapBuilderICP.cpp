@@ -539,6 +539,11 @@ void CMetricMapBuilderICP::initialize(
 
 	// Create metric maps:
 	metricMap.setListOfMaps(&ICP_options.mapInitializers);
+	// Points maps only grow while mapping: extend their kd-trees with the
+	// new points instead of rebuilding them after each insertion.
+	for (auto& m : metricMap.maps)
+		if (auto pts = dynamic_cast<CPointsMap*>(m.get()))
+			pts->kdtree_search_params.incremental = true;
 
 	// copy map:
 	SF_Poses_seq = initialMap;
@@ -11,6 +11,11 @@
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/slam/CMonteCarloLocalization2D.h>
 #include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/obs/CRawlog.h>
 #include <mrpt/system/filesystem.h>
@@ -313,3 +318,68 @@ TEST(MonteCarlo2D, RunSampleDataset)
 
 	FAIL() << "Failed to converge after 3 opportunities!!" << endl;
 }
+
+// The multi-threaded PF must give the very same particles for a given seed,
+// no matter the number of threads:
+TEST(MonteCarlo2D, ParallelResultsDoNotDependOnThreadCount)
+{
+	// A synthetic world: a 10x10m room with a column in the middle.
+	COccupancyGridMap2D grid(-6, 6, -6, 6, 0.1f);
+	for (float t = -5; t <= 5; t += 0.05f)
+	{
+		grid.setPos(t, -5, 0);
+		grid.setPos(t, 5, 0);
+		grid.setPos(-5, t, 0);
+		grid.setPos(5, t, 0);
+	}
+	for (float x = 0; x < 1; x += 0.05f)
+		for (float y = 0; y < 1; y += 0.05f) grid.setPos(x, y, 0);
+
+	auto scan = CObservation2DRangeScan::Create();
+	scan->aperture = M_PIf * 2;
+	scan->maxRange = 20;
+	grid.laserScanSimulator(*scan, CPose2D(-2, -1, 0.3), 0.5f, 360);
+	CSensoryFrame sf;
+	sf.insert(scan);
+
+	CActionRobotMovement2D odo;
+	odo.computeFromOdometry(
+		CPose2D(0.1, 0, 0), CActionRobotMovement2D::TMotionModelOptions());
+	CActionCollection acts;
+	acts.insert(odo);
+
+	auto runPF = [&](unsigned int nThreads, unsigned int blockSize) {
+		getRandomGenerator().randomize(1234);
+		CMonteCarloLocalization2D pdf;
+		pdf.options.metricMap = &grid;
+		pdf.resetUniform(-4, 4, -4, 4, -M_PI, M_PI, 3000);
+
+		CParticleFilter PF;
+		PF.m_options.adaptiveSampleSize = false;
+		PF.m_options.numThreads = nThreads;
+		PF.m_options.parallelBlockSize = blockSize;
+		for (int step = 0; step < 4; step++)
+			PF.executeOn(pdf, &acts, &sf);
+		return pdf.m_particles;
+	};
+
+	auto expectSameParticles = [](const auto& parts1, const auto& parts) {
+		ASSERT_EQ(parts1.size(), parts.size());
+		for (size_t i = 0; i < parts1.size(); i++)
+		{
+			EXPECT_EQ(parts1[i].d.x, parts[i].d.x);
+			EXPECT_EQ(parts1[i].d.y, parts[i].d.y);
+			EXPECT_EQ(parts1[i].d.phi, parts[i].d.phi);
+			EXPECT_EQ(parts1[i].log_w, parts[i].log_w);
+		}
+	};
+
+	const auto parts1 = runPF(1, 100);
+	for (unsigned int nThreads : {2, 5})
+		expectSameParticles(parts1, runPF(nThreads, 100));
+
+	// A block size of 0 works as 1, single-threaded mode included:
+	const auto partsBlock1 = runPF(1, 1);
+	for (unsigned int nThreads : {1, 2})
+		expectSameParticles(partsBlock1, runPF(nThreads, 0));
+}
@@ -351,8 +351,10 @@ void CMultiMetricMapPDF::rebuildAverageMap()
 
 		// Reserve a float grid-map, add weight all maps
 		// -------------------------------------------------------------------------------------------
+		COccupancyGridMap2D& avrgGrid = *averageMap.m_gridMaps[0];
+		const unsigned int sx = avrgGrid.getSizeX(), sy = avrgGrid.getSizeY();
 		std::vector<float> floatMap;
-		floatMap.resize(averageMap.m_gridMaps[0]->map.size(), 0);
+		floatMap.resize(sx * sy, 0);
 
 		// For each particle in the RBPF:
 		double sumW = 0;
@@ -363,37 +365,25 @@ void CMultiMetricMapPDF::rebuildAverageMap()
 
 		for (part = m_particles.begin(); part != m_particles.end(); ++part)
 		{
-			// Variables:
-			std::vector<COccupancyGridMap2D::cellType>::iterator srcCell;
-			std::vector<COccupancyGridMap2D::cellType>::iterator firstSrcCell =
-				part->d->mapTillNow.m_gridMaps[0]->map.begin();
-			std::vector<COccupancyGridMap2D::cellType>::iterator lastSrcCell =
-				part->d->mapTillNow.m_gridMaps[0]->map.end();
-			std::vector<float>::iterator destCell;
+			const COccupancyGridMap2D& srcGrid =
+				*part->d->mapTillNow.m_gridMaps[0];
 
 			// The weight of particle:
 			float w = exp(part->log_w) / sumW;
 
-			ASSERT_(
-				part->d->mapTillNow.m_gridMaps[0]->map.size() ==
-				floatMap.size());
-
-			// For each cell in individual maps:
-			for (srcCell = firstSrcCell, destCell = floatMap.begin();
-				 srcCell != lastSrcCell; srcCell++, destCell++)
-				(*destCell) += w * (*srcCell);
+			// For each cell in individual maps (either dense or tiled):
+			std::vector<float>::iterator destCell = floatMap.begin();
+			for (unsigned int cy = 0; cy < sy; cy++)
+				for (unsigned int cx = 0; cx < sx; cx++)
+					(*destCell++) += w * srcGrid.getRawCell_nocheck(cx, cy);
 		}
 
 		// Copy to fixed point map:
-		std::vector<float>::iterator srcCell;
-		std::vector<COccupancyGridMap2D::cellType>::iterator destCell =
-			averageMap.m_gridMaps[0]->map.begin();
-
-		ASSERT_(averageMap.m_gridMaps[0]->map.size() == floatMap.size());
-
-		for (srcCell = floatMap.begin(); srcCell != floatMap.end();
-			 srcCell++, destCell++)
-			*destCell = static_cast<COccupancyGridMap2D::cellType>(*srcCell);
+		std::vector<float>::const_iterator srcCell = floatMap.begin();
+		for (unsigned int cy = 0; cy < sy; cy++)
+			for (unsigned int cx = 0; cx < sx; cx++)
+				*avrgGrid.getRawCellPtr_nocheck(cx, cy) =
+					static_cast<COccupancyGridMap2D::cellType>(*srcCell++);
 
 		MRPT_END
 	}  // End of SSE not supported
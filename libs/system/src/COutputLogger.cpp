@@ -105,7 +105,11 @@ std::string COutputLogger::generateStringFromFormat(
 	while (result == -1)
 	{
 		buffer.resize(length + 10);
-		result = os::vsnprintf(&buffer[0], length, fmt, argp);
+		// "argp" cannot be reused after a call to vsnprintf():
+		va_list argp_copy;
+		va_copy(argp_copy, argp);
+		result = os::vsnprintf(&buffer[0], length, fmt, argp_copy);
+		va_end(argp_copy);
 
 		// http://www.cplusplus.com/reference/cstdio/vsnprintf/
 		// only when this returned value is non-negative and less than n, the